@@ -27,13 +27,17 @@
 #include <string>
 #include <vector>
 
+#include "foedus/epoch.hpp"
 #include "foedus/error_stack.hpp"
 #include "foedus/fwd.hpp"
 #include "foedus/assorted/atomic_fences.hpp"
 #include "foedus/assorted/fixed_string.hpp"
 #include "foedus/assorted/uniform_random.hpp"
+#include "foedus/debugging/latency_histogram.hpp"
+#include "foedus/debugging/open_loop.hpp"
 #include "foedus/memory/aligned_memory.hpp"
 #include "foedus/proc/proc_id.hpp"
+#include "foedus/soc/shared_memory_repo.hpp"
 #include "foedus/soc/shared_rendezvous.hpp"
 #include "foedus/storage/masstree/masstree_id.hpp"
 #include "foedus/thread/fwd.hpp"
@@ -41,9 +45,34 @@
 #include "foedus/tpcc/tpcc.hpp"
 #include "foedus/tpcc/tpcc_scale.hpp"
 #include "foedus/tpcc/tpcc_schema.hpp"
+#include "foedus/xct/xct_repair_functor.hpp"
 
 namespace foedus {
 namespace tpcc {
+/**
+ * @brief Re-computes the new quantity of a stock in neworder when the stock was
+ * concurrently ordered by another transaction.
+ * @details
+ * Used only in repair mode. Neworder doesn't use the stock quantity for anything else, so
+ * the transaction can commit with the re-computed quantity instead of aborting.
+ */
+struct StockQuantityRepair : public xct::XctRepairFunctor {
+  ErrorCode repair(
+    thread::Thread* context,
+    const char* payload,
+    log::RecordLogType* log_entry) override;
+  /** The quantity of the orderline */
+  uint32_t ordered_;
+};
+
+/** Same as StockQuantityRepair for the remote count of a stock. */
+struct StockRemoteRepair : public xct::XctRepairFunctor {
+  ErrorCode repair(
+    thread::Thread* context,
+    const char* payload,
+    log::RecordLogType* log_entry) override;
+};
+
 /**
  * Channel between the driver process/thread and clients process/thread.
  * If the driver spawns client processes, this is allocated in shared memory.
@@ -86,6 +115,15 @@ class TpccClientTask {
     /** on average only 3. surely won't be more than this number */
     kMaxCidsPerLname = 128,
   };
+  /** Transaction types. Index of Outputs::latencies_. */
+  enum XctType {
+    kNewOrder = 0,
+    kPayment,
+    kOrderStatus,
+    kDelivery,
+    kStockLevel,
+    kXctTypeCount,
+  };
   struct Inputs {
     uint32_t worker_id_;
     Wid total_warehouses_;
@@ -95,6 +133,14 @@ class TpccClientTask {
     uint16_t payment_remote_percent_;
     bool olap_mode_;
     bool dirty_read_mode_;
+    /** Whether neworder repairs stock updates at precommit instead of aborting. */
+    bool repair_mode_;
+    /**
+     * Average transactions per second this worker issues in open-loop mode.
+     * 0 (default) means the usual closed-loop mode.
+     */
+    double arrival_rate_;
+    debugging::ArrivalSchedule::Type arrival_type_;
   };
   struct Outputs {
     /** How many transactions processed so far*/
@@ -109,6 +155,12 @@ class TpccClientTask {
 
     uint64_t snapshot_cache_hits_;
     uint64_t snapshot_cache_misses_;
+
+    /**
+     * Only in open-loop mode. Cumulative latencies from the intended start time to the
+     * durable commit (or user-requested abort) of each transaction type.
+     */
+    debugging::LatencyHistogram latencies_[kXctTypeCount];
   };
   TpccClientTask(const Inputs& inputs, Outputs* outputs)
     : worker_id_(inputs.worker_id_),
@@ -117,6 +169,9 @@ class TpccClientTask {
       to_wid_(inputs.to_wid_),
       olap_mode_(inputs.olap_mode_),
       dirty_read_mode_(inputs.dirty_read_mode_),
+      repair_mode_(inputs.repair_mode_),
+      arrival_rate_(inputs.arrival_rate_),
+      arrival_type_(inputs.arrival_type_),
       outputs_(outputs),
       neworder_remote_percent_(inputs.neworder_remote_percent_),
       payment_remote_percent_(inputs.payment_remote_percent_),
@@ -176,6 +231,13 @@ class TpccClientTask {
   /** Set to true only when compiled and run in OLAP_MODE and also given dirty_read=true */
   const bool dirty_read_mode_;
 
+  /** @see Inputs::repair_mode_ */
+  const bool repair_mode_;
+
+  /** @see Inputs::arrival_rate_ */
+  const double arrival_rate_;
+  const debugging::ArrivalSchedule::Type arrival_type_;
+
   TpccClientChannel* channel_;
 
   TpccStorages      storages_;
@@ -185,6 +247,8 @@ class TpccClientTask {
   Engine*           engine_;
   Outputs* const    outputs_;
 
+  /** Commit epoch of the last transaction. Invalid if it was not committed. */
+  Epoch             commit_epoch_;
 
   /**
    * Percent of each orderline that is inserted to remote warehouse.
@@ -227,6 +291,10 @@ class TpccClientTask {
   double      output_amounts_[kMaxOlCount];
   double      output_total_;
 
+  // For neworder in repair_mode_. They must be alive until precommit.
+  StockQuantityRepair stock_quantity_repairs_[kMaxOlCount];
+  StockRemoteRepair   stock_remote_repairs_[kMaxOlCount];
+
   void      update_timestring_if_needed();
 
   /** Run the TPCC Neworder transaction. Implemented in tpcc_neworder.cpp. */
@@ -290,6 +358,11 @@ class TpccClientTask {
   ErrorStack warmup(thread::Thread* context);
   ErrorStack warmup_olap(thread::Thread* context);
 };
+
+static_assert(
+  sizeof(TpccClientTask::Outputs) <= soc::ThreadMemoryAnchors::kTaskOutputMemorySize,
+  "TpccClientTask::Outputs too big!");
+
 }  // namespace tpcc
 }  // namespace foedus
 
@@ -24,6 +24,7 @@
 #include <cstring>
 #include <string>
 
+#include "foedus/assert_nd.hpp"
 #include "foedus/error_stack.hpp"
 #include "foedus/fwd.hpp"
 #include "foedus/assorted/uniform_random.hpp"
@@ -79,14 +80,42 @@ class TpceClientTask {
     kRandomCount = 1 << 16,
     /** on average only 3. surely won't be more than this number */
     kMaxCidsPerLname = 128,
+    /**
+     * Capacity of submitted_trades_. When it is full, TradeOrder/MarketFeed just don't
+     * remember the new trade, so the trade stays in the submitted status forever.
+     */
+    kMaxSubmittedTrades = 1 << 12,
   };
+  /** The transactions in TPC-E, Section 3.3. */
+  enum XctType {
+    kBrokerVolume = 0,
+    kCustomerPosition,
+    kMarketFeed,
+    kMarketWatch,
+    kSecurityDetail,
+    kTradeLookup,
+    kTradeOrder,
+    kTradeResult,
+    kTradeStatus,
+    kTradeUpdate,
+    kXctTypeCount,
+  };
+  static const char* get_xct_type_name(XctType type);
+
   struct Inputs {
     TpceScale   scale_;
     PartitionT  worker_id_;
+    /**
+     * If true, we run only TradeOrder (80%) and TradeUpdate (20%) as we did before
+     * implementing the other transactions. Otherwise, the mix in Clause 6.2.2.1 of the spec.
+     */
+    bool        legacy_mix_;
   };
   struct Outputs {
     /** How many transactions processed so far*/
     uint64_t processed_;
+    /** Breakdown of processed_ */
+    uint64_t processed_per_type_[kXctTypeCount];
 
     // statistics
     uint32_t user_requested_aborts_;
@@ -101,9 +130,11 @@ class TpceClientTask {
   TpceClientTask(const Inputs& inputs, Outputs* outputs)
     : scale_(inputs.scale_),
       worker_id_(inputs.worker_id_),
+      legacy_mix_(inputs.legacy_mix_),
       outputs_(outputs),
       rnd_(kRandomSeed + inputs.worker_id_) {
     outputs_->processed_ = 0;
+    std::memset(outputs_->processed_per_type_, 0, sizeof(outputs_->processed_per_type_));
     outputs_->user_requested_aborts_ = 0;
     outputs_->race_aborts_ = 0;
     outputs_->unexpected_aborts_ = 0;
@@ -135,6 +166,7 @@ class TpceClientTask {
   const TpceScale   scale_;
   /** unique ID of this worker from 0 to #workers-1. */
   const PartitionT  worker_id_;
+  const bool        legacy_mix_;
   /**
    * A counter to generate a unique TradeT.
    * This is a thread-local counter. We combine
@@ -173,16 +205,113 @@ class TpceClientTask {
   /** thread local random for symbol generation. */
   assorted::ZipfianRandom zipfian_symbol_;
 
+  /**
+   * Trades that were submitted to the market (status SBMT) but not completed yet.
+   * In the spec, the market emulator (MEE) receives them and invokes TradeResult.
+   * We instead keep them in this thread-local FIFO. TradeOrder (market orders) and
+   * MarketFeed (triggered limit orders) push to it after they commit, and TradeResult
+   * pops from it after it commits. This is a ring buffer of kMaxSubmittedTrades entries.
+   * @note This does NOT conform to the official TPC-E spec. By design.
+   */
+  TradeT            submitted_trades_[kMaxSubmittedTrades];
+  uint32_t          submitted_trades_head_;
+  uint32_t          submitted_trades_count_;
+
+  /** Chooses the next transaction to run as specified in Clause 6.2.2.1 (or legacy_mix_). */
+  XctType choose_xct_type();
+  ErrorCode run_xct(XctType type);
+
+  void push_submitted_trade(TradeT tid) {
+    if (submitted_trades_count_ < kMaxSubmittedTrades) {
+      uint32_t tail = (submitted_trades_head_ + submitted_trades_count_) % kMaxSubmittedTrades;
+      submitted_trades_[tail] = tid;
+      ++submitted_trades_count_;
+    }
+  }
+  void pop_submitted_trade() {
+    ASSERT_ND(submitted_trades_count_ > 0);
+    submitted_trades_head_ = (submitted_trades_head_ + 1U) % kMaxSubmittedTrades;
+    --submitted_trades_count_;
+  }
+
+  IdentT pick_customer() { return rnd_.next_uint64() % scale_.customers_; }
+  IdentT pick_account() { return rnd_.next_uint64() % scale_.get_account_cardinality(); }
+
+  /**
+   * Run the TPCE BrokerVolume transaction. See Section 3.3.1.
+   * Implemented in tpce_broker_volume.cpp.
+   * Read-only. Sums up the pending TRADE_REQUEST of up to 20 brokers in a sector.
+   */
+  ErrorCode do_broker_volume();
+
+  /**
+   * Run the TPCE CustomerPosition transaction. See Section 3.3.2.
+   * Implemented in tpce_customer_position.cpp.
+   * Read-only. Frame-1 values the holdings of all accounts of a customer.
+   * Frame-2 lists the recent trades of one account. We don't have TRADE_HISTORY,
+   * so Frame-2 returns the status of the trades instead of their histories.
+   */
+  ErrorCode do_customer_position();
+
+  /**
+   * Run the TPCE MarketFeed transaction. See Section 3.3.3.
+   * Implemented in tpce_market_feed.cpp.
+   * Updates LAST_TRADE of 20 symbols and triggers limit orders waiting in TRADE_REQUEST.
+   */
+  ErrorCode do_market_feed();
+
+  /**
+   * Run the TPCE MarketWatch transaction. See Section 3.3.4.
+   * Implemented in tpce_market_watch.cpp.
+   * Read-only. Computes the market-cap change of the securities in a customer's watch list.
+   * We omit the variants that pick securities from an account's holdings or an industry.
+   */
+  ErrorCode do_market_watch();
+
+  /**
+   * Run the TPCE SecurityDetail transaction. See Section 3.3.5.
+   * Implemented in tpce_security_detail.cpp.
+   * Read-only. We don't have ADDRESS/EXCHANGE/FINANCIAL/NEWS tables, so this reads
+   * SECURITY, COMPANY, LAST_TRADE, and 5 to 20 days of DAILY_MARKET.
+   */
+  ErrorCode do_security_detail();
+
+  /**
+   * Run the TPCE TradeLookup transaction. See Section 3.3.6.
+   * Implemented in tpce_trade_lookup.cpp.
+   * Read-only. Frame-1 looks up given trade IDs, Frame-2 scans an account's trades,
+   * Frame-3 scans a symbol's trades. We omit Frame-4 (TRADE_HISTORY/HOLDING_HISTORY).
+   */
+  ErrorCode do_trade_lookup();
+  /** Reads TRADE, SETTLEMENT, and CASH_TRANSACTION of the trade for TradeLookup. */
+  ErrorCode lookup_trade_details(TradeT tid, bool* found);
+
   /**
    * Run the TPCE TradeOrder transaction. See Section 3.3.7.
    * Implemented in tpce_trade_order.cpp.
    * It's supposed to consist of six frames, but so far
-   * we only implement the 3rd and 4th frames
-   * (5th/6th are commit/rollback, tho).
-   * Further, we access only TRADE and TRADE_TYPE tables.
+   * we omit the permission check of Frame-2 and the tax/commission
+   * computation of Frame-3.
+   * Market orders are submitted right away, while limit orders wait in TRADE_REQUEST
+   * until MarketFeed triggers them.
    */
   ErrorCode do_trade_order();
 
+  /**
+   * Run the TPCE TradeResult transaction. See Section 3.3.8.
+   * Implemented in tpce_trade_result.cpp.
+   * Completes the oldest trade in submitted_trades_. We keep one HOLDING_SUMMARY
+   * row per account and symbol rather than individual HOLDING rows.
+   */
+  ErrorCode do_trade_result();
+
+  /**
+   * Run the TPCE TradeStatus transaction. See Section 3.3.9.
+   * Implemented in tpce_trade_status.cpp.
+   * Read-only. Lists the latest 50 trades of an account.
+   */
+  ErrorCode do_trade_status();
+
   /**
    * Run the TPCE TradeUpdate transaction. See Section 3.3.10.
    * Implemented in tpce_trade_update.cpp.
@@ -20,6 +20,7 @@
 
 #include <stdint.h>
 
+#include <cstring>
 #include <iosfwd>
 #include <string>
 #include <vector>
@@ -28,6 +29,7 @@
 #include "foedus/thread/rendezvous_impl.hpp"
 #include "foedus/tpce/fwd.hpp"
 #include "foedus/tpce/tpce.hpp"
+#include "foedus/tpce/tpce_client.hpp"
 #include "foedus/tpce/tpce_schema.hpp"
 
 namespace foedus {
@@ -62,10 +64,14 @@ class TpceDriver {
         largereadset_aborts_(0),
         unexpected_aborts_(0),
         snapshot_cache_hits_(0),
-        snapshot_cache_misses_(0) {}
+        snapshot_cache_misses_(0) {
+      std::memset(processed_per_type_, 0, sizeof(processed_per_type_));
+    }
     double   duration_sec_;
     uint32_t worker_count_;
     uint64_t processed_;
+    /** Breakdown of processed_ by TpceClientTask::XctType */
+    uint64_t processed_per_type_[TpceClientTask::kXctTypeCount];
     uint64_t user_requested_aborts_;
     uint64_t race_aborts_;
     uint64_t largereadset_aborts_;
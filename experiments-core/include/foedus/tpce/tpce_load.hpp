@@ -60,6 +60,8 @@ ErrorStack create_masstree(
   storage::masstree::Layer min_layer_hint);
 ErrorStack create_sequential(Engine* engine, const storage::StorageName& name);
 
+struct SecondaryKeyValue;
+
 class TpceFinishupTask {
  public:
   struct Inputs {
@@ -120,8 +122,35 @@ class TpceLoadTask {
 
   ErrorCode  commit_if_full();
 
-  /** Loads the Trade table. */
+  /** [from, to) of count rows that this partition loads. */
+  void get_partition_range(uint64_t count, uint64_t* from, uint64_t* to) const;
+
+  /**
+   * Calls row_loader(i) for i in [from, to), committing every batch_size rows.
+   * A batch is retried when it hits a race abort.
+   */
+  template <typename ROW_LOADER>
+  ErrorStack load_in_batches(
+    const char* table_name,
+    uint64_t from,
+    uint64_t to,
+    uint64_t batch_size,
+    ROW_LOADER row_loader);
+
+  /** Loads the Trade table, SETTLEMENT, CASH_TRANSACTION, and the two secondary indexes. */
   ErrorStack load_trades();
+  /** Inserts the sorted key-values to the secondary index of TRADE. */
+  ErrorStack load_secondary_index(
+    storage::masstree::MasstreeStorage index,
+    SecondaryKeyValue* sorted_array,
+    uint64_t count);
+
+  /** Loads the Broker table. */
+  ErrorStack load_brokers();
+  /** Loads COMPANY, SECURITY, LAST_TRADE, and DAILY_MARKET. */
+  ErrorStack load_market_tables();
+  /** Loads CUSTOMER_ACCOUNT, HOLDING_SUMMARY, and WATCH_ITEM. */
+  ErrorStack load_customer_tables();
 
   /** Loads the TradeType table. */
   ErrorStack load_trade_types();
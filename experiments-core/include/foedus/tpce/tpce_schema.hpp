@@ -20,6 +20,7 @@
 
 #include <stdint.h>
 
+#include <cstring>
 #include <ctime>
 #include <string>
 
@@ -58,8 +59,38 @@ struct TpceStorages {
    * Used in a cursor for OrderUpdate etc.
    */
   storage::masstree::MasstreeStorage      trades_secondary_symb_dts_;
+  /**
+   * Index(CA_ID,DTS) on TRADE. Key is CaDtsKey, Value is TradeT.
+   * Used to list the recent trades of an account in TradeStatus/CustomerPosition/TradeLookup.
+   */
+  storage::masstree::MasstreeStorage      trades_secondary_ca_dts_;
   /** Index in TRADE_TYPE has no meaning. Always TradeTypeData::kCount entries. */
   storage::array::ArrayStorage            trade_types_;
+  /** SETTLEMENT table. TradeT as PK. */
+  storage::hash::HashStorage              settlements_;
+  /** CASH_TRANSACTION table. TradeT as PK. Only cash trades have one. */
+  storage::hash::HashStorage              cash_transactions_;
+  /**
+   * TRADE_REQUEST table. Key is TradeRequestKey, so that MarketFeed can find
+   * pending limit orders of a symbol with a cursor.
+   */
+  storage::masstree::MasstreeStorage      trade_requests_;
+  /** BROKER table. B_ID as the index. */
+  storage::array::ArrayStorage            brokers_;
+  /** CUSTOMER_ACCOUNT table. CA_ID as the index. */
+  storage::array::ArrayStorage            accounts_;
+  /** HOLDING_SUMMARY table. Key is HoldingSummaryKey to list holdings of an account. */
+  storage::masstree::MasstreeStorage      holding_summaries_;
+  /** WATCH_ITEM table, merged with WATCH_LIST (one list per customer). Key is WatchItemKey. */
+  storage::masstree::MasstreeStorage      watch_items_;
+  /** SECURITY table. SymbT as the index. */
+  storage::array::ArrayStorage            securities_;
+  /** COMPANY table. CO_ID as the index. */
+  storage::array::ArrayStorage            companies_;
+  /** LAST_TRADE table. SymbT as the index. */
+  storage::array::ArrayStorage            last_trades_;
+  /** DAILY_MARKET table. Key is DailyMarketKey to read consecutive days of a symbol. */
+  storage::masstree::MasstreeStorage      daily_markets_;
 };
 
 /// See Section 2.2.2 of the TPC-E spec.
@@ -134,8 +165,8 @@ typedef uint32_t PartitionT;
 
 /**
  * This is a drastic simplification from full TPC-E.
- * We don't have SECURITY table yet. so we can't query on symbols.
- * Instead, we just use an integer to represent s_symb_.
+ * Instead of the 15-char S_SYMB, we just use an integer to represent s_symb_,
+ * which is also the index in SECURITY and LAST_TRADE tables.
  * The value is 0 to TpceScale::get_security_cardinality() - 1.
  * @see TpceScale::get_security_cardinality()
  */
@@ -147,6 +178,21 @@ typedef uint32_t SymbT;
  */
 const SymbT kMaxSymbT = 1U << 20;
 
+/**
+ * In the same way, CA_ID is assumed to consume up to 20 bits in CaDtsKey.
+ * This means we so far support up to 2^20 / 5 = 209715 customers.
+ */
+const IdentT kMaxCaT = 1U << 20;
+
+const uint32_t kSecondsPerDay = 24U * 3600U;
+
+/**
+ * The spec populates DAILY_MARKET for 1305 days (five years).
+ * We populate fewer days to save loading time. Still enough for SecurityDetail,
+ * which reads up to 20 days.
+ */
+const uint32_t kDailyMarketDays = 64;
+
 /**
  * The spec says CUSTOMER_ACCOUNT's cardinality is always
  * 5 * customers. Our implementation thus constructs
@@ -154,6 +200,12 @@ const SymbT kMaxSymbT = 1U << 20;
  */
 const IdentT kAccountsPerCustomer = 5;
 
+/** The spec says HOLDING_SUMMARY has about 10 rows per CUSTOMER_ACCOUNT. */
+const uint32_t kHoldingsPerAccount = 10;
+
+/** The spec says WATCH_ITEM has 1 to 200 (100 in average) rows per WATCH_LIST. We use 20. */
+const uint32_t kWatchItemsPerCustomer = 20;
+
 /**
  * Parameters to determine the size of TPC-E tables.
  * See Section 2.6.
@@ -190,6 +242,12 @@ struct TpceScale {
    */
   double symbol_skew_;
 
+  /**
+   * When the initial population was generated. Initial trades and DAILY_MARKET rows are
+   * dated before this.
+   */
+  Datetime load_dts_;
+
   uint64_t get_tpse() const {
     return customers_ / 500U;
   }
@@ -201,6 +259,27 @@ struct TpceScale {
   uint64_t get_security_cardinality() const {
     return 685U * customers_ / 1000U;
   }
+
+  uint64_t get_company_cardinality() const {
+    return 500U * customers_ / 1000U;
+  }
+
+  /** The spec has one broker per 100 customers. */
+  uint64_t get_broker_cardinality() const {
+    return customers_ < 100U ? 1U : customers_ / 100U;
+  }
+
+  uint64_t get_account_cardinality() const {
+    return customers_ * kAccountsPerCustomer;
+  }
+
+  /** DAILY_MARKET has rows for days (Datetime / kSecondsPerDay) in [from, to). */
+  uint32_t get_daily_market_to_day() const {
+    return load_dts_ / kSecondsPerDay;
+  }
+  uint32_t get_daily_market_from_day() const {
+    return get_daily_market_to_day() - kDailyMarketDays;
+  }
 };
 
 /** TRADE table, Section 2.2.5.6 */
@@ -268,6 +347,28 @@ inline PartitionT to_uniquefier_from_symb_dts_key(SymbDtsKey key) {
   return static_cast<PartitionT>(key & ((1U << 12) - 1U));
 }
 
+/**
+ * Composite Key for the secondary index TRADE(CA_ID,DTS).
+ * Same layout as SymbDtsKey. High 20-bits are CA_ID, next 32-bits are DTS, then
+ * the last 12 bits are partition_id just as a uniquefier.
+ */
+typedef uint64_t CaDtsKey;
+
+inline CaDtsKey to_ca_dts_key(IdentT ca_id, Datetime dts, PartitionT partition_id) {
+  ASSERT_ND(ca_id < kMaxCaT);
+  ASSERT_ND(partition_id < (1U << 12));
+  CaDtsKey ret = static_cast<CaDtsKey>(ca_id);
+  ret = (ret << 32) | dts;
+  ret = (ret << 12) | partition_id;
+  return ret;
+}
+inline IdentT to_ca_from_ca_dts_key(CaDtsKey key) {
+  return static_cast<IdentT>(key >> 44);
+}
+inline Datetime to_dts_from_ca_dts_key(CaDtsKey key) {
+  return static_cast<Datetime>(key >> 12);
+}
+
 
 /**
  * @brief generates a new and unique TradeT
@@ -331,8 +432,193 @@ struct TradeTypeData {
         return "TSL";
     }
   }
+  /** Inverse of generate_type_id() */
+  static uint16_t to_index(const char* type_id) {
+    for (uint16_t i = 0; i < kCount; ++i) {
+      if (std::memcmp(generate_type_id(i), type_id, 3) == 0) {
+        return i;
+      }
+    }
+    ASSERT_ND(false);
+    return kTsl;
+  }
+};
+
+/**
+ * Status of a trade (ST_ID). We don't have STATUS_TYPE table.
+ * The names in the spec are directly written in TradeData::st_id_.
+ */
+const char* const kStatusCompleted = "CMPT";
+const char* const kStatusPending = "PNDG";
+const char* const kStatusSubmitted = "SBMT";
+
+/** SETTLEMENT table, Section 2.2.5.5 */
+struct SettlementData {
+  TradeT    trade_id_;
+  char      cash_type_[40];
+  Datetime  due_date_;
+  ValueT    amt_;
+
+  /** Sets SE_CASH_TYPE from the trade's T_IS_CASH, zero-padding the rest of the field. */
+  void set_cash_type(bool is_cash) {
+    const char* name = is_cash ? "Cash Account" : "Margin";
+    std::memset(cash_type_, 0, sizeof(cash_type_));
+    std::memcpy(cash_type_, name, std::strlen(name));
+  }
+};
+
+/** CASH_TRANSACTION table, Section 2.2.5.2 */
+struct CashTransactionData {
+  TradeT    trade_id_;
+  Datetime  dts_;
+  ValueT    amt_;
+  char      name_[100];
 };
 
+/** TRADE_REQUEST table, Section 2.2.5.8. TR_S_SYMB is in the key. */
+struct TradeRequestData {
+  TradeT    trade_id_;
+  char      tt_id_[3];
+  SQtyT     qty_;
+  SPriceT   bid_price_;
+  IdentT    b_id_;
+};
+
+/**
+ * Key of TRADE_REQUEST. High 20-bits are SYMB_ID, and the remaining 44 bits are TradeT,
+ * which is unique by itself.
+ */
+typedef uint64_t TradeRequestKey;
+
+inline TradeRequestKey to_trade_request_key(SymbT symb_id, TradeT tid) {
+  ASSERT_ND(symb_id < kMaxSymbT);
+  ASSERT_ND(tid < (1ULL << 44));
+  return (static_cast<TradeRequestKey>(symb_id) << 44) | tid;
+}
+inline SymbT to_symb_from_trade_request_key(TradeRequestKey key) {
+  return static_cast<SymbT>(key >> 44);
+}
+
+/** BROKER table, Section 2.2.5.1 */
+struct BrokerData {
+  IdentT    id_;
+  char      st_id_[4];
+  char      name_[49];
+  /** Incremented by TradeResult */
+  uint32_t  num_trades_;
+  /** Incremented by TradeResult */
+  ValueT    comm_total_;
+};
+
+/** CUSTOMER_ACCOUNT table, Section 2.2.4.3 */
+struct CustomerAccountData {
+  IdentT    id_;
+  IdentT    b_id_;
+  IdentT    c_id_;
+  char      name_[50];
+  uint8_t   tax_st_;
+  /** Incremented by TradeResult */
+  ValueT    bal_;
+};
+
+/** HOLDING_SUMMARY table, Section 2.2.4.7. Both HS_CA_ID and HS_S_SYMB are in the key. */
+struct HoldingSummaryData {
+  SQtyT     qty_;
+};
+
+/** Key of HOLDING_SUMMARY. High 32-bits are CA_ID, low 32-bits are SymbT. */
+typedef uint64_t HoldingSummaryKey;
+
+inline HoldingSummaryKey to_holding_summary_key(IdentT ca_id, SymbT symb_id) {
+  return (static_cast<HoldingSummaryKey>(ca_id) << 32) | symb_id;
+}
+inline SymbT to_symb_from_holding_summary_key(HoldingSummaryKey key) {
+  return static_cast<SymbT>(key);
+}
+
+/**
+ * Key of WATCH_ITEM. High 32-bits are C_ID, low 32-bits are SymbT.
+ * We assume each customer has one WATCH_LIST, so WL_ID is same as C_ID.
+ * The value is empty.
+ */
+typedef uint64_t WatchItemKey;
+
+inline WatchItemKey to_watch_item_key(IdentT c_id, SymbT symb_id) {
+  return (static_cast<WatchItemKey>(c_id) << 32) | symb_id;
+}
+inline SymbT to_symb_from_watch_item_key(WatchItemKey key) {
+  return static_cast<SymbT>(key);
+}
+
+/** The spec has 12 sectors and 102 industries. We assign industries to sectors round robin. */
+const uint16_t kSectors = 12;
+const uint16_t kIndustries = 102;
+
+inline uint16_t to_sector_from_industry(uint16_t industry_id) {
+  return industry_id % kSectors;
+}
+
+/** COMPANY table, Section 2.2.6.1. CO_IN_ID is an index of industries. */
+struct CompanyData {
+  IdentT    id_;
+  char      st_id_[4];
+  char      name_[60];
+  uint16_t  industry_id_;
+  char      sp_rate_[4];
+  char      ceo_[46];
+  char      desc_[150];
+  Datetime  open_date_;
+};
+
+/** SECURITY table, Section 2.2.6.11 */
+struct SecurityData {
+  SymbT     id_;
+  char      issue_[6];
+  char      st_id_[4];
+  char      name_[70];
+  char      ex_id_[6];
+  IdentT    co_id_;
+  SCountT   num_out_;
+  Datetime  start_date_;
+  Datetime  exch_date_;
+  SPriceT   pe_;
+  SPriceT   high_52wk_;
+  Datetime  high_52wk_date_;
+  SPriceT   low_52wk_;
+  Datetime  low_52wk_date_;
+  ValueT    dividend_;
+  ValueT    yield_;
+};
+
+/** LAST_TRADE table, Section 2.2.6.7 */
+struct LastTradeData {
+  SymbT     symb_id_;
+  Datetime  dts_;
+  /** Updated by MarketFeed */
+  SPriceT   price_;
+  SPriceT   open_price_;
+  /** Incremented by MarketFeed */
+  SCountT   vol_;
+};
+
+/** DAILY_MARKET table, Section 2.2.6.3 */
+struct DailyMarketData {
+  /** Datetime / kSecondsPerDay */
+  uint32_t  day_;
+  SymbT     symb_id_;
+  SPriceT   close_;
+  SPriceT   high_;
+  SPriceT   low_;
+  SCountT   vol_;
+};
+
+/** Key of DAILY_MARKET. High 32-bits are SymbT, low 32-bits are the day. */
+typedef uint64_t DailyMarketKey;
+
+inline DailyMarketKey to_daily_market_key(SymbT symb_id, uint32_t day) {
+  return (static_cast<DailyMarketKey>(symb_id) << 32) | day;
+}
+
 }  // namespace tpce
 }  // namespace foedus
 
@@ -33,6 +33,8 @@
 #include "foedus/assorted/assorted_func.hpp"
 #include "foedus/assorted/cacheline.hpp"
 #include "foedus/assorted/endianness.hpp"
+#include "foedus/debugging/latency_histogram.hpp"
+#include "foedus/debugging/open_loop.hpp"
 #include "foedus/proc/proc_manager.hpp"
 #include "foedus/soc/shared_memory_repo.hpp"
 #include "foedus/soc/shared_rendezvous.hpp"
@@ -300,6 +302,15 @@ struct ThroughputAndAbort {
 
 class YcsbClientTask {
  public:
+  /** Transaction types. Index of Outputs::latencies_. */
+  enum XctType {
+    kInsert = 0,
+    kRead,
+    kUpdate,
+    kScan,
+    kRmw,
+    kXctTypeCount,
+  };
   struct Inputs {
     uint32_t worker_id_;
     YcsbWorkload workload_;
@@ -316,6 +327,12 @@ class YcsbClientTask {
     uint64_t initial_table_size_;
     uint64_t extra_table_size_;
     PerWorkerCounter* local_key_counter_;
+    /**
+     * Average transactions per second this worker issues in open-loop mode.
+     * 0 means the usual closed-loop mode.
+     */
+    double arrival_rate_;
+    debugging::ArrivalSchedule::Type arrival_type_;
     Inputs() {}
   };
 
@@ -334,6 +351,11 @@ class YcsbClientTask {
     uint64_t snapshot_cache_hits_;
     uint64_t snapshot_cache_misses_;
     ThroughputAndAbort bucketed_throughputs_[kMaxOutputBuckets];
+    /**
+     * Only in open-loop mode. Cumulative latencies from the intended start time to the
+     * durable commit of each transaction type.
+     */
+    debugging::LatencyHistogram latencies_[kXctTypeCount];
     friend std::ostream& operator<<(std::ostream& o, const Outputs& v);
   };
 
@@ -350,6 +372,8 @@ class YcsbClientTask {
       outputs_(outputs),
       local_key_counter_(inputs.local_key_counter_),
       zipfian_theta_(inputs.zipfian_theta_),
+      arrival_rate_(inputs.arrival_rate_),
+      arrival_type_(inputs.arrival_type_),
       rnd_record_select_(4584287 + inputs.worker_id_),
       rnd_field_select_(37 + inputs.worker_id_),
       rnd_scan_length_select_(47920 + inputs.worker_id_),
@@ -383,6 +407,9 @@ class YcsbClientTask {
   Outputs* outputs_;
   PerWorkerCounter* local_key_counter_;
   double zipfian_theta_;
+  /** @see Inputs::arrival_rate_ */
+  double arrival_rate_;
+  debugging::ArrivalSchedule::Type arrival_type_;
   YcsbKey key_arena_;   // Don't use this from other threads!
 
   Engine* engine_;
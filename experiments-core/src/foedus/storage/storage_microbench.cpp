@@ -0,0 +1,842 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+/**
+ * @file foedus/storage/storage_microbench.cpp
+ * @brief Microbenchmarks of the primitive operations of all storage types
+ * @details
+ * One binary for get/insert/overwrite/scan/append on array, hash, masstree and sequential
+ * storages. Each benchmark case is a combination of storage type, operation, key length,
+ * payload size, key distribution (uniform or zipfian) and cache state (warm or cold).
+ * The cases are generated from the cross product of the list-type flags, skipping
+ * combinations that do not make sense (eg get on sequential storage).
+ * Every case runs on a freshly initialized engine once per thread count in -thread_counts.
+ *
+ * \li \b warm: the records are loaded to volatile pages, and the workers run -warmup_micro
+ * before measurement.
+ * \li \b cold: after loading, a snapshot is taken, which drops volatile pages as the storage
+ * does by default. The measurement starts immediately, so reads begin with an empty
+ * snapshot cache. Only read operations (get, scan) have cold cases.
+ *
+ * Each worker measures its own elapsed time with both StopWatch and RdtscWatch.
+ * ns/op and cycles/op are the sum of per-worker elapsed times divided by the number of
+ * operations, thus the average latency of one operation in one thread.
+ * Scans count one operation per record read.
+ * Zipfian keys are scrambled by a multiplicative hash so that hot keys are not adjacent.
+ *
+ * With -papi, PAPI counters of the measured period are reported too if the engine is
+ * built with PAPI. With -json_output, one JSON object per line is appended for each run
+ * so that a script can track regressions.
+ *
+ * @section ENVIRONMENTS Environments
+ * /dev/shm must have room for logs and snapshots of the cold cases.
+ *
+ * @section OTHER Other notes
+ * -list shows the case names. -cases runs the cases whose names contain any of
+ * the comma-separated strings, eg -cases=masstree/get,hash/insert.
+ */
+#include <gflags/gflags.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "foedus/engine.hpp"
+#include "foedus/engine_options.hpp"
+#include "foedus/error_stack.hpp"
+#include "foedus/assorted/endianness.hpp"
+#include "foedus/assorted/uniform_random.hpp"
+#include "foedus/assorted/zipfian_random.hpp"
+#include "foedus/debugging/debugging_supports.hpp"
+#include "foedus/debugging/rdtsc_watch.hpp"
+#include "foedus/debugging/stop_watch.hpp"
+#include "foedus/fs/filesystem.hpp"
+#include "foedus/memory/aligned_memory.hpp"
+#include "foedus/proc/proc_manager.hpp"
+#include "foedus/snapshot/snapshot_manager.hpp"
+#include "foedus/soc/shared_memory_repo.hpp"
+#include "foedus/soc/shared_rendezvous.hpp"
+#include "foedus/soc/soc_manager.hpp"
+#include "foedus/storage/storage_manager.hpp"
+#include "foedus/storage/array/array_metadata.hpp"
+#include "foedus/storage/array/array_storage.hpp"
+#include "foedus/storage/hash/hash_metadata.hpp"
+#include "foedus/storage/hash/hash_storage.hpp"
+#include "foedus/storage/masstree/masstree_cursor.hpp"
+#include "foedus/storage/masstree/masstree_metadata.hpp"
+#include "foedus/storage/masstree/masstree_storage.hpp"
+#include "foedus/storage/sequential/sequential_cursor.hpp"
+#include "foedus/storage/sequential/sequential_metadata.hpp"
+#include "foedus/storage/sequential/sequential_storage.hpp"
+#include "foedus/thread/thread.hpp"
+#include "foedus/thread/thread_pool.hpp"
+#include "foedus/xct/xct_manager.hpp"
+
+namespace foedus {
+namespace storage {
+
+DEFINE_string(storages, "array,hash,masstree,sequential", "Storage types to run.");
+DEFINE_string(ops, "get,insert,overwrite,scan,append", "Operations to run.");
+DEFINE_string(key_lengths, "8,16,32", "Key lengths in bytes for hash and masstree. At least 8.");
+DEFINE_string(payloads, "16,100", "Payload sizes in bytes.");
+DEFINE_string(distributions, "uniform,zipfian", "Key distributions of get/overwrite/scan.");
+DEFINE_string(caches, "warm,cold", "Cache states. cold is available only for get/scan.");
+DEFINE_string(thread_counts, "1", "Numbers of worker threads to run each case with.");
+DEFINE_string(cases, "", "If not empty, run only cases whose names contain any of these"
+  " comma-separated strings.");
+DEFINE_bool(list, false, "Only list the case names.");
+DEFINE_int32(records, 100000, "Number of records loaded before each case.");
+DEFINE_double(zipfian_theta, 0.99, "Skew of zipfian distribution. [0, 1).");
+DEFINE_int32(ops_per_xct, 10, "Number of operations (range scans for scan) per transaction.");
+DEFINE_int32(scan_length, 100, "Number of records read by one masstree range scan.");
+DEFINE_int64(warmup_micro, 200000, "Microseconds to run warm cases before measurement.");
+DEFINE_int64(duration_micro, 1000000, "Microseconds to measure each case.");
+DEFINE_int32(volatile_pool_size, 1024, "Size of volatile memory pool per NUMA node in MB.");
+DEFINE_bool(suppress_memory_prescreen, false, "Whether to turn off environment check.");
+DEFINE_bool(null_log_device, true, "Whether to disable log writing in warm cases.");
+DEFINE_bool(papi, false, "Whether to report PAPI counters.");
+DEFINE_string(json_output, "", "If not empty, append the results to this file as JSON lines.");
+
+const char* kStorageName = "microbench";
+const char* kFolder = "/dev/shm/foedus_microbench";
+
+/** An odd prime larger than kMaxRecords to scramble zipfian ranks */
+const uint64_t kScramblePrime = 1000000007ULL;
+const uint64_t kMaxRecords = 1ULL << 29;
+
+enum BenchOp {
+  kOpGet = 0,
+  kOpInsert,
+  kOpOverwrite,
+  kOpScan,
+  kOpAppend,
+  kOpCount,
+};
+const char* kOpNames[kOpCount] = { "get", "insert", "overwrite", "scan", "append" };
+
+enum KeyDistribution {
+  kUniform = 0,
+  kZipfian,
+};
+
+/** One benchmark case. POD so that it can be placed in shared memory. */
+struct BenchCase {
+  StorageType     storage_;
+  BenchOp         op_;
+  /** 0 for array and sequential, which have no keys */
+  uint16_t        key_length_;
+  uint16_t        payload_;
+  KeyDistribution distribution_;
+  bool            cold_;
+
+  bool is_read() const { return op_ == kOpGet || op_ == kOpScan; }
+  /** Whether the key distribution matters */
+  bool is_keyed_access() const {
+    return op_ == kOpGet
+      || op_ == kOpOverwrite
+      || (op_ == kOpScan && storage_ != kSequentialStorage);
+  }
+  std::string name() const {
+    std::stringstream str;
+    str << storage_type_name() << "/" << kOpNames[op_] << "/";
+    if (key_length_ > 0) {
+      str << "k" << key_length_ << "/";
+    }
+    str << "p" << payload_ << "/";
+    if (is_keyed_access()) {
+      str << (distribution_ == kZipfian ? "zipfian/" : "uniform/");
+    }
+    str << (cold_ ? "cold" : "warm");
+    return str.str();
+  }
+  const char* storage_type_name() const {
+    switch (storage_) {
+    case kArrayStorage: return "array";
+    case kHashStorage: return "hash";
+    case kMasstreeStorage: return "masstree";
+    default: return "sequential";
+    }
+  }
+};
+
+bool is_valid_case(const BenchCase& c) {
+  switch (c.op_) {
+  case kOpGet:
+  case kOpOverwrite:
+    if (c.storage_ == kSequentialStorage) {
+      return false;
+    }
+    break;
+  case kOpInsert:
+    if (c.storage_ != kHashStorage && c.storage_ != kMasstreeStorage) {
+      return false;
+    }
+    break;
+  case kOpScan:
+    if (c.storage_ != kMasstreeStorage && c.storage_ != kSequentialStorage) {
+      return false;
+    }
+    break;
+  default:
+    ASSERT_ND(c.op_ == kOpAppend);
+    if (c.storage_ != kSequentialStorage) {
+      return false;
+    }
+  }
+  return !c.cold_ || c.is_read();
+}
+
+struct ExperimentControlBlock {
+  void initialize(const BenchCase& bench_case, uint16_t threads) {
+    bench_case_ = bench_case;
+    threads_ = threads;
+    start_rendezvous_.initialize();
+    measure_requested_ = false;
+    stop_requested_ = false;
+  }
+  void uninitialize() {
+    start_rendezvous_.uninitialize();
+  }
+  BenchCase             bench_case_;
+  uint16_t              threads_;
+  soc::SharedRendezvous start_rendezvous_;
+  std::atomic<bool>     measure_requested_;
+  std::atomic<bool>     stop_requested_;
+};
+
+struct WorkerResult {
+  uint64_t  ops_;
+  uint64_t  aborts_;
+  uint64_t  elapsed_ns_;
+  uint64_t  elapsed_cycles_;
+};
+
+ExperimentControlBlock* get_control_block(Engine* engine) {
+  return reinterpret_cast<ExperimentControlBlock*>(
+    engine->get_soc_manager()->get_shared_memory_repo()->get_global_user_memory());
+}
+
+/** Keys are a fixed prefix followed by the big-endian index, which makes long keys share slices */
+class KeyBuffer {
+ public:
+  explicit KeyBuffer(uint16_t key_length) : key_length_(key_length), key_(key_length, 'k') {
+    ASSERT_ND(key_length >= sizeof(uint64_t));
+  }
+  const char* make(uint64_t index) {
+    assorted::write_bigendian<uint64_t>(index, &key_[key_length_ - sizeof(uint64_t)]);
+    return &key_[0];
+  }
+  uint16_t get_length() const { return key_length_; }
+
+ private:
+  const uint16_t    key_length_;
+  std::vector<char> key_;
+};
+
+class KeyChooser {
+ public:
+  KeyChooser(KeyDistribution distribution, uint64_t records, uint64_t seed)
+    : distribution_(distribution), records_(records), uniform_(seed) {
+    if (distribution_ == kZipfian) {
+      // zeta() is O(records). okay as we do this only once per worker.
+      zipfian_.init(records, FLAGS_zipfian_theta, seed);
+    }
+  }
+  uint64_t next() {
+    if (distribution_ == kUniform) {
+      return uniform_.uniform_within(0, records_ - 1U);
+    }
+    return (zipfian_.next() * kScramblePrime) % records_;
+  }
+
+ private:
+  const KeyDistribution   distribution_;
+  const uint64_t          records_;
+  assorted::UniformRandom uniform_;
+  assorted::ZipfianRandom zipfian_;
+};
+
+ErrorStack microbench_load_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  Engine* engine = args.engine_;
+  xct::XctManager* xct_manager = engine->get_xct_manager();
+  const BenchCase bench_case = get_control_block(engine)->bench_case_;
+  StorageManager* storage_manager = engine->get_storage_manager();
+  const uint64_t records = FLAGS_records;
+  const uint32_t kCommitBatch = 1000;
+  std::vector<char> payload(bench_case.payload_, 'p');
+  KeyBuffer key(std::max<uint16_t>(bench_case.key_length_, sizeof(uint64_t)));
+  Epoch commit_epoch;
+  for (uint64_t from = 0; from < records; from += kCommitBatch) {
+    const uint64_t to = std::min<uint64_t>(from + kCommitBatch, records);
+    WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+    for (uint64_t i = from; i < to; ++i) {
+      switch (bench_case.storage_) {
+      case kArrayStorage:
+        WRAP_ERROR_CODE(storage_manager->get_array(kStorageName).overwrite_record(
+          context,
+          i,
+          &payload[0]));
+        break;
+      case kHashStorage:
+        WRAP_ERROR_CODE(storage_manager->get_hash(kStorageName).insert_record(
+          context,
+          key.make(i),
+          key.get_length(),
+          &payload[0],
+          bench_case.payload_));
+        break;
+      case kMasstreeStorage:
+        WRAP_ERROR_CODE(storage_manager->get_masstree(kStorageName).insert_record(
+          context,
+          key.make(i),
+          key.get_length(),
+          &payload[0],
+          bench_case.payload_));
+        break;
+      default:
+        ASSERT_ND(bench_case.storage_ == kSequentialStorage);
+        WRAP_ERROR_CODE(storage_manager->get_sequential(kStorageName).append_record(
+          context,
+          &payload[0],
+          bench_case.payload_));
+      }
+    }
+    WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  }
+  WRAP_ERROR_CODE(xct_manager->wait_for_commit(commit_epoch));
+  return kRetOk;
+}
+
+class BenchWorker {
+ public:
+  BenchWorker(thread::Thread* context, uint16_t ordinal)
+    : context_(context),
+      engine_(context->get_engine()),
+      xct_manager_(engine_->get_xct_manager()),
+      control_(get_control_block(engine_)),
+      bench_case_(control_->bench_case_),
+      ordinal_(ordinal),
+      key_(std::max<uint16_t>(bench_case_.key_length_, sizeof(uint64_t))),
+      chooser_(bench_case_.distribution_, FLAGS_records, ordinal + 1U),
+      payload_(bench_case_.payload_, 'w'),
+      inserted_(0) {
+    std::memset(&result_, 0, sizeof(result_));
+    StorageManager* storage_manager = engine_->get_storage_manager();
+    switch (bench_case_.storage_) {
+    case kArrayStorage:
+      array_ = storage_manager->get_array(kStorageName);
+      break;
+    case kHashStorage:
+      hash_ = storage_manager->get_hash(kStorageName);
+      break;
+    case kMasstreeStorage:
+      masstree_ = storage_manager->get_masstree(kStorageName);
+      break;
+    default:
+      sequential_ = storage_manager->get_sequential(kStorageName);
+    }
+  }
+
+  ErrorStack run() {
+    if (bench_case_.storage_ == kSequentialStorage && bench_case_.op_ == kOpScan) {
+      read_buffer_.alloc(
+        1U << 20,
+        1U << 12,
+        memory::AlignedMemory::kNumaAllocOnnode,
+        context_->get_numa_node());
+    }
+    control_->start_rendezvous_.wait();
+    debugging::StopWatch watch;
+    debugging::RdtscWatch cycles;
+    bool measuring = false;
+    while (!control_->stop_requested_.load(std::memory_order_acquire)) {
+      if (!measuring && control_->measure_requested_.load(std::memory_order_acquire)) {
+        // discard what we did during warmup
+        measuring = true;
+        result_.ops_ = 0;
+        result_.aborts_ = 0;
+        watch.start();
+        cycles.start();
+      }
+      uint64_t ops = 0;
+      ErrorCode ret = run_xct(&ops);
+      if (ret == kErrorCodeOk) {
+        result_.ops_ += ops;
+      } else if (ret == kErrorCodeXctRaceAbort || ret == kErrorCodeXctLockAbort) {
+        ++result_.aborts_;
+      } else {
+        return ERROR_STACK(ret);
+      }
+    }
+    if (measuring) {
+      result_.elapsed_ns_ = watch.stop();
+      result_.elapsed_cycles_ = cycles.stop();
+    }
+    return kRetOk;
+  }
+
+  const WorkerResult& get_result() const { return result_; }
+
+ private:
+  ErrorCode run_xct(uint64_t* ops) {
+    CHECK_ERROR_CODE(xct_manager_->begin_xct(context_, xct::kSerializable));
+    ErrorCode ret = kErrorCodeOk;
+    if (bench_case_.op_ == kOpScan) {
+      ret = bench_case_.storage_ == kMasstreeStorage ? scan_masstree(ops) : scan_sequential(ops);
+    } else {
+      for (int32_t i = 0; i < FLAGS_ops_per_xct && ret == kErrorCodeOk; ++i) {
+        ret = run_op();
+      }
+      *ops = FLAGS_ops_per_xct;
+    }
+    if (ret != kErrorCodeOk) {
+      CHECK_ERROR_CODE(xct_manager_->abort_xct(context_));
+      return ret;
+    }
+    Epoch commit_epoch;
+    return xct_manager_->precommit_xct(context_, &commit_epoch);
+  }
+
+  ErrorCode run_op() {
+    char buf[kPageSize];
+    uint16_t capacity = sizeof(buf);
+    switch (bench_case_.op_) {
+    case kOpGet:
+      if (bench_case_.storage_ == kArrayStorage) {
+        return array_.get_record(context_, chooser_.next(), buf);
+      } else if (bench_case_.storage_ == kHashStorage) {
+        return hash_.get_record(
+          context_,
+          key_.make(chooser_.next()),
+          key_.get_length(),
+          buf,
+          &capacity,
+          true);
+      }
+      return masstree_.get_record(
+        context_,
+        key_.make(chooser_.next()),
+        key_.get_length(),
+        buf,
+        &capacity,
+        true);
+    case kOpInsert: {
+      // each worker inserts its own disjoint keys after the loaded ones
+      const uint64_t index = FLAGS_records + ordinal_ + inserted_ * control_->threads_;
+      ++inserted_;
+      if (bench_case_.storage_ == kHashStorage) {
+        return hash_.insert_record(
+          context_,
+          key_.make(index),
+          key_.get_length(),
+          &payload_[0],
+          bench_case_.payload_);
+      }
+      return masstree_.insert_record(
+        context_,
+        key_.make(index),
+        key_.get_length(),
+        &payload_[0],
+        bench_case_.payload_);
+    }
+    case kOpOverwrite:
+      if (bench_case_.storage_ == kArrayStorage) {
+        return array_.overwrite_record(context_, chooser_.next(), &payload_[0]);
+      } else if (bench_case_.storage_ == kHashStorage) {
+        return hash_.overwrite_record(
+          context_,
+          key_.make(chooser_.next()),
+          key_.get_length(),
+          &payload_[0],
+          0,
+          bench_case_.payload_);
+      }
+      return masstree_.overwrite_record(
+        context_,
+        key_.make(chooser_.next()),
+        key_.get_length(),
+        &payload_[0],
+        0,
+        bench_case_.payload_);
+    default:
+      ASSERT_ND(bench_case_.op_ == kOpAppend);
+      return sequential_.append_record(context_, &payload_[0], bench_case_.payload_);
+    }
+  }
+
+  ErrorCode scan_masstree(uint64_t* ops) {
+    for (int32_t i = 0; i < FLAGS_ops_per_xct; ++i) {
+      masstree::MasstreeCursor cursor(masstree_, context_);
+      CHECK_ERROR_CODE(cursor.open(key_.make(chooser_.next()), key_.get_length()));
+      for (int32_t j = 0; j < FLAGS_scan_length && cursor.is_valid_record(); ++j) {
+        ++(*ops);
+        CHECK_ERROR_CODE(cursor.next());
+      }
+    }
+    return kErrorCodeOk;
+  }
+
+  ErrorCode scan_sequential(uint64_t* ops) {
+    // one transaction scans the whole storage, including records in unsafe epochs
+    sequential::SequentialCursor cursor(
+      context_,
+      sequential_,
+      read_buffer_.get_block(),
+      read_buffer_.get_size(),
+      sequential::SequentialCursor::kNodeFirstMode,
+      INVALID_EPOCH,
+      xct_manager_->get_current_global_epoch().one_more());
+    sequential::SequentialRecordIterator it;
+    while (cursor.is_valid()) {
+      CHECK_ERROR_CODE(cursor.next_batch(&it));
+      while (it.is_valid()) {
+        ++(*ops);
+        it.next();
+      }
+    }
+    return kErrorCodeOk;
+  }
+
+  thread::Thread* const         context_;
+  Engine* const                 engine_;
+  xct::XctManager* const        xct_manager_;
+  ExperimentControlBlock* const control_;
+  const BenchCase               bench_case_;
+  const uint16_t                ordinal_;
+  KeyBuffer                     key_;
+  KeyChooser                    chooser_;
+  std::vector<char>             payload_;
+  uint64_t                      inserted_;
+  array::ArrayStorage           array_;
+  hash::HashStorage             hash_;
+  masstree::MasstreeStorage     masstree_;
+  sequential::SequentialStorage sequential_;
+  memory::AlignedMemory         read_buffer_;
+  WorkerResult                  result_;
+};
+
+ErrorStack microbench_worker_task(const proc::ProcArguments& args) {
+  ASSERT_ND(args.input_len_ == sizeof(uint16_t));
+  const uint16_t ordinal = *reinterpret_cast<const uint16_t*>(args.input_buffer_);
+  BenchWorker worker(args.context_, ordinal);
+  CHECK_ERROR(worker.run());
+  ASSERT_ND(args.output_buffer_size_ >= sizeof(WorkerResult));
+  *args.output_used_ = sizeof(WorkerResult);
+  *reinterpret_cast<WorkerResult*>(args.output_buffer_) = worker.get_result();
+  return kRetOk;
+}
+
+std::vector<std::string> split_flag(const std::string& value) {
+  std::vector<std::string> ret;
+  std::stringstream str(value);
+  std::string item;
+  while (std::getline(str, item, ',')) {
+    if (!item.empty()) {
+      ret.push_back(item);
+    }
+  }
+  return ret;
+}
+
+std::vector<uint32_t> split_numbers(const std::string& value) {
+  std::vector<uint32_t> ret;
+  for (const std::string& item : split_flag(value)) {
+    ret.push_back(std::stoul(item));
+  }
+  return ret;
+}
+
+/** Generates the cases from the list-type flags. */
+std::vector<BenchCase> build_registry() {
+  std::vector<StorageType> storages;
+  for (const std::string& name : split_flag(FLAGS_storages)) {
+    if (name == "array") {
+      storages.push_back(kArrayStorage);
+    } else if (name == "hash") {
+      storages.push_back(kHashStorage);
+    } else if (name == "masstree") {
+      storages.push_back(kMasstreeStorage);
+    } else if (name == "sequential") {
+      storages.push_back(kSequentialStorage);
+    } else {
+      std::cerr << "Unknown storage type: " << name << std::endl;
+    }
+  }
+  std::vector<BenchOp> ops;
+  for (const std::string& name : split_flag(FLAGS_ops)) {
+    const char** found = std::find(kOpNames, kOpNames + kOpCount, name);
+    if (found == kOpNames + kOpCount) {
+      std::cerr << "Unknown operation: " << name << std::endl;
+    } else {
+      ops.push_back(static_cast<BenchOp>(found - kOpNames));
+    }
+  }
+  const std::vector<uint32_t> key_lengths = split_numbers(FLAGS_key_lengths);
+  const std::vector<uint32_t> payloads = split_numbers(FLAGS_payloads);
+  const std::vector<std::string> distributions = split_flag(FLAGS_distributions);
+  const std::vector<std::string> caches = split_flag(FLAGS_caches);
+  const std::vector<std::string> filters = split_flag(FLAGS_cases);
+
+  std::vector<BenchCase> ret;
+  std::vector<std::string> names;
+  for (StorageType storage : storages) {
+    for (BenchOp op : ops) {
+      for (uint32_t key_length : key_lengths) {
+        for (uint32_t payload : payloads) {
+          for (const std::string& distribution : distributions) {
+            for (const std::string& cache : caches) {
+              BenchCase c;
+              c.storage_ = storage;
+              c.op_ = op;
+              bool keyed = storage == kHashStorage || storage == kMasstreeStorage;
+              c.key_length_ = keyed ? key_length : 0;
+              c.payload_ = payload;
+              c.distribution_ = distribution == "zipfian" ? kZipfian : kUniform;
+              c.cold_ = cache == "cold";
+              if (!is_valid_case(c)) {
+                continue;
+              }
+              // array/sequential ignore key lengths, and some ops ignore distributions.
+              const std::string name = c.name();
+              if (std::find(names.begin(), names.end(), name) != names.end()) {
+                continue;
+              }
+              bool matched = filters.empty();
+              for (const std::string& filter : filters) {
+                matched |= name.find(filter) != std::string::npos;
+              }
+              if (matched) {
+                names.push_back(name);
+                ret.push_back(c);
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+  return ret;
+}
+
+ErrorStack create_storage(Engine* engine, const BenchCase& bench_case) {
+  StorageManager* storage_manager = engine->get_storage_manager();
+  Epoch commit_epoch;
+  switch (bench_case.storage_) {
+  case kArrayStorage: {
+    array::ArrayMetadata meta(kStorageName, bench_case.payload_, FLAGS_records);
+    array::ArrayStorage storage;
+    CHECK_ERROR(storage_manager->create_array(&meta, &storage, &commit_epoch));
+    break;
+  }
+  case kHashStorage: {
+    hash::HashMetadata meta(kStorageName);
+    meta.set_capacity(FLAGS_records);
+    hash::HashStorage storage;
+    CHECK_ERROR(storage_manager->create_hash(&meta, &storage, &commit_epoch));
+    break;
+  }
+  case kMasstreeStorage: {
+    masstree::MasstreeMetadata meta(kStorageName);
+    masstree::MasstreeStorage storage;
+    CHECK_ERROR(storage_manager->create_masstree(&meta, &storage, &commit_epoch));
+    break;
+  }
+  default: {
+    sequential::SequentialMetadata meta(kStorageName);
+    sequential::SequentialStorage storage;
+    CHECK_ERROR(storage_manager->create_sequential(&meta, &storage, &commit_epoch));
+  }
+  }
+  return kRetOk;
+}
+
+/** Runs one case with the given number of threads in a new engine. */
+ErrorStack run_case(const BenchCase& bench_case, uint16_t threads, std::ostream* json) {
+  if (fs::exists(fs::Path(kFolder))) {
+    fs::remove_all(fs::Path(kFolder));
+  }
+  EngineOptions options;
+  options.debugging_.debug_log_min_threshold_ = debugging::DebuggingOptions::kDebugLogWarning;
+  options.savepoint_.savepoint_path_.assign(std::string(kFolder) + "/savepoint.xml");
+  options.snapshot_.folder_path_pattern_.assign(std::string(kFolder) + "/snapshot/node_$NODE$");
+  options.log_.folder_path_pattern_.assign(
+    std::string(kFolder) + "/log/node_$NODE$/logger_$LOGGER$");
+  options.log_.flush_at_shutdown_ = false;
+  options.log_.emulation_.null_device_ = FLAGS_null_log_device && !bench_case.cold_;
+  options.snapshot_.snapshot_interval_milliseconds_ = 100000000U;
+  options.memory_.page_pool_size_mb_per_node_ = FLAGS_volatile_pool_size;
+  options.memory_.suppress_memory_prescreening_ = FLAGS_suppress_memory_prescreen;
+  const uint16_t groups = options.thread_.group_count_;
+  options.thread_.thread_count_per_group_ = std::max<uint16_t>(1U, (threads + groups - 1) / groups);
+
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("microbench_load_task", microbench_load_task);
+  engine.get_proc_manager()->pre_register("microbench_worker_task", microbench_worker_task);
+  CHECK_ERROR(engine.initialize());
+  UninitializeGuard guard(&engine);
+  ExperimentControlBlock* control = get_control_block(&engine);
+  control->initialize(bench_case, threads);
+  CHECK_ERROR(create_storage(&engine, bench_case));
+  CHECK_ERROR(engine.get_thread_pool()->impersonate_synchronous("microbench_load_task"));
+  if (bench_case.cold_) {
+    engine.get_snapshot_manager()->trigger_snapshot_immediate(true);
+  }
+
+  std::vector<thread::ImpersonateSession> sessions;
+  for (uint16_t i = 0; i < threads; ++i) {
+    thread::ImpersonateSession session;
+    bool ret = engine.get_thread_pool()->impersonate(
+      "microbench_worker_task",
+      &i,
+      sizeof(i),
+      &session);
+    if (!ret) {
+      return ERROR_STACK_MSG(kErrorCodeInvalidParameter, "Not enough worker threads");
+    }
+    sessions.emplace_back(std::move(session));
+  }
+  control->start_rendezvous_.signal();
+  if (!bench_case.cold_) {
+    std::this_thread::sleep_for(std::chrono::microseconds(FLAGS_warmup_micro));
+  }
+  if (FLAGS_papi) {
+    engine.get_debug()->start_papi_counters();
+  }
+  control->measure_requested_.store(true, std::memory_order_release);
+  std::this_thread::sleep_for(std::chrono::microseconds(FLAGS_duration_micro));
+  control->stop_requested_.store(true, std::memory_order_release);
+  if (FLAGS_papi) {
+    engine.get_debug()->stop_papi_counters();
+  }
+
+  WorkerResult total;
+  std::memset(&total, 0, sizeof(total));
+  ErrorStack worker_error;
+  for (thread::ImpersonateSession& session : sessions) {
+    if (session.get_result().is_error()) {
+      worker_error = session.get_result();
+    } else {
+      WorkerResult result;
+      session.get_output(&result);
+      total.ops_ += result.ops_;
+      total.aborts_ += result.aborts_;
+      total.elapsed_ns_ += result.elapsed_ns_;
+      total.elapsed_cycles_ += result.elapsed_cycles_;
+    }
+    session.release();
+  }
+  control->uninitialize();
+  CHECK_ERROR(worker_error);
+
+  const double ops = std::max<uint64_t>(total.ops_, 1U);
+  const double ns_per_op = total.elapsed_ns_ / ops;
+  const double cycles_per_op = total.elapsed_cycles_ / ops;
+  const double mops = total.ops_ / static_cast<double>(FLAGS_duration_micro);
+  std::cout << bench_case.name() << " threads=" << threads << ": " << total.ops_ << " ops, "
+    << ns_per_op << " ns/op, " << cycles_per_op << " cycles/op, " << mops << " Mops/sec, "
+    << total.aborts_ << " aborts" << std::endl;
+
+  std::stringstream papi;
+  if (FLAGS_papi) {
+    std::vector<std::string> papi_results = debugging::DebuggingSupports::describe_papi_counters(
+      engine.get_debug()->get_papi_counters());
+    for (uint16_t i = 0; i < papi_results.size(); ++i) {
+      std::cout << papi_results[i] << std::endl;
+      papi << (i > 0 ? "," : "") << "\"" << papi_results[i] << "\"";
+    }
+  }
+  if (json) {
+    *json << "{\"case\":\"" << bench_case.name() << "\""
+      << ",\"storage\":\"" << bench_case.storage_type_name() << "\""
+      << ",\"op\":\"" << kOpNames[bench_case.op_] << "\""
+      << ",\"key_length\":" << bench_case.key_length_
+      << ",\"payload\":" << bench_case.payload_
+      << ",\"distribution\":\"" << (bench_case.distribution_ == kZipfian ? "zipfian" : "uniform")
+      << "\",\"cache\":\"" << (bench_case.cold_ ? "cold" : "warm") << "\""
+      << ",\"threads\":" << threads
+      << ",\"records\":" << FLAGS_records
+      << ",\"ops\":" << total.ops_
+      << ",\"aborts\":" << total.aborts_
+      << ",\"duration_micro\":" << FLAGS_duration_micro
+      << ",\"ns_per_op\":" << ns_per_op
+      << ",\"cycles_per_op\":" << cycles_per_op
+      << ",\"mops\":" << mops
+      << ",\"papi\":[" << papi.str() << "]}" << std::endl;
+  }
+
+  CHECK_ERROR(engine.uninitialize());
+  return kRetOk;
+}
+
+int main_impl(int argc, char **argv) {
+  gflags::SetUsageMessage("Microbenchmarks of storage primitives");
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  if (FLAGS_records <= 0 || static_cast<uint64_t>(FLAGS_records) > kMaxRecords) {
+    std::cerr << "-records must be in (0, " << kMaxRecords << "]" << std::endl;
+    return 1;
+  }
+  if (FLAGS_zipfian_theta < 0 || FLAGS_zipfian_theta >= 1.0) {
+    std::cerr << "-zipfian_theta must be in [0, 1)" << std::endl;
+    return 1;
+  }
+
+  const std::vector<BenchCase> cases = build_registry();
+  if (FLAGS_list) {
+    for (const BenchCase& c : cases) {
+      std::cout << c.name() << std::endl;
+    }
+    return 0;
+  }
+  for (const BenchCase& c : cases) {
+    if (c.payload_ > kPageSize / 2 || (c.key_length_ > 0 && c.key_length_ < sizeof(uint64_t))) {
+      std::cerr << "Key length or payload size out of range: " << c.name() << std::endl;
+      return 1;
+    }
+  }
+
+  std::ofstream json_file;
+  if (!FLAGS_json_output.empty()) {
+    json_file.open(FLAGS_json_output, std::ios::out | std::ios::app);
+  }
+  const std::vector<uint32_t> thread_counts = split_numbers(FLAGS_thread_counts);
+  int ret = 0;
+  for (const BenchCase& c : cases) {
+    for (uint32_t threads : thread_counts) {
+      ErrorStack result = run_case(c, threads, json_file.is_open() ? &json_file : nullptr);
+      if (result.is_error()) {
+        std::cerr << c.name() << " threads=" << threads << " failed: " << result << std::endl;
+        ret = 1;
+      }
+    }
+  }
+  return ret;
+}
+
+}  // namespace storage
+}  // namespace foedus
+
+int main(int argc, char **argv) {
+  return foedus::storage::main_impl(argc, argv);
+}
@@ -19,11 +19,13 @@
 
 #include <glog/logging.h>
 
+#include <memory>
 #include <string>
 
 #include "foedus/assert_nd.hpp"
 #include "foedus/engine_options.hpp"
 #include "foedus/assorted/endianness.hpp"
+#include "foedus/debugging/open_loop.hpp"
 #include "foedus/debugging/rdtsc.hpp"
 #include "foedus/debugging/stop_watch.hpp"
 #include "foedus/memory/numa_core_memory.hpp"
@@ -107,40 +109,82 @@ ErrorStack TpccClientTask::run_impl(thread::Thread* context) {
   previous_timestring_update_ = debugging::get_rdtsc();
   xct::XctManager* xct_manager = context->get_engine()->get_xct_manager();
 
+  // In open-loop mode, transactions start on a schedule independent from their latencies
+  const bool open_loop = arrival_rate_ > 0;
+  std::unique_ptr<debugging::ArrivalSchedule> schedule;
+  std::unique_ptr<debugging::DurableLatencyRecorder> recorder;
+  for (uint16_t i = 0; i < kXctTypeCount; ++i) {
+    outputs_->latencies_[i].clear();
+  }
+  if (open_loop) {
+    schedule.reset(
+      new debugging::ArrivalSchedule(arrival_type_, arrival_rate_, kRandomSeed + worker_id_));
+    recorder.reset(new debugging::DurableLatencyRecorder(engine_, outputs_->latencies_));
+  }
+
   channel_->start_rendezvous_.wait();
   LOG(INFO) << "TPCC Client-" << worker_id_ << " started working! home wid="
     << from_wid_ << "-" << to_wid_;
 
   context->reset_snapshot_cache_counts();
+  if (open_loop) {
+    schedule->start(debugging::get_monotonic_nanoseconds());
+  }
 
   while (!is_stop_requested()) {
+    uint64_t intended_start = 0;
+    if (open_loop) {
+      intended_start = schedule->pop_arrival();
+      recorder->wait_until(intended_start, &channel_->stop_flag_);
+    }
     Wid wid = from_wid_;  // home WID. some transaction randomly uses remote WID.
     uint16_t transaction_type = rnd_.uniform_within(1, 100);
     // remember the random seed to repeat the same transaction on abort/retry.
     uint64_t rnd_seed = rnd_.get_current_seed();
+    XctType xct_type;
+    if (transaction_type <= kXctNewOrderPercent) {
+      xct_type = kNewOrder;
+    } else if (transaction_type <= kXctPaymentPercent) {
+      xct_type = kPayment;
+    } else if (transaction_type <= kXctOrderStatusPercent) {
+      xct_type = kOrderStatus;
+    } else if (transaction_type <= kXctDelieveryPercent) {
+      xct_type = kDelivery;
+    } else {
+      xct_type = kStockLevel;
+    }
 
     // abort-retry loop
+    bool finished = false;
     while (!is_stop_requested()) {
       rnd_.set_current_seed(rnd_seed);
       update_timestring_if_needed();
       xct::IsolationLevel isolation
         = dirty_read_mode_ ? xct::kDirtyRead : xct::kSerializable;
       WRAP_ERROR_CODE(xct_manager->begin_xct(context, isolation));
+      commit_epoch_ = Epoch();
       ErrorCode ret;
-      if (transaction_type <= kXctNewOrderPercent) {
+      switch (xct_type) {
+      case kNewOrder:
         ret = do_neworder(wid);
-      } else if (transaction_type <= kXctPaymentPercent) {
+        break;
+      case kPayment:
         ret = do_payment(wid);
-      } else if (transaction_type <= kXctOrderStatusPercent) {
+        break;
+      case kOrderStatus:
         ret = do_order_status(wid);
-      } else if (transaction_type <= kXctDelieveryPercent) {
+        break;
+      case kDelivery:
         ret = do_delivery(wid);
-      } else {
+        break;
+      default:
         ret = do_stock_level(wid);
+        break;
       }
 
       if (ret == kErrorCodeOk) {
         ASSERT_ND(!context->is_running_xct());
+        finished = true;
         break;
       }
 
@@ -153,6 +197,8 @@ ErrorStack TpccClientTask::run_impl(thread::Thread* context) {
       if (ret == kErrorCodeXctUserAbort) {
         // Fine. This is as defined in the spec.
         increment_user_requested_aborts();
+        commit_epoch_ = Epoch();
+        finished = true;
         break;
       } else if (ret == kErrorCodeXctRaceAbort) {
         increment_race_aborts();
@@ -185,6 +231,9 @@ ErrorStack TpccClientTask::run_impl(thread::Thread* context) {
       }
     }
 
+    if (open_loop && finished) {
+      recorder->on_commit(xct_type, intended_start, commit_epoch_);
+    }
     ++outputs_->processed_;
     if (UNLIKELY(outputs_->processed_ % (1U << 8) == 0)) {  // it's just stats. not too frequent
       outputs_->snapshot_cache_hits_ = context->get_snapshot_cache_hits();
@@ -93,8 +93,7 @@ ErrorCode TpccClientTask::do_delivery(Wid wid) {
 
     DVLOG(2) << "Delivery: updated: oid=" << oid << ", #ol=" << ol_count;
   }
-  Epoch ep;
-  return engine_->get_xct_manager()->precommit_xct(context_, &ep);
+  return engine_->get_xct_manager()->precommit_xct(context_, &commit_epoch_);
 }
 
 ErrorCode TpccClientTask::pop_neworder(Wid wid, Did did, Oid* oid) {
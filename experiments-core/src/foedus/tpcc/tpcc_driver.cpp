@@ -25,6 +25,7 @@
 #include <sys/wait.h>
 
 #include <algorithm>
+#include <fstream>
 #include <iostream>
 #include <string>
 #include <thread>
@@ -34,6 +35,8 @@
 #include "foedus/engine_options.hpp"
 #include "foedus/error_stack.hpp"
 #include "foedus/debugging/debugging_supports.hpp"
+#include "foedus/debugging/latency_histogram.hpp"
+#include "foedus/debugging/open_loop.hpp"
 #include "foedus/debugging/stop_watch.hpp"
 #include "foedus/fs/filesystem.hpp"
 #include "foedus/log/log_manager.hpp"
@@ -102,6 +105,14 @@ DEFINE_int32(hcc_policy, 1, "Specifies configurations about HCC/MOCC."
 );
 
 DEFINE_bool(suppress_memory_prescreen, false, "Whether to turn off environment check.");
+DEFINE_double(open_loop_rate, 0, "Total transactions per second issued in open-loop mode,"
+  " divided evenly to worker threads. Latencies are measured from the intended start time"
+  " to the durable commit. 0 (default) runs the usual closed-loop mode.");
+DEFINE_string(open_loop_arrival, "poisson", "Arrivals in open-loop mode: poisson or fixed.");
+DEFINE_bool(repair, false, "Whether neworder repairs its stock updates at precommit when"
+  " another transaction has concurrently updated the stock, instead of aborting.");
+DEFINE_string(latency_json, "", "Path of a file to write per-second latency histograms to,"
+  " one JSON object per line. Only in open-loop mode. Empty (default) writes no file.");
 
 
 #ifdef OLAP_MODE
@@ -109,6 +120,41 @@ DEFINE_bool(dirty_read, false, "[Experimental] Whether to use dirty-read isolati
   " Can be used only in OLAP_MODE.");
 #endif  // OLAP_MODE
 
+/** Names of TpccClientTask::XctType in JSON outputs */
+const char* const kXctTypeNames[] = {
+  "neworder",
+  "payment",
+  "order_status",
+  "delivery",
+  "stock_level",
+};
+
+void write_latency_json(
+  std::ostream* o,
+  double elapsed_sec,
+  const debugging::LatencyHistogram* histograms) {
+  *o << "{\"elapsed_sec\":" << elapsed_sec << ",\"xcts\":{";
+  for (uint16_t i = 0; i < TpccClientTask::kXctTypeCount; ++i) {
+    if (i > 0) {
+      *o << ",";
+    }
+    *o << "\"" << kXctTypeNames[i] << "\":";
+    histograms[i].write_json(o);
+  }
+  *o << "}}" << std::endl;
+}
+
+void sum_latencies(
+  const std::vector< const TpccClientTask::Outputs* >& outputs,
+  std::vector< debugging::LatencyHistogram >* out) {
+  for (uint16_t i = 0; i < TpccClientTask::kXctTypeCount; ++i) {
+    (*out)[i].clear();
+    for (const TpccClientTask::Outputs* output : outputs) {
+      (*out)[i].merge(output->latencies_[i]);
+    }
+  }
+}
+
 TpccDriver::Result TpccDriver::run() {
   const EngineOptions& options = engine_->get_options();
   LOG(INFO) << engine_->get_memory_manager()->dump_free_memory_stat();
@@ -279,6 +325,19 @@ TpccDriver::Result TpccDriver::run() {
   std::vector< thread::ImpersonateSession > sessions;
   std::vector< const TpccClientTask::Outputs* > outputs;
 
+  const bool open_loop = FLAGS_open_loop_rate > 0;
+  const double arrival_rate = FLAGS_open_loop_rate / options.thread_.get_total_thread_count();
+  debugging::ArrivalSchedule::Type arrival_type = debugging::ArrivalSchedule::kPoisson;
+  if (FLAGS_open_loop_arrival == "fixed") {
+    arrival_type = debugging::ArrivalSchedule::kFixed;
+  } else if (FLAGS_open_loop_arrival != "poisson") {
+    LOG(FATAL) << "Unknown open_loop_arrival:" << FLAGS_open_loop_arrival;
+  }
+  if (open_loop) {
+    LOG(INFO) << "Open-loop mode: " << FLAGS_open_loop_rate << " xct/sec in total, "
+      << arrival_rate << " xct/sec per thread, arrival=" << FLAGS_open_loop_arrival;
+  }
+
   for (uint16_t node = 0; node < options.thread_.group_count_; ++node) {
     for (uint16_t ordinal = 0; ordinal < options.thread_.thread_count_per_group_; ++ordinal) {
       uint16_t global_ordinal = options.thread_.thread_count_per_group_ * node + ordinal;
@@ -289,6 +348,9 @@ TpccDriver::Result TpccDriver::run() {
       inputs.to_wid_ = to_wids_[global_ordinal];
       inputs.neworder_remote_percent_ = FLAGS_neworder_remote_percent;
       inputs.payment_remote_percent_ = FLAGS_payment_remote_percent;
+      inputs.arrival_rate_ = open_loop ? arrival_rate : 0;
+      inputs.arrival_type_ = arrival_type;
+      inputs.repair_mode_ = FLAGS_repair;
 #ifndef OLAP_MODE  // see cmake script for tpcc_olap
       inputs.olap_mode_ = false;
       inputs.dirty_read_mode_ = false;
@@ -332,6 +394,15 @@ TpccDriver::Result TpccDriver::run() {
   channel->start_rendezvous_.signal();
   assorted::memory_fence_release();
   LOG(INFO) << "Started!";
+  std::ofstream latency_json;
+  if (open_loop && !FLAGS_latency_json.empty()) {
+    latency_json.open(FLAGS_latency_json.c_str(), std::ios::out | std::ios::trunc);
+    if (!latency_json) {
+      LOG(FATAL) << "Couldn't open " << FLAGS_latency_json;
+    }
+  }
+  std::vector< debugging::LatencyHistogram > latencies(TpccClientTask::kXctTypeCount);
+  std::vector< debugging::LatencyHistogram > previous_latencies(TpccClientTask::kXctTypeCount);
   debugging::StopWatch duration;
   while (duration.peek_elapsed_ns() < static_cast<uint64_t>(FLAGS_duration_micro) * 1000ULL) {
     // wake up for each second to show intermediate results.
@@ -353,6 +424,16 @@ TpccDriver::Result TpccDriver::run() {
     }
     LOG(INFO) << "Intermediate report after " << result.duration_sec_ << " sec";
     LOG(INFO) << result;
+    if (latency_json.is_open()) {
+      // histograms of this interval only
+      sum_latencies(outputs, &latencies);
+      std::vector< debugging::LatencyHistogram > interval(latencies);
+      for (uint16_t i = 0; i < TpccClientTask::kXctTypeCount; ++i) {
+        interval[i].subtract(previous_latencies[i]);
+      }
+      write_latency_json(&latency_json, result.duration_sec_, &interval[0]);
+      previous_latencies.swap(latencies);
+    }
     LOG(INFO) << engine_->get_memory_manager()->dump_free_memory_stat();
   }
   LOG(INFO) << "Experiment ended.";
@@ -389,6 +470,17 @@ TpccDriver::Result TpccDriver::run() {
     result.snapshot_cache_hits_ += output->snapshot_cache_hits_;
     result.snapshot_cache_misses_ += output->snapshot_cache_misses_;
   }
+  if (open_loop) {
+    sum_latencies(outputs, &latencies);
+    for (uint16_t i = 0; i < TpccClientTask::kXctTypeCount; ++i) {
+      LOG(INFO) << "Latencies of " << kXctTypeNames[i] << ": " << latencies[i];
+    }
+    if (latency_json.is_open()) {
+      // the last line is the histograms of the entire run
+      write_latency_json(&latency_json, result.duration_sec_, &latencies[0]);
+      latency_json.close();
+    }
+  }
   LOG(INFO) << "Shutting down...";
 
   // output the current memory state at the end
@@ -22,11 +22,15 @@
 
 #include <string>
 
+#include "foedus/assert_nd.hpp"
 #include "foedus/compiler.hpp"
 #include "foedus/engine.hpp"
 #include "foedus/assorted/cacheline.hpp"
+#include "foedus/storage/array/array_log_types.hpp"
 #include "foedus/storage/array/array_storage.hpp"
 #include "foedus/storage/masstree/masstree_storage.hpp"
+#include "foedus/thread/thread.hpp"
+#include "foedus/xct/xct.hpp"
 #include "foedus/xct/xct_manager.hpp"
 
 namespace foedus {
@@ -45,6 +49,38 @@ namespace tpcc {
   }\
 }
 
+inline uint32_t compute_new_stock_quantity(uint32_t current, uint32_t ordered) {
+  if (current > ordered) {
+    return current - ordered;
+  } else {
+    return current + (91U - ordered);
+  }
+}
+
+inline void overwrite_logged_uint32(log::RecordLogType* log_entry, uint32_t value) {
+  auto* casted = reinterpret_cast<storage::array::ArrayOverwriteLogType*>(log_entry);
+  ASSERT_ND(casted->payload_count_ == sizeof(uint32_t));
+  std::memcpy(casted->payload_, &value, sizeof(value));
+}
+
+ErrorCode StockQuantityRepair::repair(
+  thread::Thread* /*context*/,
+  const char* payload,
+  log::RecordLogType* log_entry) {
+  const StockData* s_data = reinterpret_cast<const StockData*>(payload);
+  overwrite_logged_uint32(log_entry, compute_new_stock_quantity(s_data->quantity_, ordered_));
+  return kErrorCodeOk;
+}
+
+ErrorCode StockRemoteRepair::repair(
+  thread::Thread* /*context*/,
+  const char* payload,
+  log::RecordLogType* log_entry) {
+  const StockData* s_data = reinterpret_cast<const StockData*>(payload);
+  overwrite_logged_uint32(log_entry, s_data->remote_cnt_ + 1U);
+  return kErrorCodeOk;
+}
+
 ErrorCode TpccClientTask::do_neworder(Wid wid) {
   const Did did = get_random_district_id();
   const Wdid wdid = combine_wdid(wid, did);
@@ -130,8 +166,7 @@ ErrorCode TpccClientTask::do_neworder(Wid wid) {
     << "." << std::string(output_item_names_[0], sizeof(output_item_names_[0]))
     << ".$" << output_prices_[0]
     << "*" << output_quantities_[0] << "." << output_amounts_[0];
-  Epoch ep;
-  return engine_->get_xct_manager()->precommit_xct(context_, &ep);
+  return engine_->get_xct_manager()->precommit_xct(context_, &commit_epoch_);
 }
 
 const char* kOriginalStr = "original";
@@ -213,12 +248,7 @@ ErrorCode TpccClientTask::do_neworder_create_orderlines(
     const ItemData* i_data = reinterpret_cast<const ItemData*>(i_data_address[ol - 1]);
     const StockData* s_data = reinterpret_cast<const StockData*>(s_records[ol - 1]->payload_);
     uint32_t quantity = quantities[ol - 1];
-    uint32_t new_quantity = s_data->quantity_;
-    if (new_quantity > quantity) {
-        new_quantity -= quantity;
-    } else {
-        new_quantity += (91U - quantity);
-    }
+    uint32_t new_quantity = compute_new_stock_quantity(s_data->quantity_, quantity);
 
     Wid supply_wid = extract_wid_from_sid(sids[ol - 1]);
     if (supply_wid != wid) {
@@ -229,6 +259,10 @@ ErrorCode TpccClientTask::do_neworder_create_orderlines(
         s_records[ol - 1],
         s_data->remote_cnt_ + 1,
         s_remote_offset));
+      if (repair_mode_) {
+        CHECK_ERROR_CODE(context_->get_current_xct().set_repair_functor(
+          stock_remote_repairs_ + ol - 1));
+      }
     }
     // overwrite quantity
     CHECK_ERROR_CODE(storages_.stocks_.overwrite_record_primitive<uint32_t>(
@@ -237,6 +271,11 @@ ErrorCode TpccClientTask::do_neworder_create_orderlines(
       s_records[ol - 1],
       new_quantity,
       s_quantity_offset));
+    if (repair_mode_) {
+      stock_quantity_repairs_[ol - 1].ordered_ = quantity;
+      CHECK_ERROR_CODE(context_->get_current_xct().set_repair_functor(
+        stock_quantity_repairs_ + ol - 1));
+    }
 
     OrderlineData ol_data;
     ol_data.amount_ = quantity * i_data->price_ * (1.0 + w_tax + d_tax) * (1.0 - c_discount);
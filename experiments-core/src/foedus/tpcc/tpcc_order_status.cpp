@@ -31,11 +31,11 @@ ErrorCode TpccClientTask::do_order_status(Wid wid) {
   const Did did = get_random_district_id();
 
   Cid cid;
-  Epoch ep;
   ErrorCode ret_customer = lookup_customer_by_id_or_name(wid, did, &cid);
   if (ret_customer == kErrorCodeStrKeyNotFound) {
     DVLOG(1) << "OrderStatus: customer of random last name not found";
-    return engine_->get_xct_manager()->precommit_xct(context_, &ep);  // this is a correct result
+    // this is a correct result
+    return engine_->get_xct_manager()->precommit_xct(context_, &commit_epoch_);
   } else if (ret_customer != kErrorCodeOk) {
     return ret_customer;
   }
@@ -45,7 +45,8 @@ ErrorCode TpccClientTask::do_order_status(Wid wid) {
   ErrorCode ret = get_last_orderid_by_customer(wid, did, cid, &oid);
   if (ret == kErrorCodeStrKeyNotFound) {
     DVLOG(1) << "OrderStatus: no order";
-    return engine_->get_xct_manager()->precommit_xct(context_, &ep);  // this is a correct result
+    // this is a correct result
+    return engine_->get_xct_manager()->precommit_xct(context_, &commit_epoch_);
   } else if (ret != kErrorCodeOk) {
     return ret;
   }
@@ -78,7 +79,7 @@ ErrorCode TpccClientTask::do_order_status(Wid wid) {
 
   DVLOG(2) << "Order-status:" << cnt << " records. wid=" << wid
     << ", did=" << did << ", cid=" << cid << ", oid=" << oid << std::endl;
-  return engine_->get_xct_manager()->precommit_xct(context_, &ep);
+  return engine_->get_xct_manager()->precommit_xct(context_, &commit_epoch_);
 }
 
 ErrorCode TpccClientTask::get_last_orderid_by_customer(Wid wid, Did did, Cid cid, Oid* oid) {
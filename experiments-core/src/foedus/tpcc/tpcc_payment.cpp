@@ -173,8 +173,7 @@ ErrorCode TpccClientTask::do_payment(Wid c_wid) {
   DVLOG(2) << "Payment: wid=" << wid << ", did=" << static_cast<int>(did)
     << ", cid=" << cid << ", c_wid=" << c_wid << ", c_did=" << static_cast<int>(c_did)
     << ", time=" << timestring_.str();
-  Epoch ep;
-  return engine_->get_xct_manager()->precommit_xct(context_, &ep);
+  return engine_->get_xct_manager()->precommit_xct(context_, &commit_epoch_);
 }
 
 
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include "foedus/tpce/tpce_client.hpp"
+
+#include <algorithm>
+#include <cstddef>
+
+#include "foedus/engine.hpp"
+#include "foedus/storage/masstree/masstree_cursor.hpp"
+#include "foedus/storage/masstree/masstree_storage.hpp"
+#include "foedus/xct/xct_manager.hpp"
+
+namespace foedus {
+namespace tpce {
+
+ErrorCode TpceClientTask::do_broker_volume() {
+  auto trade_requests = storages_.trade_requests_;
+  auto brokers = storages_.brokers_;
+
+  // Frame-1
+  // Inputs are 20 to 40 broker names and a sector name. We use IDs for both.
+  const uint32_t kMaxBrokers = 40;
+  const uint64_t broker_count = scale_.get_broker_cardinality();
+  const uint32_t in_broker_count = std::min<uint64_t>(
+    rnd_.uniform_within(20, kMaxBrokers),
+    broker_count);
+  IdentT in_brokers[kMaxBrokers];
+  ValueT volumes[kMaxBrokers];
+  for (uint32_t i = 0; i < in_broker_count; ++i) {
+    // Consecutive IDs from a random position. They are distinct.
+    in_brokers[i] = (rnd_.next_uint64() % broker_count + i) % broker_count;
+    volumes[i] = 0;
+    BrokerData broker;
+    CHECK_ERROR_CODE(brokers.get_record(context_, in_brokers[i], &broker));
+  }
+  const uint16_t in_sector = rnd_.uniform_within(0, kSectors - 1U);
+
+  // Join TRADE_REQUEST, SECURITY, COMPANY, INDUSTRY, and SECTOR.
+  // TRADE_REQUEST only holds pending limit orders, but it might be still large.
+  // We bound the scan to keep the read set reasonable.
+  const uint32_t kMaxScannedRequests = 1024;
+  uint32_t scanned = 0;
+  storage::masstree::MasstreeCursor cursor(trade_requests, context_);
+  CHECK_ERROR_CODE(cursor.open_normalized(
+    storage::masstree::kInfimumSlice,
+    storage::masstree::kSupremumSlice));
+  while (cursor.is_valid_record() && scanned < kMaxScannedRequests) {
+    ++scanned;
+    ASSERT_ND(cursor.get_payload_length() == sizeof(TradeRequestData));
+    const TradeRequestData* request
+      = reinterpret_cast<const TradeRequestData*>(cursor.get_payload());
+    const IdentT* broker_pos = std::find(in_brokers, in_brokers + in_broker_count, request->b_id_);
+    if (broker_pos != in_brokers + in_broker_count) {
+      const SymbT symb_id = to_symb_from_trade_request_key(cursor.get_normalized_key());
+      IdentT co_id;
+      CHECK_ERROR_CODE(storages_.securities_.get_record_primitive<IdentT>(
+        context_,
+        symb_id,
+        &co_id,
+        offsetof(SecurityData, co_id_)));
+      uint16_t industry_id;
+      CHECK_ERROR_CODE(storages_.companies_.get_record_primitive<uint16_t>(
+        context_,
+        co_id,
+        &industry_id,
+        offsetof(CompanyData, industry_id_)));
+      if (to_sector_from_industry(industry_id) == in_sector) {
+        volumes[broker_pos - in_brokers]
+          += static_cast<ValueT>(request->qty_) * request->bid_price_;
+      }
+    }
+    CHECK_ERROR_CODE(cursor.next());
+  }
+
+  // ORDER BY volume DESC. The result is not used.
+  std::sort(volumes, volumes + in_broker_count);
+
+  Epoch ep;
+  return engine_->get_xct_manager()->precommit_xct(context_, &ep);
+}
+
+}  // namespace tpce
+}  // namespace foedus
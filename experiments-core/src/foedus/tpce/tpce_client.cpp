@@ -19,6 +19,7 @@
 
 #include <glog/logging.h>
 
+#include <cstring>
 #include <string>
 
 #include "foedus/assert_nd.hpp"
@@ -56,6 +57,76 @@ ErrorStack tpce_client_task(const proc::ProcArguments& args) {
 
 const uint32_t kMaxUnexpectedErrors = 1;
 
+const char* TpceClientTask::get_xct_type_name(XctType type) {
+  switch (type) {
+    case kBrokerVolume: return "broker_volume";
+    case kCustomerPosition: return "customer_position";
+    case kMarketFeed: return "market_feed";
+    case kMarketWatch: return "market_watch";
+    case kSecurityDetail: return "security_detail";
+    case kTradeLookup: return "trade_lookup";
+    case kTradeOrder: return "trade_order";
+    case kTradeResult: return "trade_result";
+    case kTradeStatus: return "trade_status";
+    case kTradeUpdate: return "trade_update";
+    default: return "unknown";
+  }
+}
+
+TpceClientTask::XctType TpceClientTask::choose_xct_type() {
+  if (legacy_mix_) {
+    const uint16_t kXctTradeOrderPercent = 80;
+    return rnd_.uniform_within(1, 100) <= kXctTradeOrderPercent ? kTradeOrder : kTradeUpdate;
+  }
+
+  // Clause 6.2.2.1 in permille. MarketFeed and TradeResult are triggered by the market
+  // in the spec, but we issue them from the mix at the spec's frequency.
+  const uint16_t kPermilles[kXctTypeCount] = {
+    49,   // kBrokerVolume
+    130,  // kCustomerPosition
+    10,   // kMarketFeed
+    180,  // kMarketWatch
+    140,  // kSecurityDetail
+    80,   // kTradeLookup
+    101,  // kTradeOrder
+    100,  // kTradeResult
+    190,  // kTradeStatus
+    20,   // kTradeUpdate
+  };
+  uint16_t dice = rnd_.uniform_within(1, 1000);
+  XctType type = kTradeUpdate;
+  for (uint16_t i = 0; i < kXctTypeCount; ++i) {
+    if (dice <= kPermilles[i]) {
+      type = static_cast<XctType>(i);
+      break;
+    }
+    dice -= kPermilles[i];
+  }
+
+  if (type == kTradeResult && submitted_trades_count_ == 0) {
+    // No trade is waiting for completion. Make one instead.
+    type = kTradeOrder;
+  }
+  return type;
+}
+
+ErrorCode TpceClientTask::run_xct(XctType type) {
+  switch (type) {
+    case kBrokerVolume: return do_broker_volume();
+    case kCustomerPosition: return do_customer_position();
+    case kMarketFeed: return do_market_feed();
+    case kMarketWatch: return do_market_watch();
+    case kSecurityDetail: return do_security_detail();
+    case kTradeLookup: return do_trade_lookup();
+    case kTradeOrder: return do_trade_order();
+    case kTradeResult: return do_trade_result();
+    case kTradeStatus: return do_trade_status();
+    default:
+      ASSERT_ND(type == kTradeUpdate);
+      return do_trade_update();
+  }
+}
+
 
 ErrorStack TpceClientTask::run(thread::Thread* context) {
   context_ = context;
@@ -76,6 +147,7 @@ ErrorStack TpceClientTask::run_impl(thread::Thread* context) {
   CHECK_ERROR(warmup(context));
 
   outputs_->processed_ = 0;
+  std::memset(outputs_->processed_per_type_, 0, sizeof(outputs_->processed_per_type_));
   outputs_->snapshot_cache_hits_ = 0;
   outputs_->snapshot_cache_misses_ = 0;
   xct::XctManager* xct_manager = context->get_engine()->get_xct_manager();
@@ -86,10 +158,15 @@ ErrorStack TpceClientTask::run_impl(thread::Thread* context) {
   context->reset_snapshot_cache_counts();
   init_in_partition_trade_counter();
   init_articifical_current_dts();
+  zipfian_symbol_.init(
+    scale_.get_security_cardinality(),
+    scale_.symbol_skew_,
+    kRandomSeed + worker_id_);
+  submitted_trades_head_ = 0;
+  submitted_trades_count_ = 0;
 
   while (!is_stop_requested()) {
-    uint16_t transaction_type = rnd_.uniform_within(1, 100);
-    const uint16_t kXctTradeOrderPercent = 80;
+    const XctType transaction_type = choose_xct_type();
     // remember the random seed to repeat the same transaction on abort/retry.
     uint64_t rnd_seed = rnd_.get_current_seed();
     uint64_t symbol_rnd_seed = zipfian_symbol_.get_current_seed();
@@ -99,12 +176,7 @@ ErrorStack TpceClientTask::run_impl(thread::Thread* context) {
       rnd_.set_current_seed(rnd_seed);
       zipfian_symbol_.set_current_seed(symbol_rnd_seed);
       WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
-      ErrorCode ret;
-      if (transaction_type <= kXctTradeOrderPercent) {
-        ret = do_trade_order();
-      } else {
-        ret = do_trade_update();
-      }
+      ErrorCode ret = run_xct(transaction_type);
 
       if (ret == kErrorCodeOk) {
         ASSERT_ND(!context->is_running_xct());
@@ -144,6 +216,7 @@ ErrorStack TpceClientTask::run_impl(thread::Thread* context) {
     }
 
     ++outputs_->processed_;
+    ++outputs_->processed_per_type_[transaction_type];
     if (UNLIKELY(outputs_->processed_ % (1U << 8) == 0)) {  // it's just stats. not too frequent
       outputs_->snapshot_cache_hits_ = context->get_snapshot_cache_hits();
       outputs_->snapshot_cache_misses_ = context->get_snapshot_cache_misses();
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include "foedus/tpce/tpce_client.hpp"
+
+#include <glog/logging.h>
+
+#include <cstddef>
+
+#include "foedus/engine.hpp"
+#include "foedus/storage/masstree/masstree_cursor.hpp"
+#include "foedus/storage/masstree/masstree_storage.hpp"
+#include "foedus/xct/xct_manager.hpp"
+
+namespace foedus {
+namespace tpce {
+
+ErrorCode TpceClientTask::do_customer_position() {
+  auto accounts = storages_.accounts_;
+  auto holding_summaries = storages_.holding_summaries_;
+  auto last_trades = storages_.last_trades_;
+
+  // Frame-1
+  // Input is a customer ID (or tax ID, but we don't have CUSTOMER table).
+  const IdentT cust_id = pick_customer();
+  ValueT cash_balances[kAccountsPerCustomer];
+  ValueT asset_totals[kAccountsPerCustomer];
+  for (IdentT ordinal = 0; ordinal < kAccountsPerCustomer; ++ordinal) {
+    const IdentT acct_id = to_ca(cust_id, ordinal);
+    CustomerAccountData account;
+    CHECK_ERROR_CODE(accounts.get_record(context_, acct_id, &account));
+    ASSERT_ND(account.c_id_ == cust_id);
+    cash_balances[ordinal] = account.bal_;
+    asset_totals[ordinal] = 0;
+
+    // SUM(HS_QTY * LT_PRICE) over HOLDING_SUMMARY of the account.
+    storage::masstree::MasstreeCursor cursor(holding_summaries, context_);
+    CHECK_ERROR_CODE(cursor.open_normalized(
+      to_holding_summary_key(acct_id, 0),
+      to_holding_summary_key(acct_id + 1U, 0)));
+    while (cursor.is_valid_record()) {
+      ASSERT_ND(cursor.get_payload_length() == sizeof(HoldingSummaryData));
+      const HoldingSummaryData* holding
+        = reinterpret_cast<const HoldingSummaryData*>(cursor.get_payload());
+      const SymbT symb_id = to_symb_from_holding_summary_key(cursor.get_normalized_key());
+      SPriceT price;
+      CHECK_ERROR_CODE(last_trades.get_record_primitive<SPriceT>(
+        context_,
+        symb_id,
+        &price,
+        offsetof(LastTradeData, price_)));
+      asset_totals[ordinal] += static_cast<ValueT>(holding->qty_) * price;
+      CHECK_ERROR_CODE(cursor.next());
+    }
+    DVLOG(3) << "acct_id=" << acct_id << ", cash_bal=" << cash_balances[ordinal]
+      << ", assets_total=" << asset_totals[ordinal];
+  }
+
+  // Frame-2
+  // Half of the time, the customer also asks the recent trades of one account.
+  if (rnd_.next_uint32() % 2U == 0) {
+    const IdentT acct_id = to_ca(cust_id, rnd_.next_uint32() % kAccountsPerCustomer);
+    const uint32_t kMaxTrades = 10;
+    TradeT tids[kMaxTrades];
+    uint32_t fetched_rows = 0;
+    // Latest first.
+    storage::masstree::MasstreeCursor cursor(storages_.trades_secondary_ca_dts_, context_);
+    CHECK_ERROR_CODE(cursor.open_normalized(
+      to_ca_dts_key(acct_id + 1U, 0, 0),
+      to_ca_dts_key(acct_id, 0, 0),
+      false,
+      false,
+      false,
+      true));
+    while (cursor.is_valid_record() && fetched_rows < kMaxTrades) {
+      ASSERT_ND(to_ca_from_ca_dts_key(cursor.get_normalized_key()) == acct_id);
+      ASSERT_ND(cursor.get_payload_length() == sizeof(TradeT));
+      tids[fetched_rows] = *reinterpret_cast<const TradeT*>(cursor.get_payload());
+      ++fetched_rows;
+      CHECK_ERROR_CODE(cursor.next());
+    }
+
+    // We don't have TRADE_HISTORY. We return the current status of the trades.
+    for (uint32_t i = 0; i < fetched_rows; ++i) {
+      TradeData trade;
+      uint16_t capacity = sizeof(trade);
+      CHECK_ERROR_CODE(storages_.trades_.get_record<TradeT>(
+        context_,
+        tids[i],
+        &trade,
+        &capacity,
+        true));
+      ASSERT_ND(trade.ca_id_ == acct_id);
+    }
+  }
+
+  Epoch ep;
+  return engine_->get_xct_manager()->precommit_xct(context_, &ep);
+}
+
+}  // namespace tpce
+}  // namespace foedus
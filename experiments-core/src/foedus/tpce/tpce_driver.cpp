@@ -91,6 +91,8 @@ DEFINE_int64(itd, 1, "The Initial Trade Days (ITD) is the number of Business Day
 DEFINE_double(symbol_skew, 0.25, "Skewness to pick a security symbol"
   " for both trade-order (insert) and other references."
   " 0 means uniform. Higher value causes higher skew, skewing to lower symbol IDs.");
+DEFINE_bool(legacy_mix, false, "Whether to run only TradeOrder (80%) and TradeUpdate (20%)"
+  " rather than the full transaction mix in the spec.");
 
 TpceDriver::Result TpceDriver::run() {
   const EngineOptions& options = engine_->get_options();
@@ -100,6 +102,7 @@ TpceDriver::Result TpceDriver::run() {
     static_cast<uint64_t>(FLAGS_customers),
     static_cast<uint64_t>(FLAGS_itd),
     FLAGS_symbol_skew,
+    get_current_datetime(),
   };
 
   if (scale_.get_security_cardinality() > kMaxSymbT) {
@@ -108,6 +111,12 @@ TpceDriver::Result TpceDriver::run() {
       << " security symbols";
     return Result();
   }
+  if (scale_.get_account_cardinality() >= kMaxCaT) {
+    LOG(ERROR) << "Too many customers. We so far assume less than " << kMaxCaT << " accounts,"
+      << " but " << scale_.customers_ << " yields " << scale_.get_account_cardinality()
+      << " accounts";
+    return Result();
+  }
 
   {
     // first, create empty tables. this is done in single thread
@@ -241,6 +250,7 @@ TpceDriver::Result TpceDriver::run() {
       TpceClientTask::Inputs inputs = {
         scale_,
         static_cast<PartitionT>(sessions.size()),
+        FLAGS_legacy_mix,
       };
       thread::ImpersonateSession session;
       bool ret = thread_pool->impersonate_on_numa_node(
@@ -290,6 +300,9 @@ TpceDriver::Result TpceDriver::run() {
     for (uint32_t i = 0; i < sessions.size(); ++i) {
       const TpceClientTask::Outputs* output = outputs[i];
       result.processed_ += output->processed_;
+      for (uint16_t type = 0; type < TpceClientTask::kXctTypeCount; ++type) {
+        result.processed_per_type_[type] += output->processed_per_type_[type];
+      }
       result.race_aborts_ += output->race_aborts_;
       result.unexpected_aborts_ += output->unexpected_aborts_;
       result.largereadset_aborts_ += output->largereadset_aborts_;
@@ -328,6 +341,9 @@ TpceDriver::Result TpceDriver::run() {
     result.workers_[i].snapshot_cache_hits_ = output->snapshot_cache_hits_;
     result.workers_[i].snapshot_cache_misses_ = output->snapshot_cache_misses_;
     result.processed_ += output->processed_;
+    for (uint16_t type = 0; type < TpceClientTask::kXctTypeCount; ++type) {
+      result.processed_per_type_[type] += output->processed_per_type_[type];
+    }
     result.race_aborts_ += output->race_aborts_;
     result.unexpected_aborts_ += output->unexpected_aborts_;
     result.largereadset_aborts_ += output->largereadset_aborts_;
@@ -532,8 +548,13 @@ std::ostream& operator<<(std::ostream& o, const TpceDriver::Result& v) {
     << "<duration_sec_>" << v.duration_sec_ << "</duration_sec_>"
     << "<worker_count_>" << v.worker_count_ << "</worker_count_>"
     << "<processed_>" << v.processed_ << "</processed_>"
-    << "<MTPS>" << ((v.processed_ / v.duration_sec_) / 1000000) << "</MTPS>"
-    << "<user_requested_aborts_>" << v.user_requested_aborts_ << "</user_requested_aborts_>"
+    << "<MTPS>" << ((v.processed_ / v.duration_sec_) / 1000000) << "</MTPS>";
+  for (uint16_t type = 0; type < TpceClientTask::kXctTypeCount; ++type) {
+    const char* name
+      = TpceClientTask::get_xct_type_name(static_cast<TpceClientTask::XctType>(type));
+    o << "<" << name << ">" << v.processed_per_type_[type] << "</" << name << ">";
+  }
+  o << "<user_requested_aborts_>" << v.user_requested_aborts_ << "</user_requested_aborts_>"
     << "<race_aborts_>" << v.race_aborts_ << "</race_aborts_>"
     << "<largereadset_aborts_>" << v.largereadset_aborts_ << "</largereadset_aborts_>"
     << "<unexpected_aborts_>" << v.unexpected_aborts_ << "</unexpected_aborts_>"
@@ -20,6 +20,7 @@
 #include <glog/logging.h>
 
 #include <algorithm>
+#include <cstdio>
 #include <cstring>
 #include <string>
 
@@ -113,6 +114,77 @@ ErrorStack create_all(Engine* engine, const TpceScale& scale) {
     sizeof(TradeTypeData),
     TradeTypeData::kCount));
 
+  CHECK_ERROR(create_masstree(
+    engine,
+    "trades_secondary_ca_dts",
+    true,
+    estimate_masstree_records(0, sizeof(CaDtsKey), sizeof(TradeT)) * 0.75,
+    0));
+
+  CHECK_ERROR(create_hash(
+    engine,
+    "settlements",
+    true,
+    trade_cardinality,
+    (storage::hash::kHashDataPageDataSize / sizeof(SettlementData)) * trade_fill_factor));
+
+  CHECK_ERROR(create_hash(
+    engine,
+    "cash_transactions",
+    true,
+    trade_cardinality,
+    (storage::hash::kHashDataPageDataSize / sizeof(CashTransactionData)) * trade_fill_factor));
+
+  // TRADE_REQUEST is a queue-like table. Inserted by TradeOrder, deleted by MarketFeed.
+  CHECK_ERROR(create_masstree(engine, "trade_requests", true, 0.5, 0));
+
+  CHECK_ERROR(create_array(
+    engine,
+    "brokers",
+    true,
+    sizeof(BrokerData),
+    scale.get_broker_cardinality()));
+
+  CHECK_ERROR(create_array(
+    engine,
+    "accounts",
+    true,
+    sizeof(CustomerAccountData),
+    scale.get_account_cardinality()));
+
+  CHECK_ERROR(create_masstree(
+    engine,
+    "holding_summaries",
+    true,
+    estimate_masstree_records(0, sizeof(HoldingSummaryKey), sizeof(HoldingSummaryData)) * 0.75,
+    0));
+
+  CHECK_ERROR(create_masstree(engine, "watch_items", true, 1.0, 0));
+
+  CHECK_ERROR(create_array(
+    engine,
+    "securities",
+    true,
+    sizeof(SecurityData),
+    scale.get_security_cardinality()));
+
+  CHECK_ERROR(create_array(
+    engine,
+    "companies",
+    true,
+    sizeof(CompanyData),
+    scale.get_company_cardinality()));
+
+  CHECK_ERROR(create_array(
+    engine,
+    "last_trades",
+    true,
+    sizeof(LastTradeData),
+    scale.get_security_cardinality()));
+
+  // DAILY_MARKET is read-only in our implementation. Fully packed.
+  CHECK_ERROR(create_masstree(engine, "daily_markets", true, 1.0, 0));
+
   watch.stop();
   LOG(INFO) << "Created TPC-E tables in " << watch.elapsed_sec() << "sec";
   return kRetOk;
@@ -207,7 +279,19 @@ ErrorStack TpceFinishupTask::run(thread::Thread* context) {
     // TASK(Hideaki) make verify() checks snapshot pages too.
     CHECK_ERROR(storages_.trades_.verify_single_thread(context));
     CHECK_ERROR(storages_.trades_secondary_symb_dts_.verify_single_thread(context));
+    CHECK_ERROR(storages_.trades_secondary_ca_dts_.verify_single_thread(context));
     CHECK_ERROR(storages_.trade_types_.verify_single_thread(context));
+    CHECK_ERROR(storages_.settlements_.verify_single_thread(context));
+    CHECK_ERROR(storages_.cash_transactions_.verify_single_thread(context));
+    CHECK_ERROR(storages_.trade_requests_.verify_single_thread(context));
+    CHECK_ERROR(storages_.brokers_.verify_single_thread(context));
+    CHECK_ERROR(storages_.accounts_.verify_single_thread(context));
+    CHECK_ERROR(storages_.holding_summaries_.verify_single_thread(context));
+    CHECK_ERROR(storages_.watch_items_.verify_single_thread(context));
+    CHECK_ERROR(storages_.securities_.verify_single_thread(context));
+    CHECK_ERROR(storages_.companies_.verify_single_thread(context));
+    CHECK_ERROR(storages_.last_trades_.verify_single_thread(context));
+    CHECK_ERROR(storages_.daily_markets_.verify_single_thread(context));
     WRAP_ERROR_CODE(engine->get_xct_manager()->abort_xct(context));
   }
 // #endif  // NDEBUG
@@ -228,12 +312,15 @@ ErrorStack TpceLoadTask::run(thread::Thread* context) {
   debugging::StopWatch watch;
   CHECK_ERROR(load_tables());
   watch.stop();
-  LOG(INFO) << "Loaded TPC-C tables in " << watch.elapsed_sec() << "sec";
+  LOG(INFO) << "Loaded TPC-E tables in " << watch.elapsed_sec() << "sec";
   return kRetOk;
 }
 
 ErrorStack TpceLoadTask::load_tables() {
   CHECK_ERROR(load_trade_types());
+  CHECK_ERROR(load_brokers());
+  CHECK_ERROR(load_market_tables());
+  CHECK_ERROR(load_customer_tables());
   CHECK_ERROR(load_trades());
   VLOG(0) << "Loaded tables:" << engine_->get_memory_manager()->dump_free_memory_stat();
   return kRetOk;
@@ -282,38 +369,241 @@ ErrorStack TpceLoadTask::load_trade_types_one_row(
   return kRetOk;
 }
 
+void TpceLoadTask::get_partition_range(uint64_t count, uint64_t* from, uint64_t* to) const {
+  const uint64_t per_partition = count / scale_.total_partitions_;
+  *from = per_partition * partition_id_;
+  *to = (partition_id_ + 1U == scale_.total_partitions_ ? count : *from + per_partition);
+}
+
+template <typename ROW_LOADER>
+ErrorStack TpceLoadTask::load_in_batches(
+  const char* table_name,
+  uint64_t from,
+  uint64_t to,
+  uint64_t batch_size,
+  ROW_LOADER row_loader) {
+  for (uint64_t batch_from = from; batch_from < to; batch_from += batch_size) {
+    const uint64_t batch_to = std::min<uint64_t>(batch_from + batch_size, to);
+    // Retry in case of race abort.
+    while (true) {
+      WRAP_ERROR_CODE(xct_manager_->begin_xct(context_, xct::kSerializable));
+      ErrorCode ret = kErrorCodeOk;
+      for (uint64_t i = batch_from; i < batch_to && ret == kErrorCodeOk; ++i) {
+        ret = row_loader(i);
+      }
+      if (ret == kErrorCodeOk) {
+        Epoch commit_epoch;
+        ret = xct_manager_->precommit_xct(context_, &commit_epoch);
+      } else if (context_->is_running_xct()) {
+        WRAP_ERROR_CODE(xct_manager_->abort_xct(context_));
+      }
+      if (ret == kErrorCodeXctRaceAbort) {
+        LOG(WARNING) << "oops, race abort during loading " << table_name << ". retry..";
+        continue;
+      }
+      WRAP_ERROR_CODE(ret);
+      break;
+    }
+  }
+  return kRetOk;
+}
+
+ErrorStack TpceLoadTask::load_brokers() {
+  uint64_t from, to;
+  get_partition_range(scale_.get_broker_cardinality(), &from, &to);
+  auto brokers = storages_.brokers_;
+  return load_in_batches("BROKER", from, to, kCommitBatch, [&](uint64_t i) {
+    BrokerData data;
+    zero_clear(&data);
+    data.id_ = i;
+    std::memcpy(data.st_id_, "ACTV", sizeof(data.st_id_));
+    std::snprintf(data.name_, sizeof(data.name_), "Broker-%u", static_cast<IdentT>(i));
+    return brokers.overwrite_record(context_, i, &data);
+  });
+}
+
+ErrorStack TpceLoadTask::load_market_tables() {
+  uint64_t from, to;
+  get_partition_range(scale_.get_company_cardinality(), &from, &to);
+  auto companies = storages_.companies_;
+  CHECK_ERROR(load_in_batches("COMPANY", from, to, kCommitBatch, [&](uint64_t i) {
+    CompanyData data;
+    zero_clear(&data);
+    data.id_ = i;
+    std::memcpy(data.st_id_, "ACTV", sizeof(data.st_id_));
+    std::snprintf(data.name_, sizeof(data.name_), "Company-%u", static_cast<IdentT>(i));
+    data.industry_id_ = rnd_.next_uint32() % kIndustries;
+    std::memcpy(data.sp_rate_, "AAA", 3);
+    std::memcpy(data.ceo_, "Jane Doe", 8);
+    std::memcpy(data.desc_, "A company in TPC-E.", 19);
+    data.open_date_ = scale_.load_dts_ - 3650U * kSecondsPerDay;
+    return companies.overwrite_record(context_, i, &data);
+  }));
+
+  // SECURITY, LAST_TRADE, and DAILY_MARKET are loaded per security.
+  get_partition_range(scale_.get_security_cardinality(), &from, &to);
+  const uint64_t company_count = scale_.get_company_cardinality();
+  const uint32_t from_day = scale_.get_daily_market_from_day();
+  auto securities = storages_.securities_;
+  auto last_trades = storages_.last_trades_;
+  auto daily_markets = storages_.daily_markets_;
+  return load_in_batches("SECURITY", from, to, kCommitBatch / kDailyMarketDays, [&](uint64_t i) {
+    const SPriceT price = 2000U + rnd_.next_uint32() % 1000U;
+    SecurityData security;
+    zero_clear(&security);
+    security.id_ = i;
+    std::memcpy(security.issue_, "COMMON", sizeof(security.issue_));
+    std::memcpy(security.st_id_, "ACTV", sizeof(security.st_id_));
+    std::snprintf(
+      security.name_,
+      sizeof(security.name_),
+      "Security-%u",
+      static_cast<SymbT>(i));
+    std::memcpy(security.ex_id_, "NYSE", 4);
+    security.co_id_ = i % company_count;
+    security.num_out_ = 1000000ULL + rnd_.next_uint32() % 1000000U;
+    security.start_date_ = scale_.load_dts_ - 3650U * kSecondsPerDay;
+    security.exch_date_ = security.start_date_;
+    security.pe_ = 1000U + rnd_.next_uint32() % 2000U;
+    security.high_52wk_ = price + price / 2U;
+    security.high_52wk_date_ = scale_.load_dts_ - 100U * kSecondsPerDay;
+    security.low_52wk_ = price / 2U;
+    security.low_52wk_date_ = scale_.load_dts_ - 200U * kSecondsPerDay;
+    security.dividend_ = rnd_.next_uint32() % 100U;
+    security.yield_ = rnd_.next_uint32() % 500U;
+    CHECK_ERROR_CODE(securities.overwrite_record(context_, i, &security));
+
+    LastTradeData last_trade;
+    last_trade.symb_id_ = i;
+    last_trade.dts_ = scale_.load_dts_;
+    last_trade.price_ = price;
+    last_trade.open_price_ = price;
+    last_trade.vol_ = 0;
+    CHECK_ERROR_CODE(last_trades.overwrite_record(context_, i, &last_trade));
+
+    for (uint32_t d = 0; d < kDailyMarketDays; ++d) {
+      DailyMarketData daily;
+      daily.day_ = from_day + d;
+      daily.symb_id_ = i;
+      daily.close_ = 2000U + rnd_.next_uint32() % 1000U;
+      daily.high_ = daily.close_ + rnd_.next_uint32() % 100U;
+      daily.low_ = daily.close_ - rnd_.next_uint32() % 100U;
+      daily.vol_ = rnd_.next_uint32() % 10000U;
+      CHECK_ERROR_CODE(daily_markets.insert_record_normalized(
+        context_,
+        to_daily_market_key(i, daily.day_),
+        &daily,
+        sizeof(daily)));
+    }
+    return kErrorCodeOk;
+  });
+}
+
+ErrorStack TpceLoadTask::load_customer_tables() {
+  uint64_t from, to;
+  get_partition_range(scale_.customers_, &from, &to);
+  const uint64_t security_count = scale_.get_security_cardinality();
+  const uint64_t broker_count = scale_.get_broker_cardinality();
+  auto accounts = storages_.accounts_;
+  auto holding_summaries = storages_.holding_summaries_;
+  auto watch_items = storages_.watch_items_;
+  return load_in_batches("CUSTOMER_ACCOUNT", from, to, kCommitBatch / 32U, [&](uint64_t c_id) {
+    for (IdentT ordinal = 0; ordinal < kAccountsPerCustomer; ++ordinal) {
+      const IdentT ca = to_ca(c_id, ordinal);
+      CustomerAccountData account;
+      zero_clear(&account);
+      account.id_ = ca;
+      account.b_id_ = ca % broker_count;
+      account.c_id_ = c_id;
+      std::snprintf(account.name_, sizeof(account.name_), "Account-%u", ca);
+      account.tax_st_ = rnd_.next_uint32() % 3U;
+      account.bal_ = 1000000;
+      CHECK_ERROR_CODE(accounts.overwrite_record(context_, ca, &account));
+
+      // Spread the holdings over securities. Distinct unless there are too few securities.
+      const uint64_t stride = std::max<uint64_t>(security_count / kHoldingsPerAccount, 1U);
+      for (uint32_t h = 0; h < kHoldingsPerAccount; ++h) {
+        const SymbT symb_id = (ca * 7919ULL + h * stride) % security_count;
+        HoldingSummaryData holding;
+        holding.qty_ = 100 + rnd_.next_uint32() % 900U;
+        ErrorCode ret = holding_summaries.insert_record_normalized(
+          context_,
+          to_holding_summary_key(ca, symb_id),
+          &holding,
+          sizeof(holding));
+        if (ret != kErrorCodeStrKeyAlreadyExists) {
+          CHECK_ERROR_CODE(ret);
+        }
+      }
+    }
+
+    const uint64_t stride = std::max<uint64_t>(security_count / kWatchItemsPerCustomer, 1U);
+    for (uint32_t w = 0; w < kWatchItemsPerCustomer; ++w) {
+      const SymbT symb_id = (c_id * 104729ULL + w * stride) % security_count;
+      ErrorCode ret = watch_items.insert_record_normalized(
+        context_,
+        to_watch_item_key(c_id, symb_id));
+      if (ret != kErrorCodeStrKeyAlreadyExists) {
+        CHECK_ERROR_CODE(ret);
+      }
+    }
+    return kErrorCodeOk;
+  });
+}
+
+/** Used to sort secondary index entries of TRADE before inserting them. */
+struct SecondaryKeyValue {
+  uint64_t key_;
+  TradeT value_;
+  bool operator<(const SecondaryKeyValue& rhs) const { return key_ < rhs.key_; }
+};
+
+ErrorStack TpceLoadTask::load_secondary_index(
+  storage::masstree::MasstreeStorage index,
+  SecondaryKeyValue* sorted_array,
+  uint64_t count) {
+  debugging::StopWatch index_watch;
+  // Batch insert them. These key/values are small.
+  const uint64_t kSecondaryBatchSize = 128;
+  CHECK_ERROR(load_in_batches(
+    index.get_name().str().c_str(),
+    0,
+    count,
+    kSecondaryBatchSize,
+    [&](uint64_t i) {
+      const SecondaryKeyValue& kv = sorted_array[i];
+      ASSERT_ND(get_partition_id_from_trade_id(scale_, kv.value_) == partition_id_);
+      return index.insert_record_normalized(context_, kv.key_, &kv.value_, sizeof(kv.value_));
+    }));
+  index_watch.stop();
+  LOG(INFO) << "Data Loader-" << partition_id_ << " inserted to " << index.get_name() << " in "
+    << index_watch.elapsed_sec() << " sec.";
+  return kRetOk;
+}
+
 ErrorStack TpceLoadTask::load_trades() {
   LOG(INFO) << "Loading TRADE for partition=" << partition_id_;
-  Epoch ep;
   auto trades = storages_.trades_;
-  auto symb_dts_index = storages_.trades_secondary_symb_dts_;
+  auto settlements = storages_.settlements_;
+  auto cash_transactions = storages_.cash_transactions_;
 
   // This partition loads initial trade records for the following customers.
   // This doesn't mean transactions on workers are naturally
   // partitioned by customer. They are random and touch all customers.
-  const IdentT customers_per_pertition = scale_.customers_ / scale_.total_partitions_;
-  const IdentT customer_from = customers_per_pertition * partition_id_;
-  const IdentT customer_to =
-    (partition_id_ + 1U == scale_.total_partitions_
-      ? scale_.customers_
-      : customer_from + customers_per_pertition);
+  uint64_t customer_from, customer_to;
+  get_partition_range(scale_.customers_, &customer_from, &customer_to);
   const IdentT customer_count = customer_to - customer_from;
 
   // const SymbT max_symb_id = scale_.get_security_cardinality();
-  const Datetime dts_to = get_current_datetime();
+  const Datetime dts_to = scale_.load_dts_;
   const uint64_t in_partition_count
     = scale_.calculate_initial_trade_cardinality() / scale_.total_partitions_;
   ASSERT_ND(in_partition_count > 0);
 
-  // For faster data loading, we sort secondary key in a thread-private array
+  // For faster data loading, we sort secondary keys in thread-private arrays
   // then insert. We might want to consider batching, but not mandatory.
-  struct SecondaryKeyValue {
-    SymbDtsKey key_;
-    TradeT value_;
-    bool operator<(const SecondaryKeyValue& rhs) const { return key_ < rhs.key_; }
-  };
   memory::AlignedMemory secondary_buffer;
-  const uint64_t secondary_size = sizeof(SecondaryKeyValue) * in_partition_count;
+  const uint64_t secondary_size = sizeof(SecondaryKeyValue) * in_partition_count * 2U;
   LOG(INFO) << "Data Loader-" << partition_id_ << " allocating "
     << (secondary_size / 1000000.0) << " MBs for private sort buffer...";
   secondary_buffer.alloc_onnode(secondary_size, 1U << 21, context_->get_numa_node());
@@ -321,8 +611,9 @@ ErrorStack TpceLoadTask::load_trades() {
     return ERROR_STACK_MSG(kErrorCodeOutofmemory, "We need more hugepages for secondary buffer.");
   }
 
-  SecondaryKeyValue* secondary_array
+  SecondaryKeyValue* symb_dts_array
     = reinterpret_cast<SecondaryKeyValue*>(secondary_buffer.get_block());
+  SecondaryKeyValue* ca_dts_array = symb_dts_array + in_partition_count;
   assorted::ZipfianRandom symbol_rnd(
     scale_.get_security_cardinality(),
     scale_.symbol_skew_,
@@ -346,17 +637,20 @@ ErrorStack TpceLoadTask::load_trades() {
     for (uint64_t i = batch_from; i < batch_to; ++i) {
       const Datetime dts = dts_to - in_partition_count + i;
       const IdentT cid = (rnd_.next_uint32() % customer_count) + customer_from;
-      const IdentT ordinal = 0;  // always use the first account of the customer
+      const IdentT ordinal = rnd_.next_uint32() % kAccountsPerCustomer;
       const IdentT ca = to_ca(cid, ordinal);
       const SymbT symb_id = symbol_rnd.next();
       const SymbDtsKey secondary_key = to_symb_dts_key(symb_id, dts, partition_id_);
       const TradeT tid = get_new_trade_id(scale_, partition_id_, i);
       DVLOG(3) << "tid=" << tid << ", secondary_key=" << secondary_key;
-      secondary_array[i].key_ = secondary_key;
-      secondary_array[i].value_ = tid;
+      symb_dts_array[i].key_ = secondary_key;
+      symb_dts_array[i].value_ = tid;
+      ca_dts_array[i].key_ = to_ca_dts_key(ca, dts, partition_id_);
+      ca_dts_array[i].value_ = tid;
       ASSERT_ND(to_symb_from_symb_dts_key(secondary_key) == symb_id);
       ASSERT_ND(to_dts_from_symb_dts_key(secondary_key) == dts);
       ASSERT_ND(to_uniquefier_from_symb_dts_key(secondary_key) == partition_id_);
+      ASSERT_ND(to_ca_from_ca_dts_key(ca_dts_array[i].key_) == ca);
 
       // Load the trades and symb_dts_index.
       TradeData& record = primary_array[i - batch_from];
@@ -369,13 +663,14 @@ ErrorStack TpceLoadTask::load_trades() {
       record.ca_id_ = ca;
       record.tax_ = 0;
       record.lifo_ = false;
-      record.trade_price_ = 0;
 
       // Followings should be also random, but we hard code them for now.
-      std::memcpy(record.st_id_, "ACTV", sizeof(record.st_id_));
-      record.is_cash_ = true;
+      // Initial trades are all completed.
+      std::memcpy(record.st_id_, kStatusCompleted, sizeof(record.st_id_));
+      record.is_cash_ = (rnd_.next_uint32() % 100U) < 92U;
       record.qty_ = 10;
       record.bid_price_ = 10000;
+      record.trade_price_ = record.bid_price_;
       std::memcpy(
         record.exec_name_,
         "01234567890123456789012345678901234567890123456789",
@@ -384,37 +679,35 @@ ErrorStack TpceLoadTask::load_trades() {
       record.chrg_ = 100;
     }
 
-    // Retry in case of race abort.
-    while (true) {
-      WRAP_ERROR_CODE(xct_manager_->begin_xct(context_, xct::kSerializable));
-
-      bool has_error = false;
-      for (uint64_t i = batch_from; i < batch_to; ++i) {
-        const TradeData& record = primary_array[i - batch_from];
-        ErrorCode ret = trades.insert_record<TradeT>(context_, record.id_, &record, sizeof(record));
-        if (ret == kErrorCodeXctRaceAbort) {
-          LOG(WARNING) << "oops, race abort during load 1. retry..";
-          has_error = true;
-          if (context_->is_running_xct()) {
-            WRAP_ERROR_CODE(xct_manager_->abort_xct(context_));
-          }
-          break;
-        }
-        WRAP_ERROR_CODE(ret);
-      }
-
-      if (has_error) {
-        continue;
-      }
-      Epoch commit_epoch;
-      ErrorCode ret = xct_manager_->precommit_xct(context_, &commit_epoch);
-      if (ret == kErrorCodeXctRaceAbort) {
-        LOG(WARNING) << "oops, race abort during load 3. retry..";
-        continue;
+    CHECK_ERROR(load_in_batches("TRADE", batch_from, batch_to, batch_to, [&](uint64_t i) {
+      const TradeData& record = primary_array[i - batch_from];
+      CHECK_ERROR_CODE(trades.insert_record<TradeT>(context_, record.id_, &record, sizeof(record)));
+      SettlementData settlement;
+      zero_clear(&settlement);
+      settlement.trade_id_ = record.id_;
+      settlement.set_cash_type(record.is_cash_);
+      settlement.due_date_ = record.dts_ + 2U * kSecondsPerDay;
+      settlement.amt_ = static_cast<ValueT>(record.qty_) * record.trade_price_ - record.chrg_;
+      CHECK_ERROR_CODE(settlements.insert_record<TradeT>(
+        context_,
+        record.id_,
+        &settlement,
+        sizeof(settlement)));
+      if (record.is_cash_) {
+        CashTransactionData cash;
+        zero_clear(&cash);
+        cash.trade_id_ = record.id_;
+        cash.dts_ = record.dts_;
+        cash.amt_ = settlement.amt_;
+        std::memcpy(cash.name_, "Initial trade", 13);
+        CHECK_ERROR_CODE(cash_transactions.insert_record<TradeT>(
+          context_,
+          record.id_,
+          &cash,
+          sizeof(cash)));
       }
-      WRAP_ERROR_CODE(ret);
-      break;
-    }
+      return kErrorCodeOk;
+    }));
   }
 
   main_watch.stop();
@@ -422,63 +715,21 @@ ErrorStack TpceLoadTask::load_trades() {
     << main_watch.elapsed_sec() << " sec."
     << " now pre-sorting secondary keys before insertion...";
   debugging::StopWatch sort_watch;
-  std::sort(secondary_array, secondary_array + in_partition_count);
+  std::sort(symb_dts_array, symb_dts_array + in_partition_count);
+  std::sort(ca_dts_array, ca_dts_array + in_partition_count);
   sort_watch.stop();
-  LOG(INFO) << "Data Loader-" << partition_id_ << " pre-sorted TRADE secondary key in "
+  LOG(INFO) << "Data Loader-" << partition_id_ << " pre-sorted TRADE secondary keys in "
     << sort_watch.elapsed_sec() << " sec."
-    << " now inserting the secondary index...";
-
-  debugging::StopWatch index_watch;
-  // Batch insert them. These key/values are small.
-  const uint64_t kSecondaryBatchSize = 128;
-  for (uint64_t batch = 0; batch * kSecondaryBatchSize < in_partition_count; ++batch) {
-    const uint64_t batch_from = batch * kSecondaryBatchSize;
-    const uint64_t batch_to
-      = std::min<uint64_t>((batch + 1ULL) * kSecondaryBatchSize, in_partition_count);
-
-    // Retry in case of race abort.
-    while (true) {
-      WRAP_ERROR_CODE(xct_manager_->begin_xct(context_, xct::kSerializable));
-
-      bool has_error = false;
-      for (uint64_t i = batch_from; i < batch_to; ++i) {
-        const SecondaryKeyValue& kv = secondary_array[i];
-        ASSERT_ND(kv.value_ >= get_new_trade_id(scale_, partition_id_, 0));
-        ASSERT_ND(kv.value_ < get_new_trade_id(scale_, partition_id_, in_partition_count));
-        ASSERT_ND(get_partition_id_from_trade_id(scale_, kv.value_) == partition_id_);
-        ErrorCode ret = symb_dts_index.insert_record_normalized(
-          context_,
-          kv.key_,
-          &kv.value_,
-          sizeof(kv.value_));
-        if (ret == kErrorCodeXctRaceAbort) {
-          LOG(WARNING) << "oops, race abort during index-load 1. retry..";
-          has_error = true;
-          if (context_->is_running_xct()) {
-            WRAP_ERROR_CODE(xct_manager_->abort_xct(context_));
-          }
-          break;
-        }
-        WRAP_ERROR_CODE(ret);
-      }
-      if (has_error) {
-        continue;
-      }
-
-      Epoch commit_epoch;
-      ErrorCode ret = xct_manager_->precommit_xct(context_, &commit_epoch);
-      if (ret == kErrorCodeXctRaceAbort) {
-        LOG(WARNING) << "oops, race abort during index-load 2. retry..";
-        continue;
-      }
-      WRAP_ERROR_CODE(ret);
-      break;
-    }
-  }
-
-  index_watch.stop();
-  LOG(INFO) << "Data Loader-" << partition_id_ << " inserted to TRADE's secondary index in"
-    << index_watch.elapsed_sec() << " sec.";
+    << " now inserting the secondary indexes...";
+
+  CHECK_ERROR(load_secondary_index(
+    storages_.trades_secondary_symb_dts_,
+    symb_dts_array,
+    in_partition_count));
+  CHECK_ERROR(load_secondary_index(
+    storages_.trades_secondary_ca_dts_,
+    ca_dts_array,
+    in_partition_count));
   return kRetOk;
 }
 
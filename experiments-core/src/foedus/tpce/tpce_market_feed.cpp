@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include "foedus/tpce/tpce_client.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+#include "foedus/engine.hpp"
+#include "foedus/storage/masstree/masstree_cursor.hpp"
+#include "foedus/storage/masstree/masstree_storage.hpp"
+#include "foedus/xct/xct_manager.hpp"
+
+namespace foedus {
+namespace tpce {
+
+ErrorCode TpceClientTask::do_market_feed() {
+  auto last_trades = storages_.last_trades_;
+  auto trade_requests = storages_.trade_requests_;
+  auto trades = storages_.trades_;
+
+  // The market emulator of the spec sends 20 ticker entries at a time.
+  const uint32_t kMaxFeedLength = 20;
+  // We bound the number of triggered orders so that the read/write sets don't explode.
+  const uint32_t kMaxTriggered = 256;
+  TradeRequestKey triggered_keys[kMaxTriggered];
+  TradeT triggered_tids[kMaxTriggered];
+  uint32_t triggered_count = 0;
+
+  // The ticker has distinct symbols. Otherwise we would trigger the same request twice.
+  SymbT symbols[kMaxFeedLength];
+  uint32_t feed_length = 0;
+  const uint32_t feed_candidates = std::min<uint64_t>(
+    kMaxFeedLength,
+    scale_.get_security_cardinality());
+  while (feed_length < feed_candidates) {
+    const SymbT symb_id = zipfian_symbol_.next();
+    ASSERT_ND(symb_id < scale_.get_security_cardinality());
+    if (std::find(symbols, symbols + feed_length, symb_id) == symbols + feed_length) {
+      symbols[feed_length] = symb_id;
+      ++feed_length;
+    }
+  }
+
+  // Frame-1
+  const Datetime now_dts = get_articifical_current_dts();
+  for (uint32_t i = 0; i < feed_length; ++i) {
+    const SymbT symb_id = symbols[i];
+    LastTradeData last_trade;
+    CHECK_ERROR_CODE(last_trades.get_record(context_, symb_id, &last_trade));
+    // Random walk of +-5%
+    const SPriceT price_quote
+      = std::max<SPriceT>(100U, last_trade.price_ * rnd_.uniform_within(95, 105) / 100U);
+    const SCountT trade_qty = rnd_.uniform_within(1, 8) * 100U;
+    last_trade.dts_ = now_dts;
+    last_trade.price_ = price_quote;
+    last_trade.vol_ += trade_qty;
+    CHECK_ERROR_CODE(last_trades.overwrite_record(context_, symb_id, &last_trade));
+
+    // Limit orders on the symbol that are triggered by the new price.
+    storage::masstree::MasstreeCursor cursor(trade_requests, context_);
+    CHECK_ERROR_CODE(cursor.open_normalized(
+      to_trade_request_key(symb_id, 0),
+      to_trade_request_key(symb_id + 1U, 0),
+      true,
+      true));
+    while (cursor.is_valid_record() && triggered_count < kMaxTriggered) {
+      ASSERT_ND(cursor.get_payload_length() == sizeof(TradeRequestData));
+      const TradeRequestData* request
+        = reinterpret_cast<const TradeRequestData*>(cursor.get_payload());
+      const uint16_t tt_index = TradeTypeData::to_index(request->tt_id_);
+      bool triggered;
+      if (tt_index == TradeTypeData::kTls) {
+        triggered = price_quote >= request->bid_price_;
+      } else {
+        ASSERT_ND(tt_index == TradeTypeData::kTlb || tt_index == TradeTypeData::kTsl);
+        triggered = price_quote <= request->bid_price_;
+      }
+      if (triggered) {
+        triggered_keys[triggered_count] = cursor.get_normalized_key();
+        triggered_tids[triggered_count] = request->trade_id_;
+        ++triggered_count;
+      }
+      CHECK_ERROR_CODE(cursor.next());
+    }
+  }
+
+  // Triggered orders are removed from TRADE_REQUEST and submitted to the market.
+  for (uint32_t i = 0; i < triggered_count; ++i) {
+    CHECK_ERROR_CODE(trade_requests.delete_record_normalized(context_, triggered_keys[i]));
+    CHECK_ERROR_CODE(trades.overwrite_record<TradeT>(
+      context_,
+      triggered_tids[i],
+      kStatusSubmitted,
+      offsetof(TradeData, st_id_),
+      sizeof(TradeData::st_id_)));
+  }
+
+  Epoch ep;
+  CHECK_ERROR_CODE(engine_->get_xct_manager()->precommit_xct(context_, &ep));
+  for (uint32_t i = 0; i < triggered_count; ++i) {
+    push_submitted_trade(triggered_tids[i]);
+  }
+  return kErrorCodeOk;
+}
+
+}  // namespace tpce
+}  // namespace foedus
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include "foedus/tpce/tpce_client.hpp"
+
+#include <glog/logging.h>
+
+#include <cstddef>
+
+#include "foedus/engine.hpp"
+#include "foedus/storage/masstree/masstree_cursor.hpp"
+#include "foedus/storage/masstree/masstree_storage.hpp"
+#include "foedus/xct/xct_manager.hpp"
+
+namespace foedus {
+namespace tpce {
+
+ErrorCode TpceClientTask::do_market_watch() {
+  auto watch_items = storages_.watch_items_;
+  auto daily_markets = storages_.daily_markets_;
+
+  // Frame-1
+  // The spec picks the securities from a watch list (60%), an account's holdings (35%),
+  // or an industry (5%). We only implement the watch list.
+  const IdentT cust_id = pick_customer();
+  const uint32_t start_day = rnd_.uniform_within(
+    scale_.get_daily_market_from_day(),
+    scale_.get_daily_market_to_day() - 1U);
+
+  ValueT old_mkt_cap = 0;
+  ValueT new_mkt_cap = 0;
+  storage::masstree::MasstreeCursor cursor(watch_items, context_);
+  CHECK_ERROR_CODE(cursor.open_normalized(
+    to_watch_item_key(cust_id, 0),
+    to_watch_item_key(cust_id + 1U, 0)));
+  while (cursor.is_valid_record()) {
+    const SymbT symb_id = to_symb_from_watch_item_key(cursor.get_normalized_key());
+    SPriceT new_price;
+    CHECK_ERROR_CODE(storages_.last_trades_.get_record_primitive<SPriceT>(
+      context_,
+      symb_id,
+      &new_price,
+      offsetof(LastTradeData, price_)));
+    SCountT s_num_out;
+    CHECK_ERROR_CODE(storages_.securities_.get_record_primitive<SCountT>(
+      context_,
+      symb_id,
+      &s_num_out,
+      offsetof(SecurityData, num_out_)));
+    SPriceT old_price;
+    CHECK_ERROR_CODE(daily_markets.get_record_primitive_normalized<SPriceT>(
+      context_,
+      to_daily_market_key(symb_id, start_day),
+      &old_price,
+      offsetof(DailyMarketData, close_),
+      true));
+    old_mkt_cap += static_cast<ValueT>(s_num_out) * old_price;
+    new_mkt_cap += static_cast<ValueT>(s_num_out) * new_price;
+    CHECK_ERROR_CODE(cursor.next());
+  }
+
+  // pct_change, which is the output.
+  double pct_change = 0;
+  if (old_mkt_cap != 0) {
+    pct_change = 100.0 * (static_cast<double>(new_mkt_cap) / old_mkt_cap - 1.0);
+  }
+  DVLOG(3) << "pct_change=" << pct_change;
+
+  Epoch ep;
+  return engine_->get_xct_manager()->precommit_xct(context_, &ep);
+}
+
+}  // namespace tpce
+}  // namespace foedus
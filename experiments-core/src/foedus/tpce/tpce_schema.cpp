@@ -32,18 +32,54 @@ TpceStorages::TpceStorages() {
 void TpceStorages::assert_initialized() {
   ASSERT_ND(trades_.exists());
   ASSERT_ND(trades_secondary_symb_dts_.exists());
+  ASSERT_ND(trades_secondary_ca_dts_.exists());
   ASSERT_ND(trade_types_.exists());
+  ASSERT_ND(settlements_.exists());
+  ASSERT_ND(cash_transactions_.exists());
+  ASSERT_ND(trade_requests_.exists());
+  ASSERT_ND(brokers_.exists());
+  ASSERT_ND(accounts_.exists());
+  ASSERT_ND(holding_summaries_.exists());
+  ASSERT_ND(watch_items_.exists());
+  ASSERT_ND(securities_.exists());
+  ASSERT_ND(companies_.exists());
+  ASSERT_ND(last_trades_.exists());
+  ASSERT_ND(daily_markets_.exists());
 
   ASSERT_ND(trades_.get_name().str() == "trades");
   ASSERT_ND(trades_secondary_symb_dts_.get_name().str() == "trades_secondary_symb_dts");
+  ASSERT_ND(trades_secondary_ca_dts_.get_name().str() == "trades_secondary_ca_dts");
   ASSERT_ND(trade_types_.get_name().str() == "trade_types");
+  ASSERT_ND(settlements_.get_name().str() == "settlements");
+  ASSERT_ND(cash_transactions_.get_name().str() == "cash_transactions");
+  ASSERT_ND(trade_requests_.get_name().str() == "trade_requests");
+  ASSERT_ND(brokers_.get_name().str() == "brokers");
+  ASSERT_ND(accounts_.get_name().str() == "accounts");
+  ASSERT_ND(holding_summaries_.get_name().str() == "holding_summaries");
+  ASSERT_ND(watch_items_.get_name().str() == "watch_items");
+  ASSERT_ND(securities_.get_name().str() == "securities");
+  ASSERT_ND(companies_.get_name().str() == "companies");
+  ASSERT_ND(last_trades_.get_name().str() == "last_trades");
+  ASSERT_ND(daily_markets_.get_name().str() == "daily_markets");
 }
 
 void TpceStorages::initialize_tables(Engine* engine) {
   storage::StorageManager* st = engine->get_storage_manager();
   trades_ = st->get_hash("trades");
   trades_secondary_symb_dts_ = st->get_masstree("trades_secondary_symb_dts");
+  trades_secondary_ca_dts_ = st->get_masstree("trades_secondary_ca_dts");
   trade_types_ = st->get_array("trade_types");
+  settlements_ = st->get_hash("settlements");
+  cash_transactions_ = st->get_hash("cash_transactions");
+  trade_requests_ = st->get_masstree("trade_requests");
+  brokers_ = st->get_array("brokers");
+  accounts_ = st->get_array("accounts");
+  holding_summaries_ = st->get_masstree("holding_summaries");
+  watch_items_ = st->get_masstree("watch_items");
+  securities_ = st->get_array("securities");
+  companies_ = st->get_array("companies");
+  last_trades_ = st->get_array("last_trades");
+  daily_markets_ = st->get_masstree("daily_markets");
   assert_initialized();
 }
 
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include "foedus/tpce/tpce_client.hpp"
+
+#include "foedus/engine.hpp"
+#include "foedus/storage/masstree/masstree_cursor.hpp"
+#include "foedus/storage/masstree/masstree_storage.hpp"
+#include "foedus/xct/xct_manager.hpp"
+
+namespace foedus {
+namespace tpce {
+
+ErrorCode TpceClientTask::do_security_detail() {
+  auto daily_markets = storages_.daily_markets_;
+
+  // Frame-1
+  const SymbT symb_id = zipfian_symbol_.next();
+  ASSERT_ND(symb_id < scale_.get_security_cardinality());
+  const uint32_t in_max_rows_to_return = rnd_.uniform_within(5, 20);
+  const uint32_t start_day = rnd_.uniform_within(
+    scale_.get_daily_market_from_day(),
+    scale_.get_daily_market_to_day() - in_max_rows_to_return);
+
+  SecurityData security;
+  CHECK_ERROR_CODE(storages_.securities_.get_record(context_, symb_id, &security));
+  CompanyData company;
+  CHECK_ERROR_CODE(storages_.companies_.get_record(context_, security.co_id_, &company));
+  // We don't have ADDRESS, ZIP_CODE, EXCHANGE, COMPANY_COMPETITOR, FINANCIAL, or NEWS.
+
+  DailyMarketData days[20];
+  uint32_t fetched_rows = 0;
+  storage::masstree::MasstreeCursor cursor(daily_markets, context_);
+  CHECK_ERROR_CODE(cursor.open_normalized(
+    to_daily_market_key(symb_id, start_day),
+    to_daily_market_key(symb_id, start_day + in_max_rows_to_return)));
+  while (cursor.is_valid_record()) {
+    ASSERT_ND(cursor.get_payload_length() == sizeof(DailyMarketData));
+    ASSERT_ND(fetched_rows < in_max_rows_to_return);
+    days[fetched_rows] = *reinterpret_cast<const DailyMarketData*>(cursor.get_payload());
+    ASSERT_ND(days[fetched_rows].symb_id_ == symb_id);
+    ++fetched_rows;
+    CHECK_ERROR_CODE(cursor.next());
+  }
+  ASSERT_ND(fetched_rows == in_max_rows_to_return);
+
+  LastTradeData last_trade;
+  CHECK_ERROR_CODE(storages_.last_trades_.get_record(context_, symb_id, &last_trade));
+
+  Epoch ep;
+  return engine_->get_xct_manager()->precommit_xct(context_, &ep);
+}
+
+}  // namespace tpce
+}  // namespace foedus
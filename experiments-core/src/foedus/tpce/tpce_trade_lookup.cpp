@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include "foedus/tpce/tpce_client.hpp"
+
+#include "foedus/engine.hpp"
+#include "foedus/storage/masstree/masstree_cursor.hpp"
+#include "foedus/storage/masstree/masstree_storage.hpp"
+#include "foedus/xct/xct_manager.hpp"
+
+namespace foedus {
+namespace tpce {
+
+ErrorCode TpceClientTask::lookup_trade_details(TradeT tid, bool* found) {
+  TradeData trade;
+  uint16_t capacity = sizeof(trade);
+  ErrorCode ret = storages_.trades_.get_record<TradeT>(context_, tid, &trade, &capacity, true);
+  if (ret == kErrorCodeStrKeyNotFound) {
+    // The trade order was rolled back.
+    *found = false;
+    return kErrorCodeOk;
+  }
+  CHECK_ERROR_CODE(ret);
+  *found = true;
+
+  // Not-yet-completed trades don't have SETTLEMENT or CASH_TRANSACTION.
+  SettlementData settlement;
+  capacity = sizeof(settlement);
+  ret = storages_.settlements_.get_record<TradeT>(context_, tid, &settlement, &capacity, true);
+  if (ret != kErrorCodeStrKeyNotFound) {
+    CHECK_ERROR_CODE(ret);
+  }
+  if (trade.is_cash_) {
+    CashTransactionData cash;
+    capacity = sizeof(cash);
+    ret = storages_.cash_transactions_.get_record<TradeT>(context_, tid, &cash, &capacity, true);
+    if (ret != kErrorCodeStrKeyNotFound) {
+      CHECK_ERROR_CODE(ret);
+    }
+  }
+  return kErrorCodeOk;
+}
+
+ErrorCode TpceClientTask::do_trade_lookup() {
+  const uint32_t kMaxTrades = 20;
+  // Trades dated from the initial population to now.
+  const Datetime initial_from_dts = scale_.load_dts_
+    - scale_.calculate_initial_trade_cardinality() / scale_.total_partitions_;
+  const Datetime in_start_trade_dts
+    = rnd_.uniform_within(initial_from_dts, artificial_cur_dts_);
+  const Datetime in_end_trade_dts = artificial_cur_dts_;
+  uint32_t fetched_rows = 0;
+  bool found;
+
+  // We omit Frame-4, which needs TRADE_HISTORY and HOLDING_HISTORY.
+  // Its share is split among the other frames.
+  const uint32_t frame = rnd_.uniform_within(1, 3);
+  if (frame == 1) {
+    // Frame-1: lookup given trade IDs. We pick them from the initially loaded trades.
+    const uint64_t in_partition_count
+      = scale_.calculate_initial_trade_cardinality() / scale_.total_partitions_;
+    for (uint32_t i = 0; i < kMaxTrades; ++i) {
+      const TradeT tid = get_new_trade_id(
+        scale_,
+        rnd_.next_uint32() % scale_.total_partitions_,
+        rnd_.next_uint64() % in_partition_count);
+      CHECK_ERROR_CODE(lookup_trade_details(tid, &found));
+      ASSERT_ND(found);
+    }
+  } else {
+    // Frame-2: trades of an account in the range. Frame-3: trades of a symbol in the range.
+    storage::masstree::KeySlice from_key;
+    storage::masstree::KeySlice to_key;
+    storage::masstree::MasstreeStorage index;
+    if (frame == 2) {
+      const IdentT acct_id = pick_account();
+      from_key = to_ca_dts_key(acct_id, in_start_trade_dts, 0);
+      to_key = to_ca_dts_key(acct_id, in_end_trade_dts + 1U, 0);
+      index = storages_.trades_secondary_ca_dts_;
+    } else {
+      const SymbT symbol = zipfian_symbol_.next();
+      from_key = to_symb_dts_key(symbol, in_start_trade_dts, 0);
+      to_key = to_symb_dts_key(symbol, in_end_trade_dts + 1U, 0);
+      index = storages_.trades_secondary_symb_dts_;
+    }
+
+    TradeT tids[kMaxTrades];
+    storage::masstree::MasstreeCursor cursor(index, context_);
+    CHECK_ERROR_CODE(cursor.open_normalized(from_key, to_key));
+    while (cursor.is_valid_record() && fetched_rows < kMaxTrades) {
+      ASSERT_ND(cursor.get_payload_length() == sizeof(TradeT));
+      tids[fetched_rows] = *reinterpret_cast<const TradeT*>(cursor.get_payload());
+      ++fetched_rows;
+      CHECK_ERROR_CODE(cursor.next());
+    }
+    for (uint32_t i = 0; i < fetched_rows; ++i) {
+      CHECK_ERROR_CODE(lookup_trade_details(tids[i], &found));
+    }
+  }
+
+  Epoch ep;
+  return engine_->get_xct_manager()->precommit_xct(context_, &ep);
+}
+
+}  // namespace tpce
+}  // namespace foedus
@@ -19,6 +19,9 @@
 
 #include <glog/logging.h>
 
+#include <cstddef>
+#include <cstring>
+
 #include "foedus/engine.hpp"
 #include "foedus/storage/storage.hpp"
 #include "foedus/storage/storage_manager.hpp"
@@ -30,30 +33,66 @@ namespace tpce {
 ErrorCode TpceClientTask::do_trade_order() {
   auto trades = storages_.trades_;
   auto trades_index = storages_.trades_secondary_symb_dts_;
+  auto trades_ca_index = storages_.trades_secondary_ca_dts_;
   auto trade_types = storages_.trade_types_;
-  // We omit Frame-1 and -2.
+  auto trade_requests = storages_.trade_requests_;
+
+  // Frame-1
+  // Customer account and its broker. We don't have CUSTOMER table.
+  const IdentT acct_id = pick_account();
+  CustomerAccountData account;
+  CHECK_ERROR_CODE(storages_.accounts_.get_record(context_, acct_id, &account));
+  BrokerData broker;
+  CHECK_ERROR_CODE(storages_.brokers_.get_record(context_, account.b_id_, &broker));
+
+  // We omit Frame-2 (permission check). The executor is always the account owner.
 
   // Frame-3
   // This is also drastically simplified from the full spec.
-  // Our intent here is to focus on the behavior around
-  // TRADE/TRADE_TYPE. We aren't even trying the full spec.
+  // We don't compute tax and commission rates here.
   uint32_t r = rnd_.next_uint32() % TradeTypeData::kCount;
   const char* in_trade_type_id = TradeTypeData::generate_type_id(r);
-
-  // Lookup in TRADE_TYPE. It's just 5 records. Better to just scan all.
   TradeTypeData tt_record;
-  bool type_found = false;
-  for (uint32_t i = 0; i < TradeTypeData::kCount; ++i) {
-    CHECK_ERROR_CODE(trade_types.get_record(context_, i, &tt_record));
-    if (std::memcmp(tt_record.id_, in_trade_type_id, sizeof(tt_record.id_)) == 0) {
-      type_found = true;
-      break;
+  CHECK_ERROR_CODE(trade_types.get_record(context_, r, &tt_record));
+  ASSERT_ND(std::memcmp(tt_record.id_, in_trade_type_id, sizeof(tt_record.id_)) == 0);
+
+  const SymbT symb_id = zipfian_symbol_.next();
+  ASSERT_ND(symb_id < scale_.get_security_cardinality());
+  SecurityData security;
+  CHECK_ERROR_CODE(storages_.securities_.get_record(context_, symb_id, &security));
+  SPriceT market_price;
+  CHECK_ERROR_CODE(storages_.last_trades_.get_record_primitive<SPriceT>(
+    context_,
+    symb_id,
+    &market_price,
+    offsetof(LastTradeData, price_)));
+
+  const SQtyT trade_qty = rnd_.uniform_within(1, 8) * 100;
+  SPriceT requested_price;
+  if (tt_record.is_mrkt_) {
+    requested_price = market_price;
+  } else {
+    // Limit orders are within +-10% of the current price, so that MarketFeed triggers some.
+    requested_price = market_price * rnd_.uniform_within(90, 110) / 100U;
+  }
+
+  if (tt_record.is_sell_) {
+    // The spec checks the current holdings to find whether this sells long positions.
+    // We just read the summary.
+    HoldingSummaryData holding;
+    storage::masstree::PayloadLength capacity = sizeof(holding);
+    ErrorCode ret = storages_.holding_summaries_.get_record_normalized(
+      context_,
+      to_holding_summary_key(acct_id, symb_id),
+      &holding,
+      &capacity,
+      true);
+    if (ret != kErrorCodeStrKeyNotFound) {
+      CHECK_ERROR_CODE(ret);
     }
   }
-  ASSERT_ND(type_found);
 
   // Frame-4
-  // Inserted values are directly coming from above code or fixed values.
   const Datetime now_dts = get_articifical_current_dts();
   const TradeT tid = get_artificial_new_trade_id();
   DVLOG(3) << "tid=" << tid << ", now_dts=" << now_dts;
@@ -61,23 +100,20 @@ ErrorCode TpceClientTask::do_trade_order() {
   record.dts_ = now_dts;
   record.id_ = tid;
   std::memcpy(record.tt_id_, in_trade_type_id, sizeof(record.tt_id_));
-  record.symb_id_ = zipfian_symbol_.next();
-  ASSERT_ND(record.symb_id_ < scale_.get_security_cardinality());
-  record.ca_id_ = rnd_.next_uint64() % (scale_.customers_ * kAccountsPerCustomer);
+  record.symb_id_ = symb_id;
+  record.ca_id_ = acct_id;
   record.tax_ = 0;
-  record.lifo_ = false;
+  record.lifo_ = (rnd_.next_uint32() % 2U) == 0;
   record.trade_price_ = 0;
 
-  // Followings should be given as inputs, but we hard-code them for now.
-  std::memcpy(record.st_id_, "ACTV", sizeof(record.st_id_));
-  record.is_cash_ = true;
-  record.qty_ = 10;
-  record.bid_price_ = tt_record.is_mrkt_ ? 10000 : 11000;
-  std::memcpy(
-    record.exec_name_,
-    "01234567890123456789012345678901234567890123456789",
-    sizeof(record.exec_name_));
-  record.comm_ = 100;
+  // Market orders are submitted right away. Limit orders wait for MarketFeed.
+  const char* status = tt_record.is_mrkt_ ? kStatusSubmitted : kStatusPending;
+  std::memcpy(record.st_id_, status, sizeof(record.st_id_));
+  record.is_cash_ = (rnd_.next_uint32() % 100U) < 92U;
+  record.qty_ = trade_qty;
+  record.bid_price_ = requested_price;
+  std::memcpy(record.exec_name_, broker.name_, sizeof(record.exec_name_));
+  record.comm_ = 0;
   record.chrg_ = 100;
 
   CHECK_ERROR_CODE(trades.insert_record<TradeT>(context_, tid, &record, sizeof(record)));
@@ -91,8 +127,37 @@ ErrorCode TpceClientTask::do_trade_order() {
     secondary_key,
     &tid,
     sizeof(tid)));
+  CHECK_ERROR_CODE(trades_ca_index.insert_record_normalized(
+    context_,
+    to_ca_dts_key(acct_id, now_dts, worker_id_),
+    &tid,
+    sizeof(tid)));
+
+  if (!tt_record.is_mrkt_) {
+    TradeRequestData request;
+    request.trade_id_ = tid;
+    std::memcpy(request.tt_id_, in_trade_type_id, sizeof(request.tt_id_));
+    request.qty_ = trade_qty;
+    request.bid_price_ = requested_price;
+    request.b_id_ = account.b_id_;
+    CHECK_ERROR_CODE(trade_requests.insert_record_normalized(
+      context_,
+      to_trade_request_key(symb_id, tid),
+      &request,
+      sizeof(request)));
+  }
+
+  // Frame-5/6. The spec rolls back about 1% of the trade orders.
+  if (rnd_.uniform_within(1, 100) == 1) {
+    return kErrorCodeXctUserAbort;
+  }
+
   Epoch ep;
-  return engine_->get_xct_manager()->precommit_xct(context_, &ep);
+  CHECK_ERROR_CODE(engine_->get_xct_manager()->precommit_xct(context_, &ep));
+  if (tt_record.is_mrkt_) {
+    push_submitted_trade(tid);
+  }
+  return kErrorCodeOk;
 }
 
 }  // namespace tpce
@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include "foedus/tpce/tpce_client.hpp"
+
+#include <cstddef>
+#include <cstring>
+
+#include "foedus/engine.hpp"
+#include "foedus/storage/masstree/masstree_storage.hpp"
+#include "foedus/xct/xct_manager.hpp"
+
+namespace foedus {
+namespace tpce {
+
+ErrorCode TpceClientTask::do_trade_result() {
+  auto trades = storages_.trades_;
+  auto holding_summaries = storages_.holding_summaries_;
+  ASSERT_ND(submitted_trades_count_ > 0);
+  const TradeT tid = submitted_trades_[submitted_trades_head_];
+
+  // Frame-1
+  TradeData trade;
+  uint16_t trade_capacity = sizeof(trade);
+  CHECK_ERROR_CODE(trades.get_record<TradeT>(context_, tid, &trade, &trade_capacity, false));
+  ASSERT_ND(std::memcmp(trade.st_id_, kStatusSubmitted, sizeof(trade.st_id_)) == 0);
+  const uint16_t tt_index = TradeTypeData::to_index(trade.tt_id_);
+  TradeTypeData tt_record;
+  CHECK_ERROR_CODE(storages_.trade_types_.get_record(context_, tt_index, &tt_record));
+  CustomerAccountData account;
+  CHECK_ERROR_CODE(storages_.accounts_.get_record(context_, trade.ca_id_, &account));
+
+  // The market emulator of the spec gives the execution price. Market orders are
+  // executed at the last trade price, limit orders at the requested price.
+  SPriceT trade_price = trade.bid_price_;
+  if (tt_record.is_mrkt_) {
+    CHECK_ERROR_CODE(storages_.last_trades_.get_record_primitive<SPriceT>(
+      context_,
+      trade.symb_id_,
+      &trade_price,
+      offsetof(LastTradeData, price_)));
+  }
+
+  // Frame-2
+  // We don't have HOLDING/HOLDING_HISTORY. We just maintain the summary.
+  const HoldingSummaryKey hs_key = to_holding_summary_key(trade.ca_id_, trade.symb_id_);
+  SQtyT qty_delta = tt_record.is_sell_ ? -trade.qty_ : trade.qty_;
+  HoldingSummaryData holding;
+  storage::masstree::PayloadLength capacity = sizeof(holding);
+  ErrorCode ret = holding_summaries.get_record_normalized(
+    context_,
+    hs_key,
+    &holding,
+    &capacity,
+    false);
+  if (ret == kErrorCodeStrKeyNotFound) {
+    holding.qty_ = qty_delta;
+    CHECK_ERROR_CODE(holding_summaries.insert_record_normalized(
+      context_,
+      hs_key,
+      &holding,
+      sizeof(holding)));
+  } else {
+    CHECK_ERROR_CODE(ret);
+    CHECK_ERROR_CODE(holding_summaries.increment_record_normalized<SQtyT>(
+      context_,
+      hs_key,
+      &qty_delta,
+      0));
+  }
+
+  // Frame-3 (tax) is omitted.
+
+  // Frame-4
+  SecurityData security;
+  CHECK_ERROR_CODE(storages_.securities_.get_record(context_, trade.symb_id_, &security));
+  const ValueT trade_amount = static_cast<ValueT>(trade.qty_) * trade_price;
+  ValueT comm_amount = trade_amount / 100;  // flat 1% commission
+
+  // Frame-5
+  const Datetime now_dts = get_articifical_current_dts();
+  std::memcpy(trade.st_id_, kStatusCompleted, sizeof(trade.st_id_));
+  trade.trade_price_ = trade_price;
+  trade.comm_ = comm_amount;
+  // We keep T_DTS as of the order because it is a part of the secondary index keys.
+  CHECK_ERROR_CODE(trades.overwrite_record<TradeT>(context_, tid, &trade, 0, sizeof(trade)));
+  uint32_t one = 1;
+  CHECK_ERROR_CODE(storages_.brokers_.increment_record<uint32_t>(
+    context_,
+    account.b_id_,
+    &one,
+    offsetof(BrokerData, num_trades_)));
+  CHECK_ERROR_CODE(storages_.brokers_.increment_record<ValueT>(
+    context_,
+    account.b_id_,
+    &comm_amount,
+    offsetof(BrokerData, comm_total_)));
+
+  // Frame-6
+  SettlementData settlement;
+  std::memset(&settlement, 0, sizeof(settlement));
+  settlement.trade_id_ = tid;
+  settlement.set_cash_type(trade.is_cash_);
+  settlement.due_date_ = now_dts + 2U * kSecondsPerDay;
+  ValueT se_amount = tt_record.is_sell_ ? trade_amount : -trade_amount;
+  se_amount -= trade.chrg_ + comm_amount;
+  settlement.amt_ = se_amount;
+  CHECK_ERROR_CODE(storages_.settlements_.insert_record<TradeT>(
+    context_,
+    tid,
+    &settlement,
+    sizeof(settlement)));
+  if (trade.is_cash_) {
+    CashTransactionData cash;
+    std::memset(&cash, 0, sizeof(cash));
+    cash.trade_id_ = tid;
+    cash.dts_ = now_dts;
+    cash.amt_ = se_amount;
+    std::memcpy(cash.name_, tt_record.name_, sizeof(tt_record.name_));
+    CHECK_ERROR_CODE(storages_.cash_transactions_.insert_record<TradeT>(
+      context_,
+      tid,
+      &cash,
+      sizeof(cash)));
+    CHECK_ERROR_CODE(storages_.accounts_.increment_record<ValueT>(
+      context_,
+      trade.ca_id_,
+      &se_amount,
+      offsetof(CustomerAccountData, bal_)));
+  }
+
+  Epoch ep;
+  CHECK_ERROR_CODE(engine_->get_xct_manager()->precommit_xct(context_, &ep));
+  pop_submitted_trade();
+  return kErrorCodeOk;
+}
+
+}  // namespace tpce
+}  // namespace foedus
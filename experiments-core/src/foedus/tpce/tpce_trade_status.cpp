@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include "foedus/tpce/tpce_client.hpp"
+
+#include <cstring>
+
+#include "foedus/engine.hpp"
+#include "foedus/storage/masstree/masstree_cursor.hpp"
+#include "foedus/storage/masstree/masstree_storage.hpp"
+#include "foedus/xct/xct_manager.hpp"
+
+namespace foedus {
+namespace tpce {
+
+struct TradeStatusOutput {
+  TradeT    id_;
+  Datetime  dts_;
+  char      status_[4];
+  char      type_name_[12];
+  SymbT     symb_id_;
+  SQtyT     qty_;
+  char      exec_name_[49];
+  ValueT    chrg_;
+  char      s_name_[70];
+};
+
+ErrorCode TpceClientTask::do_trade_status() {
+  auto trades = storages_.trades_;
+  auto trade_types = storages_.trade_types_;
+
+  // Frame-1
+  const IdentT acct_id = pick_account();
+  const uint32_t kMaxTrades = 50;
+
+  TradeTypeData tt_records[TradeTypeData::kCount];
+  for (uint32_t i = 0; i < TradeTypeData::kCount; ++i) {
+    CHECK_ERROR_CODE(trade_types.get_record(context_, i, tt_records + i));
+  }
+
+  // The latest 50 trades of the account.
+  TradeStatusOutput outputs[kMaxTrades];
+  uint32_t fetched_rows = 0;
+  storage::masstree::MasstreeCursor cursor(storages_.trades_secondary_ca_dts_, context_);
+  CHECK_ERROR_CODE(cursor.open_normalized(
+    to_ca_dts_key(acct_id + 1U, 0, 0),
+    to_ca_dts_key(acct_id, 0, 0),
+    false,
+    false,
+    false,
+    true));
+  while (cursor.is_valid_record() && fetched_rows < kMaxTrades) {
+    ASSERT_ND(to_ca_from_ca_dts_key(cursor.get_normalized_key()) == acct_id);
+    ASSERT_ND(cursor.get_payload_length() == sizeof(TradeT));
+    outputs[fetched_rows].id_ = *reinterpret_cast<const TradeT*>(cursor.get_payload());
+    ++fetched_rows;
+    CHECK_ERROR_CODE(cursor.next());
+  }
+
+  for (uint32_t i = 0; i < fetched_rows; ++i) {
+    TradeData payload;
+    uint16_t payload_capacity = sizeof(payload);
+    CHECK_ERROR_CODE(trades.get_record<TradeT>(
+      context_,
+      outputs[i].id_,
+      &payload,
+      &payload_capacity,
+      true));
+    ASSERT_ND(payload.ca_id_ == acct_id);
+    outputs[i].dts_ = payload.dts_;
+    std::memcpy(outputs[i].status_, payload.st_id_, sizeof(payload.st_id_));
+    const TradeTypeData& tt_record = tt_records[TradeTypeData::to_index(payload.tt_id_)];
+    std::memcpy(outputs[i].type_name_, tt_record.name_, sizeof(tt_record.name_));
+    outputs[i].symb_id_ = payload.symb_id_;
+    outputs[i].qty_ = payload.qty_;
+    std::memcpy(outputs[i].exec_name_, payload.exec_name_, sizeof(payload.exec_name_));
+    outputs[i].chrg_ = payload.chrg_;
+
+    SecurityData security;
+    CHECK_ERROR_CODE(storages_.securities_.get_record(context_, payload.symb_id_, &security));
+    std::memcpy(outputs[i].s_name_, security.name_, sizeof(security.name_));
+  }
+
+  // Customer and broker of the account. We don't have CUSTOMER table.
+  CustomerAccountData account;
+  CHECK_ERROR_CODE(storages_.accounts_.get_record(context_, acct_id, &account));
+  BrokerData broker;
+  CHECK_ERROR_CODE(storages_.brokers_.get_record(context_, account.b_id_, &broker));
+
+  Epoch ep;
+  return engine_->get_xct_manager()->precommit_xct(context_, &ep);
+}
+
+}  // namespace tpce
+}  // namespace foedus
@@ -95,6 +95,7 @@ ErrorCode TpceClientTask::do_trade_update() {
     if (fetched_rows >= in_max_trades) {
       break;
     }
+    CHECK_ERROR_CODE(cursor.next());
   }
 
   // Finally, query them in TRADE's primary storage
@@ -103,25 +104,25 @@ ErrorCode TpceClientTask::do_trade_update() {
     TradeData payload;
     uint16_t payload_capacity = sizeof(payload);
     CHECK_ERROR_CODE(trades.get_record<TradeT>(context_, key, &payload, &payload_capacity, true));
-    outputs[fetched_rows].acct_id_ = payload.ca_id_;
-    std::memcpy(outputs[fetched_rows].exec_name_, payload.exec_name_, sizeof(payload.exec_name_));
-    outputs[fetched_rows].is_cash_ = payload.is_cash_;
-    outputs[fetched_rows].qty_ = payload.qty_;
-    outputs[fetched_rows].price_ = payload.trade_price_;
-    outputs[fetched_rows].symb_id_ = payload.symb_id_;
+    outputs[i].acct_id_ = payload.ca_id_;
+    std::memcpy(outputs[i].exec_name_, payload.exec_name_, sizeof(payload.exec_name_));
+    outputs[i].is_cash_ = payload.is_cash_;
+    outputs[i].qty_ = payload.qty_;
+    outputs[i].price_ = payload.trade_price_;
+    outputs[i].symb_id_ = payload.symb_id_;
     ASSERT_ND(payload.symb_id_ == symbol);
-    outputs[fetched_rows].trade_dts_ = payload.dts_;
+    outputs[i].trade_dts_ = payload.dts_;
     ASSERT_ND(payload.dts_ >= in_start_trade_dts);
     ASSERT_ND(payload.dts_ <= in_end_trade_dts);
-    outputs[fetched_rows].trade_dts_ = payload.dts_;
-    std::memcpy(outputs[fetched_rows].trade_type_, payload.tt_id_, sizeof(payload.tt_id_));
+    outputs[i].trade_dts_ = payload.dts_;
+    std::memcpy(outputs[i].trade_type_, payload.tt_id_, sizeof(payload.tt_id_));
 
     // NLJ without index. Just iterate through
     bool found = false;
     for (uint32_t j = 0; j < TradeTypeData::kCount; ++j) {
       if (std::memcmp(tt_records[j].id_, payload.tt_id_, sizeof(payload.tt_id_)) == 0) {
         std::memcpy(
-          outputs[fetched_rows].type_name_,
+          outputs[i].type_name_,
           tt_records[j].name_,
           sizeof(tt_records[j].name_));
         found = true;
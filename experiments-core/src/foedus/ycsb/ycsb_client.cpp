@@ -26,6 +26,7 @@
 #include <algorithm>
 #include <chrono>
 #include <iostream>
+#include <memory>
 #include <string>
 #include <thread>
 #include <utility>
@@ -33,9 +34,11 @@
 
 #include "foedus/engine.hpp"
 #include "foedus/engine_options.hpp"
+#include "foedus/epoch.hpp"
 #include "foedus/error_stack.hpp"
 #include "foedus/assorted/zipfian_random.hpp"
 #include "foedus/debugging/debugging_supports.hpp"
+#include "foedus/debugging/open_loop.hpp"
 #include "foedus/debugging/stop_watch.hpp"
 #include "foedus/fs/filesystem.hpp"
 #include "foedus/log/log_manager.hpp"
@@ -118,6 +121,20 @@ ErrorStack YcsbClientTask::run(thread::Thread* context) {
   uint32_t cur_bucket_throughput = 0;
   uint32_t cur_bucket_abort = 0;
   uint32_t total_extra_ops = workload_.extra_table_rmws_+ workload_.extra_table_reads_;
+
+  // In open-loop mode, transactions start on a schedule independent from their latencies
+  const bool open_loop = arrival_rate_ > 0;
+  std::unique_ptr<debugging::ArrivalSchedule> schedule;
+  std::unique_ptr<debugging::DurableLatencyRecorder> recorder;
+  for (uint16_t i = 0; i < kXctTypeCount; ++i) {
+    outputs_->latencies_[i].clear();
+  }
+  if (open_loop) {
+    schedule.reset(
+      new debugging::ArrivalSchedule(arrival_type_, arrival_rate_, 7493 + worker_id_));
+    recorder.reset(new debugging::DurableLatencyRecorder(engine_, outputs_->latencies_));
+    schedule->start(debugging::get_monotonic_nanoseconds());
+  }
   while (!is_stop_requested()) {
     // per every transaction (probably not too frequent), check if we are told to move on
     if (output_bucketed_throughput_) {
@@ -152,6 +169,12 @@ ErrorStack YcsbClientTask::run(thread::Thread* context) {
       }
     }
 
+    uint64_t intended_start = 0;
+    if (open_loop) {
+      intended_start = schedule->pop_arrival();
+      recorder->wait_until(intended_start, &channel_->stop_flag_);
+    }
+
     uint16_t xct_type = rnd_xct_select_.uniform_within(1, 100);
     // remember the random seed to repeat the same transaction on abort/retry.
     uint64_t rnd_seed = rnd_xct_select_.get_current_seed();
@@ -196,6 +219,8 @@ ErrorStack YcsbClientTask::run(thread::Thread* context) {
 
     // abort-retry loop
     bool abort_gave_up = false;
+    bool committed = false;
+    Epoch commit_epoch;
     while (!is_stop_requested()) {
       rnd_xct_select_.set_current_seed(rnd_seed);
       rnd_scan_length_select_.set_current_seed(scan_length_rnd_seed);
@@ -288,13 +313,13 @@ ErrorStack YcsbClientTask::run(thread::Thread* context) {
 
     finish:
       // Done with data access, try to commit
-      Epoch commit_epoch;
       if (ret == kErrorCodeOk) {
         ret = xct_manager_->precommit_xct(context_, &commit_epoch);
         if (ret == kErrorCodeOk) {
           ASSERT_ND(!context->is_running_xct());
           user_keys.clear();
           extra_keys.clear();
+          committed = true;
           break;
         }
       } else {
@@ -345,6 +370,21 @@ ErrorStack YcsbClientTask::run(thread::Thread* context) {
         }
       }
     }
+    if (open_loop && committed) {
+      XctType type;
+      if (xct_type <= workload_.insert_percent_) {
+        type = kInsert;
+      } else if (xct_type <= workload_.read_percent_) {
+        type = kRead;
+      } else if (xct_type <= workload_.update_percent_) {
+        type = kUpdate;
+      } else if (xct_type <= workload_.scan_percent_) {
+        type = kScan;
+      } else {
+        type = kRmw;
+      }
+      recorder->on_commit(type, intended_start, commit_epoch);
+    }
     if (!abort_gave_up) {
       ++outputs_->processed_;
       ++cur_bucket_throughput;
@@ -37,6 +37,8 @@
 #include "foedus/assorted/cacheline.hpp"
 #include "foedus/assorted/zipfian_random.hpp"
 #include "foedus/debugging/debugging_supports.hpp"
+#include "foedus/debugging/latency_histogram.hpp"
+#include "foedus/debugging/open_loop.hpp"
 #include "foedus/debugging/stop_watch.hpp"
 #include "foedus/fs/filesystem.hpp"
 #include "foedus/log/log_manager.hpp"
@@ -131,6 +133,12 @@ DEFINE_bool(aggressive_release, true, "Enable aggressive lock-release to restore
 DEFINE_bool(shifting_workload, false, "whether to run the shifting workloads.");
 
 DEFINE_bool(suppress_memory_prescreen, false, "Whether to turn off environment check.");
+DEFINE_double(open_loop_rate, 0, "Total transactions per second issued in open-loop mode,"
+  " divided evenly to worker threads. Latencies are measured from the intended start time"
+  " to the durable commit. 0 (default) runs the usual closed-loop mode.");
+DEFINE_string(open_loop_arrival, "poisson", "Arrivals in open-loop mode: poisson or fixed.");
+DEFINE_string(latency_json, "", "Path of a file to write per-second latency histograms to,"
+  " one JSON object per line. Only in open-loop mode. Empty (default) writes no file.");
 
 
 YcsbWorkload YcsbWorkloadA('A', 0,  50U,  100U, 0,    0);     // Workload A - 50% read, 50% update
@@ -368,6 +376,41 @@ int driver_main(int argc, char **argv) {
   return 0;
 }
 
+/** Names of YcsbClientTask::XctType in JSON outputs */
+const char* const kXctTypeNames[] = {
+  "insert",
+  "read",
+  "update",
+  "scan",
+  "rmw",
+};
+
+void write_latency_json(
+  std::ostream* o,
+  double elapsed_sec,
+  const debugging::LatencyHistogram* histograms) {
+  *o << "{\"elapsed_sec\":" << elapsed_sec << ",\"xcts\":{";
+  for (uint16_t i = 0; i < YcsbClientTask::kXctTypeCount; ++i) {
+    if (i > 0) {
+      *o << ",";
+    }
+    *o << "\"" << kXctTypeNames[i] << "\":";
+    histograms[i].write_json(o);
+  }
+  *o << "}}" << std::endl;
+}
+
+void sum_latencies(
+  const std::vector< const YcsbClientTask::Outputs* >& outputs,
+  std::vector< debugging::LatencyHistogram >* out) {
+  for (uint16_t i = 0; i < YcsbClientTask::kXctTypeCount; ++i) {
+    (*out)[i].clear();
+    for (const YcsbClientTask::Outputs* output : outputs) {
+      (*out)[i].merge(output->latencies_[i]);
+    }
+  }
+}
+
 ErrorStack YcsbDriver::run() {
   // Setup the channel so I can synchronize with workers and record nr_workers
   YcsbClientChannel* channel = get_channel(engine_);
@@ -552,6 +595,18 @@ ErrorStack YcsbDriver::run() {
   uint32_t worker_id = 0;
   std::vector< thread::ImpersonateSession > sessions;
   std::vector< const YcsbClientTask::Outputs* > outputs;
+  const bool open_loop = FLAGS_open_loop_rate > 0;
+  const double arrival_rate = FLAGS_open_loop_rate / total_thread_count;
+  debugging::ArrivalSchedule::Type arrival_type = debugging::ArrivalSchedule::kPoisson;
+  if (FLAGS_open_loop_arrival == "fixed") {
+    arrival_type = debugging::ArrivalSchedule::kFixed;
+  } else if (FLAGS_open_loop_arrival != "poisson") {
+    LOG(FATAL) << "Unknown open_loop_arrival:" << FLAGS_open_loop_arrival;
+  }
+  if (open_loop) {
+    LOG(INFO) << "Open-loop mode: " << FLAGS_open_loop_rate << " xct/sec in total, "
+      << arrival_rate << " xct/sec per thread, arrival=" << FLAGS_open_loop_arrival;
+  }
   for (uint16_t node = 0; node < options.thread_.group_count_; node++) {
     for (uint16_t ordinal = 0; ordinal < options.thread_.thread_count_per_group_; ordinal++) {
       thread::ImpersonateSession session;
@@ -564,6 +619,8 @@ ErrorStack YcsbDriver::run() {
       inputs.sort_keys_ = FLAGS_sort_keys;
       inputs.local_key_counter_ = get_local_key_counter(engine_, worker_id);
       inputs.output_bucketed_throughput_ = FLAGS_shifting_workload;
+      inputs.arrival_rate_ = open_loop ? arrival_rate : 0;
+      inputs.arrival_type_ = arrival_type;
       if (initial_user_records_per_thread == 0) {
         if (node == 0 && ordinal == 0) {
           inputs.local_key_counter_->user_key_counter_ = initial_table_size;
@@ -604,6 +661,15 @@ ErrorStack YcsbDriver::run() {
   channel->start_rendezvous_.signal();
   assorted::memory_fence_release();
   LOG(INFO) << "Started!";
+  std::ofstream latency_json;
+  if (open_loop && !FLAGS_latency_json.empty()) {
+    latency_json.open(FLAGS_latency_json.c_str(), std::ios::out | std::ios::trunc);
+    if (!latency_json) {
+      LOG(FATAL) << "Couldn't open " << FLAGS_latency_json;
+    }
+  }
+  std::vector< debugging::LatencyHistogram > latencies(YcsbClientTask::kXctTypeCount);
+  std::vector< debugging::LatencyHistogram > previous_latencies(YcsbClientTask::kXctTypeCount);
   debugging::StopWatch duration;
   uint32_t sleep_interval_us = 1000000ULL;
   constexpr uint32_t kBucketIntervalUs = 10UL;  // 10 us
@@ -694,6 +760,16 @@ ErrorStack YcsbDriver::run() {
     }
     LOG(INFO) << "Intermediate report after " << result.duration_sec_ << " sec";
     LOG(INFO) << result;
+    if (latency_json.is_open()) {
+      // histograms of this interval only
+      sum_latencies(outputs, &latencies);
+      std::vector< debugging::LatencyHistogram > interval(latencies);
+      for (uint16_t i = 0; i < YcsbClientTask::kXctTypeCount; ++i) {
+        interval[i].subtract(previous_latencies[i]);
+      }
+      write_latency_json(&latency_json, result.duration_sec_, &interval[0]);
+      previous_latencies.swap(latencies);
+    }
   }
   duration.stop();
 
@@ -745,6 +821,17 @@ ErrorStack YcsbDriver::run() {
       }
     }
   }
+  if (open_loop) {
+    sum_latencies(outputs, &latencies);
+    for (uint16_t i = 0; i < YcsbClientTask::kXctTypeCount; ++i) {
+      LOG(INFO) << "Latencies of " << kXctTypeNames[i] << ": " << latencies[i];
+    }
+    if (latency_json.is_open()) {
+      // the last line is the histograms of the entire run
+      write_latency_json(&latency_json, result.duration_sec_, &latencies[0]);
+      latency_json.close();
+    }
+  }
 
   LOG(INFO) << "Shutting down...";
 
@@ -310,6 +310,24 @@ class CacheHashtable CXX11_FINAL {
    */
   void evict(EvictArgs* args);
 
+  /** An entry collected by collect_hot_entries() */
+  struct HotEntry {
+    ContentId content_;
+    uint16_t  refcount_;
+  };
+  /**
+   * @brief Collects entries in this hashtable that are still referenced, with their refcounts.
+   * @param[in] max_count Capacity of out
+   * @param[out] out Collected entries in no particular order
+   * @return Number of entries written to out
+   * @details
+   * This does not take any lock, so the result might be a bit inaccurate under concurrent
+   * installs. That's fine as the caller uses it just as a hint of the hot working set.
+   * Like evict(), this should be called only by the cleaner thread so that the returned
+   * contents are not reclaimed while the caller reads them.
+   */
+  uint64_t collect_hot_entries(uint64_t max_count, HotEntry* out) const;
+
   BucketId get_logical_buckets() const ALWAYS_INLINE { return hash_func_.logical_buckets_; }
   BucketId get_physical_buckets() const ALWAYS_INLINE { return hash_func_.physical_buckets_; }
 
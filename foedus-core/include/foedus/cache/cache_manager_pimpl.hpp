@@ -27,6 +27,7 @@
 #include "foedus/cache/fwd.hpp"
 #include "foedus/memory/aligned_memory.hpp"
 #include "foedus/memory/page_pool.hpp"
+#include "foedus/storage/storage_id.hpp"
 
 namespace foedus {
 namespace cache {
@@ -40,6 +41,11 @@ namespace cache {
  * @par Eviction Policy
  * So far we use a simple CLOCK algorithm to minimize the overhead, especially synchronization
  * overhead.
+ *
+ * @par Hot List
+ * When CacheOptions::snapshot_cache_persist_hot_list_ is on, the cleaner thread also dumps
+ * a list of snapshot page IDs in the cache, hottest first, and the next engine prefetches them
+ * at startup. The file is simply a header (HotListHeader) followed by SnapshotPagePointer array.
  */
 class CacheManagerPimpl final : public DefaultInitializable {
  public:
@@ -60,6 +66,32 @@ class CacheManagerPimpl final : public DefaultInitializable {
 
   ErrorStack  stop_cleaner();
 
+  /** Header of the hot list file. */
+  struct HotListHeader {
+    /** A magic word to detect a broken or foreign file. */
+    uint64_t  magic_word_;
+    /** Number of SnapshotPagePointer that follow. */
+    uint64_t  page_count_;
+  };
+  /** Magic word in HotListHeader. */
+  static const uint64_t kHotListMagicWord = 0x31544F48454843ULL;  // "CHEHOT1"
+  /** Max number of contiguous pages to read in one I/O while prefetching. */
+  static const uint16_t kMaxPrefetchRunPages = 64;
+
+  /** Full path of the hot list file of this node. */
+  std::string get_hot_list_path() const;
+  /**
+   * Writes out the snapshot page IDs currently in the cache, ranked by their refcounts.
+   * Called only by the cleaner thread (or after it stopped) not to race with eviction.
+   */
+  ErrorStack  dump_hot_list();
+  /**
+   * Reads the hot list left by the previous engine and installs the pages to the cache
+   * in the order of file offsets, reading contiguous pages in one sequential I/O.
+   * This stops when the cache reaches cleaner_threshold_ or the cleaner is requested to stop.
+   */
+  ErrorStack  prefetch_hot_list();
+
   Engine* const     engine_;
 
   /**
@@ -110,6 +142,9 @@ class CacheManagerPimpl final : public DefaultInitializable {
 
   /** Number of pages buffered so far. */
   uint64_t  reclaimed_pages_count_;
+
+  /** Buffer for CacheHashtable::collect_hot_entries(). Allocated only when hot list is on. */
+  memory::AlignedMemory hot_entries_memory_;
 };
 }  // namespace cache
 }  // namespace foedus
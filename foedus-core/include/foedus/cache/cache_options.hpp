@@ -17,8 +17,13 @@
  */
 #ifndef FOEDUS_CACHE_CACHE_OPTIONS_HPP_
 #define FOEDUS_CACHE_CACHE_OPTIONS_HPP_
+#include <stdint.h>
+
+#include <string>
+
 #include "foedus/cxx11.hpp"
 #include "foedus/externalize/externalizable.hpp"
+#include "foedus/fs/filesystem.hpp"
 namespace foedus {
 namespace cache {
 /**
@@ -31,6 +36,8 @@ struct CacheOptions CXX11_FINAL : public virtual externalize::Externalizable {
   enum Constants {
     /** Default value for snapshot_cache_size_mb_per_node_. */
     kDefaultSnapshotCacheSizeMbPerNode = 1 << 10,
+    /** Default value for snapshot_cache_hot_list_interval_ms_. */
+    kDefaultSnapshotCacheHotListIntervalMs = 60000,
   };
 
   /**
@@ -95,6 +102,40 @@ struct CacheOptions CXX11_FINAL : public virtual externalize::Externalizable {
    */
   float       snapshot_cache_urgent_threshold_;
 
+  /**
+   * @brief Whether to periodically persist the IDs of hot snapshot pages and prefetch them
+   * when the engine starts up.
+   * @details
+   * When this is true, the cleaner thread of each node occasionally dumps the snapshot page IDs
+   * currently in the cache, ranked by their CLOCK reference counts, to a file.
+   * The next engine reads the file at startup and loads the pages into the cache in the order
+   * of file offsets with large sequential reads. The prefetch runs in the cleaner thread
+   * concurrently with transactions, so it never delays the startup.
+   * The list is just a hint. Pages of removed snapshot files are silently skipped.
+   * Default is false.
+   */
+  bool        snapshot_cache_persist_hot_list_;
+
+  /**
+   * @brief String pattern of the full path of the file to persist hot snapshot page IDs.
+   * @details
+   * A special placeholder $NODE$ will be replaced with the NUMA node number.
+   * The default value is "snapshots/node_$NODE$/hot_pages.bin".
+   * Used only when snapshot_cache_persist_hot_list_ is true.
+   */
+  fs::FixedPath snapshot_cache_hot_list_path_pattern_;
+
+  /**
+   * @brief Interval in milliseconds to dump the hot snapshot page IDs.
+   * @details
+   * The list is also dumped when the engine shuts down. Default is 60 seconds.
+   * Used only when snapshot_cache_persist_hot_list_ is true.
+   */
+  uint32_t    snapshot_cache_hot_list_interval_ms_;
+
+  /** converts snapshot_cache_hot_list_path_pattern_ into a string with the given node. */
+  std::string convert_hot_list_path_pattern(int node) const;
+
   EXTERNALIZABLE(CacheOptions);
 };
 }  // namespace cache
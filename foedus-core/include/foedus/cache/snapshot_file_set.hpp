@@ -20,6 +20,7 @@
 
 #include <iosfwd>
 #include <map>
+#include <utility>
 
 #include "foedus/cxx11.hpp"
 #include "foedus/fwd.hpp"
@@ -36,7 +37,9 @@ namespace cache {
  * @brief Holds a set of read-only file objects for snapshot files.
  * @ingroup CACHE
  * @details
- * In essense, this is a map<snapshot_id, map<node_id, DirectIoFile*> >.
+ * In essense, this is a map<snapshot_id, map<(node_id, shard), DirectIoFile*> >.
+ * Shards other than 0 exist only when the node's reducer composed pages with more than one
+ * thread (see snapshot::SnapshotOptions::log_reducer_composers_).
  * Each \b thread memory internally maintains this file set.
  * This is because DirectIoFile (or underlying linux read()) cannot be concurrently used.
  * Each thread thus obtains its own file descriptors using this object.
@@ -66,22 +69,38 @@ class SnapshotFileSet CXX11_FINAL : public DefaultInitializable {
     snapshot::SnapshotId snapshot_id
       = storage::extract_snapshot_id_from_snapshot_pointer(page_pointer);
     thread::ThreadGroupId node_id = storage::extract_numa_node_from_snapshot_pointer(page_pointer);
-    return get_or_open_file(snapshot_id, node_id, out);
+    uint8_t shard = storage::extract_shard_from_local_page_id(
+      storage::extract_local_page_id_from_snapshot_pointer(page_pointer));
+    return get_or_open_file(snapshot_id, node_id, shard, out);
   }
   ErrorCode get_or_open_file(
     snapshot::SnapshotId snapshot_id,
     thread::ThreadGroupId node_id,
+    uint8_t shard,
     fs::DirectIoFile** out);
 
+  /** Returns the byte offset of the page in the file returned by get_or_open_file(). */
+  static uint64_t get_file_offset(storage::SnapshotPagePointer page_pointer) {
+    return storage::extract_shard_offset_from_local_page_id(
+      storage::extract_local_page_id_from_snapshot_pointer(page_pointer)) * storage::kPageSize;
+  }
+
   ErrorCode read_page(storage::SnapshotPagePointer page_id, void* out);
   /** Read contiguous pages in one shot */
   ErrorCode read_pages(storage::SnapshotPagePointer page_id_begin, uint32_t page_count, void* out);
+  /** Read contiguous pages in one shot into page buffers that are not contiguous */
+  ErrorCode read_pages_scattered(
+    storage::SnapshotPagePointer page_id_begin,
+    uint32_t page_count,
+    void* const* outs);
 
   friend std::ostream&    operator<<(std::ostream& o, const SnapshotFileSet& v);
 
  private:
   Engine* const engine_;
-  std::map<snapshot::SnapshotId, std::map< thread::ThreadGroupId, fs::DirectIoFile* > > files_;
+  /** (node_id, shard) */
+  typedef std::pair<thread::ThreadGroupId, uint8_t> FileKey;
+  std::map<snapshot::SnapshotId, std::map< FileKey, fs::DirectIoFile* > > files_;
 };
 }  // namespace cache
 }  // namespace foedus
@@ -24,8 +24,11 @@
  */
 namespace foedus {
 namespace debugging {
+class   ArrivalSchedule;
 class   DebuggingSupports;
 struct  DebuggingOptions;
+class   DurableLatencyRecorder;
+class   LatencyHistogram;
 }  // namespace debugging
 }  // namespace foedus
 #endif  // FOEDUS_DEBUGGING_FWD_HPP_
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#ifndef FOEDUS_DEBUGGING_LATENCY_HISTOGRAM_HPP_
+#define FOEDUS_DEBUGGING_LATENCY_HISTOGRAM_HPP_
+
+#include <stdint.h>
+
+#include <iosfwd>
+
+#include "foedus/compiler.hpp"
+
+namespace foedus {
+namespace debugging {
+/**
+ * @brief A fixed-size latency histogram with HDR-style log-linear buckets.
+ * @ingroup DEBUGGING
+ * @details
+ * Values are nanoseconds. Values below kSubBucketCount have their own bucket, and each
+ * power-of-two range above it is split into kSubBucketCount / 2 linear buckets, so any
+ * recorded value is reported within 1/32 (about 3%) relative error. Values of
+ * 2^kMaxValueBits ns (about 18 minutes) or more are clamped to the last bucket.
+ *
+ * This is a POD without pointers so that it can be placed in shared memory, such as the
+ * output buffer of an impersonated task, and copied with memcpy. Only one thread should
+ * record to it. Other threads (or processes) might read it while it is being recorded to,
+ * which gives a slightly stale but usable view. Use subtract() on two copies of a
+ * cumulative histogram to get the histogram of the interval between them.
+ */
+class LatencyHistogram {
+ public:
+  enum Constants {
+    kSubBucketBits = 6,
+    kSubBucketCount = 1 << kSubBucketBits,
+    kHalfSubBucketCount = kSubBucketCount / 2,
+    kMaxValueBits = 40,
+    kBucketCount = (kMaxValueBits - kSubBucketBits + 2) * kHalfSubBucketCount,
+  };
+
+  LatencyHistogram() { clear(); }
+
+  void      clear();
+  void      record(uint64_t nanoseconds) ALWAYS_INLINE {
+    ++buckets_[to_bucket(nanoseconds)];
+    ++count_;
+    total_nanoseconds_ += nanoseconds;
+  }
+
+  uint64_t  get_count() const { return count_; }
+  uint64_t  get_total_nanoseconds() const { return total_nanoseconds_; }
+  double    get_mean_nanoseconds() const {
+    return count_ == 0 ? 0 : static_cast<double>(total_nanoseconds_) / count_;
+  }
+  /**
+   * Returns the value at the given percentile (0 < percentile <= 100), or 0 if empty.
+   * Like HdrHistogram, this is the highest value that falls in the same bucket.
+   */
+  uint64_t  get_percentile_nanoseconds(double percentile) const;
+  uint64_t  get_max_nanoseconds() const { return get_percentile_nanoseconds(100.0); }
+
+  /** Adds all values recorded in the other histogram to this histogram. */
+  void      merge(const LatencyHistogram& other);
+  /**
+   * Removes values in an older copy of this histogram, leaving only values recorded since then.
+   * Buckets that would become negative because of racy copies are set to zero.
+   */
+  void      subtract(const LatencyHistogram& older);
+
+  /**
+   * Writes a JSON object of the count, mean, max, and common percentiles in microseconds:
+   * {"count":..,"mean_us":..,"p50_us":..,"p90_us":..,"p99_us":..,"p999_us":..,"p9999_us":..,
+   * "max_us":..}
+   */
+  void      write_json(std::ostream* o) const;
+
+  static uint32_t to_bucket(uint64_t nanoseconds) ALWAYS_INLINE {
+    if (nanoseconds < static_cast<uint64_t>(kSubBucketCount)) {
+      return nanoseconds;
+    } else if (UNLIKELY(nanoseconds >> kMaxValueBits)) {
+      return kBucketCount - 1;
+    }
+    const uint32_t msb = 63U - __builtin_clzll(nanoseconds);
+    const uint32_t shift = msb - (kSubBucketBits - 1);
+    return shift * kHalfSubBucketCount + (nanoseconds >> shift);
+  }
+  /** Smallest value that falls in the bucket. */
+  static uint64_t bucket_lowest_value(uint32_t bucket);
+  /** Largest value that falls in the bucket. */
+  static uint64_t bucket_highest_value(uint32_t bucket);
+
+  friend std::ostream& operator<<(std::ostream& o, const LatencyHistogram& v);
+
+ private:
+  uint64_t  count_;
+  uint64_t  total_nanoseconds_;
+  uint64_t  buckets_[kBucketCount];
+};
+
+}  // namespace debugging
+}  // namespace foedus
+
+#endif  // FOEDUS_DEBUGGING_LATENCY_HISTOGRAM_HPP_
@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#ifndef FOEDUS_DEBUGGING_OPEN_LOOP_HPP_
+#define FOEDUS_DEBUGGING_OPEN_LOOP_HPP_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <vector>
+
+#include "foedus/cxx11.hpp"
+#include "foedus/epoch.hpp"
+#include "foedus/fwd.hpp"
+#include "foedus/assorted/uniform_random.hpp"
+#include "foedus/debugging/latency_histogram.hpp"
+
+/**
+ * @file foedus/debugging/open_loop.hpp
+ * @brief Helpers to drive a benchmark in open-loop and measure its latency.
+ * @ingroup DEBUGGING
+ * @details
+ * A closed-loop worker issues the next transaction only after the previous one finishes,
+ * so a stall delays the following requests without counting them as slow (coordinated
+ * omission). An open-loop worker instead has a schedule of intended start times that does not
+ * depend on the system, and measures each latency from its intended start time.
+ */
+namespace foedus {
+namespace debugging {
+
+/** Returns nanoseconds of a monotonic clock. Comparable between threads and processes. */
+uint64_t get_monotonic_nanoseconds();
+
+/**
+ * @brief The schedule of intended start times of an open-loop worker.
+ * @ingroup DEBUGGING
+ */
+class ArrivalSchedule {
+ public:
+  enum Type {
+    /** Arrivals at a fixed interval. */
+    kFixed = 0,
+    /** Poisson arrivals, i.e., exponentially distributed intervals. */
+    kPoisson,
+  };
+
+  /**
+   * @param[in] type distribution of intervals
+   * @param[in] per_second average number of arrivals per second. must be positive.
+   * @param[in] seed random seed for Poisson arrivals
+   */
+  ArrivalSchedule(Type type, double per_second, uint64_t seed);
+
+  /** Starts the schedule with the first arrival at now. */
+  void      start(uint64_t now_nanoseconds) { next_arrival_ = now_nanoseconds; }
+  /** The intended start time of the next arrival. */
+  uint64_t  get_next_arrival() const { return next_arrival_; }
+  /** Returns the intended start time of the next arrival and moves on to the one after it. */
+  uint64_t  pop_arrival();
+
+ private:
+  const Type    type_;
+  const double  mean_interval_nanoseconds_;
+  assorted::UniformRandom rnd_;
+  uint64_t      next_arrival_;
+};
+
+/**
+ * @brief Records latencies of committed transactions including the wait for durability.
+ * @ingroup DEBUGGING
+ * @details
+ * A transaction's response is not sent until its commit epoch becomes durable. Instead of
+ * blocking on each transaction like XctManager::wait_for_commit(), this remembers
+ * committed transactions in a FIFO queue and records each of them to the histogram
+ * of its type once its epoch becomes durable, which is how a server pipelines group commit.
+ * Call complete_durable() frequently, e.g., before each transaction and while idle.
+ * This object is not thread-safe. Use one per worker.
+ */
+class DurableLatencyRecorder CXX11_FINAL {
+ public:
+  enum Constants {
+    kDefaultMaxPending = 1 << 16,
+  };
+
+  /**
+   * @param[in] engine the engine the transactions run in
+   * @param[in] histograms one histogram per transaction type
+   * @param[in] max_pending when this many transactions wait for durability, on_commit()
+   * waits until the oldest of them becomes durable.
+   */
+  DurableLatencyRecorder(
+    Engine* engine,
+    LatencyHistogram* histograms,
+    uint32_t max_pending = kDefaultMaxPending);
+
+  /**
+   * Notifies a finished transaction.
+   * @param[in] type index of the histogram to record to
+   * @param[in] intended_start when the transaction was supposed to start
+   * @param[in] commit_epoch the commit epoch. If invalid (e.g., rolled back), the latency is
+   * recorded immediately.
+   */
+  void      on_commit(uint16_t type, uint64_t intended_start, Epoch commit_epoch);
+  /** Records all pending transactions whose commit epochs are durable. */
+  void      complete_durable();
+  /** Waits for all pending transactions to be durable, then records them. */
+  void      complete_all();
+  /**
+   * Waits until the given time, e.g., the next arrival, while completing durable transactions.
+   * Returns early if stop_requested becomes true.
+   */
+  void      wait_until(uint64_t until_nanoseconds, const std::atomic<bool>* stop_requested);
+  uint32_t  get_pending_count() const { return pending_count_; }
+
+ private:
+  struct Pending {
+    uint64_t  intended_start_;
+    Epoch     commit_epoch_;
+    uint16_t  type_;
+  };
+
+  void      pop_front(uint64_t now);
+
+  Engine* const           engine_;
+  LatencyHistogram* const histograms_;
+  /** Ring buffer of pending transactions */
+  std::vector<Pending>    pending_;
+  uint32_t                pending_head_;
+  uint32_t                pending_count_;
+};
+
+}  // namespace debugging
+}  // namespace foedus
+
+#endif  // FOEDUS_DEBUGGING_OPEN_LOOP_HPP_
@@ -115,6 +115,22 @@ class DirectIoFile {
   ErrorCode       read(uint64_t desired_bytes, const foedus::memory::AlignedMemorySlice& slice);
   /** A version that receives a raw pointer that has to be aligned (be careful to use this ver). */
   ErrorCode       read_raw(uint64_t desired_bytes, void* buffer);
+  /**
+   * @brief Reads a contiguous region of the file into non-contiguous buffers in one shot.
+   * @param[in] file_offset Byte position in the file to start reading from.
+   * @param[in] buffer_count Number of buffers
+   * @param[in] bytes_per_buffer Bytes to read into each buffer.
+   * @param[out] buffers Memory to copy into. As this is Direct-IO, each must be aligned.
+   * @details
+   * This is a positional read (preadv), so it does not use or change the current position.
+   * Useful to read consecutive pages into pages of a page pool, which are not contiguous.
+   * @pre is_opened()
+   */
+  ErrorCode       read_raw_scattered(
+    uint64_t file_offset,
+    uint32_t buffer_count,
+    uint64_t bytes_per_buffer,
+    void* const* buffers);
 
   /**
    * @brief Sequentially write the given amount of contents from the current position.
@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#ifndef FOEDUS_LOG_CHANGE_STREAM_HPP_
+#define FOEDUS_LOG_CHANGE_STREAM_HPP_
+#include <stdint.h>
+
+#include <iosfwd>
+#include <vector>
+
+#include "foedus/cxx11.hpp"
+#include "foedus/epoch.hpp"
+#include "foedus/error_stack.hpp"
+#include "foedus/fwd.hpp"
+#include "foedus/log/common_log_types.hpp"
+#include "foedus/log/fwd.hpp"
+#include "foedus/log/log_id.hpp"
+#include "foedus/log/log_type.hpp"
+#include "foedus/storage/storage_id.hpp"
+#include "foedus/xct/xct_id.hpp"
+
+namespace foedus {
+namespace log {
+/**
+ * @brief One committed change delivered by ChangeStream.
+ * @ingroup LOG
+ * @details
+ * This points to a copy of the log entry in the ChangeBatch, so it is valid until the batch
+ * is reused. Use log_type_invoke.hpp (e.g. invoke_ostream()) or cast to the concrete log type
+ * of get_type() to decode it.
+ */
+struct ChangeRecord {
+  /** The log entry exactly as the logger wrote it. */
+  const RecordLogType*  log_;
+  /** The logger that wrote the log entry. */
+  LoggerId              logger_id_;
+
+  xct::XctId          get_xct_id() const { return log_->header_.xct_id_; }
+  Epoch               get_epoch() const { return log_->header_.xct_id_.get_epoch(); }
+  storage::StorageId  get_storage_id() const { return log_->header_.storage_id_; }
+  LogCode             get_type() const { return log_->header_.get_type(); }
+  const char*         get_type_name() const { return get_log_type_name(get_type()); }
+
+  /** Writes out the content of the log entry via invoke_ostream(). */
+  friend std::ostream&  operator<<(std::ostream& o, const ChangeRecord& v);
+};
+
+/**
+ * @brief A batch of committed changes in the epochs (get_from_epoch(), get_until_epoch()].
+ * @ingroup LOG
+ * @details
+ * Records are in serialization order, namely ordered by their XctId (epoch, then in-epoch
+ * ordinal). Logs of one transaction keep the order they were written.
+ * Reuse one batch object for many fetches to avoid memory allocations.
+ */
+class ChangeBatch CXX11_FINAL {
+ public:
+  ChangeBatch() {}
+
+  /** Exclusive beginning of the epochs in this batch. */
+  Epoch                 get_from_epoch() const { return from_epoch_; }
+  /** Inclusive end of the epochs in this batch. Same as get_from_epoch() if nothing fetched. */
+  Epoch                 get_until_epoch() const { return until_epoch_; }
+  uint32_t              get_record_count() const { return records_.size(); }
+  bool                  is_empty() const { return records_.empty(); }
+  const ChangeRecord&   get_record(uint32_t index) const { return records_[index]; }
+  /** Total bytes of the log entries in this batch. */
+  uint64_t              get_bytes() const { return data_.size() * sizeof(uint64_t); }
+
+ private:
+  friend class ChangeStreamPimpl;
+  Epoch                     from_epoch_;
+  Epoch                     until_epoch_;
+  /** Copies of the log entries. 8-byte aligned because all log lengths are. */
+  std::vector<uint64_t>     data_;
+  std::vector<ChangeRecord> records_;
+};
+
+/**
+ * @brief Change-data-capture feed of committed record modifications.
+ * @ingroup LOG
+ * @details
+ * A consumer subscribes to storages and repeatedly calls fetch() to receive the record logs
+ * of those storages in epoch order. Only durable epochs are delivered, so everything delivered
+ * is committed and survives crashes. A ChangeStream remembers the last epoch it delivered.
+ *
+ * @par How it works
+ * fetch() reads the log files each logger has made durable, locating the region of each
+ * epoch from the loggers' epoch histories just like log gleaner's mappers do.
+ * It never touches the log buffers, so consumers never make loggers or transactions wait.
+ *
+ * @par Backpressure and batching
+ * It is pull-based. A slow consumer simply fetches older epochs later while the engine keeps
+ * running; log files are not recycled. Each fetch() delivers whole epochs, up to
+ * set_max_batch_epochs() epochs and stops at the first epoch that makes the batch exceed
+ * set_max_batch_bytes(), so one batch contains at least one epoch even if it is larger.
+ *
+ * @par Limitations
+ * Only record logs (kRecordLogs) are delivered. Storage creation/drop are written to the
+ * metadata log, which is not part of this feed. Epoch histories are volatile, so a stream
+ * can go back at most to the latest snapshot epoch after a restart.
+ *
+ * This object is not thread-safe. Use one per consumer.
+ */
+class ChangeStream CXX11_FINAL {
+ public:
+  /**
+   * @param[in] engine the engine to capture changes of. must be initialized while fetching.
+   * @param[in] start_after the stream delivers epochs after this epoch.
+   * If invalid, it starts from the current durable epoch, delivering only future changes.
+   */
+  ChangeStream(Engine* engine, Epoch start_after);
+  ~ChangeStream();
+
+  ChangeStream() CXX11_FUNC_DELETE;
+  ChangeStream(const ChangeStream&) CXX11_FUNC_DELETE;
+  ChangeStream& operator=(const ChangeStream&) CXX11_FUNC_DELETE;
+
+  /** Adds a storage to receive changes of. Without any subscription, all storages. */
+  void        subscribe(storage::StorageId storage_id);
+  void        set_max_batch_epochs(uint32_t epochs);
+  void        set_max_batch_bytes(uint64_t bytes);
+
+  /**
+   * @brief Fetches changes in durable epochs not delivered yet.
+   * @param[out] batch receives the changes. its previous content is discarded.
+   * @param[in] wait_microseconds If there is no new durable epoch, wait at most this long.
+   * Negative value means waiting forever, 0 means immediately returning.
+   * @details
+   * On timeout, this returns kRetOk with an empty batch whose from/until epochs are the same.
+   * An empty batch with from < until means the epochs had no changes to the subscribed storages.
+   */
+  ErrorStack  fetch(ChangeBatch* batch, int64_t wait_microseconds);
+
+  /** The last epoch delivered. */
+  Epoch       get_consumed_epoch() const;
+
+ private:
+  ChangeStreamPimpl* pimpl_;
+};
+
+}  // namespace log
+}  // namespace foedus
+#endif  // FOEDUS_LOG_CHANGE_STREAM_HPP_
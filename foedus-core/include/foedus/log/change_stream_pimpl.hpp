@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#ifndef FOEDUS_LOG_CHANGE_STREAM_PIMPL_HPP_
+#define FOEDUS_LOG_CHANGE_STREAM_PIMPL_HPP_
+#include <stdint.h>
+
+#include <utility>
+#include <vector>
+
+#include "foedus/epoch.hpp"
+#include "foedus/error_stack.hpp"
+#include "foedus/fwd.hpp"
+#include "foedus/log/change_stream.hpp"
+#include "foedus/log/fwd.hpp"
+#include "foedus/log/log_id.hpp"
+#include "foedus/storage/storage_id.hpp"
+
+namespace foedus {
+namespace log {
+/**
+ * @brief Pimpl object of ChangeStream.
+ * @ingroup LOG
+ * @details
+ * A private pimpl object for ChangeStream.
+ * Do not include this header from a client program unless you know what you are doing.
+ */
+class ChangeStreamPimpl final {
+ public:
+  enum Constants {
+    /** Size of the buffer to read log files. Must be larger than the largest log entry. */
+    kReadBufferSize = 1 << 20,
+    kDefaultMaxBatchEpochs = 64,
+    kDefaultMaxBatchBytes = 16 << 20,
+  };
+
+  ChangeStreamPimpl(Engine* engine, Epoch start_after);
+
+  ChangeStreamPimpl() = delete;
+  ChangeStreamPimpl(const ChangeStreamPimpl&) = delete;
+  ChangeStreamPimpl& operator=(const ChangeStreamPimpl&) = delete;
+
+  ErrorStack  fetch(ChangeBatch* batch, int64_t wait_microseconds);
+  /** Appends the subscribed record logs the logger wrote in the given epoch to the batch. */
+  ErrorStack  read_epoch(LoggerId logger_id, Epoch epoch, ChangeBatch* batch);
+  /** Appends the subscribed record logs in the given range of a log file to the batch. */
+  ErrorStack  read_file_range(
+    LoggerId logger_id,
+    LogFileOrdinal ordinal,
+    uint64_t begin_offset,
+    uint64_t end_offset,
+    ChangeBatch* batch);
+  bool        is_subscribed(storage::StorageId storage_id) const;
+  /** Sorts the records of the batch in serialization order and sets their pointers. */
+  void        finalize_batch(ChangeBatch* batch);
+
+  Engine* const                     engine_;
+  /** Sorted. Empty means all storages. */
+  std::vector<storage::StorageId>   subscriptions_;
+  uint32_t                          max_batch_epochs_;
+  uint64_t                          max_batch_bytes_;
+  Epoch                             consumed_epoch_;
+  std::vector<char>                 read_buffer_;
+  /** Word offset in ChangeBatch::data_ and logger of each record until finalize_batch(). */
+  std::vector< std::pair<uint64_t, LoggerId> >  pending_;
+};
+
+}  // namespace log
+}  // namespace foedus
+#endif  // FOEDUS_LOG_CHANGE_STREAM_PIMPL_HPP_
@@ -25,21 +25,33 @@
 namespace foedus {
 namespace log {
 struct  BaseLogType;
+class   ChangeBatch;
+struct  ChangeRecord;
+class   ChangeStream;
+class   ChangeStreamPimpl;
+class   DirectIoLogSink;
 struct  EngineLogType;
 struct  EpochHistory;
 struct  EpochMarkerLogType;
 struct  FillerLogType;
 struct  LogHeader;
+struct  LogStripeLayout;
 class   LogManager;
 struct  LogManagerControlBlock;
 class   LogManagerPimpl;
+class   LogSink;
 struct  LogOptions;
+class   LogShipper;
+class   LogShipperPimpl;
 class   Logger;
 class   LoggerRef;
 struct  LoggerControlBlock;
 class   MetaLogBuffer;
 struct  MetaLogControlBlock;
 class   MetaLogger;
+class   MmapLogSink;
+class   StripedLogFile;
+class   StripedLogSink;
 struct  RecordLogType;
 struct  StorageLogType;
 struct  ThreadEpockMark;
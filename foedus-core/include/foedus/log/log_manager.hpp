@@ -54,6 +54,17 @@ class LogManager CXX11_FINAL : public virtual Initializable {
    */
   void        copy_logger_states(savepoint::Savepoint *new_savepoint);
 
+  /**
+   * @brief Fillup the given savepoint with where each logger's logs after the given
+   * snapshot epoch begin.
+   * @pre copy_logger_states() was called for the savepoint.
+   * @details
+   * This is called as a part of taking a savepoint right after a new snapshot.
+   */
+  void        copy_logger_snapshot_positions(
+    Epoch snapshot_epoch,
+    savepoint::Savepoint *new_savepoint);
+
   /**
    * @brief Wake up loggers if they are sleeping.
    * @details
@@ -87,6 +87,9 @@ class LogManagerPimpl final : public DefaultInitializable {
   ErrorCode   wait_until_durable(Epoch commit_epoch, int64_t wait_microseconds);
   ErrorStack  refresh_global_durable_epoch();
   void        copy_logger_states(savepoint::Savepoint *new_savepoint);
+  void        copy_logger_snapshot_positions(
+    Epoch snapshot_epoch,
+    savepoint::Savepoint *new_savepoint);
 
   Epoch       get_durable_global_epoch() const {
     return Epoch(control_block_->durable_global_epoch_.load());
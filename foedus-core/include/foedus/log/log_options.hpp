@@ -43,6 +43,15 @@ struct LogOptions CXX11_FINAL : public virtual externalize::Externalizable {
     kDefaultLogBufferKb = (1 << 16),
     /** Default value for log_file_size_mb_. */
     kDefaultLogSizeMb = (1 << 14),
+    /** Default value for log_stripe_unit_kb_. */
+    kDefaultLogStripeUnitKb = (1 << 10),
+  };
+  /** Types of LogSink loggers write out to. */
+  enum LogSinkType {
+    /** DirectIoLogSink, which writes out with direct I/O and fsync. Default. */
+    kLogSinkDirectIo = 0,
+    /** MmapLogSink, which copies to memory-mapped log files with non-temporal stores. */
+    kLogSinkMmap = 1,
   };
   /**
    * Constructs option values with default values.
@@ -53,9 +62,11 @@ struct LogOptions CXX11_FINAL : public virtual externalize::Externalizable {
    * @brief String pattern of path of log folders in each NUMA node.
    * @details
    * This specifies the path of the folder to contain log file written out in each NUMA node.
-   * Two special placeholders can be used; $NODE$ and $LOGGER$.
+   * Three special placeholders can be used; $NODE$, $LOGGER$, and $STRIPE$.
    * $NODE$ is replaced with the NUMA node number.
    * $LOGGER$ is replaced with the logger index in the node (0 to loggers_per_node_ - 1).
+   * $STRIPE$ is replaced with the stripe index (0 to log_stripes_ - 1), which is
+   * how you place the stripes of a logger on different devices.
    * For example,
    * \li "/log/node_$NODE$/logger_$LOGGER$" becomes "/log/node_1/logger_0" on node-1 and logger-0.
    * \li "/log/logger_$INDEX$" becomes "/log/logger_1" on any node and logger-1.
@@ -79,6 +90,40 @@ struct LogOptions CXX11_FINAL : public virtual externalize::Externalizable {
    */
   uint16_t                    loggers_per_node_;
 
+  /**
+   * @brief Whether loggers in a NUMA node share the work of writing out logs of the node.
+   * @details
+   * By default, each logger writes out logs of a fixed set of worker threads
+   * (thread_count_per_group_ / loggers_per_node_ threads each), so a logger assigned to
+   * threads that emit most of the logs falls behind while other loggers idle.
+   * If true, each logger writes out its own threads' logs first, then claims the logs of
+   * other threads in the node that no logger has claimed yet in the epoch.
+   * Each logger still writes out to its own log files.
+   * Default is false.
+   */
+  bool                        dynamic_logger_assignment_;
+
+  /**
+   * @brief Number of devices each logger stripes its log files across.
+   * @details
+   * When this is larger than 1, a log file is split into units of log_stripe_unit_kb_ that
+   * are placed in stripe files round-robin, like RAID-0. The logger writes out the units
+   * of a large write to the stripes in parallel. Readers of log files (LogMapper etc)
+   * reassemble them, so the log files look like one file to them.
+   * Specify $STRIPE$ in folder_path_pattern_ to place the stripes on different devices.
+   * This value must be at least 1 (which is also default, no striping).
+   * Striping is supported only with kLogSinkDirectIo.
+   */
+  uint16_t                    log_stripes_;
+
+  /**
+   * @brief Size in KB of each stripe unit when log_stripes_ > 1.
+   * @details
+   * Must be a multiple of 4 (the unit of log writes). Default is 1024 (1 MB).
+   * Do not change this value or log_stripes_ while there are log files not snapshotted yet.
+   */
+  uint32_t                    log_stripe_unit_kb_;
+
   /** Size in KB of log buffer for \e each worker thread. */
   uint32_t                    log_buffer_kb_;
 
@@ -100,13 +145,41 @@ struct LogOptions CXX11_FINAL : public virtual externalize::Externalizable {
    */
   bool                        flush_at_shutdown_;
 
-  /** Settings to emulate slower logging device. */
+  /**
+   * @brief Type of LogSink loggers write out to.
+   * @details
+   * kLogSinkMmap is meant for byte-addressable persistent memory (DAX filesystems),
+   * but it works on any filesystem including tmpfs. Log files look the same in either case,
+   * so you can change this option between executions.
+   * Default is kLogSinkDirectIo.
+   */
+  LogSinkType                 sink_type_;
+
+  /**
+   * @brief Whether MmapLogSink maps log files with MAP_SYNC.
+   * @details
+   * On a DAX filesystem, MAP_SYNC guarantees that an sfence after non-temporal stores
+   * is enough for durability, thus we skip msync() altogether.
+   * If the filesystem doesn't support it, we fall back to msync().
+   * Used only when sink_type_ is kLogSinkMmap. Default is false.
+   */
+  bool                        mmap_sink_map_sync_;
+
+  /** Settings to emulate slower logging device. Ignored by kLogSinkMmap. */
   foedus::fs::DeviceEmulationOptions emulation_;
 
   /** converts folder_path_pattern_ into a string with the given IDs. */
-  std::string     convert_folder_path_pattern(int node, int logger) const;
-  /** construct full path of individual log file (log_folder/LOGGERID_ORDINAL.log) */
-  std::string     construct_suffixed_log_path(int node, int logger, LogFileOrdinal ordinal) const;
+  std::string     convert_folder_path_pattern(int node, int logger, int stripe = 0) const;
+  /**
+   * construct full path of individual log file (log_folder/LOGGERID_ORDINAL.log).
+   * When log_stripes_ > 1, stripes other than the first one are
+   * log_folder/LOGGERID_ORDINAL_STRIPE.log.
+   */
+  std::string     construct_suffixed_log_path(
+    int node,
+    int logger,
+    LogFileOrdinal ordinal,
+    int stripe = 0) const;
   /** metadata log file is placed in node-0/logger-0 folder */
   std::string     construct_meta_log_path() const;
 
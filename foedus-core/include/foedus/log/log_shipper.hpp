@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#ifndef FOEDUS_LOG_LOG_SHIPPER_HPP_
+#define FOEDUS_LOG_LOG_SHIPPER_HPP_
+#include <stdint.h>
+
+#include "foedus/cxx11.hpp"
+#include "foedus/epoch.hpp"
+#include "foedus/error_stack.hpp"
+#include "foedus/fwd.hpp"
+#include "foedus/log/fwd.hpp"
+
+namespace foedus {
+namespace log {
+/**
+ * @brief Ships logs and snapshots of a running engine to the folders of a standby engine.
+ * @ingroup LOG
+ * @details
+ * @par Scope
+ * This only copies files. Nothing runs on the standby side while we ship: shipped epochs are
+ * not applied to any volatile pages, the standby does not take its own snapshots, and the
+ * shipped data can't be read until failover. In other words, this keeps a cold standby image,
+ * not a hot standby engine. The transport is the filesystem; there is no network protocol.
+ *
+ * @par What is shipped
+ * Each round reads the savepoint file of the primary engine, which is atomically written,
+ * and copies everything the savepoint refers to into the folders specified by the standby's
+ * EngineOptions: the durable region of each logger's log files, the durable region of the
+ * metadata log, and the snapshot files and snapshot metadata files up to the latest snapshot.
+ * All copies are incremental; a round copies only the bytes appended since the previous round.
+ * Finally, it writes out the primary's savepoint as the standby's savepoint file,
+ * atomically and durably. Hence, the standby's folders always form a consistent image of the
+ * primary as of the shipped durable epoch, which is at most one round behind.
+ *
+ * @par Failover
+ * To fail over, stop shipping and initialize an Engine with the standby options.
+ * That is when the shipped logs are applied, by the usual restart. It recovers only the logs
+ * after the latest shipped snapshot, which the primary's snapshots keep short, rather than
+ * re-reading the whole log history. Still, failover takes as long as a cold restart.
+ * The standby engine must not be running while we ship to it, because each engine owns its
+ * epochs and log files.
+ *
+ * @par Topology
+ * The standby must have the same number of NUMA nodes and loggers per node as the primary.
+ * The folders can be anywhere, such as a shared directory mounted on another machine.
+ *
+ * This object must be used in the master engine. Not thread-safe except get_xxx() methods.
+ */
+class LogShipper CXX11_FINAL {
+ public:
+  /**
+   * @param[in] primary the engine to ship logs from. must be initialized while shipping.
+   * @param[in] standby_options options of the standby engine, which tell where to ship to.
+   */
+  LogShipper(Engine* primary, const EngineOptions& standby_options);
+  /** Stops the background shipper if it is running. */
+  ~LogShipper();
+
+  LogShipper() CXX11_FUNC_DELETE;
+  LogShipper(const LogShipper&) CXX11_FUNC_DELETE;
+  LogShipper& operator=(const LogShipper&) CXX11_FUNC_DELETE;
+
+  /** Ships whatever the primary has made durable since the previous round, synchronously. */
+  ErrorStack  ship_once();
+
+  /** Launches a background thread that calls ship_once() every given milliseconds. */
+  void        start(uint32_t interval_ms);
+  /**
+   * Stops the background thread, if any, after one last round.
+   * @return the first error the background thread encountered, if any.
+   */
+  ErrorStack  stop();
+  bool        is_running() const;
+
+  /** The durable epoch of the image in the standby folders. Invalid if nothing is shipped. */
+  Epoch       get_shipped_epoch() const;
+  /** How many epochs the standby is behind the durable epoch of the primary. */
+  uint32_t    get_lag_epochs() const;
+  /** Total bytes copied so far. */
+  uint64_t    get_shipped_bytes() const;
+
+ private:
+  LogShipperPimpl* pimpl_;
+};
+
+}  // namespace log
+}  // namespace foedus
+#endif  // FOEDUS_LOG_LOG_SHIPPER_HPP_
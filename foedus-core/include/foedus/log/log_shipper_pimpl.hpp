@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#ifndef FOEDUS_LOG_LOG_SHIPPER_PIMPL_HPP_
+#define FOEDUS_LOG_LOG_SHIPPER_PIMPL_HPP_
+#include <stdint.h>
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "foedus/engine_options.hpp"
+#include "foedus/epoch.hpp"
+#include "foedus/error_stack.hpp"
+#include "foedus/fwd.hpp"
+#include "foedus/fs/fwd.hpp"
+#include "foedus/log/fwd.hpp"
+#include "foedus/savepoint/fwd.hpp"
+#include "foedus/snapshot/snapshot_id.hpp"
+
+namespace foedus {
+namespace log {
+/**
+ * @brief Pimpl object of LogShipper.
+ * @ingroup LOG
+ * @details
+ * A private pimpl object for LogShipper.
+ * Do not include this header from a client program unless you know what you are doing.
+ */
+class LogShipperPimpl final {
+ public:
+  /** Size of the buffer to copy files. */
+  enum Constants {
+    kCopyBufferSize = 1 << 20,
+  };
+
+  LogShipperPimpl(Engine* primary, const EngineOptions& standby_options);
+  ~LogShipperPimpl();
+
+  LogShipperPimpl() = delete;
+  LogShipperPimpl(const LogShipperPimpl&) = delete;
+  LogShipperPimpl& operator=(const LogShipperPimpl&) = delete;
+
+  ErrorStack  ship_once();
+  void        start(uint32_t interval_ms);
+  ErrorStack  stop();
+  void        handle_shipper(uint32_t interval_ms);
+
+  /** Ships the durable region of the log files of all loggers. */
+  ErrorStack  ship_logs(const savepoint::Savepoint& savepoint);
+  /** Ships the snapshot files and snapshot metadata files not shipped yet. */
+  ErrorStack  ship_snapshots(const savepoint::Savepoint& savepoint);
+  /**
+   * Makes the destination file the same as the first \e length bytes of the source file.
+   * If the destination is a prefix of it, this copies only the rest. Otherwise, from scratch.
+   */
+  ErrorStack  ship_file(const fs::Path& source, const fs::Path& destination, uint64_t length);
+
+  Engine* const             primary_;
+  const EngineOptions       standby_options_;
+
+  /** Serializes ship_once() between the background thread and the user. */
+  std::mutex                ship_mutex_;
+  std::vector<char>         copy_buffer_;
+  /** The latest snapshot shipped to the standby, including its files in all nodes. */
+  snapshot::SnapshotId      shipped_snapshot_id_;
+  std::atomic<Epoch::EpochInteger>  shipped_epoch_;
+  std::atomic<uint64_t>     shipped_bytes_;
+
+  std::thread               shipper_thread_;
+  std::atomic<bool>         stop_requested_;
+  /** The first error the background thread encountered. */
+  ErrorStack                shipper_error_;
+};
+
+}  // namespace log
+}  // namespace foedus
+#endif  // FOEDUS_LOG_LOG_SHIPPER_PIMPL_HPP_
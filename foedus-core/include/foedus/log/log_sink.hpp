@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#ifndef FOEDUS_LOG_LOG_SINK_HPP_
+#define FOEDUS_LOG_LOG_SINK_HPP_
+#include <stdint.h>
+
+#include <iosfwd>
+#include <vector>
+
+#include "foedus/cxx11.hpp"
+#include "foedus/error_code.hpp"
+#include "foedus/fs/device_emulation_options.hpp"
+#include "foedus/fs/fwd.hpp"
+#include "foedus/fs/path.hpp"
+#include "foedus/log/fwd.hpp"
+#include "foedus/log/log_id.hpp"
+#include "foedus/log/striped_log_file.hpp"
+
+namespace foedus {
+namespace log {
+/**
+ * @brief Where a logger appends its log file.
+ * @ingroup LOG
+ * @details
+ * Logger writes out log entries only through this interface, so that we can switch
+ * the underlying device without touching the logger itself.
+ * Whatever the implementation is, the log file on the filesystem must look exactly the same
+ * once it is closed, so that LogMapper, restart, and foedus-util read it as usual.
+ * While the file is open, its size might be larger than get_current_offset() (see MmapLogSink),
+ * but readers never read beyond the offsets recorded in epoch histories anyway.
+ *
+ * All writes are in multiples of FillerLogType::kLogWriteUnitSize and aligned to it.
+ * Logger calls sync() before announcing a new durable epoch.
+ * This object is used only by the logger thread, thus not thread-safe.
+ */
+class LogSink {
+ public:
+  explicit LogSink(const fs::Path& path) : path_(path) {}
+  virtual ~LogSink() {}
+
+  // non-copyable
+  LogSink(const LogSink& other) CXX11_FUNC_DELETE;
+  LogSink& operator=(const LogSink& other) CXX11_FUNC_DELETE;
+
+  /** Opens or creates the file, setting the current offset to the end of existing logs. */
+  virtual ErrorCode   open() = 0;
+  /** Closes the file, leaving exactly get_current_offset() bytes in it. Idempotent. */
+  virtual void        close() = 0;
+  /** Appends the given bytes at the current offset. */
+  virtual ErrorCode   write(uint64_t desired_bytes, const void* buffer) = 0;
+  /** Makes all bytes written so far durable, including the file's existence in the folder. */
+  virtual ErrorCode   sync() = 0;
+  /** Discards bytes after the given offset and immediately makes it durable. */
+  virtual ErrorCode   truncate(uint64_t new_length) = 0;
+  /** Byte offset to which the next write() appends. */
+  virtual uint64_t    get_current_offset() const = 0;
+  virtual void        describe(std::ostream* o) const = 0;
+
+  const fs::Path&     get_path() const { return path_; }
+
+  friend std::ostream&    operator<<(std::ostream& o, const LogSink& v);
+
+ protected:
+  const fs::Path      path_;
+};
+
+/**
+ * @brief The default log sink that writes out with direct I/O and fsync.
+ * @ingroup LOG
+ * @details
+ * This honors LogOptions::emulation_ to emulate slower devices.
+ */
+class DirectIoLogSink CXX11_FINAL : public LogSink {
+ public:
+  DirectIoLogSink(const fs::Path& path, const fs::DeviceEmulationOptions& emulation);
+  ~DirectIoLogSink();
+
+  ErrorCode   open() CXX11_OVERRIDE;
+  void        close() CXX11_OVERRIDE;
+  ErrorCode   write(uint64_t desired_bytes, const void* buffer) CXX11_OVERRIDE;
+  ErrorCode   sync() CXX11_OVERRIDE;
+  ErrorCode   truncate(uint64_t new_length) CXX11_OVERRIDE;
+  uint64_t    get_current_offset() const CXX11_OVERRIDE;
+  void        describe(std::ostream* o) const CXX11_OVERRIDE;
+
+ private:
+  fs::DirectIoFile*   file_;
+};
+
+/**
+ * @brief A log sink for byte-addressable persistent memory, which memory-maps the log file
+ * and copies log entries to it with non-temporal (streaming) stores.
+ * @ingroup LOG
+ * @details
+ * @par Durability
+ * Streaming stores bypass CPU caches, so an sfence after the copy is enough to make them
+ * durable on a DAX filesystem mapped with MAP_SYNC (LogOptions::mmap_sink_map_sync_).
+ * Unaligned copies instead write back the cachelines before the sfence.
+ * Otherwise (e.g., tmpfs or ordinary filesystems), sync() additionally calls msync() on the
+ * range written since the previous sync, which still avoids the write() system call and
+ * the block layer per write.
+ *
+ * @par Durable-offset header
+ * The file is extended by kExtentSize at a time, so its size is larger than the logs
+ * while it is open. To know where the logs end after a crash, sync() persists the durable
+ * offset to a small header file next to the log file ([log file].header).
+ * When the file is closed, we shrink the file to the exact size of the logs and remove
+ * the header, so that a closed log file is indistinguishable from one written by
+ * DirectIoLogSink.
+ *
+ * This ignores LogOptions::emulation_.
+ */
+class MmapLogSink CXX11_FINAL : public LogSink {
+ public:
+  /** The file is extended by this size at a time. */
+  static const uint64_t kExtentSize = 1ULL << 26;
+  /** Magic word in Header. */
+  static const uint64_t kHeaderMagicWord = 0x5244484B4E4953ULL;  // "SINKHDR"
+
+  /** Content of the header file. */
+  struct Header {
+    uint64_t  magic_word_;
+    /** Bytes of logs durably written to the log file. */
+    uint64_t  durable_offset_;
+  };
+
+  MmapLogSink(const fs::Path& path, bool map_sync);
+  ~MmapLogSink();
+
+  ErrorCode   open() CXX11_OVERRIDE;
+  void        close() CXX11_OVERRIDE;
+  ErrorCode   write(uint64_t desired_bytes, const void* buffer) CXX11_OVERRIDE;
+  ErrorCode   sync() CXX11_OVERRIDE;
+  ErrorCode   truncate(uint64_t new_length) CXX11_OVERRIDE;
+  uint64_t    get_current_offset() const CXX11_OVERRIDE { return current_offset_; }
+  void        describe(std::ostream* o) const CXX11_OVERRIDE;
+
+  /** Returns whether the file is mapped with MAP_SYNC, which needs no msync(). */
+  bool        is_map_synced() const { return map_synced_; }
+
+  /** [log file].header */
+  static fs::Path get_header_path(const fs::Path& path);
+  /**
+   * Copies the memory region with non-temporal stores if both are 16-byte aligned.
+   * Otherwise, this copies with memcpy and then writes back the destination's cachelines
+   * with clflushopt (clflush if not available). Either way, this ends with an sfence, after
+   * which the copy is durable on a MAP_SYNC mapping.
+   * Without SSE2, this is just a memcpy, and we never use MAP_SYNC.
+   */
+  static void     copy_non_temporal(void* destination, const void* source, uint64_t bytes);
+
+ private:
+  /** Maps the file with the given size, extending the file if needed. */
+  ErrorCode   remap(uint64_t new_mapped_size);
+  void        unmap();
+  /** Persists [synced_offset_, current_offset_) and then the header. */
+  ErrorCode   persist(uint64_t from, uint64_t to);
+
+  /** Whether we try to map the file with MAP_SYNC. */
+  const bool  map_sync_;
+  /** Whether the file is actually mapped with MAP_SYNC. */
+  bool        map_synced_;
+  int         descriptor_;
+  int         header_descriptor_;
+  char*       mapped_;
+  uint64_t    mapped_size_;
+  Header*     header_;
+  uint64_t    current_offset_;
+  /** Bytes known to be durable. */
+  uint64_t    synced_offset_;
+};
+
+/**
+ * @brief A log sink that stripes the log file across several files, possibly on different
+ * devices, with direct I/O.
+ * @ingroup LOG
+ * @details
+ * See LogStripeLayout for how the log file is split. A write that spans multiple stripe units
+ * is written to the stripes in parallel, and so is sync(). While the sink is open, each stripe
+ * has its own I/O thread for that. The calling thread takes care of one stripe itself and
+ * hands the others to their threads.
+ * Unlike other sinks, the log file on the filesystem is a set of stripe files, which readers
+ * reassemble with StripedLogFile. get_path() is the path of the first stripe.
+ * This honors LogOptions::emulation_.
+ */
+class StripedLogSink CXX11_FINAL : public LogSink {
+ public:
+  StripedLogSink(
+    const LogOptions& options,
+    int node,
+    LoggerId logger,
+    LogFileOrdinal ordinal);
+  ~StripedLogSink();
+
+  ErrorCode   open() CXX11_OVERRIDE;
+  void        close() CXX11_OVERRIDE;
+  ErrorCode   write(uint64_t desired_bytes, const void* buffer) CXX11_OVERRIDE;
+  ErrorCode   sync() CXX11_OVERRIDE;
+  ErrorCode   truncate(uint64_t new_length) CXX11_OVERRIDE;
+  uint64_t    get_current_offset() const CXX11_OVERRIDE { return current_offset_; }
+  void        describe(std::ostream* o) const CXX11_OVERRIDE;
+
+  const LogStripeLayout& get_layout() const { return layout_; }
+
+ private:
+  /** A persistent I/O thread of one stripe. Defined in the cpp as it needs C++11 threads. */
+  struct StripeWorker;
+
+  /** Writes the segments of [offset, offset + bytes) in the log file that belong to the stripe. */
+  ErrorCode   write_stripe(uint16_t stripe, uint64_t offset, uint64_t bytes, const char* buffer);
+  /** fsync the stripe file and its parent folder. */
+  ErrorCode   sync_stripe(uint16_t stripe);
+  void        stop_workers();
+
+  const LogStripeLayout           layout_;
+  std::vector< fs::DirectIoFile* > files_;
+  /** Index is the stripe. Empty while the sink is closed. */
+  std::vector< StripeWorker* >    workers_;
+  uint64_t                        current_offset_;
+};
+
+/** Instantiates a log sink specified in the options. The caller must delete it. */
+LogSink* create_log_sink(const LogOptions& options, const fs::Path& path);
+/**
+ * Instantiates a log sink for the specified log file of a logger.
+ * This returns StripedLogSink if LogOptions::log_stripes_ > 1. The caller must delete it.
+ */
+LogSink* create_log_sink(
+  const LogOptions& options,
+  int node,
+  LoggerId logger,
+  LogFileOrdinal ordinal);
+
+}  // namespace log
+}  // namespace foedus
+#endif  // FOEDUS_LOG_LOG_SINK_HPP_
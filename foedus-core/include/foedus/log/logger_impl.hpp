@@ -61,12 +61,19 @@ struct LoggerControlBlock {
   LoggerControlBlock() = delete;
   ~LoggerControlBlock() = delete;
 
-  void initialize() {
+  /**
+   * @param[in] retain_epoch_history whether to keep the epoch histories left in the shared
+   * memory. True only in warm restart, where the logs written by the previous engine are
+   * not yet snapshotted, so the next log gleaning needs their epoch histories.
+   */
+  void initialize(bool retain_epoch_history) {
     wakeup_cond_.initialize();
     epoch_history_mutex_.initialize();
     stop_requested_ = false;
-    epoch_history_head_ = 0;
-    epoch_history_count_ = 0;
+    if (!retain_epoch_history) {
+      epoch_history_head_ = 0;
+      epoch_history_count_ = 0;
+    }
   }
   void uninitialize() {
     epoch_history_mutex_.uninitialize();
@@ -236,6 +243,20 @@ class Logger final : public DefaultInitializable, public LoggerRef {
    */
   ErrorStack  write_dummy_epoch_mark();
 
+  /**
+   * Called on warm restart to resume the epoch histories the previous engine left in the
+   * retained shared memory, discarding histories beyond the durable region.
+   */
+  void        retain_epoch_history();
+
+  /**
+   * Called on cold restart to tell where the logs after the latest snapshot begin.
+   * Epoch histories are lost in cold restart, so we put an epoch history that spans from the
+   * snapshot epoch to the durable epoch at the position recorded in the savepoint.
+   * Otherwise, the recovery gleaner would start reading from the end of the log file.
+   */
+  void        seed_snapshot_epoch_history(const savepoint::LoggerSavepointInfo& info);
+
   /**
    * Write out all logs in all buffers for the given epoch.
    * @pre write_epoch == logger's durable_epoch + 1
@@ -243,6 +264,18 @@ class Logger final : public DefaultInitializable, public LoggerRef {
    * @post logger's durable_epoch is updated to write_epoch if this method successfully returns
    */
   ErrorStack  write_one_epoch(Epoch write_epoch);
+  /**
+   * Sub-routine of write_one_epoch().
+   * Writes out all logs of the given buffer in the given epoch.
+   * @param[in,out] buffer the log buffer of a thread
+   * @param[in] write_epoch the epoch to write out
+   * @param[in,out] had_any_log whether we have written out any log in this epoch.
+   * We write out an epoch mark when this turns to true.
+   */
+  ErrorStack  write_one_epoch_thread(
+    ThreadLogBuffer* buffer,
+    Epoch write_epoch,
+    bool* had_any_log);
   /**
    * Sub-routine of write_one_epoch().
    * Writes out the given piece of the given buffer.
@@ -282,14 +315,21 @@ class Logger final : public DefaultInitializable, public LoggerRef {
 
   /**
    * @brief The log file this logger is currently appending to.
+   * @details
+   * The type of sink is determined by LogOptions::sink_type_.
    */
-  fs::DirectIoFile*               current_file_;
+  LogSink*                        current_file_;
   /**
    * [log_folder_]/[id_]_[current_ordinal_].log.
    */
   fs::Path                        current_file_path_;
 
   std::vector< thread::Thread* >  assigned_threads_;
+  /**
+   * Other threads in the same node, whose logs we write out when no other logger has claimed
+   * them. Empty unless LogOptions::dynamic_logger_assignment_ is on.
+   */
+  std::vector< thread::Thread* >  other_threads_;
 
   /** protects log_epoch_switch() from concurrent accesses. */
   std::mutex                      epoch_switch_mutex_;
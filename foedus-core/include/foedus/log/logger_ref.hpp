@@ -61,6 +61,14 @@ class LoggerRef : public Attachable<LoggerControlBlock> {
   /** Called from log manager's copy_logger_states. */
   void        copy_logger_state(savepoint::Savepoint *new_savepoint) const;
 
+  /**
+   * Called from log manager's copy_logger_snapshot_positions.
+   * This must be called after copy_logger_state() for the same savepoint.
+   */
+  void        copy_logger_snapshot_position(
+    Epoch snapshot_epoch,
+    savepoint::Savepoint *new_savepoint) const;
+
   /** Append a new epoch history. */
   void        add_epoch_history(const EpochMarkerLogType& epoch_marker);
 
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#ifndef FOEDUS_LOG_STRIPED_LOG_FILE_HPP_
+#define FOEDUS_LOG_STRIPED_LOG_FILE_HPP_
+#include <stdint.h>
+
+#include <iosfwd>
+#include <vector>
+
+#include "foedus/cxx11.hpp"
+#include "foedus/error_code.hpp"
+#include "foedus/fs/device_emulation_options.hpp"
+#include "foedus/fs/fwd.hpp"
+#include "foedus/fs/path.hpp"
+#include "foedus/log/fwd.hpp"
+#include "foedus/log/log_id.hpp"
+
+namespace foedus {
+namespace log {
+
+/**
+ * @brief Maps offsets in a log file to offsets in its stripes.
+ * @ingroup LOG
+ * @details
+ * Like RAID-0, the log file is split into units of unit_size_ bytes, and the i-th unit
+ * is placed in stripe (i % stripes_) at offset (i / stripes_) * unit_size_.
+ * With stripes_ == 1, the only stripe is the log file itself.
+ * @see LogOptions::log_stripes_
+ */
+struct LogStripeLayout {
+  explicit LogStripeLayout(const LogOptions& options);
+  LogStripeLayout(uint16_t stripes, uint64_t unit_size)
+    : stripes_(stripes), unit_size_(unit_size) {}
+
+  bool      is_striped() const { return stripes_ > 1U; }
+  /** Stripe that contains the given offset in the log file. */
+  uint16_t  to_stripe(uint64_t offset) const {
+    return static_cast<uint16_t>((offset / unit_size_) % stripes_);
+  }
+  /** Offset in to_stripe(offset) that corresponds to the given offset in the log file. */
+  uint64_t  to_stripe_offset(uint64_t offset) const {
+    return (offset / unit_size_ / stripes_) * unit_size_ + offset % unit_size_;
+  }
+  /** Bytes in the given stripe when the log file has the given length. */
+  uint64_t  get_stripe_length(uint64_t length, uint16_t stripe) const;
+
+  uint16_t  stripes_;
+  uint64_t  unit_size_;
+};
+
+/**
+ * @brief Reads a log file, reassembling it from its stripes if it is striped.
+ * @ingroup LOG
+ * @details
+ * This is how LogMapper and ChangeStream read log files, so that they need not care whether
+ * LogOptions::log_stripes_ is larger than 1. Each stripe is opened with direct I/O,
+ * so offsets, sizes, and buffers must be aligned to FillerLogType::kLogWriteUnitSize,
+ * which is the case for all log regions loggers write out.
+ */
+class StripedLogFile CXX11_FINAL {
+ public:
+  StripedLogFile(
+    const LogOptions& options,
+    int node,
+    LoggerId logger,
+    LogFileOrdinal ordinal,
+    const fs::DeviceEmulationOptions& emulation);
+  ~StripedLogFile();
+
+  // non-copyable
+  StripedLogFile(const StripedLogFile& other) CXX11_FUNC_DELETE;
+  StripedLogFile& operator=(const StripedLogFile& other) CXX11_FUNC_DELETE;
+
+  /** Opens all stripes in read-only mode. */
+  ErrorCode       open();
+  void            close();
+  /** Reads the given region of the log file. */
+  ErrorCode       read(uint64_t offset, uint64_t bytes, void* buffer);
+
+  /** Byte size of the log file. Sum of the sizes of all stripes. */
+  uint64_t        get_size() const;
+  /** Path of the first stripe, which is the log file itself if not striped. */
+  fs::Path        get_path() const;
+  const LogStripeLayout& get_layout() const { return layout_; }
+
+  /** Byte size of the specified log file, without opening it. */
+  static uint64_t get_file_size(
+    const LogOptions& options,
+    int node,
+    LoggerId logger,
+    LogFileOrdinal ordinal);
+
+  friend std::ostream& operator<<(std::ostream& o, const StripedLogFile& v);
+
+ private:
+  const LogStripeLayout           layout_;
+  std::vector< fs::DirectIoFile* > files_;
+};
+
+}  // namespace log
+}  // namespace foedus
+#endif  // FOEDUS_LOG_STRIPED_LOG_FILE_HPP_
@@ -19,6 +19,7 @@
 #define FOEDUS_LOG_THREAD_LOG_BUFFER_HPP_
 #include <stdint.h>
 
+#include <atomic>
 #include <iosfwd>
 
 #include "foedus/cxx11.hpp"
@@ -392,6 +393,24 @@ class ThreadLogBuffer CXX11_FINAL : public DefaultInitializable {
   /** Called when the logger wrote out all logs in the given epoch, advancing oldest_mark_index_ */
   void        on_log_written(Epoch written_epoch);
 
+  /** Result of claim_logs_to_write() */
+  enum ClaimResult {
+    /** The caller must write out the logs in the epoch, then call on_claimed_log_written(). */
+    kClaimed = 0,
+    /** Another logger has claimed the epoch. Nothing to do. */
+    kClaimedByOther,
+    /** Another logger is still writing out the previous epoch. Try again later. */
+    kClaimPending,
+  };
+  /**
+   * @brief Used when LogOptions::dynamic_logger_assignment_ is on, so that exactly one logger
+   * writes out the logs of this thread in each epoch, and in the order of epochs.
+   * @pre The logs of this thread in written_epoch.one_less() have been claimed.
+   */
+  ClaimResult claim_logs_to_write(Epoch written_epoch);
+  /** Called after on_log_written() by the logger that claimed the epoch. */
+  void        on_claimed_log_written(Epoch written_epoch);
+
 
   friend std::ostream& operator<<(std::ostream& o, const ThreadLogBuffer& v);
 
@@ -411,6 +430,14 @@ class ThreadLogBuffer CXX11_FINAL : public DefaultInitializable {
   Engine* const             engine_;
   ThreadLogBufferMeta       meta_;
 
+  /**
+   * The latest epoch a logger has claimed to write out.
+   * Used only when LogOptions::dynamic_logger_assignment_ is on.
+   */
+  std::atomic< Epoch::EpochInteger >  claimed_epoch_;
+  /** The latest epoch the claimed logger has written out. claimed_epoch_ if none in progress. */
+  std::atomic< Epoch::EpochInteger >  claimed_written_epoch_;
+
 
   /**
    * @brief The in-memory log buffer given to this thread.
@@ -98,6 +98,14 @@ class AlignedMemory CXX11_FINAL {
      * the linux.. crap!
      */
     kNumaMmapOneGbPages,
+    /**
+     * mmap() with 4kb pages bound to the NUMA node via mbind, \b without the zero-clearing.
+     * This just reserves the address space. Physical memory is given to each page when it is
+     * first touched, and can be returned to the OS via discard_physical_memory().
+     * We use this for memory whose necessary size is unknown in advance (eg read/write-sets).
+     * The owner is responsible for touching the part it wants to be resident from the start.
+     */
+    kNumaReserveOnnode,
   };
 
   /** Empty constructor which allocates nothing. */
@@ -245,6 +253,15 @@ struct AlignedMemorySlice CXX11_FINAL {
 /** Returns if 1GB hugepages were enabled. */
 bool is_1gb_hugepage_enabled();
 
+/**
+ * @brief Returns the physical memory of the 4kb pages entirely contained in the given region
+ * to the OS, keeping the address space.
+ * @details
+ * Touching the region again gives zero-cleared pages. Use this only for memory allocated
+ * with AlignedMemory::kNumaReserveOnnode, which is private and not backed by hugetlbfs.
+ */
+void discard_physical_memory(void* address, uint64_t size);
+
 }  // namespace memory
 }  // namespace foedus
 
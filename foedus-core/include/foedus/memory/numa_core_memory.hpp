@@ -45,7 +45,7 @@ namespace memory {
  */
 class NumaCoreMemory CXX11_FINAL : public DefaultInitializable {
  public:
-  /** Packs pointers to pieces of small_thread_local_memory_*/
+  /** Packs pointers to pieces of small_thread_local_memory_ and xct_access_memory_ */
   struct SmallThreadLocalMemoryPieces {
     char* sysxct_workspace_memory_;
     char* xct_pointer_access_memory_;
@@ -111,6 +111,15 @@ class NumaCoreMemory CXX11_FINAL : public DefaultInitializable {
 
   /** @returns the byte size of small_thread_local_memory each thread consumes */
   static uint64_t calculate_local_small_memory_size(const EngineOptions& options);
+  /**
+   * @returns the byte size of xct_access_memory each thread reserves.
+   * @param[in] options engine options
+   * @param[in] growth_factor pass xct_.work_memory_growth_factor_ for the reserved size,
+   * 1 for the size that is resident in physical memory.
+   */
+  static uint64_t calculate_xct_access_memory_size(
+    const EngineOptions& options,
+    uint16_t growth_factor);
 
  private:
   /** Called when there no local free pages. */
@@ -148,25 +157,34 @@ class NumaCoreMemory CXX11_FINAL : public DefaultInitializable {
    * To reduce # of TLB entries, we pack several small things to this 2MB.
    * \li (used in Xct) PointerAccess(16b) * 1k : 16kb
    * \li (used in Xct) PageVersionAccess(16b) * 1k : 16kb
-   * \li (used in Xct) ReadXctAccess(32b) * 32k :1024kb
-   * \li (used in Xct) WriteXctAccess(40b) * 8k : 320kb
-   * \li (used in Xct) LockFreeReadXctAccess(32b) * 128 : 4kb
-   * \li (used in Xct) LockFreeWriteXctAccess(16b) * 4k : 64kb
    * \li (used in Xct) Retired pages(PagePoolOffsetAndEpochChunk=512kb) * #-of-nodes
    *  : 512kb * #nodes
-   * \li (used in Xct) RetrospectiveLock(24b) * (32k+8k) : 960kb
-   * \li (used in Xct) CurrentLock(24b) * (32k+8k) : 960kb
    * In total within a few MBs in most cases.
-   * Depending on options (esp, #nodes, xct_.max_read_set_size and max_write_set_size), this might
+   * Depending on options (esp, #nodes), this might
    * become more than that, which is not ideal. Hopefully the numbers above are sufficient.
    */
   memory::AlignedMemory   small_thread_local_memory_;
   SmallThreadLocalMemoryPieces small_thread_local_memory_pieces_;
 
+  /**
+   * Read/write-sets and lock lists of the transaction in this thread.
+   * Each of them takes xct_.work_memory_growth_factor_ times the configured size, aligned to 4kb.
+   * \li (used in Xct) ReadXctAccess(32b) * 32k :1024kb
+   * \li (used in Xct) WriteXctAccess(40b) * 8k : 320kb
+   * \li (used in Xct) LockFreeReadXctAccess(32b) * 128 : 4kb
+   * \li (used in Xct) LockFreeWriteXctAccess(16b) * 4k : 64kb
+   * \li (used in Xct) RetrospectiveLock(24b) * (32k+8k) : 960kb
+   * \li (used in Xct) CurrentLock(24b) * (32k+8k) : 960kb
+   * The numbers above are the default configured sizes, which we touch at start up.
+   * The rest is just reserved. Xct touches it only when a transaction needs it,
+   * and returns it to the OS after the transaction.
+   */
+  memory::AlignedMemory   xct_access_memory_;
+
   /**
    * Local work memory is used for various purposes during a transaction.
    * We avoid allocating such temporary memory for each transaction and pre-allocate it
-   * at start up.
+   * at start up. Like xct_access_memory_, only the configured size is touched at start up.
    */
   memory::AlignedMemory   local_work_memory_;
 
@@ -88,6 +88,11 @@ class NumaNodeMemory CXX11_FINAL : public DefaultInitializable {
   ErrorStack      allocate_huge_numa_memory(uint64_t size, AlignedMemory *out) const {
     return allocate_numa_memory_general(size, kHugepageSize, out);
   }
+  /**
+   * Reserves an address space of the given size bound to this NUMA node without touching it.
+   * @see AlignedMemory::kNumaReserveOnnode
+   */
+  ErrorStack      reserve_numa_memory(uint64_t size, AlignedMemory *out) const;
 
   PagePoolOffsetChunk* get_volatile_offset_chunk_memory_piece(
     foedus::thread::ThreadLocalOrdinal core_ordinal) {
@@ -214,6 +214,15 @@ class PagePool CXX11_FINAL : public virtual Initializable {
   std::string           get_debug_pool_name() const;
   /** Call this anytime after attach() */
   void                  set_debug_pool_name(const std::string& name);
+  /**
+   * @brief Whether the contents of this pool survive across engine restarts (warm restart).
+   * @details
+   * Call this before initialize() to take over the free pool that a previous engine left in
+   * the re-attached shared memory instead of constructing a new one, and before uninitialize()
+   * to leave pages still in use as they are.
+   * @see foedus::restart::RestartOptions::enable_warm_restart_
+   */
+  void                  set_retained(bool retained);
 
   /**
    * @brief Adds the specified number of free pages to the chunk.
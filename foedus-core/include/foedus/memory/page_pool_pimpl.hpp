@@ -154,6 +154,9 @@ class PagePoolPimpl final : public DefaultInitializable {
   /** @copydoc foedus::memory::MemoryOptions::rigorous_page_boundary_check_ */
   bool                            rigorous_page_boundary_check_;
 
+  /** @copydoc foedus::memory::PagePool::set_retained() */
+  bool                            retained_;
+
   /**
    * An object to resolve an offset in \e this page pool (thus \e local) to an actual
    * pointer and vice versa.
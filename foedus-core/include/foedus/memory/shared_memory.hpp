@@ -138,6 +138,42 @@ class SharedMemory CXX11_FINAL {
    */
   void        attach(const std::string& meta_path, bool use_hugepages);
 
+  /**
+   * @brief Attach a shared memory retained by a previous master process and take over its
+   * ownership.
+   * @param[in] meta_path Path of the new meta file to create for child processes.
+   * @param[in] shmkey Key of the retained shared memory.
+   * @param[in] size Expected byte size of the retained shared memory.
+   * @param[in] numa_node Where the physical memory was allocated.
+   * @param[in] use_hugepages Whether to use hugepages.
+   * @details
+   * Unlike alloc(), this does not zero-clear the memory. The retained memory is exactly what the
+   * previous owner left in detach_and_retain(). This method should be called only at the master
+   * process.
+   */
+  ErrorStack  reattach(
+    const std::string& meta_path,
+    key_t shmkey,
+    uint64_t size,
+    int numa_node,
+    bool use_hugepages);
+
+  /**
+   * @brief Detaches the memory block  without marking it for release so that a later master
+   * process can reattach() it with the same key.
+   * @details
+   * The meta file is removed as usual. This method must not be called after mark_for_release()
+   * because shmget() on a removed key is impossible. Only the owner can call this method.
+   */
+  void        detach_and_retain();
+
+  /**
+   * Marks a retained shared memory of the given key for release without attaching it.
+   * Used to reclaim shared memories left by a previous master process that are not reusable.
+   * This does nothing if there is no such shared memory or someone still attaches it.
+   */
+  static void reclaim_retained(key_t shmkey);
+
   /** Returns the path of the meta file. */
   const std::string& get_meta_path() const { return meta_path_; }
   /** Returns the memory block. */
@@ -168,6 +204,7 @@ class SharedMemory CXX11_FINAL {
    * next reboot. Call it as soon as child processes ack-ed that they have attached the memory
    * or that there are some issues the master process should exit.
    * This method is idempotent, meaning you can safely call this many times.
+   * This method does nothing unless this process owns the memory.
    */
   void        mark_for_release();
 
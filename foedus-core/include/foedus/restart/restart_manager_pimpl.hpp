@@ -58,6 +58,13 @@ class RestartManagerPimpl final : public DefaultInitializable {
    * Essentially this is the only thing the restart manager has to do.
    */
   ErrorStack  redo_meta_logs(Epoch durable_epoch, Epoch snapshot_epoch);
+  /**
+   * Called at uninitialization when warm restart is enabled. Makes all committed transactions
+   * durable so that the retained volatile pages contain nothing newer than the durable epoch,
+   * then requests SOC manager to retain the shared memories.
+   * @see foedus::restart::RestartOptions::enable_warm_restart_
+   */
+  ErrorStack  prepare_warm_shutdown();
 
   Engine* const           engine_;
   RestartManagerControlBlock* control_block_;
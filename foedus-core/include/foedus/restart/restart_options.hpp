@@ -19,11 +19,20 @@
 #define FOEDUS_RESTART_RESTART_OPTIONS_HPP_
 #include "foedus/cxx11.hpp"
 #include "foedus/externalize/externalizable.hpp"
+#include "foedus/fs/filesystem.hpp"
 namespace foedus {
 namespace restart {
 /**
  * @brief Set of options for restart manager.
  * @ingroup RESTART
+ * @details
+ * @par Warm restart
+ * By default, a restart discards all volatile pages and rebuilds them from the latest snapshot
+ * and logs. When enable_warm_restart_ is true, a clean shutdown instead leaves the shared
+ * memories (volatile page pools, storage control blocks, etc) alive and records their keys in
+ * a manifest file. The next engine with the same memory layout re-attaches them and skips the
+ * recovery, resuming with the hot volatile pages. Anything unexpected (crash, layout change,
+ * savepoint older than the manifest) falls back to the usual cold restart.
  * This is a POD struct. Default destructor/copy-constructor/assignment operator work fine.
  */
 struct RestartOptions CXX11_FINAL : public virtual externalize::Externalizable {
@@ -32,6 +41,22 @@ struct RestartOptions CXX11_FINAL : public virtual externalize::Externalizable {
    */
   RestartOptions();
 
+  /**
+   * @brief Whether to retain shared memories at clean shutdown and re-attach them on startup.
+   * @details
+   * Default is false. Ignored when rigorous memory/page boundary checks are enabled.
+   * While this is enabled, shared memories are not marked for reclamation at startup, so
+   * a crashed engine leaves them until the next startup reclaims them via the manifest.
+   */
+  bool            enable_warm_restart_;
+
+  /**
+   * @brief Full path of the manifest file that describes the retained shared memories.
+   * @details
+   * Default is "shared_memory_manifest.bin". Used only when enable_warm_restart_ is true.
+   */
+  fs::FixedPath   warm_restart_manifest_path_;
+
   EXTERNALIZABLE(RestartOptions);
 };
 }  // namespace restart
@@ -113,6 +113,19 @@ struct Savepoint CXX11_FINAL : public virtual externalize::Externalizable {
    */
   std::vector<uint64_t>               current_log_files_offset_durable_;
 
+  /**
+   * @brief Ordinal of the log file in each logger that contains the first log entry after
+   * latest_snapshot_epoch_.
+   * @details
+   * Epoch histories of loggers are volatile. When the engine restarts without warm restart,
+   * this tells where the logs not yet snapshotted begin so that the recovery gleaner reads
+   * them from there. Same as current_log_files_ if no snapshot has been taken.
+   */
+  std::vector<log::LogFileOrdinal>    snapshot_log_files_;
+
+  /** Offset in snapshot_log_files_ where the logs after latest_snapshot_epoch_ begin. */
+  std::vector<uint64_t>               snapshot_log_files_offset_;
+
   EXTERNALIZABLE(Savepoint);
 
   /** Populate variables as an initial state. */
@@ -127,7 +140,9 @@ struct Savepoint CXX11_FINAL : public virtual externalize::Externalizable {
       && oldest_log_files_.size() == logger_count
       && oldest_log_files_offset_begin_.size() == logger_count
       && current_log_files_.size() == logger_count
-      && current_log_files_offset_durable_.size() == logger_count);
+      && current_log_files_offset_durable_.size() == logger_count
+      && snapshot_log_files_.size() == logger_count
+      && snapshot_log_files_offset_.size() == logger_count);
   }
 
   Epoch  get_durable_epoch() const { return Epoch(durable_epoch_); }
@@ -160,6 +175,12 @@ struct LoggerSavepointInfo {
   * During restart, current log files are truncated to this size to discard incomplete logs.
   */
   uint64_t            current_log_file_offset_durable_;
+
+  /** The log file that contains the first log entry after the latest snapshot epoch. */
+  log::LogFileOrdinal snapshot_log_file_;
+
+  /** Offset in snapshot_log_file_ where the logs after the latest snapshot epoch begin. */
+  uint64_t            snapshot_log_file_offset_;
 };
 
 /**
@@ -188,7 +209,7 @@ struct FixedSavepoint CXX11_FINAL {
   /**
    * Stores all loggers' information. We allocate memory enough for the largest number of loggers.
    * In reality, we are just reading/writing a small piece of it.
-   * 24b * 64k = 1.5MB.
+   * 40b * 64k = 2.5MB.
    */
   LoggerSavepointInfo             logger_info_[1U << 16];
 
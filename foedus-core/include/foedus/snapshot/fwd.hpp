@@ -44,6 +44,7 @@ struct  SnapshotManagerControlBlock;
 class   SnapshotManagerPimpl;
 struct  SnapshotMetadata;
 struct  SnapshotOptions;
+class   SnapshotView;
 class   SnapshotWriter;
 class   SortedBuffer;
 }  // namespace snapshot
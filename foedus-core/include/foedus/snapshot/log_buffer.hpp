@@ -166,6 +166,19 @@ class SortedBuffer {
    */
   virtual ErrorCode     wind(uint64_t next_absolute_pos) = 0;
 
+  /**
+   * @brief Same as wind() except that this allows jumping over more than one buffer window.
+   * @param[in] next_absolute_pos the absolute byte position that will be guaranteed to be
+   * within the buffer after this method call.
+   * @pre next_absolute_pos <= get_total_size()
+   * @pre next_absolute_pos >= get_offset()
+   * @details
+   * Used to skip over storage blocks without reading them, for example storages processed by
+   * another composer thread. Data between the current window and the position is not read.
+   * @return File I/O related errors only
+   */
+  virtual ErrorCode     skip(uint64_t next_absolute_pos) = 0;
+
   /** Returns a short string that briefly describes this object. */
   virtual std::string   to_string() const = 0;
 
@@ -234,6 +247,7 @@ class InMemorySortedBuffer CXX11_FINAL : public SortedBuffer {
     ASSERT_ND(next_absolute_pos <= buffer_size_);
     return kErrorCodeOk;
   }
+  ErrorCode   skip(uint64_t next_absolute_pos) CXX11_OVERRIDE { return wind(next_absolute_pos); }
   void        describe(std::ostream* o) const CXX11_OVERRIDE;
 };
 
@@ -256,6 +270,7 @@ class DumpFileSortedBuffer CXX11_FINAL : public SortedBuffer {
 
   std::string to_string() const CXX11_OVERRIDE;
   ErrorCode   wind(uint64_t next_absolute_pos) CXX11_OVERRIDE;
+  ErrorCode   skip(uint64_t next_absolute_pos) CXX11_OVERRIDE;
   void        describe(std::ostream* o) const CXX11_OVERRIDE;
 
   fs::DirectIoFile*                 get_file()      const { return file_; }
@@ -96,6 +96,13 @@ namespace snapshot {
  * root page(s). When all set, gleaner produces maps from storage ID to a new root page ID.
  * This will be written out in a snapshot metadata file by snapshot manager.
  *
+ * @section GLEANER_PREGLEANING Pre-gleaning
+ * When SnapshotOptions::log_pregleaning_interval_milliseconds_ is set, snapshot manager also
+ * runs the gleaner between snapshots in the \e pre-gleaning mode. Mappers read only the logs
+ * that became durable after the previous round, and reducers sort and dump whatever they receive
+ * as sorted runs without composing anything. The sorted runs and partitions are kept until the
+ * next snapshot, whose gleaner then maps only the remaining logs and merge-sorts all of them.
+ *
  * @note
  * This is a private implementation-details of \ref SNAPSHOT, thus file name ends with _impl.
  * Do not include this header from a client program. There is no case client program needs to
@@ -103,7 +110,11 @@ namespace snapshot {
  */
 class LogGleaner final : public LogGleanerRef {
  public:
-  LogGleaner(Engine* engine, LogGleanerResource* gleaner_resource, const Snapshot& new_snapshot);
+  LogGleaner(
+    Engine* engine,
+    LogGleanerResource* gleaner_resource,
+    const Snapshot& new_snapshot,
+    bool pregleaning = false);
 
   LogGleaner() = delete;
   LogGleaner(const LogGleaner &other) = delete;
@@ -126,6 +137,8 @@ class LogGleaner final : public LogGleanerRef {
   LogGleanerResource* const       gleaner_resource_;
   /** The snapshot we are now taking. */
   const Snapshot                  new_snapshot_;
+  /** Whether this gleaner only pre-gleans logs for new_snapshot_ without composing it. */
+  const bool                      pregleaning_;
 
   /**
    * Points to new root pages constructed at the end of gleaning, one for a storage.
@@ -133,7 +146,10 @@ class LogGleaner final : public LogGleanerRef {
    */
   std::map<storage::StorageId, storage::SnapshotPagePointer> new_root_page_pointers_;
 
-  /** Before starting log gleaner, this method resets all shared memory to initialized state. */
+  /**
+   * Before starting log gleaner, this method resets all shared memory to initialized state.
+   * If there are pre-gleaned sorted runs, we keep the partitions they were sorted for.
+   */
   void      clear_all();
 
   /**
@@ -45,6 +45,15 @@ class LogGleanerRef : public Attachable<LogGleanerControlBlock> {
   SnapshotId  get_snapshot_id() const;
   Epoch       get_base_epoch() const;
   Epoch       get_valid_until_epoch() const;
+  /** Whether this round only pre-gleans logs. @see LogGleanerControlBlock::pregleaning_ */
+  bool        is_pregleaning() const;
+  /** @see LogGleanerControlBlock::pregleaned_epoch_ */
+  Epoch       get_pregleaned_epoch() const;
+  /**
+   * Mappers read logs after this epoch (exclusive) in this round.
+   * The pre-gleaned epoch if exists, otherwise the base epoch of the snapshot.
+   */
+  Epoch       get_mapper_from_epoch() const;
 
   uint16_t increment_completed_count();
   uint16_t increment_completed_mapper_count();
@@ -274,7 +274,7 @@ class LogMapper final : public MapReduceBase {
   /**
    * Process one I/O buffer, which is the unit of batching in mapper.
    */
-  ErrorStack  handle_process_buffer(const fs::DirectIoFile &file, IoBufStatus* status);
+  ErrorStack  handle_process_buffer(const log::StripedLogFile &file, IoBufStatus* status);
 
   /**
    * Add the given log position to a bucket for the specified storage.
@@ -407,13 +407,20 @@ class LogReducer final : public MapReduceBase {
   memory::AlignedMemory   writer_intermediate_memory_;
 
   /**
-   * How many buffers written out as a temporary file.
+   * How many buffers written out as a temporary file in this round.
    * If this number is zero when all mappers complete, the reducer does not bother writing out
    * the last and only buffer to file.
    * For now, this value should be always same as current_buffer_.
    */
   uint32_t      sorted_runs_;
 
+  /**
+   * How many sorted runs previous pre-gleaning rounds have left for this snapshot.
+   * They are numbered before the sorted runs of this round, and merged together in merge_sort().
+   * Reset when a round starts without pre-gleaned logs.
+   */
+  uint32_t      carried_runs_;
+
   void expand_if_needed(
     uint64_t required_size,
     memory::AlignedMemory *memory,
@@ -432,6 +439,13 @@ class LogReducer final : public MapReduceBase {
    * So, the next target of sort/dump is another buffer.
    */
   ErrorStack dump_buffer();
+  /**
+   * Used at the end of a pre-gleaning round instead of merge_sort().
+   * Closes the current buffer, if it has anything, and dumps it as another sorted run
+   * so that the next round can start with empty buffers.
+   * @pre all mappers are completed
+   */
+  ErrorStack dump_last_buffer();
   /**
    * First sub routine of dump_buffer.
    * Wait for all mappers to finish writing (active_writers==0).
@@ -499,9 +513,30 @@ class LogReducer final : public MapReduceBase {
    * @pre all mappers completed (thus both buffers active_writers==0 and won't change)
    * @details
    * This invokes a foedus::storage::Composer for each storage, giving sorted buffers as inputs.
-   * The result is just one snapshot file, which is written by SnapshotWriter.
+   * The result is just one snapshot file, which is written by SnapshotWriter, or one shard
+   * of the snapshot file per composer thread if SnapshotOptions::log_reducer_composers_ > 1.
    */
   ErrorStack  merge_sort();
+  /**
+   * The main loop of one composer thread in merge_sort().
+   * @param[in] shard index of the composer thread, which is also the shard it writes to.
+   * The first one runs on the reducer thread itself.
+   * @param[in] dumped_files_count number of sorted run files to read
+   * @param[in,out] next_ordinal shared among composer threads. Ordinal of the next storage
+   * nobody has taken.
+   * @param[out] storage_count number of storages processed by all composer threads
+   * @details
+   * Each composer thread reads the sorted runs with its own streams, takes the next storage
+   * nobody has taken, and skips over storages taken by others.
+   * The unit of work is a whole storage. One composer thread composes all key ranges of a
+   * storage because partitioning within a storage (e.g. array root-child boundaries or
+   * masstree border pages) is decided inside each storage's Composer.
+   */
+  ErrorStack  merge_sort_compose(
+    uint8_t shard,
+    uint32_t dumped_files_count,
+    std::atomic<uint32_t>* next_ordinal,
+    uint32_t* storage_count);
 
   /** just sanity checks. */
   void        merge_sort_check_buffer_status() const;
@@ -533,6 +568,14 @@ class LogReducer final : public MapReduceBase {
   ErrorCode   merge_sort_advance_sort_buffers(
     SortedBuffer* buffer,
     storage::StorageId processed_storage_id) const;
+  /**
+   * Used instead of composing a storage taken by another composer thread.
+   * Makes sure the next block header is in the window without reading the skipped block,
+   * so that merge_sort_advance_sort_buffers() can follow.
+   */
+  ErrorCode   merge_sort_skip_sort_buffers(
+    SortedBuffer* buffer,
+    storage::StorageId skipped_storage_id) const;
 
   uint32_t    get_max_storage_count() const;
 };
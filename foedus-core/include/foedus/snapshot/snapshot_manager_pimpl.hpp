@@ -53,6 +53,8 @@ struct LogGleanerControlBlock {
     reducers_count_ = 0;
     all_count_ = 0;
     terminating_ = false;
+    pregleaned_epoch_.reset();
+    round_ = 0;
   }
   void uninitialize() {
   }
@@ -64,8 +66,18 @@ struct LogGleanerControlBlock {
     exit_count_ = 0;
     gleaning_ = false;
     cancelled_ = false;
+    pregleaning_ = false;
   }
 
+  /**
+   * Forgets the sorted runs pre-gleaned so far in this snapshot cycle.
+   * The next round starts over from the base epoch of the snapshot.
+   * Called when the pre-gleaned runs can't be used any more, for example when the shape of a
+   * storage changed so that the partitions they were sorted for are no longer valid.
+   * The caller must hold SnapshotManagerControlBlock::snapshot_mutex_.
+   */
+  void discard_pregleaned() { pregleaned_epoch_.reset(); }
+
   /**
   * If this returns true, all mappers and reducers should exit as soon as possible.
   * Gleaner 'does its best' to wait for the exit of them, and then exit asap, too.
@@ -82,6 +94,27 @@ struct LogGleanerControlBlock {
   /** The snapshot we are now taking. */
   Snapshot                        cur_snapshot_;
 
+  /**
+   * Whether the current round is a pre-gleaning round. In that case, reducers only sort and dump
+   * the logs they receive as sorted runs and keep them for the next round. Nothing is composed.
+   * @see SnapshotOptions::log_pregleaning_interval_milliseconds_
+   */
+  bool                            pregleaning_;
+
+  /**
+   * Logs up to this epoch (inclusive) have been pre-gleaned into sorted runs of the reducers
+   * in this snapshot cycle, so mappers start reading logs after this epoch.
+   * Invalid if nothing has been pre-gleaned. Unlike others, this survives clear_counts().
+   */
+  Epoch                           pregleaned_epoch_;
+
+  /**
+   * Incremented every time the gleaner launches mappers/reducers.
+   * Child engines compare it with what they have seen to launch mappers/reducers threads.
+   * A snapshot ID alone is not enough because one snapshot might have many pre-gleaning rounds.
+   */
+  std::atomic<uint32_t>           round_;
+
   /**
    * count of mappers/reducers that have completed processing the current epoch.
    * the gleaner thread is woken up when this becomes mappers_.size() + reducers_.size().
@@ -127,9 +160,11 @@ struct SnapshotManagerControlBlock {
     snapshot_wakeup_.initialize();
     snapshot_children_wakeup_.initialize();
     gleaner_.initialize();
+    snapshot_mutex_.initialize();
     requested_snapshot_epoch_.store(Epoch::kEpochInvalid);
   }
   void uninitialize() {
+    snapshot_mutex_.uninitialize();
     gleaner_.uninitialize();
   }
 
@@ -190,6 +225,13 @@ struct SnapshotManagerControlBlock {
    */
   soc::SharedPolling              snapshot_children_wakeup_;
 
+  /**
+   * Held while the master engine takes a snapshot.
+   * Metadata operations that change the shape of a storage, such as
+   * storage::array::ArrayStorage::extend(), take this mutex to wait for the ongoing snapshot.
+   */
+  soc::SharedMutex                snapshot_mutex_;
+
   /** Gleaner-related variables */
   LogGleanerControlBlock          gleaner_;
 };
@@ -263,6 +305,16 @@ class SnapshotManagerPimpl final : public DefaultInitializable {
    * In other words, this function is the main routine of snapshotting.
    */
   ErrorStack  handle_snapshot_triggered(Snapshot *new_snapshot);
+  /**
+   * handle_snapshot() calls this when log_pregleaning_interval_milliseconds_ has elapsed.
+   * Runs mappers/reducers on durable logs after the previously pre-gleaned epoch so that
+   * reducers accumulate sorted runs for the upcoming snapshot.
+   * This does not change anything visible to transactions.
+   * @see SnapshotOptions::log_pregleaning_interval_milliseconds_
+   */
+  ErrorStack  handle_pregleaning_triggered();
+  /** ID of the snapshot we will take next. */
+  SnapshotId  get_next_snapshot_id() const;
 
   /**
    * @brief Main routine for snapshot_thread_ in child engines.
@@ -347,6 +399,12 @@ class SnapshotManagerPimpl final : public DefaultInitializable {
    */
   std::chrono::system_clock::time_point   previous_snapshot_time_;
 
+  /**
+   * When snapshot_thread_ pre-gleaned logs or took snapshot last time.
+   * Read and written only by snapshot_thread_.
+   */
+  std::chrono::system_clock::time_point   previous_pregleaning_time_;
+
   /** Mappers in this node. Index is logger ordinal. Empty in master engine. */
   std::vector<LogMapper*>     local_mappers_;
   /** Reducer in this node. Null in master engine. */
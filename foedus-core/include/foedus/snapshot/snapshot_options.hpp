@@ -36,11 +36,13 @@ struct SnapshotOptions CXX11_FINAL : public virtual externalize::Externalizable
   enum Constants {
     kDefaultSnapshotTriggerPagePoolPercent = 100,
     kDefaultSnapshotIntervalMilliseconds  = 60000,
+    kDefaultLogPregleaningIntervalMilliseconds  = 0,
     kDefaultLogMapperBucketKb             = 1024,
     kDefaultLogMapperIoBufferMb           = 64,
     kDefaultLogReducerBufferMb            = 256,
     kDefaultLogReducerDumpIoBufferMb      = 8,
     kDefaultLogReducerReadIoBufferKb      = 1024,
+    kDefaultLogReducerComposers           = 1,
     kDefaultSnapshotWriterPagePoolSizeMb  = 128,
     kDefaultSnapshotWriterIntermediatePoolSizeMb  = 16,
   };
@@ -79,6 +81,21 @@ struct SnapshotOptions CXX11_FINAL : public virtual externalize::Externalizable
    */
   uint32_t                            snapshot_interval_milliseconds_;
 
+  /**
+   * @brief Interval in milliseconds to incrementally glean durable logs between snapshots.
+   * @details
+   * When this is not zero, snapshot manager periodically runs mappers and reducers on
+   * the logs that became durable since the last round, even before the snapshot interval.
+   * Reducers sort and dump what they receive as sorted runs and keep them. Taking a snapshot
+   * then only needs to map the remaining logs and merge-sort/compose the sorted runs, which
+   * makes snapshotting much shorter and spreads the log I/O over time.
+   * Note that the final merge-sort reads each sorted run with its own
+   * log_reducer_read_io_buffer_kb_ buffer, so this should not be too small relative to
+   * snapshot_interval_milliseconds_.
+   * Default is 0 (disabled, logs are gleaned only when taking a snapshot).
+   */
+  uint32_t                            log_pregleaning_interval_milliseconds_;
+
   /**
    * The size in KB of bucket (buffer for each partition) in mapper.
    * The larger, the less freuquently each mapper communicates with reducers.
@@ -126,6 +143,23 @@ struct SnapshotOptions CXX11_FINAL : public virtual externalize::Externalizable
    */
   uint32_t                            log_reducer_read_io_buffer_kb_;
 
+  /**
+   * @brief Number of threads in each reducer (NUMA node) that compose snapshot pages.
+   * @details
+   * When this is more than one, the reducer's merge-sort phase spawns this number of composer
+   * threads in the node. They take storages one by one, and each thread writes out the pages
+   * with its own snapshot writer to its own shard of the node's snapshot file.
+   * Each thread opens its own streams on the sorted runs, and allocates its own snapshot writer
+   * memory (snapshot_writer_page_pool_size_mb_ and snapshot_writer_intermediate_pool_size_mb_),
+   * so the memory consumption in the merge-sort phase is multiplied by this number.
+   * This parallelizes composition across storages, not within a storage. Each storage is
+   * composed by exactly one thread, so the largest storage in the node bounds the duration of
+   * the merge-sort phase. For example, a snapshot that modifies one large storage and a few
+   * small ones gains nothing from this. We do not split a storage's key range across threads.
+   * Must be 1 to storage::kMaxSnapshotShards. Default is 1.
+   */
+  uint16_t                            log_reducer_composers_;
+
   /**
    * The size in MB of one snapshot writer, which holds data pages modified in the snapshot
    * and them sequentially dumps them to a file for each storage.
@@ -149,8 +183,13 @@ struct SnapshotOptions CXX11_FINAL : public virtual externalize::Externalizable
   /** converts folder_path_pattern_ into a string with the given node. */
   std::string     convert_folder_path_pattern(int node) const;
 
-  /** 'folder_path'/snapshot_'snapshot-id'_node_'node-id'.data. */
-  std::string     construct_snapshot_file_path(int snapshot_id, int node) const;
+  /**
+   * 'folder_path'/snapshot_'snapshot-id'_'node-id', followed by _'shard' unless it is
+   * the first shard.
+   */
+  std::string     construct_snapshot_file_path(int snapshot_id, int node, int shard = 0) const;
+  /** 'primary_folder_path'/snapshot_metadata_'snapshot-id'.xml. */
+  std::string     construct_snapshot_metadata_file_path(int snapshot_id) const;
 
   /**
    * Returns the path of first node, which is also used as the primary place
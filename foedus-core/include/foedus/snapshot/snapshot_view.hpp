@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#ifndef FOEDUS_SNAPSHOT_SNAPSHOT_VIEW_HPP_
+#define FOEDUS_SNAPSHOT_SNAPSHOT_VIEW_HPP_
+
+#include "foedus/cxx11.hpp"
+#include "foedus/epoch.hpp"
+#include "foedus/error_code.hpp"
+#include "foedus/error_stack.hpp"
+#include "foedus/fwd.hpp"
+#include "foedus/memory/aligned_memory.hpp"
+#include "foedus/snapshot/fwd.hpp"
+#include "foedus/snapshot/snapshot_id.hpp"
+#include "foedus/snapshot/snapshot_metadata.hpp"
+#include "foedus/storage/fwd.hpp"
+#include "foedus/storage/storage_id.hpp"
+#include "foedus/storage/array/array_storage.hpp"
+#include "foedus/storage/hash/hash_storage.hpp"
+#include "foedus/storage/masstree/masstree_storage.hpp"
+#include "foedus/storage/sequential/sequential_storage.hpp"
+#include "foedus/thread/fwd.hpp"
+
+namespace foedus {
+namespace snapshot {
+/**
+ * @brief A read-only view of all storages as of a past snapshot, or time-travel reads.
+ * @ingroup SNAPSHOT
+ * @details
+ * Every snapshot leaves its metadata file and snapshot files behind, and snapshot pages are
+ * immutable. This object loads the metadata file of the given snapshot and provides storage
+ * objects whose root pointers are those of the snapshot. Reading them in a transaction begun by
+ * begin_xct() gives the exact image of the database as of the snapshot's valid-until epoch.
+ *
+ * @code{.cpp}
+ * SnapshotView view(engine);
+ * CHECK_ERROR(view.open(old_snapshot_id));
+ * storage::masstree::MasstreeStorage customers = view.get_masstree("customers");
+ * WRAP_ERROR_CODE(view.begin_xct(context));
+ * ... customers.get_record(), MasstreeCursor, SequentialCursor, etc ...
+ * WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));  // never aborts
+ * @endcode
+ *
+ * @par How it works
+ * The transaction is a snapshot-only transaction (see XctManager::begin_snapshot_only_xct())
+ * pinned to the snapshot. It follows only snapshot pointers and reads pages through the
+ * snapshot cache, taking no read-set or lock. The storage objects are backed by control blocks
+ * in this object, not in the shared memory, so neither the view nor its transactions have any
+ * effect on other transactions. The pages are shared with other readers in the snapshot cache.
+ *
+ * @par Limitations
+ * Only reads. The storage objects must not be used in usual transactions or for DDLs.
+ * The view is valid only while this object and the engine are alive.
+ * A storage that was empty as of the snapshot has no root page, so reads on it fail with
+ * kErrorCodeXctNoSnapshotPage.
+ */
+class SnapshotView CXX11_FINAL {
+ public:
+  explicit SnapshotView(Engine* engine);
+  ~SnapshotView() {}
+
+  SnapshotView() CXX11_FUNC_DELETE;
+  SnapshotView(const SnapshotView&) CXX11_FUNC_DELETE;
+  SnapshotView& operator=(const SnapshotView&) CXX11_FUNC_DELETE;
+
+  /**
+   * @brief Loads the metadata of the given snapshot.
+   * @return kErrorCodeSnapshotNotFound if the snapshot is not a completed one.
+   * @details
+   * If this view was already opened, the storage objects obtained from it become invalid.
+   */
+  ErrorStack  open(SnapshotId snapshot_id);
+  /** Releases the metadata. The storage objects obtained from it become invalid. */
+  void        close();
+  bool        is_open() const { return metadata_.id_ != kNullSnapshotId; }
+
+  SnapshotId  get_snapshot_id() const { return metadata_.id_; }
+  /** All changes upto (inclusive) this epoch are visible in the view. */
+  Epoch       get_valid_until_epoch() const { return Epoch(metadata_.valid_until_epoch_); }
+  storage::StorageId get_largest_storage_id() const { return metadata_.largest_storage_id_; }
+
+  /**
+   * Begins a snapshot-only transaction pinned to this snapshot.
+   * Its commit epoch is get_valid_until_epoch().
+   */
+  ErrorCode   begin_xct(thread::Thread* context) const;
+
+  /**
+   * @return Control block of the storage as of the snapshot. nullptr if the storage
+   * did not exist as of the snapshot.
+   */
+  storage::StorageControlBlock* get_storage(storage::StorageId id);
+  /** Same as above, but with the storage name as of the snapshot. */
+  storage::StorageControlBlock* get_storage(const storage::StorageName& name);
+
+  /** @return Array storage as of the snapshot. If it did not exist, an empty object. */
+  storage::array::ArrayStorage get_array(const storage::StorageName& name) {
+    return get_typed_storage<storage::array::ArrayStorage>(name);
+  }
+  /** @return Hash storage as of the snapshot. If it did not exist, an empty object. */
+  storage::hash::HashStorage get_hash(const storage::StorageName& name) {
+    return get_typed_storage<storage::hash::HashStorage>(name);
+  }
+  /** @return Sequential storage as of the snapshot. If it did not exist, an empty object. */
+  storage::sequential::SequentialStorage get_sequential(const storage::StorageName& name) {
+    return get_typed_storage<storage::sequential::SequentialStorage>(name);
+  }
+  /** @return Masstree storage as of the snapshot. If it did not exist, an empty object. */
+  storage::masstree::MasstreeStorage get_masstree(const storage::StorageName& name) {
+    return get_typed_storage<storage::masstree::MasstreeStorage>(name);
+  }
+
+ private:
+  template <typename STORAGE>
+  STORAGE get_typed_storage(const storage::StorageName& name) {
+    storage::StorageControlBlock* block = get_storage(name);
+    return block == CXX11_NULLPTR ? STORAGE() : STORAGE(engine_, block);
+  }
+
+  Engine* const             engine_;
+  /** The metadata file of the snapshot, as it is. */
+  SnapshotMetadata          metadata_;
+  /** Control blocks set up for reading from the metadata. Indexed by StorageId. */
+  storage::StorageControlBlock* control_blocks_;
+  memory::AlignedMemory     control_blocks_memory_;
+};
+
+}  // namespace snapshot
+}  // namespace foedus
+#endif  // FOEDUS_SNAPSHOT_SNAPSHOT_VIEW_HPP_
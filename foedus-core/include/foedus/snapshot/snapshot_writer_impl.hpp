@@ -68,6 +68,11 @@ namespace snapshot {
  * \b right-most pages in all levels. After dumping everything else, we repeat the compose phase
  * just like moving on to another storage.
  *
+ * @par Shards
+ * When a reducer composes storages with more than one thread, each thread has its own writer
+ * that writes to its own shard of the node's snapshot file. The writer's page IDs then carry
+ * the shard in the high bits of the local page ID. See storage::SnapshotPagePointer.
+ *
  * @note
  * This is a private implementation-details of \ref SNAPSHOT, thus file name ends with _impl.
  * Do not include this header from a client program. There is no case client program needs to
@@ -81,7 +86,8 @@ class SnapshotWriter final {
     SnapshotId snapshot_id,
     memory::AlignedMemory* pool_memory,
     memory::AlignedMemory* intermediate_memory,
-    bool append = false);
+    bool append = false,
+    uint8_t shard = 0);
   ~SnapshotWriter() { close(); }
 
   /** Open the file so that the writer can start writing. */
@@ -99,6 +105,7 @@ class SnapshotWriter final {
 
 
   uint16_t                get_numa_node() const { return numa_node_; }
+  uint8_t                 get_shard() const { return shard_; }
   inline storage::Page*   get_page_base() ALWAYS_INLINE {
     return reinterpret_cast<storage::Page*>(pool_memory_->get_block());
   }
@@ -146,7 +153,9 @@ class SnapshotWriter final {
   }
 
   std::string             to_string() const {
-    return "SnapshotWriter-" + std::to_string(numa_node_) + (append_ ? "(append)" : "");
+    return "SnapshotWriter-" + std::to_string(numa_node_)
+      + (shard_ ? "-" + std::to_string(shard_) : std::string())
+      + (append_ ? "(append)" : "");
   }
 
   /**
@@ -187,6 +196,8 @@ class SnapshotWriter final {
   const uint16_t                  numa_node_;
   /** Whether we are appending to an existing file. */
   const bool                      append_;
+  /** Which shard of the node's snapshot file we write to. 0 unless composed in parallel. */
+  const uint8_t                   shard_;
   /** ID of the snapshot this writer is currently working on. */
   const SnapshotId                snapshot_id_;
 
@@ -0,0 +1,314 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#ifndef FOEDUS_SOC_CLIENT_RING_HPP_
+#define FOEDUS_SOC_CLIENT_RING_HPP_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <string>
+
+#include "foedus/cxx11.hpp"
+#include "foedus/error_code.hpp"
+#include "foedus/error_stack.hpp"
+#include "foedus/memory/shared_memory.hpp"
+#include "foedus/proc/proc_id.hpp"
+#include "foedus/soc/fwd.hpp"
+#include "foedus/soc/shared_cond.hpp"
+#include "foedus/soc/shared_polling.hpp"
+
+namespace foedus {
+namespace soc {
+
+/**
+ * @brief Header of one request slot in ClientRing, followed by the input/output data area.
+ * @ingroup SOC
+ * @details
+ * sequence_ follows the bounded MPMC queue of Dmitry Vyukov. A slot at position P is free
+ * or reserved when sequence_ == P, holds a submitted request when sequence_ == P + 1, and becomes
+ * free for position P + slot count when the client releases it.
+ * status_ tells the client whether the worker thread has completed the request.
+ * It also tells who owns the slot: the client from kReserved until submit, again after
+ * kCompleted until release, and the worker threads in between.
+ * A slot the owner abandoned in kReserved or kCompleted is reclaimed, see ClientRing.
+ *
+ * This is backed by shared memory. Not instantiated, just reinterpret_cast.
+ */
+struct ClientRingSlot {
+  enum Constants {
+    /** Byte size of the header. The data area follows it. */
+    kHeaderSize = 128,
+  };
+  enum Status {
+    kFree = 0,
+    kReserved,
+    kSubmitted,
+    kCompleted,
+    /** Reserved, but skipped by workers as the client didn't submit it in time. */
+    kAbandoned,
+  };
+
+  ClientRingSlot() CXX11_FUNC_DELETE;
+  ~ClientRingSlot() CXX11_FUNC_DELETE;
+
+  std::atomic<uint64_t>   sequence_;
+  /** Status. Written by the client when it submits, by the worker when it completes. */
+  std::atomic<uint32_t>   status_;
+  uint32_t                input_len_;
+  /** Byte length of the output the procedure wrote. Valid when completed. */
+  uint32_t                output_len_;
+  /** kErrorCodeOk or the error code the procedure returned. Valid when completed. */
+  ErrorCode               result_;
+  /** Process ID of the client that reserved the slot. */
+  uint32_t                owner_pid_;
+  /** When the slot became kReserved or kCompleted, in microseconds of a monotonic clock. */
+  uint64_t                status_changed_us_;
+  proc::ProcName          proc_name_;
+};
+
+/**
+ * @brief A ring of procedure requests placed in a shared memory that processes outside of the
+ * engine can attach.
+ * @ingroup SOC
+ * @details
+ * When SocOptions::client_ring_slots_ is non-zero, each NUMA node has its own ring, which
+ * thread::ThreadGroup allocates and owns. Unlike the shared memories in SharedMemoryRepo,
+ * the ring is not marked for release until the engine shuts down, so external processes can
+ * attach it via ClientRingConnection at any time.
+ *
+ * Impersonation hands one task to one thread and makes the client wait for it, which costs a
+ * mutex and two condition signals per request. Instead, external clients here push many
+ * requests to the ring without locks and then wait for them together.
+ * Idle worker threads of the node take requests from the ring in batches of
+ * SocOptions::client_ring_batch_size_, run the procedures in place on the slots, and notify
+ * clients once per batch.
+ * Idle workers sleep on a doorbell, which clients ring when they submit a request while some
+ * worker is sleeping. Ringing it does not need a mutex, so a client process dying at any point
+ * can't block workers.
+ *
+ * Usage in the client side:
+ * @code{.cpp}
+ * ClientRing::Ticket ticket;
+ * void* input;
+ * CHECK_ERROR_CODE(ring->reserve(sizeof(MyInput), &ticket, &input));
+ * ... write MyInput to input ...
+ * ring->submit(ticket, "my_proc");
+ * ... reserve/submit more, then ...
+ * CHECK_ERROR_CODE(ring->wait(ticket, 1000000ULL));
+ * ... read ring->get_result(ticket), get_output(ticket) ...
+ * ring->release(ticket);
+ * @endcode
+ * A reserved slot must be submitted shortly as worker threads take requests in order.
+ * Completed slots must be released, otherwise the ring becomes full.
+ *
+ * @par Abandoned slots
+ * Each slot remembers the process that reserved it. When the owner does not move a slot
+ * forward for SocOptions::client_ring_abandon_timeout_us_, or the owner process has died:
+ *  \li A reserved slot at the head of the ring is skipped by worker threads, so that other
+ * requests don't wait for it. The owner's submit() then returns
+ * kErrorCodeSocClientRingAbandoned and returns the slot to the ring. If the owner has died,
+ * the slot is returned right away.
+ *  \li A completed slot that is not released is returned to the ring by a reserve() that
+ * finds the ring full. wait() and get_result() of the old ticket then report
+ * kErrorCodeSocClientRingAbandoned, and its output must not be read any more.
+ *
+ * Memory layout: a 4kb control block, then slots of kHeaderSize + slot data size bytes each.
+ * This object itself is just a set of pointers into the memory.
+ */
+class ClientRing CXX11_FINAL {
+ public:
+  /** The position of a request in the ring. Only the lower bits identify the slot. */
+  typedef uint64_t Ticket;
+  enum Constants {
+    kControlBlockSize = 1 << 12,
+  };
+
+  ClientRing();
+
+  /** Byte size of the shared memory needed for the given options. 0 if disabled. */
+  static uint64_t calculate_memory_size(const SocOptions& options);
+
+  /**
+   * Initializes the memory of calculate_memory_size() bytes as an empty ring.
+   * Only the owner of the memory calls this.
+   */
+  void        initialize(void* memory, const SocOptions& options);
+  /**
+   * Points to a ring that the owner has initialized.
+   * @return kErrorCodeSocShmAttachFailed if the memory does not look like a ring
+   */
+  ErrorCode   attach(void* memory, uint64_t memory_size);
+  bool        is_enabled() const { return control_block_ != CXX11_NULLPTR; }
+
+  uint32_t    get_slot_count() const { return slot_mask_ + 1U; }
+  /** Byte size of the data area in each slot, shared by the input and the output. */
+  uint32_t    get_slot_data_size() const { return slot_data_size_; }
+
+  // client side
+  /**
+   * @brief Takes a free slot for a new request.
+   * @param[in] input_len byte length of the input the client will write
+   * @param[out] ticket identifies the request in the following calls
+   * @param[out] input where the client writes the input to
+   * @return kErrorCodeSocClientRingFull if there is no free slot even after reclaiming
+   * abandoned ones, kErrorCodeSocClientRingTooLargeInput if the input doesn't fit in a slot
+   */
+  ErrorCode   reserve(uint32_t input_len, Ticket* ticket, void** input);
+  /**
+   * @brief Requests the procedure of the given name on the input written to the reserved slot.
+   * @return kErrorCodeSocClientRingAbandoned if the workers have skipped the slot because
+   * this was too late. The ticket becomes invalid in that case.
+   */
+  ErrorCode   submit(Ticket ticket, const proc::ProcName& proc_name);
+  bool        is_completed(Ticket ticket) const {
+    const ClientRingSlot* slot = get_slot(ticket);
+    return slot->status_.load(std::memory_order_acquire) == ClientRingSlot::kCompleted
+      && slot->sequence_.load(std::memory_order_acquire) == ticket + 1U;
+  }
+  /** Whether the submitted request's slot was reclaimed before the client released it. */
+  bool        is_abandoned(Ticket ticket) const {
+    return static_cast<int64_t>(get_slot(ticket)->sequence_.load() - (ticket + 1U)) > 0;
+  }
+  /**
+   * @brief Waits until the request completes.
+   * @return kErrorCodeTimeout if no request in the ring completed for timeout_us microseconds,
+   * kErrorCodeSocClientRingAbandoned if the slot was reclaimed
+   */
+  ErrorCode   wait(Ticket ticket, uint64_t timeout_us) const;
+  /**
+   * @pre is_completed(ticket) or is_abandoned(ticket)
+   * @return the result of the procedure, or kErrorCodeSocClientRingAbandoned
+   */
+  ErrorCode   get_result(Ticket ticket) const;
+  /** @pre is_completed(ticket) */
+  const void* get_output(Ticket ticket) const;
+  /** @pre is_completed(ticket) */
+  uint32_t    get_output_len(Ticket ticket) const { return get_slot(ticket)->output_len_; }
+  /**
+   * Returns a completed slot to the ring. The ticket becomes invalid.
+   * Does nothing if the slot was already reclaimed.
+   */
+  void        release(Ticket ticket);
+
+  // worker side
+  /** Cheap check without read-modify-write operations, which might be stale. */
+  bool        has_requests() const;
+  /**
+   * Cheap check whether any request is reserved or submitted but not taken yet,
+   * which might be stale.
+   */
+  bool        has_pending_slots() const;
+  /**
+   * Takes the oldest submitted request, if any. This also skips an abandoned reserved slot
+   * that blocks the head of the ring.
+   */
+  bool        dequeue(Ticket* ticket);
+  /**
+   * @brief Sleeps until a client submits a request or the timeout elapses.
+   * @details
+   * Returns immediately if there already is a request. A wakeup might be lost if a client
+   * rings the doorbell right before the worker starts sleeping, so the timeout should be short.
+   */
+  void        wait_for_requests(uint64_t timeout_us);
+  const proc::ProcName& get_proc_name(Ticket ticket) const { return get_slot(ticket)->proc_name_; }
+  const void* get_input(Ticket ticket) const { return get_data(ticket); }
+  uint32_t    get_input_len(Ticket ticket) const { return get_slot(ticket)->input_len_; }
+  /** Output buffer placed after the input in the slot and its byte capacity. */
+  void*       get_output_buffer(Ticket ticket, uint32_t* capacity) const;
+  /** Publishes the result of a request. Clients are not woken up until signal_completion(). */
+  void        complete(Ticket ticket, ErrorCode result, uint32_t output_len);
+  /** Wakes up clients waiting for completed requests. */
+  void        signal_completion();
+
+ private:
+  /** Placed at the beginning of the shared memory. */
+  struct ControlBlock {
+    uint64_t                magic_word_;
+    uint32_t                slot_count_;
+    uint32_t                slot_data_size_;
+    /** SocOptions::client_ring_abandon_timeout_us_ */
+    uint64_t                abandon_timeout_us_;
+    char                    filler1_[40];
+    /** Next position clients reserve. Placed in its own cacheline. */
+    std::atomic<uint64_t>   enqueue_position_;
+    char                    filler2_[56];
+    /** Next position worker threads take. Placed in its own cacheline. */
+    std::atomic<uint64_t>   dequeue_position_;
+    char                    filler3_[56];
+    /** Number of worker threads sleeping on doorbell_. Placed in its own cacheline. */
+    std::atomic<uint32_t>   sleeping_workers_;
+    char                    filler4_[60];
+    /** Signalled when worker threads complete requests. */
+    SharedPolling           response_cond_;
+    /** Signalled without mutex when a client submits a request while workers are sleeping. */
+    SharedCond              doorbell_;
+  };
+
+  ClientRingSlot* get_slot(Ticket ticket) const {
+    return reinterpret_cast<ClientRingSlot*>(
+      slots_ + (ticket & slot_mask_) * (ClientRingSlot::kHeaderSize + slot_data_size_));
+  }
+  char*       get_data(Ticket ticket) const {
+    return reinterpret_cast<char*>(get_slot(ticket)) + ClientRingSlot::kHeaderSize;
+  }
+  void        point_to(void* memory);
+  /** Whether the owner of the slot has died or has not moved it forward for long. */
+  bool        is_owner_gone(const ClientRingSlot* slot) const;
+  /** Skips the reserved slot at the head of the ring if the owner is gone. */
+  bool        try_skip_abandoned(uint64_t position);
+  /** Returns the slot of the previous lap to the ring if the owner is gone. */
+  bool        try_reclaim(uint64_t position);
+
+  ControlBlock*   control_block_;
+  char*           slots_;
+  uint32_t        slot_mask_;
+  uint32_t        slot_data_size_;
+};
+
+/**
+ * @brief A connection of a process outside of the engine to the ClientRing of a NUMA node.
+ * @ingroup SOC
+ * @details
+ * This attaches the shared memory via the meta file at
+ * SocOptions::convert_client_ring_path_pattern(), which exists while the engine is running.
+ * This object does not need an Engine object. The engine shutting down while connections
+ * remain is fine as linux releases the memory when the last process detaches it.
+ */
+class ClientRingConnection CXX11_FINAL {
+ public:
+  ClientRingConnection() {}
+  ~ClientRingConnection() { disconnect(); }
+
+  // Disable copy constructors
+  ClientRingConnection(const ClientRingConnection&) CXX11_FUNC_DELETE;
+  ClientRingConnection& operator=(const ClientRingConnection&) CXX11_FUNC_DELETE;
+
+  /** Attaches the ring whose meta file is at the given path. */
+  ErrorStack  connect(const std::string& meta_path);
+  void        disconnect();
+  bool        is_connected() const { return ring_.is_enabled(); }
+  ClientRing* get_ring() { return &ring_; }
+
+ private:
+  memory::SharedMemory  memory_;
+  ClientRing            ring_;
+};
+
+}  // namespace soc
+}  // namespace foedus
+#endif  // FOEDUS_SOC_CLIENT_RING_HPP_
@@ -25,6 +25,9 @@
 namespace foedus {
 namespace soc {
 struct  ChildEngineStatus;
+class   ClientRing;
+class   ClientRingConnection;
+struct  ClientRingSlot;
 struct  GlobalMemoryAnchors;
 struct  MasterEngineStatus;
 struct  NodeMemoryAnchors;
@@ -27,6 +27,7 @@
 #include "foedus/cxx11.hpp"
 #include "foedus/engine.hpp"
 #include "foedus/engine_options.hpp"
+#include "foedus/epoch.hpp"
 #include "foedus/error_stack.hpp"
 #include "foedus/module_type.hpp"
 #include "foedus/assorted/atomic_fences.hpp"
@@ -130,7 +131,20 @@ struct MasterEngineStatus CXX11_FINAL {
   ModuleType initialized_modules_;
   /** The module that has been most recently closed in master. Used to synchronize uninit. */
   ModuleType uninitialized_modules_;
-  // so far this is the only information.
+  /**
+   * Whether the master re-attached shared memories retained by a previous clean shutdown.
+   * Modules that own state in shared memory keep it as-is instead of initializing it.
+   * @see foedus::restart::RestartOptions::enable_warm_restart_
+   */
+  bool       warm_restarted_;
+  /**
+   * Whether the master will retain the shared memories at this shutdown for a warm restart.
+   * Set by restart manager during uninitialization after everything became durable.
+   * Modules that would release volatile pages at uninitialization leave them as they are.
+   */
+  bool       retain_at_shutdown_;
+  /** When retain_at_shutdown_, the durable epoch all retained volatile pages are within. */
+  Epoch::EpochInteger retained_durable_epoch_;
 };
 
 /**
@@ -221,8 +235,8 @@ struct GlobalMemoryAnchors {
     kLogManagerMemorySize = 1 << 12,
     kMetaLoggerSize = 1 << 13,
     kRestartManagerMemorySize = 1 << 12,
-    /** 3 << 19 is for FixedSavepoint. It's about 1.5MB */
-    kSavepointManagerMemorySize = (3 << 19) + (1 << 12),
+    /** 5 << 19 is for FixedSavepoint. It's about 2.5MB */
+    kSavepointManagerMemorySize = (5 << 19) + (1 << 12),
     kSnapshotManagerMemorySize = 1 << 12,
     kStorageManagerMemorySize = 1 << 12,
     kXctManagerMemorySize = 1 << 12,
@@ -298,6 +312,13 @@ struct GlobalMemoryAnchors {
    */
   void*                                     user_memory_;
 
+  /**
+   * Old record versions for multi-version read-only transactions.
+   * The size is xct::VersionStore::calculate_memory_size(), 0 unless
+   * XctOptions::version_arena_size_kb_ is set.
+   */
+  void*                                     version_store_memory_;
+
   /** sanity check boundaries to detect bogus memory accesses that overrun a memory region */
   assorted::ProtectedBoundary*              protected_boundaries_[kMaxBoundaries];
   /** To be a POD, we avoid vector and instead uses a fix-sized array */
@@ -452,6 +473,45 @@ struct ThreadMemoryAnchors {
   xct::McsRwAsyncMapping*   mcs_rw_async_mappings_memories_;
 };
 
+/**
+ * @brief Describes shared memories retained for a warm restart.
+ * @ingroup SOC
+ * @details
+ * The master engine writes this to RestartOptions::warm_restart_manifest_path_.
+ * Right after allocating shared memories, it writes a manifest with clean_shutdown_ false so
+ * that the next master can reclaim the shared memories even if this process crashes.
+ * At clean shutdown, it overwrites the manifest with clean_shutdown_ true after detaching the
+ * shared memories without releasing them.
+ * The next master re-attaches them only when the manifest is clean and the memory layout
+ * is the same. Otherwise, it reclaims them and allocates new shared memories.
+ *
+ * This is a POD written to the file as-is, so it can be read only by the same binary format.
+ */
+struct SharedMemoryManifest CXX11_FINAL {
+  /** A magic word to detect a broken or foreign file. */
+  static const uint64_t kMagicWord = 0x3154534E4D48535FULL;  // "_SHMNST1"
+
+  void clear() { std::memset(this, 0, sizeof(SharedMemoryManifest)); }
+  /** Marks all shared memories in this manifest for release without attaching them. */
+  void reclaim_all() const;
+
+  ErrorStack load_from_file(const std::string& path);
+  ErrorStack save_to_file(const std::string& path) const;
+
+  uint64_t            magic_word_;
+  /** Whether the shared memories were retained by a clean shutdown. */
+  bool                clean_shutdown_;
+  SocId               soc_count_;
+  /** @see SharedMemoryRepo::calculate_layout_fingerprint() */
+  uint64_t            layout_fingerprint_;
+  uint64_t            global_memory_size_;
+  uint64_t            node_memory_size_;
+  /** Durable epoch at the clean shutdown. Volatile pages contain nothing newer than this. */
+  Epoch::EpochInteger durable_epoch_;
+  key_t               global_memory_key_;
+  key_t               node_memory_keys_[kMaxSocs];
+};
+
 /**
  * @brief Repository of all shared memory in one FOEDUS instance.
  * @ingroup SOC
@@ -493,6 +553,39 @@ class SharedMemoryRepo CXX11_FINAL {
     SocId my_soc_id,
     EngineOptions* options);
 
+  /**
+   * @brief Master process re-attaches shared memories retained by a previous master process
+   * instead of allocating new ones.
+   * @param[in] upid Universal (or Unique) ID of this master process.
+   * @param[in] eid Engine ID of this master process.
+   * @param[in] options Options of this engine. The memory layout must be the same as the
+   * retained one, which the caller checks via the manifest.
+   * @param[in] manifest Describes the retained shared memories.
+   * @details
+   * The contents of the shared memories are kept as they are except the serialized options.
+   * On error, this method detaches everything it attached without releasing it.
+   */
+  ErrorStack  reattach_shared_memories(
+    uint64_t upid,
+    Eid eid,
+    const EngineOptions& options,
+    const SharedMemoryManifest& manifest);
+
+  /**
+   * Fills the manifest that describes the shared memories this master process currently owns.
+   * The manifest is not yet a clean one.
+   */
+  void        describe_shared_memories(
+    const EngineOptions& options,
+    SharedMemoryManifest* manifest) const;
+
+  /**
+   * @brief Detaches the shared memories without releasing them so that the next master process
+   * can reattach_shared_memories().
+   * @pre mark_for_release() has not been called.
+   */
+  void        retain_shared_memories();
+
   /**
    * @brief Marks shared memories as being removed so that it will be reclaimed when all processes
    * detach it.
@@ -531,8 +624,38 @@ class SharedMemoryRepo CXX11_FINAL {
 
   void* get_volatile_pool(SocId node) { return node_memory_anchors_[node].volatile_page_pool_; }
 
+  /** @copydoc MasterEngineStatus::warm_restarted_ */
+  bool        is_warm_restarted() const {
+    return global_memory_anchors_.master_status_memory_->warm_restarted_;
+  }
+  /** @copydoc MasterEngineStatus::retain_at_shutdown_ */
+  bool        is_retain_at_shutdown() const {
+    return global_memory_anchors_.master_status_memory_->retain_at_shutdown_;
+  }
+  Epoch       get_retained_durable_epoch() const {
+    return Epoch(global_memory_anchors_.master_status_memory_->retained_durable_epoch_);
+  }
+  /** Called by restart manager in master after making everything durable. */
+  void        request_retain_at_shutdown(Epoch durable_epoch) {
+    global_memory_anchors_.master_status_memory_->retained_durable_epoch_ = durable_epoch.value();
+    global_memory_anchors_.master_status_memory_->retain_at_shutdown_ = true;
+  }
+
+  /** Whether warm restart is enabled and also applicable to the given options. */
+  static bool is_warm_restart_enabled(const EngineOptions& options) {
+    // mprotect-ed boundaries and pages are not carried over across processes. let's not bother.
+    return options.restart_.enable_warm_restart_
+      && !options.memory_.rigorous_memory_boundary_check_
+      && !options.memory_.rigorous_page_boundary_check_;
+  }
+
   static uint64_t calculate_global_memory_size(uint64_t xml_size, const EngineOptions& options);
   static uint64_t calculate_node_memory_size(const EngineOptions& options);
+  /**
+   * Returns a hash of everything that determines the placement of objects in the shared
+   * memories. Two engines can share the same shared memories only when this value matches.
+   */
+  static uint64_t calculate_layout_fingerprint(uint64_t xml_size, const EngineOptions& options);
 
  private:
   SocId                 soc_count_;
@@ -21,6 +21,7 @@
 #include <unistd.h>
 #include <sys/types.h>
 
+#include <string>
 #include <thread>
 #include <vector>
 
@@ -52,6 +53,22 @@ class SocManagerPimpl final : public DefaultInitializable {
   /** Called as part of initialize_once() if this is a master engine */
   ErrorStack  initialize_master();
 
+  /**
+   * Called as part of initialize_master(). Re-attaches shared memories retained by a previous
+   * clean shutdown if possible, otherwise allocates new ones.
+   * @see foedus::restart::RestartOptions::enable_warm_restart_
+   */
+  ErrorStack  allocate_or_reattach_shared_memories();
+  /** Whether the retained shared memories in the manifest can be re-attached by this engine. */
+  bool        is_reusable_manifest(const SharedMemoryManifest& manifest, std::string* reason) const;
+  /**
+   * Called as part of uninitialize_once() in master. If requested, detaches the shared memories
+   * without releasing them and writes a clean manifest. Otherwise, removes the manifest.
+   */
+  ErrorStack  retain_or_release_shared_memories();
+  /** Whether warm restart is enabled and also applicable to the current options. */
+  bool        is_warm_restart_enabled() const;
+
   /** Called as part of initialize_once() if this is a child SOC engine */
   ErrorStack  initialize_child();
 
@@ -39,6 +39,14 @@ struct SocOptions CXX11_FINAL : public virtual externalize::Externalizable {
   enum Constants {
     /** default for shared_user_memory_size_kb_ */
     kDefaultSharedUserMemorySizeKb = 4,
+    /** default for client_ring_slots_ */
+    kDefaultClientRingSlots = 0,
+    /** default for client_ring_slot_kb_ */
+    kDefaultClientRingSlotKb = 4,
+    /** default for client_ring_batch_size_ */
+    kDefaultClientRingBatchSize = 32,
+    /** default for client_ring_abandon_timeout_us_ */
+    kDefaultClientRingAbandonTimeoutUs = 1000000,
   };
 
   /**
@@ -84,10 +92,56 @@ struct SocOptions CXX11_FINAL : public virtual externalize::Externalizable {
    */
   fs::FixedPath spawn_ld_library_path_pattern_;
 
+  /**
+   * @brief The number of request slots in the client request ring of each NUMA node.
+   * @details
+   * The default value is 0, which disables client request rings.
+   * When non-zero, each SOC engine creates a ring in a shared memory that external processes
+   * can attach via client_ring_path_pattern_, and idle worker threads in the node run the
+   * procedures requested there. Rounded up to a power of two.
+   * @see ClientRing
+   */
+  uint32_t      client_ring_slots_;
+  /**
+   * @brief Byte size of the input and output of one request in the client request ring, in KB.
+   * @details
+   * The procedure reads its input from and writes its output to the slot in place, so
+   * the input length plus the output buffer size is this value.
+   */
+  uint32_t      client_ring_slot_kb_;
+  /**
+   * @brief The maximum number of requests a worker thread takes from the ring in a row.
+   * @details
+   * A worker notifies clients of completions once per such batch rather than per request.
+   * It also checks its own impersonation requests between batches.
+   */
+  uint16_t      client_ring_batch_size_;
+  /**
+   * @brief A slot in the client request ring is considered abandoned when its client does not
+   * submit it or release it for this long after reserving it or after its completion.
+   * @details
+   * Worker threads skip a reserved slot abandoned this way, and clients reclaim a completed
+   * slot abandoned this way when the ring is full. Slots of dead client processes are handled
+   * the same way regardless of this value.
+   * @see ClientRing
+   */
+  uint32_t      client_ring_abandon_timeout_us_;
+  /**
+   * @brief String pattern of the path of the meta file external processes use to attach the
+   * client request ring of each NUMA node.
+   * @details
+   * A placeholder '$NODE$' is replaced with the NUMA node number.
+   * The default value is "/tmp/foedus_client_ring_node_$NODE$".
+   * Unlike the other shared memories, the ring remains attachable until the engine shuts down.
+   */
+  fs::FixedPath client_ring_path_pattern_;
+
   /** converts spawn_executable_pattern_ into a string with the given node ID. */
   std::string   convert_spawn_executable_pattern(int node) const;
   /** converts spawn_ld_library_path_pattern_ into a string with the given node ID. */
   std::string   convert_spawn_ld_library_path_pattern(int node) const;
+  /** converts client_ring_path_pattern_ into a string with the given node ID. */
+  std::string   convert_client_ring_path_pattern(int node) const;
 
   EXTERNALIZABLE(SocOptions);
 };
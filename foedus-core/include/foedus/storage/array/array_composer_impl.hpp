@@ -152,6 +152,14 @@ class ArrayComposeContext {
   ErrorCode create_empty_pages_recurse(ArrayOffset from, ArrayOffset to, ArrayPage* page);
   ErrorCode create_empty_intermediate_page(ArrayPage* parent, uint16_t index, ArrayRange range);
   ErrorCode create_empty_leaf_page(ArrayPage* parent, uint16_t index, ArrayRange range);
+  /**
+   * Called in finalize() when ArrayStorage::extend() grew the array after the previous snapshot.
+   * Widens right-most pages of the previous snapshot and creates empty pages for the new range
+   * that didn't receive any logs, just like the initial snapshot.
+   * @param[in] page_index relative index of an intermediate page in intermediate_base_.
+   * We use an index rather than a pointer because the intermediate pool might be expanded.
+   */
+  ErrorCode fill_grown_pages(SnapshotPagePointer page_index);
 
   /** call this before obtaining a new intermediate page */
   ErrorCode expand_intermediate_pool_if_needed() ALWAYS_INLINE;
@@ -202,6 +210,13 @@ class ArrayComposeContext {
   const uint16_t                  payload_size_;
   const uint8_t                   levels_;
   const SnapshotPagePointer       previous_root_page_pointer_;
+  /**
+   * The array size the previous snapshot covers. 0 in initial snapshot.
+   * Smaller than the current size if ArrayStorage::extend() was called after the snapshot.
+   */
+  const ArrayOffset               previous_array_size_;
+  /** Number of levels in the previous snapshot. 0 in initial snapshot. */
+  uint8_t                         previous_levels_;
 
   /**
    * The offset interval a single page represents in each level. index=level.
@@ -64,6 +64,24 @@ struct ArrayCreateLogType : public log::StorageLogType {
   friend std::ostream& operator<<(std::ostream& o, const ArrayCreateLogType& v);
 };
 
+/**
+ * @brief Log type of EXTEND ARRAY STORAGE operation.
+ * @ingroup ARRAY LOGTYPE
+ * @details
+ * This log corresponds to ArrayStorage::extend() operation.
+ * Like ArrayCreateLogType, this is a metadata operation.
+ *
+ * This log type is infrequently triggered, so no optimization. All methods defined in cpp.
+ */
+struct ArrayExtendLogType : public log::StorageLogType {
+  LOG_TYPE_NO_CONSTRUCT(ArrayExtendLogType)
+  ArrayOffset     new_array_size_;
+
+  void apply_storage(Engine* engine, StorageId storage_id);
+  void assert_valid();
+  friend std::ostream& operator<<(std::ostream& o, const ArrayExtendLogType& v);
+};
+
 /**
  * @brief A base class for ArrayOverwriteLogType/ArrayIncrementLogType.
  * @ingroup ARRAY LOGTYPE
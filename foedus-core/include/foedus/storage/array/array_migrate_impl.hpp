@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#ifndef FOEDUS_STORAGE_ARRAY_ARRAY_MIGRATE_IMPL_HPP_
+#define FOEDUS_STORAGE_ARRAY_ARRAY_MIGRATE_IMPL_HPP_
+
+#include "foedus/error_code.hpp"
+#include "foedus/storage/fwd.hpp"
+#include "foedus/storage/storage_id.hpp"
+#include "foedus/storage/array/fwd.hpp"
+#include "foedus/thread/fwd.hpp"
+#include "foedus/xct/sysxct_functor.hpp"
+
+namespace foedus {
+namespace storage {
+namespace array {
+
+/**
+ * @brief A system transaction to migrate a volatile leaf page to the NUMA node of this thread.
+ * @ingroup ARRAY
+ * @see SYSXCT
+ * @details
+ * The leaf page is copied into a page grabbed from this thread's node, and the parent's
+ * pointer is swung to the copy. The old page is then marked as moved and retired, and so are
+ * all records in it. Transactions that have the old records in their read/write sets track
+ * the records in the new page, which is at the same offset range, during precommit.
+ * The old page is returned to the pool after the grace period of retired pages.
+ *
+ * This does nothing and returns kErrorCodeOk in the following cases:
+ * \li The pointer no longer points to the page we observed (eg migrated by another thread).
+ * \li The page is already in this thread's node.
+ *
+ * Locks taken in this sysxct (in order of taking):
+ * \li Page-lock of the leaf page.
+ * \li Record-lock of all records in the leaf page (in canonical order).
+ *
+ * This is invoked only between user transactions, so there is no chance of deadlocks.
+ * max_retries=2 should be enough in run_nested_sysxct().
+ */
+struct ArrayMigrateLeaf final : public xct::SysxctFunctor {
+  /** Thread context */
+  thread::Thread* const       context_;
+  /** The pointer in the parent interior page that points to the leaf page */
+  DualPagePointer* const      pointer_;
+  /** The leaf page we observed via pointer_ */
+  const VolatilePagePointer   observed_;
+  /** [Out] whether we migrated the page */
+  bool                        migrated_;
+
+  ArrayMigrateLeaf(
+    thread::Thread* context,
+    DualPagePointer* pointer,
+    VolatilePagePointer observed)
+    : xct::SysxctFunctor(),
+      context_(context),
+      pointer_(pointer),
+      observed_(observed),
+      migrated_(false) {
+  }
+  virtual ErrorCode run(xct::SysxctWorkspace* sysxct_workspace) override;
+};
+
+}  // namespace array
+}  // namespace storage
+}  // namespace foedus
+#endif  // FOEDUS_STORAGE_ARRAY_ARRAY_MIGRATE_IMPL_HPP_
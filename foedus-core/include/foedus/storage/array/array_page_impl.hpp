@@ -70,6 +70,15 @@ class ArrayPage final {
   bool                is_leaf()           const   { return level_ == 0; }
   uint8_t             get_level()         const   { return level_; }
   const ArrayRange&   get_array_range()   const   { return array_range_; }
+  /**
+   * Widens the range of this right-most page to new_end.
+   * Called only when ArrayStorage::extend() grows the array. Records beyond the old end
+   * are already initialized because we initialize all physical records in a page.
+   */
+  void                extend_array_range(ArrayOffset new_end) {
+    ASSERT_ND(new_end >= array_range_.end_);
+    array_range_.end_ = new_end;
+  }
 
   /** Called only when this page is initialized. */
   void                initialize_snapshot_page(
@@ -134,7 +143,8 @@ class ArrayPage final {
    */
   ArrayRange          array_range_;   // +16 -> 64
 
-  // All variables up to here are immutable after the array storage is created.
+  // All variables up to here are immutable after the array storage is created,
+  // except that ArrayStorage::extend() widens array_range_ of right-most pages.
 
   /** Dynamic records in this page. */
   Data                data_;
@@ -35,11 +35,43 @@
 #include "foedus/storage/array/array_route.hpp"
 #include "foedus/storage/array/fwd.hpp"
 #include "foedus/thread/fwd.hpp"
+#include "foedus/xct/xct_id.hpp"
 
 namespace foedus {
 namespace storage {
 namespace array {
 
+/**
+ * @brief Result of ArrayStorage::aggregate_primitive().
+ * @ingroup ARRAY
+ * @details
+ * min_ and max_ are meaningful only when count_ > 0.
+ * sum_ is accumulated in T itself, so use a field type wide enough for the sum.
+ */
+template <typename T>
+struct ArrayAggregateResult {
+  ArrayAggregateResult() : count_(0), sum_(0), min_(0), max_(0) {}
+
+  /** Merges another partial result into this one. */
+  void merge(const ArrayAggregateResult<T>& other) {
+    if (other.count_ == 0) {
+      return;
+    } else if (count_ == 0) {
+      *this = other;
+      return;
+    }
+    count_ += other.count_;
+    sum_ += other.sum_;
+    min_ = other.min_ < min_ ? other.min_ : min_;
+    max_ = other.max_ > max_ ? other.max_ : max_;
+  }
+
+  uint64_t  count_;
+  T         sum_;
+  T         min_;
+  T         max_;
+};
+
 /**
  * @brief Represents a key-value store based on a dense and regular array.
  * @ingroup ARRAY
@@ -62,6 +94,13 @@ class ArrayStorage CXX11_FINAL : public Storage<ArrayStorageControlBlock> {
   const ArrayMetadata*  get_array_metadata()  const;
   ErrorStack          create(const Metadata &metadata);
   ErrorStack          load(const StorageControlBlock& snapshot_block);
+  /**
+   * Sets up this control block as a read-only view of the storage as of a snapshot,
+   * copying the metadata from the snapshot's control block. Unlike load(), this creates no
+   * volatile page, so only snapshot-only transactions can read it.
+   * @see snapshot::SnapshotView
+   */
+  ErrorStack          load_snapshot_view(const StorageControlBlock& snapshot_block);
   ErrorStack          drop();
 
   /**
@@ -101,6 +140,27 @@ class ArrayStorage CXX11_FINAL : public Storage<ArrayStorageControlBlock> {
   /** Returns the number of levels. */
   uint8_t     get_levels() const;
 
+  /**
+   * @brief Extends the size of this array storage.
+   * @param[in] new_array_size The new number of records in this array.
+   * @param[out] commit_epoch The epoch when the extension has happened.
+   * @pre new_array_size <= kMaxArrayOffset
+   * @post new_array_size == get_array_size()
+   * @details
+   * Like SequentialStorage::truncate(), this is a logged metadata operation, and the next
+   * snapshot writes out the new size.
+   * Records in the new range are zero-cleared. When the new size needs more levels,
+   * we put new root pages on top of the current root page. Pages of existing offsets stay
+   * as they are, so concurrent transactions on them are not blocked.
+   * This method waits for an ongoing snapshot, if any.
+   *
+   * Snapshot-only transactions keep reading the snapshot taken before the extension,
+   * which does not contain the new range (kErrorCodeXctNoSnapshotPage) until the next snapshot.
+   * If new_array_size <= get_array_size(), this method does nothing (not an error).
+   */
+  ErrorStack  extend(ArrayOffset new_array_size, Epoch* commit_epoch);
+  void        apply_extend(const ArrayExtendLogType& the_log);
+
   /**
    * @brief Retrieves one record of the given offset in this array storage.
    * @param[in] context Thread context
@@ -167,6 +227,34 @@ class ArrayStorage CXX11_FINAL : public Storage<ArrayStorageControlBlock> {
    */
   ErrorCode get_record_for_write(thread::Thread* context, ArrayOffset offset, Record** record);
 
+  /**
+   * @brief Computes count/sum/min/max of a primitive field over a range of records.
+   * @param[in] context Thread context
+   * @param[in] payload_offset Byte position of the field in each record.
+   * @param[in] from Inclusive beginning of the offset range.
+   * @param[in] to Exclusive end of the offset range. 0 means the end of the array.
+   * @param[in,out] result The aggregate of the range is merged into this object.
+   * @tparam T primitive type. All integers and floats are allowed.
+   * @pre payload_offset + sizeof(T) <= get_payload_size()
+   * @pre from <= to <= get_array_size()
+   * @details
+   * This walks leaf pages directly and aggregates all records in each page in a tight loop,
+   * which is much faster than calling get_record_primitive() for each offset.
+   * Records in snapshot pages need no validation. For records in volatile pages,
+   * serializable transactions add them to read-set as usual, so a huge range might cause
+   * read-set overflow. Other isolation levels check that no record in the page changed
+   * during the aggregation, retrying the page otherwise.
+   * For dashboard-like queries over millions of records, consider snapshot-only transactions
+   * (see xct::XctManager::begin_snapshot_only_xct()) or kSnapshot isolation level.
+   */
+  template <typename T>
+  ErrorCode aggregate_primitive(
+    thread::Thread* context,
+    uint16_t payload_offset,
+    ArrayOffset from,
+    ArrayOffset to,
+    ArrayAggregateResult<T>* result);
+
   /** batched interface */
   template <typename T>
   ErrorCode get_record_primitive_batch(
@@ -315,6 +403,23 @@ class ArrayStorage CXX11_FINAL : public Storage<ArrayStorageControlBlock> {
   ErrorStack  hcc_reset_all_temperature_stat();
 
   ErrorStack  verify_single_thread(thread::Thread* context);
+
+  /**
+   * @copydoc foedus::storage::StorageManager::track_moved_record()
+   * @details
+   * Array records move only when their leaf page migrates to another NUMA node.
+   * The record is then at the same index of the leaf page that now covers the same offsets.
+   */
+  xct::TrackMovedRecordResult track_moved_record(
+    xct::RwLockableXctId* old_address,
+    xct::WriteXctAccess* write_set);
+
+  /**
+   * @copydoc foedus::storage::StorageManager::migrate_volatile_page()
+   * @details
+   * page_key is the first offset of a volatile leaf page. The root page is never migrated.
+   */
+  ErrorCode   migrate_volatile_page(thread::Thread* context, uint64_t page_key, bool* migrated);
 };
 
 }  // namespace array
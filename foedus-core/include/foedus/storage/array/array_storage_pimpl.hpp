@@ -27,6 +27,7 @@
 #include "foedus/cxx11.hpp"
 #include "foedus/fwd.hpp"
 #include "foedus/assorted/const_div.hpp"
+#include "foedus/cache/fwd.hpp"
 #include "foedus/memory/fwd.hpp"
 #include "foedus/soc/shared_memory_repo.hpp"
 #include "foedus/storage/fwd.hpp"
@@ -76,6 +77,14 @@ struct ArrayStorageControlBlock final {
    * which might be smaller than the range it can physically contain.
    */
   uint64_t            intervals_[8];
+
+  /**
+   * The array size the root page of the latest snapshot covers.
+   * This is smaller than meta_.array_size_ only when extend() was called after the snapshot.
+   * 0 if there is no snapshot yet. Modified only in extend() and snapshot, which are mutually
+   * exclusive (see snapshot::SnapshotManagerControlBlock::snapshot_mutex_).
+   */
+  ArrayOffset         snapshot_array_size_;
 };
 
 /**
@@ -102,7 +111,52 @@ class ArrayStoragePimpl final {
 
   ErrorStack  create(const Metadata& metadata);
   ErrorStack  load(const StorageControlBlock& snapshot_block);
+  ErrorStack  load_snapshot_view(const StorageControlBlock& snapshot_block);
   ErrorStack  load_empty();
+  ErrorStack  extend(ArrayOffset new_array_size, Epoch* commit_epoch);
+  void        apply_extend(const ArrayExtendLogType& the_log);
+
+  /**
+   * Calculates the route finder and intervals for the given array size without publishing them.
+   * @param[out] intervals intervals of each level, kMaxLevels entries
+   * @return the number of levels
+   */
+  uint8_t     calculate_route(
+    ArrayOffset array_size,
+    LookupRouteFinder* route_finder,
+    uint64_t* intervals) const;
+  /**
+   * Sets route_finder_ and intervals_ for the given array size and returns the number of levels.
+   * Setting them for a larger size does not affect the routes of existing offsets.
+   */
+  uint8_t     set_route(ArrayOffset array_size);
+  /**
+   * The first half of extend(), which might fail but changes nothing visible to transactions.
+   * This installs volatile pages in the right-most path as transactions would do, and
+   * grabs new root pages if the new size needs more levels.
+   * The routes for the new size are calculated locally. route_finder_ and intervals_ are not
+   * modified until commit_extend().
+   * @param[out] new_roots new pages of level-x to put above the current root. index=level.
+   */
+  ErrorStack  prepare_extend(
+    cache::SnapshotFileSet* fileset,
+    ArrayOffset new_array_size,
+    VolatilePagePointer* new_roots);
+  /**
+   * The second half of extend(), which never fails. This widens the right-most pages,
+   * installs the new root pages, then publishes the new routes and size.
+   */
+  void        commit_extend(ArrayOffset new_array_size, const VolatilePagePointer* new_roots);
+  /**
+   * Called right after the volatile root page is loaded from the root snapshot page.
+   * The snapshot might be taken before extend(), so this grows volatile pages to the current size.
+   */
+  ErrorStack  grow_volatile_pages(cache::SnapshotFileSet* fileset);
+  /**
+   * Releases all volatile pages except the root page.
+   * Called when restart overwrites the root volatile page with the recovered snapshot.
+   */
+  void        release_volatile_pages_except_root();
 
   void        report_page_distribution();
 
@@ -122,6 +176,24 @@ class ArrayStoragePimpl final {
   ErrorStack  hcc_reset_all_temperature_stat();
   ErrorStack  hcc_reset_all_temperature_stat_intermediate(VolatilePagePointer intermediate_page_id);
 
+  xct::TrackMovedRecordResult track_moved_record(xct::RwLockableXctId* old_address);
+  ErrorCode   migrate_volatile_page(
+    thread::Thread* context,
+    ArrayOffset leaf_begin,
+    bool* migrated);
+  /**
+   * Follows volatile pointers from the root page to the pointer to the leaf page that
+   * contains the offset. Returns null if the root page is a leaf or the volatile page on the
+   * way doesn't exist. This takes no pointer set or lock.
+   */
+  DualPagePointer* find_volatile_leaf_pointer(ArrayOffset offset);
+  /**
+   * Records the leaf page we have just reached to the sampled remote accesses of the thread
+   * if the page is in another NUMA node.
+   * @see StorageOptions::volatile_page_migration_sample_interval_
+   */
+  void        sample_remote_leaf(thread::Thread* context, const ArrayPage* leaf) ALWAYS_INLINE;
+
   /** defined in array_storage_prefetch.cpp */
   ErrorCode   prefetch_pages(
     thread::Thread* context,
@@ -137,6 +209,20 @@ class ArrayStoragePimpl final {
     ArrayOffset to,
     ArrayPage* page);
 
+  template <typename T>
+  ErrorCode   aggregate_primitive(
+    thread::Thread* context,
+    uint16_t payload_offset,
+    ArrayOffset from,
+    ArrayOffset to,
+    ArrayAggregateResult<T>* result);
+  template <typename T>
+  ErrorCode   aggregate_primitive_volatile_page(
+    Record* first_record,
+    uint16_t payload_offset,
+    uint16_t count,
+    ArrayAggregateResult<T>* result);
+
   // all per-record APIs are called so frequently, so returns ErrorCode rather than ErrorStack
   ErrorCode   locate_record_for_read(
     thread::Thread* context,
@@ -334,6 +420,19 @@ inline ErrorCode ArrayStoragePimpl::follow_pointer(
 }
 
 
+inline void ArrayStoragePimpl::sample_remote_leaf(
+  thread::Thread* context,
+  const ArrayPage* leaf) {
+  ASSERT_ND(leaf->is_leaf());
+  if (leaf->header().snapshot_) {
+    return;
+  }
+  VolatilePagePointer page_id = construct_volatile_page_pointer(leaf->header().page_id_);
+  if (UNLIKELY(page_id.get_numa_node() != context->get_numa_node())) {
+    context->sample_remote_volatile_page(get_id(), leaf->get_array_range().begin_);
+  }
+}
+
 inline ErrorCode ArrayStoragePimpl::get_root_page(
   thread::Thread* context,
   bool for_write,
@@ -27,6 +27,7 @@ namespace storage {
 namespace array {
 struct  ArrayCommonUpdateLogType;
 struct  ArrayCreateLogType;
+struct  ArrayExtendLogType;
 struct  ArrayIncrementLogType;
 struct  ArrayMetadata;
 struct  ArrayOverwriteLogType;
@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#ifndef FOEDUS_STORAGE_DELTA_UPDATE_HPP_
+#define FOEDUS_STORAGE_DELTA_UPDATE_HPP_
+#include <stdint.h>
+
+#include <cstring>
+
+#include "foedus/assert_nd.hpp"
+#include "foedus/compiler.hpp"
+
+/**
+ * @file foedus/storage/delta_update.hpp
+ * @brief Blind and commutative updates on a primitive value in a payload.
+ * @ingroup STORAGE
+ * @details
+ * A delta update modifies a primitive value at some payload offset without reading it,
+ * eg "add 10 to the 8-byte integer at offset 16". As the result does not depend on which
+ * transaction applies first, two transactions that apply deltas to the same record do not
+ * conflict. The transaction thus takes only a write-set, no read-set, and the delta is applied
+ * under the record lock at precommit. Snapshot composers re-apply the same deltas in
+ * serialization order.
+ *
+ * Masstree and hash storages provide this as delta_record(). A delta log stores the operand as
+ * its payload and the operator/type in one byte, see encode_delta_tag().
+ */
+namespace foedus {
+namespace storage {
+
+/** Commutative operators of delta updates. */
+enum DeltaOperator {
+  /** value += operand */
+  kDeltaAdd = 1,
+  /** value = min(value, operand) */
+  kDeltaMin = 2,
+  /** value = max(value, operand) */
+  kDeltaMax = 3,
+  /** value |= operand. Integer types only. */
+  kDeltaBitOr = 4,
+};
+
+/** Primitive types delta updates can work on. */
+enum DeltaValueType {
+  kDeltaUnknown = 0,
+  kDeltaI8 = 1,
+  kDeltaI16,
+  kDeltaI32,
+  kDeltaI64,
+  kDeltaU8,
+  kDeltaU16,
+  kDeltaU32,
+  kDeltaU64,
+  kDeltaFloat,
+  kDeltaDouble,
+};
+
+template <typename T> DeltaValueType to_delta_value_type();
+template <> inline DeltaValueType to_delta_value_type<int8_t>() { return kDeltaI8; }
+template <> inline DeltaValueType to_delta_value_type<int16_t>() { return kDeltaI16; }
+template <> inline DeltaValueType to_delta_value_type<int32_t>() { return kDeltaI32; }
+template <> inline DeltaValueType to_delta_value_type<int64_t>() { return kDeltaI64; }
+template <> inline DeltaValueType to_delta_value_type<uint8_t>() { return kDeltaU8; }
+template <> inline DeltaValueType to_delta_value_type<uint16_t>() { return kDeltaU16; }
+template <> inline DeltaValueType to_delta_value_type<uint32_t>() { return kDeltaU32; }
+template <> inline DeltaValueType to_delta_value_type<uint64_t>() { return kDeltaU64; }
+template <> inline DeltaValueType to_delta_value_type<float>() { return kDeltaFloat; }
+template <> inline DeltaValueType to_delta_value_type<double>() { return kDeltaDouble; }
+
+/**
+ * @brief Returns whether the operator is valid for the type.
+ * @details
+ * delta_record() methods check this and return kErrorCodeInvalidParameter otherwise.
+ */
+template <typename T>
+inline bool is_valid_delta(DeltaOperator op) {
+  if (op == kDeltaAdd || op == kDeltaMin || op == kDeltaMax) {
+    return true;
+  }
+  DeltaValueType type = to_delta_value_type<T>();
+  return op == kDeltaBitOr && type != kDeltaFloat && type != kDeltaDouble;
+}
+
+/** Operator in higher 4 bits, value type in lower 4 bits. Stored in the delta log types. */
+inline uint8_t encode_delta_tag(DeltaOperator op, DeltaValueType type) {
+  return static_cast<uint8_t>((op << 4) | type);
+}
+inline DeltaOperator decode_delta_operator(uint8_t tag) {
+  return static_cast<DeltaOperator>(tag >> 4);
+}
+inline DeltaValueType decode_delta_value_type(uint8_t tag) {
+  return static_cast<DeltaValueType>(tag & 0x0F);
+}
+
+template <typename T>
+inline T delta_bit_or(T value, T operand) { return value | operand; }
+template <>
+inline float delta_bit_or<float>(float value, float /*operand*/) {
+  ASSERT_ND(false);  // rejected in delta_record()
+  return value;
+}
+template <>
+inline double delta_bit_or<double>(double value, double /*operand*/) {
+  ASSERT_ND(false);
+  return value;
+}
+
+/**
+ * Applies one delta to target. Unlike ArrayIncrementLogType, target might not be aligned
+ * (hash payloads are not), so we load/store via memcpy.
+ */
+template <typename T>
+inline void apply_delta_typed(DeltaOperator op, const void* operand, void* target) {
+  T value;
+  T delta;
+  std::memcpy(&value, target, sizeof(T));
+  std::memcpy(&delta, operand, sizeof(T));
+  switch (op) {
+    case kDeltaAdd:
+      value += delta;
+      break;
+    case kDeltaMin:
+      if (delta < value) {
+        value = delta;
+      }
+      break;
+    case kDeltaMax:
+      if (delta > value) {
+        value = delta;
+      }
+      break;
+    case kDeltaBitOr:
+      value = delta_bit_or<T>(value, delta);
+      break;
+    default:
+      ASSERT_ND(false);
+      break;
+  }
+  std::memcpy(target, &value, sizeof(T));
+}
+
+/**
+ * @brief Applies the delta of the given tag and operand to target.
+ * @param[in] tag operator and type, see encode_delta_tag()
+ * @param[in] operand the operand, whose length is that of the type
+ * @param[in,out] target the value to modify in the record's payload
+ */
+inline void apply_delta(uint8_t tag, const void* operand, void* target) {
+  DeltaOperator op = decode_delta_operator(tag);
+  switch (decode_delta_value_type(tag)) {
+    case kDeltaI8:
+      apply_delta_typed<int8_t>(op, operand, target);
+      break;
+    case kDeltaI16:
+      apply_delta_typed<int16_t>(op, operand, target);
+      break;
+    case kDeltaI32:
+      apply_delta_typed<int32_t>(op, operand, target);
+      break;
+    case kDeltaI64:
+      apply_delta_typed<int64_t>(op, operand, target);
+      break;
+    case kDeltaU8:
+      apply_delta_typed<uint8_t>(op, operand, target);
+      break;
+    case kDeltaU16:
+      apply_delta_typed<uint16_t>(op, operand, target);
+      break;
+    case kDeltaU32:
+      apply_delta_typed<uint32_t>(op, operand, target);
+      break;
+    case kDeltaU64:
+      apply_delta_typed<uint64_t>(op, operand, target);
+      break;
+    case kDeltaFloat:
+      apply_delta_typed<float>(op, operand, target);
+      break;
+    case kDeltaDouble:
+      apply_delta_typed<double>(op, operand, target);
+      break;
+    default:
+      ASSERT_ND(false);
+      break;
+  }
+}
+
+/**
+ * Sanity check of a delta log's payload-count against its tag.
+ */
+inline bool is_valid_delta_tag(uint8_t tag, uint16_t payload_count) {
+  DeltaOperator op = decode_delta_operator(tag);
+  if (op < kDeltaAdd || op > kDeltaBitOr) {
+    return false;
+  }
+  switch (decode_delta_value_type(tag)) {
+    case kDeltaI8:
+    case kDeltaU8:
+      return payload_count == 1U;
+    case kDeltaI16:
+    case kDeltaU16:
+      return payload_count == 2U;
+    case kDeltaI32:
+    case kDeltaU32:
+    case kDeltaFloat:
+      return payload_count == 4U;
+    case kDeltaI64:
+    case kDeltaU64:
+    case kDeltaDouble:
+      return payload_count == 8U;
+    default:
+      return false;
+  }
+}
+
+}  // namespace storage
+}  // namespace foedus
+#endif  // FOEDUS_STORAGE_DELTA_UPDATE_HPP_
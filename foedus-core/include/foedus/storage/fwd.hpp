@@ -32,6 +32,7 @@ struct  Metadata;
 struct  Page;
 struct  PageVersion;
 class   Partitioner;
+struct  PartitionerAccessStatistics;
 struct  PartitionerMetadata;
 struct  Record;
 struct  StorageControlBlock;
@@ -35,6 +35,7 @@ struct  HashComposedBinsPage;
 struct  HashCreateLogType;
 class   HashDataPage;
 struct  HashDeleteLogType;
+struct  HashDeltaLogType;
 struct  HashInsertLogType;
 class   HashIntermediatePage;
 class   HashPartitioner;
@@ -27,6 +27,7 @@
 #include "foedus/assorted/assorted_func.hpp"
 #include "foedus/log/common_log_types.hpp"
 #include "foedus/log/log_type.hpp"
+#include "foedus/storage/delta_update.hpp"
 #include "foedus/storage/record.hpp"
 #include "foedus/storage/storage_id.hpp"
 #include "foedus/storage/hash/fwd.hpp"
@@ -163,7 +164,8 @@ struct HashCommonLogType : public log::RecordLogType {
     ASSERT_ND(header_.log_type_code_ == log::kLogCodeHashOverwrite
       || header_.log_type_code_ == log::kLogCodeHashInsert
       || header_.log_type_code_ == log::kLogCodeHashDelete
-      || header_.log_type_code_ == log::kLogCodeHashUpdate);
+      || header_.log_type_code_ == log::kLogCodeHashUpdate
+      || header_.log_type_code_ == log::kLogCodeHashDelta);
     ASSERT_ND(hash_ == hashinate(get_key(), key_length_));
   }
 
@@ -431,6 +433,79 @@ struct HashOverwriteLogType : public HashCommonLogType {
   friend std::ostream& operator<<(std::ostream& o, const HashOverwriteLogType& v);
 };
 
+/**
+ * @brief Log type of hash-storage's delta-update operation.
+ * @ingroup HASH LOGTYPE
+ * @details
+ * Same layout as overwrite log. The payload is the operand, and reserved_ stores the
+ * operator and type of the operand (see encode_delta_tag()).
+ * Unlike overwrite, the transaction did not read the record, so the record might have been
+ * deleted or shrunk since then. precommit checks is_applicable() after locking the record.
+ */
+struct HashDeltaLogType : public HashCommonLogType {
+  LOG_TYPE_NO_CONSTRUCT(HashDeltaLogType)
+
+  template <typename PAYLOAD>
+  void            populate(
+    StorageId   storage_id,
+    const void* key,
+    uint16_t    key_length,
+    uint8_t     bin_bits,
+    HashValue   hash,
+    DeltaOperator op,
+    PAYLOAD     operand,
+    uint16_t    payload_offset) {
+    log::LogCode type = log::kLogCodeHashDelta;
+    populate_base(
+      type,
+      storage_id,
+      key,
+      key_length,
+      bin_bits,
+      hash,
+      &operand,
+      payload_offset,
+      sizeof(PAYLOAD));
+    reserved_ = encode_delta_tag(op, to_delta_value_type<PAYLOAD>());
+  }
+
+  /**
+   * Whether the delta can be applied to the record as of now.
+   * @pre owner_id is locked by this thread
+   */
+  bool            is_applicable(const xct::RwLockableXctId* owner_id) const ALWAYS_INLINE {
+    if (owner_id->xct_id_.is_deleted()) {
+      return false;
+    }
+    // In HashDataPage::Slot, [3] is payload_length_
+    const uint16_t* lengthes = reinterpret_cast<const uint16_t*>(owner_id + 1);
+    return lengthes[3] >= payload_offset_ + payload_count_;
+  }
+
+  void            apply_record(
+    thread::Thread* /*context*/,
+    StorageId /*storage_id*/,
+    xct::RwLockableXctId* owner_id,
+    char* data) ALWAYS_INLINE {
+    ASSERT_ND(!owner_id->xct_id_.is_deleted());
+    ASSERT_ND(!owner_id->xct_id_.is_next_layer());
+    ASSERT_ND(!owner_id->xct_id_.is_moved());
+    ASSERT_ND(is_applicable(owner_id));
+    assert_record_and_log_keys(owner_id, data);
+    apply_delta(reserved_, get_payload(), data + get_key_length_aligned() + payload_offset_);
+  }
+
+  void            assert_valid() ALWAYS_INLINE {
+    assert_valid_generic();
+    assert_type();
+    ASSERT_ND(header_.log_length_ == calculate_log_length(key_length_, payload_count_));
+    ASSERT_ND(header_.get_type() == log::kLogCodeHashDelta);
+    ASSERT_ND(is_valid_delta_tag(reserved_, payload_count_));
+  }
+
+  friend std::ostream& operator<<(std::ostream& o, const HashDeltaLogType& v);
+};
+
 }  // namespace hash
 }  // namespace storage
 }  // namespace foedus
@@ -23,6 +23,7 @@
 #include "foedus/attachable.hpp"
 #include "foedus/cxx11.hpp"
 #include "foedus/fwd.hpp"
+#include "foedus/storage/delta_update.hpp"
 #include "foedus/storage/fwd.hpp"
 #include "foedus/storage/storage.hpp"
 #include "foedus/storage/storage_id.hpp"
@@ -68,6 +69,13 @@ class HashStorage CXX11_FINAL : public Storage<HashStorageControlBlock> {
   uint16_t            get_root_children() const;
   ErrorStack          create(const Metadata &metadata);
   ErrorStack          load(const StorageControlBlock& snapshot_block);
+  /**
+   * Sets up this control block as a read-only view of the storage as of a snapshot,
+   * copying the metadata from the snapshot's control block. Unlike load(), this creates no
+   * volatile page, so only snapshot-only transactions can read it.
+   * @see snapshot::SnapshotView
+   */
+  ErrorStack          load_snapshot_view(const StorageControlBlock& snapshot_block);
   ErrorStack          drop();
   friend std::ostream& operator<<(std::ostream& o, const HashStorage& v);
 
@@ -584,6 +592,60 @@ class HashStorage CXX11_FINAL : public Storage<HashStorageControlBlock> {
     const HashCombo& combo,
     PAYLOAD* value,
     uint16_t payload_offset);
+
+  // delta_record() methods
+
+  /**
+   * @brief Blindly applies a commutative delta (add/min/max/bit-or) to a primitive value
+   * in the record.
+   * @param[in] context Thread context
+   * @param[in] key Arbitrary length of key.
+   * @param[in] key_length Byte size of key.
+   * @param[in] op The operator. kDeltaBitOr is allowed only for integer types.
+   * @param[in] operand The operand of the operator.
+   * @param[in] payload_offset We modify this byte position of the record.
+   * @pre payload_offset + sizeof(PAYLOAD) must be within the record's actual payload size
+   * (returns kErrorCodeStrTooShortPayload if not)
+   * @tparam PAYLOAD primitive type of the payload. all integers and floats are allowed.
+   * @details
+   * Unlike increment_record(), this does not return the resulting value, thus does not take
+   * read-set on the record. Concurrent delta_record() on the same record do not abort each
+   * other. See MasstreeStorage::delta_record() for more details.
+   */
+  template <typename PAYLOAD>
+  inline ErrorCode delta_record(
+    thread::Thread* context,
+    const void* key,
+    uint16_t key_length,
+    DeltaOperator op,
+    PAYLOAD operand,
+    uint16_t payload_offset) {
+    HashCombo c(combo(key, key_length));
+    return delta_record(context, key, key_length, c, op, operand, payload_offset);
+  }
+
+  /** Overlord to receive key as a primitive type. */
+  template <typename KEY, typename PAYLOAD>
+  inline ErrorCode delta_record(
+    thread::Thread* context,
+    KEY key,
+    DeltaOperator op,
+    PAYLOAD operand,
+    uint16_t payload_offset) {
+    HashCombo c(combo<KEY>(&key));
+    return delta_record(context, &key, sizeof(key), c, op, operand, payload_offset);
+  }
+
+  /** If you have already computed HashCombo, use this. */
+  template <typename PAYLOAD>
+  ErrorCode       delta_record(
+    thread::Thread* context,
+    const void* key,
+    uint16_t key_length,
+    const HashCombo& combo,
+    DeltaOperator op,
+    PAYLOAD operand,
+    uint16_t payload_offset);
 };
 }  // namespace hash
 }  // namespace storage
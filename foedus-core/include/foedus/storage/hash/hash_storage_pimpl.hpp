@@ -31,6 +31,7 @@
 #include "foedus/cache/fwd.hpp"
 #include "foedus/memory/fwd.hpp"
 #include "foedus/soc/shared_memory_repo.hpp"
+#include "foedus/storage/delta_update.hpp"
 #include "foedus/storage/fwd.hpp"
 #include "foedus/storage/storage.hpp"
 #include "foedus/storage/storage_id.hpp"
@@ -155,6 +156,7 @@ class HashStoragePimpl final : public Attachable<HashStorageControlBlock> {
 
   ErrorStack  create(const HashMetadata& metadata);
   ErrorStack  load(const StorageControlBlock& snapshot_block);
+  ErrorStack  load_snapshot_view(const StorageControlBlock& snapshot_block);
   ErrorStack  drop();
 
   bool                exists()    const { return control_block_->exists(); }
@@ -284,6 +286,17 @@ class HashStoragePimpl final : public Attachable<HashStorageControlBlock> {
     PAYLOAD* value,
     uint16_t payload_offset);
 
+  /** @see foedus::storage::hash::HashStorage::delta_record() */
+  template <typename PAYLOAD>
+  ErrorCode   delta_record(
+    thread::Thread* context,
+    const void* key,
+    uint16_t key_length,
+    const HashCombo& combo,
+    DeltaOperator op,
+    PAYLOAD operand,
+    uint16_t payload_offset);
+
   /**
    * Retrieves the root page of this storage.
    */
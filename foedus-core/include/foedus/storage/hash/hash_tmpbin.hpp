@@ -257,6 +257,21 @@ class HashTmpBin CXX11_FINAL {
     uint16_t payload_offset,
     uint16_t payload_count);
 
+  /**
+   * @brief Applies a delta (see foedus/storage/delta_update.hpp) to the record of the given key.
+   * @details
+   * Same as overwrite_record() except this applies the operator of delta_tag to the payload.
+   */
+  ErrorCode delta_record(
+    xct::XctId xct_id,
+    const void* key,
+    uint16_t key_length,
+    HashValue hash,
+    uint8_t delta_tag,
+    const void* operand,
+    uint16_t payload_offset,
+    uint16_t payload_count);
+
   /**
    * @brief Updates a record of the given key with the given payload, which might change length.
    * @details
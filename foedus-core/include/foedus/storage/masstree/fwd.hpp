@@ -30,6 +30,7 @@ struct  MasstreeCommonLogType;
 struct  MasstreeCreateLogType;
 class   MasstreeCursor;
 struct  MasstreeDeleteLogType;
+struct  MasstreeDeltaLogType;
 struct  MasstreeInsertLogType;
 class   MasstreeIntermediatePage;
 struct  MasstreeMetadata;
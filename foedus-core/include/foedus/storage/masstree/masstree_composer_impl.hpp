@@ -238,13 +238,20 @@ class MasstreeComposeContext {
       KeySlice slice = normalize_be_bytes_full_aligned(key + layer_ * kSliceLen);
       return contains_slice(slice);
     }
+    /**
+     * Whether the next original record comes before or at the key.
+     * In the same slice, shorter keys come first, and longer keys share the next layer.
+     * The record of the same key is consumed too so that delete/update/overwrite/delta logs
+     * can find it as the tail record.
+     */
     bool needs_to_consume_original(KeySlice slice, KeyLength key_length) const {
+      const KeyLength remainder = key_length - layer_ * kSliceLen;
       return has_next_original()
         && (
           next_original_slice_ < slice
           || (next_original_slice_ == slice
-              && next_original_remainder_ > kSliceLen
-              && key_length > (layer_ + 1U) * kSliceLen));
+              && (next_original_remainder_ <= remainder
+                || (next_original_remainder_ > kSliceLen && remainder > kSliceLen))));
     }
 
     friend std::ostream& operator<<(std::ostream& o, const PathLevel& v);
@@ -27,6 +27,7 @@
 #include "foedus/assorted/assorted_func.hpp"
 #include "foedus/log/common_log_types.hpp"
 #include "foedus/log/log_type.hpp"
+#include "foedus/storage/delta_update.hpp"
 #include "foedus/storage/page.hpp"
 #include "foedus/storage/record.hpp"
 #include "foedus/storage/storage_id.hpp"
@@ -472,6 +473,72 @@ struct MasstreeOverwriteLogType : public MasstreeCommonLogType {
   friend std::ostream& operator<<(std::ostream& o, const MasstreeOverwriteLogType& v);
 };
 
+/**
+ * @brief Log type of masstree-storage's delta-update operation.
+ * @ingroup MASSTREE LOGTYPE
+ * @details
+ * Same layout as overwrite log. The payload is the operand, and reserved_ stores the
+ * operator and type of the operand (see encode_delta_tag()).
+ * Unlike overwrite, the transaction did not read the record, so the record might have been
+ * deleted or shrunk since then. precommit checks is_applicable() after locking the record.
+ */
+struct MasstreeDeltaLogType : public MasstreeCommonLogType {
+  LOG_TYPE_NO_CONSTRUCT(MasstreeDeltaLogType)
+
+  template <typename PAYLOAD>
+  void            populate(
+    StorageId   storage_id,
+    const void* key,
+    KeyLength   key_length,
+    DeltaOperator op,
+    PAYLOAD     operand,
+    PayloadLength payload_offset) {
+    log::LogCode type = log::kLogCodeMasstreeDelta;
+    ASSERT_ND(key_length > 0U);
+    populate_base(type, storage_id, key, key_length, &operand, payload_offset, sizeof(PAYLOAD));
+    reserved_ = encode_delta_tag(op, to_delta_value_type<PAYLOAD>());
+  }
+
+  /**
+   * Whether the delta can be applied to the record as of now.
+   * @pre owner_id is locked by this thread
+   */
+  bool            is_applicable(const xct::RwLockableXctId* owner_id) const ALWAYS_INLINE {
+    if (owner_id->xct_id_.is_deleted()) {
+      return false;
+    }
+    // See apply_record_prepare() for the layout. [3]: payload_length_
+    const uint16_t* lengthes = reinterpret_cast<const uint16_t*>(owner_id + 1);
+    return lengthes[3] >= payload_offset_ + payload_count_;
+  }
+
+  void            apply_record(
+    thread::Thread* /*context*/,
+    StorageId /*storage_id*/,
+    xct::RwLockableXctId* owner_id,
+    char* data) const ALWAYS_INLINE {
+    RecordAddresses addresses = apply_record_prepare(owner_id, data);
+    ASSERT_ND(!owner_id->xct_id_.is_deleted());
+    ASSERT_ND(*addresses.record_payload_count_ >= payload_count_ + payload_offset_);
+    apply_delta(reserved_, get_payload(), addresses.record_payload_ + payload_offset_);
+  }
+
+  /** Applies the delta on the given payload of an unlocked record, eg in snapshot composers. */
+  void            apply_on_payload(char* payload, PayloadLength payload_length) const {
+    ASSERT_ND(payload_length >= payload_count_ + payload_offset_);
+    apply_delta(reserved_, get_payload(), payload + payload_offset_);
+  }
+
+  void            assert_valid() const ALWAYS_INLINE {
+    assert_valid_generic();
+    ASSERT_ND(header_.log_length_ == calculate_log_length(key_length_, payload_count_));
+    ASSERT_ND(header_.get_type() == log::kLogCodeMasstreeDelta);
+    ASSERT_ND(is_valid_delta_tag(reserved_, payload_count_));
+  }
+
+  friend std::ostream& operator<<(std::ostream& o, const MasstreeDeltaLogType& v);
+};
+
 
 }  // namespace masstree
 }  // namespace storage
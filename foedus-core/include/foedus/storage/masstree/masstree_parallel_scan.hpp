@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#ifndef FOEDUS_STORAGE_MASSTREE_MASSTREE_PARALLEL_SCAN_HPP_
+#define FOEDUS_STORAGE_MASSTREE_MASSTREE_PARALLEL_SCAN_HPP_
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "foedus/cxx11.hpp"
+#include "foedus/error_stack.hpp"
+#include "foedus/fwd.hpp"
+#include "foedus/proc/proc_id.hpp"
+#include "foedus/storage/storage_id.hpp"
+#include "foedus/storage/masstree/masstree_id.hpp"
+#include "foedus/storage/masstree/masstree_storage.hpp"
+#include "foedus/thread/fwd.hpp"
+#include "foedus/xct/xct_id.hpp"
+
+namespace foedus {
+namespace storage {
+namespace masstree {
+
+/**
+ * @brief A key range scanned by one worker of MasstreeParallelScan.
+ * @ingroup MASSTREE
+ * @details
+ * The ranges of partitions are disjoint, ordered by key, and cover the whole range given to
+ * MasstreeParallelScan::design_partitions().
+ */
+struct MasstreeScanPartition {
+  MasstreeScanPartition() : low_infimum_(true), high_supremum_(true), record_count_(0) {}
+
+  /** Inclusive beginning of the range as a big-endian key. Ignored if low_infimum_. */
+  std::string low_key_;
+  /** Exclusive end of the range as a big-endian key. Ignored if high_supremum_. */
+  std::string high_key_;
+  bool        low_infimum_;
+  bool        high_supremum_;
+  /** [OUT] Number of records the worker read in this range. */
+  uint64_t    record_count_;
+  /**
+   * [OUT] Records the worker read, buffered until the merge in MasstreeParallelScan::kOrdered.
+   * Each record is key-length, payload-length, key, then payload.
+   */
+  std::string buffer_;
+};
+
+/**
+ * @brief Runs one logical range scan of a masstree on multiple worker threads.
+ * @ingroup MASSTREE
+ * @details
+ * MasstreeCursor is single-threaded. This class splits a [begin, end) key range into
+ * balanced sub-ranges, runs one cursor per sub-range on worker threads of ThreadPool,
+ * and hands the records to a user-given handler.
+ *
+ * @par Partitioning
+ * design_partitions() uses the boundaries of border pages in the first layer as the candidates
+ * of sub-range boundaries: those of volatile pages (see
+ * MasstreeStorage::peek_volatile_page_boundaries()) and those in intermediate pages of the
+ * latest snapshot. Picking every n-th candidate gives sub-ranges of roughly the same number of pages.
+ * Like peeking, this is opportunistic. The boundaries are just hints, so concurrent
+ * modifications only make the partitions less balanced, not incorrect.
+ *
+ * @par Merging
+ * In kUnordered mode, each worker calls the handler as it reads records, so the handler is
+ * called concurrently from multiple threads. Use the partition argument to keep
+ * per-partition states without synchronization, e.g., partial aggregates.
+ * In kOrdered mode, each worker buffers records in its partition, and execute() calls the
+ * handler in key order on the calling thread after all workers are done.
+ *
+ * @par Transactions
+ * Each worker runs a separate transaction on its partition. Hence the scan as a whole is not
+ * atomic unless all workers read the same snapshot; set snapshot_only_ for that, which also
+ * avoids read-set overflow in huge scans (see xct::XctManager::begin_snapshot_only_xct()).
+ * If a worker fails (e.g. race abort), execute() returns the error. In kUnordered mode the
+ * handler might have already received some records of the failed partition.
+ *
+ * @par Procedure registration
+ * Workers run the procedure returned by get_worker_proc(). Pre-register it before initializing
+ * the engine:
+ * @code{.cpp}
+ * engine.get_proc_manager()->pre_register(MasstreeParallelScan::get_worker_proc());
+ * @endcode
+ * As workers access this object and the handler via pointers, this works only when child SOCs
+ * are of kChildEmulated type.
+ */
+class MasstreeParallelScan CXX11_FINAL {
+ public:
+  enum MergeMode {
+    /** The handler is called concurrently from workers in no particular order. */
+    kUnordered = 0,
+    /** The handler is called on the calling thread in key order. */
+    kOrdered = 1,
+  };
+
+  /**
+   * Receives each record. In kOrdered mode, the key and payload are valid only during the call.
+   * Returning an error stops the worker of the partition.
+   */
+  typedef ErrorCode (*RecordHandler)(
+    void* user_context,
+    uint16_t partition,
+    const char* key,
+    KeyLength key_length,
+    const char* payload,
+    PayloadLength payload_length);
+
+  /** Arguments of execute() */
+  struct ExecuteArguments {
+    ExecuteArguments()
+      : merge_mode_(kUnordered),
+        isolation_level_(xct::kSerializable),
+        snapshot_only_(false),
+        handler_(CXX11_NULLPTR),
+        user_context_(CXX11_NULLPTR) {}
+    MergeMode           merge_mode_;
+    /** Isolation level of each worker's transaction. Ignored if snapshot_only_. */
+    xct::IsolationLevel isolation_level_;
+    /** Whether workers read only the latest snapshot. */
+    bool                snapshot_only_;
+    RecordHandler       handler_;
+    /** Arbitrary pointer given to handler_ */
+    void*               user_context_;
+  };
+
+  /** Name of the procedure workers run. */
+  static const char* const kWorkerProcName;
+  /** Returns the procedure workers run, which must be pre-registered. */
+  static proc::ProcAndName get_worker_proc();
+
+  MasstreeParallelScan(Engine* engine, StorageId storage_id);
+
+  /**
+   * @brief Splits [begin_key, end_key) into at most desired_partitions sub-ranges.
+   * @param[in] begin_key Inclusive beginning of the range. null or 0 length means infimum,
+   * like MasstreeCursor::open().
+   * @param[in] begin_key_length byte length of begin_key
+   * @param[in] end_key Exclusive end of the range. null or 0 length means supremum.
+   * @param[in] end_key_length byte length of end_key
+   * @param[in] desired_partitions Usually the number of worker threads to use.
+   * @details
+   * This method does not need a thread context. It might return fewer partitions than desired
+   * when the storage or the range is small.
+   */
+  ErrorStack  design_partitions(
+    const void* begin_key,
+    KeyLength begin_key_length,
+    const void* end_key,
+    KeyLength end_key_length,
+    uint16_t desired_partitions);
+
+  const std::vector<MasstreeScanPartition>& get_partitions() const { return partitions_; }
+
+  /**
+   * @brief Scans all partitions in parallel and waits for the completion.
+   * @param[in] context The caller's thread context if the caller is a worker thread that is not
+   * running a transaction, otherwise null. When no worker thread is available, we scan the
+   * partition on this context rather than failing.
+   * @param[in] args handler etc.
+   * @pre design_partitions() was called.
+   */
+  ErrorStack  execute(thread::Thread* context, const ExecuteArguments& args);
+
+  /** Sum of record_count_ of all partitions after execute(). */
+  uint64_t    get_total_record_count() const;
+
+ private:
+  /**
+   * Lists up boundary candidates of first-layer pages in (from, to). Sorted, no duplicate.
+   * We stop going down snapshot pages once we find desired_boundaries candidates.
+   */
+  ErrorStack  collect_boundaries(
+    KeySlice from,
+    KeySlice to,
+    uint32_t desired_boundaries,
+    std::vector<KeySlice>* out);
+  /** Scans one partition on the given thread. Called from worker_proc(). */
+  ErrorStack  scan_partition(thread::Thread* context, uint16_t partition);
+  static ErrorStack worker_proc(const proc::ProcArguments& args);
+
+  Engine* const                       engine_;
+  MasstreeStorage                     storage_;
+  std::vector<MasstreeScanPartition>  partitions_;
+  ExecuteArguments                    args_;
+};
+
+}  // namespace masstree
+}  // namespace storage
+}  // namespace foedus
+#endif  // FOEDUS_STORAGE_MASSTREE_MASSTREE_PARALLEL_SCAN_HPP_
@@ -25,6 +25,7 @@
 #include "foedus/cxx11.hpp"
 #include "foedus/fwd.hpp"
 #include "foedus/initializable.hpp"
+#include "foedus/storage/delta_update.hpp"
 #include "foedus/storage/fwd.hpp"
 #include "foedus/storage/storage.hpp"
 #include "foedus/storage/storage_id.hpp"
@@ -58,6 +59,13 @@ class MasstreeStorage CXX11_FINAL : public Storage<MasstreeStorageControlBlock>
   const MasstreeMetadata*  get_masstree_metadata()  const;
   ErrorStack          create(const Metadata &metadata);
   ErrorStack          load(const StorageControlBlock& snapshot_block);
+  /**
+   * Sets up this control block as a read-only view of the storage as of a snapshot,
+   * copying the metadata from the snapshot's control block. Unlike load(), this creates no
+   * volatile page, so only snapshot-only transactions can read it.
+   * @see snapshot::SnapshotView
+   */
+  ErrorStack          load_snapshot_view(const StorageControlBlock& snapshot_block);
   ErrorStack          drop();
   friend std::ostream& operator<<(std::ostream& o, const MasstreeStorage& v);
 
@@ -535,6 +543,50 @@ class MasstreeStorage CXX11_FINAL : public Storage<MasstreeStorageControlBlock>
     PAYLOAD* value,
     PayloadLength payload_offset);
 
+  // delta_record() methods
+
+  /**
+   * @brief Blindly applies a commutative delta (add/min/max/bit-or) to a primitive value
+   * in the record.
+   * @param[in] context Thread context
+   * @param[in] key Arbitrary length of key that is lexicographically (big-endian) evaluated.
+   * @param[in] key_length Byte size of key.
+   * @param[in] op The operator. kDeltaBitOr is allowed only for integer types.
+   * @param[in] operand The operand of the operator.
+   * @param[in] payload_offset We modify this byte position of the record.
+   * @pre payload_offset + sizeof(PAYLOAD) must be within the record's actual payload size
+   * (returns kErrorCodeStrTooShortPayload if not)
+   * @tparam PAYLOAD primitive type of the payload. all integers and floats are allowed.
+   * @details
+   * Unlike increment_record(), this does not return the resulting value, thus does not take
+   * read-set on the record. Concurrent delta_record() on the same record do not abort each
+   * other. The delta is applied under the record lock in precommit, which aborts only if
+   * the record has been deleted or shrunk since this call.
+   * In other words, this is the best way to maintain a frequently updated counter.
+   * Within a transaction, this can't be combined with writes that delete or shrink the same
+   * record, in either order. Such a write or delta fails with kErrorCodeXctDeltaConflict.
+   */
+  template <typename PAYLOAD>
+  ErrorCode   delta_record(
+    thread::Thread* context,
+    const void* key,
+    KeyLength key_length,
+    DeltaOperator op,
+    PAYLOAD operand,
+    PayloadLength payload_offset);
+
+  /**
+   * @brief For primitive key.
+   * @see delta_record()
+   */
+  template <typename PAYLOAD>
+  ErrorCode   delta_record_normalized(
+    thread::Thread* context,
+    KeySlice key,
+    DeltaOperator op,
+    PAYLOAD operand,
+    PayloadLength payload_offset);
+
   // TODO(Hideaki): Extend/shrink/update methods for payload. A bit faster than delete + insert.
 
   ErrorStack  verify_single_thread(thread::Thread* context);
@@ -31,6 +31,7 @@
 #include "foedus/log/fwd.hpp"
 #include "foedus/memory/fwd.hpp"
 #include "foedus/soc/shared_memory_repo.hpp"
+#include "foedus/storage/delta_update.hpp"
 #include "foedus/storage/fwd.hpp"
 #include "foedus/storage/page.hpp"
 #include "foedus/storage/storage.hpp"
@@ -105,6 +106,7 @@ class MasstreeStoragePimpl final : public Attachable<MasstreeStorageControlBlock
 
   ErrorStack  create(const MasstreeMetadata& metadata);
   ErrorStack  load(const StorageControlBlock& snapshot_block);
+  ErrorStack  load_snapshot_view(const StorageControlBlock& snapshot_block);
   ErrorStack  load_empty();
   ErrorStack  drop();
 
@@ -229,6 +231,17 @@ class MasstreeStoragePimpl final : public Attachable<MasstreeStorageControlBlock
     PAYLOAD* value,
     PayloadLength payload_offset);
 
+  /** implementation of delta_record family. use with locate_record()  */
+  template <typename PAYLOAD>
+  ErrorCode delta_general(
+    thread::Thread* context,
+    const RecordLocation& location,
+    const void* be_key,
+    KeyLength key_length,
+    DeltaOperator op,
+    PAYLOAD operand,
+    PayloadLength payload_offset);
+
   /** These are defined in masstree_storage_verify.cpp */
   ErrorStack verify_single_thread(thread::Thread* context);
   ErrorStack verify_single_thread_layer(
@@ -32,6 +32,7 @@
 #include "foedus/snapshot/log_buffer.hpp"
 #include "foedus/snapshot/snapshot_id.hpp"
 #include "foedus/soc/shared_mutex.hpp"
+#include "foedus/storage/fwd.hpp"
 #include "foedus/storage/storage_id.hpp"
 
 namespace foedus {
@@ -53,6 +54,10 @@ namespace storage {
  * This is so far enough and VERY simple/efficient to design partitioning, but later
  * we might want to explore smarter partitioning that utilizes, say, log entries.
  * (but that will be complex/expensive!)
+ * Optionally, worker threads also sample their snapshot-cache misses into
+ * PartitionerAccessStatistics. When a key range was read mostly by one node since the
+ * previous snapshot, the partitioner assigns the range to that node so that the snapshot
+ * pages land in the reader's node. See StorageOptions::partitioner_access_sample_interval_.
  *
  * @par Sorting Algorithm
  * Sorting algorithm \e may use metadata specific to the storage (not just storage type).
@@ -79,6 +84,19 @@ class Partitioner CXX11_FINAL : public Attachable<PartitionerMetadata> {
   */
   Partitioner(Engine* engine, StorageId id);
 
+  /**
+   * @brief Records a sampled snapshot-cache miss on the given page to the access statistics
+   * of the page's storage.
+   * @param[in] engine Engine
+   * @param[in] page a snapshot page just read from a snapshot file
+   * @param[in] node the NUMA node of the thread that read the page
+   * @details
+   * This method only looks at the page, so it's cheap compared to the I/O that preceded it.
+   * Pages that can't be placed in a key range of the storage (eg. pages in the second or
+   * deeper layers of masstree) are ignored.
+   */
+  static void sample_access(Engine* engine, const Page* page, PartitionId node);
+
   /** Returns tiny metadata of the partitioner in shared memory. */
   const PartitionerMetadata& get_metadata() const;
   /** whether this object is ready for partitioning. if only sorting is needed, it doesn't matter */
@@ -191,6 +209,73 @@ class Partitioner CXX11_FINAL : public Attachable<PartitionerMetadata> {
   StorageType       type_;
 };
 
+/**
+ * @brief Sampled snapshot-cache misses of one storage per key range per NUMA node.
+ * @ingroup STORAGE
+ * @details
+ * Each storage has one of this in PartitionerMetadata. Unlike other members of
+ * PartitionerMetadata, this survives across snapshots.
+ * The key ranges (buckets) are defined by the partitioner when it designs partitions,
+ * and each worker thread increments the counter of the bucket and its node when it samples
+ * a snapshot-cache miss. The next design_partition() consumes the counters to assign each
+ * key range to the node that mostly read it, and then resets the buckets for the new design.
+ *
+ * Keys are storage-specific 64bit values: array offsets for array, bins for hash,
+ * and first-layer key slices for masstree.
+ * The counters are updated without synchronization. Lost increments are fine because
+ * these are just samples.
+ */
+struct PartitionerAccessStatistics CXX11_FINAL {
+  enum Constants {
+    /** If there are more partitions than this, adjacent partitions share a bucket. */
+    kMaxBuckets = 64,
+    /** Samples from nodes beyond this are ignored. */
+    kMaxNodes = 16,
+    /** A key range needs at least this number of samples to be re-assigned. */
+    kMinSamples = 8,
+  };
+
+  // This object is placed on shared memory. We only reinterpret them.
+  PartitionerAccessStatistics() CXX11_FUNC_DELETE;
+  ~PartitionerAccessStatistics() CXX11_FUNC_DELETE;
+
+  void clear() {
+    bucket_count_ = 0;
+    total_samples_ = 0;
+  }
+
+  /**
+   * @brief Defines buckets from the partitions just designed and clears the counters.
+   * @param[in] low_keys the smallest key of each partition, in ascending order.
+   * @param[in] count number of partitions
+   */
+  void reset(const uint64_t* low_keys, uint32_t count);
+
+  /** Increments the counter of the bucket containing the key. */
+  void sample(uint64_t key, PartitionId node);
+
+  /**
+   * @brief Returns the node that read the given key range most since the last reset().
+   * @param[in] low_key inclusive beginning of the key range
+   * @param[in] high_key exclusive end of the key range
+   * @param[out] node the node that contributed more than half of the samples in the buckets
+   * overlapping with the key range.
+   * @return whether there is such a node with at least kMinSamples samples.
+   */
+  bool find_dominant_node(uint64_t low_key, uint64_t high_key, PartitionId* node) const;
+
+  /** Number of buckets defined by the last reset(). 0 means no sampling. */
+  uint32_t  bucket_count_;
+  /** Number of samples since the last reset(). Just for statistics. */
+  uint32_t  total_samples_;
+  /** The smallest key of each bucket, in ascending order. */
+  uint64_t  bucket_low_keys_[kMaxBuckets];
+  /** Number of samples in each bucket from each node. */
+  uint32_t  samples_[kMaxBuckets][kMaxNodes];
+
+  friend std::ostream& operator<<(std::ostream& o, const PartitionerAccessStatistics& v);
+};
+
 /**
  * @brief Tiny metadata of partitioner for every storage used while log gleaning.
  * @ingroup STORAGE
@@ -214,6 +299,7 @@ struct PartitionerMetadata CXX11_FINAL {
   void initialize() {
     mutex_.initialize();
     clear_counts();
+    access_statistics_.clear();
   }
   void uninitialize() {
     mutex_.uninitialize();
@@ -244,6 +330,11 @@ struct PartitionerMetadata CXX11_FINAL {
    * The size of the partitioner data.
    */
   uint32_t          data_size_;
+  /**
+   * Sampled accesses to this storage since the previous snapshot.
+   * Not cleared by clear_counts().
+   */
+  PartitionerAccessStatistics access_statistics_;
 
   /**
    * Returns the partitioner data pointed from this metadata.
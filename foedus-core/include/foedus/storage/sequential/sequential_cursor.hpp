@@ -271,6 +271,7 @@ class SequentialCursor {
    */
   const Epoch                   to_epoch_;
 
+  /** The epoch of the snapshot to read. The pinned one in a snapshot-only transaction. */
   const Epoch                   latest_snapshot_epoch_;
 
   /**
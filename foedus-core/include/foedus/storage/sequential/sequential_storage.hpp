@@ -56,6 +56,13 @@ class SequentialStorage CXX11_FINAL : public Storage<SequentialStorageControlBlo
   const SequentialMetadata*  get_sequential_metadata()  const;
   ErrorStack          create(const Metadata &metadata);
   ErrorStack          load(const StorageControlBlock& snapshot_block);
+  /**
+   * Sets up this control block as a read-only view of the storage as of a snapshot,
+   * copying the metadata from the snapshot's control block. Unlike load(), this creates no
+   * volatile page, so only snapshot-only transactions can read it.
+   * @see snapshot::SnapshotView
+   */
+  ErrorStack          load_snapshot_view(const StorageControlBlock& snapshot_block);
   ErrorStack          drop();
 
   // this storage type doesn't use moved bit
@@ -156,6 +156,7 @@ class SequentialStoragePimpl final : public Attachable<SequentialStorageControlB
   const StorageName& get_name() const { return control_block_->meta_.name_; }
   ErrorStack  create(const SequentialMetadata& metadata);
   ErrorStack  load(const StorageControlBlock& snapshot_block);
+  ErrorStack  load_snapshot_view(const StorageControlBlock& snapshot_block);
   ErrorStack  initialize_head_tail_pages();
   ErrorStack  drop();
   ErrorStack  truncate(Epoch new_truncate_epoch, Epoch* commit_epoch);
@@ -194,6 +195,9 @@ class SequentialStoragePimpl final : public Attachable<SequentialStorageControlB
    */
   template <typename HANDLER>
   ErrorCode for_every_page(HANDLER handler) const {
+    if (control_block_->head_pointer_pages_[0].is_null()) {
+      return kErrorCodeOk;  // no volatile pages at all, eg a view of a snapshot
+    }
     uint16_t nodes = engine_->get_options().thread_.group_count_;
     uint16_t threads_per_node = engine_->get_options().thread_.thread_count_per_group_;
     for (uint16_t node = 0; node < nodes; ++node) {
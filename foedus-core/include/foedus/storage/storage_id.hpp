@@ -75,6 +75,11 @@ typedef thread::ThreadGroupId PartitionId;
  * We have one snapshot file per NUMA node, so it won't be more than 2^8.
  * The last 40 bits indicate page offset in the file. So, one file in one snapshot must be within
  * 4kb * 2^40 = 4PB, which is surely the case.
+ * When a NUMA node composes its pages with more than one composer thread, each thread writes
+ * to its own file, which we call a \e shard of the node's snapshot file.
+ * The high 4 bits of the 40 bits then indicate the shard, and the remaining 36 bits are the page
+ * offset in the shard (4kb * 2^36 = 256TB). They are zero in the first shard, so a node
+ * composed by one thread has exactly one file as described above.
  */
 typedef uint64_t SnapshotPagePointer;
 
@@ -103,6 +108,24 @@ inline void assert_valid_snapshot_local_page_id(SnapshotLocalPageId page_id) {
   ASSERT_ND(page_id < (1ULL << 40));
 }
 
+/** Bit position of the shard in SnapshotLocalPageId. @see SnapshotPagePointer */
+const uint8_t kSnapshotShardShift = 36;
+/** Maximum number of shards (files) in one NUMA node in one snapshot. */
+const uint16_t kMaxSnapshotShards = 16;
+
+inline uint8_t extract_shard_from_local_page_id(SnapshotLocalPageId page_id) {
+  return static_cast<uint8_t>(page_id >> kSnapshotShardShift);
+}
+/** Returns the page offset in the shard file, which is also the offset for the first shard. */
+inline uint64_t extract_shard_offset_from_local_page_id(SnapshotLocalPageId page_id) {
+  return page_id & ((1ULL << kSnapshotShardShift) - 1ULL);
+}
+inline SnapshotLocalPageId to_local_page_id(uint8_t shard, uint64_t shard_offset) {
+  ASSERT_ND(shard < kMaxSnapshotShards);
+  ASSERT_ND(shard_offset < (1ULL << kSnapshotShardShift));
+  return static_cast<uint64_t>(shard) << kSnapshotShardShift | shard_offset;
+}
+
 inline SnapshotPagePointer to_snapshot_page_pointer(
   uint16_t snapshot_id,
   uint8_t node,
@@ -248,6 +248,24 @@ class StorageManager CXX11_FINAL : public virtual Initializable {
     xct::RwLockableXctId* old_address,
     xct::WriteXctAccess* write_set);
 
+  /**
+   * @brief Migrates a volatile page to the NUMA node of the given thread.
+   * @param[in] context the thread that has frequently accessed the page
+   * @param[in] storage_id the storage the page belongs to
+   * @param[in] page_key storage-specific key to find the page, eg the first array offset
+   * @param[out] migrated whether the page has been migrated. false if the page is already
+   * in the node, no longer exists, or this storage type doesn't support migration.
+   * @details
+   * The old page is retired with the moved-bit protocol. Records in it are then tracked by
+   * track_moved_record().
+   * @see thread::Thread::migrate_sampled_volatile_pages()
+   */
+  ErrorCode   migrate_volatile_page(
+    thread::Thread* context,
+    StorageId storage_id,
+    uint64_t page_key,
+    bool* migrated);
+
   /** Returns pimpl object. Use this only if you know what you are doing. */
   StorageManagerPimpl* get_pimpl() { return pimpl_; }
 
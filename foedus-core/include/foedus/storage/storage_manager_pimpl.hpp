@@ -111,6 +111,11 @@ class StorageManagerPimpl final : public DefaultInitializable {
     StorageId storage_id,
     xct::RwLockableXctId* old_address,
     xct::WriteXctAccess *write);
+  ErrorCode   migrate_volatile_page(
+    thread::Thread* context,
+    StorageId storage_id,
+    uint64_t page_key,
+    bool* migrated);
   ErrorStack  clone_all_storage_metadata(snapshot::SnapshotMetadata *metadata);
 
   uint32_t    get_max_storages() const;
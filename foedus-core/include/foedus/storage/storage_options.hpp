@@ -31,6 +31,7 @@ struct StorageOptions CXX11_FINAL : public virtual externalize::Externalizable {
     kDefaultMaxStorages = 1 << 9,
     kDefaultPartitionerDataMemoryMb = 1,
     kDefaultHotThreshold = 256,  // OCC by default (for test cases and benchamrks that don't set it)
+    kDefaultVolatilePageMigrationMinSamples = 4,
   };
   /**
    * Constructs option values with default values.
@@ -50,6 +51,36 @@ struct StorageOptions CXX11_FINAL : public virtual externalize::Externalizable {
    */
   uint32_t                partitioner_data_memory_mb_;
 
+  /**
+   * @brief Every this number of snapshot-cache misses, a worker thread records the key range
+   * of the page it read and its NUMA node to the storage's PartitionerAccessStatistics.
+   * @details
+   * Partitioners then assign key ranges mostly read by one node to the node in the next
+   * snapshot, so that the snapshot pages are read from the node-local snapshot file.
+   * 0 disables sampling, in which case partitioners use only the status-quo of the storage
+   * as they do in the first snapshot. Default is 0.
+   */
+  uint32_t                partitioner_access_sample_interval_;
+
+  /**
+   * @brief Every this number of accesses to volatile pages in a remote NUMA node, a worker
+   * thread records the page as a candidate to migrate to its own node.
+   * @details
+   * Volatile pages stay in the node of the thread that created them. After a load phase or
+   * re-routing of clients, many hot pages are remote to the threads that access them.
+   * When a worker thread begins a new transaction, it copies the candidate pages sampled
+   * at least volatile_page_migration_min_samples_ times to its own node and retires the old
+   * pages with the moved-bit protocol. So far only leaf pages of array storages are migrated.
+   * 0 disables migration. Default is 0.
+   */
+  uint32_t                volatile_page_migration_sample_interval_;
+
+  /**
+   * A candidate page is migrated when it is sampled this number of times.
+   * @see volatile_page_migration_sample_interval_
+   */
+  uint32_t                volatile_page_migration_min_samples_;
+
   /**
    * Page hotness >= this value will be considered hot (hybrid CC only).
    */
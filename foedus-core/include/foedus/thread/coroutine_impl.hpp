@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#ifndef FOEDUS_THREAD_COROUTINE_IMPL_HPP_
+#define FOEDUS_THREAD_COROUTINE_IMPL_HPP_
+#include <stdint.h>
+#include <ucontext.h>
+
+#include <vector>
+
+#include "foedus/epoch.hpp"
+#include "foedus/error_code.hpp"
+#include "foedus/error_stack.hpp"
+#include "foedus/fwd.hpp"
+#include "foedus/initializable.hpp"
+#include "foedus/memory/aligned_memory.hpp"
+#include "foedus/proc/proc_id.hpp"
+#include "foedus/storage/fwd.hpp"
+#include "foedus/storage/storage_id.hpp"
+#include "foedus/thread/fwd.hpp"
+#include "foedus/thread/thread_id.hpp"
+#include "foedus/xct/xct.hpp"
+
+namespace foedus {
+namespace thread {
+
+/**
+ * @brief One transaction coroutine multiplexed on a worker thread.
+ * @ingroup THREAD
+ * @details
+ * A stackful coroutine that has its own stack and its own xct::Xct object, both backed by
+ * one NUMA-local memory block. The coroutine runs a procedure and finishes when it returns.
+ */
+struct Coroutine final {
+  Coroutine(Engine* engine, Thread* holder, ThreadId id, uint16_t ordinal)
+    : ordinal_(ordinal), finished_(true), xct_(engine, holder, id), proc_(nullptr),
+      output_used_(0) {}
+
+  Coroutine() = delete;
+  Coroutine(const Coroutine& other) = delete;
+  Coroutine& operator=(const Coroutine& other) = delete;
+
+  /** 0-based index of this coroutine in the thread. */
+  const uint16_t        ordinal_;
+  /** Whether the procedure has returned. */
+  bool                  finished_;
+  /** Saved registers/stack pointer while this coroutine is suspended. */
+  ucontext_t            context_;
+  /** Stack, local work memory, and the small pieces of xct_, in this order. */
+  memory::AlignedMemory memory_;
+  /** The transaction object get_current_xct() returns while this coroutine is running. */
+  xct::Xct              xct_;
+  proc::Proc            proc_;
+  proc::ProcArguments   args_;
+  uint32_t              output_used_;
+  /** Return value of proc_ */
+  ErrorStack            result_;
+};
+
+/**
+ * @brief Multiplexes transaction coroutines on one worker thread.
+ * @ingroup THREAD
+ * @details
+ * Owned by ThreadPimpl when ThreadOptions::coroutines_per_thread_ is positive.
+ * The scheduler switches coroutines with ucontext in a simple round-robin fashion.
+ * A coroutine suspends only at explicit yield points:
+ *  \li Thread::yield_coroutine() called by the procedure itself.
+ *  \li Snapshot cache misses, which are served by asynchronous I/O while the coroutine
+ * is suspended.
+ *  \li Waiting for a contended record lock in the read phase (RLL or hot records).
+ *  \li XctManager::wait_for_commit() with the thread context, which waits for the
+ * durable epoch while the other coroutines run.
+ *
+ * @par Which state is shared
+ * The log buffer, the MCS lock blocks, the snapshot file descriptors, and the free page
+ * chunks are shared by all coroutines of the thread. Hence, a coroutine can be suspended
+ * only when it has no uncommitted logs, holds no locks, and runs no system transaction.
+ * See is_yieldable(). In other words, precommit never suspends; each transaction suspends
+ * only in its read phase or after precommit.
+ *
+ * As this class uses C++11 and ucontext, the name of this file ends with impl.
+ */
+class CoroutineScheduler final : public DefaultInitializable {
+ public:
+  explicit CoroutineScheduler(ThreadPimpl* pimpl);
+  ~CoroutineScheduler() {}
+
+  CoroutineScheduler() = delete;
+  CoroutineScheduler(const CoroutineScheduler& other) = delete;
+  CoroutineScheduler& operator=(const CoroutineScheduler& other) = delete;
+
+  ErrorStack  initialize_once() override;
+  ErrorStack  uninitialize_once() override;
+
+  /** Byte size of the memory block each coroutine allocates. */
+  static uint64_t calculate_memory_size_per_coroutine(const EngineOptions& options);
+
+  /** @copydoc Thread::run_coroutines() */
+  ErrorStack  run(proc::Proc proc, uint16_t count, const void* input, uint32_t input_len);
+
+  bool        is_in_coroutine() const { return current_ != nullptr; }
+  uint16_t    get_current_ordinal() const;
+  /** @copydoc Thread::is_coroutine_yieldable() */
+  bool        is_yieldable() const;
+  /** @copydoc Thread::yield_coroutine() */
+  bool        yield();
+
+  /**
+   * Reads a snapshot page with POSIX asynchronous I/O, suspending the current coroutine
+   * until the I/O completes.
+   * @pre is_yieldable()
+   */
+  ErrorCode   read_a_snapshot_page(storage::SnapshotPagePointer page_id, storage::Page* buffer);
+
+  /**
+   * Suspends the current coroutine until the durable global epoch reaches commit_epoch.
+   * Falls back to the blocking wait if no other coroutine can run.
+   * @pre is_yieldable()
+   */
+  ErrorCode   wait_for_commit(Epoch commit_epoch, int64_t wait_microseconds);
+
+  /** [statistics] number of times coroutines of this thread were suspended */
+  uint64_t    get_yield_count() const { return yield_count_; }
+
+ private:
+  /** Function given to makecontext(). The scheduler's address is split into two ints. */
+  static void entry_point(uint32_t address_high, uint32_t address_low);
+  /** Body of each coroutine. */
+  void        run_current();
+  /** Runs the given coroutine until it yields or finishes. */
+  void        switch_to(Coroutine* coroutine);
+
+  ThreadPimpl* const        pimpl_;
+  Engine* const             engine_;
+  std::vector<Coroutine*>   coroutines_;
+  /** Currently running coroutine. null if the thread is running the scheduler itself. */
+  Coroutine*                current_;
+  /** Number of coroutines that are not finished in the current run(). */
+  uint16_t                  active_count_;
+  uint64_t                  stack_size_;
+  uint64_t                  yield_count_;
+  /** Registers of the scheduler loop in run() while a coroutine runs. */
+  ucontext_t                scheduler_context_;
+};
+
+}  // namespace thread
+}  // namespace foedus
+#endif  // FOEDUS_THREAD_COROUTINE_IMPL_HPP_
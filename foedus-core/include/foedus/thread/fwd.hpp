@@ -25,6 +25,8 @@
  */
 namespace foedus {
 namespace thread {
+struct  Coroutine;
+class   CoroutineScheduler;
 class   GrabFreeVolatilePagesScope;
 struct  ImpersonateSession;
 class   Rendezvous;
@@ -25,6 +25,7 @@
 #include "foedus/log/fwd.hpp"
 #include "foedus/memory/fwd.hpp"
 #include "foedus/memory/page_resolver.hpp"
+#include "foedus/proc/proc_id.hpp"
 #include "foedus/storage/fwd.hpp"
 #include "foedus/storage/storage_id.hpp"
 #include "foedus/thread/fwd.hpp"
@@ -97,6 +98,8 @@ class Thread CXX11_FINAL : public virtual Initializable {
   uint64_t      get_snapshot_cache_misses() const;
   /** [statistics] resets the above two */
   void          reset_snapshot_cache_counts() const;
+  /** [statistics] count of volatile pages this thread has migrated to its node */
+  uint64_t      get_migrated_volatile_pages() const;
 
   /** Shorthand for get_global_volatile_page_resolver.resolve_offset() */
   storage::Page* resolve(storage::VolatilePagePointer ptr) const;
@@ -272,6 +275,29 @@ class Thread CXX11_FINAL : public virtual Initializable {
    */
   void          collect_retired_volatile_page(storage::VolatilePagePointer ptr);
 
+  /**
+   * @brief Called when this thread accessed a volatile page placed in another NUMA node.
+   * @param[in] storage_id the storage the page belongs to
+   * @param[in] page_key storage-specific key to find the page again, eg the first array offset
+   * @details
+   * Every StorageOptions::volatile_page_migration_sample_interval_ calls, this method records
+   * the page as a candidate to migrate to this thread's node.
+   */
+  void          sample_remote_volatile_page(storage::StorageId storage_id, uint64_t page_key);
+
+  /**
+   * @brief Migrates the sampled volatile pages that are hot enough to this thread's node.
+   * @pre This thread is not running a transaction.
+   * @details
+   * Each page is copied into a page grabbed from this thread's node, the pointer to it is
+   * swung to the copy, and the old page is retired with moved bits set, which is the same
+   * protocol as page splits. Concurrent transactions that have the old records in their
+   * read/write sets track the moved records during precommit.
+   * The transaction manager calls this when this thread begins a new transaction.
+   * @see StorageOptions::volatile_page_migration_sample_interval_
+   */
+  ErrorCode     migrate_sampled_volatile_pages();
+
   /** Unconditionally takes MCS lock on the given mcs_lock. */
   xct::McsRwSimpleBlock* get_mcs_rw_simple_blocks();
   xct::McsRwExtendedBlock* get_mcs_rw_extended_blocks();
@@ -359,6 +385,49 @@ class Thread CXX11_FINAL : public virtual Initializable {
   /// Currently we don't have sysxct_release_locks() etc. All locks will be automatically
   /// released when the sysxct ends. Probably this is enough as sysxct should be short-living.
 
+  ///////////////////////////////////////////////////////////////////////////////
+  ///
+  ///  Methods related to transaction coroutines multiplexed on this thread.
+  ///  Available only when ThreadOptions::coroutines_per_thread_ > 0.
+  ///
+  /**
+   * @brief Runs the given procedure as \e count coroutines interleaved on this thread.
+   * @param[in] proc the procedure each coroutine runs. It receives this thread as context_.
+   * get_current_xct() returns the coroutine's own transaction object while it runs.
+   * @param[in] count number of coroutines. Must be 1 to ThreadOptions::coroutines_per_thread_.
+   * @param[in] input input given to all coroutines as input_buffer_.
+   * @param[in] input_len byte size of input.
+   * @pre !is_in_coroutine() and !is_running_xct() (must be called from a normal procedure)
+   * @return summarized error of all coroutines, kRetOk if all of them succeeded.
+   * @details
+   * Each coroutine has its own stack and its own xct::Xct, so that one transaction can be
+   * suspended while it waits for snapshot-page I/O, a contended lock, or the durability of
+   * its commit, letting the other coroutines on this thread make progress meanwhile.
+   * Coroutines only suspend at yield_coroutine() and at the built-in yield points,
+   * and only when is_coroutine_yieldable(). This method returns when all of them finish.
+   * Procedures do not receive an output buffer (output_buffer_size_ is 0).
+   */
+  ErrorStack    run_coroutines(
+    proc::Proc proc,
+    uint16_t count,
+    const void* input,
+    uint32_t input_len);
+  /** Returns if this thread is now running a coroutine in run_coroutines(). */
+  bool          is_in_coroutine() const;
+  /** Returns the 0-based ordinal of the currently running coroutine. @pre is_in_coroutine() */
+  uint16_t      get_coroutine_ordinal() const;
+  /**
+   * Returns if the current coroutine can be suspended now. It can be suspended only when
+   * it holds no lock, runs no system transaction, and has no uncommitted logs, because the
+   * MCS blocks and the log buffer are shared by all coroutines of this thread.
+   */
+  bool          is_coroutine_yieldable() const;
+  /**
+   * Suspends the current coroutine and lets the next runnable coroutine run.
+   * @return whether it actually yielded. False if !is_coroutine_yieldable().
+   */
+  bool          yield_coroutine();
+
   /** @see foedus::xct::InCommitEpochGuard  */
   Epoch*        get_in_commit_epoch_address();
 
@@ -25,6 +25,8 @@
 #include "foedus/fwd.hpp"
 #include "foedus/initializable.hpp"
 #include "foedus/memory/fwd.hpp"
+#include "foedus/memory/shared_memory.hpp"
+#include "foedus/soc/client_ring.hpp"
 #include "foedus/thread/fwd.hpp"
 
 namespace foedus {
@@ -45,6 +47,8 @@ class ThreadGroup CXX11_FINAL : public DefaultInitializable {
 
   ThreadGroupId           get_group_id() const { return group_id_; }
   memory::NumaNodeMemory* get_node_memory() const { return node_memory_; }
+  /** The client request ring of this node. Not enabled unless SocOptions enables it. */
+  soc::ClientRing*        get_client_ring() { return &client_ring_; }
 
   /** Returns Thread object for the given ordinal in this group. */
   Thread*                 get_thread(ThreadLocalOrdinal ordinal) const { return threads_[ordinal]; }
@@ -64,6 +68,14 @@ class ThreadGroup CXX11_FINAL : public DefaultInitializable {
    */
   memory::NumaNodeMemory* node_memory_;
 
+  /**
+   * Shared memory of the client request ring, which this group owns unlike node_memory_.
+   * Allocated separately from SharedMemoryRepo so that external processes can attach it
+   * while the engine is running.
+   */
+  memory::SharedMemory    client_ring_memory_;
+  soc::ClientRing         client_ring_;
+
   /**
    * List of Thread in this group. Index is ThreadLocalOrdinal.
    */
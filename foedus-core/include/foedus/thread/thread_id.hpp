@@ -199,6 +199,8 @@ enum ThreadPriority {
  *  \li Every state might jump to kTerminated for whatever reason.
  *  \li kWaitingForClientRelease goes back to kWaitingForTask when the client picks the result up
  * and closes the session.
+ *  \li kWaitingForTask goes to kRunningTask and back while the thread serves requests in
+ * soc::ClientRing, during which impersonation fails as usual.
  */
 enum ThreadStatus {
   /** Initial state. The thread does nothing in this state */
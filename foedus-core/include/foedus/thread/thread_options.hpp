@@ -57,6 +57,21 @@ struct ThreadOptions CXX11_FINAL : public virtual externalize::Externalizable {
   /** Thread priority for worker threads. ignored if overwrite_thread_schedule_==false */
   ThreadPriority          thread_priority_;
 
+  /**
+   * @brief Max number of transaction coroutines each worker thread can multiplex.
+   * @details
+   * 0 (default) disables the coroutine execution mode, which is the traditional
+   * one-procedure-at-a-time behavior. When this is positive, each worker thread pre-allocates
+   * this number of coroutine contexts, each of which has its own stack and its own read/write
+   * sets, lock lists, and local work memory. Hence, it consumes roughly
+   * (coroutine_stack_kb_ + memory for XctOptions) times this number per thread.
+   * @see foedus::thread::Thread::run_coroutines()
+   */
+  uint16_t                coroutines_per_thread_;
+
+  /** Byte size (in KB) of the stack of each coroutine. ignored if coroutines_per_thread_==0. */
+  uint32_t                coroutine_stack_kb_;
+
   EXTERNALIZABLE(ThreadOptions);
 
   ThreadId                get_total_thread_count() const {
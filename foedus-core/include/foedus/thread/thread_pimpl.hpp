@@ -29,6 +29,7 @@
 #include "foedus/memory/fwd.hpp"
 #include "foedus/memory/page_resolver.hpp"
 #include "foedus/proc/proc_id.hpp"
+#include "foedus/soc/fwd.hpp"
 #include "foedus/soc/shared_mutex.hpp"
 #include "foedus/soc/shared_polling.hpp"
 #include "foedus/storage/fwd.hpp"
@@ -67,6 +68,8 @@ struct ThreadControlBlock {
     my_thread_id_ = my_thread_id;
     stat_snapshot_cache_hits_ = 0;
     stat_snapshot_cache_misses_ = 0;
+    stat_remote_volatile_page_accesses_ = 0;
+    stat_migrated_volatile_pages_ = 0;
   }
   void uninitialize() {
     task_mutex_.uninitialize();
@@ -144,6 +147,24 @@ struct ThreadControlBlock {
 
   uint64_t            stat_snapshot_cache_hits_;
   uint64_t            stat_snapshot_cache_misses_;
+  /** @see foedus::storage::StorageOptions::volatile_page_migration_sample_interval_ */
+  uint64_t            stat_remote_volatile_page_accesses_;
+  uint64_t            stat_migrated_volatile_pages_;
+};
+
+/**
+ * @brief A volatile page in a remote NUMA node that a thread has frequently accessed.
+ * @ingroup THREAD
+ * @details
+ * The page is identified by a storage-specific key (eg the first offset of an array leaf)
+ * rather than its address because the page might be moved or dropped before the thread
+ * migrates it. @see ThreadPimpl::sample_remote_volatile_page()
+ */
+struct VolatilePageMigrationCandidate {
+  storage::StorageId  storage_id_;
+  /** How many times the page has been sampled. 0 means this entry is unused. */
+  uint32_t            samples_;
+  uint64_t            page_key_;
 };
 
 /**
@@ -158,6 +179,10 @@ struct ThreadControlBlock {
  */
 class ThreadPimpl final : public DefaultInitializable {
  public:
+  enum Constants {
+    /** Size of migration_candidates_. */
+    kMaxMigrationCandidates = 16,
+  };
   template<typename RW_BLOCK> friend class ThreadPimplMcsAdaptor;
 
   ThreadPimpl() = delete;
@@ -176,6 +201,27 @@ class ThreadPimpl final : public DefaultInitializable {
    * it and re-sets current_task_ when it's done. It exists when exit_requested_ is set.
    */
   void        handle_tasks();
+  /**
+   * Runs a procedure of the given name. Shared by impersonation and the client request ring.
+   * @return kErrorCodeProcNotFound if there is no such procedure, otherwise what it returned
+   */
+  ErrorStack  run_proc(
+    const proc::ProcName& proc_name,
+    const void* input,
+    uint32_t input_len,
+    void* output,
+    uint32_t output_size,
+    uint32_t* output_used);
+  /**
+   * @brief Takes requests from the client request ring of this node and runs them.
+   * @return the number of requests this thread served
+   * @details
+   * This is called only when the thread is waiting for a task. The thread is marked as
+   * running a task while it serves requests so that nobody impersonates it in the meantime.
+   * It takes at most SocOptions::client_ring_batch_size_ requests, then returns so that
+   * it can check termination and impersonation requests.
+   */
+  uint32_t    serve_client_requests();
   /** initializes the thread's policy/priority */
   void        set_thread_schedule();
   bool        is_stop_requested() const;
@@ -237,6 +283,49 @@ class ThreadPimpl final : public DefaultInitializable {
   ErrorCode on_snapshot_cache_miss(
     storage::SnapshotPagePointer page_id,
     memory::PagePoolOffset* pool_offset);
+  /**
+   * Same as on_snapshot_cache_miss(), but for consecutive pages in a snapshot file.
+   * It reads them in one sequential I/O into the snapshot pool pages it grabs.
+   */
+  ErrorCode on_snapshot_cache_miss_contiguous(
+    storage::SnapshotPagePointer page_id_begin,
+    uint16_t page_count,
+    memory::PagePoolOffset* pool_offsets);
+  /**
+   * Called after each snapshot-cache miss to occasionally record the page to the access
+   * statistics for partitioners. @see storage::StorageOptions::partitioner_access_sample_interval_
+   */
+  void      sample_snapshot_cache_miss(const storage::Page* page);
+
+  /** @copydoc foedus::thread::Thread::sample_remote_volatile_page() */
+  void      sample_remote_volatile_page(storage::StorageId storage_id, uint64_t page_key);
+  /** @copydoc foedus::thread::Thread::migrate_sampled_volatile_pages() */
+  ErrorCode migrate_sampled_volatile_pages();
+
+  /**
+   * @brief follow_page_pointer() for snapshot-only transactions.
+   * @details
+   * It always follows the snapshot pointer, ignoring the volatile pointer.
+   * No pointer set is needed because snapshot pages are immutable.
+   * @see xct::XctManager::begin_snapshot_only_xct()
+   */
+  ErrorCode follow_page_pointer_snapshot_only(
+    bool tolerate_null_pointer,
+    bool will_modify,
+    const storage::DualPagePointer* pointer,
+    storage::Page** page);
+  /** Batched version of follow_page_pointer_snapshot_only() for reads. */
+  ErrorCode follow_page_pointers_for_read_batch_snapshot_only(
+    uint16_t batch_size,
+    bool tolerate_null_pointer,
+    storage::DualPagePointer** pointers,
+    bool* followed_snapshots,
+    storage::Page** out);
+  /**
+   * Returns an error if the snapshot pointer, which a snapshot-only transaction is about to
+   * follow, belongs to a snapshot newer than the one the transaction pinned.
+   */
+  ErrorCode check_snapshot_only_pointer(storage::SnapshotPagePointer snapshot_pointer) const;
 
   /**
    * @brief Subroutine of install_a_volatile_page() and follow_page_pointer() to atomically place
@@ -367,12 +456,27 @@ class ThreadPimpl final : public DefaultInitializable {
   /** Just to make sure raw_thread_ is set. Otherwise pthread_getschedparam will complain. */
   std::atomic<bool>       raw_thread_set_;
 
+  /**
+   * The transaction object of this thread itself, backed by core_memory_.
+   * This is what current_xct_ points to unless the thread is running coroutines.
+   */
+  xct::Xct                default_xct_;
+
   /**
    * Current transaction this thread is conveying.
-   * Each thread can run at most one transaction at once.
-   * If this thread is not conveying any transaction, current_xct_.is_active() == false.
+   * Each thread (or each coroutine of the thread) can run at most one transaction at once.
+   * If this thread is not conveying any transaction, current_xct_->is_active() == false.
+   * This usually points to default_xct_. While a coroutine is running, it points to the
+   * Xct object of the coroutine.
+   * @see CoroutineScheduler
    */
-  xct::Xct                current_xct_;
+  xct::Xct*               current_xct_;
+
+  /**
+   * Multiplexes transaction coroutines on this thread. Null if
+   * ThreadOptions::coroutines_per_thread_ is zero.
+   */
+  CoroutineScheduler*     coroutine_scheduler_;
 
   /**
    * Each threads maintains a private set of snapshot file descriptors.
@@ -380,6 +484,8 @@ class ThreadPimpl final : public DefaultInitializable {
   cache::SnapshotFileSet  snapshot_file_set_;
 
   ThreadControlBlock*     control_block_;
+  /** Client request ring of this node. Null if SocOptions::client_ring_slots_ is zero. */
+  soc::ClientRing*        client_ring_;
   void*                   task_input_memory_;
   void*                   task_output_memory_;
 
@@ -390,6 +496,12 @@ class ThreadPimpl final : public DefaultInitializable {
   xct::McsRwAsyncMapping*   mcs_rw_async_mappings_;
 
   xct::RwLockableXctId*   canonical_address_;
+
+  /**
+   * Remote volatile pages this thread has frequently accessed, migrated to this node
+   * when the thread begins a new transaction. Thread-private, so no synchronization.
+   */
+  VolatilePageMigrationCandidate migration_candidates_[kMaxMigrationCandidates];
 };
 
 /**
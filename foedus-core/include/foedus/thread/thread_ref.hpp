@@ -76,6 +76,7 @@ class ThreadRef CXX11_FINAL {
   uint64_t      get_snapshot_cache_hits() const;
   uint64_t      get_snapshot_cache_misses() const;
   void          reset_snapshot_cache_counts() const;
+  uint64_t      get_migrated_volatile_pages() const;
 
   friend std::ostream& operator<<(std::ostream& o, const ThreadRef& v);
 
@@ -39,13 +39,17 @@ struct  McsWwLock;
 struct  McsWwBlock;
 struct  PointerAccess;
 struct  ReadXctAccess;
+struct  RecordVersion;
 class   RetrospectiveLockList;
 struct  RwLockableXctId;
 struct  SysxctFunctor;
 struct  SysxctWorkspace;
+class   VersionStore;
+struct  VersionStoreStat;
 struct  WriteXctAccess;
 class   Xct;
 struct  XctId;
+struct  XctRepairFunctor;
 class   XctManager;
 struct  XctManagerControlBlock;
 class   XctManagerPimpl;
@@ -232,6 +232,7 @@ class RetrospectiveLockList {
   void construct(thread::Thread* context, uint32_t read_lock_threshold);
 
   const LockEntry* get_array() const { return array_; }
+  LockEntry* get_array() { return array_; }
   LockEntry* get_entry(LockListPosition pos) {
     ASSERT_ND(is_valid_entry(pos));
     return array_ + pos;
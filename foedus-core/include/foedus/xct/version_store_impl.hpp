@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#ifndef FOEDUS_XCT_VERSION_STORE_IMPL_HPP_
+#define FOEDUS_XCT_VERSION_STORE_IMPL_HPP_
+
+#include <stdint.h>
+
+#include <atomic>
+
+#include "foedus/cxx11.hpp"
+#include "foedus/epoch.hpp"
+#include "foedus/error_code.hpp"
+#include "foedus/fwd.hpp"
+#include "foedus/storage/storage_id.hpp"
+#include "foedus/thread/thread_id.hpp"
+#include "foedus/xct/xct_id.hpp"
+#include "foedus/xct/xct_manager.hpp"
+
+namespace foedus {
+namespace xct {
+
+/**
+ * @brief An old image of a record retained in VersionStore.
+ * @ingroup XCT
+ * @details
+ * Each slot is owned by one worker thread, which overwrites the slot in a ring order.
+ * generation_ works as a seqlock. It is odd while the owner is overwriting the slot, and
+ * it becomes a new even value when the slot holds a new version. Readers remember the
+ * generation in the pointer they followed and discard what they copied if it has changed.
+ *
+ * This is backed by shared memory. Not instantiated, just reinterpret_cast.
+ */
+struct RecordVersion {
+  enum Constants {
+    /** Byte size of one slot. */
+    kSlotSize = 256,
+    /** Byte size of the fields before payload_. */
+    kHeaderSize = 40,
+    /** Records whose payload is longer than this are not retained. */
+    kPayloadCapacity = kSlotSize - kHeaderSize,
+  };
+
+  RecordVersion() CXX11_FUNC_DELETE;
+  ~RecordVersion() CXX11_FUNC_DELETE;
+
+  /** Even: holds a version (or never used if 0). Odd: being overwritten by the owner. */
+  std::atomic<uint32_t>   generation_;
+  storage::StorageId      storage_id_;
+  /** Storage-specific key of the record, eg ArrayOffset. */
+  uint64_t                key_;
+  /** The ID of the transaction that wrote this version. */
+  XctId                   xct_id_;
+  /** The epoch of the transaction that overwrote this version. */
+  Epoch::EpochInteger     superseded_epoch_;
+  uint16_t                payload_count_;
+  uint16_t                filler_;
+  /** VersionStore::Pointer to the previously pushed version in the same bucket. */
+  uint64_t                older_;
+  char                    payload_[kPayloadCapacity];
+};
+
+/**
+ * @brief Per-thread state of the arena in VersionStore.
+ * @ingroup XCT
+ * @details
+ * Only the owner thread writes to it. The counters are read by others without synchronization.
+ * This is backed by shared memory. Not instantiated, just reinterpret_cast.
+ */
+struct VersionArena {
+  VersionArena() CXX11_FUNC_DELETE;
+  ~VersionArena() CXX11_FUNC_DELETE;
+
+  /** The slot in the arena to be overwritten next. */
+  uint64_t  cursor_;
+  /** @see VersionStoreStat::retained_count_ */
+  uint64_t  retained_count_;
+  /** @see VersionStoreStat::dropped_large_count_ */
+  uint64_t  dropped_large_count_;
+  /** @see VersionStoreStat::dropped_in_use_count_ */
+  uint64_t  dropped_in_use_count_;
+};
+
+/**
+ * @brief A bounded store of old record versions for multi-version read-only transactions.
+ * @ingroup XCT
+ * @details
+ * When XctOptions::version_arena_size_kb_ is non-zero, a worker thread that overwrites a
+ * record in a new epoch first copies the current image of the record into a slot of its
+ * own arena and pushes the slot to a hash bucket determined by the record.
+ * The pushed slots in a bucket form a chain from newer to older.
+ * A read-only transaction reading as of epoch R then reads the current image if its
+ * epoch is R or older, and otherwise looks for a version such that
+ * xct_id_.get_epoch() <= R < superseded_epoch_.
+ *
+ * Reclamation is epoch-based. A slot is recycled only when the epoch of its successor,
+ * superseded_epoch_, is already durable. Multi-version transactions read as of the durable
+ * epoch when they begin, so a newly-started reader never needs a recycled version.
+ * If the next slot of the arena is still needed, the writer does not retain the new version.
+ * Readers that started long ago or that need a dropped version
+ * get kErrorCodeXctVersionUnavailable and can retry with a new durable epoch.
+ * Each arena counts the versions it dropped, which XctManager::get_version_store_stat() sums up.
+ *
+ * The whole store is placed in the global shared memory so that threads in all SOCs
+ * see the same chains. Records are identified by (storage_id, key), not by addresses.
+ *
+ * Memory layout: an array of VersionArena, an array of buckets,
+ * then the slots of all threads.
+ * This object itself is just a set of pointers into the memory, instantiated in each engine.
+ */
+class VersionStore CXX11_FINAL {
+ public:
+  /** A slot index in the lower 32 bits and the generation of the slot in higher bits. */
+  typedef uint64_t Pointer;
+  enum Constants {
+    kNullPointer = 0,
+  };
+
+  VersionStore();
+
+  /** Byte size of the shared memory needed for the given options. 0 if disabled. */
+  static uint64_t calculate_memory_size(const EngineOptions& options);
+
+  /**
+   * Points to the memory placed in the global shared memory.
+   * @param[in] memory the memory of calculate_memory_size() bytes
+   * @param[in] options engine options
+   * @param[in] initialize whether to initialize the memory. Only master engine does it.
+   */
+  void        attach(void* memory, const EngineOptions& options, bool initialize);
+  bool        is_enabled() const { return slots_ != nullptr; }
+
+  /**
+   * @brief Retains the current image of a record that is about to be overwritten.
+   * @param[in] thread_ordinal global ordinal of the calling thread, which owns the arena
+   * @param[in] storage_id storage of the record
+   * @param[in] key storage-specific key of the record
+   * @param[in] xct_id the current XctId of the record
+   * @param[in] superseded_epoch epoch of the transaction that is overwriting the record
+   * @param[in] payload the current payload of the record
+   * @param[in] payload_count byte size of payload
+   * @param[in] durable_epoch current durable epoch, used to tell if a slot can be recycled
+   * @pre The caller has locked the record and has not modified the record yet.
+   * @return whether the version was retained. If not, the arena counts it as dropped.
+   */
+  bool        retain(
+    thread::ThreadGlobalOrdinal thread_ordinal,
+    storage::StorageId storage_id,
+    uint64_t key,
+    XctId xct_id,
+    Epoch superseded_epoch,
+    const void* payload,
+    uint16_t payload_count,
+    Epoch durable_epoch);
+
+  /**
+   * @brief Copies a part of the version of a record that was current as of the given epoch.
+   * @param[in] storage_id storage of the record
+   * @param[in] key storage-specific key of the record
+   * @param[in] as_of the epoch to read as of
+   * @param[out] payload copied payload
+   * @param[in] payload_offset offset in the record's payload to copy from
+   * @param[in] payload_count byte size to copy
+   * @return kErrorCodeXctVersionUnavailable if the version is not found
+   * @details
+   * This method is called only when the current image of the record is newer than as_of.
+   */
+  ErrorCode   read(
+    storage::StorageId storage_id,
+    uint64_t key,
+    Epoch as_of,
+    void* payload,
+    uint16_t payload_offset,
+    uint16_t payload_count) const;
+
+  /** Sums up the counters of all arenas. */
+  VersionStoreStat get_stat() const;
+
+ private:
+  uint32_t    to_bucket(storage::StorageId storage_id, uint64_t key) const {
+    uint64_t hash = (key ^ (static_cast<uint64_t>(storage_id) << 40)) * 0x9E3779B97F4A7C15ULL;
+    return static_cast<uint32_t>(hash >> 32) & bucket_mask_;
+  }
+
+  VersionArena*             arenas_;
+  std::atomic<Pointer>*     buckets_;
+  RecordVersion*            slots_;
+  uint32_t                  bucket_mask_;
+  uint32_t                  thread_count_;
+  uint32_t                  slots_per_thread_;
+  uint16_t                  max_chain_length_;
+};
+
+}  // namespace xct
+}  // namespace foedus
+#endif  // FOEDUS_XCT_VERSION_STORE_IMPL_HPP_
@@ -34,6 +34,7 @@
 #endif  // NDEBUG
 
 #include "foedus/memory/fwd.hpp"
+#include "foedus/snapshot/snapshot_id.hpp"
 #include "foedus/storage/fwd.hpp"
 #include "foedus/storage/page.hpp"
 #include "foedus/storage/record.hpp"
@@ -62,6 +63,36 @@ class Xct {
     kMaxPageVersionSets = 1024,
   };
 
+  /**
+   * @brief Thread-private memory regions this object works on.
+   * @details
+   * Usually they are carved out of NumaCoreMemory of the thread. Coroutine contexts
+   * (see foedus::thread::CoroutineScheduler) bring their own pieces so that more than one
+   * transaction can be in-flight on one worker thread.
+   */
+  struct MemoryPieces {
+    SysxctWorkspace*        sysxct_workspace_;
+    PointerAccess*          pointer_set_;
+    PageVersionAccess*      page_version_set_;
+    ReadXctAccess*          read_set_;
+    WriteXctAccess*         write_set_;
+    LockFreeReadXctAccess*  lock_free_read_set_;
+    LockFreeWriteXctAccess* lock_free_write_set_;
+    LockEntry*              current_lock_list_;
+    uint64_t                current_lock_list_capacity_;
+    LockEntry*              retrospective_lock_list_;
+    uint64_t                retrospective_lock_list_capacity_;
+    void*                   local_work_memory_;
+    uint64_t                local_work_memory_size_;
+    /**
+     * The read/write-sets and local work memory above have room for this many times
+     * the configured sizes in XctOptions, and the lock lists' capacities are set accordingly.
+     * Only the configured sizes are assumed to be resident.
+     * @see XctOptions::work_memory_growth_factor_
+     */
+    uint16_t                growth_factor_;
+  };
+
   Xct(Engine* engine, thread::Thread* context, thread::ThreadId thread_id);
 
   // No copy
@@ -72,6 +103,11 @@ class Xct {
     memory::NumaCoreMemory* core_memory,
     uint32_t* mcs_block_current,
     uint32_t* mcs_rw_async_mapping_current);
+  /** Same as above except the memory pieces are explicitly given. */
+  void initialize(
+    const MemoryPieces& pieces,
+    uint32_t* mcs_block_current,
+    uint32_t* mcs_rw_async_mapping_current);
 
   /**
    * Begins the transaction.
@@ -83,10 +119,14 @@ class Xct {
     hot_threshold_for_this_xct_ = default_hot_threshold_for_this_xct_;
     rll_threshold_for_this_xct_ = default_rll_threshold_for_this_xct_;
     isolation_level_ = isolation_level;
+    snapshot_only_id_ = snapshot::kNullSnapshotId;
+    snapshot_only_epoch_ = INVALID_EPOCH;
+    multi_version_epoch_ = INVALID_EPOCH;
     pointer_set_size_ = 0;
     page_version_set_size_ = 0;
     read_set_size_ = 0;
     write_set_size_ = 0;
+    delta_write_count_ = 0;
     lock_free_read_set_size_ = 0;
     lock_free_write_set_size_ = 0;
     *mcs_block_current_ = 0;
@@ -101,6 +141,44 @@ class Xct {
     }
   }
 
+  /**
+   * @brief Turns the just-activated transaction into a snapshot-only read transaction.
+   * @param[in] snapshot_id The snapshot this transaction reads. Never kNullSnapshotId.
+   * @param[in] snapshot_epoch Valid-until epoch of the snapshot, which is already durable.
+   * @pre is_active() and the transaction has not accessed anything yet.
+   * @details
+   * A snapshot-only transaction reads only snapshot pages of the given snapshot.
+   * Snapshot pages are immutable, so it takes no read-set, pointer-set, or lock,
+   * and its precommit trivially succeeds. It cannot write anything.
+   * @see XctManager::begin_snapshot_only_xct()
+   */
+  void                set_snapshot_only(snapshot::SnapshotId snapshot_id, Epoch snapshot_epoch) {
+    ASSERT_ND(active_);
+    ASSERT_ND(snapshot_id != snapshot::kNullSnapshotId);
+    ASSERT_ND(snapshot_epoch.is_valid());
+    ASSERT_ND(isolation_level_ == kSnapshot);
+    ASSERT_ND(read_set_size_ == 0 && write_set_size_ == 0 && pointer_set_size_ == 0);
+    snapshot_only_id_ = snapshot_id;
+    snapshot_only_epoch_ = snapshot_epoch;
+  }
+
+  /**
+   * @brief Turns the just-activated transaction into a multi-version read transaction.
+   * @param[in] as_of The epoch whose versions this transaction reads. Already durable.
+   * @pre is_active() and the transaction has not accessed anything yet.
+   * @details
+   * A multi-version transaction reads the versions of records that were current as of the
+   * given epoch, either the current image or an old one in VersionStore.
+   * It takes no read-set, and its precommit trivially succeeds. It cannot write anything.
+   * @see XctManager::begin_multi_version_xct()
+   */
+  void                set_multi_version(Epoch as_of) {
+    ASSERT_ND(active_);
+    ASSERT_ND(as_of.is_valid());
+    ASSERT_ND(read_set_size_ == 0 && write_set_size_ == 0 && pointer_set_size_ == 0);
+    multi_version_epoch_ = as_of;
+  }
+
   /**
    * Closes the transaction.
    * @pre Before calling this method, all locks must be already released.
@@ -111,8 +189,30 @@ class Xct {
     active_ = false;
     *mcs_block_current_ = 0;
     *mcs_rw_async_mapping_current_ = 0;
+    if (UNLIKELY(is_work_memory_spilled())) {
+      release_spilled_work_memory();
+    }
   }
 
+  /**
+   * Whether the last transaction used more than the resident part of the read/write-sets
+   * or local work memory. @see XctOptions::work_memory_growth_factor_
+   */
+  bool                is_work_memory_spilled() const {
+    return read_set_size_ > resident_read_set_size_
+      || write_set_size_ > resident_write_set_size_
+      || lock_free_read_set_size_ > resident_lock_free_read_set_size_
+      || lock_free_write_set_size_ > resident_lock_free_write_set_size_
+      || local_work_memory_cur_ > resident_local_work_memory_size_
+      || retrospective_lock_list_spilled_;
+  }
+  /**
+   * Returns the physical memory beyond the resident part of the read/write-sets, lock lists,
+   * and local work memory to the OS. Called after a large transaction.
+   * Entries in RLL, which will be used in the next run, are retained.
+   */
+  void                release_spilled_work_memory();
+
   uint32_t            get_mcs_block_current() const { return *mcs_block_current_; }
   uint32_t            increment_mcs_block_current() { return ++(*mcs_block_current_); }
   void                decrement_mcs_block_current() { --(*mcs_block_current_); }
@@ -147,6 +247,18 @@ class Xct {
   }
   /** Returns the level of isolation for this transaction. */
   IsolationLevel      get_isolation_level() const { return isolation_level_; }
+  /** Returns if this transaction reads only the pinned snapshot. @see set_snapshot_only() */
+  bool                is_snapshot_only() const {
+    return snapshot_only_id_ != snapshot::kNullSnapshotId;
+  }
+  /** The snapshot a snapshot-only transaction reads. kNullSnapshotId otherwise. */
+  snapshot::SnapshotId get_snapshot_only_id() const { return snapshot_only_id_; }
+  /** Valid-until epoch of the snapshot a snapshot-only transaction reads. */
+  Epoch               get_snapshot_only_epoch() const { return snapshot_only_epoch_; }
+  /** Returns if this transaction reads versions as of an epoch. @see set_multi_version() */
+  bool                is_multi_version() const { return multi_version_epoch_.is_valid(); }
+  /** The epoch a multi-version transaction reads as of. Invalid otherwise. */
+  Epoch               get_multi_version_epoch() const { return multi_version_epoch_; }
   /** Returns the ID of this transaction, but note that it is not issued until commit time! */
   const XctId&        get_id() const { return id_; }
   thread::Thread*     get_thread_context() { return context_; }
@@ -339,8 +451,26 @@ class Xct {
     RwLockableXctId* owner_id_address,
     ReadXctAccess** read_set_address);
 
+  /**
+   * @brief Removes the read-set just added by on_record_read().
+   * @details
+   * Blind writes, such as delta_record() of masstree/hash, locate the record like other
+   * writes, but their result does not depend on the observed TID. They thus drop the read-set
+   * to avoid aborts due to concurrent writes.
+   * @pre read is the last entry of the read-set and has no related write-set
+   */
+  void                remove_last_read(ReadXctAccess* read) {
+    ASSERT_ND(read_set_size_ > 0);
+    ASSERT_ND(read == read_set_ + read_set_size_ - 1U);
+    ASSERT_ND(read->related_write_ == CXX11_NULLPTR);
+    --read_set_size_;
+  }
+
   /**
    * @brief Add the given record to the write set of this transaction.
+   * @return kErrorCodeXctDeltaConflict if this combines a delta update (eg
+   * storage::masstree::MasstreeStorage::delta_record()) with a write that deletes or shrinks
+   * the same record in this transaction. Precommit could not apply such a delta.
    */
   ErrorCode           add_to_write_set(
     storage::StorageId storage_id,
@@ -368,6 +498,19 @@ class Xct {
     char* payload_address,
     log::RecordLogType* log_entry);
 
+  /**
+   * @brief Lets precommit repair, rather than abort, the last write added to the write set.
+   * @param[in] functor re-computes the write when the read of the record turns out to be stale.
+   * It must stay alive until this transaction finishes.
+   * @return kErrorCodeInvalidParameter if the write set is empty
+   * @details
+   * Call this right after the storage method that overwrote the record, eg
+   * ArrayStorage::overwrite_record(). Precommit then invokes the functor with the current image
+   * of the record instead of aborting due to the record.
+   * @see XctRepairFunctor
+   */
+  ErrorCode           set_repair_functor(XctRepairFunctor* functor);
+
   /**
    * @brief Add the given record to the special read-set that is not placed in usual data pages.
    */
@@ -426,6 +569,16 @@ class Xct {
   friend std::ostream& operator<<(std::ostream& o, const Xct& v);
 
  private:
+  /**
+   * Checks the write-set for a write of the same record that cannot be combined with the
+   * new write because one of them is a delta update. Called only while the transaction has
+   * delta updates, so the linear search costs nothing in usual transactions.
+   */
+  ErrorCode           check_delta_conflict(
+    const RwLockableXctId* owner_id_address,
+    const log::RecordLogType* log_entry,
+    bool is_delta) const;
+
   Engine* const engine_;
   /**
    * The thread that holds this object, or a back pointer.
@@ -444,6 +597,19 @@ class Xct {
   /** Level of isolation for this transaction. */
   IsolationLevel      isolation_level_;
 
+  /**
+   * The snapshot this transaction reads if it is a snapshot-only transaction.
+   * kNullSnapshotId for usual transactions. Reset at every activate().
+   */
+  snapshot::SnapshotId  snapshot_only_id_;
+  /** Valid-until epoch of snapshot_only_id_. */
+  Epoch               snapshot_only_epoch_;
+  /**
+   * The epoch a multi-version transaction reads as of. Invalid for usual transactions.
+   * Reset at every activate().
+   */
+  Epoch               multi_version_epoch_;
+
   /** Whether the object is an active transaction. */
   bool                active_;
 
@@ -498,18 +664,25 @@ class Xct {
   ReadXctAccess*      read_set_;
   uint32_t            read_set_size_;
   uint32_t            max_read_set_size_;
+  /** Entries up to this are backed by physical memory from the start. */
+  uint32_t            resident_read_set_size_;
 
   WriteXctAccess*     write_set_;
   uint32_t            write_set_size_;
   uint32_t            max_write_set_size_;
+  uint32_t            resident_write_set_size_;
+  /** Number of delta updates in the write-set. */
+  uint32_t            delta_write_count_;
 
   LockFreeReadXctAccess*  lock_free_read_set_;
   uint32_t                lock_free_read_set_size_;
   uint32_t                max_lock_free_read_set_size_;
+  uint32_t                resident_lock_free_read_set_size_;
 
   LockFreeWriteXctAccess* lock_free_write_set_;
   uint32_t                lock_free_write_set_size_;
   uint32_t                max_lock_free_write_set_size_;
+  uint32_t                resident_lock_free_write_set_size_;
 
   PointerAccess*      pointer_set_;
   uint32_t            pointer_set_size_;
@@ -528,11 +701,16 @@ class Xct {
    * @see foedus::xct::RetrospectiveLockList
    */
   xct::RetrospectiveLockList  retrospective_lock_list_;
+  /** Lock lists' entries up to this are backed by physical memory from the start. */
+  uint32_t            resident_lock_list_capacity_;
+  /** Whether RLL still has entries beyond resident_lock_list_capacity_ after deactivate(). */
+  bool                retrospective_lock_list_spilled_;
 
   void*               local_work_memory_;
   uint64_t            local_work_memory_size_;
   /** This value is reset to zero for each transaction, and always <= local_work_memory_size_ */
   uint64_t            local_work_memory_cur_;
+  uint64_t            resident_local_work_memory_size_;
 };
 
 inline bool Xct::assert_related_read_write() const {
@@ -177,6 +177,13 @@ struct WriteXctAccess : public RecordXctAccess {
   /** @see ReadXctAccess::related_write_ */
   ReadXctAccess*        related_read_;
 
+  /**
+   * Re-computes log_entry_ when the read of the record turns out to be stale in precommit.
+   * Null (the default) means the transaction aborts in that case.
+   * @see Xct::set_repair_functor()
+   */
+  XctRepairFunctor*     repair_functor_;
+
   /** @copydoc foedux::xct::RecordXctAccess::compare() */
   static bool compare(const WriteXctAccess &left, const WriteXctAccess& right) ALWAYS_INLINE {
     return RecordXctAccess::compare(left, right);
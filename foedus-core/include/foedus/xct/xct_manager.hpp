@@ -17,13 +17,33 @@
  */
 #ifndef FOEDUS_XCT_XCT_MANAGER_HPP_
 #define FOEDUS_XCT_XCT_MANAGER_HPP_
+#include "foedus/epoch.hpp"
 #include "foedus/fwd.hpp"
 #include "foedus/initializable.hpp"
+#include "foedus/snapshot/snapshot_id.hpp"
+#include "foedus/storage/storage_id.hpp"
 #include "foedus/thread/fwd.hpp"
 #include "foedus/xct/fwd.hpp"
 #include "foedus/xct/xct_id.hpp"
 namespace foedus {
 namespace xct {
+/**
+ * @brief Counters of VersionStore, summed over all worker threads.
+ * @ingroup XCT
+ * @details
+ * A writer that could not retain the old image of a record makes multi-version transactions
+ * that need the image fail with kErrorCodeXctVersionUnavailable. If the dropped counts keep
+ * growing, consider a larger XctOptions::version_arena_size_kb_.
+ */
+struct VersionStoreStat {
+  /** Number of old versions retained. */
+  uint64_t  retained_count_;
+  /** Number of old versions not retained as the payload does not fit in a slot. */
+  uint64_t  dropped_large_count_;
+  /** Number of old versions not retained as readers might still need the oldest slot. */
+  uint64_t  dropped_in_use_count_;
+};
+
 /**
  * @brief Xct Manager class that provides API to begin/abort/commit transaction.
  * @ingroup XCT
@@ -79,6 +99,102 @@ class XctManager CXX11_FINAL : public virtual Initializable {
    */
   ErrorCode  begin_xct(thread::Thread* context, IsolationLevel isolation_level);
 
+  /**
+   * @brief Begins a new read-only transaction that reads only the most recent snapshot.
+   * @param[in,out] context Thread context
+   * @pre context->is_running_xct() == false
+   * @details
+   * The transaction is pinned to the snapshot that is the most recent one when it begins.
+   * It reads only the immutable snapshot pages of the snapshot, ignoring volatile pages.
+   * Hence, it takes no read-set, pointer-set, nor lock, and precommit_xct() never aborts it.
+   * The commit epoch returned by precommit_xct() is the snapshot epoch, which is already
+   * durable. The results are serializable as of the snapshot epoch, but might be stale.
+   *
+   * This is useful for long-running analytic queries and for huge scans, which would otherwise
+   * overflow the read-set or abort due to concurrent updates.
+   *
+   * The transaction fails with kErrorCodeXctSnapshotOnlyWrite when it tries to modify anything,
+   * with kErrorCodeXctNoSnapshotPage when the data does not exist in the snapshot (e.g., the
+   * storage was created after the snapshot), and with kErrorCodeXctSnapshotChanged when
+   * a newer snapshot has replaced pages it needs. The last one is a transient error. Retry it.
+   * @return kErrorCodeXctNoSnapshot if no snapshot has been taken yet.
+   */
+  ErrorCode  begin_snapshot_only_xct(thread::Thread* context);
+
+  /**
+   * @brief Begins a new read-only transaction pinned to the given, possibly older, snapshot.
+   * @param[in,out] context Thread context
+   * @param[in] snapshot_id the snapshot to read
+   * @param[in] snapshot_epoch valid-until epoch of the snapshot, returned as the commit epoch
+   * @pre context->is_running_xct() == false
+   * @details
+   * Same as begin_snapshot_only_xct(Thread*) except the pinned snapshot.
+   * The transaction must read storages whose root pointers are of the snapshot, which
+   * snapshot::SnapshotView provides. Storage objects of the engine point to newer snapshots.
+   * @see snapshot::SnapshotView::begin_xct()
+   */
+  ErrorCode  begin_snapshot_only_xct(
+    thread::Thread* context,
+    snapshot::SnapshotId snapshot_id,
+    Epoch snapshot_epoch);
+
+  /**
+   * @brief Begins a new read-only transaction that reads versions as of the durable epoch.
+   * @param[in,out] context Thread context
+   * @pre context->is_running_xct() == false
+   * @details
+   * The transaction reads each record as it was at the end of the durable global epoch
+   * when the transaction begins. If a record has been overwritten since then, it reads
+   * the old version retained in VersionStore. Hence, it takes no read-set and
+   * precommit_xct() never aborts it. The commit epoch is the durable epoch it read as of.
+   * Unlike begin_snapshot_only_xct(), the results are as recent as the durable epoch.
+   *
+   * This requires XctOptions::version_arena_size_kb_ to be non-zero. So far, it can read
+   * records only via get_record() and get_record_primitive() of array storages.
+   * Reads of masstree, hash, and sequential storages fail with
+   * kErrorCodeXctMultiVersionUnsupported, and writes fail with kErrorCodeXctMultiVersionWrite.
+   *
+   * Retaining old versions is best-effort. Under heavy writes, a writer drops the old version
+   * instead of waiting when its arena has no slot to recycle, and versions are recycled as
+   * soon as their successors become durable. A read then fails with
+   * kErrorCodeXctVersionUnavailable. That is a transient error. Retry the transaction, which
+   * reads as of a newer durable epoch. get_version_store_stat() tells how often this happens.
+   * @return kErrorCodeXctMultiVersionDisabled if the version store is disabled.
+   */
+  ErrorCode  begin_multi_version_xct(thread::Thread* context);
+
+  /**
+   * @brief Returns how many old versions writers have retained or dropped so far.
+   * @details
+   * All counts are zero if the version store is disabled. The counts might be slightly stale.
+   */
+  VersionStoreStat get_version_store_stat() const;
+
+  /**
+   * @brief Reads a part of a record in a multi-version transaction.
+   * @param[in,out] context Thread context running a multi-version transaction
+   * @param[in] storage_id storage of the record
+   * @param[in] key storage-specific key of the record, eg ArrayOffset
+   * @param[in] owner_id the current owner ID of the record
+   * @param[in] record_payload the current payload of the record
+   * @param[out] payload copied payload
+   * @param[in] payload_offset offset in the record's payload to copy from
+   * @param[in] payload_count byte size to copy
+   * @details
+   * This is called by storages, not by client programs.
+   * It copies the current payload if it is not newer than the epoch the transaction reads
+   * as of, otherwise the retained old version.
+   */
+  ErrorCode  read_multi_version(
+    thread::Thread* context,
+    storage::StorageId storage_id,
+    uint64_t key,
+    const RwLockableXctId* owner_id,
+    const char* record_payload,
+    void* payload,
+    uint16_t payload_offset,
+    uint16_t payload_count);
+
   /**
    * @brief Prepares the currently running transaction on the thread for commit.
    * @pre context->is_running_xct() == true
@@ -103,6 +219,21 @@ class XctManager CXX11_FINAL : public virtual Initializable {
    */
   ErrorCode   wait_for_commit(Epoch commit_epoch, int64_t wait_microseconds = -1);
 
+  /**
+   * @brief Same as wait_for_commit(), but lets other coroutines of the thread run meanwhile.
+   * @param[in,out] context Thread context
+   * @param[in] commit_epoch the commit epoch returned by precommit_xct()
+   * @param[in] wait_microseconds same as wait_for_commit()
+   * @details
+   * If the thread is running a coroutine that can be suspended
+   * (thread::Thread::is_coroutine_yieldable()), this method suspends the coroutine until the
+   * durable global epoch reaches commit_epoch. Otherwise, exactly same as wait_for_commit().
+   */
+  ErrorCode   wait_for_commit(
+    thread::Thread* context,
+    Epoch commit_epoch,
+    int64_t wait_microseconds = -1);
+
   /**
    * @brief Aborts the currently running transaction on the thread.
    * @param[in,out] context Thread context
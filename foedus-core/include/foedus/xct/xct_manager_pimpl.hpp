@@ -23,6 +23,7 @@
 #include "foedus/epoch.hpp"
 #include "foedus/fwd.hpp"
 #include "foedus/initializable.hpp"
+#include "foedus/snapshot/snapshot_id.hpp"
 #include "foedus/soc/shared_memory_repo.hpp"
 #include "foedus/soc/shared_polling.hpp"
 #include "foedus/thread/condition_variable_impl.hpp"
@@ -30,6 +31,7 @@
 #include "foedus/thread/stoppable_thread_impl.hpp"
 #include "foedus/xct/fwd.hpp"
 #include "foedus/xct/retrospective_lock_list.hpp"  // to inline CurrentLockListIteratorForWriteSet
+#include "foedus/xct/version_store_impl.hpp"
 #include "foedus/xct/xct_access.hpp"               // same above. iterator must be fast...
 #include "foedus/xct/xct_id.hpp"
 
@@ -115,6 +117,22 @@ class XctManagerPimpl final : public DefaultInitializable {
   }
 
   ErrorCode   begin_xct(thread::Thread* context, IsolationLevel isolation_level);
+  ErrorCode   begin_snapshot_only_xct(thread::Thread* context);
+  ErrorCode   begin_snapshot_only_xct(
+    thread::Thread* context,
+    snapshot::SnapshotId snapshot_id,
+    Epoch snapshot_epoch);
+  ErrorCode   begin_multi_version_xct(thread::Thread* context);
+  VersionStoreStat get_version_store_stat() const { return version_store_.get_stat(); }
+  ErrorCode   read_multi_version(
+    thread::Thread* context,
+    storage::StorageId storage_id,
+    uint64_t key,
+    const RwLockableXctId* owner_id,
+    const char* record_payload,
+    void* payload,
+    uint16_t payload_offset,
+    uint16_t payload_count);
   /**
    * This is the gut of commit protocol. It's mostly same as [TU2013].
    */
@@ -122,6 +140,10 @@ class XctManagerPimpl final : public DefaultInitializable {
   ErrorCode   abort_xct(thread::Thread* context);
 
   ErrorCode   wait_for_commit(Epoch commit_epoch, int64_t wait_microseconds);
+  ErrorCode   wait_for_commit(
+    thread::Thread* context,
+    Epoch commit_epoch,
+    int64_t wait_microseconds);
   void        set_requested_global_epoch(Epoch request);
   void        advance_current_global_epoch();
   void        wait_for_current_global_epoch(Epoch target_epoch, int64_t wait_microseconds);
@@ -166,6 +188,14 @@ class XctManagerPimpl final : public DefaultInitializable {
    * we take lock. In that case we redo the process. It happens.
    */
   ErrorCode   precommit_xct_lock_batch_track_moved(thread::Thread* context);
+  /**
+   * Subroutine of precommit_xct_lock to check a write-set without related read-set.
+   * Most of them are truly blind (eg array overwrite), but delta logs of masstree/hash
+   * require the record to be still alive and long enough. They have no read-set to verify it,
+   * so we check it here after taking the lock.
+   * @return whether the write can be applied
+   */
+  bool        precommit_xct_check_blind_write(const WriteXctAccess* write) const;
   /**
    * @brief Phase 2 of precommit_xct() for read-only case
    * @return true if verification succeeded. false if we need to abort.
@@ -183,6 +213,23 @@ class XctManagerPimpl final : public DefaultInitializable {
    * Because phase 2 is after the memory fence, no thread would take new locks while checking.
    */
   bool        precommit_xct_verify_readwrite(thread::Thread* context, XctId* max_xct_id);
+  /**
+   * @brief Subroutine of precommit_xct_lock() and precommit_xct_verify_readwrite() to repair
+   * writes whose read turned out to be stale, instead of aborting.
+   * @param[in] context thread context
+   * @param[in,out] read the stale read. Its observed_owner_id_ becomes the current XctId
+   * if successfully repaired.
+   * @param[in] writes_begin first write-set entry of the same record
+   * @param[in] writes_end one past the last write-set entry of the same record
+   * @pre the record is X-locked by this transaction
+   * @return whether all the writes were repaired. false if any of them has no
+   * XctRepairFunctor, in which case the transaction must abort.
+   */
+  bool        precommit_xct_repair(
+    thread::Thread* context,
+    ReadXctAccess* read,
+    WriteXctAccess* writes_begin,
+    WriteXctAccess* writes_end);
   /** Returns false if there is any pointer set conflict */
   bool        precommit_xct_verify_pointer_set(thread::Thread* context);
   /** Returns false if there is any page version conflict */
@@ -197,6 +244,15 @@ class XctManagerPimpl final : public DefaultInitializable {
    * This method does NOT release locks yet. This is one difference from SILO.
    */
   void        precommit_xct_apply(thread::Thread* context, XctId max_xct_id, Epoch *commit_epoch);
+  /**
+   * Subroutine of precommit_xct_apply() to retain the current image of a record in
+   * version_store_ before the write-set overwrites it in a new epoch.
+   * So far only array records are retained.
+   */
+  void        precommit_xct_retain_version(
+    thread::Thread* context,
+    const WriteXctAccess& write,
+    Epoch commit_epoch);
   /** unlocking all acquired locks, used when commit/abort. */
   void        release_and_clear_all_current_locks(thread::Thread* context);
   bool        precommit_xct_acquire_writer_lock(thread::Thread* context, WriteXctAccess *write);
@@ -223,6 +279,8 @@ class XctManagerPimpl final : public DefaultInitializable {
 
   Engine* const                 engine_;
   XctManagerControlBlock*       control_block_;
+  /** Old versions of records for multi-version transactions. Disabled by default. */
+  VersionStore                  version_store_;
 
   /**
    * This thread keeps advancing the current_global_epoch_.
@@ -45,11 +45,17 @@ struct XctOptions CXX11_FINAL : public virtual externalize::Externalizable {
     kDefaultMaxLockFreeWriteSetSize = 4 << 10,
     /** Default value for local_work_memory_size_mb_. */
     kDefaultLocalWorkMemorySizeMb = 2,
+    /** Default value for work_memory_growth_factor_. */
+    kDefaultWorkMemoryGrowthFactor = 4,
     /** Default value for epoch_advance_interval_ms_. */
     kDefaultEpochAdvanceIntervalMs = 20,
     kMcsImplementationTypeSimple = 0,
     kMcsImplementationTypeExtended = 1,
     kDefaultHotThreshold = 256,  // OCC by default (for test cases and benchamrks that don't set it)
+    /** Default value for version_arena_size_kb_. 0 means multi-version reads are disabled. */
+    kDefaultVersionArenaSizeKb = 0,
+    /** Default value for max_version_chain_length_. */
+    kDefaultMaxVersionChainLength = 16,
   };
 
   /**
@@ -100,6 +106,22 @@ struct XctOptions CXX11_FINAL : public virtual externalize::Externalizable {
    */
   uint32_t    local_work_memory_size_mb_;
 
+  /**
+   * @brief How many times larger than the configured sizes the read/write-sets, lock lists,
+   * and local work memory of one transaction can grow.
+   * @details
+   * Default is 4. 1 means a transaction can't exceed the sizes above.
+   * The sizes above (max_read_set_size_ etc) are what each thread keeps resident.
+   * We additionally reserve (this value - 1) times more address space right after each of them,
+   * which is bound to the thread's NUMA node but not backed by physical memory until a
+   * large transaction actually touches it. After such a transaction, the thread returns the
+   * physical memory beyond the resident sizes to the OS.
+   * So, the sizes above can be tuned for usual transactions while occasional large
+   * transactions (eg maintenance jobs) still go through without a special configuration.
+   * The entries never move, so the common case is exactly as fast as when this is 1.
+   */
+  uint16_t    work_memory_growth_factor_;
+
   /**
    * @brief Intervals in milliseconds between epoch advancements.
    * @details
@@ -162,6 +184,31 @@ struct XctOptions CXX11_FINAL : public virtual externalize::Externalizable {
    * @see foedus::xct::McsImpl
    */
   uint16_t    mcs_implementation_type_;
+
+  /**
+   * @brief Size of the per-thread arena that retains old versions of overwritten records.
+   * @details
+   * Default is 0, which disables multi-version reads (XctManager::begin_multi_version_xct()).
+   * When non-zero, each worker thread copies the image of a record into its arena before it
+   * overwrites the record in a new epoch, and read-only transactions can read the version
+   * that was current as of the durable epoch without read-set validation.
+   * The arenas are placed in the global shared memory, so the total size is this value
+   * times the number of worker threads. A version is recycled only after its successor
+   * becomes durable, so the arena should be large enough to hold the versions overwritten
+   * in a few epochs. Otherwise, writers drop old versions, and multi-version transactions that
+   * need them fail with a retryable error (see XctManager::get_version_store_stat()).
+   * So far only array storages retain versions.
+   * @see VersionStore
+   */
+  uint32_t    version_arena_size_kb_;
+
+  /**
+   * @brief The maximum number of versions a multi-version read follows in a version chain.
+   * @details
+   * Default is 16. A read that does not find the version within this many hops fails
+   * with kErrorCodeXctVersionUnavailable, which is a retryable error.
+   */
+  uint16_t    max_version_chain_length_;
 };
 }  // namespace xct
 }  // namespace foedus
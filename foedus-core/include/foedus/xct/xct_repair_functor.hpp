@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#ifndef FOEDUS_XCT_XCT_REPAIR_FUNCTOR_HPP_
+#define FOEDUS_XCT_XCT_REPAIR_FUNCTOR_HPP_
+
+#include "foedus/error_code.hpp"
+#include "foedus/log/fwd.hpp"
+#include "foedus/thread/fwd.hpp"
+#include "foedus/xct/fwd.hpp"
+
+namespace foedus {
+namespace xct {
+
+/**
+ * @brief A functor that re-computes a write from the current image of the record.
+ * @ingroup XCT
+ * @details
+ * A transaction usually aborts when precommit finds that a record it read has been changed
+ * by another transaction, and the application retries from scratch.
+ * For a read-modify-write whose new value depends only on the record itself and on the
+ * application's inputs (eg, decrementing the stock quantity in TPC-C NewOrder),
+ * the application can instead attach this functor to the write via
+ * Xct::set_repair_functor(). When the read turns out to be stale, precommit
+ * invokes repair() for all writes to the record while it holds the write lock,
+ * then takes the current XctId as the observed one and continues committing.
+ * Only the invalidated reads and their writes are re-computed.
+ *
+ * Do not attach it if any other access of the transaction depends on the value you read
+ * (eg, the value is used as a key of an insert). precommit can't repair them.
+ *
+ * The functor must stay alive until precommit_xct() returns.
+ * It might be called more than once for one write, so it must be idempotent, namely it
+ * must compute the new value from the given payload, not from the log.
+ *
+ * @note Because this will have vtable, do NOT place this object in shared memory!
+ */
+struct XctRepairFunctor {
+  virtual ~XctRepairFunctor() {}
+  /**
+   * @brief Re-computes the log of a write.
+   * @param[in] context thread context
+   * @param[in] payload the current payload of the record, locked by this transaction
+   * @param[in,out] log_entry the log of the write to re-compute in place. Its type and length
+   * must not change.
+   * @return kErrorCodeOk if repaired. Any other value aborts the transaction.
+   */
+  virtual ErrorCode repair(
+    thread::Thread* context,
+    const char* payload,
+    log::RecordLogType* log_entry) = 0;
+};
+
+}  // namespace xct
+}  // namespace foedus
+#endif  // FOEDUS_XCT_XCT_REPAIR_FUNCTOR_HPP_
@@ -328,6 +328,34 @@ void CacheHashtable::evict_overflow_loop(CacheHashtable::EvictArgs* args, uint16
     << (checked_count) << " buckets in " << watch.elapsed_us() << "us";
 }
 
+uint64_t CacheHashtable::collect_hot_entries(uint64_t max_count, HotEntry* out) const {
+  uint64_t count = 0;
+  const BucketId end = get_physical_buckets();
+  for (BucketId i = 0; i < end && count < max_count; ++i) {
+    // read the bucket as a whole 8 bytes. see the comment of CacheBucket.
+    CacheBucket bucket = buckets_[i];
+    uint16_t refcount = refcounts_[i].count_;
+    if (bucket.is_content_set() && refcount > 0) {
+      out[count].content_ = bucket.get_content_id();
+      out[count].refcount_ = refcount;
+      ++count;
+    }
+  }
+
+  if (overflow_buckets_head_) {
+    for (OverflowPointer i = overflow_buckets_head_; i != 0 && count < max_count;) {
+      CacheBucket bucket = overflow_buckets_[i].bucket_;
+      uint16_t refcount = overflow_buckets_[i].refcount_.count_;
+      if (bucket.is_content_set() && refcount > 0) {
+        out[count].content_ = bucket.get_content_id();
+        out[count].refcount_ = refcount;
+        ++count;
+      }
+      i = overflow_buckets_[i].next_;
+    }
+  }
+  return count;
+}
 
 std::ostream& operator<<(std::ostream& o, const HashFunc& v) {
   o << "<HashFunc>"
@@ -19,17 +19,24 @@
 
 #include <glog/logging.h>
 
+#include <algorithm>
 #include <chrono>
+#include <fstream>
 #include <sstream>
 #include <string>
+#include <vector>
 
 #include "foedus/engine.hpp"
 #include "foedus/engine_options.hpp"
 #include "foedus/cache/cache_hashtable.hpp"
+#include "foedus/cache/snapshot_file_set.hpp"
 #include "foedus/debugging/stop_watch.hpp"
+#include "foedus/fs/filesystem.hpp"
 #include "foedus/memory/engine_memory.hpp"
 #include "foedus/memory/numa_node_memory.hpp"
 #include "foedus/savepoint/savepoint_manager.hpp"
+#include "foedus/storage/page.hpp"
+#include "foedus/thread/numa_thread_scope.hpp"
 #include "foedus/xct/xct_manager.hpp"
 
 namespace foedus {
@@ -91,6 +98,13 @@ ErrorStack CacheManagerPimpl::initialize_once() {
     memory::AlignedMemory::kNumaAllocOnnode,
     engine_->get_soc_id());
   reclaimed_pages_ = reinterpret_cast<memory::PagePoolOffset*>(reclaimed_pages_memory_.get_block());
+  if (options.snapshot_cache_persist_hot_list_) {
+    hot_entries_memory_.alloc(
+      total_pages_ * sizeof(CacheHashtable::HotEntry),
+      1ULL << 21,
+      memory::AlignedMemory::kNumaAllocOnnode,
+      engine_->get_soc_id());
+  }
 
   // launch the cleaner thread
   stop_requested_.store(false);
@@ -107,18 +121,36 @@ ErrorStack CacheManagerPimpl::uninitialize_once() {
 
   LOG(INFO) << "Uninitializing Snapshot Cache... " << describe();
   CHECK_ERROR(stop_cleaner());
+  if (engine_->get_options().cache_.snapshot_cache_persist_hot_list_) {
+    // the cleaner has stopped, so no one evicts pages while we read them.
+    ErrorStack dump_error = dump_hot_list();
+    if (dump_error.is_error()) {
+      LOG(WARNING) << "Failed to dump the hot list of snapshot cache: " << dump_error;
+    }
+  }
 
   pool_ = nullptr;
   hashtable_ = nullptr;
   reclaimed_pages_ = nullptr;
   reclaimed_pages_memory_.release_block();
   reclaimed_pages_count_ = 0;
+  hot_entries_memory_.release_block();
   return kRetOk;
 }
 
 void CacheManagerPimpl::handle_cleaner() {
   LOG(INFO) << "Here we go. Cleaner thread: " << describe();
 
+  const CacheOptions& options = engine_->get_options().cache_;
+  if (options.snapshot_cache_persist_hot_list_) {
+    // Warm up the cache before the usual job. Transactions are running concurrently.
+    ErrorStack prefetch_error = prefetch_hot_list();
+    if (prefetch_error.is_error()) {
+      LOG(WARNING) << "Failed to prefetch the hot list of snapshot cache: " << prefetch_error;
+    }
+  }
+  debugging::StopWatch hot_list_watch;
+
   const uint32_t kIntervalMs = 5;  // should be a bit shorter than epoch-advance interval
   while (!stop_requested_) {
     DVLOG(2) << "Cleaner thread came in: " << describe();
@@ -179,6 +211,16 @@ void CacheManagerPimpl::handle_cleaner() {
       DVLOG(2) << "Still enough free pages. do nothing";
     }
 
+    if (options.snapshot_cache_persist_hot_list_
+      && hot_list_watch.peek_elapsed_ns()
+        >= options.snapshot_cache_hot_list_interval_ms_ * 1000000ULL) {
+      ErrorStack dump_error = dump_hot_list();
+      if (dump_error.is_error()) {
+        LOG(WARNING) << "Failed to dump the hot list of snapshot cache: " << dump_error;
+      }
+      hot_list_watch.start();
+    }
+
     if (!stop_requested_) {
       std::this_thread::sleep_for(std::chrono::milliseconds(kIntervalMs));
     }
@@ -209,6 +251,169 @@ ErrorStack CacheManagerPimpl::stop_cleaner() {
   return kRetOk;
 }
 
+const uint64_t CacheManagerPimpl::kHotListMagicWord;
+const uint16_t CacheManagerPimpl::kMaxPrefetchRunPages;
+
+/** Sorts hot entries in descending order of refcount. */
+inline bool is_hotter(const CacheHashtable::HotEntry& left, const CacheHashtable::HotEntry& right) {
+  return left.refcount_ > right.refcount_;
+}
+
+std::string CacheManagerPimpl::get_hot_list_path() const {
+  return engine_->get_options().cache_.convert_hot_list_path_pattern(engine_->get_soc_id());
+}
+
+ErrorStack CacheManagerPimpl::dump_hot_list() {
+  ASSERT_ND(hot_entries_memory_.get_block());
+  debugging::StopWatch watch;
+  CacheHashtable::HotEntry* entries
+    = reinterpret_cast<CacheHashtable::HotEntry*>(hot_entries_memory_.get_block());
+  uint64_t count = hashtable_->collect_hot_entries(total_pages_, entries);
+  std::sort(entries, entries + count, is_hotter);
+
+  // No point to remember more than what the next engine can prefetch.
+  std::vector<storage::SnapshotPagePointer> page_ids;
+  page_ids.reserve(std::min<uint64_t>(count, cleaner_threshold_));
+  const storage::Page* pool_base = pool_->get_base();
+  for (uint64_t i = 0; i < count && page_ids.size() < cleaner_threshold_; ++i) {
+    ASSERT_ND(entries[i].content_ < total_pages_);
+    const storage::PageHeader& header = pool_base[entries[i].content_].get_header();
+    if (header.snapshot_ && header.page_id_ != 0) {
+      page_ids.push_back(header.page_id_);
+    }
+  }
+
+  // write to a temporary file then rename so that the next engine never sees a partial list
+  fs::Path path(get_hot_list_path());
+  fs::Path tmp_path(path.string() + std::string(".tmp"));
+  if (path.has_parent_path() && !fs::exists(path.parent_path())) {
+    fs::create_directories(path.parent_path(), true);
+  }
+  HotListHeader header = { kHotListMagicWord, page_ids.size() };
+  {
+    std::ofstream file(tmp_path.string(), std::ofstream::binary | std::ofstream::trunc);
+    if (!file.is_open()) {
+      return ERROR_STACK_MSG(kErrorCodeFsFailedToOpen, tmp_path.c_str());
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(
+      reinterpret_cast<const char*>(page_ids.data()),
+      page_ids.size() * sizeof(storage::SnapshotPagePointer));
+    file.flush();
+    if (!file.good()) {
+      return ERROR_STACK_MSG(kErrorCodeFsWriteFail, tmp_path.c_str());
+    }
+  }
+  if (!fs::durable_atomic_rename(tmp_path, path)) {
+    return ERROR_STACK_MSG(kErrorCodeFsWriteFail, path.c_str());
+  }
+  watch.stop();
+  LOG(INFO) << "Dumped " << page_ids.size() << " hot snapshot page IDs out of " << count
+    << " cached pages to " << path << " in " << watch.elapsed_ms() << "ms";
+  return kRetOk;
+}
+
+ErrorStack CacheManagerPimpl::prefetch_hot_list() {
+  fs::Path path(get_hot_list_path());
+  if (!fs::exists(path)) {
+    LOG(INFO) << "No hot list of snapshot cache to prefetch: " << path;
+    return kRetOk;
+  }
+
+  debugging::StopWatch watch;
+  std::vector<storage::SnapshotPagePointer> page_ids;
+  {
+    std::ifstream file(path.string(), std::ifstream::binary);
+    if (!file.is_open()) {
+      return ERROR_STACK_MSG(kErrorCodeFsFailedToOpen, path.c_str());
+    }
+    HotListHeader header;
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file.good()) {
+      return ERROR_STACK_MSG(kErrorCodeFsTooShortRead, path.c_str());
+    } else if (header.magic_word_ != kHotListMagicWord || header.page_count_ > total_pages_) {
+      return ERROR_STACK_MSG(kErrorCodeInvalidParameter, path.c_str());
+    }
+    page_ids.resize(header.page_count_);
+    file.read(
+      reinterpret_cast<char*>(page_ids.data()),
+      page_ids.size() * sizeof(storage::SnapshotPagePointer));
+    if (!file.good()) {
+      return ERROR_STACK_MSG(kErrorCodeFsTooShortRead, path.c_str());
+    }
+  }
+
+  // The hottest pages come first. Take as many as the cache can hold without eviction,
+  // then sort them by snapshot file and offset so that we can read contiguous ones at once.
+  uint64_t allocated = pool_->get_stat().allocated_pages_;
+  uint64_t capacity = allocated < cleaner_threshold_ ? cleaner_threshold_ - allocated : 0;
+  if (page_ids.size() > capacity) {
+    page_ids.resize(capacity);
+  }
+  std::sort(page_ids.begin(), page_ids.end());
+  page_ids.erase(std::unique(page_ids.begin(), page_ids.end()), page_ids.end());
+
+  thread::NumaThreadScope numa_scope(engine_->get_soc_id());
+  SnapshotFileSet files(engine_);
+  CHECK_ERROR(files.initialize());
+  uint64_t prefetched = 0;
+  uint64_t skipped = 0;
+  memory::PagePoolOffset offsets[kMaxPrefetchRunPages];
+  void* buffers[kMaxPrefetchRunPages];
+  storage::Page* pool_base = pool_->get_base();
+  for (uint64_t i = 0; i < page_ids.size() && !stop_requested_;) {
+    if (pool_->get_stat().allocated_pages_ >= cleaner_threshold_) {
+      LOG(INFO) << "Transactions filled the snapshot cache during prefetch. Stopped prefetch";
+      break;
+    }
+    storage::SnapshotPagePointer page_id = page_ids[i];
+    ContentId existing = hashtable_->find(page_id);
+    if (existing != 0 && pool_base[existing].get_header().page_id_ == page_id) {
+      ++i;  // someone already read it
+      continue;
+    }
+    uint16_t run = 1;
+    while (i + run < page_ids.size()
+      && run < kMaxPrefetchRunPages
+      && page_ids[i + run] == page_id + run) {
+      ++run;
+    }
+
+    uint16_t grabbed;
+    for (grabbed = 0; grabbed < run; ++grabbed) {
+      if (pool_->grab_one(offsets + grabbed) != kErrorCodeOk) {
+        break;
+      }
+      buffers[grabbed] = pool_base + offsets[grabbed];
+    }
+    if (grabbed < run) {
+      for (uint16_t j = 0; j < grabbed; ++j) {
+        pool_->release_one(offsets[j]);
+      }
+      LOG(INFO) << "No more free pages in snapshot cache. Stopped prefetch";
+      break;
+    }
+
+    ErrorCode read_result = files.read_pages_scattered(page_id, run, buffers);
+    for (uint16_t j = 0; j < run; ++j) {
+      if (read_result != kErrorCodeOk
+        || hashtable_->install(page_id + j, offsets[j]) != kErrorCodeOk) {
+        // most likely the snapshot file was removed. the list is just a hint. skip it.
+        pool_->release_one(offsets[j]);
+        ++skipped;
+      } else {
+        ++prefetched;
+      }
+    }
+    i += run;
+  }
+  CHECK_ERROR(files.uninitialize());
+
+  watch.stop();
+  LOG(INFO) << "Prefetched " << prefetched << " hot snapshot pages (skipped " << skipped
+    << ") from " << path << " in " << watch.elapsed_ms() << "ms: " << describe();
+  return kRetOk;
+}
 
 std::string CacheManagerPimpl::describe() const {
   if (pool_ == nullptr) {
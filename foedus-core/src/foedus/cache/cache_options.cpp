@@ -17,6 +17,9 @@
  */
 #include "foedus/cache/cache_options.hpp"
 
+#include <string>
+
+#include "foedus/assorted/assorted_func.hpp"
 #include "foedus/memory/page_pool.hpp"
 
 namespace foedus {
@@ -27,7 +30,15 @@ CacheOptions::CacheOptions() {
   private_snapshot_cache_initial_grab_ = memory::PagePoolOffsetChunk::kMaxSize / 2;
   snapshot_cache_eviction_threshold_ = 0.75;
   snapshot_cache_urgent_threshold_ = 0.9;
+  snapshot_cache_persist_hot_list_ = false;
+  snapshot_cache_hot_list_path_pattern_ = "snapshots/node_$NODE$/hot_pages.bin";
+  snapshot_cache_hot_list_interval_ms_ = kDefaultSnapshotCacheHotListIntervalMs;
+}
+
+std::string CacheOptions::convert_hot_list_path_pattern(int node) const {
+  return assorted::replace_all(snapshot_cache_hot_list_path_pattern_.str(), "$NODE$", node);
 }
+
 ErrorStack CacheOptions::load(tinyxml2::XMLElement* element) {
   EXTERNALIZE_LOAD_ELEMENT(element, snapshot_cache_enabled_);
   EXTERNALIZE_LOAD_ELEMENT(element, snapshot_cache_size_mb_per_node_);
@@ -38,6 +49,9 @@ ErrorStack CacheOptions::load(tinyxml2::XMLElement* element) {
   EXTERNALIZE_LOAD_ELEMENT(element, snapshot_cache_urgent_threshold_);
   ASSERT_ND(snapshot_cache_urgent_threshold_ >= snapshot_cache_eviction_threshold_);
   ASSERT_ND(snapshot_cache_urgent_threshold_ <= 1);
+  EXTERNALIZE_LOAD_ELEMENT(element, snapshot_cache_persist_hot_list_);
+  EXTERNALIZE_LOAD_ELEMENT(element, snapshot_cache_hot_list_path_pattern_);
+  EXTERNALIZE_LOAD_ELEMENT(element, snapshot_cache_hot_list_interval_ms_);
   return kRetOk;
 }
 ErrorStack CacheOptions::save(tinyxml2::XMLElement* element) const {
@@ -62,6 +76,14 @@ ErrorStack CacheOptions::save(tinyxml2::XMLElement* element) const {
     snapshot_cache_urgent_threshold_,
     "When the cache eviction performs in an urgent mode, which immediately advances"
     " the current epoch to release pages");
+  EXTERNALIZE_SAVE_ELEMENT(element, snapshot_cache_persist_hot_list_,
+    "Whether to periodically persist the IDs of hot snapshot pages and prefetch them"
+    " when the engine starts up.");
+  EXTERNALIZE_SAVE_ELEMENT(element, snapshot_cache_hot_list_path_pattern_,
+    "String pattern of the full path of the file to persist hot snapshot page IDs."
+    " A special placeholder $NODE$ will be replaced with the NUMA node number.");
+  EXTERNALIZE_SAVE_ELEMENT(element, snapshot_cache_hot_list_interval_ms_,
+    "Interval in milliseconds to dump the hot snapshot page IDs.");
   return kRetOk;
 }
 
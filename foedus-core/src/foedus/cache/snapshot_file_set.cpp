@@ -59,33 +59,36 @@ void SnapshotFileSet::close_all() {
 ErrorCode SnapshotFileSet::get_or_open_file(
   snapshot::SnapshotId snapshot_id,
   thread::ThreadGroupId node_id,
+  uint8_t shard,
   fs::DirectIoFile** out) {
   *out = nullptr;
   auto snapshot = files_.find(snapshot_id);
   if (snapshot == files_.end()) {
     files_.insert(
-      std::pair<snapshot::SnapshotId, std::map< thread::ThreadGroupId, fs::DirectIoFile* > >(
-        snapshot_id, std::map< thread::ThreadGroupId, fs::DirectIoFile* >()));
+      std::pair<snapshot::SnapshotId, std::map< FileKey, fs::DirectIoFile* > >(
+        snapshot_id, std::map< FileKey, fs::DirectIoFile* >()));
     snapshot = files_.find(snapshot_id);
   }
   ASSERT_ND(snapshot != files_.end());
   ASSERT_ND(snapshot->first == snapshot_id);
   auto& the_map = snapshot->second;
-  auto node = the_map.find(node_id);
+  const FileKey key(node_id, shard);
+  auto node = the_map.find(key);
   if (node != the_map.end()) {
     *out = node->second;
     return kErrorCodeOk;
   } else {
     fs::Path path(engine_->get_options().snapshot_.construct_snapshot_file_path(
       snapshot_id,
-      node_id));
+      node_id,
+      shard));
     fs::DirectIoFile* file = new fs::DirectIoFile(path);
     ErrorCode open_error = file->open(true, false, false, false);
     if (open_error != kErrorCodeOk) {
       delete file;
       return open_error;
     }
-    std::pair< thread::ThreadGroupId, fs::DirectIoFile* > entry(node_id, file);
+    std::pair< FileKey, fs::DirectIoFile* > entry(key, file);
     the_map.insert(entry);
     *out = file;
     return kErrorCodeOk;
@@ -95,10 +98,7 @@ ErrorCode SnapshotFileSet::get_or_open_file(
 ErrorCode SnapshotFileSet::read_page(storage::SnapshotPagePointer page_id, void* out) {
   fs::DirectIoFile* file;
   CHECK_ERROR_CODE(get_or_open_file(page_id, &file));
-  storage::SnapshotLocalPageId local_page_id
-    = storage::extract_local_page_id_from_snapshot_pointer(page_id);
-  CHECK_ERROR_CODE(
-    file->seek(local_page_id * sizeof(storage::Page), fs::DirectIoFile::kDirectIoSeekSet));
+  CHECK_ERROR_CODE(file->seek(get_file_offset(page_id), fs::DirectIoFile::kDirectIoSeekSet));
   CHECK_ERROR_CODE(file->read_raw(sizeof(storage::Page), out));
   ASSERT_ND(reinterpret_cast<storage::Page*>(out)->get_header().page_id_ == page_id);
   return kErrorCodeOk;
@@ -110,10 +110,8 @@ ErrorCode SnapshotFileSet::read_pages(
   void* out) {
   fs::DirectIoFile* file;
   CHECK_ERROR_CODE(get_or_open_file(page_id_begin, &file));
-  storage::SnapshotLocalPageId local_page_id_begin
-    = storage::extract_local_page_id_from_snapshot_pointer(page_id_begin);
   CHECK_ERROR_CODE(
-    file->seek(local_page_id_begin * sizeof(storage::Page), fs::DirectIoFile::kDirectIoSeekSet));
+    file->seek(get_file_offset(page_id_begin), fs::DirectIoFile::kDirectIoSeekSet));
   CHECK_ERROR_CODE(file->read_raw(sizeof(storage::Page) * page_count, out));
 #ifndef NDEBUG
   storage::Page* pages = reinterpret_cast<storage::Page*>(out);
@@ -124,12 +122,33 @@ ErrorCode SnapshotFileSet::read_pages(
   return kErrorCodeOk;
 }
 
+ErrorCode SnapshotFileSet::read_pages_scattered(
+  storage::SnapshotPagePointer page_id_begin,
+  uint32_t page_count,
+  void* const* outs) {
+  fs::DirectIoFile* file;
+  CHECK_ERROR_CODE(get_or_open_file(page_id_begin, &file));
+  CHECK_ERROR_CODE(file->read_raw_scattered(
+    get_file_offset(page_id_begin),
+    page_count,
+    sizeof(storage::Page),
+    outs));
+#ifndef NDEBUG
+  for (uint32_t i = 0; i < page_count; ++i) {
+    const storage::Page* page = reinterpret_cast<const storage::Page*>(outs[i]);
+    ASSERT_ND(page->get_header().page_id_ == page_id_begin + i);
+  }
+#endif  // NDEBUG
+  return kErrorCodeOk;
+}
+
 std::ostream& operator<<(std::ostream& o, const SnapshotFileSet& v) {
   o << "<SnapshotFileSet>";
   for (const auto& snapshot : v.files_) {
     o << "<snapshot id=\"" << snapshot.first << "\">";
     for (const auto& entry : snapshot.second) {
-      o << "<node id=\"" << entry.first
+      o << "<node id=\"" << static_cast<int>(entry.first.first)
+        << "\" shard=\"" << static_cast<int>(entry.first.second)
         << "\" fd=\"" << entry.second->get_descriptor() << "\" />";
     }
     o << "</snapshot>";
@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include "foedus/debugging/latency_histogram.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <ostream>
+
+#include "foedus/assert_nd.hpp"
+
+namespace foedus {
+namespace debugging {
+
+void LatencyHistogram::clear() {
+  count_ = 0;
+  total_nanoseconds_ = 0;
+  std::memset(buckets_, 0, sizeof(buckets_));
+}
+
+uint64_t LatencyHistogram::bucket_lowest_value(uint32_t bucket) {
+  ASSERT_ND(bucket < static_cast<uint32_t>(kBucketCount));
+  if (bucket < static_cast<uint32_t>(kSubBucketCount)) {
+    return bucket;
+  }
+  const uint32_t shift = bucket / kHalfSubBucketCount - 1U;
+  const uint64_t sub_bucket = bucket - shift * kHalfSubBucketCount;
+  return sub_bucket << shift;
+}
+
+uint64_t LatencyHistogram::bucket_highest_value(uint32_t bucket) {
+  ASSERT_ND(bucket < static_cast<uint32_t>(kBucketCount));
+  if (bucket < static_cast<uint32_t>(kSubBucketCount)) {
+    return bucket;
+  }
+  const uint32_t shift = bucket / kHalfSubBucketCount - 1U;
+  return bucket_lowest_value(bucket) + (1ULL << shift) - 1ULL;
+}
+
+uint64_t LatencyHistogram::get_percentile_nanoseconds(double percentile) const {
+  ASSERT_ND(percentile > 0);
+  ASSERT_ND(percentile <= 100.0);
+  if (count_ == 0) {
+    return 0;
+  }
+  uint64_t target = static_cast<uint64_t>(std::ceil(count_ * percentile / 100.0));
+  if (target == 0) {
+    target = 1;
+  } else if (target > count_) {
+    target = count_;
+  }
+  uint64_t cumulative = 0;
+  uint32_t last_nonempty = 0;
+  for (uint32_t i = 0; i < static_cast<uint32_t>(kBucketCount); ++i) {
+    if (buckets_[i] == 0) {
+      continue;
+    }
+    cumulative += buckets_[i];
+    last_nonempty = i;
+    if (cumulative >= target) {
+      return bucket_highest_value(i);
+    }
+  }
+  // count_ and buckets_ can disagree slightly in a racy copy
+  return bucket_highest_value(last_nonempty);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+  count_ += other.count_;
+  total_nanoseconds_ += other.total_nanoseconds_;
+  for (uint32_t i = 0; i < static_cast<uint32_t>(kBucketCount); ++i) {
+    buckets_[i] += other.buckets_[i];
+  }
+}
+
+void LatencyHistogram::subtract(const LatencyHistogram& older) {
+  count_ = 0;
+  for (uint32_t i = 0; i < static_cast<uint32_t>(kBucketCount); ++i) {
+    if (buckets_[i] > older.buckets_[i]) {
+      buckets_[i] -= older.buckets_[i];
+      count_ += buckets_[i];
+    } else {
+      buckets_[i] = 0;
+    }
+  }
+  if (total_nanoseconds_ > older.total_nanoseconds_) {
+    total_nanoseconds_ -= older.total_nanoseconds_;
+  } else {
+    total_nanoseconds_ = 0;
+  }
+}
+
+void LatencyHistogram::write_json(std::ostream* o) const {
+  *o << "{\"count\":" << count_
+    << ",\"mean_us\":" << get_mean_nanoseconds() / 1000.0
+    << ",\"p50_us\":" << get_percentile_nanoseconds(50.0) / 1000.0
+    << ",\"p90_us\":" << get_percentile_nanoseconds(90.0) / 1000.0
+    << ",\"p99_us\":" << get_percentile_nanoseconds(99.0) / 1000.0
+    << ",\"p999_us\":" << get_percentile_nanoseconds(99.9) / 1000.0
+    << ",\"p9999_us\":" << get_percentile_nanoseconds(99.99) / 1000.0
+    << ",\"max_us\":" << get_max_nanoseconds() / 1000.0
+    << "}";
+}
+
+std::ostream& operator<<(std::ostream& o, const LatencyHistogram& v) {
+  o << "<LatencyHistogram>"
+    << "<count>" << v.get_count() << "</count>"
+    << "<mean_us>" << v.get_mean_nanoseconds() / 1000.0 << "</mean_us>"
+    << "<p50_us>" << v.get_percentile_nanoseconds(50.0) / 1000.0 << "</p50_us>"
+    << "<p99_us>" << v.get_percentile_nanoseconds(99.0) / 1000.0 << "</p99_us>"
+    << "<p999_us>" << v.get_percentile_nanoseconds(99.9) / 1000.0 << "</p999_us>"
+    << "<max_us>" << v.get_max_nanoseconds() / 1000.0 << "</max_us>"
+    << "</LatencyHistogram>";
+  return o;
+}
+
+}  // namespace debugging
+}  // namespace foedus
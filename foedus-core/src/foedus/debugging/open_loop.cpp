@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include "foedus/debugging/open_loop.hpp"
+
+#include <time.h>
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+#include "foedus/assert_nd.hpp"
+#include "foedus/engine.hpp"
+#include "foedus/log/log_manager.hpp"
+#include "foedus/xct/xct_manager.hpp"
+
+namespace foedus {
+namespace debugging {
+
+uint64_t get_monotonic_nanoseconds() {
+  // CLOCK_MONOTONIC is system-wide, so forked/spawned workers agree with the driver
+  struct timespec now;
+  ::clock_gettime(CLOCK_MONOTONIC, &now);
+  return static_cast<uint64_t>(now.tv_sec) * 1000000000ULL + now.tv_nsec;
+}
+
+ArrivalSchedule::ArrivalSchedule(Type type, double per_second, uint64_t seed)
+  : type_(type),
+    mean_interval_nanoseconds_(1000000000.0 / per_second),
+    rnd_(seed),
+    next_arrival_(0) {
+  ASSERT_ND(per_second > 0);
+}
+
+uint64_t ArrivalSchedule::pop_arrival() {
+  const uint64_t ret = next_arrival_;
+  double interval;
+  if (type_ == kFixed) {
+    interval = mean_interval_nanoseconds_;
+  } else {
+    // inverse transform sampling. (0, 1] so that log() is finite
+    const double uniform = (static_cast<double>(rnd_.next_uint32()) + 1.0) / 4294967296.0;
+    interval = -std::log(uniform) * mean_interval_nanoseconds_;
+  }
+  next_arrival_ += static_cast<uint64_t>(interval);
+  return ret;
+}
+
+DurableLatencyRecorder::DurableLatencyRecorder(
+  Engine* engine,
+  LatencyHistogram* histograms,
+  uint32_t max_pending)
+  : engine_(engine),
+    histograms_(histograms),
+    pending_(max_pending),
+    pending_head_(0),
+    pending_count_(0) {
+  ASSERT_ND(max_pending > 0);
+}
+
+void DurableLatencyRecorder::on_commit(uint16_t type, uint64_t intended_start, Epoch commit_epoch) {
+  if (!commit_epoch.is_valid()) {
+    uint64_t now = get_monotonic_nanoseconds();
+    histograms_[type].record(now > intended_start ? now - intended_start : 0);
+    return;
+  }
+  if (pending_count_ == pending_.size()) {
+    // the logger is far behind. this wait is part of the latency of the pending transactions.
+    ErrorCode ret = engine_->get_xct_manager()->wait_for_commit(
+      pending_[pending_head_].commit_epoch_);
+    if (ret != kErrorCodeOk) {
+      LOG(WARNING) << "wait_for_commit failed: " << get_error_name(ret);
+    }
+    complete_durable();
+  }
+  ASSERT_ND(pending_count_ < pending_.size());
+  Pending& entry = pending_[(pending_head_ + pending_count_) % pending_.size()];
+  entry.intended_start_ = intended_start;
+  entry.commit_epoch_ = commit_epoch;
+  entry.type_ = type;
+  ++pending_count_;
+}
+
+void DurableLatencyRecorder::pop_front(uint64_t now) {
+  ASSERT_ND(pending_count_ > 0);
+  const Pending& entry = pending_[pending_head_];
+  histograms_[entry.type_].record(now > entry.intended_start_ ? now - entry.intended_start_ : 0);
+  pending_head_ = (pending_head_ + 1U) % pending_.size();
+  --pending_count_;
+}
+
+void DurableLatencyRecorder::complete_durable() {
+  if (pending_count_ == 0) {
+    return;
+  }
+  const Epoch durable = engine_->get_log_manager()->get_durable_global_epoch_weak();
+  const uint64_t now = get_monotonic_nanoseconds();
+  // FIFO, like responses sent on one connection
+  while (pending_count_ > 0 && pending_[pending_head_].commit_epoch_ <= durable) {
+    pop_front(now);
+  }
+}
+
+void DurableLatencyRecorder::complete_all() {
+  while (pending_count_ > 0) {
+    ErrorCode ret = engine_->get_xct_manager()->wait_for_commit(
+      pending_[pending_head_].commit_epoch_);
+    if (ret != kErrorCodeOk) {
+      LOG(WARNING) << "wait_for_commit failed: " << get_error_name(ret);
+      return;
+    }
+    complete_durable();
+  }
+}
+
+void DurableLatencyRecorder::wait_until(
+  uint64_t until_nanoseconds,
+  const std::atomic<bool>* stop_requested) {
+  const uint64_t kSpinThreshold = 200000ULL;
+  const uint64_t kMaxSleep = 1000000ULL;
+  while (!stop_requested->load(std::memory_order_acquire)) {
+    complete_durable();
+    const uint64_t now = get_monotonic_nanoseconds();
+    if (now >= until_nanoseconds) {
+      break;
+    }
+    // sleep_for() oversleeps by tens of microseconds. spin near the deadline.
+    const uint64_t remaining = until_nanoseconds - now;
+    if (remaining > kSpinThreshold) {
+      const uint64_t sleep = std::min<uint64_t>(remaining - kSpinThreshold / 2U, kMaxSleep);
+      std::this_thread::sleep_for(std::chrono::nanoseconds(sleep));
+    }
+  }
+}
+
+}  // namespace debugging
+}  // namespace foedus
@@ -33,6 +33,7 @@
 #include "foedus/memory/numa_core_memory.hpp"
 #include "foedus/memory/page_pool.hpp"
 #include "foedus/soc/shared_memory_repo.hpp"
+#include "foedus/thread/coroutine_impl.hpp"
 
 namespace foedus {
 EngineOptions::EngineOptions() {
@@ -369,6 +370,13 @@ void EngineOptions::calculate_required_memory(
   // core-local memories in NumaCoreMemory. work_memory and "small_memory" (terrible name, yes)
   *local_bytes += xct_.local_work_memory_size_mb_ * (1ULL << 20) * total_threads;
   *local_bytes += memory::NumaCoreMemory::calculate_local_small_memory_size(*this) * total_threads;
+  // read/write-sets and lock lists. only the resident part. the rest is just reserved.
+  *local_bytes += memory::NumaCoreMemory::calculate_xct_access_memory_size(*this, 1U)
+    * total_threads;
+
+  // coroutines in each thread, if enabled
+  *local_bytes += thread::CoroutineScheduler::calculate_memory_size_per_coroutine(*this)
+    * thread_.coroutines_per_thread_ * total_threads;
 }
 
 
@@ -19,7 +19,9 @@
 
 #include <fcntl.h>
 #include <glog/logging.h>
+#include <sys/uio.h>
 
+#include <algorithm>
 #include <ostream>
 #include <sstream>
 #include <string>
@@ -213,6 +215,64 @@ ErrorCode  DirectIoFile::read_raw(uint64_t desired_bytes, void* buffer) {
   return kErrorCodeOk;
 }
 
+ErrorCode  DirectIoFile::read_raw_scattered(
+  uint64_t file_offset,
+  uint32_t buffer_count,
+  uint64_t bytes_per_buffer,
+  void* const* buffers) {
+  ASSERT_ND(!emulation_.null_device_);
+  if (!is_opened()) {
+    LOG(ERROR) << "File not opened yet, or closed. this=" << *this;
+    return kErrorCodeFsNotOpened;
+  } else if (buffer_count == 0 || bytes_per_buffer == 0) {
+    return kErrorCodeOk;
+  }
+
+  // we issue preadv() for up to this many buffers at a time.
+  const uint32_t kMaxIov = 64;
+  struct iovec iov[kMaxIov];
+  uint32_t done_buffers = 0;
+  uint64_t done_bytes_in_buffer = 0;  // in case the previous preadv() ended in the middle
+  while (done_buffers < buffer_count) {
+    uint32_t count = std::min<uint32_t>(kMaxIov, buffer_count - done_buffers);
+    uint64_t requested = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+      char* base = reinterpret_cast<char*>(buffers[done_buffers + i]);
+      uint64_t skip = (i == 0 ? done_bytes_in_buffer : 0);
+      ASSERT_ND(is_odirect_aligned(base + skip));
+      iov[i].iov_base = base + skip;
+      iov[i].iov_len = bytes_per_buffer - skip;
+      requested += iov[i].iov_len;
+    }
+    uint64_t position = file_offset + done_buffers * bytes_per_buffer + done_bytes_in_buffer;
+    ssize_t read_bytes = ::preadv(descriptor_, iov, count, position);
+    if (read_bytes <= 0) {
+      LOG(ERROR) << "DirectIoFile::read_raw_scattered(): error. this=" << *this
+        << ", file_offset=" << file_offset << ", buffer_count=" << buffer_count
+        << ", done_buffers=" << done_buffers << ", read_bytes=" << read_bytes
+        << ", err=" << assorted::os_error();
+      return kErrorCodeFsTooShortRead;
+    } else if (static_cast<uint64_t>(read_bytes) > requested) {
+      LOG(ERROR) << "DirectIoFile::read_raw_scattered(): wtf? this=" << *this
+        << ", requested=" << requested << ", read_bytes=" << read_bytes;
+      return kErrorCodeFsExcessRead;
+    } else if (!emulation_.disable_direct_io_ && !is_odirect_aligned(read_bytes)) {
+      LOG(FATAL) << "DirectIoFile::read_raw_scattered(): wtf2? this=" << *this
+        << ", requested=" << requested << ", read_bytes=" << read_bytes;
+      return kErrorCodeFsResultNotAligned;
+    }
+
+    uint64_t consumed = done_bytes_in_buffer + read_bytes;
+    done_buffers += consumed / bytes_per_buffer;
+    done_bytes_in_buffer = consumed % bytes_per_buffer;
+  }
+  if (emulation_.emulated_read_kb_cycles_ > 0) {
+    debugging::wait_rdtsc_cycles(
+      emulation_.emulated_read_kb_cycles_ * ((buffer_count * bytes_per_buffer) >> 10));
+  }
+  return kErrorCodeOk;
+}
+
 ErrorCode  DirectIoFile::write(uint64_t desired_bytes, const memory::AlignedMemory& buffer) {
   return write(desired_bytes, memory::AlignedMemorySlice(
     const_cast<memory::AlignedMemory*>(&buffer)));
@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include "foedus/log/change_stream.hpp"
+
+#include <algorithm>
+#include <ostream>
+#include <vector>
+
+#include "foedus/log/change_stream_pimpl.hpp"
+#include "foedus/log/log_type_invoke.hpp"
+
+namespace foedus {
+namespace log {
+ChangeStream::ChangeStream(Engine* engine, Epoch start_after) : pimpl_(nullptr) {
+  pimpl_ = new ChangeStreamPimpl(engine, start_after);
+}
+ChangeStream::~ChangeStream() {
+  delete pimpl_;
+  pimpl_ = nullptr;
+}
+
+void ChangeStream::subscribe(storage::StorageId storage_id) {
+  std::vector<storage::StorageId>& subscriptions = pimpl_->subscriptions_;
+  auto it = std::lower_bound(subscriptions.begin(), subscriptions.end(), storage_id);
+  if (it == subscriptions.end() || *it != storage_id) {
+    subscriptions.insert(it, storage_id);
+  }
+}
+void ChangeStream::set_max_batch_epochs(uint32_t epochs) {
+  pimpl_->max_batch_epochs_ = std::max<uint32_t>(epochs, 1U);
+}
+void ChangeStream::set_max_batch_bytes(uint64_t bytes) { pimpl_->max_batch_bytes_ = bytes; }
+
+ErrorStack ChangeStream::fetch(ChangeBatch* batch, int64_t wait_microseconds) {
+  return pimpl_->fetch(batch, wait_microseconds);
+}
+Epoch ChangeStream::get_consumed_epoch() const { return pimpl_->consumed_epoch_; }
+
+std::ostream& operator<<(std::ostream& o, const ChangeRecord& v) {
+  o << "<ChangeRecord logger=\"" << v.logger_id_ << "\">";
+  invoke_ostream(v.log_, &o);
+  o << "</ChangeRecord>";
+  return o;
+}
+
+}  // namespace log
+}  // namespace foedus
@@ -0,0 +1,255 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include "foedus/log/change_stream_pimpl.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <string>
+#include <vector>
+
+#include "foedus/assert_nd.hpp"
+#include "foedus/engine.hpp"
+#include "foedus/engine_options.hpp"
+#include "foedus/fs/filesystem.hpp"
+#include "foedus/fs/path.hpp"
+#include "foedus/log/common_log_types.hpp"
+#include "foedus/log/log_manager.hpp"
+#include "foedus/log/log_type.hpp"
+#include "foedus/log/logger_ref.hpp"
+#include "foedus/log/striped_log_file.hpp"
+
+namespace foedus {
+namespace log {
+namespace {
+void close_all(std::vector<int>* descriptors) {
+  for (int descriptor : *descriptors) {
+    ::close(descriptor);
+  }
+  descriptors->clear();
+}
+
+/** pread() on the log file, which might be striped. Returns the bytes read or -1. */
+::ssize_t read_striped(
+  const std::vector<int>& descriptors,
+  const LogStripeLayout& layout,
+  uint64_t offset,
+  uint64_t bytes,
+  char* buffer) {
+  uint64_t total = 0;
+  while (total < bytes) {
+    const uint64_t in_unit = offset % layout.unit_size_;
+    const uint64_t segment = std::min<uint64_t>(bytes - total, layout.unit_size_ - in_unit);
+    ::ssize_t read_bytes = ::pread(
+      descriptors[layout.to_stripe(offset)],
+      buffer + total,
+      segment,
+      layout.to_stripe_offset(offset));
+    if (read_bytes < 0) {
+      return total > 0 ? total : -1;
+    }
+    total += read_bytes;
+    offset += read_bytes;
+    if (static_cast<uint64_t>(read_bytes) < segment) {
+      break;  // end of the file
+    }
+  }
+  return total;
+}
+}  // namespace
+
+ChangeStreamPimpl::ChangeStreamPimpl(Engine* engine, Epoch start_after)
+  : engine_(engine),
+    max_batch_epochs_(kDefaultMaxBatchEpochs),
+    max_batch_bytes_(kDefaultMaxBatchBytes),
+    consumed_epoch_(start_after) {
+  if (!consumed_epoch_.is_valid()) {
+    consumed_epoch_ = engine_->get_log_manager()->get_durable_global_epoch();
+  }
+}
+
+bool ChangeStreamPimpl::is_subscribed(storage::StorageId storage_id) const {
+  return subscriptions_.empty()
+    || std::binary_search(subscriptions_.begin(), subscriptions_.end(), storage_id);
+}
+
+ErrorStack ChangeStreamPimpl::fetch(ChangeBatch* batch, int64_t wait_microseconds) {
+  batch->data_.clear();
+  batch->records_.clear();
+  batch->from_epoch_ = consumed_epoch_;
+  batch->until_epoch_ = consumed_epoch_;
+  pending_.clear();
+
+  LogManager* log_manager = engine_->get_log_manager();
+  Epoch durable_epoch = log_manager->get_durable_global_epoch();
+  if (!durable_epoch.is_valid() || durable_epoch <= consumed_epoch_) {
+    ErrorCode code = log_manager->wait_until_durable(consumed_epoch_.one_more(), wait_microseconds);
+    if (code == kErrorCodeTimeout) {
+      return kRetOk;
+    }
+    WRAP_ERROR_CODE(code);
+    durable_epoch = log_manager->get_durable_global_epoch();
+  }
+
+  // Whole epochs only, so that a consumer never sees a part of an epoch.
+  const uint32_t logger_count = engine_->get_options().log_.loggers_per_node_
+    * engine_->get_options().thread_.group_count_;
+  Epoch epoch = consumed_epoch_;
+  for (uint32_t i = 0; i < max_batch_epochs_ && epoch < durable_epoch; ++i) {
+    ++epoch;
+    for (LoggerId logger_id = 0; logger_id < logger_count; ++logger_id) {
+      CHECK_ERROR(read_epoch(logger_id, epoch, batch));
+    }
+    batch->until_epoch_ = epoch;
+    if (batch->get_bytes() >= max_batch_bytes_) {
+      break;
+    }
+  }
+  consumed_epoch_ = batch->until_epoch_;
+  finalize_batch(batch);
+  DVLOG(1) << "ChangeStream fetched " << batch->get_record_count() << " records in epochs ("
+    << batch->from_epoch_ << ", " << batch->until_epoch_ << "]";
+  return kRetOk;
+}
+
+ErrorStack ChangeStreamPimpl::read_epoch(LoggerId logger_id, Epoch epoch, ChangeBatch* batch) {
+  LoggerRef logger = engine_->get_log_manager()->get_logger(logger_id);
+  const LogRange range = logger.get_log_range(epoch.one_less(), epoch);
+  if (range.is_empty()) {
+    return kRetOk;
+  }
+  const LogOptions& options = engine_->get_options().log_;
+  const int node = logger_id / options.loggers_per_node_;
+  for (LogFileOrdinal ordinal = range.begin_file_ordinal;
+        ordinal <= range.end_file_ordinal;
+        ++ordinal) {
+    uint64_t begin_offset = 0;
+    if (ordinal == range.begin_file_ordinal) {
+      begin_offset = range.begin_offset;
+    }
+    uint64_t end_offset;
+    if (ordinal == range.end_file_ordinal) {
+      end_offset = range.end_offset;
+    } else {
+      end_offset = StripedLogFile::get_file_size(options, node, logger_id, ordinal);
+    }
+    CHECK_ERROR(read_file_range(logger_id, ordinal, begin_offset, end_offset, batch));
+  }
+  return kRetOk;
+}
+
+ErrorStack ChangeStreamPimpl::read_file_range(
+  LoggerId logger_id,
+  LogFileOrdinal ordinal,
+  uint64_t begin_offset,
+  uint64_t end_offset,
+  ChangeBatch* batch) {
+  if (begin_offset >= end_offset) {
+    return kRetOk;
+  }
+  const LogOptions& options = engine_->get_options().log_;
+  const int node = logger_id / options.loggers_per_node_;
+  fs::Path path(options.construct_suffixed_log_path(node, logger_id, ordinal));
+  // The region is durable, hence never modified. Plain buffered reads suffice.
+  // If the log file is striped, we open all stripes and read each stripe unit from its stripe.
+  const LogStripeLayout layout(options);
+  std::vector<int> descriptors;
+  for (uint16_t stripe = 0; stripe < layout.stripes_; ++stripe) {
+    fs::Path stripe_path(options.construct_suffixed_log_path(node, logger_id, ordinal, stripe));
+    int descriptor = ::open(stripe_path.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+      LOG(ERROR) << "ChangeStream: failed to open " << stripe_path << ". errno=" << errno;
+      close_all(&descriptors);
+      return ERROR_STACK_MSG(kErrorCodeFsFailedToOpen, stripe_path.c_str());
+    }
+    descriptors.push_back(descriptor);
+  }
+  if (read_buffer_.empty()) {
+    read_buffer_.resize(kReadBufferSize);
+  }
+  ErrorCode result = kErrorCodeOk;
+  uint64_t cur = begin_offset;
+  while (cur < end_offset) {
+    const uint64_t desired = std::min<uint64_t>(end_offset - cur, read_buffer_.size());
+    ::ssize_t read_bytes = read_striped(descriptors, layout, cur, desired, &read_buffer_[0]);
+    if (read_bytes <= 0) {
+      LOG(ERROR) << "ChangeStream: " << path << " is shorter than " << end_offset;
+      result = kErrorCodeFsTooShortRead;
+      break;
+    }
+    // consume complete log entries in the buffer. a partial one at the end is read again.
+    uint64_t pos = 0;
+    while (pos + sizeof(LogHeader) <= static_cast<uint64_t>(read_bytes)) {
+      const LogHeader* header = reinterpret_cast<const LogHeader*>(&read_buffer_[pos]);
+      if (UNLIKELY(header->log_length_ == 0 || header->log_length_ % sizeof(uint64_t) != 0)) {
+        LOG(ERROR) << "ChangeStream: invalid log entry at " << (cur + pos) << " in " << path
+          << ". log header=" << *header;
+        result = kErrorCodeSnapshotInvalidLogEnd;
+        break;
+      }
+      if (pos + header->log_length_ > static_cast<uint64_t>(read_bytes)) {
+        break;
+      }
+      if (header->get_kind() == kRecordLogs && is_subscribed(header->storage_id_)) {
+        const uint64_t* words = reinterpret_cast<const uint64_t*>(header);
+        pending_.emplace_back(batch->data_.size(), logger_id);
+        batch->data_.insert(
+          batch->data_.end(),
+          words,
+          words + header->log_length_ / sizeof(uint64_t));
+      }
+      pos += header->log_length_;
+    }
+    if (result != kErrorCodeOk) {
+      break;
+    }
+    ASSERT_ND(pos > 0);  // the buffer is larger than any log entry
+    cur += pos;
+  }
+  close_all(&descriptors);
+  if (result != kErrorCodeOk) {
+    return ERROR_STACK_MSG(result, path.c_str());
+  }
+  return kRetOk;
+}
+
+void ChangeStreamPimpl::finalize_batch(ChangeBatch* batch) {
+  // data_ does not grow any more, so the pointers are now stable.
+  batch->records_.reserve(pending_.size());
+  for (const auto& pending : pending_) {
+    ChangeRecord record;
+    record.log_ = reinterpret_cast<const RecordLogType*>(&batch->data_[pending.first]);
+    record.logger_id_ = pending.second;
+    batch->records_.push_back(record);
+  }
+  pending_.clear();
+  // Each logger wrote its transactions in serialization order, and logs of one transaction
+  // are contiguous in one logger. A stable sort merges them keeping the order within xcts.
+  std::stable_sort(
+    batch->records_.begin(),
+    batch->records_.end(),
+    [](const ChangeRecord& left, const ChangeRecord& right) {
+      return left.get_xct_id().before(right.get_xct_id());
+    });
+}
+
+}  // namespace log
+}  // namespace foedus
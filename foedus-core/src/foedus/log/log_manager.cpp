@@ -57,6 +57,11 @@ ErrorStack LogManager::refresh_global_durable_epoch() {
 void LogManager::copy_logger_states(savepoint::Savepoint* new_savepoint) {
   pimpl_->copy_logger_states(new_savepoint);
 }
+void LogManager::copy_logger_snapshot_positions(
+  Epoch snapshot_epoch,
+  savepoint::Savepoint* new_savepoint) {
+  pimpl_->copy_logger_snapshot_positions(snapshot_epoch, new_savepoint);
+}
 
 MetaLogBuffer* LogManager::get_meta_buffer() {
   return &pimpl_->meta_buffer_;
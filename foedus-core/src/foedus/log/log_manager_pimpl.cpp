@@ -30,6 +30,7 @@
 #include "foedus/assorted/atomic_fences.hpp"
 #include "foedus/fs/filesystem.hpp"
 #include "foedus/fs/path.hpp"
+#include "foedus/log/common_log_types.hpp"
 #include "foedus/log/log_id.hpp"
 #include "foedus/log/log_options.hpp"
 #include "foedus/log/logger_impl.hpp"
@@ -62,6 +63,15 @@ ErrorStack LogManagerPimpl::initialize_once() {
     || total_loggers > total_threads) {
     return ERROR_STACK(kErrorCodeLogInvalidLoggerCount);
   }
+  const LogOptions& log_options = engine_->get_options().log_;
+  if (log_options.log_stripes_ == 0
+    || log_options.log_stripe_unit_kb_ == 0
+    || log_options.log_stripe_unit_kb_ % (FillerLogType::kLogWriteUnitSize >> 10) != 0) {
+    return ERROR_STACK_MSG(kErrorCodeInvalidParameter, "invalid log_stripes_/log_stripe_unit_kb_");
+  }
+  if (log_options.log_stripes_ > 1U && log_options.sink_type_ != LogOptions::kLogSinkDirectIo) {
+    return ERROR_STACK_MSG(kErrorCodeInvalidParameter, "log striping needs kLogSinkDirectIo");
+  }
 
   // attach control block
   soc::SharedMemoryRepo* memory_repo = engine_->get_soc_manager()->get_shared_memory_repo();
@@ -109,10 +119,12 @@ ErrorStack LogManagerPimpl::initialize_once() {
         current_ordinal++;
       }
       std::string folder = engine_->get_options().log_.convert_folder_path_pattern(node, j);
-      // to avoid race, create the root log folder now.
-      fs::Path path(folder);
-      if (!fs::exists(path)) {
-        fs::create_directories(path);
+      // to avoid race, create the root log folder (of each stripe) now.
+      for (uint16_t stripe = 0; stripe < log_options.log_stripes_; ++stripe) {
+        fs::Path path(log_options.convert_folder_path_pattern(node, j, stripe));
+        if (!fs::exists(path)) {
+          fs::create_directories(path);
+        }
       }
       Logger* logger = new Logger(
         engine_,
@@ -283,5 +295,15 @@ void LogManagerPimpl::copy_logger_states(savepoint::Savepoint* new_savepoint) {
   }
 }
 
+void LogManagerPimpl::copy_logger_snapshot_positions(
+  Epoch snapshot_epoch,
+  savepoint::Savepoint* new_savepoint) {
+  new_savepoint->snapshot_log_files_.clear();
+  new_savepoint->snapshot_log_files_offset_.clear();
+  for (const LoggerRef& logger : logger_refs_) {
+    logger.copy_logger_snapshot_position(snapshot_epoch, new_savepoint);
+  }
+}
+
 }  // namespace log
 }  // namespace foedus
@@ -27,24 +27,35 @@ namespace foedus {
 namespace log {
 LogOptions::LogOptions() {
   loggers_per_node_ = 1;
+  dynamic_logger_assignment_ = false;
   folder_path_pattern_ = "logs/node_$NODE$/logger_$LOGGER$";
   log_buffer_kb_ = kDefaultLogBufferKb;
   log_file_size_mb_ = kDefaultLogSizeMb;
+  log_stripes_ = 1;
+  log_stripe_unit_kb_ = kDefaultLogStripeUnitKb;
   flush_at_shutdown_ = true;
+  sink_type_ = kLogSinkDirectIo;
+  mmap_sink_map_sync_ = false;
 }
 
-std::string LogOptions::convert_folder_path_pattern(int node, int logger) const {
+std::string LogOptions::convert_folder_path_pattern(int node, int logger, int stripe) const {
   std::string tmp = assorted::replace_all(folder_path_pattern_.str(), "$NODE$", node);
+  tmp = assorted::replace_all(tmp, "$STRIPE$", stripe);
   return assorted::replace_all(tmp, "$LOGGER$", logger);
 }
 
 std::string LogOptions::construct_suffixed_log_path(
   int node,
   int logger,
-  LogFileOrdinal ordinal) const {
-  std::string folder = convert_folder_path_pattern(node, logger);
+  LogFileOrdinal ordinal,
+  int stripe) const {
+  std::string folder = convert_folder_path_pattern(node, logger, stripe);
   std::stringstream path_str;
-  path_str << folder << "/" << logger << "_" << ordinal << ".log";
+  path_str << folder << "/" << logger << "_" << ordinal;
+  if (stripe > 0) {
+    path_str << "_" << stripe;
+  }
+  path_str << ".log";
   return path_str.str();
 }
 
@@ -55,9 +66,14 @@ std::string LogOptions::construct_meta_log_path() const {
 ErrorStack LogOptions::load(tinyxml2::XMLElement* element) {
   EXTERNALIZE_LOAD_ELEMENT(element, folder_path_pattern_);
   EXTERNALIZE_LOAD_ELEMENT(element, loggers_per_node_);
+  EXTERNALIZE_LOAD_ELEMENT(element, dynamic_logger_assignment_);
   EXTERNALIZE_LOAD_ELEMENT(element, log_buffer_kb_);
   EXTERNALIZE_LOAD_ELEMENT(element, log_file_size_mb_);
+  EXTERNALIZE_LOAD_ELEMENT(element, log_stripes_);
+  EXTERNALIZE_LOAD_ELEMENT(element, log_stripe_unit_kb_);
   EXTERNALIZE_LOAD_ELEMENT(element, flush_at_shutdown_);
+  EXTERNALIZE_LOAD_ENUM_ELEMENT(element, sink_type_);
+  EXTERNALIZE_LOAD_ELEMENT(element, mmap_sink_map_sync_);
   CHECK_ERROR(get_child_element(element, "LogDeviceEmulationOptions", &emulation_))
   return kRetOk;
 }
@@ -68,9 +84,10 @@ ErrorStack LogOptions::save(tinyxml2::XMLElement* element) const {
   EXTERNALIZE_SAVE_ELEMENT(element, folder_path_pattern_,
     "String pattern of path of log folders in each NUMA node.\n"
     " This specifies the path of the folder to contain log file written out in each NUMA node."
-    " Two special placeholders can be used; $NODE$ and $LOGGER$."
+    " Three special placeholders can be used; $NODE$, $LOGGER$, and $STRIPE$."
     " $NODE$ is replaced with the NUMA node number."
     " $LOGGER$ is replaced with the logger index in the node (0 to loggers_per_node_ - 1)."
+    " $STRIPE$ is replaced with the stripe index (0 to log_stripes_ - 1)."
     " For example,\n"
     " /log/node_$NODE$/logger_$LOGGER$ becomes /log/node_1/logger_0 on node-1 and logger-0."
     " /log/logger_$INDEX$ becomes /log/logger_1 on any node and logger-1."
@@ -83,10 +100,26 @@ ErrorStack LogOptions::save(tinyxml2::XMLElement* element) const {
     " A larger value might be able to employ more CPU power if you have succient # of cores."
     " For the best performance, the number of loggers in each NUMA node must be"
     " a submultiple of the number of cores in the node (s.t. logger assignment is balanced).");
+  EXTERNALIZE_SAVE_ELEMENT(element, dynamic_logger_assignment_,
+    "Whether loggers in a NUMA node share the work of writing out logs of the node."
+    " If true, each logger writes out its own threads' logs first, then claims the logs of"
+    " other threads in the node that no logger has claimed yet in the epoch.");
   EXTERNALIZE_SAVE_ELEMENT(element, log_buffer_kb_, "Buffer size in KB of each worker thread");
   EXTERNALIZE_SAVE_ELEMENT(element, log_file_size_mb_, "Size in MB of files loggers write out");
+  EXTERNALIZE_SAVE_ELEMENT(element, log_stripes_,
+    "Number of devices each logger stripes its log files across, like RAID-0."
+    " 1 (default) means no striping. Specify $STRIPE$ in folder_path_pattern_ to place the"
+    " stripes on different devices. Supported only with the direct I/O sink.");
+  EXTERNALIZE_SAVE_ELEMENT(element, log_stripe_unit_kb_,
+    "Size in KB of each stripe unit when log_stripes_ > 1. Must be a multiple of 4.");
   EXTERNALIZE_SAVE_ELEMENT(element, flush_at_shutdown_,
       "Whether to flush transaction logs and take savepoint when uninitialize() is called");
+  EXTERNALIZE_SAVE_ENUM_ELEMENT(element, sink_type_,
+      "Type of log sink loggers write out to. 0: direct I/O and fsync (default),"
+      " 1: memory-mapped log files with non-temporal stores, meant for persistent memory.");
+  EXTERNALIZE_SAVE_ELEMENT(element, mmap_sink_map_sync_,
+      "Whether the memory-mapped log sink maps log files with MAP_SYNC (DAX filesystems only)."
+      " If the filesystem doesn't support it, we fall back to msync().");
   CHECK_ERROR(add_child_element(element, "LogDeviceEmulationOptions",
           "[Experiments-only] Settings to emulate slower logging device", emulation_));
   return kRetOk;
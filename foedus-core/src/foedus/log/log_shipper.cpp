@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include "foedus/log/log_shipper.hpp"
+
+#include "foedus/engine.hpp"
+#include "foedus/log/log_manager.hpp"
+#include "foedus/log/log_shipper_pimpl.hpp"
+
+namespace foedus {
+namespace log {
+LogShipper::LogShipper(Engine* primary, const EngineOptions& standby_options) : pimpl_(nullptr) {
+  pimpl_ = new LogShipperPimpl(primary, standby_options);
+}
+LogShipper::~LogShipper() {
+  delete pimpl_;
+  pimpl_ = nullptr;
+}
+
+ErrorStack  LogShipper::ship_once() { return pimpl_->ship_once(); }
+void        LogShipper::start(uint32_t interval_ms) { pimpl_->start(interval_ms); }
+ErrorStack  LogShipper::stop() { return pimpl_->stop(); }
+bool        LogShipper::is_running() const { return pimpl_->shipper_thread_.joinable(); }
+
+Epoch       LogShipper::get_shipped_epoch() const { return Epoch(pimpl_->shipped_epoch_); }
+uint32_t    LogShipper::get_lag_epochs() const {
+  Epoch durable = pimpl_->primary_->get_log_manager()->get_durable_global_epoch();
+  Epoch shipped = get_shipped_epoch();
+  if (!durable.is_valid() || (shipped.is_valid() && shipped >= durable)) {
+    return 0;
+  }
+  return durable.subtract(shipped);
+}
+uint64_t    LogShipper::get_shipped_bytes() const { return pimpl_->shipped_bytes_; }
+
+}  // namespace log
+}  // namespace foedus
@@ -0,0 +1,290 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include "foedus/log/log_shipper_pimpl.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <glog/logging.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <string>
+
+#include "foedus/assert_nd.hpp"
+#include "foedus/engine.hpp"
+#include "foedus/error_stack_batch.hpp"
+#include "foedus/fs/filesystem.hpp"
+#include "foedus/fs/path.hpp"
+#include "foedus/log/log_manager.hpp"
+#include "foedus/log/striped_log_file.hpp"
+#include "foedus/savepoint/savepoint.hpp"
+#include "foedus/snapshot/snapshot_options.hpp"
+#include "foedus/storage/storage_id.hpp"
+
+namespace foedus {
+namespace log {
+
+LogShipperPimpl::LogShipperPimpl(Engine* primary, const EngineOptions& standby_options)
+  : primary_(primary),
+    standby_options_(standby_options),
+    shipped_snapshot_id_(snapshot::kNullSnapshotId),
+    shipped_epoch_(Epoch::kEpochInvalid),
+    shipped_bytes_(0),
+    stop_requested_(false) {
+}
+
+LogShipperPimpl::~LogShipperPimpl() {
+  if (shipper_thread_.joinable()) {
+    ErrorStack result = stop();
+    if (result.is_error()) {
+      LOG(ERROR) << "LogShipper had an error: " << result;
+    }
+  }
+}
+
+void LogShipperPimpl::start(uint32_t interval_ms) {
+  ASSERT_ND(!shipper_thread_.joinable());
+  stop_requested_ = false;
+  shipper_error_ = kRetOk;
+  shipper_thread_ = std::move(std::thread(&LogShipperPimpl::handle_shipper, this, interval_ms));
+}
+
+ErrorStack LogShipperPimpl::stop() {
+  if (shipper_thread_.joinable()) {
+    stop_requested_ = true;
+    shipper_thread_.join();
+  }
+  ErrorStack result = shipper_error_;
+  shipper_error_ = kRetOk;
+  return result;
+}
+
+void LogShipperPimpl::handle_shipper(uint32_t interval_ms) {
+  LOG(INFO) << "LogShipper started. interval=" << interval_ms << "ms";
+  while (true) {
+    // one last round after the stop request, so that stop() leaves the latest image
+    const bool last_round = stop_requested_;
+    ErrorStack result = ship_once();
+    if (result.is_error()) {
+      LOG(ERROR) << "LogShipper failed to ship. will retry in the next round: " << result;
+      if (!shipper_error_.is_error()) {
+        shipper_error_ = result;
+      }
+    }
+    if (last_round) {
+      break;
+    }
+    const auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(interval_ms);
+    while (!stop_requested_ && std::chrono::steady_clock::now() < until) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(std::min<uint32_t>(interval_ms, 10)));
+    }
+  }
+  LOG(INFO) << "LogShipper stopped. shipped_epoch=" << Epoch(shipped_epoch_)
+    << ", shipped_bytes=" << shipped_bytes_;
+}
+
+ErrorStack LogShipperPimpl::ship_once() {
+  std::lock_guard<std::mutex> guard(ship_mutex_);
+  // The savepoint file is atomically written after everything it refers to becomes durable.
+  // Thus, shipping exactly what it refers to gives a consistent image.
+  const EngineOptions& primary_options = primary_->get_options();
+  if (primary_options.thread_.group_count_ != standby_options_.thread_.group_count_
+    || primary_options.log_.loggers_per_node_ != standby_options_.log_.loggers_per_node_) {
+    return ERROR_STACK_MSG(kErrorCodeInvalidParameter,
+      "The standby must have the same number of nodes and loggers as the primary");
+  }
+  if (primary_options.log_.log_stripes_ != standby_options_.log_.log_stripes_
+    || primary_options.log_.log_stripe_unit_kb_ != standby_options_.log_.log_stripe_unit_kb_) {
+    return ERROR_STACK_MSG(kErrorCodeInvalidParameter,
+      "The standby must stripe log files in the same way as the primary");
+  }
+  fs::Path primary_savepoint_path(primary_options.savepoint_.savepoint_path_.str());
+  savepoint::Savepoint savepoint;
+  CHECK_ERROR(savepoint.load_from_file(primary_savepoint_path));
+  const uint32_t logger_count
+    = standby_options_.thread_.group_count_ * standby_options_.log_.loggers_per_node_;
+  ASSERT_ND(savepoint.consistent(logger_count));
+  if (Epoch(shipped_epoch_) == savepoint.get_durable_epoch()
+    && shipped_snapshot_id_ == savepoint.latest_snapshot_id_) {
+    return kRetOk;  // nothing new
+  }
+
+  CHECK_ERROR(ship_snapshots(savepoint));
+  CHECK_ERROR(ship_file(
+    fs::Path(primary_->get_options().log_.construct_meta_log_path()),
+    fs::Path(standby_options_.log_.construct_meta_log_path()),
+    savepoint.meta_log_durable_offset_));
+  CHECK_ERROR(ship_logs(savepoint));
+
+  // at last, the savepoint. until this, the standby's image stays at the previous round
+  fs::Path standby_savepoint_path(standby_options_.savepoint_.savepoint_path_.str());
+  fs::create_directories(standby_savepoint_path.parent_path(), true);
+  CHECK_ERROR(savepoint.save_to_file(standby_savepoint_path));
+  shipped_epoch_ = savepoint.durable_epoch_;
+  VLOG(0) << "LogShipper shipped upto epoch-" << savepoint.get_durable_epoch()
+    << ", snapshot-" << savepoint.latest_snapshot_id_ << ". total bytes=" << shipped_bytes_;
+  return kRetOk;
+}
+
+ErrorStack LogShipperPimpl::ship_logs(const savepoint::Savepoint& savepoint) {
+  const LogOptions& primary_log = primary_->get_options().log_;
+  const LogOptions& standby_log = standby_options_.log_;
+  const LogStripeLayout layout(primary_log);
+  const uint32_t logger_count = savepoint.current_log_files_.size();
+  for (uint32_t id = 0; id < logger_count; ++id) {
+    const int node = id / standby_log.loggers_per_node_;
+    const LogFileOrdinal current = savepoint.current_log_files_[id];
+    for (LogFileOrdinal ordinal = savepoint.oldest_log_files_[id]; ordinal <= current; ++ordinal) {
+      // older files are closed and never change. the current file is durable upto the offset.
+      uint64_t length;
+      if (ordinal == current) {
+        length = savepoint.current_log_files_offset_durable_[id];
+      } else {
+        length = StripedLogFile::get_file_size(primary_log, node, id, ordinal);
+      }
+      // each stripe is shipped as a file, upto its share of the durable region.
+      for (uint16_t stripe = 0; stripe < layout.stripes_; ++stripe) {
+        fs::Path source(primary_log.construct_suffixed_log_path(node, id, ordinal, stripe));
+        fs::Path destination(standby_log.construct_suffixed_log_path(node, id, ordinal, stripe));
+        CHECK_ERROR(ship_file(source, destination, layout.get_stripe_length(length, stripe)));
+      }
+    }
+  }
+  return kRetOk;
+}
+
+ErrorStack LogShipperPimpl::ship_snapshots(const savepoint::Savepoint& savepoint) {
+  const snapshot::SnapshotId latest = savepoint.latest_snapshot_id_;
+  if (latest == snapshot::kNullSnapshotId || latest == shipped_snapshot_id_) {
+    return kRetOk;
+  }
+  // Later snapshots point to pages in earlier snapshot files, so we need all of them.
+  const snapshot::SnapshotOptions& primary_snapshot = primary_->get_options().snapshot_;
+  const snapshot::SnapshotOptions& standby_snapshot = standby_options_.snapshot_;
+  snapshot::SnapshotId id = shipped_snapshot_id_;
+  do {
+    id = (id == snapshot::kNullSnapshotId ? 1 : snapshot::increment(id));
+    for (uint16_t node = 0; node < standby_options_.thread_.group_count_; ++node) {
+      // a node has more than one shard if its reducer composed pages in parallel
+      for (uint16_t shard = 0; shard < storage::kMaxSnapshotShards; ++shard) {
+        fs::Path source(primary_snapshot.construct_snapshot_file_path(id, node, shard));
+        if (!fs::exists(source)) {
+          continue;  // the snapshot had nothing to write in the node/shard
+        }
+        CHECK_ERROR(ship_file(
+          source,
+          fs::Path(standby_snapshot.construct_snapshot_file_path(id, node, shard)),
+          fs::file_size(source)));
+      }
+    }
+    fs::Path metadata_source(primary_snapshot.construct_snapshot_metadata_file_path(id));
+    if (fs::exists(metadata_source)) {
+      CHECK_ERROR(ship_file(
+        metadata_source,
+        fs::Path(standby_snapshot.construct_snapshot_metadata_file_path(id)),
+        fs::file_size(metadata_source)));
+    }
+  } while (id != latest);
+  shipped_snapshot_id_ = latest;
+  return kRetOk;
+}
+
+ErrorStack LogShipperPimpl::ship_file(
+  const fs::Path& source,
+  const fs::Path& destination,
+  uint64_t length) {
+  uint64_t shipped = 0;
+  if (fs::exists(destination)) {
+    shipped = fs::file_size(destination);
+    if (shipped == length) {
+      return kRetOk;
+    }
+  } else {
+    fs::create_directories(destination.parent_path(), true);
+  }
+
+  int flags = O_WRONLY | O_CREAT;
+  if (shipped > length) {
+    // The primary has truncated non-durable logs we had shipped (only after its crash).
+    LOG(WARNING) << "LogShipper: " << destination << " is longer than the durable region of "
+      << source << ". Re-shipping it from scratch.";
+    flags |= O_TRUNC;
+    shipped = 0;
+  }
+  int source_descriptor = -1;
+  if (length > 0) {
+    source_descriptor = ::open(source.c_str(), O_RDONLY);
+    if (source_descriptor < 0) {
+      LOG(ERROR) << "LogShipper: failed to open " << source << ". errno=" << errno;
+      return ERROR_STACK_MSG(kErrorCodeFsFailedToOpen, source.c_str());
+    }
+  }
+  int destination_descriptor = ::open(destination.c_str(), flags, S_IRUSR | S_IWUSR);
+  if (destination_descriptor < 0) {
+    LOG(ERROR) << "LogShipper: failed to open " << destination << ". errno=" << errno;
+    if (source_descriptor >= 0) {
+      ::close(source_descriptor);
+    }
+    return ERROR_STACK_MSG(kErrorCodeFsFailedToOpen, destination.c_str());
+  }
+
+  if (copy_buffer_.empty()) {
+    copy_buffer_.resize(kCopyBufferSize);
+  }
+  ErrorCode result = kErrorCodeOk;
+  while (shipped < length) {
+    const uint64_t desired = std::min<uint64_t>(length - shipped, copy_buffer_.size());
+    ::ssize_t read_bytes = ::pread(source_descriptor, &copy_buffer_[0], desired, shipped);
+    if (read_bytes <= 0) {
+      LOG(ERROR) << "LogShipper: " << source << " is shorter than " << length;
+      result = kErrorCodeFsTooShortRead;
+      break;
+    }
+    ::ssize_t written = ::pwrite(destination_descriptor, &copy_buffer_[0], read_bytes, shipped);
+    if (written != read_bytes) {
+      LOG(ERROR) << "LogShipper: failed to write " << destination << ". errno=" << errno;
+      result = kErrorCodeFsWriteFail;
+      break;
+    }
+    shipped += read_bytes;
+    shipped_bytes_ += read_bytes;
+  }
+  if (result == kErrorCodeOk && ::ftruncate(destination_descriptor, length) != 0) {
+    result = kErrorCodeFsTruncateFailed;
+  }
+  if (result == kErrorCodeOk && ::fsync(destination_descriptor) != 0) {
+    result = kErrorCodeFsSyncFailed;
+  }
+  ::close(destination_descriptor);
+  if (source_descriptor >= 0) {
+    ::close(source_descriptor);
+  }
+  if (result != kErrorCodeOk) {
+    return ERROR_STACK_MSG(result, destination.c_str());
+  }
+  if (!fs::fsync(destination.parent_path(), false)) {
+    return ERROR_STACK_MSG(kErrorCodeFsSyncFailed, destination.c_str());
+  }
+  return kRetOk;
+}
+
+}  // namespace log
+}  // namespace foedus
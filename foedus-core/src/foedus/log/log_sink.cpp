@@ -0,0 +1,692 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include "foedus/log/log_sink.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <glog/logging.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif  // __SSE2__
+#ifdef __CLFLUSHOPT__
+#include <immintrin.h>
+#endif  // __CLFLUSHOPT__
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "foedus/assert_nd.hpp"
+#include "foedus/assorted/assorted_func.hpp"
+#include "foedus/assorted/cacheline.hpp"
+#include "foedus/assorted/raw_atomics.hpp"
+#include "foedus/fs/direct_io_file.hpp"
+#include "foedus/fs/filesystem.hpp"
+#include "foedus/log/common_log_types.hpp"
+#include "foedus/log/log_options.hpp"
+#include "foedus/thread/condition_variable_impl.hpp"
+
+namespace foedus {
+namespace log {
+
+std::ostream& operator<<(std::ostream& o, const LogSink& v) {
+  v.describe(&o);
+  return o;
+}
+
+LogSink* create_log_sink(const LogOptions& options, const fs::Path& path) {
+  if (options.sink_type_ == LogOptions::kLogSinkMmap) {
+    return new MmapLogSink(path, options.mmap_sink_map_sync_);
+  } else {
+    return new DirectIoLogSink(path, options.emulation_);
+  }
+}
+
+LogSink* create_log_sink(
+  const LogOptions& options,
+  int node,
+  LoggerId logger,
+  LogFileOrdinal ordinal) {
+  if (options.log_stripes_ > 1U && options.sink_type_ == LogOptions::kLogSinkDirectIo) {
+    return new StripedLogSink(options, node, logger, ordinal);
+  }
+  fs::Path path(options.construct_suffixed_log_path(node, logger, ordinal));
+  return create_log_sink(options, path);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+///       DirectIoLogSink
+///
+////////////////////////////////////////////////////////////////////////////////
+DirectIoLogSink::DirectIoLogSink(
+  const fs::Path& path,
+  const fs::DeviceEmulationOptions& emulation)
+  : LogSink(path), file_(new fs::DirectIoFile(path, emulation)) {
+}
+
+DirectIoLogSink::~DirectIoLogSink() {
+  close();
+  delete file_;
+  file_ = nullptr;
+}
+
+ErrorCode DirectIoLogSink::open() {
+  return file_->open(true, true, true, true);
+}
+
+void DirectIoLogSink::close() {
+  if (file_->is_opened()) {
+    file_->close();
+  }
+}
+
+ErrorCode DirectIoLogSink::write(uint64_t desired_bytes, const void* buffer) {
+  return file_->write_raw(desired_bytes, buffer);
+}
+
+ErrorCode DirectIoLogSink::sync() {
+  // fsync the file AND the parent folder
+  if (!fs::fsync(path_, true)) {
+    return kErrorCodeFsSyncFailed;
+  }
+  return kErrorCodeOk;
+}
+
+ErrorCode DirectIoLogSink::truncate(uint64_t new_length) {
+  return file_->truncate(new_length, true);
+}
+
+uint64_t DirectIoLogSink::get_current_offset() const {
+  return file_->get_current_offset();
+}
+
+void DirectIoLogSink::describe(std::ostream* o) const {
+  *o << *file_;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+///       MmapLogSink
+///
+////////////////////////////////////////////////////////////////////////////////
+const uint64_t MmapLogSink::kExtentSize;
+const uint64_t MmapLogSink::kHeaderMagicWord;
+
+MmapLogSink::MmapLogSink(const fs::Path& path, bool map_sync)
+  : LogSink(path),
+    map_sync_(map_sync),
+    map_synced_(false),
+    descriptor_(-1),
+    header_descriptor_(-1),
+    mapped_(nullptr),
+    mapped_size_(0),
+    header_(nullptr),
+    current_offset_(0),
+    synced_offset_(0) {
+}
+
+MmapLogSink::~MmapLogSink() {
+  close();
+}
+
+fs::Path MmapLogSink::get_header_path(const fs::Path& path) {
+  return fs::Path(path.string() + std::string(".header"));
+}
+
+void MmapLogSink::copy_non_temporal(void* destination, const void* source, uint64_t bytes) {
+#ifdef __SSE2__
+  if (reinterpret_cast<uintptr_t>(destination) % sizeof(__m128i) == 0
+    && reinterpret_cast<uintptr_t>(source) % sizeof(__m128i) == 0
+    && bytes % sizeof(__m128i) == 0) {
+    __m128i* dest = reinterpret_cast<__m128i*>(destination);
+    const __m128i* src = reinterpret_cast<const __m128i*>(source);
+    const uint64_t count = bytes / sizeof(__m128i);
+    for (uint64_t i = 0; i < count; ++i) {
+      _mm_stream_si128(dest + i, _mm_load_si128(src + i));
+    }
+  } else {
+    // Ordinary stores stay in CPU caches, which MAP_SYNC does not make durable.
+    // Write back every cacheline we touched before the sfence.
+    std::memcpy(destination, source, bytes);
+    const uintptr_t kLineSize = assorted::kCachelineSize;
+    const uintptr_t begin = reinterpret_cast<uintptr_t>(destination) & ~(kLineSize - 1U);
+    const uintptr_t end = reinterpret_cast<uintptr_t>(destination) + bytes;
+    for (uintptr_t line = begin; line < end; line += kLineSize) {
+#ifdef __CLFLUSHOPT__
+      _mm_clflushopt(reinterpret_cast<void*>(line));
+#else  // __CLFLUSHOPT__
+      _mm_clflush(reinterpret_cast<const void*>(line));
+#endif  // __CLFLUSHOPT__
+    }
+  }
+  _mm_sfence();
+#else  // __SSE2__
+  std::memcpy(destination, source, bytes);
+  assorted::memory_fence_release();
+#endif  // __SSE2__
+}
+
+ErrorCode MmapLogSink::open() {
+  ASSERT_ND(descriptor_ == -1);
+  fs::Path folder(path_.parent_path());
+  if (!fs::exists(folder)) {
+    if (!fs::create_directories(folder, true)) {
+      LOG(ERROR) << "MmapLogSink::open(): failed to create parent directory: "
+        << folder << ", err=" << assorted::os_error();
+      return kErrorCodeFsMkdirFailed;
+    }
+  }
+
+  descriptor_ = ::open(path_.c_str(), O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
+  if (descriptor_ == -1) {
+    LOG(ERROR) << "MmapLogSink::open(): failed to open " << path_
+      << ", err=" << assorted::os_error();
+    return kErrorCodeFsFailedToOpen;
+  }
+  uint64_t file_size = fs::file_size(path_);
+
+  // the header tells where the logs end unless the file was cleanly closed.
+  fs::Path header_path(get_header_path(path_));
+  bool header_existed = fs::exists(header_path);
+  header_descriptor_ = ::open(header_path.c_str(), O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
+  if (header_descriptor_ == -1 || ::ftruncate(header_descriptor_, sizeof(Header)) != 0) {
+    LOG(ERROR) << "MmapLogSink::open(): failed to open " << header_path
+      << ", err=" << assorted::os_error();
+    close();
+    return kErrorCodeFsFailedToOpen;
+  }
+  void* header_block = ::mmap(
+    nullptr,
+    sizeof(Header),
+    PROT_READ | PROT_WRITE,
+    MAP_SHARED,
+    header_descriptor_,
+    0);
+  if (header_block == MAP_FAILED) {
+    LOG(ERROR) << "MmapLogSink::open(): failed to mmap " << header_path
+      << ", err=" << assorted::os_error();
+    close();
+    return kErrorCodeFsFailedToOpen;
+  }
+  header_ = reinterpret_cast<Header*>(header_block);
+  if (header_existed
+    && header_->magic_word_ == kHeaderMagicWord
+    && header_->durable_offset_ <= file_size) {
+    LOG(INFO) << "MmapLogSink::open(): " << path_ << " was not cleanly closed. The header says "
+      << header_->durable_offset_ << " bytes are durable. file size=" << file_size;
+    current_offset_ = header_->durable_offset_;
+  } else {
+    current_offset_ = file_size;
+  }
+  synced_offset_ = current_offset_;
+
+  ErrorCode remap_result = remap(assorted::align<uint64_t, kExtentSize>(current_offset_ + 1U));
+  if (remap_result != kErrorCodeOk) {
+    close();
+    return remap_result;
+  }
+
+  // persist the header and the file's existence before we write any log
+  header_->magic_word_ = kHeaderMagicWord;
+  header_->durable_offset_ = synced_offset_;
+  if (::msync(header_, sizeof(Header), MS_SYNC) != 0
+    || !fs::fsync(path_, true)
+    || !fs::fsync(header_path, true)) {
+    LOG(ERROR) << "MmapLogSink::open(): failed to sync " << path_
+      << ", err=" << assorted::os_error();
+    close();
+    return kErrorCodeFsSyncFailed;
+  }
+  LOG(INFO) << "MmapLogSink::open(): opened " << *this;
+  return kErrorCodeOk;
+}
+
+ErrorCode MmapLogSink::remap(uint64_t new_mapped_size) {
+  ASSERT_ND(new_mapped_size % kExtentSize == 0);
+  ASSERT_ND(new_mapped_size > mapped_size_);
+  unmap();
+  if (fs::file_size(path_) < new_mapped_size
+    && ::ftruncate(descriptor_, new_mapped_size) != 0) {
+    LOG(ERROR) << "MmapLogSink::remap(): failed to extend " << path_ << " to "
+      << new_mapped_size << ", err=" << assorted::os_error();
+    return kErrorCodeFsWriteFail;
+  }
+
+  void* block = MAP_FAILED;
+  map_synced_ = false;
+#if defined(MAP_SYNC) && defined(__SSE2__)
+  if (map_sync_) {
+    block = ::mmap(
+      nullptr,
+      new_mapped_size,
+      PROT_READ | PROT_WRITE,
+      MAP_SHARED_VALIDATE | MAP_SYNC,
+      descriptor_,
+      0);
+    if (block == MAP_FAILED) {
+      LOG(WARNING) << "MmapLogSink::remap(): MAP_SYNC is not supported on " << path_
+        << ". Probably not a DAX filesystem. Falls back to msync. err=" << assorted::os_error();
+    } else {
+      map_synced_ = true;
+    }
+  }
+#else  // defined(MAP_SYNC) && defined(__SSE2__)
+  // Without SSE2, copy_non_temporal() can't write back CPU caches, so we always need msync.
+  if (map_sync_) {
+    LOG(WARNING) << "MmapLogSink::remap(): MAP_SYNC is not available in this environment."
+      << " Falls back to msync.";
+  }
+#endif  // defined(MAP_SYNC) && defined(__SSE2__)
+  if (block == MAP_FAILED) {
+    block = ::mmap(nullptr, new_mapped_size, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor_, 0);
+  }
+  if (block == MAP_FAILED) {
+    LOG(ERROR) << "MmapLogSink::remap(): failed to mmap " << path_ << " of "
+      << new_mapped_size << " bytes, err=" << assorted::os_error();
+    return kErrorCodeFsFailedToOpen;
+  }
+  mapped_ = reinterpret_cast<char*>(block);
+  mapped_size_ = new_mapped_size;
+  return kErrorCodeOk;
+}
+
+void MmapLogSink::unmap() {
+  if (mapped_) {
+    ::munmap(mapped_, mapped_size_);
+    mapped_ = nullptr;
+    mapped_size_ = 0;
+  }
+}
+
+ErrorCode MmapLogSink::write(uint64_t desired_bytes, const void* buffer) {
+  if (descriptor_ == -1) {
+    return kErrorCodeFsNotOpened;
+  }
+  if (current_offset_ + desired_bytes > mapped_size_) {
+    uint64_t new_mapped_size = assorted::align<uint64_t, kExtentSize>(
+      current_offset_ + desired_bytes);
+    CHECK_ERROR_CODE(remap(new_mapped_size));
+  }
+  copy_non_temporal(mapped_ + current_offset_, buffer, desired_bytes);
+  current_offset_ += desired_bytes;
+  return kErrorCodeOk;
+}
+
+ErrorCode MmapLogSink::persist(uint64_t from, uint64_t to) {
+  ASSERT_ND(from <= to);
+  if (from < to && !map_synced_) {
+    // msync() requires a page-aligned address
+    uint64_t page_size = ::getpagesize();
+    uint64_t aligned_from = (from / page_size) * page_size;
+    if (::msync(mapped_ + aligned_from, to - aligned_from, MS_SYNC) != 0) {
+      LOG(ERROR) << "MmapLogSink::persist(): msync failed on " << path_
+        << ", err=" << assorted::os_error();
+      return kErrorCodeFsSyncFailed;
+    }
+  }
+
+  // then announce the durable offset
+  Header new_header;
+  new_header.magic_word_ = kHeaderMagicWord;
+  new_header.durable_offset_ = to;
+  copy_non_temporal(header_, &new_header, sizeof(Header));
+  if (!map_synced_ && ::msync(header_, sizeof(Header), MS_SYNC) != 0) {
+    LOG(ERROR) << "MmapLogSink::persist(): msync failed on the header of " << path_
+      << ", err=" << assorted::os_error();
+    return kErrorCodeFsSyncFailed;
+  }
+  return kErrorCodeOk;
+}
+
+ErrorCode MmapLogSink::sync() {
+  if (descriptor_ == -1) {
+    return kErrorCodeFsNotOpened;
+  }
+  CHECK_ERROR_CODE(persist(synced_offset_, current_offset_));
+  synced_offset_ = current_offset_;
+  return kErrorCodeOk;
+}
+
+ErrorCode MmapLogSink::truncate(uint64_t new_length) {
+  if (descriptor_ == -1) {
+    return kErrorCodeFsNotOpened;
+  }
+  ASSERT_ND(new_length <= current_offset_);
+  LOG(INFO) << "MmapLogSink::truncate(): truncating " << path_ << " from " << current_offset_
+    << " to " << new_length;
+  // The file keeps its size as the mapping is still there. Just zero-out the discarded region.
+  std::memset(mapped_ + new_length, 0, current_offset_ - new_length);
+  uint64_t dirty_until = current_offset_;
+  current_offset_ = new_length;
+  synced_offset_ = new_length;
+  return persist(new_length, dirty_until);
+}
+
+void MmapLogSink::close() {
+  if (descriptor_ != -1) {
+    ErrorCode sync_result = sync();
+    unmap();
+    // shrink the file to the exact size of logs so that it looks like an ordinary log file
+    if (sync_result != kErrorCodeOk
+      || ::ftruncate(descriptor_, current_offset_) != 0
+      || ::fsync(descriptor_) != 0) {
+      // then leave the header. next open() will tell where the logs end.
+      LOG(ERROR) << "MmapLogSink::close(): failed to shrink " << path_
+        << ", err=" << assorted::os_error();
+      sync_result = kErrorCodeFsWriteFail;
+    }
+    ::close(descriptor_);
+    descriptor_ = -1;
+    if (header_) {
+      ::munmap(header_, sizeof(Header));
+      header_ = nullptr;
+    }
+    if (header_descriptor_ != -1) {
+      ::close(header_descriptor_);
+      header_descriptor_ = -1;
+    }
+    if (sync_result == kErrorCodeOk) {
+      fs::remove(get_header_path(path_));
+      fs::fsync(path_, true);
+    }
+  } else {
+    // open() failed halfway
+    unmap();
+    if (header_) {
+      ::munmap(header_, sizeof(Header));
+      header_ = nullptr;
+    }
+    if (header_descriptor_ != -1) {
+      ::close(header_descriptor_);
+      header_descriptor_ = -1;
+    }
+  }
+}
+
+void MmapLogSink::describe(std::ostream* o) const {
+  *o << "<MmapLogSink>"
+    << "<path>" << path_ << "</path>"
+    << "<descriptor>" << descriptor_ << "</descriptor>"
+    << "<map_synced>" << map_synced_ << "</map_synced>"
+    << "<mapped_size>" << mapped_size_ << "</mapped_size>"
+    << "<current_offset>" << current_offset_ << "</current_offset>"
+    << "<synced_offset>" << synced_offset_ << "</synced_offset>"
+    << "</MmapLogSink>";
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+///       StripedLogSink
+///
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * Runs one job at a time for StripedLogSink on its own thread. The sink posts a job and later
+ * waits for it, and never posts another job before that.
+ */
+struct StripedLogSink::StripeWorker {
+  enum JobType {
+    kNone = 0,
+    kWrite,
+    kSync,
+    kStop,
+  };
+
+  StripeWorker(StripedLogSink* sink, uint16_t stripe)
+    : sink_(sink), stripe_(stripe), offset_(0), bytes_(0), buffer_(nullptr),
+      job_type_(kNone), done_(true), result_(kErrorCodeOk) {
+    thread_ = std::move(std::thread(&StripeWorker::handle, this));
+  }
+  ~StripeWorker() {
+    post(kStop, 0, 0, nullptr);
+    thread_.join();
+  }
+
+  void post(JobType type, uint64_t offset, uint64_t bytes, const char* buffer) {
+    ASSERT_ND(done_);
+    posted_.notify_one([this, type, offset, bytes, buffer]{
+      offset_ = offset;
+      bytes_ = bytes;
+      buffer_ = buffer;
+      done_ = false;
+      job_type_ = type;
+    });
+  }
+  ErrorCode wait_done() {
+    done_cond_.wait([this]{ return done_.load(); });
+    return result_;
+  }
+
+  void handle() {
+    while (true) {
+      posted_.wait([this]{ return job_type_.load() != kNone; });
+      const JobType type = static_cast<JobType>(job_type_.load());
+      if (type == kStop) {
+        break;
+      }
+      ErrorCode result;
+      if (type == kWrite) {
+        result = sink_->write_stripe(stripe_, offset_, bytes_, buffer_);
+      } else {
+        result = sink_->sync_stripe(stripe_);
+      }
+      done_cond_.notify_one([this, result]{
+        result_ = result;
+        job_type_ = kNone;
+        done_ = true;
+      });
+    }
+  }
+
+  StripedLogSink* const     sink_;
+  const uint16_t            stripe_;
+  uint64_t                  offset_;
+  uint64_t                  bytes_;
+  const char*               buffer_;
+  std::atomic<int>          job_type_;
+  std::atomic<bool>         done_;
+  ErrorCode                 result_;
+  thread::ConditionVariable posted_;
+  thread::ConditionVariable done_cond_;
+  std::thread               thread_;
+};
+
+StripedLogSink::StripedLogSink(
+  const LogOptions& options,
+  int node,
+  LoggerId logger,
+  LogFileOrdinal ordinal)
+  : LogSink(fs::Path(options.construct_suffixed_log_path(node, logger, ordinal))),
+    layout_(options),
+    current_offset_(0) {
+  for (uint16_t stripe = 0; stripe < layout_.stripes_; ++stripe) {
+    fs::Path path(options.construct_suffixed_log_path(node, logger, ordinal, stripe));
+    files_.push_back(new fs::DirectIoFile(path, options.emulation_));
+  }
+}
+
+StripedLogSink::~StripedLogSink() {
+  close();
+  for (fs::DirectIoFile* file : files_) {
+    delete file;
+  }
+  files_.clear();
+}
+
+ErrorCode StripedLogSink::open() {
+  current_offset_ = 0;
+  for (fs::DirectIoFile* file : files_) {
+    ErrorCode result = file->open(true, true, true, true);
+    if (result != kErrorCodeOk) {
+      close();
+      return result;
+    }
+    current_offset_ += file->get_current_offset();
+  }
+  ASSERT_ND(workers_.empty());
+  for (uint16_t stripe = 0; stripe < layout_.stripes_; ++stripe) {
+    workers_.push_back(new StripeWorker(this, stripe));
+  }
+  // the stripes must look like one file. otherwise, we crashed while we were writing them.
+  for (uint16_t stripe = 0; stripe < layout_.stripes_; ++stripe) {
+    uint64_t expected = layout_.get_stripe_length(current_offset_, stripe);
+    if (files_[stripe]->get_current_offset() != expected) {
+      LOG(WARNING) << "StripedLogSink::open(): stripe-" << stripe << " has "
+        << files_[stripe]->get_current_offset() << " bytes while " << expected << " bytes are"
+        << " expected. Probably there was a crash. Logger will truncate non-durable regions.";
+    }
+  }
+  return kErrorCodeOk;
+}
+
+void StripedLogSink::close() {
+  bool was_opened = false;
+  for (fs::DirectIoFile* file : files_) {
+    if (file->is_opened()) {
+      file->close();
+      was_opened = true;
+    }
+  }
+  if (was_opened) {
+    sync();
+  }
+  stop_workers();
+}
+
+void StripedLogSink::stop_workers() {
+  for (StripeWorker* worker : workers_) {
+    delete worker;
+  }
+  workers_.clear();
+}
+
+ErrorCode StripedLogSink::write_stripe(
+  uint16_t stripe,
+  uint64_t offset,
+  uint64_t bytes,
+  const char* buffer) {
+  const uint64_t end = offset + bytes;
+  fs::DirectIoFile* file = files_[stripe];
+  while (offset < end) {
+    const uint64_t unit_end = std::min<uint64_t>(
+      end,
+      (offset / layout_.unit_size_ + 1U) * layout_.unit_size_);
+    if (layout_.to_stripe(offset) == stripe) {
+      ASSERT_ND(file->get_current_offset() == layout_.to_stripe_offset(offset));
+      CHECK_ERROR_CODE(file->write_raw(unit_end - offset, buffer));
+    }
+    buffer += unit_end - offset;
+    offset = unit_end;
+  }
+  return kErrorCodeOk;
+}
+
+ErrorCode StripedLogSink::write(uint64_t desired_bytes, const void* buffer) {
+  if (desired_bytes == 0) {
+    return kErrorCodeOk;
+  }
+  const char* bytes = reinterpret_cast<const char*>(buffer);
+  const uint64_t first_unit = current_offset_ / layout_.unit_size_;
+  const uint64_t last_unit = (current_offset_ + desired_bytes - 1U) / layout_.unit_size_;
+  const uint16_t touched_stripes = static_cast<uint16_t>(std::min<uint64_t>(
+    last_unit - first_unit + 1U,
+    layout_.stripes_));
+  ErrorCode result = kErrorCodeOk;
+  if (touched_stripes == 1U) {
+    const uint16_t stripe = layout_.to_stripe(current_offset_);
+    result = write_stripe(stripe, current_offset_, desired_bytes, bytes);
+  } else {
+    // each stripe is written by its I/O thread. the first one by this thread.
+    ASSERT_ND(workers_.size() == layout_.stripes_);
+    const uint16_t first_stripe = layout_.to_stripe(current_offset_);
+    for (uint16_t i = 1; i < touched_stripes; ++i) {
+      uint16_t stripe = (first_stripe + i) % layout_.stripes_;
+      workers_[stripe]->post(StripeWorker::kWrite, current_offset_, desired_bytes, bytes);
+    }
+    result = write_stripe(first_stripe, current_offset_, desired_bytes, bytes);
+    for (uint16_t i = 1; i < touched_stripes; ++i) {
+      uint16_t stripe = (first_stripe + i) % layout_.stripes_;
+      ErrorCode other_result = workers_[stripe]->wait_done();
+      if (result == kErrorCodeOk) {
+        result = other_result;
+      }
+    }
+  }
+  if (result == kErrorCodeOk) {
+    current_offset_ += desired_bytes;
+  }
+  return result;
+}
+
+ErrorCode StripedLogSink::sync_stripe(uint16_t stripe) {
+  if (!fs::fsync(files_[stripe]->get_path(), true)) {
+    return kErrorCodeFsSyncFailed;
+  }
+  return kErrorCodeOk;
+}
+
+ErrorCode StripedLogSink::sync() {
+  // fsync the files AND the parent folders, in parallel as they are on different devices
+  const bool parallel = !workers_.empty();
+  if (parallel) {
+    for (uint16_t stripe = 1; stripe < layout_.stripes_; ++stripe) {
+      workers_[stripe]->post(StripeWorker::kSync, 0, 0, nullptr);
+    }
+  }
+  ErrorCode result = sync_stripe(0);
+  for (uint16_t stripe = 1; stripe < layout_.stripes_; ++stripe) {
+    ErrorCode other_result = parallel ? workers_[stripe]->wait_done() : sync_stripe(stripe);
+    if (result == kErrorCodeOk) {
+      result = other_result;
+    }
+  }
+  return result;
+}
+
+ErrorCode StripedLogSink::truncate(uint64_t new_length) {
+  ASSERT_ND(new_length % FillerLogType::kLogWriteUnitSize == 0);
+  for (uint16_t stripe = 0; stripe < layout_.stripes_; ++stripe) {
+    uint64_t stripe_length = layout_.get_stripe_length(new_length, stripe);
+    if (files_[stripe]->get_current_offset() != stripe_length) {
+      CHECK_ERROR_CODE(files_[stripe]->truncate(stripe_length, true));
+    }
+  }
+  current_offset_ = new_length;
+  return kErrorCodeOk;
+}
+
+void StripedLogSink::describe(std::ostream* o) const {
+  *o << "<StripedLogSink>"
+    << "<stripes>" << layout_.stripes_ << "</stripes>"
+    << "<unit_size>" << layout_.unit_size_ << "</unit_size>"
+    << "<current_offset>" << current_offset_ << "</current_offset>";
+  for (const fs::DirectIoFile* file : files_) {
+    *o << *file;
+  }
+  *o << "</StripedLogSink>";
+}
+
+}  // namespace log
+}  // namespace foedus
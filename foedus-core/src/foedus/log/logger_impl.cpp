@@ -35,16 +35,17 @@
 #include "foedus/error_stack_batch.hpp"
 #include "foedus/assorted/atomic_fences.hpp"
 #include "foedus/debugging/stop_watch.hpp"
-#include "foedus/fs/direct_io_file.hpp"
 #include "foedus/fs/filesystem.hpp"
 #include "foedus/log/common_log_types.hpp"
 #include "foedus/log/log_manager.hpp"
+#include "foedus/log/log_sink.hpp"
 #include "foedus/log/log_type.hpp"
 #include "foedus/log/thread_log_buffer.hpp"
 #include "foedus/memory/engine_memory.hpp"
 #include "foedus/memory/numa_node_memory.hpp"
 #include "foedus/savepoint/savepoint.hpp"
 #include "foedus/savepoint/savepoint_manager.hpp"
+#include "foedus/soc/soc_manager.hpp"
 #include "foedus/thread/numa_thread_scope.hpp"
 #include "foedus/thread/thread.hpp"
 #include "foedus/thread/thread_group.hpp"
@@ -72,7 +73,10 @@ inline uint64_t align_log_floor(uint64_t offset) {
 }
 
 ErrorStack Logger::initialize_once() {
-  control_block_->initialize();
+  // In warm restart, logs since the latest snapshot are not gleaned yet. Keep their histories.
+  const bool warm_restarted
+    = engine_->get_soc_manager()->get_shared_memory_repo()->is_warm_restarted();
+  control_block_->initialize(warm_restarted);
   // clear all variables
   current_file_ = nullptr;
   LOG(INFO) << "Initializing Logger-" << id_ << ". assigned " << assigned_thread_ids_.size()
@@ -94,9 +98,12 @@ ErrorStack Logger::initialize_once() {
     id_,
     control_block_->current_ordinal_);
   // open the log file
-  current_file_ = new fs::DirectIoFile(current_file_path_,
-                     engine_->get_options().log_.emulation_);
-  WRAP_ERROR_CODE(current_file_->open(true, true, true, true));
+  current_file_ = create_log_sink(
+    engine_->get_options().log_,
+    numa_node_,
+    id_,
+    control_block_->current_ordinal_);
+  WRAP_ERROR_CODE(current_file_->open());
   if (control_block_->current_file_durable_offset_ < current_file_->get_current_offset()) {
     // there are non-durable regions as an incomplete remnant of previous execution.
     // probably there was a crash. in this case, we discard the non-durable regions.
@@ -104,17 +111,34 @@ ErrorStack Logger::initialize_once() {
       << " was a crash. Will truncate it to " << control_block_->current_file_durable_offset_
       << " from " << current_file_->get_current_offset();
     WRAP_ERROR_CODE(current_file_->truncate(
-      control_block_->current_file_durable_offset_,
-      true));  // sync right now
+      control_block_->current_file_durable_offset_));  // this syncs right now
   }
   ASSERT_ND(control_block_->current_file_durable_offset_ == current_file_->get_current_offset());
+  if (warm_restarted) {
+    retain_epoch_history();
+  } else {
+    seed_snapshot_epoch_history(info);
+  }
   LOG(INFO) << "Initialized logger: " << *this;
 
   // which threads are assigned to me?
+  thread::ThreadGroup* local_group = engine_->get_thread_pool()->get_pimpl()->get_local_group();
   for (auto thread_id : assigned_thread_ids_) {
     assigned_threads_.push_back(
-      engine_->get_thread_pool()->get_pimpl()->get_local_group()->get_thread(
-        thread::decompose_numa_local_ordinal(thread_id)));
+      local_group->get_thread(thread::decompose_numa_local_ordinal(thread_id)));
+  }
+  if (engine_->get_options().log_.dynamic_logger_assignment_) {
+    // Then other threads in the node, starting from the ones next to mine so that
+    // loggers don't compete for the same threads.
+    const uint16_t threads_per_node = engine_->get_options().thread_.thread_count_per_group_;
+    const thread::ThreadLocalOrdinal last_ordinal
+      = thread::decompose_numa_local_ordinal(assigned_thread_ids_.back());
+    for (uint16_t i = 1; i < threads_per_node - assigned_thread_ids_.size() + 1U; ++i) {
+      other_threads_.push_back(
+        local_group->get_thread((last_ordinal + i) % threads_per_node));
+    }
+    LOG(INFO) << "Logger-" << id_ << " will also write out logs of " << other_threads_.size()
+      << " other threads in the node when they are not claimed yet";
   }
 
   // grab a buffer to pad incomplete blocks for direct file I/O
@@ -219,8 +243,8 @@ ErrorStack Logger::update_durable_epoch(Epoch new_durable_epoch, bool had_any_lo
     VLOG(0) << "Logger-" << id_ << " updating durable_epoch_ from " << get_durable_epoch()
       << " to " << new_durable_epoch;
 
-    // BEFORE updating the epoch, fsync the file AND the parent folder
-    if (!fs::fsync(current_file_path_, true)) {
+    // BEFORE updating the epoch, make the file durable (fsync the file AND the parent folder)
+    if (current_file_->sync() != kErrorCodeOk) {
       return ERROR_STACK_MSG(kErrorCodeFsSyncFailed, to_string().c_str());
     }
     control_block_->current_file_durable_offset_ = current_file_->get_current_offset();
@@ -253,6 +277,57 @@ ErrorStack Logger::update_durable_epoch(Epoch new_durable_epoch, bool had_any_lo
   assert_consistent();
   return kRetOk;
 }
+void Logger::retain_epoch_history() {
+  // Drop histories that point beyond the durable region, if any, then continue from the last
+  // epoch marker of the previous engine. The dummy epoch marker written next then bridges the
+  // idle epochs, if any, between that marker and the durable epoch.
+  uint32_t dropped = 0;
+  while (!control_block_->is_epoch_history_empty()) {
+    const EpochHistory& tail
+      = control_block_->epoch_histories_[control_block_->get_tail_epoch_history()];
+    if (tail.new_epoch_ <= get_durable_epoch()
+      && (tail.log_file_ordinal_ < control_block_->current_ordinal_
+        || (tail.log_file_ordinal_ == control_block_->current_ordinal_
+          && tail.log_file_offset_ < control_block_->current_file_durable_offset_))) {
+      break;
+    }
+    --control_block_->epoch_history_count_;
+    ++dropped;
+  }
+  if (!control_block_->is_epoch_history_empty()) {
+    control_block_->marked_epoch_
+      = control_block_->epoch_histories_[control_block_->get_tail_epoch_history()].new_epoch_;
+  }
+  LOG(INFO) << "Logger-" << id_ << " retained " << control_block_->epoch_history_count_
+    << " epoch histories for warm restart. dropped=" << dropped
+    << ", marked_epoch_=" << control_block_->marked_epoch_;
+}
+
+void Logger::seed_snapshot_epoch_history(const savepoint::LoggerSavepointInfo& info) {
+  ASSERT_ND(control_block_->is_epoch_history_empty());
+  Epoch snapshot_epoch = engine_->get_savepoint_manager()->get_latest_snapshot_epoch();
+  Epoch durable_epoch = get_durable_epoch();
+  if (!snapshot_epoch.is_valid() || snapshot_epoch >= durable_epoch) {
+    return;  // nothing to recover, or we read from the beginning anyway
+  }
+  ASSERT_ND(info.snapshot_log_file_ <= info.current_log_file_);
+  // new_epoch is the durable epoch so that the dummy marker written next continues from it.
+  uint64_t marker_buffer[sizeof(EpochMarkerLogType) / sizeof(uint64_t)];
+  EpochMarkerLogType* marker = reinterpret_cast<EpochMarkerLogType*>(marker_buffer);
+  marker->populate(
+    snapshot_epoch,
+    durable_epoch,
+    numa_node_,
+    in_node_ordinal_,
+    id_,
+    info.snapshot_log_file_,
+    info.snapshot_log_file_offset_);
+  add_epoch_history(*marker);
+  LOG(INFO) << "Logger-" << id_ << " will recover logs after snapshot epoch " << snapshot_epoch
+    << " from file ordinal " << info.snapshot_log_file_ << " offset "
+    << info.snapshot_log_file_offset_;
+}
+
 ErrorStack Logger::write_dummy_epoch_mark() {
   CHECK_ERROR(log_epoch_switch(get_durable_epoch()));
   LOG(INFO) << "Logger-" << id_ << " wrote out a dummy epoch marker at the beginning";
@@ -284,7 +359,7 @@ ErrorStack Logger::log_epoch_switch(Epoch new_epoch) {
     + sizeof(EpochMarkerLogType));
   filler_log->populate(fill_buffer_.get_size() - sizeof(EpochMarkerLogType));
 
-  WRAP_ERROR_CODE(current_file_->write(fill_buffer_.get_size(), fill_buffer_));
+  WRAP_ERROR_CODE(current_file_->write(fill_buffer_.get_size(), fill_buffer_.get_block()));
   control_block_->marked_epoch_ = new_epoch;
   add_epoch_history(*epoch_marker);
 
@@ -315,9 +390,12 @@ ErrorStack Logger::switch_file_if_required() {
     id_,
     ++control_block_->current_ordinal_);
   LOG(INFO) << "Logger-" << id_ << " next file=" << current_file_path_;
-  current_file_ = new fs::DirectIoFile(current_file_path_,
-                      engine_->get_options().log_.emulation_);
-  WRAP_ERROR_CODE(current_file_->open(true, true, true, true));
+  current_file_ = create_log_sink(
+    engine_->get_options().log_,
+    numa_node_,
+    id_,
+    control_block_->current_ordinal_);
+  WRAP_ERROR_CODE(current_file_->open());
   ASSERT_ND(current_file_->get_current_offset() == 0);
   LOG(INFO) << "Logger-" << id_ << " moved on to next file. " << *this;
   CHECK_ERROR(write_dummy_epoch_mark());
@@ -328,49 +406,86 @@ ErrorStack Logger::write_one_epoch(Epoch write_epoch) {
   ASSERT_ND(get_durable_epoch().one_more() == write_epoch);
   ASSERT_ND(write_epoch.one_more() < engine_->get_xct_manager()->get_current_global_epoch());
   bool had_any_log = false;
-  for (thread::Thread* the_thread : assigned_threads_) {
-    ThreadLogBuffer& buffer = the_thread->get_thread_log_buffer();
-    ThreadLogBuffer::OffsetRange range = buffer.get_logs_to_write(write_epoch);
-    ASSERT_ND(range.begin_ <= buffer.get_meta().buffer_size_);
-    ASSERT_ND(range.end_ <= buffer.get_meta().buffer_size_);
-    if (range.begin_ > buffer.get_meta().buffer_size_
-      || range.end_ > buffer.get_meta().buffer_size_) {
-      LOG(FATAL) << "Logger-" << id_ << " reported an invalid buffer range for epoch-"
-        << write_epoch << ". begin=" << range.begin_ << ", end=" << range.end_
-          << " while log buffer size=" << buffer.get_meta().buffer_size_
-          << ". " << *this;
+  if (!engine_->get_options().log_.dynamic_logger_assignment_) {
+    for (thread::Thread* the_thread : assigned_threads_) {
+      CHECK_ERROR(write_one_epoch_thread(&the_thread->get_thread_log_buffer(), write_epoch,
+        &had_any_log));
     }
-
-    if (!range.is_empty()) {
-      if (had_any_log == false) {
-        // First log for this epoch. Now we write out an epoch mark.
-        // If no buffers have any logs, we don't even bother writing out an epoch mark.
-        VLOG(1) << "Logger-" << id_ << " has a non-empty epoch-" << write_epoch;
-        had_any_log = true;
-        CHECK_ERROR(log_epoch_switch(write_epoch));
+  } else {
+    // Our own threads first, then the others. We can't declare the epoch durable until
+    // all threads in the node are claimed by some logger, which also declares the epoch durable
+    // only after it writes out what it claimed.
+    while (true) {
+      bool all_claimed = true;
+      for (uint16_t round = 0; round < 2U; ++round) {
+        const std::vector< thread::Thread* >& threads
+          = round == 0 ? assigned_threads_ : other_threads_;
+        for (thread::Thread* the_thread : threads) {
+          ThreadLogBuffer* buffer = &the_thread->get_thread_log_buffer();
+          ThreadLogBuffer::ClaimResult result = buffer->claim_logs_to_write(write_epoch);
+          if (result == ThreadLogBuffer::kClaimed) {
+            CHECK_ERROR(write_one_epoch_thread(buffer, write_epoch, &had_any_log));
+            buffer->on_claimed_log_written(write_epoch);
+          } else if (result == ThreadLogBuffer::kClaimPending) {
+            all_claimed = false;
+          }
+        }
       }
-
-      if (range.begin_ < range.end_) {
-        CHECK_ERROR(write_one_epoch_piece(buffer, write_epoch, range.begin_, range.end_));
-      } else {
-        // oh, it wraps around.
-        // let's write up to the end of the circular buffer, then from the beginning.
-        // we can simply write out logs upto the end without worrying about the case where a log
-        // entry spans the end of circular buffer. Because we avoid that in ThreadLogBuffer.
-        // (see reserve_new_log()). So, we can separately handle the two writes by calling itself
-        // again, which adds padding if they need.
-        VLOG(0) << "Wraps around. from_offset=" << range.begin_ << ", upto_offset=" << range.end_;
-        uint64_t capacity = buffer.get_meta().buffer_size_;
-        CHECK_ERROR(write_one_epoch_piece(buffer, write_epoch, range.begin_, capacity));
-        CHECK_ERROR(write_one_epoch_piece(buffer, write_epoch, 0, range.end_));
+      if (all_claimed) {
+        break;
       }
+      // Some other logger is still writing out the previous epoch of a thread. Should be short.
+      std::this_thread::yield();
     }
-    buffer.on_log_written(write_epoch);
   }
   CHECK_ERROR(update_durable_epoch(write_epoch, had_any_log));
   return kRetOk;
 }
 
+ErrorStack Logger::write_one_epoch_thread(
+  ThreadLogBuffer* buffer_ptr,
+  Epoch write_epoch,
+  bool* had_any_log) {
+  ThreadLogBuffer& buffer = *buffer_ptr;
+  ThreadLogBuffer::OffsetRange range = buffer.get_logs_to_write(write_epoch);
+  ASSERT_ND(range.begin_ <= buffer.get_meta().buffer_size_);
+  ASSERT_ND(range.end_ <= buffer.get_meta().buffer_size_);
+  if (range.begin_ > buffer.get_meta().buffer_size_
+    || range.end_ > buffer.get_meta().buffer_size_) {
+    LOG(FATAL) << "Logger-" << id_ << " reported an invalid buffer range for epoch-"
+      << write_epoch << ". begin=" << range.begin_ << ", end=" << range.end_
+        << " while log buffer size=" << buffer.get_meta().buffer_size_
+        << ". " << *this;
+  }
+
+  if (!range.is_empty()) {
+    if (*had_any_log == false) {
+      // First log for this epoch. Now we write out an epoch mark.
+      // If no buffers have any logs, we don't even bother writing out an epoch mark.
+      VLOG(1) << "Logger-" << id_ << " has a non-empty epoch-" << write_epoch;
+      *had_any_log = true;
+      CHECK_ERROR(log_epoch_switch(write_epoch));
+    }
+
+    if (range.begin_ < range.end_) {
+      CHECK_ERROR(write_one_epoch_piece(buffer, write_epoch, range.begin_, range.end_));
+    } else {
+      // oh, it wraps around.
+      // let's write up to the end of the circular buffer, then from the beginning.
+      // we can simply write out logs upto the end without worrying about the case where a log
+      // entry spans the end of circular buffer. Because we avoid that in ThreadLogBuffer.
+      // (see reserve_new_log()). So, we can separately handle the two writes by calling itself
+      // again, which adds padding if they need.
+      VLOG(0) << "Wraps around. from_offset=" << range.begin_ << ", upto_offset=" << range.end_;
+      uint64_t capacity = buffer.get_meta().buffer_size_;
+      CHECK_ERROR(write_one_epoch_piece(buffer, write_epoch, range.begin_, capacity));
+      CHECK_ERROR(write_one_epoch_piece(buffer, write_epoch, 0, range.end_));
+    }
+  }
+  buffer.on_log_written(write_epoch);
+  return kRetOk;
+}
+
 ErrorStack Logger::write_one_epoch_piece(
   const ThreadLogBuffer& buffer,
   Epoch write_epoch,
@@ -424,7 +539,9 @@ ErrorStack Logger::write_one_epoch_piece(
       FillerLogType* end_filler_log = reinterpret_cast<FillerLogType*>(buf);
       end_filler_log->populate(end_fill_size);
     }
-    WRAP_ERROR_CODE(current_file_->write(FillerLogType::kLogWriteUnitSize, fill_buffer_));
+    WRAP_ERROR_CODE(current_file_->write(
+      FillerLogType::kLogWriteUnitSize,
+      fill_buffer_.get_block()));
     from_offset += copy_size;
   }
 
@@ -441,7 +558,7 @@ ErrorStack Logger::write_one_epoch_piece(
   if (middle_size > 0) {
     // debugging::StopWatch watch;
     VLOG(1) << "Writing middle regions: " << middle_size << " bytes from " << from_offset;
-    WRAP_ERROR_CODE(current_file_->write_raw(middle_size, raw_buffer + from_offset));
+    WRAP_ERROR_CODE(current_file_->write(middle_size, raw_buffer + from_offset));
     // watch.stop();
     // mm, in fact too noisy... Maybe VLOG(0). but we need this information for the paper
     // LOG(INFO) << "Wrote middle regions of " << middle_size << " bytes in "
@@ -472,7 +589,9 @@ ErrorStack Logger::write_one_epoch_piece(
   FillerLogType* filler_log = reinterpret_cast<FillerLogType*>(buf);
   filler_log->populate(fill_size);
 
-  WRAP_ERROR_CODE(current_file_->write(FillerLogType::kLogWriteUnitSize, fill_buffer_));
+  WRAP_ERROR_CODE(current_file_->write(
+    FillerLogType::kLogWriteUnitSize,
+    fill_buffer_.get_block()));
   return kRetOk;
 }
 
@@ -62,6 +62,40 @@ void LoggerRef::copy_logger_state(savepoint::Savepoint* new_savepoint) const {
     control_block_->current_file_durable_offset_);
 }
 
+void LoggerRef::copy_logger_snapshot_position(
+  Epoch snapshot_epoch,
+  savepoint::Savepoint* new_savepoint) const {
+  ASSERT_ND(snapshot_epoch.is_valid());
+  // copy_logger_state() has read the current position BEFORE we check the histories below.
+  // Any log of a later epoch is written after that position or has an epoch history.
+  LogFileOrdinal current_ordinal = new_savepoint->current_log_files_[id_];
+  uint64_t current_offset = new_savepoint->current_log_files_offset_durable_[id_];
+  LogFileOrdinal ordinal = current_ordinal;
+  uint64_t offset = current_offset;
+  {
+    soc::SharedMutexScope scope(&control_block_->epoch_history_mutex_);
+    const uint32_t head = control_block_->epoch_history_head_;
+    const uint32_t count = control_block_->epoch_history_count_;
+    for (uint32_t pos = 0; pos < count; ++pos) {
+      uint32_t abs_pos = control_block_->wrap_epoch_history_index(head + pos);
+      const EpochHistory& cur = control_block_->epoch_histories_[abs_pos];
+      if (cur.new_epoch_ > snapshot_epoch) {
+        ordinal = cur.log_file_ordinal_;
+        offset = cur.log_file_offset_;
+        break;
+      }
+    }
+  }
+  // the marker might be beyond what this savepoint deems durable. logs after that are
+  // truncated in restart anyway.
+  if (ordinal > current_ordinal || (ordinal == current_ordinal && offset > current_offset)) {
+    ordinal = current_ordinal;
+    offset = current_offset;
+  }
+  new_savepoint->snapshot_log_files_.push_back(ordinal);
+  new_savepoint->snapshot_log_files_offset_.push_back(offset);
+}
+
 void LoggerRef::add_epoch_history(const EpochMarkerLogType& epoch_marker) {
   soc::SharedMutexScope scope(&control_block_->epoch_history_mutex_);
   uint32_t tail_index = control_block_->get_tail_epoch_history();
@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include "foedus/log/striped_log_file.hpp"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <ostream>
+
+#include "foedus/assert_nd.hpp"
+#include "foedus/fs/direct_io_file.hpp"
+#include "foedus/fs/filesystem.hpp"
+#include "foedus/log/log_options.hpp"
+
+namespace foedus {
+namespace log {
+
+LogStripeLayout::LogStripeLayout(const LogOptions& options)
+  : stripes_(options.log_stripes_),
+    unit_size_(static_cast<uint64_t>(options.log_stripe_unit_kb_) << 10) {
+  ASSERT_ND(stripes_ > 0);
+  ASSERT_ND(unit_size_ > 0);
+}
+
+uint64_t LogStripeLayout::get_stripe_length(uint64_t length, uint16_t stripe) const {
+  ASSERT_ND(stripe < stripes_);
+  const uint64_t row_size = unit_size_ * stripes_;
+  uint64_t stripe_length = (length / row_size) * unit_size_;
+  // the last, partial row. stripes before the one containing the end have a full unit.
+  const uint64_t remainder = length % row_size;
+  const uint64_t stripe_begin = unit_size_ * stripe;
+  if (remainder > stripe_begin) {
+    stripe_length += std::min<uint64_t>(remainder - stripe_begin, unit_size_);
+  }
+  return stripe_length;
+}
+
+StripedLogFile::StripedLogFile(
+  const LogOptions& options,
+  int node,
+  LoggerId logger,
+  LogFileOrdinal ordinal,
+  const fs::DeviceEmulationOptions& emulation)
+  : layout_(options) {
+  for (uint16_t stripe = 0; stripe < layout_.stripes_; ++stripe) {
+    fs::Path path(options.construct_suffixed_log_path(node, logger, ordinal, stripe));
+    files_.push_back(new fs::DirectIoFile(path, emulation));
+  }
+}
+
+StripedLogFile::~StripedLogFile() {
+  close();
+  for (fs::DirectIoFile* file : files_) {
+    delete file;
+  }
+  files_.clear();
+}
+
+ErrorCode StripedLogFile::open() {
+  for (fs::DirectIoFile* file : files_) {
+    ErrorCode result = file->open(true, false, false, false);
+    if (result != kErrorCodeOk) {
+      close();
+      return result;
+    }
+  }
+  return kErrorCodeOk;
+}
+
+void StripedLogFile::close() {
+  for (fs::DirectIoFile* file : files_) {
+    if (file->is_opened()) {
+      file->close();
+    }
+  }
+}
+
+ErrorCode StripedLogFile::read(uint64_t offset, uint64_t bytes, void* buffer) {
+  char* position = reinterpret_cast<char*>(buffer);
+  while (bytes > 0) {
+    // read up to the end of the current stripe unit
+    const uint64_t in_unit = offset % layout_.unit_size_;
+    const uint64_t segment = std::min<uint64_t>(bytes, layout_.unit_size_ - in_unit);
+    fs::DirectIoFile* file = files_[layout_.to_stripe(offset)];
+    CHECK_ERROR_CODE(file->seek(
+      layout_.to_stripe_offset(offset),
+      fs::DirectIoFile::kDirectIoSeekSet));
+    CHECK_ERROR_CODE(file->read_raw(segment, position));
+    position += segment;
+    offset += segment;
+    bytes -= segment;
+  }
+  return kErrorCodeOk;
+}
+
+uint64_t StripedLogFile::get_size() const {
+  uint64_t size = 0;
+  for (const fs::DirectIoFile* file : files_) {
+    size += fs::file_size(file->get_path());
+  }
+  return size;
+}
+
+fs::Path StripedLogFile::get_path() const {
+  ASSERT_ND(!files_.empty());
+  return files_[0]->get_path();
+}
+
+uint64_t StripedLogFile::get_file_size(
+  const LogOptions& options,
+  int node,
+  LoggerId logger,
+  LogFileOrdinal ordinal) {
+  uint64_t size = 0;
+  for (uint16_t stripe = 0; stripe < options.log_stripes_; ++stripe) {
+    fs::Path path(options.construct_suffixed_log_path(node, logger, ordinal, stripe));
+    if (fs::exists(path)) {
+      size += fs::file_size(path);
+    }
+  }
+  return size;
+}
+
+std::ostream& operator<<(std::ostream& o, const StripedLogFile& v) {
+  o << "<StripedLogFile>"
+    << "<stripes>" << v.layout_.stripes_ << "</stripes>"
+    << "<unit_size>" << v.layout_.unit_size_ << "</unit_size>";
+  for (const fs::DirectIoFile* file : v.files_) {
+    o << *file;
+  }
+  o << "</StripedLogFile>";
+  return o;
+}
+
+}  // namespace log
+}  // namespace foedus
@@ -125,6 +125,8 @@ ErrorStack ThreadLogBuffer::initialize_once() {
   meta_.current_mark_index_ = 0;
   meta_.oldest_mark_index_ = 0;
   meta_.thread_epoch_marks_[0] = ThreadEpockMark(initial_durable, initial_current, 0);
+  claimed_epoch_ = initial_durable.value();
+  claimed_written_epoch_ = initial_durable.value();
   return kRetOk;
 }
 
@@ -327,6 +329,29 @@ void ThreadLogBuffer::on_log_written(Epoch written_epoch) {
   // assert_consistent(); this verification assumes the worker is not working. we can't use it here
 }
 
+ThreadLogBuffer::ClaimResult ThreadLogBuffer::claim_logs_to_write(Epoch written_epoch) {
+  Epoch::EpochInteger claimed = claimed_epoch_.load(std::memory_order_acquire);
+  if (Epoch(claimed) >= written_epoch) {
+    return kClaimedByOther;
+  }
+  ASSERT_ND(Epoch(claimed).one_more() == written_epoch);
+  if (claimed_written_epoch_.load(std::memory_order_acquire) != claimed) {
+    // The logger that claimed the previous epoch is still writing it out.
+    return kClaimPending;
+  }
+  if (claimed_epoch_.compare_exchange_strong(claimed, written_epoch.value())) {
+    return kClaimed;
+  }
+  ASSERT_ND(Epoch(claimed) == written_epoch);
+  return kClaimedByOther;
+}
+
+void ThreadLogBuffer::on_claimed_log_written(Epoch written_epoch) {
+  ASSERT_ND(Epoch(claimed_epoch_.load()) == written_epoch);
+  ASSERT_ND(Epoch(claimed_written_epoch_.load()).one_more() == written_epoch);
+  claimed_written_epoch_.store(written_epoch.value(), std::memory_order_release);
+}
+
 std::ostream& operator<<(std::ostream& o, const ThreadLogBuffer& v) {
   o << v.meta_;
   return o;
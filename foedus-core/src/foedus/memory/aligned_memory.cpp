@@ -156,6 +156,14 @@ void AlignedMemory::alloc(
     case kNumaMmapOneGbPages:
       block_ = alloc_mmap_1gb_pages(size_);
       break;
+    case kNumaReserveOnnode:
+      block_ = alloc_mmap(size_, 1ULL << 12);
+      if (block_ && ::numa_available() >= 0) {
+        // pages are given later by the thread that touches them, so numa_set_preferred
+        // here doesn't help. explicitly bind the range instead.
+        ::numa_tonode_memory(block_, size_, assorted::mod_numa_node(numa_node));
+      }
+      break;
     default:
       ASSERT_ND(false);
   }
@@ -171,7 +179,9 @@ void AlignedMemory::alloc(
   }
 
   debugging::StopWatch watch2;
-  std::memset(block_, 0, size_);  // see class comment for why we do this immediately
+  if (alloc_type_ != kNumaReserveOnnode) {
+    std::memset(block_, 0, size_);  // see class comment for why we do this immediately
+  }
   watch2.stop();
   if (::numa_available() >= 0) {
     ::numa_set_preferred(original_node);
@@ -241,6 +251,7 @@ void AlignedMemory::release_block() {
       case kNumaAllocInterleaved:
       case kNumaAllocOnnode:
       case kNumaMmapOneGbPages:
+      case kNumaReserveOnnode:
         ::munmap(block_, size_);
         break;
       default:
@@ -269,6 +280,9 @@ std::ostream& operator<<(std::ostream& o, const AlignedMemory& v) {
     case AlignedMemory::kNumaMmapOneGbPages:
       o << "kNumaMmapOneGbPages";
       break;
+    case AlignedMemory::kNumaReserveOnnode:
+      o << "kNumaReserveOnnode";
+      break;
     default:
       o << "Unknown";
   }
@@ -290,6 +304,20 @@ std::ostream& operator<<(std::ostream& o, const AlignedMemorySlice& v) {
   return o;
 }
 
+void discard_physical_memory(void* address, uint64_t size) {
+  const uintptr_t address_int = reinterpret_cast<uintptr_t>(address);
+  const uintptr_t begin = assorted::align<uintptr_t, 1U << 12>(address_int);
+  const uintptr_t end = (address_int + size) & ~static_cast<uintptr_t>((1U << 12) - 1U);
+  if (begin >= end) {
+    return;
+  }
+  if (::madvise(reinterpret_cast<void*>(begin), end - begin, MADV_DONTNEED) != 0) {
+    // not a big deal. we just keep consuming the physical memory.
+    LOG(WARNING) << "madvise(MADV_DONTNEED) failed. address=" << address << ", size=" << size
+      << ", error=" << assorted::os_error();
+  }
+}
+
 bool is_1gb_hugepage_enabled() {
   // /proc/meminfo should have "Hugepagesize:    1048576 kB"
   // Unfortunately, sysinfo() doesn't provide this information. So, just read the whole file.
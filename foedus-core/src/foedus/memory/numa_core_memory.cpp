@@ -20,7 +20,9 @@
 #include <glog/logging.h>
 
 #include <algorithm>
+#include <cstring>
 
+#include "foedus/assorted/assorted_func.hpp"
 #include "foedus/compiler.hpp"
 #include "foedus/engine.hpp"
 #include "foedus/engine_options.hpp"
@@ -67,21 +69,34 @@ uint64_t NumaCoreMemory::calculate_local_small_memory_size(const EngineOptions&
   memory_size += sizeof(xct::SysxctWorkspace);
   memory_size += sizeof(xct::PageVersionAccess) * xct::Xct::kMaxPageVersionSets;
   memory_size += sizeof(xct::PointerAccess) * xct::Xct::kMaxPointerSets;
-  const xct::XctOptions& xct_opt = options.xct_;
   const uint16_t nodes = options.thread_.group_count_;
-  memory_size += sizeof(xct::ReadXctAccess) * xct_opt.max_read_set_size_;
-  memory_size += sizeof(xct::WriteXctAccess) * xct_opt.max_write_set_size_;
-  memory_size += sizeof(xct::LockFreeReadXctAccess)
-    * xct_opt.max_lock_free_read_set_size_;
-  memory_size += sizeof(xct::LockFreeWriteXctAccess)
-    * xct_opt.max_lock_free_write_set_size_;
   memory_size += sizeof(memory::PagePoolOffsetAndEpochChunk) * nodes;
+  return memory_size;
+}
+
+namespace {
+/** Each piece in xct_access_memory_ is 4kb-aligned so that we can discard its tail. */
+uint64_t align_4kb(uint64_t value) { return assorted::align< uint64_t, (1U << 12) >(value); }
+}  // namespace
+
+uint64_t NumaCoreMemory::calculate_xct_access_memory_size(
+  const EngineOptions& options,
+  uint16_t growth_factor) {
+  const xct::XctOptions& xct_opt = options.xct_;
+  const uint64_t factor = growth_factor;
+  uint64_t memory_size = 0;
+  memory_size += align_4kb(sizeof(xct::ReadXctAccess) * xct_opt.max_read_set_size_ * factor);
+  memory_size += align_4kb(sizeof(xct::WriteXctAccess) * xct_opt.max_write_set_size_ * factor);
+  memory_size += align_4kb(sizeof(xct::LockFreeReadXctAccess)
+    * xct_opt.max_lock_free_read_set_size_ * factor);
+  memory_size += align_4kb(sizeof(xct::LockFreeWriteXctAccess)
+    * xct_opt.max_lock_free_write_set_size_ * factor);
 
   // In reality almost no chance we take as many locks as all read/write-sets,
   // but let's simplify that. Not much memory anyways.
   const uint64_t total_access_sets = xct_opt.max_read_set_size_ + xct_opt.max_write_set_size_;
-  memory_size += sizeof(xct::LockEntry) * total_access_sets;
-  memory_size += sizeof(xct::LockEntry) * total_access_sets;
+  memory_size += align_4kb(sizeof(xct::LockEntry) * total_access_sets * factor);
+  memory_size += align_4kb(sizeof(xct::LockEntry) * total_access_sets * factor);
   return memory_size;
 }
 
@@ -116,25 +131,9 @@ ErrorStack NumaCoreMemory::initialize_once() {
   memory += sizeof(xct::PageVersionAccess) * xct::Xct::kMaxPageVersionSets;
   small_thread_local_memory_pieces_.xct_pointer_access_memory_ = memory;
   memory += sizeof(xct::PointerAccess) * xct::Xct::kMaxPointerSets;
-  small_thread_local_memory_pieces_.xct_read_access_memory_ = memory;
-  memory += sizeof(xct::ReadXctAccess) * xct_opt.max_read_set_size_;
-  small_thread_local_memory_pieces_.xct_write_access_memory_ = memory;
-  memory += sizeof(xct::WriteXctAccess) * xct_opt.max_write_set_size_;
-  small_thread_local_memory_pieces_.xct_lock_free_read_access_memory_ = memory;
-  memory += sizeof(xct::LockFreeReadXctAccess) * xct_opt.max_lock_free_read_set_size_;
-  small_thread_local_memory_pieces_.xct_lock_free_write_access_memory_ = memory;
-  memory += sizeof(xct::LockFreeWriteXctAccess) * xct_opt.max_lock_free_write_set_size_;
   retired_volatile_pool_chunks_ = reinterpret_cast<PagePoolOffsetAndEpochChunk*>(memory);
   memory += sizeof(memory::PagePoolOffsetAndEpochChunk) * nodes;
 
-  const uint64_t total_access_sets = xct_opt.max_read_set_size_ + xct_opt.max_write_set_size_;
-  current_lock_list_memory_ = reinterpret_cast<xct::LockEntry*>(memory);
-  current_lock_list_capacity_ = total_access_sets;
-  memory += sizeof(xct::LockEntry) * total_access_sets;
-  retrospective_lock_list_memory_ = reinterpret_cast<xct::LockEntry*>(memory);
-  retrospective_lock_list_capacity_ = total_access_sets;
-  memory += sizeof(xct::LockEntry) * total_access_sets;
-
   memory += static_cast<uint64_t>(thread_per_group - core_local_ordinal_) << 12;
   ASSERT_ND(reinterpret_cast<char*>(small_thread_local_memory_.get_block())
     + memory_size == memory);
@@ -143,9 +142,52 @@ ErrorStack NumaCoreMemory::initialize_once() {
     retired_volatile_pool_chunks_[node].clear();
   }
 
-  CHECK_ERROR(node_memory_->allocate_numa_memory(
-    xct_opt.local_work_memory_size_mb_ * (1ULL << 20),
+  // Read/write-sets and lock lists. We reserve growth_factor times the configured sizes,
+  // but touch only the configured sizes so that usual transactions never page-fault.
+  const uint64_t growth_factor = xct_opt.work_memory_growth_factor_;
+  ASSERT_ND(growth_factor >= 1U);
+  const uint64_t access_memory_size
+    = calculate_xct_access_memory_size(engine_->get_options(), growth_factor);
+  CHECK_ERROR(node_memory_->reserve_numa_memory(access_memory_size, &xct_access_memory_));
+  memory = reinterpret_cast<char*>(xct_access_memory_.get_block());
+  small_thread_local_memory_pieces_.xct_read_access_memory_ = memory;
+  std::memset(memory, 0, sizeof(xct::ReadXctAccess) * xct_opt.max_read_set_size_);
+  memory += align_4kb(sizeof(xct::ReadXctAccess) * xct_opt.max_read_set_size_ * growth_factor);
+  small_thread_local_memory_pieces_.xct_write_access_memory_ = memory;
+  std::memset(memory, 0, sizeof(xct::WriteXctAccess) * xct_opt.max_write_set_size_);
+  memory += align_4kb(sizeof(xct::WriteXctAccess) * xct_opt.max_write_set_size_ * growth_factor);
+  small_thread_local_memory_pieces_.xct_lock_free_read_access_memory_ = memory;
+  std::memset(
+    memory,
+    0,
+    sizeof(xct::LockFreeReadXctAccess) * xct_opt.max_lock_free_read_set_size_);
+  memory += align_4kb(sizeof(xct::LockFreeReadXctAccess)
+    * xct_opt.max_lock_free_read_set_size_ * growth_factor);
+  small_thread_local_memory_pieces_.xct_lock_free_write_access_memory_ = memory;
+  std::memset(
+    memory,
+    0,
+    sizeof(xct::LockFreeWriteXctAccess) * xct_opt.max_lock_free_write_set_size_);
+  memory += align_4kb(sizeof(xct::LockFreeWriteXctAccess)
+    * xct_opt.max_lock_free_write_set_size_ * growth_factor);
+
+  const uint64_t total_access_sets = xct_opt.max_read_set_size_ + xct_opt.max_write_set_size_;
+  current_lock_list_memory_ = reinterpret_cast<xct::LockEntry*>(memory);
+  current_lock_list_capacity_ = total_access_sets * growth_factor;
+  std::memset(memory, 0, sizeof(xct::LockEntry) * total_access_sets);
+  memory += align_4kb(sizeof(xct::LockEntry) * total_access_sets * growth_factor);
+  retrospective_lock_list_memory_ = reinterpret_cast<xct::LockEntry*>(memory);
+  retrospective_lock_list_capacity_ = total_access_sets * growth_factor;
+  std::memset(memory, 0, sizeof(xct::LockEntry) * total_access_sets);
+  memory += align_4kb(sizeof(xct::LockEntry) * total_access_sets * growth_factor);
+  ASSERT_ND(reinterpret_cast<char*>(xct_access_memory_.get_block())
+    + access_memory_size == memory);
+
+  const uint64_t work_memory_size = static_cast<uint64_t>(xct_opt.local_work_memory_size_mb_) << 20;
+  CHECK_ERROR(node_memory_->reserve_numa_memory(
+    work_memory_size * growth_factor,
     &local_work_memory_));
+  std::memset(local_work_memory_.get_block(), 0, work_memory_size);
 
   // Each core starts from 50%-full free pool chunk (configurable)
   uint32_t initial_pages = engine_->get_options().memory_.private_page_pool_initial_grab_;
@@ -192,6 +234,7 @@ ErrorStack NumaCoreMemory::uninitialize_once() {
   }
   log_buffer_memory_.clear();
   local_work_memory_.release_block();
+  xct_access_memory_.release_block();
   small_thread_local_memory_.release_block();
   return SUMMARIZE_ERROR_BATCH(batch);
 }
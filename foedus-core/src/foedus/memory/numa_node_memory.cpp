@@ -72,6 +72,7 @@ ErrorStack NumaNodeMemory::initialize_once() {
   volatile_pool_.set_debug_pool_name(
     std::string("VolatilePool-")
     + std::to_string(static_cast<int>(numa_node_)));
+  volatile_pool_.set_retained(memory_repo->is_warm_restarted());
 
   // snapshot pool is SOC-local
   uint64_t snapshot_pool_bytes
@@ -188,6 +189,8 @@ ErrorStack NumaNodeMemory::uninitialize_once() {
     delete snapshot_cache_table_;
     snapshot_cache_table_ = nullptr;
   }
+  volatile_pool_.set_retained(
+    engine_->get_soc_manager()->get_shared_memory_repo()->is_retain_at_shutdown());
   batch.emprace_back(volatile_pool_.uninitialize());
   batch.emprace_back(snapshot_pool_.uninitialize());
   snapshot_pool_memory_.release_block();
@@ -217,6 +220,15 @@ ErrorStack NumaNodeMemory::allocate_numa_memory_general(
   return kRetOk;
 }
 
+ErrorStack NumaNodeMemory::reserve_numa_memory(uint64_t size, AlignedMemory *out) const {
+  ASSERT_ND(out);
+  out->alloc(size, 1 << 12, AlignedMemory::kNumaReserveOnnode, numa_node_);
+  if (out->is_null()) {
+    return ERROR_STACK(kErrorCodeOutofmemory);
+  }
+  return kRetOk;
+}
+
 std::string NumaNodeMemory::dump_free_memory_stat() const {
   std::stringstream ret;
   PagePool::Stat volatile_stat = volatile_pool_.get_stat();
@@ -120,6 +120,7 @@ storage::Page* PagePool::get_base() const { return pimpl_->pool_base_; }
 uint64_t    PagePool::get_free_pool_capacity() const { return pimpl_->get_free_pool_capacity(); }
 std::string PagePool::get_debug_pool_name() const { return pimpl_->get_debug_pool_name(); }
 void PagePool::set_debug_pool_name(const std::string& name) { pimpl_->set_debug_pool_name(name); }
+void PagePool::set_retained(bool retained) { pimpl_->retained_ = retained; }
 
 uint32_t PagePool::get_recommended_pages_per_grab() const {
   return std::min<uint32_t>(1U << 12, pimpl_->free_pool_capacity_ / 8U);
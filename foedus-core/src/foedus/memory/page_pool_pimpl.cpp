@@ -42,7 +42,8 @@ PagePoolPimpl::PagePoolPimpl()
     memory_(nullptr),
     memory_size_(0),
     owns_(false),
-    rigorous_page_boundary_check_(false) {}
+    rigorous_page_boundary_check_(false),
+    retained_(false) {}
 
 void PagePoolPimpl::attach(
   PagePoolControlBlock* control_block,
@@ -78,6 +79,14 @@ ErrorStack PagePoolPimpl::initialize_once() {
       << " - total_pages=" << pool_size_ << ", pages_for_free_pool_=" << pages_for_free_pool_
       << ", boundary_check=" << rigorous_page_boundary_check_;
     control_block_->initialize();
+    if (retained_) {
+      // warm restart. the free pool and pages in use are exactly what the previous engine left.
+      ASSERT_ND(!rigorous_page_boundary_check_);
+      LOG(INFO) << get_debug_pool_name() << " - Took over the retained free pool. free_count="
+        << get_free_pool_count() << "/" << free_pool_capacity_;
+      assert_free_pool();
+      return kRetOk;
+    }
     LOG(INFO) << get_debug_pool_name() << " - Constructing circular free pool...";
     // all pages after pages_for_free_pool_-th page is in the free pool at first
     if (!rigorous_page_boundary_check_) {
@@ -174,7 +183,10 @@ ErrorStack PagePoolPimpl::uninitialize_once() {
     }
 
     uint64_t free_count = get_free_pool_count();
-    if (free_count != free_pool_capacity_) {
+    if (retained_) {
+      LOG(INFO) << get_debug_pool_name() << " - Retaining " << (free_pool_capacity_ - free_count)
+        << " pages in use for warm restart.";
+    } else if (free_count != free_pool_capacity_) {
       // This is not a memory leak as we anyway releases everything, but it's a smell of bug.
       LOG(WARNING) << get_debug_pool_name()
         << " - Page Pool has not received back all free pages by its uninitialization!!"
@@ -154,6 +154,100 @@ ErrorStack SharedMemory::alloc(
   return kRetOk;
 }
 
+ErrorStack SharedMemory::reattach(
+  const std::string& meta_path,
+  key_t shmkey,
+  uint64_t size,
+  int numa_node,
+  bool use_hugepages) {
+  release_block();
+  if (shmkey == 0) {
+    return ERROR_STACK_MSG(kErrorCodeSocShmAttachFailed, "Dubious shmkey");
+  }
+  if (fs::exists(fs::Path(meta_path))) {
+    std::string msg = std::string("Shared memory meta file already exists:") + meta_path;
+    return ERROR_STACK_MSG(kErrorCodeSocShmAttachFailed, msg.c_str());
+  }
+
+  if (RUNNING_ON_VALGRIND) {
+    use_hugepages = false;
+  }
+  int shmid = ::shmget(shmkey, size, use_hugepages ? SHM_HUGETLB : 0);
+  if (shmid == -1) {
+    std::string msg = std::string("shmget() reattach failed! size=") + std::to_string(size)
+      + std::string(", os_error=") + assorted::os_error() + std::string(", meta_path=") + meta_path;
+    return ERROR_STACK_MSG(kErrorCodeSocShmAttachFailed, msg.c_str());
+  }
+  struct shmid_ds stat;
+  if (::shmctl(shmid, IPC_STAT, &stat) == -1 || stat.shm_segsz != size) {
+    std::string msg = std::string("Retained shared memory has an unexpected size. expected=")
+      + std::to_string(size) + std::string(", meta_path=") + meta_path;
+    return ERROR_STACK_MSG(kErrorCodeSocShmAttachFailed, msg.c_str());
+  }
+  if (stat.shm_nattch != 0) {
+    std::string msg = std::string("Retained shared memory is still attached by someone else.")
+      + std::string(" meta_path=") + meta_path;
+    return ERROR_STACK_MSG(kErrorCodeSocShmAttachFailed, msg.c_str());
+  }
+
+  char* block = reinterpret_cast<char*>(::shmat(shmid, nullptr, 0));
+  if (block == reinterpret_cast<void*>(-1)) {
+    std::string msg = std::string("shmat() reattach failed! os_error=") + assorted::os_error()
+      + std::string(", meta_path=") + meta_path;
+    return ERROR_STACK_MSG(kErrorCodeSocShmAttachFailed, msg.c_str());
+  }
+
+  // same format as alloc(). child processes attach() via this meta file.
+  std::ofstream file(meta_path, std::ofstream::binary);
+  if (!file.is_open()) {
+    ::shmdt(block);
+    std::string msg = std::string("Failed to create shared memory meta file:") + meta_path;
+    return ERROR_STACK_MSG(kErrorCodeSocShmAttachFailed, msg.c_str());
+  }
+  file.write(reinterpret_cast<char*>(&size), sizeof(size));
+  file.write(reinterpret_cast<char*>(&numa_node), sizeof(numa_node));
+  file.write(reinterpret_cast<char*>(&shmkey), sizeof(key_t));
+  file.flush();
+  file.close();
+
+  size_ = size;
+  numa_node_ = numa_node;
+  owner_pid_ = ::getpid();
+  meta_path_ = meta_path;
+  shmkey_ = shmkey;
+  shmid_ = shmid;
+  block_ = block;
+  return kRetOk;
+}
+
+void SharedMemory::detach_and_retain() {
+  if (block_ != nullptr) {
+    ASSERT_ND(is_owned());
+    int dt_ret = ::shmdt(block_);
+    if (dt_ret == -1) {
+      std::cerr << "shmdt() failed." << *this << ", error=" << assorted::os_error() << std::endl;
+    }
+    block_ = nullptr;
+    std::remove(meta_path_.c_str());
+  }
+}
+
+void SharedMemory::reclaim_retained(key_t shmkey) {
+  if (shmkey == 0) {
+    return;
+  }
+  int shmid = ::shmget(shmkey, 0, 0);
+  if (shmid == -1) {
+    return;
+  }
+  // someone (eg another engine mistakenly using the same manifest) is still using it. leave it.
+  struct shmid_ds stat;
+  if (::shmctl(shmid, IPC_STAT, &stat) == -1 || stat.shm_nattch != 0) {
+    return;
+  }
+  ::shmctl(shmid, IPC_RMID, nullptr);
+}
+
 void SharedMemory::attach(const std::string& meta_path, bool use_hugepages) {
   release_block();
   if (!fs::exists(fs::Path(meta_path))) {
@@ -211,7 +305,8 @@ void SharedMemory::attach(const std::string& meta_path, bool use_hugepages) {
 }
 
 void SharedMemory::mark_for_release() {
-  if (block_ != nullptr && shmid_ != 0) {
+  // Only the owner marks it. Otherwise a child's detach would remove a retained memory.
+  if (block_ != nullptr && shmid_ != 0 && is_owned()) {
     // Some material says that Linux allows shmget even after shmctl(IPC_RMID), but it doesn't.
     // It allows shmat() after shmctl(IPC_RMID), but not shmget().
     // So we have to invoke IPC_RMID after all child processes acked.
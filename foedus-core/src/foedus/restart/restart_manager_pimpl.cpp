@@ -30,9 +30,11 @@
 #include "foedus/savepoint/savepoint_manager.hpp"
 #include "foedus/snapshot/snapshot_manager.hpp"
 #include "foedus/snapshot/snapshot_manager_pimpl.hpp"
+#include "foedus/soc/shared_memory_repo.hpp"
 #include "foedus/soc/soc_manager.hpp"
 #include "foedus/storage/storage_log_types.hpp"
 #include "foedus/storage/storage_manager.hpp"
+#include "foedus/storage/array/array_log_types.hpp"
 #include "foedus/xct/xct_manager.hpp"
 
 namespace foedus {
@@ -64,11 +66,36 @@ ErrorStack RestartManagerPimpl::uninitialize_once() {
     // restart manager essentially has nothing to release, but because this is the first module
     // to uninit, we place "stop them first" kind of operations here.
     engine_->get_snapshot_manager()->get_pimpl()->stop_snapshot_thread();  // stop snapshot thread
+    if (soc::SharedMemoryRepo::is_warm_restart_enabled(engine_->get_options())) {
+      batch.emprace_back(prepare_warm_shutdown());
+    }
   }
   return SUMMARIZE_ERROR_BATCH(batch);
 }
 
+ErrorStack RestartManagerPimpl::prepare_warm_shutdown() {
+  // Every record in volatile pages has been committed in the current global epoch or before.
+  xct::XctManager* xct_manager = engine_->get_xct_manager();
+  Epoch current_epoch = xct_manager->get_current_global_epoch();
+  xct_manager->advance_current_global_epoch();
+  WRAP_ERROR_CODE(xct_manager->wait_for_commit(current_epoch));
+  Epoch durable_epoch = engine_->get_log_manager()->get_durable_global_epoch();
+  ASSERT_ND(durable_epoch >= current_epoch);
+  LOG(INFO) << "Retaining volatile pages for warm restart. durable_epoch=" << durable_epoch;
+  engine_->get_soc_manager()->get_shared_memory_repo()->request_retain_at_shutdown(durable_epoch);
+  return kRetOk;
+}
+
 ErrorStack RestartManagerPimpl::recover() {
+  if (engine_->get_soc_manager()->get_shared_memory_repo()->is_warm_restarted()) {
+    // Volatile pages already contain everything up to the durable epoch. Nothing to redo.
+    // Logs not yet snapshotted are picked up by the next snapshot as usual.
+    LOG(INFO) << "Warm restart. Skipped recovery. durable_epoch="
+      << engine_->get_log_manager()->get_durable_global_epoch()
+      << ", snapshot_epoch=" << engine_->get_snapshot_manager()->get_snapshot_epoch();
+    return kRetOk;
+  }
+
   Epoch durable_epoch = engine_->get_log_manager()->get_durable_global_epoch();
   Epoch snapshot_epoch = engine_->get_snapshot_manager()->get_snapshot_epoch();
   LOG(INFO) << "Recovering the database... durable_epoch=" << durable_epoch
@@ -169,6 +196,12 @@ ErrorStack RestartManagerPimpl::redo_meta_logs(Epoch durable_epoch, Epoch snapsh
           entry->header_.storage_id_);
         ++processed;
         break;
+      case log::kLogCodeArrayExtend:
+        reinterpret_cast<storage::array::ArrayExtendLogType*>(entry)->apply_storage(
+          engine_,
+          entry->header_.storage_id_);
+        ++processed;
+        break;
       default:
         LOG(ERROR) << "Unexpected log type in metadata log:" << entry->header_;
     }
@@ -20,14 +20,22 @@
 namespace foedus {
 namespace restart {
 RestartOptions::RestartOptions() {
+  enable_warm_restart_ = false;
+  warm_restart_manifest_path_ = "shared_memory_manifest.bin";
 }
 
-ErrorStack RestartOptions::load(tinyxml2::XMLElement* /*element*/) {
+ErrorStack RestartOptions::load(tinyxml2::XMLElement* element) {
+  EXTERNALIZE_LOAD_ELEMENT(element, enable_warm_restart_);
+  EXTERNALIZE_LOAD_ELEMENT(element, warm_restart_manifest_path_);
   return kRetOk;
 }
 
 ErrorStack RestartOptions::save(tinyxml2::XMLElement* element) const {
   CHECK_ERROR(insert_comment(element, "Set of options for restart manager"));
+  EXTERNALIZE_SAVE_ELEMENT(element, enable_warm_restart_,
+    "Whether to retain shared memories at clean shutdown and re-attach them on startup.");
+  EXTERNALIZE_SAVE_ELEMENT(element, warm_restart_manifest_path_,
+    "Full path of the manifest file that describes the retained shared memories.");
   return kRetOk;
 }
 
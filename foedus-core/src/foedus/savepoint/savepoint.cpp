@@ -45,6 +45,15 @@ ErrorStack Savepoint::load(tinyxml2::XMLElement* element) {
   EXTERNALIZE_LOAD_ELEMENT(element, oldest_log_files_offset_begin_);
   EXTERNALIZE_LOAD_ELEMENT(element, current_log_files_);
   EXTERNALIZE_LOAD_ELEMENT(element, current_log_files_offset_durable_);
+  // savepoint files written by older versions don't have them. No way to tell, so we assume
+  // there is no log to read before the current position, which was the old behavior.
+  CHECK_ERROR(get_element(element, "snapshot_log_files_", &snapshot_log_files_, true));
+  CHECK_ERROR(get_element(
+    element, "snapshot_log_files_offset_", &snapshot_log_files_offset_, true));
+  if (snapshot_log_files_.empty() && snapshot_log_files_offset_.empty()) {
+    snapshot_log_files_ = current_log_files_;
+    snapshot_log_files_offset_ = current_log_files_offset_durable_;
+  }
   assert_epoch_values();
   return kRetOk;
 }
@@ -73,6 +82,10 @@ ErrorStack Savepoint::save(tinyxml2::XMLElement* element) const {
                "Indicates the log file each logger is currently appending to");
   EXTERNALIZE_SAVE_ELEMENT(element, current_log_files_offset_durable_,
             "Indicates the exclusive end of durable region in the current log file");
+  EXTERNALIZE_SAVE_ELEMENT(element, snapshot_log_files_,
+    "The log file that contains the first log entry after latest_snapshot_epoch_");
+  EXTERNALIZE_SAVE_ELEMENT(element, snapshot_log_files_offset_,
+    "Offset in snapshot_log_files_ where the logs after latest_snapshot_epoch_ begin");
   return kRetOk;
 }
 
@@ -88,6 +101,8 @@ void Savepoint::populate_empty(log::LoggerId logger_count) {
   oldest_log_files_offset_begin_.resize(logger_count, 0);
   current_log_files_.resize(logger_count, 0);
   current_log_files_offset_durable_.resize(logger_count, 0);
+  snapshot_log_files_.resize(logger_count, 0);
+  snapshot_log_files_offset_.resize(logger_count, 0);
   assert_epoch_values();
 }
 
@@ -110,6 +125,8 @@ void FixedSavepoint::update(
     logger_info_[i].oldest_log_file_offset_begin_ = src.oldest_log_files_offset_begin_[i];
     logger_info_[i].current_log_file_ = src.current_log_files_[i];
     logger_info_[i].current_log_file_offset_durable_ = src.current_log_files_offset_durable_[i];
+    logger_info_[i].snapshot_log_file_ = src.snapshot_log_files_[i];
+    logger_info_[i].snapshot_log_file_offset_ = src.snapshot_log_files_offset_[i];
   }
 }
 
@@ -183,9 +183,18 @@ void SavepointManagerPimpl::savepoint_main() {
         new_savepoint.latest_snapshot_epoch_ = control_block_->new_snapshot_epoch_;
         control_block_->new_snapshot_id_ = snapshot::kNullSnapshotId;
         control_block_->new_snapshot_epoch_ = Epoch::kEpochInvalid;
+        engine_->get_log_manager()->copy_logger_snapshot_positions(
+          Epoch(new_savepoint.latest_snapshot_epoch_),
+          &new_savepoint);
       } else {
         new_savepoint.latest_snapshot_id_ = control_block_->savepoint_.latest_snapshot_id_;
         new_savepoint.latest_snapshot_epoch_ = control_block_->savepoint_.latest_snapshot_epoch_;
+        const uint32_t logger_count = control_block_->savepoint_.get_total_logger_count();
+        for (uint32_t i = 0; i < logger_count; ++i) {
+          const LoggerSavepointInfo& info = control_block_->savepoint_.logger_info_[i];
+          new_savepoint.snapshot_log_files_.push_back(info.snapshot_log_file_);
+          new_savepoint.snapshot_log_files_offset_.push_back(info.snapshot_log_file_offset_);
+        }
       }
 
       log::MetaLogControlBlock* metalog_block = engine_->get_soc_manager()->get_shared_memory_repo()
@@ -119,5 +119,25 @@ ErrorCode DumpFileSortedBuffer::wind(uint64_t next_absolute_pos) {
   return kErrorCodeOk;
 }
 
+ErrorCode DumpFileSortedBuffer::skip(uint64_t next_absolute_pos) {
+  ASSERT_ND(next_absolute_pos <= total_size_);
+  ASSERT_ND(next_absolute_pos >= offset_);
+  if (next_absolute_pos <= offset_ + buffer_size_) {
+    return wind(next_absolute_pos);
+  }
+
+  // jumps over more than one buffer. we don't need the bytes in between, so just seek.
+  uint64_t new_offset = next_absolute_pos - (next_absolute_pos % kAlignment);
+  uint64_t desired_reads = std::min(buffer_size_, total_size_ - new_offset);
+  CHECK_ERROR_CODE(file_->seek(new_offset, fs::DirectIoFile::kDirectIoSeekSet));
+  memory::AlignedMemorySlice sub_slice(io_buffer_, 0, desired_reads);
+  CHECK_ERROR_CODE(file_->read(desired_reads, sub_slice));
+  offset_ = new_offset;
+
+  ASSERT_ND(offset_ % kAlignment == 0);
+  ASSERT_ND(next_absolute_pos >= offset_);
+  return kErrorCodeOk;
+}
+
 }  // namespace snapshot
 }  // namespace foedus
@@ -52,10 +52,12 @@ namespace snapshot {
 LogGleaner::LogGleaner(
   Engine* engine,
   LogGleanerResource* gleaner_resource,
-  const Snapshot& new_snapshot)
+  const Snapshot& new_snapshot,
+  bool pregleaning)
   : LogGleanerRef(engine),
     gleaner_resource_(gleaner_resource),
-    new_snapshot_(new_snapshot) {
+    new_snapshot_(new_snapshot),
+    pregleaning_(pregleaning) {
 }
 
 ErrorStack LogGleaner::cancel_reducers_mappers() {
@@ -79,16 +81,28 @@ ErrorStack LogGleaner::cancel_reducers_mappers() {
 void LogGleaner::clear_all() {
   control_block_->clear_counts();
   control_block_->cur_snapshot_ = new_snapshot_;
+  control_block_->pregleaning_ = pregleaning_;
   uint16_t node_count = engine_->get_options().thread_.group_count_;
   for (uint16_t node = 0; node < node_count; ++node) {
     LogReducerRef reducer(engine_, node);
     reducer.clear();
   }
-  partitioner_metadata_[0].data_offset_ = 0;
   ASSERT_ND(partitioner_metadata_[0].data_size_
     == engine_->get_options().storage_.partitioner_data_memory_mb_ * (1ULL << 20));
-  for (storage::StorageId i = 1; i <= new_snapshot_.max_storage_id_; ++i) {
-    partitioner_metadata_[i].clear_counts();
+  if (get_pregleaned_epoch().is_valid()) {
+    // The pre-gleaned sorted runs are partitioned with the current partitions. Keep using them.
+    // Only storages created since then need new partitions.
+    LOG(INFO) << "Keeping partitions for logs pre-gleaned until " << get_pregleaned_epoch();
+    for (storage::StorageId i = 1; i <= new_snapshot_.max_storage_id_; ++i) {
+      if (!partitioner_metadata_[i].valid_) {
+        partitioner_metadata_[i].clear_counts();
+      }
+    }
+  } else {
+    partitioner_metadata_[0].data_offset_ = 0;
+    for (storage::StorageId i = 1; i <= new_snapshot_.max_storage_id_; ++i) {
+      partitioner_metadata_[i].clear_counts();
+    }
   }
 }
 
@@ -127,6 +141,10 @@ void LogGleaner::design_partitions_run(
       continue;
     }
     storage::Partitioner partitioner(engine_, id);
+    if (partitioner.is_valid()) {
+      ASSERT_ND(get_pregleaned_epoch().is_valid());  // kept by clear_all()
+      continue;
+    }
     storage::Partitioner::DesignPartitionArguments args = { &work_memory, &fileset };
     ErrorStack ret = partitioner.design_partition(args);
     if (ret.is_error()) {
@@ -146,7 +164,8 @@ void LogGleaner::design_partitions_run(
 }
 
 ErrorStack LogGleaner::execute() {
-  LOG(INFO) << "Gleaner starts running: snapshot_id=" << get_snapshot_id();
+  LOG(INFO) << "Gleaner starts running: snapshot_id=" << get_snapshot_id()
+    << (pregleaning_ ? " (pre-gleaning)" : "");
   clear_all();
 
   LOG(INFO) << "Gleaner Step 1: Design partitions for all storages...";
@@ -162,6 +181,7 @@ ErrorStack LogGleaner::execute() {
   LOG(INFO) << "Gleaner Step 2: Run mappers/reducers...";
   debugging::StopWatch watch2;
   // Request each node's snapshot manager to launch mappers/reducers threads
+  ++control_block_->round_;
   control_block_->gleaning_ = true;
   engine_->get_soc_manager()->get_shared_memory_repo()->get_global_memory_anchors()->
     snapshot_manager_memory_->wakeup_snapshot_children();
@@ -177,6 +197,21 @@ ErrorStack LogGleaner::execute() {
   watch2.stop();
   LOG(INFO) << "Gleaner Step 2: Ended in " << watch2.elapsed_sec() << "s";
 
+  if (pregleaning_) {
+    if (!is_error() && is_all_completed()) {
+      control_block_->pregleaned_epoch_ = new_snapshot_.valid_until_epoch_;
+      LOG(INFO) << "Pre-gleaned logs until " << get_pregleaned_epoch() << ". " << *this;
+    } else {
+      LOG(WARNING) << "Pre-gleaning stopped without completion. Discarded sorted runs." << *this;
+      control_block_->discard_pregleaned();
+    }
+    CHECK_ERROR(cancel_reducers_mappers());
+    ASSERT_ND(is_error() || is_all_exitted());
+    return kRetOk;
+  }
+  // whether successful or not, the sorted runs are consumed by this snapshot
+  control_block_->discard_pregleaned();
+
   LOG(INFO) << "Gleaner Step 3: Combine outputs from reducers (root page info)..." << *this;
   debugging::StopWatch watch3;
   if (is_error()) {
@@ -312,6 +347,8 @@ std::string LogGleaner::to_string() const {
 std::ostream& operator<<(std::ostream& o, const LogGleaner& v) {
   o << "<LogGleaner>"
     << v.new_snapshot_
+    << "<pregleaning_>" << v.pregleaning_ << "</pregleaning_>"
+    << "<pregleaned_epoch_>" << v.get_pregleaned_epoch() << "</pregleaned_epoch_>"
     << "<completed_count_>" << v.control_block_->completed_count_ << "</completed_count_>"
     << "<completed_mapper_count_>"
       << v.control_block_->completed_mapper_count_ << "</completed_mapper_count_>"
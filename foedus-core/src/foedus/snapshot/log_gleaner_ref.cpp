@@ -76,6 +76,12 @@ const Snapshot& LogGleanerRef::get_cur_snapshot() const { return control_block_-
 SnapshotId LogGleanerRef::get_snapshot_id() const { return get_cur_snapshot().id_; }
 Epoch LogGleanerRef::get_base_epoch() const { return get_cur_snapshot().base_epoch_; }
 Epoch LogGleanerRef::get_valid_until_epoch() const { return get_cur_snapshot().valid_until_epoch_; }
+bool LogGleanerRef::is_pregleaning() const { return control_block_->pregleaning_; }
+Epoch LogGleanerRef::get_pregleaned_epoch() const { return control_block_->pregleaned_epoch_; }
+Epoch LogGleanerRef::get_mapper_from_epoch() const {
+  Epoch pregleaned_epoch = get_pregleaned_epoch();
+  return pregleaned_epoch.is_valid() ? pregleaned_epoch : get_base_epoch();
+}
 
 
 }  // namespace snapshot
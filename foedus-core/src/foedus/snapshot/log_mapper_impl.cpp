@@ -30,11 +30,11 @@
 #include "foedus/error_stack_batch.hpp"
 #include "foedus/assorted/assorted_func.hpp"
 #include "foedus/debugging/stop_watch.hpp"
-#include "foedus/fs/direct_io_file.hpp"
 #include "foedus/fs/filesystem.hpp"
 #include "foedus/log/log_manager.hpp"
 #include "foedus/log/log_type.hpp"
 #include "foedus/log/logger_impl.hpp"
+#include "foedus/log/striped_log_file.hpp"
 #include "foedus/memory/memory_id.hpp"
 #include "foedus/snapshot/log_gleaner_impl.hpp"
 #include "foedus/snapshot/log_reducer_impl.hpp"
@@ -138,7 +138,8 @@ uint64_t align_io_floor(uint64_t offset) { return (offset / kIoAlignment) * kIoA
 uint64_t align_io_ceil(uint64_t offset) { return align_io_floor(offset + kIoAlignment - 1U); }
 
 ErrorStack LogMapper::handle_process() {
-  const Epoch base_epoch = parent_.get_base_epoch();
+  // logs up to the pre-gleaned epoch, if any, are already in reducers' sorted runs
+  const Epoch base_epoch = parent_.get_mapper_from_epoch();
   const Epoch until_epoch = parent_.get_valid_until_epoch();
   log::LoggerRef logger = engine_->get_log_manager()->get_logger(id_);
   const log::LogRange log_range = logger.get_log_range(base_epoch, until_epoch);
@@ -164,11 +165,15 @@ ErrorStack LogMapper::handle_process() {
   status.first_read_ = true;
   debugging::StopWatch watch;
   while (!status.ended_) {  // loop for log file switch
-    fs::Path path(engine_->get_options().log_.construct_suffixed_log_path(
+    // the log file might be striped across devices. StripedLogFile reassembles it.
+    log::StripedLogFile file(
+      engine_->get_options().log_,
       numa_node_,
       id_,
-      status.cur_file_ordinal_));
-    uint64_t file_size = fs::file_size(path);
+      status.cur_file_ordinal_,
+      engine_->get_options().snapshot_.emulation_);
+    fs::Path path(file.get_path());
+    uint64_t file_size = file.get_size();
     if (file_size % kIoAlignment != 0) {
       LOG(WARNING) << to_string() << " Interesting, non-aligned file size, which probably means"
         << " previous writes didn't flush. file path=" << path << ", file size=" << file_size;
@@ -194,20 +199,21 @@ ErrorStack LogMapper::handle_process() {
 
     DVLOG(1) << to_string() << " file path=" << path << ", file size=" << assorted::Hex(file_size)
       << ", read_end=" << assorted::Hex(status.end_infile_);
-    fs::DirectIoFile file(path, engine_->get_options().snapshot_.emulation_);
-    WRAP_ERROR_CODE(file.open(true, false, false, false));
+    WRAP_ERROR_CODE(file.open());
     DVLOG(1) << to_string() << "opened log file " << file;
 
     while (true) {
       WRAP_ERROR_CODE(check_cancelled());  // check per each read
       status.buf_infile_aligned_ = align_io_floor(status.next_infile_);
-      WRAP_ERROR_CODE(file.seek(status.buf_infile_aligned_, fs::DirectIoFile::kDirectIoSeekSet));
-      DVLOG(1) << to_string() << " seeked to: " << assorted::Hex(status.buf_infile_aligned_);
+      DVLOG(1) << to_string() << " reading from: " << assorted::Hex(status.buf_infile_aligned_);
       status.end_inbuf_aligned_ = std::min(
         io_buffer_.get_size(),
         align_io_ceil(status.end_infile_ - status.buf_infile_aligned_));
       ASSERT_ND(status.end_inbuf_aligned_ % kIoAlignment == 0);
-      WRAP_ERROR_CODE(file.read(status.end_inbuf_aligned_, &io_buffer_));
+      WRAP_ERROR_CODE(file.read(
+        status.buf_infile_aligned_,
+        status.end_inbuf_aligned_,
+        io_buffer_.get_block()));
 
       status.cur_inbuf_ = 0;
       if (status.next_infile_ != status.buf_infile_aligned_) {
@@ -248,8 +254,10 @@ void LogMapper::report_completion(double elapsed_sec) {
   }
 }
 
-ErrorStack LogMapper::handle_process_buffer(const fs::DirectIoFile &file, IoBufStatus* status) {
-  const Epoch base_epoch = parent_.get_base_epoch();  // only for assertions
+ErrorStack LogMapper::handle_process_buffer(
+  const log::StripedLogFile &file,
+  IoBufStatus* status) {
+  const Epoch base_epoch = parent_.get_mapper_from_epoch();  // only for assertions
   const Epoch until_epoch = parent_.get_valid_until_epoch();  // only for assertions
 
   // many temporary memory are used only within this method and completely cleared out
@@ -24,6 +24,7 @@
 #include <map>
 #include <ostream>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -45,6 +46,7 @@
 #include "foedus/soc/soc_manager.hpp"
 #include "foedus/storage/composer.hpp"
 #include "foedus/storage/partitioner.hpp"
+#include "foedus/storage/storage_id.hpp"
 
 namespace foedus {
 namespace snapshot {
@@ -52,7 +54,8 @@ namespace snapshot {
 LogReducer::LogReducer(Engine* engine)
 : MapReduceBase(engine, engine->get_soc_id()),
   previous_snapshot_files_(engine_),
-  sorted_runs_(0) {
+  sorted_runs_(0),
+  carried_runs_(0) {
   soc::NodeMemoryAnchors* anchors = engine->get_soc_manager()->get_shared_memory_repo()->
     get_node_memory_anchors(numa_node_);
   control_block_ = anchors->log_reducer_memory_;
@@ -114,6 +117,7 @@ ErrorStack LogReducer::initialize_once() {
     numa_node_),
 
   sorted_runs_ = 0;
+  carried_runs_ = 0;
 
   CHECK_ERROR(previous_snapshot_files_.initialize());
   return kRetOk;
@@ -132,6 +136,21 @@ ErrorStack LogReducer::uninitialize_once() {
 }
 
 ErrorStack LogReducer::handle_process() {
+  sorted_runs_ = 0;
+  if (!parent_.get_pregleaned_epoch().is_valid()) {
+    // a new snapshot, or the sorted runs pre-gleaned so far were discarded
+    carried_runs_ = 0;
+  }
+  if (dump_io_buffer_.is_null()) {
+    // merge_sort() of the previous snapshot released it
+    dump_io_buffer_.alloc(
+      static_cast<uint64_t>(engine_->get_options().snapshot_.log_reducer_dump_io_buffer_mb_) << 20,
+      memory::kHugepageSize,
+      memory::AlignedMemory::kNumaAllocOnnode,
+      get_numa_node());
+    ASSERT_ND(!dump_io_buffer_.is_null());
+  }
+
   while (true) {
     std::this_thread::sleep_for(std::chrono::milliseconds(10));
     WRAP_ERROR_CODE(check_cancelled());
@@ -157,10 +176,17 @@ ErrorStack LogReducer::handle_process() {
     }
   }
 
-  LOG(INFO) << to_string() << " all mappers are done, this reducer starts the merge-sort phase.";
   ASSERT_ND(parent_.is_all_mappers_completed());
   WRAP_ERROR_CODE(check_cancelled());
-  CHECK_ERROR(merge_sort());
+  if (parent_.is_pregleaning()) {
+    LOG(INFO) << to_string() << " all mappers are done, this reducer keeps the sorted runs.";
+    CHECK_ERROR(dump_last_buffer());
+    carried_runs_ += sorted_runs_;
+    sorted_runs_ = 0;
+  } else {
+    LOG(INFO) << to_string() << " all mappers are done, this reducer starts the merge-sort phase.";
+    CHECK_ERROR(merge_sort());
+  }
 
   LOG(INFO) << to_string() << " all done.";
   return kRetOk;
@@ -187,8 +213,11 @@ ErrorStack LogReducer::dump_buffer() {
   std::map<storage::StorageId, std::vector<BufferPosition> > blocks;
   dump_buffer_scan_block_headers(base, final_status.components.tail_position_, &blocks);
 
-  // open a file
-  fs::Path path = get_sorted_run_file_path(sorted_runs_);
+  // open a file. remove a leftover from a failed or discarded attempt, if any
+  fs::Path path = get_sorted_run_file_path(carried_runs_ + sorted_runs_);
+  if (fs::exists(path)) {
+    fs::remove(path);
+  }
   fs::DirectIoFile file(path);
   WRAP_ERROR_CODE(file.open(false, true, true, true));
   LOG(INFO) << to_string() << " Created a sorted run file " << path;
@@ -239,6 +268,26 @@ ErrorStack LogReducer::dump_buffer() {
   return kRetOk;
 }
 
+ErrorStack LogReducer::dump_last_buffer() {
+  ASSERT_ND(parent_.is_all_mappers_completed());
+  ASSERT_ND(sorted_runs_ == control_block_->current_buffer_);
+  ReducerBufferStatus cur_status = control_block_->get_current_buffer_status();
+  if (cur_status.get_tail_bytes() == 0) {
+    LOG(INFO) << to_string() << " has nothing in the last buffer.";
+    return kRetOk;
+  }
+
+  // no mapper writes to the buffer any more. close it and switch, just like a full buffer
+  ReducerBufferStatus new_status = cur_status;
+  new_status.components.flags_ |= kFlagNoMoreWriters;
+  control_block_->get_buffer_status_address(control_block_->current_buffer_)->store(
+    new_status.word);
+  control_block_->current_buffer_.fetch_add(1U);
+  CHECK_ERROR(dump_buffer());
+  ASSERT_ND(sorted_runs_ == control_block_->current_buffer_);
+  return kRetOk;
+}
+
 ErrorStack LogReducer::dump_buffer_wait_for_writers(uint32_t buffer_index) const {
   debugging::StopWatch wait_watch;
   SPINLOCK_WHILE(control_block_->get_buffer_status_atomic(buffer_index).get_active_writers() > 0) {
@@ -577,28 +626,110 @@ ErrorStack LogReducer::merge_sort() {
   merge_sort_check_buffer_status();
   CHECK_ERROR(merge_sort_dump_last_buffer());
 
-  // The writer to writes out composed snapshot pages to a new snapshot file.
-  // we use it only during merge_sort().
-  SnapshotWriter snapshot_writer(
-    engine_,
-    numa_node_,
-    parent_.get_snapshot_id(),
-    &writer_pool_memory_,
-    &writer_intermediate_memory_);
-  CHECK_ERROR(snapshot_writer.open());
-
   // because now we are at the last merging phase, we will no longer dump sorted runs any more.
   // thus, we release the reducer's dump IO buffer to reduce memory pressure.
   dump_io_buffer_.release_block();
 
-  MergeContext context(sorted_runs_);
-  LOG(INFO) << to_string() << " merge sorting " << sorted_runs_ << " sorted runs and the current"
+  const uint32_t dumped_files_count = carried_runs_ + sorted_runs_;
+  const uint16_t composers = engine_->get_options().snapshot_.log_reducer_composers_;
+  ASSERT_ND(composers > 0 && composers <= storage::kMaxSnapshotShards);
+  LOG(INFO) << to_string() << " merge sorting " << carried_runs_ << " pre-gleaned and "
+    << sorted_runs_ << " sorted runs and the current"
     << " buffer which has "
     << 8ULL * control_block_->get_current_buffer_status().get_tail_position()
-    << " bytes";
+    << " bytes with " << composers << " composer threads";
   debugging::StopWatch merge_watch;
 
-  // prepare the input streams for composers
+  // Composer threads take storages one by one in this order. See merge_sort_compose().
+  std::atomic<uint32_t> next_ordinal(0);
+  std::vector<uint32_t> storage_counts(composers, 0);
+  std::vector<ErrorStack> results(composers);
+  std::vector<std::thread> threads;
+  for (uint16_t shard = 1; shard < composers; ++shard) {
+    // spawned threads inherit the CPU affinity and memory policy of this thread (the node)
+    threads.emplace_back([this, shard, dumped_files_count, &next_ordinal, &storage_counts,
+        &results]() {
+      results[shard] = merge_sort_compose(
+        shard,
+        dumped_files_count,
+        &next_ordinal,
+        &storage_counts[shard]);
+    });
+  }
+  results[0] = merge_sort_compose(0, dumped_files_count, &next_ordinal, &storage_counts[0]);
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (const ErrorStack& result : results) {
+    CHECK_ERROR(result);
+  }
+
+  // every composer thread went through all storages
+  for (uint16_t shard = 1; shard < composers; ++shard) {
+    ASSERT_ND(storage_counts[shard] == storage_counts[0]);
+  }
+  control_block_->total_storage_count_ = storage_counts[0];
+  ASSERT_ND(control_block_->total_storage_count_ <= get_max_storage_count());
+
+  // the sorted runs are no longer needed
+  for (uint32_t sorted_run = 0; sorted_run < dumped_files_count; ++sorted_run) {
+    fs::remove(get_sorted_run_file_path(sorted_run));
+  }
+  carried_runs_ = 0;
+  merge_watch.stop();
+  LOG(INFO) << to_string() << " completed merging in " << merge_watch.elapsed_sec() << " seconds"
+    << " . total_storage_count_=" << control_block_->total_storage_count_;
+  return kRetOk;
+}
+
+ErrorStack LogReducer::merge_sort_compose(
+  uint8_t shard,
+  uint32_t dumped_files_count,
+  std::atomic<uint32_t>* next_ordinal,
+  uint32_t* storage_count) {
+  *storage_count = 0;
+  // the first composer uses the reducer's own resources. others allocate their own.
+  memory::AlignedMemory own_pool_memory;
+  memory::AlignedMemory own_intermediate_memory;
+  cache::SnapshotFileSet own_snapshot_files(engine_);
+  memory::AlignedMemory* pool_memory = &writer_pool_memory_;
+  memory::AlignedMemory* intermediate_memory = &writer_intermediate_memory_;
+  cache::SnapshotFileSet* snapshot_files = &previous_snapshot_files_;
+  if (shard > 0) {
+    own_pool_memory.alloc(
+      writer_pool_memory_.get_size(),
+      memory::kHugepageSize,
+      memory::AlignedMemory::kNumaAllocOnnode,
+      numa_node_);
+    own_intermediate_memory.alloc(
+      writer_intermediate_memory_.get_size(),
+      memory::kHugepageSize,
+      memory::AlignedMemory::kNumaAllocOnnode,
+      numa_node_);
+    CHECK_ERROR(own_snapshot_files.initialize());
+    pool_memory = &own_pool_memory;
+    intermediate_memory = &own_intermediate_memory;
+    snapshot_files = &own_snapshot_files;
+  }
+  UninitializeGuard files_guard(&own_snapshot_files, UninitializeGuard::kWarnIfUninitializeError);
+
+  // The writer to writes out composed snapshot pages to this composer's shard of the snapshot
+  // file. The first shard is always created because the gleaner appends root pages to it.
+  // Other shards are created only when they have something to write.
+  SnapshotWriter snapshot_writer(
+    engine_,
+    numa_node_,
+    parent_.get_snapshot_id(),
+    pool_memory,
+    intermediate_memory,
+    false,
+    shard);
+  if (shard == 0) {
+    CHECK_ERROR(snapshot_writer.open());
+  }
+
+  // each composer thread has its own input streams because they are not thread-safe
+  MergeContext context(dumped_files_count);
   merge_sort_allocate_io_buffers(&context);
   CHECK_ERROR(merge_sort_open_sorted_runs(&context));
   CHECK_ERROR(merge_sort_initialize_sort_buffers(&context));
@@ -611,30 +742,44 @@ ErrorStack LogReducer::merge_sort() {
     memory::AlignedMemory::kNumaAllocOnnode,
     numa_node_);
 
-  // merge-sort each storage
+  // All composer threads see the same sequence of storages, so the ordinal of a storage
+  // in the sequence identifies it. Each thread takes the next ordinal nobody has taken,
+  // composes that storage, and skips storages taken by others. The ordinal is also the
+  // index of the root-info page of the storage, so the output is same as serial composing.
+  uint32_t my_ordinal = next_ordinal->fetch_add(1U);
+  uint32_t ordinal = 0;
   storage::StorageId prev_storage_id = 0;
-  control_block_->total_storage_count_ = 0;
   for (storage::StorageId storage_id = context.get_min_storage_id();
         storage_id > 0;
-        storage_id = context.get_min_storage_id(), ++control_block_->total_storage_count_) {
+        storage_id = context.get_min_storage_id(), ++ordinal) {
     if (storage_id <= prev_storage_id) {
       LOG(FATAL) << to_string() << " wtf. not storage sorted? " << *this;
     }
     prev_storage_id = storage_id;
 
+    if (ordinal != my_ordinal) {
+      for (auto& ptr : context.sorted_buffers_) {
+        WRAP_ERROR_CODE(merge_sort_skip_sort_buffers(ptr.get(), storage_id));
+        WRAP_ERROR_CODE(merge_sort_advance_sort_buffers(ptr.get(), storage_id));
+      }
+      continue;
+    }
+
     // collect streams for this storage
-    VLOG(0) << to_string() << " merging storage-" << storage_id << ", num="
-      << control_block_->total_storage_count_;
+    VLOG(0) << to_string() << " composer-" << static_cast<int>(shard) << " merging storage-"
+      << storage_id << ", num=" << ordinal;
     context.set_tmp_sorted_buffer_array(storage_id);
+    if (!snapshot_writer.is_opened()) {
+      CHECK_ERROR(snapshot_writer.open());
+    }
 
     // run composer
     storage::Composer composer(engine_, storage_id);
-    // snapshot_reader_.get_or_open_file();
-    ASSERT_ND(control_block_->total_storage_count_ <= get_max_storage_count());
-    storage::Page* root_info_page = root_info_pages_ + control_block_->total_storage_count_;
+    ASSERT_ND(ordinal < get_max_storage_count());
+    storage::Page* root_info_page = root_info_pages_ + ordinal;
     storage::Composer::ComposeArguments args = {
       &snapshot_writer,
-      &previous_snapshot_files_,
+      snapshot_files,
       context.tmp_sorted_buffer_array_,
       context.tmp_sorted_buffer_count_,
       &composer_work_memory,
@@ -647,17 +792,14 @@ ErrorStack LogReducer::merge_sort() {
       SortedBuffer *buffer = ptr.get();
       WRAP_ERROR_CODE(merge_sort_advance_sort_buffers(buffer, storage_id));
     }
+    my_ordinal = next_ordinal->fetch_add(1U);
   }
-  ASSERT_ND(control_block_->total_storage_count_ <= get_max_storage_count());
 
+  *storage_count = ordinal;
   snapshot_writer.close();
-  merge_watch.stop();
-  LOG(INFO) << to_string() << " completed merging in " << merge_watch.elapsed_sec() << " seconds"
-    << " . total_storage_count_=" << control_block_->total_storage_count_;
   return kRetOk;
 }
 
-
 void LogReducer::merge_sort_check_buffer_status() const {
   ASSERT_ND(sorted_runs_ == control_block_->current_buffer_);
   ASSERT_ND(control_block_->get_current_buffer_status().get_tail_bytes()
@@ -776,7 +918,7 @@ ErrorStack LogReducer::merge_sort_open_sorted_runs(LogReducer::MergeContext* con
     from_buffer_position(buffer_status.components.tail_position_)));
 
   // sorted run files
-  ASSERT_ND(context->io_buffers_.size() == sorted_runs_);
+  ASSERT_ND(context->io_buffers_.size() == context->dumped_files_count_);
   for (uint32_t sorted_run = 0 ; sorted_run < context->dumped_files_count_; ++sorted_run) {
     fs::Path path = get_sorted_run_file_path(sorted_run);
     if (!fs::exists(path)) {
@@ -843,6 +985,22 @@ ErrorStack LogReducer::merge_sort_initialize_sort_buffers(LogReducer::MergeConte
 }
 
 
+ErrorCode LogReducer::merge_sort_skip_sort_buffers(
+  SortedBuffer* buffer,
+  storage::StorageId skipped_storage_id) const {
+  if (buffer->get_cur_block_storage_id() != skipped_storage_id) {
+    return kErrorCodeOk;
+  }
+  // merge_sort_advance_sort_buffers() needs the next block header in the window
+  uint64_t next_block_header_pos = buffer->get_cur_block_abosulte_end();
+  if (next_block_header_pos < buffer->get_total_size()
+    && next_block_header_pos + sizeof(FullBlockHeader)
+      > buffer->get_offset() + buffer->get_buffer_size()) {
+    CHECK_ERROR_CODE(buffer->skip(next_block_header_pos));
+  }
+  return kErrorCodeOk;
+}
+
 ErrorCode LogReducer::merge_sort_advance_sort_buffers(
   SortedBuffer* buffer,
   storage::StorageId processed_storage_id) const {
@@ -918,6 +1076,7 @@ std::ostream& operator<<(std::ostream& o, const LogReducer& v) {
     << "<positions_buffers_>" << v.positions_buffers_ << "</positions_buffers_>"
     << "<current_buffer_>" << v.control_block_->current_buffer_ << "</current_buffer_>"
     << "<sorted_runs_>" << v.sorted_runs_ << "</sorted_runs_>"
+    << "<carried_runs_>" << v.carried_runs_ << "</carried_runs_>"
     << "</LogReducer>";
   return o;
 }
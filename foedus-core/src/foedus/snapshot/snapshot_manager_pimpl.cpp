@@ -48,6 +48,7 @@
 #include "foedus/storage/composer.hpp"
 #include "foedus/storage/metadata.hpp"
 #include "foedus/storage/partitioner.hpp"
+#include "foedus/storage/storage_id.hpp"
 #include "foedus/storage/storage_manager.hpp"
 #include "foedus/thread/numa_thread_scope.hpp"
 #include "foedus/xct/xct_manager.hpp"
@@ -63,6 +64,10 @@ ErrorStack SnapshotManagerPimpl::initialize_once() {
   if (!engine_->get_log_manager()->is_initialized()) {
     return ERROR_STACK(kErrorCodeDepedentModuleUnavailableInit);
   }
+  const uint16_t composers = engine_->get_options().snapshot_.log_reducer_composers_;
+  if (composers == 0 || composers > storage::kMaxSnapshotShards) {
+    return ERROR_STACK_MSG(kErrorCodeConfValueOutofrange, "log_reducer_composers_");
+  }
   soc::SharedMemoryRepo* repo = engine_->get_soc_manager()->get_shared_memory_repo();
   control_block_ = repo->get_global_memory_anchors()->snapshot_manager_memory_;
   if (engine_->is_master()) {
@@ -103,6 +108,7 @@ ErrorStack SnapshotManagerPimpl::initialize_once() {
 
   // in child engines, we instantiate local mappers/reducer objects (but not the threads yet)
   previous_snapshot_time_ = std::chrono::system_clock::now();
+  previous_pregleaning_time_ = previous_snapshot_time_;
   stop_requested_ = false;
   if (!engine_->is_master()) {
     local_reducer_ = new LogReducer(engine_);
@@ -228,6 +234,13 @@ void SnapshotManagerPimpl::handle_snapshot() {
       if (stack.is_error()) {
         LOG(ERROR) << "Snapshot failed:" << stack;
       }
+    } else if (get_option().log_pregleaning_interval_milliseconds_ > 0
+        && std::chrono::system_clock::now() >= previous_pregleaning_time_ +
+          std::chrono::milliseconds(get_option().log_pregleaning_interval_milliseconds_)) {
+      ErrorStack stack = handle_pregleaning_triggered();
+      if (stack.is_error()) {
+        LOG(ERROR) << "Pre-gleaning failed:" << stack;
+      }
     } else {
       VLOG(1) << "Snapshotting not triggered. going to sleep again";
     }
@@ -239,7 +252,7 @@ void SnapshotManagerPimpl::handle_snapshot() {
 void SnapshotManagerPimpl::handle_snapshot_child() {
   LOG(INFO) << "Child snapshot daemon-" << engine_->get_soc_id() << " started";
   thread::NumaThreadScope scope(engine_->get_soc_id());
-  SnapshotId previous_id = control_block_->gleaner_.cur_snapshot_.id_;
+  uint32_t previous_round = control_block_->gleaner_.round_;
   while (!is_stop_requested()) {
     {
       uint64_t demand = control_block_->snapshot_children_wakeup_.acquire_ticket();
@@ -249,9 +262,10 @@ void SnapshotManagerPimpl::handle_snapshot_child() {
     }
     if (is_stop_requested()) {
       break;
-    } else if (!is_gleaning() || previous_id == control_block_->gleaner_.cur_snapshot_.id_) {
+    } else if (!is_gleaning() || previous_round == control_block_->gleaner_.round_) {
       continue;
     }
+    uint32_t current_round = control_block_->gleaner_.round_;
     SnapshotId current_id = control_block_->gleaner_.cur_snapshot_.id_;
     LOG(INFO) << "Child snapshot daemon-" << engine_->get_soc_id() << " received a request"
       << " for snapshot-" << current_id;
@@ -267,7 +281,7 @@ void SnapshotManagerPimpl::handle_snapshot_child() {
     local_reducer_->join_thread();
     LOG(INFO) << "Child snapshot daemon-" << engine_->get_soc_id() << " joined mappers/reducer"
       " for snapshot-" << current_id;
-    previous_id = current_id;
+    previous_round = current_round;
   }
 
   LOG(INFO) << "Child snapshot daemon-" << engine_->get_soc_id() << " ended";
@@ -316,6 +330,7 @@ void SnapshotManagerPimpl::trigger_snapshot_immediate(
 ErrorStack SnapshotManagerPimpl::handle_snapshot_triggered(Snapshot *new_snapshot) {
   ASSERT_ND(engine_->is_master());
   ASSERT_ND(engine_->get_storage_manager()->is_initialized());  // snapshot relied on storage module
+  soc::SharedMutexScope snapshot_scope(&control_block_->snapshot_mutex_);
   Epoch durable_epoch = engine_->get_log_manager()->get_durable_global_epoch();
   Epoch previous_epoch = get_snapshot_epoch();
   LOG(INFO) << "Taking a new snapshot. durable_epoch=" << durable_epoch
@@ -332,17 +347,19 @@ ErrorStack SnapshotManagerPimpl::handle_snapshot_triggered(Snapshot *new_snapsho
   } else {
     new_snapshot->valid_until_epoch_ = durable_epoch;
   }
+  Epoch pregleaned_epoch = control_block_->gleaner_.pregleaned_epoch_;
+  if (pregleaned_epoch.is_valid() && new_snapshot->valid_until_epoch_ < pregleaned_epoch) {
+    // sorted runs already contain logs up to there. they are durable, so just include them.
+    LOG(INFO) << "Logs until " << pregleaned_epoch << " are already pre-gleaned. Snapshot"
+      << " epoch is advanced from " << new_snapshot->valid_until_epoch_;
+    new_snapshot->valid_until_epoch_ = pregleaned_epoch;
+  }
   new_snapshot->max_storage_id_ = engine_->get_storage_manager()->get_largest_storage_id();
   ASSERT_ND(new_snapshot->max_storage_id_
     >= control_block_->gleaner_.cur_snapshot_.max_storage_id_);
 
   // determine the snapshot ID
-  SnapshotId snapshot_id;
-  if (control_block_->previous_snapshot_id_ == kNullSnapshotId) {
-    snapshot_id = 1;
-  } else {
-    snapshot_id = increment(control_block_->previous_snapshot_id_);
-  }
+  SnapshotId snapshot_id = get_next_snapshot_id();
   LOG(INFO) << "Issued ID for this snapshot:" << snapshot_id;
   new_snapshot->id_ = snapshot_id;
 
@@ -376,6 +393,7 @@ ErrorStack SnapshotManagerPimpl::handle_snapshot_triggered(Snapshot *new_snapsho
   Epoch::EpochInteger epoch_after = new_snapshot_epoch.value();
   control_block_->previous_snapshot_id_ = snapshot_id;
   previous_snapshot_time_ = std::chrono::system_clock::now();
+  previous_pregleaning_time_ = previous_snapshot_time_;
 
   control_block_->snapshot_epoch_ = epoch_after;
   assorted::memory_fence_release();
@@ -383,6 +401,40 @@ ErrorStack SnapshotManagerPimpl::handle_snapshot_triggered(Snapshot *new_snapsho
   return kRetOk;
 }
 
+ErrorStack SnapshotManagerPimpl::handle_pregleaning_triggered() {
+  ASSERT_ND(engine_->is_master());
+  previous_pregleaning_time_ = std::chrono::system_clock::now();
+  // the shape of storages must not change while we partition logs, same as snapshotting
+  soc::SharedMutexScope snapshot_scope(&control_block_->snapshot_mutex_);
+  Epoch durable_epoch = engine_->get_log_manager()->get_durable_global_epoch();
+  Epoch previous_epoch = get_snapshot_epoch();
+  Epoch pregleaned_epoch = control_block_->gleaner_.pregleaned_epoch_;
+  Epoch from_epoch = pregleaned_epoch.is_valid() ? pregleaned_epoch : previous_epoch;
+  if (!durable_epoch.is_valid() || (from_epoch.is_valid() && durable_epoch <= from_epoch)) {
+    VLOG(1) << "No new durable logs to pre-glean. durable_epoch=" << durable_epoch;
+    return kRetOk;
+  }
+
+  // pre-gleaning works on behalf of the next snapshot. mappers read only the new logs
+  Snapshot next_snapshot;
+  next_snapshot.id_ = get_next_snapshot_id();
+  next_snapshot.base_epoch_ = previous_epoch;
+  next_snapshot.valid_until_epoch_ = durable_epoch;
+  next_snapshot.max_storage_id_ = engine_->get_storage_manager()->get_largest_storage_id();
+  LOG(INFO) << "Pre-gleaning logs for snapshot-" << next_snapshot.id_ << " after " << from_epoch
+    << " until " << durable_epoch;
+  LogGleaner gleaner(engine_, &gleaner_resource_, next_snapshot, true);
+  return gleaner.execute();
+}
+
+SnapshotId SnapshotManagerPimpl::get_next_snapshot_id() const {
+  if (control_block_->previous_snapshot_id_ == kNullSnapshotId) {
+    return 1;
+  } else {
+    return increment(control_block_->previous_snapshot_id_);
+  }
+}
+
 ErrorStack SnapshotManagerPimpl::glean_logs(
   const Snapshot& new_snapshot,
   std::map<storage::StorageId, storage::SnapshotPagePointer>* new_root_page_pointers) {
@@ -478,11 +530,7 @@ ErrorStack SnapshotManagerPimpl::snapshot_savepoint(const Snapshot& new_snapshot
 }
 
 fs::Path SnapshotManagerPimpl::get_snapshot_metadata_file_path(SnapshotId snapshot_id) const {
-  fs::Path folder(get_option().get_primary_folder_path());
-  fs::Path file(folder);
-  file /= std::string("snapshot_metadata_")
-    + std::to_string(snapshot_id) + std::string(".xml");
-  return file;
+  return fs::Path(get_option().construct_snapshot_metadata_file_path(snapshot_id));
 }
 
 ErrorStack SnapshotManagerPimpl::drop_volatile_pages(
@@ -27,12 +27,14 @@ SnapshotOptions::SnapshotOptions() {
   folder_path_pattern_ = "snapshots/node_$NODE$";
   snapshot_trigger_page_pool_percent_ = kDefaultSnapshotTriggerPagePoolPercent;
   snapshot_interval_milliseconds_ = kDefaultSnapshotIntervalMilliseconds;
+  log_pregleaning_interval_milliseconds_ = kDefaultLogPregleaningIntervalMilliseconds;
   log_mapper_bucket_kb_ = kDefaultLogMapperBucketKb;
   log_mapper_io_buffer_mb_ = kDefaultLogMapperIoBufferMb;
   log_mapper_sort_before_send_ = true;
   log_reducer_buffer_mb_ = kDefaultLogReducerBufferMb;
   log_reducer_dump_io_buffer_mb_ = kDefaultLogReducerDumpIoBufferMb;
   log_reducer_read_io_buffer_kb_ = kDefaultLogReducerReadIoBufferKb;
+  log_reducer_composers_ = kDefaultLogReducerComposers;
   snapshot_writer_page_pool_size_mb_ = kDefaultSnapshotWriterPagePoolSizeMb;
   snapshot_writer_intermediate_pool_size_mb_ = kDefaultSnapshotWriterIntermediatePoolSizeMb;
 }
@@ -41,12 +43,26 @@ std::string SnapshotOptions::convert_folder_path_pattern(int node) const {
   return assorted::replace_all(folder_path_pattern_.str(), "$NODE$", node);
 }
 
-std::string SnapshotOptions::construct_snapshot_file_path(int snapshot_id, int node) const {
-  return convert_folder_path_pattern(node)
+std::string SnapshotOptions::construct_snapshot_file_path(
+  int snapshot_id,
+  int node,
+  int shard) const {
+  std::string path = convert_folder_path_pattern(node)
     + std::string("/snapshot_")
     + std::to_string(snapshot_id)
     + std::string("_")
     + std::to_string(node);
+  if (shard != 0) {
+    path += std::string("_") + std::to_string(shard);
+  }
+  return path;
+}
+
+std::string SnapshotOptions::construct_snapshot_metadata_file_path(int snapshot_id) const {
+  return get_primary_folder_path()
+    + std::string("/snapshot_metadata_")
+    + std::to_string(snapshot_id)
+    + std::string(".xml");
 }
 
 
@@ -54,12 +70,14 @@ ErrorStack SnapshotOptions::load(tinyxml2::XMLElement* element) {
   EXTERNALIZE_LOAD_ELEMENT(element, folder_path_pattern_);
   EXTERNALIZE_LOAD_ELEMENT(element, snapshot_trigger_page_pool_percent_);
   EXTERNALIZE_LOAD_ELEMENT(element, snapshot_interval_milliseconds_);
+  EXTERNALIZE_LOAD_ELEMENT(element, log_pregleaning_interval_milliseconds_);
   EXTERNALIZE_LOAD_ELEMENT(element, log_mapper_bucket_kb_);
   EXTERNALIZE_LOAD_ELEMENT(element, log_mapper_io_buffer_mb_);
   EXTERNALIZE_LOAD_ELEMENT(element, log_mapper_sort_before_send_);
   EXTERNALIZE_LOAD_ELEMENT(element, log_reducer_buffer_mb_);
   EXTERNALIZE_LOAD_ELEMENT(element, log_reducer_dump_io_buffer_mb_);
   EXTERNALIZE_LOAD_ELEMENT(element, log_reducer_read_io_buffer_kb_);
+  EXTERNALIZE_LOAD_ELEMENT(element, log_reducer_composers_);
   EXTERNALIZE_LOAD_ELEMENT(element, snapshot_writer_page_pool_size_mb_);
   EXTERNALIZE_LOAD_ELEMENT(element, snapshot_writer_intermediate_pool_size_mb_);
   CHECK_ERROR(get_child_element(element, "SnapshotDeviceEmulationOptions", &emulation_))
@@ -79,6 +97,9 @@ ErrorStack SnapshotOptions::save(tinyxml2::XMLElement* element) const {
     " snapshot manager starts snapshotting to drop volatile pages even before the interval.");
   EXTERNALIZE_SAVE_ELEMENT(element, snapshot_interval_milliseconds_,
     "Interval in milliseconds to take snapshots.");
+  EXTERNALIZE_SAVE_ELEMENT(element, log_pregleaning_interval_milliseconds_,
+    "Interval in milliseconds to incrementally glean durable logs into sorted runs between"
+    " snapshots. 0 (default) disables it and logs are gleaned only when taking a snapshot.");
   EXTERNALIZE_SAVE_ELEMENT(element, log_mapper_bucket_kb_,
     "Size in KB of bucket (buffer for each partition) in mapper."
     " The larger, the less freuquently each mapper communicates with reducers."
@@ -95,6 +116,10 @@ ErrorStack SnapshotOptions::save(tinyxml2::XMLElement* element) const {
   EXTERNALIZE_SAVE_ELEMENT(element, log_reducer_read_io_buffer_kb_,
     "The size in KB of a buffer in reducer to read one temporary file. Note that the total"
     " memory consumption is this number times the number of temporary files. It's a merge-sort.");
+  EXTERNALIZE_SAVE_ELEMENT(element, log_reducer_composers_,
+    "Number of threads in each reducer (NUMA node) that compose snapshot pages. Each of them"
+    " writes to its own shard of the node's snapshot file with its own snapshot writer memory."
+    " Each storage is composed by one thread, so this does not speed up a single large storage.");
   EXTERNALIZE_SAVE_ELEMENT(element, snapshot_writer_page_pool_size_mb_,
     "The size in MB of one snapshot writer, which holds data pages modified in the snapshot"
     " and them sequentially dumps them to a file for each storage.");
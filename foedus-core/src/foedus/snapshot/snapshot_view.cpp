@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include "foedus/snapshot/snapshot_view.hpp"
+
+#include <glog/logging.h>
+
+#include <cstring>
+
+#include "foedus/assert_nd.hpp"
+#include "foedus/engine.hpp"
+#include "foedus/engine_options.hpp"
+#include "foedus/fs/filesystem.hpp"
+#include "foedus/fs/path.hpp"
+#include "foedus/snapshot/snapshot_manager.hpp"
+#include "foedus/soc/shared_memory_repo.hpp"
+#include "foedus/storage/storage.hpp"
+#include "foedus/xct/xct_manager.hpp"
+
+namespace foedus {
+namespace snapshot {
+
+SnapshotView::SnapshotView(Engine* engine) : engine_(engine), control_blocks_(CXX11_NULLPTR) {
+  metadata_.clear();
+}
+
+void SnapshotView::close() {
+  metadata_.clear();
+  control_blocks_ = CXX11_NULLPTR;
+  control_blocks_memory_.release_block();
+}
+
+ErrorStack SnapshotView::open(SnapshotId snapshot_id) {
+  close();
+  const SnapshotManager* snapshot_manager = engine_->get_snapshot_manager();
+  const Epoch latest_epoch = snapshot_manager->get_snapshot_epoch();
+  if (snapshot_id == kNullSnapshotId || !latest_epoch.is_valid()) {
+    return ERROR_STACK(kErrorCodeSnapshotNotFound);
+  }
+  const SnapshotOptions& options = engine_->get_options().snapshot_;
+  fs::Path file(options.construct_snapshot_metadata_file_path(snapshot_id));
+  if (!fs::exists(file)) {
+    return ERROR_STACK_MSG(kErrorCodeSnapshotNotFound, file.c_str());
+  }
+  CHECK_ERROR(engine_->get_snapshot_manager()->read_snapshot_metadata(snapshot_id, &metadata_));
+  if (metadata_.id_ != snapshot_id || Epoch(metadata_.valid_until_epoch_) > latest_epoch) {
+    // a leftover of a snapshot that didn't complete
+    LOG(WARNING) << "Snapshot-" << snapshot_id << " (valid until " << metadata_.valid_until_epoch_
+      << ") is not a completed snapshot. latest snapshot epoch=" << latest_epoch;
+    close();
+    return ERROR_STACK(kErrorCodeSnapshotNotFound);
+  }
+
+  const uint64_t memory_size
+    = static_cast<uint64_t>(metadata_.largest_storage_id_ + 1)
+      * soc::GlobalMemoryAnchors::kStorageMemorySize;
+  control_blocks_memory_.alloc(memory_size, 1 << 12, memory::AlignedMemory::kNumaAllocOnnode, 0);
+  control_blocks_ = reinterpret_cast<storage::StorageControlBlock*>(
+    control_blocks_memory_.get_block());
+  std::memset(control_blocks_memory_.get_block(), 0, memory_size);
+  for (storage::StorageId id = 1; id <= metadata_.largest_storage_id_; ++id) {
+    const storage::StorageControlBlock& snapshot_block = metadata_.storage_control_blocks_[id];
+    if (snapshot_block.status_ != storage::kExists) {
+      continue;
+    }
+    storage::StorageControlBlock* block = control_blocks_ + id;
+    block->meta_.type_ = snapshot_block.meta_.type_;
+    switch (snapshot_block.meta_.type_) {
+    case storage::kArrayStorage:
+      CHECK_ERROR(storage::array::ArrayStorage(engine_, block).load_snapshot_view(snapshot_block));
+      break;
+    case storage::kHashStorage:
+      CHECK_ERROR(storage::hash::HashStorage(engine_, block).load_snapshot_view(snapshot_block));
+      break;
+    case storage::kMasstreeStorage:
+      CHECK_ERROR(storage::masstree::MasstreeStorage(engine_, block).load_snapshot_view(
+        snapshot_block));
+      break;
+    case storage::kSequentialStorage:
+      CHECK_ERROR(storage::sequential::SequentialStorage(engine_, block).load_snapshot_view(
+        snapshot_block));
+      break;
+    default:
+      return ERROR_STACK(kErrorCodeStrUnsupportedMetadata);
+    }
+    ASSERT_ND(block->exists());
+  }
+  LOG(INFO) << "Opened a view of snapshot-" << snapshot_id << " valid until epoch-"
+    << metadata_.valid_until_epoch_ << ". " << metadata_.largest_storage_id_ << " storages";
+  return kRetOk;
+}
+
+ErrorCode SnapshotView::begin_xct(thread::Thread* context) const {
+  if (!is_open()) {
+    return kErrorCodeXctNoSnapshot;
+  }
+  return engine_->get_xct_manager()->begin_snapshot_only_xct(
+    context,
+    metadata_.id_,
+    get_valid_until_epoch());
+}
+
+storage::StorageControlBlock* SnapshotView::get_storage(storage::StorageId id) {
+  if (!is_open() || id == 0 || id > metadata_.largest_storage_id_) {
+    return CXX11_NULLPTR;
+  }
+  storage::StorageControlBlock* block = control_blocks_ + id;
+  if (!block->exists()) {
+    return CXX11_NULLPTR;
+  }
+  return block;
+}
+
+storage::StorageControlBlock* SnapshotView::get_storage(const storage::StorageName& name) {
+  for (storage::StorageId id = 1; is_open() && id <= metadata_.largest_storage_id_; ++id) {
+    storage::StorageControlBlock* block = control_blocks_ + id;
+    if (block->exists() && block->meta_.name_ == name) {
+      return block;
+    }
+  }
+  return CXX11_NULLPTR;
+}
+
+}  // namespace snapshot
+}  // namespace foedus
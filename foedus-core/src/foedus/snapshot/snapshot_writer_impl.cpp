@@ -39,10 +39,12 @@ SnapshotWriter::SnapshotWriter(
   SnapshotId snapshot_id,
   memory::AlignedMemory* pool_memory,
   memory::AlignedMemory* intermediate_memory,
-  bool append)
+  bool append,
+  uint8_t shard)
   : engine_(engine),
   numa_node_(numa_node),
   append_(append),
+  shard_(shard),
   snapshot_id_(snapshot_id),
   pool_memory_(pool_memory),
   intermediate_memory_(intermediate_memory),
@@ -75,7 +77,8 @@ bool SnapshotWriter::close() {
 
 fs::Path SnapshotWriter::get_snapshot_file_path() const {
   fs::Path path(engine_->get_options().snapshot_.construct_snapshot_file_path(snapshot_id_,
-                                                                              numa_node_));
+                                                                              numa_node_,
+                                                                              shard_));
   return path;
 }
 
@@ -90,7 +93,10 @@ ErrorStack SnapshotWriter::open() {
     char* first_page = reinterpret_cast<char*>(pool_memory_->get_block());
     // first 8 bytes have some data, but we would use them just for sanity checks and debugging
     storage::PageHeader* first_page_header = reinterpret_cast<storage::PageHeader*>(first_page);
-    first_page_header->page_id_ = storage::to_snapshot_page_pointer(snapshot_id_, numa_node_, 0);
+    first_page_header->page_id_ = storage::to_snapshot_page_pointer(
+      snapshot_id_,
+      numa_node_,
+      storage::to_local_page_id(shard_, 0));
     first_page_header->storage_id_ = 0x1BF0ED05;  // something unusual
     first_page_header->checksum_ = 0x1BF0ED05;  // something unusual
     std::memset(
@@ -103,7 +109,10 @@ ErrorStack SnapshotWriter::open() {
     std::memcpy(first_page + sizeof(storage::PageHeader), duh.data(), duh.size());
 
     WRAP_ERROR_CODE(snapshot_file_->write(sizeof(storage::Page), *pool_memory_));
-    next_page_id_ = storage::to_snapshot_page_pointer(snapshot_id_, numa_node_, 1);
+    next_page_id_ = storage::to_snapshot_page_pointer(
+      snapshot_id_,
+      numa_node_,
+      storage::to_local_page_id(shard_, 1));
   } else {
     // if appending, nothing to do
     uint64_t file_size = snapshot_file_->get_current_offset();
@@ -111,7 +120,10 @@ ErrorStack SnapshotWriter::open() {
     ASSERT_ND(file_size >= sizeof(storage::Page));  // have at least the dummy page
     ASSERT_ND(file_size % sizeof(storage::Page) == 0);  // must be aligned writes
     uint64_t next_offset = file_size / sizeof(storage::Page);
-    next_page_id_ = storage::to_snapshot_page_pointer(snapshot_id_, numa_node_, next_offset);
+    next_page_id_ = storage::to_snapshot_page_pointer(
+      snapshot_id_,
+      numa_node_,
+      storage::to_local_page_id(shard_, next_offset));
   }
   return kRetOk;
 }
@@ -175,6 +187,7 @@ std::ostream& operator<<(std::ostream& o, const SnapshotWriter& v) {
   o << "<SnapshotWriter>"
     << "<numa_node_>" << v.numa_node_ << "</numa_node_>"
     << "<append_>" << v.append_ << "</append_>"
+    << "<shard_>" << static_cast<int>(v.shard_) << "</shard_>"
     << "<snapshot_id_>" << v.snapshot_id_ << "</snapshot_id_>"
     << "<pool_memory_>" << *v.pool_memory_ << "</pool_memory_>"
     << "<intermediate_memory_>" << *v.intermediate_memory_ << "</intermediate_memory_>"
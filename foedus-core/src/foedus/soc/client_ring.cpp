@@ -0,0 +1,379 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include "foedus/soc/client_ring.hpp"
+
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <glog/logging.h>
+
+#include <chrono>
+#include <cstring>
+#include <string>
+
+#include "foedus/assert_nd.hpp"
+#include "foedus/assorted/assorted_func.hpp"
+#include "foedus/soc/soc_options.hpp"
+
+namespace foedus {
+namespace soc {
+
+namespace {
+const uint64_t kClientRingMagicWord = 0x434C4E5452494E47ULL;  // "CLNTRING"
+
+/** Power of two that is at least as large as the configured number of slots. */
+uint32_t calculate_slot_count(const SocOptions& options) {
+  uint32_t slots = 1U;
+  while (slots < options.client_ring_slots_ && slots < (1U << 20)) {
+    slots <<= 1;
+  }
+  return slots;
+}
+
+inline uint32_t align_8(uint32_t value) { return assorted::align8(value); }
+
+/** Microseconds of a monotonic clock, which is comparable between processes. */
+uint64_t get_monotonic_us() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool is_process_dead(uint32_t pid) {
+  return ::kill(static_cast<pid_t>(pid), 0) != 0 && errno == ESRCH;
+}
+}  // namespace
+
+static_assert(sizeof(ClientRingSlot) <= ClientRingSlot::kHeaderSize, "slot header too large");
+
+ClientRing::ClientRing()
+  : control_block_(nullptr), slots_(nullptr), slot_mask_(0), slot_data_size_(0) {
+  static_assert(sizeof(ControlBlock) <= kControlBlockSize, "control block too large");
+}
+
+uint64_t ClientRing::calculate_memory_size(const SocOptions& options) {
+  if (options.client_ring_slots_ == 0) {
+    return 0;
+  }
+  const uint64_t slot_size
+    = ClientRingSlot::kHeaderSize + (static_cast<uint64_t>(options.client_ring_slot_kb_) << 10);
+  return kControlBlockSize + slot_size * calculate_slot_count(options);
+}
+
+void ClientRing::point_to(void* memory) {
+  control_block_ = reinterpret_cast<ControlBlock*>(memory);
+  slots_ = reinterpret_cast<char*>(memory) + kControlBlockSize;
+  slot_mask_ = control_block_->slot_count_ - 1U;
+  slot_data_size_ = control_block_->slot_data_size_;
+}
+
+void ClientRing::initialize(void* memory, const SocOptions& options) {
+  ASSERT_ND(options.client_ring_slots_ > 0);
+  ASSERT_ND(memory);
+  const uint32_t slot_count = calculate_slot_count(options);
+  LOG(INFO) << "Initializing client request ring. " << slot_count << " slots, "
+    << options.client_ring_slot_kb_ << "kb each";
+  std::memset(memory, 0, calculate_memory_size(options));
+  ControlBlock* block = reinterpret_cast<ControlBlock*>(memory);
+  block->slot_count_ = slot_count;
+  block->slot_data_size_ = options.client_ring_slot_kb_ << 10;
+  block->abandon_timeout_us_ = options.client_ring_abandon_timeout_us_;
+  block->enqueue_position_.store(0);
+  block->dequeue_position_.store(0);
+  block->sleeping_workers_.store(0);
+  block->response_cond_.initialize();
+  block->doorbell_.initialize();
+  point_to(memory);
+  for (uint32_t i = 0; i < slot_count; ++i) {
+    get_slot(i)->sequence_.store(i, std::memory_order_relaxed);
+  }
+  // Clients check the magic word before anything else, so write it last.
+  std::atomic_thread_fence(std::memory_order_release);
+  block->magic_word_ = kClientRingMagicWord;
+}
+
+ErrorCode ClientRing::attach(void* memory, uint64_t memory_size) {
+  const ControlBlock* block = reinterpret_cast<const ControlBlock*>(memory);
+  if (memory == nullptr
+    || memory_size < kControlBlockSize
+    || block->magic_word_ != kClientRingMagicWord) {
+    return kErrorCodeSocShmAttachFailed;
+  }
+  std::atomic_thread_fence(std::memory_order_acquire);
+  const uint64_t slot_size = ClientRingSlot::kHeaderSize + block->slot_data_size_;
+  if (memory_size < kControlBlockSize + slot_size * block->slot_count_) {
+    return kErrorCodeSocShmAttachFailed;
+  }
+  point_to(memory);
+  return kErrorCodeOk;
+}
+
+ErrorCode ClientRing::reserve(uint32_t input_len, Ticket* ticket, void** input) {
+  ASSERT_ND(is_enabled());
+  if (input_len > slot_data_size_) {
+    return kErrorCodeSocClientRingTooLargeInput;
+  }
+  uint64_t position = control_block_->enqueue_position_.load(std::memory_order_relaxed);
+  while (true) {
+    ClientRingSlot* slot = get_slot(position);
+    const uint64_t sequence = slot->sequence_.load(std::memory_order_acquire);
+    const int64_t diff = static_cast<int64_t>(sequence - position);
+    if (diff == 0) {
+      if (control_block_->enqueue_position_.compare_exchange_weak(
+        position,
+        position + 1U,
+        std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      // The slot of the previous lap is not released yet. Unless its owner is gone, we are full.
+      if (!try_reclaim(position - get_slot_count())) {
+        return kErrorCodeSocClientRingFull;
+      }
+      position = control_block_->enqueue_position_.load(std::memory_order_relaxed);
+    } else {
+      position = control_block_->enqueue_position_.load(std::memory_order_relaxed);
+    }
+  }
+  ClientRingSlot* slot = get_slot(position);
+  slot->input_len_ = input_len;
+  slot->output_len_ = 0;
+  slot->result_ = kErrorCodeOk;
+  slot->owner_pid_ = static_cast<uint32_t>(::getpid());
+  slot->status_changed_us_ = get_monotonic_us();
+  slot->status_.store(ClientRingSlot::kReserved, std::memory_order_release);
+  *ticket = position;
+  *input = get_data(position);
+  return kErrorCodeOk;
+}
+
+ErrorCode ClientRing::submit(Ticket ticket, const proc::ProcName& proc_name) {
+  ClientRingSlot* slot = get_slot(ticket);
+  ASSERT_ND(slot->sequence_.load() == ticket);
+  slot->proc_name_ = proc_name;
+  uint32_t expected = ClientRingSlot::kReserved;
+  if (!slot->status_.compare_exchange_strong(expected, ClientRingSlot::kSubmitted)) {
+    // workers have skipped this slot. it's still ours, so we return it to the ring.
+    ASSERT_ND(expected == ClientRingSlot::kAbandoned);
+    slot->status_.store(ClientRingSlot::kFree, std::memory_order_relaxed);
+    slot->sequence_.store(ticket + get_slot_count(), std::memory_order_release);
+    return kErrorCodeSocClientRingAbandoned;
+  }
+  slot->sequence_.store(ticket + 1U, std::memory_order_release);
+
+  // ring the doorbell if some worker might be sleeping. the fence pairs with the one in
+  // wait_for_requests() so that either the worker sees our request or we see the worker.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (control_block_->sleeping_workers_.load(std::memory_order_relaxed) > 0) {
+    control_block_->doorbell_.broadcast_nolock();
+  }
+  return kErrorCodeOk;
+}
+
+ErrorCode ClientRing::wait(Ticket ticket, uint64_t timeout_us) const {
+  while (!is_completed(ticket)) {
+    if (is_abandoned(ticket)) {
+      return kErrorCodeSocClientRingAbandoned;
+    }
+    uint64_t demand = control_block_->response_cond_.acquire_ticket();
+    if (is_completed(ticket)) {
+      break;
+    }
+    if (!control_block_->response_cond_.timedwait(demand, timeout_us)) {
+      if (is_completed(ticket)) {
+        break;
+      }
+      return kErrorCodeTimeout;
+    }
+  }
+  return kErrorCodeOk;
+}
+
+ErrorCode ClientRing::get_result(Ticket ticket) const {
+  const ClientRingSlot* slot = get_slot(ticket);
+  ErrorCode result = slot->result_;
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (slot->sequence_.load(std::memory_order_relaxed) != ticket + 1U) {
+    return kErrorCodeSocClientRingAbandoned;
+  }
+  return result;
+}
+
+const void* ClientRing::get_output(Ticket ticket) const {
+  ASSERT_ND(is_completed(ticket));
+  return get_data(ticket) + align_8(get_slot(ticket)->input_len_);
+}
+
+void ClientRing::release(Ticket ticket) {
+  ClientRingSlot* slot = get_slot(ticket);
+  if (slot->sequence_.load(std::memory_order_acquire) != ticket + 1U) {
+    return;  // someone has reclaimed it
+  }
+  uint32_t expected = ClientRingSlot::kCompleted;
+  if (slot->status_.compare_exchange_strong(expected, ClientRingSlot::kFree)) {
+    slot->sequence_.store(ticket + get_slot_count(), std::memory_order_release);
+  }
+}
+
+bool ClientRing::is_owner_gone(const ClientRingSlot* slot) const {
+  const uint64_t now = get_monotonic_us();
+  return now > slot->status_changed_us_ + control_block_->abandon_timeout_us_
+    || is_process_dead(slot->owner_pid_);
+}
+
+bool ClientRing::try_skip_abandoned(uint64_t position) {
+  ClientRingSlot* slot = get_slot(position);
+  if (slot->status_.load(std::memory_order_acquire) != ClientRingSlot::kReserved
+    || slot->sequence_.load(std::memory_order_acquire) != position
+    || !is_owner_gone(slot)) {
+    return false;
+  }
+  uint32_t expected = ClientRingSlot::kReserved;
+  if (!slot->status_.compare_exchange_strong(expected, ClientRingSlot::kAbandoned)) {
+    return false;  // submitted just now, or another worker is skipping it
+  }
+  // Only we can move dequeue_position_ past this slot now.
+  uint64_t expected_position = position;
+  bool advanced = control_block_->dequeue_position_.compare_exchange_strong(
+    expected_position,
+    position + 1U);
+  ASSERT_ND(advanced);
+  UNUSED_ND(advanced);
+  LOG(WARNING) << "Skipped a client request slot that was reserved but not submitted in time."
+    << " position=" << position << ", owner pid=" << slot->owner_pid_;
+  if (is_process_dead(slot->owner_pid_)) {
+    // nobody will submit it. return it to the ring now.
+    slot->status_.store(ClientRingSlot::kFree, std::memory_order_relaxed);
+    slot->sequence_.store(position + get_slot_count(), std::memory_order_release);
+  }
+  return true;
+}
+
+bool ClientRing::try_reclaim(uint64_t position) {
+  ClientRingSlot* slot = get_slot(position);
+  const uint32_t status = slot->status_.load(std::memory_order_acquire);
+  const uint64_t sequence = slot->sequence_.load(std::memory_order_acquire);
+  if (status == ClientRingSlot::kCompleted && sequence == position + 1U) {
+    if (!is_owner_gone(slot)) {
+      return false;
+    }
+  } else if (status == ClientRingSlot::kAbandoned && sequence == position) {
+    // skipped by workers. usually the owner returns it in submit(), unless it died.
+    if (!is_process_dead(slot->owner_pid_)) {
+      return false;
+    }
+  } else {
+    return false;  // in use, or someone has just returned it
+  }
+  uint32_t expected = status;
+  if (!slot->status_.compare_exchange_strong(expected, ClientRingSlot::kFree)) {
+    return false;
+  }
+  LOG(WARNING) << "Reclaimed a client request slot that the client did not release."
+    << " position=" << position << ", owner pid=" << slot->owner_pid_;
+  slot->sequence_.store(position + get_slot_count(), std::memory_order_release);
+  return true;
+}
+
+bool ClientRing::has_requests() const {
+  const uint64_t position = control_block_->dequeue_position_.load(std::memory_order_relaxed);
+  return get_slot(position)->sequence_.load(std::memory_order_relaxed) == position + 1U;
+}
+
+bool ClientRing::has_pending_slots() const {
+  return control_block_->dequeue_position_.load(std::memory_order_relaxed)
+    != control_block_->enqueue_position_.load(std::memory_order_relaxed);
+}
+
+bool ClientRing::dequeue(Ticket* ticket) {
+  uint64_t position = control_block_->dequeue_position_.load(std::memory_order_relaxed);
+  while (true) {
+    ClientRingSlot* slot = get_slot(position);
+    const uint64_t sequence = slot->sequence_.load(std::memory_order_acquire);
+    const int64_t diff = static_cast<int64_t>(sequence - (position + 1U));
+    if (diff == 0) {
+      if (control_block_->dequeue_position_.compare_exchange_weak(
+        position,
+        position + 1U,
+        std::memory_order_relaxed)) {
+        *ticket = position;
+        return true;
+      }
+    } else if (diff < 0) {
+      // not submitted yet. if the client is gone, skip it and look at the next one.
+      if (!try_skip_abandoned(position)) {
+        return false;
+      }
+      position = control_block_->dequeue_position_.load(std::memory_order_relaxed);
+    } else {
+      position = control_block_->dequeue_position_.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+void ClientRing::wait_for_requests(uint64_t timeout_us) {
+  control_block_->sleeping_workers_.fetch_add(1U);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (!has_requests()) {
+    SharedMutexScope scope(control_block_->doorbell_.get_mutex());
+    control_block_->doorbell_.timedwait(&scope, timeout_us * 1000ULL);
+  }
+  control_block_->sleeping_workers_.fetch_sub(1U);
+}
+
+void* ClientRing::get_output_buffer(Ticket ticket, uint32_t* capacity) const {
+  const uint32_t offset = align_8(get_slot(ticket)->input_len_);
+  *capacity = offset < slot_data_size_ ? slot_data_size_ - offset : 0;
+  return get_data(ticket) + offset;
+}
+
+void ClientRing::complete(Ticket ticket, ErrorCode result, uint32_t output_len) {
+  ClientRingSlot* slot = get_slot(ticket);
+  ASSERT_ND(slot->status_.load() == ClientRingSlot::kSubmitted);
+  slot->result_ = result;
+  slot->output_len_ = output_len;
+  slot->status_changed_us_ = get_monotonic_us();
+  slot->status_.store(ClientRingSlot::kCompleted, std::memory_order_release);
+}
+
+void ClientRing::signal_completion() {
+  control_block_->response_cond_.signal();
+}
+
+ErrorStack ClientRingConnection::connect(const std::string& meta_path) {
+  disconnect();
+  memory_.attach(meta_path, false);
+  if (memory_.is_null()) {
+    std::string msg = std::string("Failed to attach client request ring: ") + meta_path;
+    return ERROR_STACK_MSG(kErrorCodeSocShmAttachFailed, msg.c_str());
+  }
+  ErrorCode code = ring_.attach(memory_.get_block(), memory_.get_size());
+  if (code != kErrorCodeOk) {
+    memory_.release_block();
+    std::string msg = std::string("Not a client request ring: ") + meta_path;
+    return ERROR_STACK_MSG(code, msg.c_str());
+  }
+  return kRetOk;
+}
+
+void ClientRingConnection::disconnect() {
+  ring_ = ClientRing();
+  memory_.release_block();
+}
+
+}  // namespace soc
+}  // namespace foedus
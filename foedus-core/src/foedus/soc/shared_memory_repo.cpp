@@ -20,6 +20,7 @@
 #include <unistd.h>
 
 #include <cstring>
+#include <fstream>
 #include <iostream>
 #include <sstream>
 #include <string>
@@ -28,8 +29,10 @@
 
 #include "foedus/assert_nd.hpp"
 #include "foedus/assorted/assorted_func.hpp"
+#include "foedus/fs/filesystem.hpp"
 #include "foedus/storage/page.hpp"
 #include "foedus/storage/partitioner.hpp"
+#include "foedus/xct/version_store_impl.hpp"
 
 namespace foedus {
 namespace soc {
@@ -211,6 +214,152 @@ ErrorStack SharedMemoryRepo::attach_shared_memories(
   return kRetOk;
 }
 
+ErrorStack SharedMemoryRepo::reattach_shared_memories(
+  uint64_t upid,
+  Eid eid,
+  const EngineOptions& options,
+  const SharedMemoryManifest& manifest) {
+  deallocate_shared_memories();
+  init_empty(options);
+  if (manifest.soc_count_ != soc_count_) {
+    deallocate_shared_memories();
+    return ERROR_STACK_MSG(kErrorCodeSocShmAttachFailed, "SOC count differs from the manifest");
+  }
+
+  std::stringstream options_stream;
+  options.save_to_stream(&options_stream);
+  std::string xml(options_stream.str());
+  uint64_t xml_size = xml.size();
+  std::string global_memory_path = get_self_path(upid, eid) + std::string("_global");
+  const bool global_hugepages = !options.memory_.rigorous_memory_boundary_check_;
+  CHECK_ERROR(global_memory_.reattach(
+    global_memory_path,
+    manifest.global_memory_key_,
+    manifest.global_memory_size_,
+    0,
+    global_hugepages));
+
+  bool failed = false;
+  ErrorStack last_error;
+  for (uint16_t node = 0; node < soc_count_; ++node) {
+    std::string node_memory_path
+      = get_self_path(upid, eid) + std::string("_node_") + std::to_string(node);
+    ErrorStack result = node_memories_[node].reattach(
+      node_memory_path,
+      manifest.node_memory_keys_[node],
+      manifest.node_memory_size_,
+      node,
+      !options.memory_.rigorous_memory_boundary_check_
+        && !options.memory_.rigorous_page_boundary_check_);
+    if (result.is_error()) {
+      std::cerr << "[FOEDUS] Failed to reattach node shared memory for node-" << node
+        << ". " << result << std::endl;
+      last_error = result;
+      failed = true;
+    }
+  }
+  if (failed) {
+    // leave them for the caller who reclaims them. we haven't changed anything in them.
+    retain_shared_memories();
+    return last_error;
+  }
+
+  // Everything but the options is what the previous master left. Overwrite only the options,
+  // which is within the same 4kb-aligned area thanks to the layout fingerprint.
+  set_global_memory_anchors(xml_size, options, true);
+  std::memcpy(global_memory_.get_block(), &xml_size, sizeof(xml_size));
+  std::memcpy(global_memory_.get_block() + sizeof(xml_size), xml.data(), xml_size);
+  MasterEngineStatus* status = global_memory_anchors_.master_status_memory_;
+  status->status_code_ = MasterEngineStatus::kInitial;
+  status->warm_restarted_ = true;
+  status->retain_at_shutdown_ = false;
+  status->retained_durable_epoch_ = Epoch::kEpochInvalid;
+  for (uint16_t node = 0; node < soc_count_; ++node) {
+    set_node_memory_anchors(node, options, true);
+  }
+  return kRetOk;
+}
+
+void SharedMemoryRepo::describe_shared_memories(
+  const EngineOptions& options,
+  SharedMemoryManifest* manifest) const {
+  manifest->clear();
+  manifest->magic_word_ = SharedMemoryManifest::kMagicWord;
+  manifest->clean_shutdown_ = false;
+  manifest->soc_count_ = soc_count_;
+  manifest->layout_fingerprint_
+    = calculate_layout_fingerprint(global_memory_anchors_.options_xml_length_, options);
+  manifest->global_memory_size_ = global_memory_.get_size();
+  manifest->global_memory_key_ = global_memory_.get_shmkey();
+  manifest->node_memory_size_ = soc_count_ > 0 ? node_memories_[0].get_size() : 0;
+  for (uint16_t node = 0; node < soc_count_; ++node) {
+    ASSERT_ND(node_memories_[node].get_size() == manifest->node_memory_size_);
+    manifest->node_memory_keys_[node] = node_memories_[node].get_shmkey();
+  }
+  manifest->durable_epoch_ = Epoch::kEpochInvalid;
+}
+
+void SharedMemoryRepo::retain_shared_memories() {
+  global_memory_anchors_.clear();
+  global_memory_.detach_and_retain();
+  for (uint16_t i = 0; i < soc_count_; ++i) {
+    if (node_memories_) {
+      node_memories_[i].detach_and_retain();
+    }
+  }
+  // the rest is the same as deallocate_shared_memories(). now it does nothing on the memories.
+  deallocate_shared_memories();
+}
+
+void SharedMemoryManifest::reclaim_all() const {
+  memory::SharedMemory::reclaim_retained(global_memory_key_);
+  for (uint16_t node = 0; node < soc_count_ && node < kMaxSocs; ++node) {
+    memory::SharedMemory::reclaim_retained(node_memory_keys_[node]);
+  }
+}
+
+ErrorStack SharedMemoryManifest::load_from_file(const std::string& path) {
+  clear();
+  std::ifstream file(path, std::ifstream::binary);
+  if (!file.is_open()) {
+    std::string msg = std::string("Failed to open shared memory manifest:") + path;
+    return ERROR_STACK_MSG(kErrorCodeSocShmAttachFailed, msg.c_str());
+  }
+  file.read(reinterpret_cast<char*>(this), sizeof(SharedMemoryManifest));
+  bool complete = file.gcount() == static_cast<std::streamsize>(sizeof(SharedMemoryManifest));
+  file.close();
+  if (!complete || magic_word_ != kMagicWord) {
+    clear();
+    std::string msg = std::string("Shared memory manifest is broken:") + path;
+    return ERROR_STACK_MSG(kErrorCodeSocShmAttachFailed, msg.c_str());
+  }
+  return kRetOk;
+}
+
+ErrorStack SharedMemoryManifest::save_to_file(const std::string& path) const {
+  // write to a temporary file then rename so that readers never see a half-written manifest
+  fs::Path final_path(path);
+  fs::Path tmp_path(path + std::string(".tmp"));
+  if (final_path.has_parent_path() && !fs::exists(final_path.parent_path())) {
+    fs::create_directories(final_path.parent_path(), true);
+  }
+  {
+    std::ofstream file(tmp_path.string(), std::ofstream::binary | std::ofstream::trunc);
+    if (!file.is_open()) {
+      std::string msg = std::string("Failed to create shared memory manifest:") + path;
+      return ERROR_STACK_MSG(kErrorCodeSocShmAllocFailed, msg.c_str());
+    }
+    file.write(reinterpret_cast<const char*>(this), sizeof(SharedMemoryManifest));
+    file.flush();
+    file.close();
+  }
+  if (!fs::durable_atomic_rename(tmp_path, final_path)) {
+    std::string msg = std::string("Failed to rename shared memory manifest:") + path;
+    return ERROR_STACK_MSG(kErrorCodeSocShmAllocFailed, msg.c_str());
+  }
+  return kRetOk;
+}
+
 void SharedMemoryRepo::mark_for_release() {
   // mark_for_release() is idempotent, so just do it on all of them
   global_memory_.mark_for_release();
@@ -345,6 +494,10 @@ void SharedMemoryRepo::set_global_memory_anchors(
   total += align_4kb(1024ULL * options.soc_.shared_user_memory_size_kb_);
   put_global_memory_boundary(&total, "user_memory_boundary", reset_boundaries);
 
+  global_memory_anchors_.version_store_memory_ = base + total;
+  total += align_4kb(xct::VersionStore::calculate_memory_size(options));
+  put_global_memory_boundary(&total, "version_store_memory_boundary", reset_boundaries);
+
   // we have to be super careful here. let's not use assertion.
   if (calculate_global_memory_size(xml_size, options) != total) {
     std::cerr << "[FOEDUS] global memory size doesn't match. bug?"
@@ -389,9 +542,38 @@ uint64_t SharedMemoryRepo::calculate_global_memory_size(
     static_cast<uint64_t>(GlobalMemoryAnchors::kStorageMemorySize) * options.storage_.max_storages_
     + kBoundarySize;
   total += align_4kb(1024ULL * options.soc_.shared_user_memory_size_kb_) + kBoundarySize;
+  total += align_4kb(xct::VersionStore::calculate_memory_size(options)) + kBoundarySize;
   return total;
 }
 
+uint64_t SharedMemoryRepo::calculate_layout_fingerprint(
+  uint64_t xml_size,
+  const EngineOptions& options) {
+  // the xml itself may change (eg config change), but its aligned area must not.
+  const uint64_t values[] = {
+    align_4kb(sizeof(xml_size) + xml_size),
+    options.thread_.group_count_,
+    options.thread_.thread_count_per_group_,
+    options.log_.loggers_per_node_,
+    options.storage_.max_storages_,
+    options.storage_.partitioner_data_memory_mb_,
+    options.soc_.shared_user_memory_size_kb_,
+    options.proc_.max_proc_count_,
+    options.snapshot_.log_reducer_buffer_mb_,
+    options.memory_.page_pool_size_mb_per_node_,
+    calculate_global_memory_size(xml_size, options),
+    calculate_node_memory_size(options),
+  };
+  uint64_t hash = 0xCBF29CE484222325ULL;  // FNV-1a over the values
+  for (uint64_t value : values) {
+    for (uint16_t i = 0; i < sizeof(value); ++i) {
+      hash ^= (value >> (i * 8U)) & 0xFFU;
+      hash *= 0x100000001B3ULL;
+    }
+  }
+  return hash;
+}
+
 void SharedMemoryRepo::set_node_memory_anchors(
   SocId node,
   const EngineOptions& options,
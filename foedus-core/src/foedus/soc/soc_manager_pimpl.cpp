@@ -29,6 +29,7 @@
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <sstream>
 #include <string>
 #include <thread>
 #include <vector>
@@ -38,7 +39,9 @@
 #include "foedus/engine_type.hpp"
 #include "foedus/epoch.hpp"
 #include "foedus/error_stack_batch.hpp"
+#include "foedus/fs/filesystem.hpp"
 #include "foedus/proc/proc_manager.hpp"
+#include "foedus/savepoint/savepoint.hpp"
 #include "foedus/soc/soc_manager.hpp"
 #include "foedus/thread/numa_thread_scope.hpp"
 
@@ -59,6 +62,9 @@ ErrorStack SocManagerPimpl::uninitialize_once() {
   if (engine_->is_master() && memory_repo_.get_global_memory() != nullptr) {
     CHECK_ERROR(wait_for_child_terminate());  // wait for children to terminate
     memory_repo_.change_master_status(MasterEngineStatus::kTerminated);
+    if (is_warm_restart_enabled()) {
+      batch.emprace_back(retain_or_release_shared_memories());
+    }
   }
   memory_repo_.deallocate_shared_memories();
   return SUMMARIZE_ERROR_BATCH(batch);
@@ -83,15 +89,138 @@ void SocManagerPimpl::report_engine_fatal_error() {
   }
 }
 
-ErrorStack SocManagerPimpl::initialize_master() {
+bool SocManagerPimpl::is_warm_restart_enabled() const {
+  return SharedMemoryRepo::is_warm_restart_enabled(engine_->get_options());
+}
+
+bool SocManagerPimpl::is_reusable_manifest(
+  const SharedMemoryManifest& manifest,
+  std::string* reason) const {
+  const EngineOptions& options = engine_->get_options();
+  if (!is_warm_restart_enabled()) {
+    *reason = "warm restart is now disabled";
+    return false;
+  }
+  if (!manifest.clean_shutdown_) {
+    *reason = "the previous engine did not shut down cleanly";
+    return false;
+  }
+  if (manifest.soc_count_ != options.thread_.group_count_) {
+    *reason = "the number of SOCs has changed";
+    return false;
+  }
+  std::stringstream options_stream;
+  options.save_to_stream(&options_stream);
+  uint64_t xml_size = options_stream.str().size();
+  if (manifest.layout_fingerprint_
+    != SharedMemoryRepo::calculate_layout_fingerprint(xml_size, options)) {
+    *reason = "the memory layout has changed";
+    return false;
+  }
+
+  // The volatile pages must not contain anything newer than the durable epoch of savepoint.
+  // Otherwise, someone has restored an older savepoint and logs.
+  savepoint::Savepoint savepoint;
+  fs::Path savepoint_path(options.savepoint_.savepoint_path_.str());
+  if (!fs::exists(savepoint_path) || savepoint.load_from_file(savepoint_path).is_error()) {
+    *reason = "the savepoint file is not readable";
+    return false;
+  }
+  Epoch savepoint_durable(savepoint.durable_epoch_);
+  Epoch retained_durable(manifest.durable_epoch_);
+  if (!retained_durable.is_valid()
+    || !savepoint_durable.is_valid()
+    || savepoint_durable < retained_durable) {
+    *reason = "the savepoint is older than the retained volatile pages";
+    return false;
+  }
+  return true;
+}
+
+ErrorStack SocManagerPimpl::allocate_or_reattach_shared_memories() {
+  const EngineOptions& options = engine_->get_options();
+  const bool warm_enabled = is_warm_restart_enabled();
+  const std::string manifest_path(options.restart_.warm_restart_manifest_path_.str());
+  // Even if warm restart is now disabled, we reclaim what the previous master retained.
+  if (fs::exists(fs::Path(manifest_path))) {
+    SharedMemoryManifest manifest;
+    ErrorStack load_error = manifest.load_from_file(manifest_path);
+    if (load_error.is_error()) {
+      std::cerr << "[FOEDUS] Ignored a broken shared memory manifest. " << load_error << std::endl;
+    } else {
+      std::string reason;
+      if (is_reusable_manifest(manifest, &reason)) {
+        ErrorStack reattach_error = memory_repo_.reattach_shared_memories(
+          engine_->get_master_upid(),
+          engine_->get_master_eid(),
+          options,
+          manifest);
+        if (!reattach_error.is_error()) {
+          // from now on, we are responsible for them. if we crash, the next master reclaims.
+          SharedMemoryManifest running;
+          memory_repo_.describe_shared_memories(options, &running);
+          ErrorStack save_error = running.save_to_file(manifest_path);
+          if (save_error.is_error()) {
+            memory_repo_.deallocate_shared_memories();
+            return save_error;
+          }
+          return kRetOk;
+        }
+        std::stringstream str;
+        str << "re-attach failed. " << reattach_error;
+        reason = str.str();
+      }
+      std::cerr << "[FOEDUS] Retained shared memories are not reusable because " << reason
+        << ". Reclaiming them and falling back to cold restart." << std::endl;
+      manifest.reclaim_all();
+    }
+    fs::remove(fs::Path(manifest_path));
+  }
+
   ErrorStack alloc_error = memory_repo_.allocate_shared_memories(
     engine_->get_master_upid(),
     engine_->get_master_eid(),
-    engine_->get_options());
+    options);
   if (alloc_error.is_error()) {
     memory_repo_.deallocate_shared_memories();
     return alloc_error;
   }
+  if (warm_enabled) {
+    SharedMemoryManifest running;
+    memory_repo_.describe_shared_memories(options, &running);
+    ErrorStack save_error = running.save_to_file(manifest_path);
+    if (save_error.is_error()) {
+      memory_repo_.deallocate_shared_memories();
+      return save_error;
+    }
+  }
+  return kRetOk;
+}
+
+ErrorStack SocManagerPimpl::retain_or_release_shared_memories() {
+  ASSERT_ND(engine_->is_master());
+  ASSERT_ND(is_warm_restart_enabled());
+  const EngineOptions& options = engine_->get_options();
+  const std::string manifest_path(options.restart_.warm_restart_manifest_path_.str());
+  if (!memory_repo_.is_retain_at_shutdown()) {
+    // then the shared memories are released as usual. the manifest is now meaningless.
+    memory_repo_.deallocate_shared_memories();
+    fs::remove(fs::Path(manifest_path));
+    return kRetOk;
+  }
+
+  SharedMemoryManifest manifest;
+  memory_repo_.describe_shared_memories(options, &manifest);
+  manifest.clean_shutdown_ = true;
+  manifest.durable_epoch_ = memory_repo_.get_retained_durable_epoch().value();
+  memory_repo_.retain_shared_memories();
+  // If this fails, the unclean manifest written at startup still tells the next master
+  // what to reclaim.
+  return manifest.save_to_file(manifest_path);
+}
+
+ErrorStack SocManagerPimpl::initialize_master() {
+  CHECK_ERROR(allocate_or_reattach_shared_memories());
 
   // shared memory allocated. now launch child SOCs
   child_emulated_engines_.clear();
@@ -221,7 +350,11 @@ ErrorStack SocManagerPimpl::wait_for_child_attach() {
   // as soon as all children ack-ed, mark the shared memory for release.
   // no one will newly issue shmget.
   memory_repo_.change_master_status(MasterEngineStatus::kSharedMemoryReservedReclamation);
-  memory_repo_.mark_for_release();  // now it's safe. closed attaching and marked for reclaim.
+  if (!is_warm_restart_enabled()) {
+    memory_repo_.mark_for_release();  // now it's safe. closed attaching and marked for reclaim.
+  }
+  // Otherwise, we must not mark them because a marked key can never be shmget-ed again.
+  // Instead, the manifest written at startup allows the next master to reclaim them.
   return kRetOk;
 }
 
@@ -31,6 +31,11 @@ SocOptions::SocOptions() {
   shared_user_memory_size_kb_ = kDefaultSharedUserMemorySizeKb;
   spawn_executable_pattern_ = "";
   spawn_ld_library_path_pattern_ = "";
+  client_ring_slots_ = kDefaultClientRingSlots;
+  client_ring_slot_kb_ = kDefaultClientRingSlotKb;
+  client_ring_batch_size_ = kDefaultClientRingBatchSize;
+  client_ring_abandon_timeout_us_ = kDefaultClientRingAbandonTimeoutUs;
+  client_ring_path_pattern_ = "/tmp/foedus_client_ring_node_$NODE$";
 }
 
 std::string SocOptions::convert_spawn_executable_pattern(int node) const {
@@ -54,11 +59,20 @@ std::string SocOptions::convert_spawn_ld_library_path_pattern(int node) const {
   return assorted::replace_all(spawn_ld_library_path_pattern_.str(), "$NODE$", node);
 }
 
+std::string SocOptions::convert_client_ring_path_pattern(int node) const {
+  return assorted::replace_all(client_ring_path_pattern_.str(), "$NODE$", node);
+}
+
 ErrorStack SocOptions::load(tinyxml2::XMLElement* element) {
   EXTERNALIZE_LOAD_ENUM_ELEMENT(element, soc_type_);
   EXTERNALIZE_LOAD_ELEMENT(element, shared_user_memory_size_kb_);
   EXTERNALIZE_LOAD_ELEMENT(element, spawn_executable_pattern_);
   EXTERNALIZE_LOAD_ELEMENT(element, spawn_ld_library_path_pattern_);
+  EXTERNALIZE_LOAD_ELEMENT(element, client_ring_slots_);
+  EXTERNALIZE_LOAD_ELEMENT(element, client_ring_slot_kb_);
+  EXTERNALIZE_LOAD_ELEMENT(element, client_ring_batch_size_);
+  EXTERNALIZE_LOAD_ELEMENT(element, client_ring_abandon_timeout_us_);
+  EXTERNALIZE_LOAD_ELEMENT(element, client_ring_path_pattern_);
   return kRetOk;
 }
 
@@ -79,6 +93,19 @@ ErrorStack SocOptions::save(tinyxml2::XMLElement* element) const {
     "LD_LIBRARY_PATH environment variable to spawn SOC engines in each NUMA node.\n"
     " The default value is empty, which means we don't overwrite LD_LIBRARY_PATH of this master"
     " process. To overwrite master process's LD_LIBRARY_PATH with empty value, put one space etc.");
+  EXTERNALIZE_SAVE_ELEMENT(element, client_ring_slots_,
+    "The number of request slots in the client request ring of each NUMA node."
+    " 0 (default) disables client request rings. Rounded up to a power of two.");
+  EXTERNALIZE_SAVE_ELEMENT(element, client_ring_slot_kb_,
+    "Byte size of the input and output of one request in the client request ring, in KB.");
+  EXTERNALIZE_SAVE_ELEMENT(element, client_ring_batch_size_,
+    "The maximum number of requests a worker thread takes from the ring in a row.");
+  EXTERNALIZE_SAVE_ELEMENT(element, client_ring_abandon_timeout_us_,
+    "A slot in the client request ring is considered abandoned when its client does not"
+    " submit it or release it for this long after reserving it or after its completion.");
+  EXTERNALIZE_SAVE_ELEMENT(element, client_ring_path_pattern_,
+    "String pattern of the path of the meta file external processes use to attach the"
+    " client request ring of each NUMA node. '$NODE$' is replaced with the node number.");
   return kRetOk;
 }
 
@@ -127,9 +127,19 @@ ErrorStack ArrayComposer::construct_root(const Composer::ConstructRootArguments&
       WRAP_ERROR_CODE(args.previous_snapshot_files_->read_page(page_id, root_page));
       ASSERT_ND(root_page->header().storage_id_ == storage_id_);
       ASSERT_ND(root_page->header().page_id_ == page_id);
+    }
+    if (page_id != 0 && root_page->get_level() == levels - 1U) {
+      if (root_page->get_array_range() != range) {
+        // ArrayStorage::extend() widened the array after the previous snapshot
+        ASSERT_ND(root_page->get_array_range().begin_ == 0);
+        ASSERT_ND(root_page->get_array_range().end_ < range.end_);
+        root_page->extend_array_range(range.end_);
+      }
       ASSERT_ND(root_page->get_array_range() == range);
       root_page->header().page_id_ = new_page_id;
     } else {
+      // initial snapshot, or ArrayStorage::extend() added levels after the previous snapshot.
+      // in the latter case, the previous root page is now pointed from the left-most child.
       root_page->initialize_snapshot_page(
         system_initial_epoch,
         storage_id_,
@@ -175,6 +185,7 @@ ErrorStack ArrayComposer::construct_root(const Composer::ConstructRootArguments&
     storage_.get_control_block()->root_page_pointer_.snapshot_pointer_ = new_page_id;
     storage_.get_control_block()->meta_.root_snapshot_page_id_ = new_page_id;
   }
+  storage_.get_control_block()->snapshot_array_size_ = storage_.get_array_size();
   return kRetOk;
 }
 
@@ -205,12 +216,23 @@ ArrayComposeContext::ArrayComposeContext(
     root_info_page_(reinterpret_cast<ArrayRootInfoPage*>(root_info_page)),
     payload_size_(storage_.get_payload_size()),
     levels_(storage_.get_levels()),
-    previous_root_page_pointer_(storage_.get_metadata()->root_snapshot_page_id_) {
+    previous_root_page_pointer_(storage_.get_metadata()->root_snapshot_page_id_),
+    previous_array_size_(
+      previous_root_page_pointer_ == 0 ? 0 : storage_.get_control_block()->snapshot_array_size_) {
   LookupRouteFinder route_finder(levels_, payload_size_);
   offset_intervals_[0] = route_finder.get_records_in_leaf();
   for (uint8_t level = 1; level < levels_; ++level) {
     offset_intervals_[level] = offset_intervals_[level - 1] * kInteriorFanout;
   }
+  previous_levels_ = 0;
+  if (previous_array_size_ > 0) {
+    ASSERT_ND(previous_array_size_ <= storage_.get_array_size());
+    previous_levels_ = 1;
+    while (offset_intervals_[previous_levels_ - 1U] < previous_array_size_) {
+      ++previous_levels_;
+    }
+    ASSERT_ND(previous_levels_ <= levels_);
+  }
   std::memset(cur_path_, 0, sizeof(cur_path_));
 
   allocated_pages_ = 0;
@@ -344,7 +366,8 @@ void ArrayComposeContext::apply_batch(uint64_t cur, uint64_t next) {
 ErrorStack ArrayComposeContext::execute_single_level_array() {
   // no page-switch in this case
   ArrayRange range(0, storage_.get_array_size());
-  // single-page array. root is a leaf page.
+  // single-page array. root is a leaf page. If ArrayStorage::extend() was called after the
+  // previous snapshot, read_or_init_page() widens the previous root page.
   cur_path_[0] = page_base_;
   SnapshotPagePointer page_id = snapshot_writer_->get_next_page_id();
   ASSERT_ND(allocated_pages_ == 0);
@@ -388,6 +411,10 @@ ErrorStack ArrayComposeContext::finalize() {
     VLOG(0) << "Need to fill out empty pages in initial snapshot of array-" << storage_id_
       << ", from " << last_range.end_ << " to the end of array";
     WRAP_ERROR_CODE(create_empty_pages(last_range.end_, storage_.get_array_size()));
+  } else if (!is_initial_snapshot() && previous_array_size_ < storage_.get_array_size()) {
+    VLOG(0) << "Need to fill out pages of array-" << storage_id_ << " grown from "
+      << previous_array_size_ << " to " << storage_.get_array_size();
+    WRAP_ERROR_CODE(fill_grown_pages(0));
   }
 
   // flush the main buffer. now we finalized all leaf pages
@@ -519,8 +546,32 @@ ErrorStack ArrayComposeContext::init_root_page() {
   ASSERT_ND(allocated_intermediates_ == 0);
   allocated_intermediates_ = 1;
 
-  WRAP_ERROR_CODE(read_or_init_page(previous_root_page_pointer_, 0, level, range, page));
+  if (is_initial_snapshot() || previous_levels_ == levels_) {
+    WRAP_ERROR_CODE(read_or_init_page(previous_root_page_pointer_, 0, level, range, page));
+    cur_path_[level] = page;
+    return kRetOk;
+  }
+
+  // ArrayStorage::extend() added levels after the previous snapshot. The previous root page is
+  // now the left-most page in its level. We create new pages above it in the left-most path.
+  ASSERT_ND(previous_levels_ < levels_);
+  WRAP_ERROR_CODE(read_or_init_page(0, 0, level, range, page));
   cur_path_[level] = page;
+  const PartitionId partition = snapshot_writer_->get_numa_node();
+  if (partitioning_data_->partitionable_ && partitioning_data_->bucket_owners_[0] != partition) {
+    return kRetOk;
+  }
+  for (uint8_t child_level = level - 1U; child_level >= previous_levels_; --child_level) {
+    ArrayRange child_range(0, offset_intervals_[child_level], storage_.get_array_size());
+    WRAP_ERROR_CODE(create_empty_intermediate_page(
+      cur_path_[child_level + 1U],
+      0,
+      child_range));
+    cur_path_[child_level + 1U]->get_interior_record(0).snapshot_pointer_
+      = cur_path_[child_level]->header().page_id_;
+  }
+  cur_path_[previous_levels_]->get_interior_record(0).snapshot_pointer_
+    = previous_root_page_pointer_;
   return kRetOk;
 }
 
@@ -693,6 +744,89 @@ ErrorCode ArrayComposeContext::create_empty_leaf_page(
   return kErrorCodeOk;
 }
 
+ErrorCode ArrayComposeContext::fill_grown_pages(SnapshotPagePointer page_index) {
+  ASSERT_ND(!is_initial_snapshot());
+  ASSERT_ND(page_index < allocated_intermediates_);
+  const uint8_t level = intermediate_base_[page_index].get_level();
+  const ArrayRange range = intermediate_base_[page_index].get_array_range();
+  ASSERT_ND(level > 0);
+  ASSERT_ND(range.end_ > previous_array_size_);
+  const uint8_t child_level = level - 1U;
+  const uint64_t interval = offset_intervals_[child_level];
+  const uint16_t children = assorted::int_div_ceil(range.end_ - range.begin_, interval);
+  ASSERT_ND(children <= kInteriorFanout);
+  const PartitionId partition = snapshot_writer_->get_numa_node();
+  for (uint16_t i = 0; i < children; ++i) {
+    ArrayRange child_range(
+      range.begin_ + i * interval,
+      range.begin_ + (i + 1U) * interval,
+      range.end_);
+    if (child_range.end_ <= previous_array_size_) {
+      continue;  // not affected by the growth
+    } else if (level == levels_ - 1U
+      && partitioning_data_->partitionable_
+      && partitioning_data_->bucket_owners_[i] != partition) {
+      continue;
+    }
+
+    ArrayPage* page = intermediate_base_ + page_index;
+    const SnapshotPagePointer child_id = page->get_interior_record(i).snapshot_pointer_;
+    const snapshot::SnapshotId snapshot_id = extract_snapshot_id_from_snapshot_pointer(child_id);
+    if (child_id == 0) {
+      // a new sub-tree that received no logs
+      ASSERT_ND(child_range.begin_ >= previous_array_size_);
+      if (child_level > 0) {
+        CHECK_ERROR_CODE(create_empty_intermediate_page(page, i, child_range));
+        page = intermediate_base_ + page_index;  // the pool might have been expanded
+        page->get_interior_record(i).snapshot_pointer_ = cur_path_[child_level]->header().page_id_;
+        CHECK_ERROR_CODE(create_empty_pages_recurse(
+          child_range.begin_,
+          child_range.end_,
+          cur_path_[child_level]));
+      } else {
+        CHECK_ERROR_CODE(create_empty_leaf_page(page, i, child_range));
+      }
+    } else if (snapshot_id == snapshot_id_) {
+      // a leaf page that received logs. we have widened it when we read it.
+      ASSERT_ND(child_level == 0);
+    } else if (snapshot_id == snapshot::kNullSnapshotId) {
+      // an intermediate page that received logs. its descendants might not.
+      ASSERT_ND(child_level > 0);
+      CHECK_ERROR_CODE(fill_grown_pages(child_id));
+    } else {
+      // the right-most page of the previous snapshot that received no logs. widen it.
+      ASSERT_ND(child_range.begin_ < previous_array_size_);
+      SnapshotPagePointer new_page_id;
+      if (child_level > 0) {
+        CHECK_ERROR_CODE(expand_intermediate_pool_if_needed());
+        new_page_id = allocated_intermediates_;
+        ++allocated_intermediates_;
+        CHECK_ERROR_CODE(read_or_init_page(
+          child_id,
+          new_page_id,
+          child_level,
+          child_range,
+          intermediate_base_ + new_page_id));
+      } else {
+        if (allocated_pages_ >= max_pages_) {
+          CHECK_ERROR_CODE(dump_leaf_pages());
+          ASSERT_ND(allocated_pages_ == 0);
+        }
+        new_page_id = snapshot_writer_->get_next_page_id() + allocated_pages_;
+        ASSERT_ND(verify_snapshot_pointer(new_page_id));
+        ArrayPage* leaf = page_base_ + allocated_pages_;
+        ++allocated_pages_;
+        CHECK_ERROR_CODE(read_or_init_page(child_id, new_page_id, 0, child_range, leaf));
+      }
+      intermediate_base_[page_index].get_interior_record(i).snapshot_pointer_ = new_page_id;
+      if (child_level > 0) {
+        CHECK_ERROR_CODE(fill_grown_pages(new_page_id));
+      }
+    }
+  }
+  return kErrorCodeOk;
+}
+
 inline ErrorCode ArrayComposeContext::expand_intermediate_pool_if_needed() {
   ASSERT_ND(allocated_intermediates_ <= max_intermediates_);
   if (UNLIKELY(allocated_intermediates_ == max_intermediates_)) {
@@ -749,7 +883,7 @@ ErrorCode ArrayComposeContext::update_cur_path(ArrayOffset next_offset) {
     ASSERT_ND(pointer.volatile_pointer_.is_null());
     SnapshotPagePointer old_page_id = pointer.snapshot_pointer_;
     ASSERT_ND((!is_initial_snapshot() && old_page_id != 0)
-      || (is_initial_snapshot() && old_page_id == 0));
+      || (old_page_id == 0 && child_range.begin_ >= previous_array_size_));
 
     ArrayPage* page;
     SnapshotPagePointer new_page_id;
@@ -795,10 +929,17 @@ inline ErrorCode ArrayComposeContext::read_or_init_page(
     ASSERT_ND(page->header().storage_id_ == storage_id_);
     ASSERT_ND(page->header().page_id_ == old_page_id);
     ASSERT_ND(page->get_level() == level);
-    ASSERT_ND(page->get_array_range() == range);
+    if (page->get_array_range() != range) {
+      // a right-most page of the previous snapshot. ArrayStorage::extend() widened it.
+      ASSERT_ND(page->get_array_range().begin_ == range.begin_);
+      ASSERT_ND(page->get_array_range().end_ == previous_array_size_);
+      ASSERT_ND(range.end_ > previous_array_size_);
+      page->extend_array_range(range.end_);
+    }
     page->header().page_id_ = new_page_id;
   } else {
-    ASSERT_ND(is_initial_snapshot());
+    // the page didn't exist in the previous snapshot
+    ASSERT_ND(level >= previous_levels_ || range.begin_ >= previous_array_size_);
     page->initialize_snapshot_page(
       system_initial_epoch_,
       storage_id_,
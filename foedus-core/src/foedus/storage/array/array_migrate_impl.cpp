@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include "foedus/storage/array/array_migrate_impl.hpp"
+
+#include <glog/logging.h>
+
+#include <cstring>
+
+#include "foedus/assert_nd.hpp"
+#include "foedus/assorted/atomic_fences.hpp"
+#include "foedus/storage/page.hpp"
+#include "foedus/storage/record.hpp"
+#include "foedus/storage/array/array_id.hpp"
+#include "foedus/storage/array/array_page_impl.hpp"
+#include "foedus/thread/thread.hpp"
+
+namespace foedus {
+namespace storage {
+namespace array {
+
+ErrorCode ArrayMigrateLeaf::run(xct::SysxctWorkspace* sysxct_workspace) {
+  ASSERT_ND(!observed_.is_null());
+  migrated_ = false;
+  if (observed_.get_numa_node() == context_->get_numa_node()) {
+    return kErrorCodeOk;
+  }
+  ArrayPage* target = reinterpret_cast<ArrayPage*>(context_->resolve(observed_));
+  ASSERT_ND(!target->header().snapshot_);
+  ASSERT_ND(target->is_leaf());
+
+  // First, lock the page. The page's lock state is before all the records in the page,
+  // so we can simply lock it first.
+  CHECK_ERROR_CODE(context_->sysxct_page_lock(sysxct_workspace, reinterpret_cast<Page*>(target)));
+
+  // The lock involves atomic operation, so now all we see are finalized.
+  if (target->header().page_version_.is_moved() || pointer_->volatile_pointer_ != observed_) {
+    DVLOG(0) << "Interesting. the page has been already migrated";
+    return kErrorCodeOk;
+  }
+
+  memory::PagePoolOffset offsets[1];
+  thread::GrabFreeVolatilePagesScope free_pages_scope(context_, offsets);
+  CHECK_ERROR_CODE(free_pages_scope.grab(1));
+  VolatilePagePointer new_page_id;
+  new_page_id.set(context_->get_numa_node(), offsets[0]);
+  ArrayPage* new_page = reinterpret_cast<ArrayPage*>(
+    context_->get_local_volatile_page_resolver().resolve_offset_newpage(offsets[0]));
+
+  // lock all records. unlike masstree, all records in array pages always exist.
+  const uint16_t payload_size = target->get_payload_size();
+  const uint16_t record_count = target->get_leaf_record_count();
+  xct::RwLockableXctId* record_locks[kDataSize / kRecordOverhead];
+  ASSERT_ND(record_count <= kDataSize / kRecordOverhead);
+  for (uint16_t i = 0; i < record_count; ++i) {
+    record_locks[i] = &target->get_leaf_record(i, payload_size)->owner_id_;
+  }
+  CHECK_ERROR_CODE(context_->sysxct_batch_record_locks(
+    sysxct_workspace,
+    observed_,
+    record_count,
+    record_locks));
+
+  // Nobody can modify the page now. Copy the whole page, then fix the new page's locks and ID.
+  std::memcpy(reinterpret_cast<void*>(new_page), reinterpret_cast<const void*>(target), kPageSize);
+  new_page->header().page_id_ = new_page_id.word;
+  new_page->header().page_version_.reset();
+  for (uint16_t i = 0; i < record_count; ++i) {
+    xct::RwLockableXctId* owner_id = &new_page->get_leaf_record(i, payload_size)->owner_id_;
+    ASSERT_ND(owner_id->is_keylocked());
+    owner_id->get_key_lock()->reset();  // no race
+  }
+
+  // Now we will install the new page. **From now on no error-return allowed**
+  assorted::memory_fence_release();
+  // We install the pointer to the page AFTER we initialize the page.
+  pointer_->volatile_pointer_.word = new_page_id.word;
+  free_pages_scope.dispatch(0);
+  assorted::memory_fence_release();
+
+  // invoking set_moved is the point we announce all of these changes. take fence to make it right
+  target->header().page_version_.set_moved();
+  assorted::memory_fence_release();
+
+  // set the "moved" bit so that concurrent transactions
+  // track the records in the new page for read-set/write-set checks.
+  for (uint16_t i = 0; i < record_count; ++i) {
+    target->get_leaf_record(i, payload_size)->owner_id_.xct_id_.set_moved();
+  }
+  target->header().page_version_.set_retired();
+  assorted::memory_fence_release();
+
+  // Concurrent threads might be still reading the old page. It is reclaimed after grace period.
+  context_->collect_retired_volatile_page(observed_);
+  migrated_ = true;
+  DVLOG(1) << "Migrated an array leaf page " << observed_ << " to " << new_page_id;
+  return kErrorCodeOk;
+}
+
+}  // namespace array
+}  // namespace storage
+}  // namespace foedus
@@ -91,8 +91,9 @@ void array_volatile_page_init(const VolatilePageInitArguments& args) {
   ArrayRange parent_range = parent->get_array_range();
   uint8_t parent_level = parent->get_level();
   ASSERT_ND(parent_level > 0);
-  ASSERT_ND(parent_range.end_ - parent_range.begin_ == cb->intervals_[parent_level]
-    || parent_range.end_ == storage.get_array_size());
+  // The right-most page is narrower. While ArrayStorage::extend() is in progress, its range
+  // might be already widened while get_array_size() is not yet. Hence we cap with the parent.
+  ASSERT_ND(parent_range.end_ - parent_range.begin_ <= cb->intervals_[parent_level]);
 
   uint8_t child_level = parent_level - 1U;
   uint64_t interval = cb->intervals_[child_level];
@@ -100,8 +101,8 @@ void array_volatile_page_init(const VolatilePageInitArguments& args) {
   ArrayRange child_range;
   child_range.begin_ = parent_range.begin_ + args.index_in_parent_ * interval;
   child_range.end_ = child_range.begin_ + interval;
-  if (child_range.end_ > storage.get_array_size()) {
-    child_range.end_ = storage.get_array_size();
+  if (child_range.end_ > parent_range.end_) {
+    child_range.end_ = parent_range.end_;
   }
   ASSERT_ND(child_range.end_ > 0);
 
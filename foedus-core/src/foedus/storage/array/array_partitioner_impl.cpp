@@ -86,11 +86,21 @@ ErrorStack ArrayPartitioner::design_partition(
   data_->array_levels_ = storage.get_levels();
   data_->array_size_ = storage.get_array_size();
 
-  if (storage.get_levels() == 1U || engine_->get_soc_count() == 1U) {
+  // If ArrayStorage::extend() grew the array after the previous snapshot, a single composer
+  // composes it so that the pages of the previous and new range are consistently widened.
+  // The next snapshot is partitioned again.
+  const bool grown = control_block->snapshot_array_size_ != 0
+    && control_block->snapshot_array_size_ < storage.get_array_size();
+  if (grown) {
+    LOG(INFO) << "Array-" << id_ << " has grown from " << control_block->snapshot_array_size_
+      << " to " << storage.get_array_size() << " since the previous snapshot. Not partitioned.";
+  }
+  if (storage.get_levels() == 1U || engine_->get_soc_count() == 1U || grown) {
     // No partitioning needed.
     data_->bucket_owners_[0] = 0;
     data_->partitionable_ = false;
     data_->bucket_size_ = data_->array_size_;
+    metadata_->access_statistics_.clear();
     metadata_->valid_ = true;
     return kRetOk;
   }
@@ -131,12 +141,25 @@ ErrorStack ArrayPartitioner::design_partition(
 
   // two paths. first path simply sees volatile/snapshot pointer and determines owner.
   // second path addresses excessive assignments, off loading them to needy ones.
+  // If the access statistics say a node mostly read the child since the previous snapshot,
+  // the first path assigns it to the node, and the second path doesn't off load it.
+  PartitionerAccessStatistics* statistics = &metadata_->access_statistics_;
   std::vector<uint16_t> counts(total_partitions, 0);
   const uint16_t excessive_count = (direct_children / total_partitions) + 1;
   std::vector<uint16_t> excessive_children;
+  std::vector<uint64_t> low_keys;
+  low_keys.reserve(direct_children);
   for (uint16_t child = 0; child < direct_children; ++child) {
     const DualPagePointer &pointer = root_page->get_interior_record(child);
+    const ArrayOffset low = child * data_->bucket_size_;
+    low_keys.push_back(low);
     PartitionId partition;
+    if (statistics->find_dominant_node(low, low + data_->bucket_size_, &partition)
+      && partition < total_partitions) {
+      ++counts[partition];
+      data_->bucket_owners_[child] = partition;
+      continue;
+    }
     if (!pointer.volatile_pointer_.is_null()) {
       partition = pointer.volatile_pointer_.get_numa_node();
     } else {
@@ -168,6 +191,8 @@ ErrorStack ArrayPartitioner::design_partition(
     data_->bucket_owners_[child] = most_needy;
   }
 
+  // from now on, sample accesses per direct child for the next snapshot
+  statistics->reset(&low_keys[0], low_keys.size());
   metadata_->valid_ = true;
   return kRetOk;
 }
@@ -19,15 +19,20 @@
 
 #include <glog/logging.h>
 
+#include <algorithm>
+#include <cstring>
 #include <string>
 #include <vector>
 
 #include "foedus/engine.hpp"
 #include "foedus/assorted/assorted_func.hpp"
 #include "foedus/assorted/cacheline.hpp"
+#include "foedus/assorted/raw_atomics.hpp"
 #include "foedus/cache/snapshot_file_set.hpp"
 #include "foedus/debugging/stop_watch.hpp"
+#include "foedus/log/log_manager.hpp"
 #include "foedus/log/log_type.hpp"
+#include "foedus/log/meta_log_buffer.hpp"
 #include "foedus/log/thread_log_buffer.hpp"
 #include "foedus/memory/engine_memory.hpp"
 #include "foedus/memory/memory_id.hpp"
@@ -35,12 +40,16 @@
 #include "foedus/memory/page_pool.hpp"
 #include "foedus/savepoint/savepoint_manager.hpp"
 #include "foedus/snapshot/snapshot.hpp"
+#include "foedus/snapshot/snapshot_manager.hpp"
+#include "foedus/snapshot/snapshot_manager_pimpl.hpp"
+#include "foedus/soc/shared_mutex.hpp"
 #include "foedus/storage/record.hpp"
 #include "foedus/storage/storage_manager.hpp"
 #include "foedus/storage/storage_manager_pimpl.hpp"
 #include "foedus/storage/array/array_id.hpp"
 #include "foedus/storage/array/array_log_types.hpp"
 #include "foedus/storage/array/array_metadata.hpp"
+#include "foedus/storage/array/array_migrate_impl.hpp"
 #include "foedus/storage/array/array_page_impl.hpp"
 #include "foedus/storage/array/array_storage.hpp"
 #include "foedus/thread/thread.hpp"
@@ -191,9 +200,8 @@ std::vector<uint64_t> ArrayStoragePimpl::calculate_required_pages(
   return pages;
 }
 
-uint8_t calculate_levels(const ArrayMetadata &metadata) {
-  uint64_t array_size = metadata.array_size_;
-  uint16_t payload = assorted::align8(metadata.payload_size_);
+uint8_t calculate_levels(uint16_t payload_size, ArrayOffset array_size) {
+  uint16_t payload = assorted::align8(payload_size);
   uint64_t records_per_page = kDataSize / (payload + kRecordOverhead);
   uint8_t levels = 1;
   for (uint64_t pages = assorted::int_div_ceil(array_size, records_per_page);
@@ -204,6 +212,10 @@ uint8_t calculate_levels(const ArrayMetadata &metadata) {
   return levels;
 }
 
+uint8_t calculate_levels(const ArrayMetadata &metadata) {
+  return calculate_levels(metadata.payload_size_, metadata.array_size_);
+}
+
 void ArrayStoragePimpl::release_pages_recursive(
   const memory::GlobalVolatilePageResolver& resolver,
   memory::PageReleaseBatch* batch,
@@ -251,22 +263,41 @@ std::vector<uint64_t> ArrayStoragePimpl::calculate_offset_intervals(
   return offset_intervals;
 }
 
+uint8_t ArrayStoragePimpl::calculate_route(
+  ArrayOffset array_size,
+  LookupRouteFinder* route_finder,
+  uint64_t* intervals) const {
+  const uint8_t levels = calculate_levels(get_payload_size(), array_size);
+  *route_finder = LookupRouteFinder(levels, get_payload_size());
+  std::memset(intervals, 0, sizeof(uint64_t) * kMaxLevels);
+  intervals[0] = route_finder->get_records_in_leaf();
+  for (uint16_t level = 1; level < levels; ++level) {
+    intervals[level] = intervals[level - 1U] * kInteriorFanout;
+  }
+  return levels;
+}
+
+uint8_t ArrayStoragePimpl::set_route(ArrayOffset array_size) {
+  LookupRouteFinder route_finder;
+  uint64_t intervals[kMaxLevels];
+  const uint8_t levels = calculate_route(array_size, &route_finder, intervals);
+  control_block_->route_finder_ = route_finder;
+  std::memcpy(control_block_->intervals_, intervals, sizeof(intervals));
+  return levels;
+}
+
 ErrorStack ArrayStoragePimpl::load_empty() {
-  const uint16_t levels = calculate_levels(control_block_->meta_);
   const uint32_t payload_size = control_block_->meta_.payload_size_;
   const ArrayOffset array_size = control_block_->meta_.array_size_;
   if (array_size > kMaxArrayOffset) {
     return ERROR_STACK(kErrorCodeStrTooLargeArray);
   }
+  const uint16_t levels = set_route(array_size);
   control_block_->levels_ = levels;
-  control_block_->route_finder_ = LookupRouteFinder(levels, payload_size);
+  control_block_->snapshot_array_size_ = 0;
   control_block_->root_page_pointer_.snapshot_pointer_ = 0;
   control_block_->root_page_pointer_.volatile_pointer_.word = 0;
   control_block_->meta_.root_snapshot_page_id_ = 0;
-  control_block_->intervals_[0] = control_block_->route_finder_.get_records_in_leaf();
-  for (uint16_t level = 1; level < levels; ++level) {
-    control_block_->intervals_[level] = control_block_->intervals_[level - 1U] * kInteriorFanout;
-  }
 
   VolatilePagePointer volatile_pointer;
   ArrayPage* volatile_root;
@@ -302,9 +333,7 @@ ErrorStack ArrayStoragePimpl::load(const StorageControlBlock& snapshot_block) {
   control_block_->meta_ = static_cast<const ArrayMetadata&>(snapshot_block.meta_);
   const ArrayMetadata& meta = control_block_->meta_;
   ASSERT_ND(meta.root_snapshot_page_id_ != 0);
-  const uint16_t levels = calculate_levels(meta);
-  control_block_->levels_ = levels;
-  control_block_->route_finder_ = LookupRouteFinder(levels, get_payload_size());
+  control_block_->levels_ = set_route(meta.array_size_);
   control_block_->root_page_pointer_.snapshot_pointer_ = meta.root_snapshot_page_id_;
   control_block_->root_page_pointer_.volatile_pointer_.word = 0;
 
@@ -322,6 +351,7 @@ ErrorStack ArrayStoragePimpl::load(const StorageControlBlock& snapshot_block) {
       &volatile_pointer,
       &volatile_root));
     control_block_->root_page_pointer_.volatile_pointer_ = volatile_pointer;
+    CHECK_ERROR(grow_volatile_pages(&fileset));
     CHECK_ERROR(fileset.uninitialize());
   } else {
     LOG(INFO) << "Loading an empty array-storage-" << get_meta();
@@ -333,6 +363,273 @@ ErrorStack ArrayStoragePimpl::load(const StorageControlBlock& snapshot_block) {
   return kRetOk;
 }
 
+ErrorStack ArrayStoragePimpl::load_snapshot_view(const StorageControlBlock& snapshot_block) {
+  control_block_->meta_ = static_cast<const ArrayMetadata&>(snapshot_block.meta_);
+  const ArrayMetadata& meta = control_block_->meta_;
+  control_block_->levels_ = set_route(meta.array_size_);
+  control_block_->root_page_pointer_.snapshot_pointer_ = meta.root_snapshot_page_id_;
+  control_block_->root_page_pointer_.volatile_pointer_.word = 0;
+  // the snapshot's root covers the array size as of the snapshot
+  control_block_->snapshot_array_size_ = meta.array_size_;
+  control_block_->status_ = kExists;
+  return kRetOk;
+}
+
+
+ErrorStack ArrayStoragePimpl::extend(ArrayOffset new_array_size, Epoch* commit_epoch) {
+  LOG(INFO) << "Extending " << get_meta().name_ << " to " << new_array_size
+    << " records. old value=" << get_array_size();
+  if (new_array_size > kMaxArrayOffset) {
+    return ERROR_STACK(kErrorCodeStrTooLargeArray);
+  }
+
+  // Snapshot assumes that the shape of storages doesn't change, so we wait for it.
+  // This also serializes concurrent extend().
+  snapshot::SnapshotManagerControlBlock* snapshot_block
+    = engine_->get_snapshot_manager()->get_pimpl()->control_block_;
+  soc::SharedMutexScope snapshot_scope(&snapshot_block->snapshot_mutex_);
+  if (new_array_size <= get_array_size()) {
+    LOG(INFO) << "Already " << get_array_size() << " records. Requested = " << new_array_size;
+    return kRetOk;
+  }
+  // Logs pre-gleaned for the next snapshot were partitioned for the current shape.
+  snapshot_block->gleaner_.discard_pregleaned();
+
+  cache::SnapshotFileSet fileset(engine_);
+  CHECK_ERROR(fileset.initialize());
+  UninitializeGuard fileset_guard(&fileset, UninitializeGuard::kWarnIfUninitializeError);
+  VolatilePagePointer new_roots[kMaxLevels];
+  CHECK_ERROR(prepare_extend(&fileset, new_array_size, new_roots));
+
+  // Log this operation as a metadata operation. We get a commit_epoch here.
+  // NOTE: Below, we must NOT have any error-return path. prepare_extend() did all we might fail.
+  {
+    char log_buffer[sizeof(ArrayExtendLogType)];
+    std::memset(log_buffer, 0, sizeof(log_buffer));
+    ArrayExtendLogType* the_log = reinterpret_cast<ArrayExtendLogType*>(log_buffer);
+    the_log->header_.storage_id_ = get_id();
+    the_log->header_.log_type_code_ = log::get_log_code<ArrayExtendLogType>();
+    the_log->header_.log_length_ = sizeof(ArrayExtendLogType);
+    the_log->new_array_size_ = new_array_size;
+    engine_->get_log_manager()->get_meta_buffer()->commit(the_log, commit_epoch);
+  }
+
+  commit_extend(new_array_size, new_roots);
+  CHECK_ERROR(fileset.uninitialize());
+  LOG(INFO) << "Extended. levels=" << static_cast<int>(get_levels());
+  return kRetOk;
+}
+
+void ArrayStoragePimpl::apply_extend(const ArrayExtendLogType& the_log) {
+  // this method is called only during restart, so no race.
+  ASSERT_ND(control_block_->exists());
+  if (the_log.new_array_size_ <= get_array_size()) {
+    LOG(INFO) << "The snapshot already contains the extension of array-" << get_id();
+    return;
+  }
+  cache::SnapshotFileSet fileset(engine_);
+  COERCE_ERROR(fileset.initialize());
+  VolatilePagePointer new_roots[kMaxLevels];
+  COERCE_ERROR(prepare_extend(&fileset, the_log.new_array_size_, new_roots));
+  commit_extend(the_log.new_array_size_, new_roots);
+  COERCE_ERROR(fileset.uninitialize());
+  LOG(INFO) << "Applied redo-log of extension on array storage- " << get_meta().name_
+    << " size=" << get_array_size();
+}
+
+ErrorStack ArrayStoragePimpl::prepare_extend(
+  cache::SnapshotFileSet* fileset,
+  ArrayOffset new_array_size,
+  VolatilePagePointer* new_roots) {
+  ASSERT_ND(new_array_size >= get_array_size());
+  memory::EngineMemory* memory = engine_->get_memory_manager();
+  const memory::GlobalVolatilePageResolver& resolver = memory->get_global_volatile_page_resolver();
+  // Nothing visible to transactions yet. The new routes are published in commit_extend().
+  LookupRouteFinder new_route_finder;
+  uint64_t intervals[kMaxLevels];
+  const uint8_t new_levels = calculate_route(new_array_size, &new_route_finder, intervals);
+  for (uint8_t level = 0; level < kMaxLevels; ++level) {
+    new_roots[level].clear();
+  }
+
+  // Follow the right-most path, installing volatile pages as a transaction would do.
+  // We stop at a page that is already full because its descendants are full, too.
+  const Epoch initial_epoch = engine_->get_savepoint_manager()->get_initial_current_epoch();
+  DualPagePointer* pointer = &control_block_->root_page_pointer_;
+  const ArrayPage* parent = nullptr;
+  uint16_t index = 0;
+  while (true) {
+    VolatilePagePointer volatile_pointer = pointer->volatile_pointer_;
+    if (volatile_pointer.is_null()) {
+      VolatilePagePointer new_pointer;
+      Page* new_page;
+      if (pointer->snapshot_pointer_ != 0) {
+        CHECK_ERROR(memory->load_one_volatile_page(
+          fileset,
+          pointer->snapshot_pointer_,
+          &new_pointer,
+          &new_page));
+      } else {
+        ASSERT_ND(parent);  // root page always has a snapshot page or a volatile page
+        CHECK_ERROR(memory->grab_one_volatile_page(0, &new_pointer, &new_page));
+        const ArrayRange& parent_range = parent->get_array_range();
+        const uint64_t interval = intervals[parent->get_level() - 1U];
+        reinterpret_cast<ArrayPage*>(new_page)->initialize_volatile_page(
+          initial_epoch,
+          get_id(),
+          new_pointer,
+          get_payload_size(),
+          parent->get_level() - 1U,
+          ArrayRange(
+            parent_range.begin_ + index * interval,
+            parent_range.begin_ + (index + 1U) * interval,
+            parent_range.end_));
+      }
+      uint64_t expected = 0;
+      if (assorted::raw_atomic_compare_exchange_strong<uint64_t>(
+        &pointer->volatile_pointer_.word,
+        &expected,
+        new_pointer.word)) {
+        volatile_pointer = new_pointer;
+      } else {
+        // someone else has installed it
+        memory->get_node_memory(new_pointer.get_numa_node())->get_volatile_pool()->release_one(
+          new_pointer.get_offset());
+        volatile_pointer.word = expected;
+      }
+    }
+
+    ArrayPage* page = reinterpret_cast<ArrayPage*>(resolver.resolve_offset(volatile_pointer));
+    const ArrayRange& range = page->get_array_range();
+    const uint8_t level = page->get_level();
+    if (page->is_leaf() || range.end_ - range.begin_ == intervals[level]) {
+      break;
+    }
+    index = (range.end_ - 1U - range.begin_) / intervals[level - 1U];
+    pointer = &page->get_interior_record(index);
+    parent = page;
+  }
+
+  // Then, grab pages to put above the current root, if we need more levels.
+  const ArrayPage* root = reinterpret_cast<const ArrayPage*>(
+    resolver.resolve_offset(control_block_->root_page_pointer_.volatile_pointer_));
+  for (uint8_t level = root->get_level() + 1U; level < new_levels; ++level) {
+    Page* page;
+    ErrorStack result = memory->grab_one_volatile_page(0, &new_roots[level], &page);
+    if (result.is_error()) {
+      for (uint8_t i = root->get_level() + 1U; i < level; ++i) {
+        memory->get_node_memory(new_roots[i].get_numa_node())->get_volatile_pool()->release_one(
+          new_roots[i].get_offset());
+      }
+      return result;
+    }
+  }
+  return kRetOk;
+}
+
+void ArrayStoragePimpl::commit_extend(
+  ArrayOffset new_array_size,
+  const VolatilePagePointer* new_roots) {
+  const memory::GlobalVolatilePageResolver& resolver
+    = engine_->get_memory_manager()->get_global_volatile_page_resolver();
+  LookupRouteFinder new_route_finder;
+  uint64_t intervals[kMaxLevels];
+  const uint8_t new_levels = calculate_route(new_array_size, &new_route_finder, intervals);
+  VolatilePagePointer root_pointer = control_block_->root_page_pointer_.volatile_pointer_;
+  ArrayPage* root = reinterpret_cast<ArrayPage*>(resolver.resolve_offset(root_pointer));
+
+  // Widen the right-most path from the top. prepare_extend() installed volatile pages in it.
+  // Nobody accesses the new range yet, so concurrent transactions see no difference.
+  for (ArrayPage* page = root;;) {
+    const ArrayRange range = page->get_array_range();
+    const uint8_t level = page->get_level();
+    const uint64_t capacity = intervals[level];
+    if (range.end_ - range.begin_ == capacity) {
+      break;
+    }
+    page->extend_array_range(std::min<ArrayOffset>(range.begin_ + capacity, new_array_size));
+    if (page->is_leaf()) {
+      break;
+    }
+    uint16_t index = (range.end_ - 1U - range.begin_) / intervals[level - 1U];
+    VolatilePagePointer child = page->get_interior_record(index).volatile_pointer_;
+    ASSERT_ND(!child.is_null());
+    page = reinterpret_cast<ArrayPage*>(resolver.resolve_offset(child));
+  }
+
+  // Put new pages above the current root. The current root becomes the left-most child.
+  // Its snapshot pointer is installed by the next snapshot.
+  const Epoch initial_epoch = engine_->get_savepoint_manager()->get_initial_current_epoch();
+  for (uint8_t level = root->get_level() + 1U; level < new_levels; ++level) {
+    ASSERT_ND(!new_roots[level].is_null());
+    ArrayPage* page = reinterpret_cast<ArrayPage*>(resolver.resolve_offset_newpage(
+      new_roots[level]));
+    page->initialize_volatile_page(
+      initial_epoch,
+      get_id(),
+      new_roots[level],
+      get_payload_size(),
+      level,
+      ArrayRange(0, intervals[level], new_array_size));
+    page->get_interior_record(0).volatile_pointer_ = root_pointer;
+    root_pointer = new_roots[level];
+  }
+  assorted::memory_fence_release();
+  control_block_->root_page_pointer_.volatile_pointer_ = root_pointer;
+  assorted::memory_fence_release();
+
+  // Only now the routes for the new size point to existing pages. Offsets in the old range have
+  // the same routes except the levels above the old root, which are always 0 (left-most).
+  control_block_->route_finder_ = new_route_finder;
+  std::memcpy(control_block_->intervals_, intervals, sizeof(intervals));
+  control_block_->levels_ = new_levels;
+
+  // Also set to the metadata to make this permanent.
+  // The metadata will be written out in next snapshot.
+  // Until that, REDO-operation will re-apply that after crash.
+  control_block_->meta_.array_size_ = new_array_size;
+  assorted::memory_fence_release();
+}
+
+ErrorStack ArrayStoragePimpl::grow_volatile_pages(cache::SnapshotFileSet* fileset) {
+  const memory::GlobalVolatilePageResolver& resolver
+    = engine_->get_memory_manager()->get_global_volatile_page_resolver();
+  const ArrayPage* root = reinterpret_cast<const ArrayPage*>(
+    resolver.resolve_offset(control_block_->root_page_pointer_.volatile_pointer_));
+  ASSERT_ND(root->get_array_range().begin_ == 0);
+  control_block_->snapshot_array_size_ = root->get_array_range().end_;
+  const ArrayOffset array_size = get_array_size();
+  if (control_block_->snapshot_array_size_ < array_size) {
+    LOG(INFO) << "Array-" << get_id() << " has " << array_size << " records while the snapshot"
+      << " has " << control_block_->snapshot_array_size_ << ". Growing volatile pages";
+    VolatilePagePointer new_roots[kMaxLevels];
+    CHECK_ERROR(prepare_extend(fileset, array_size, new_roots));
+    commit_extend(array_size, new_roots);
+  }
+  return kRetOk;
+}
+
+void ArrayStoragePimpl::release_volatile_pages_except_root() {
+  VolatilePagePointer root_pointer = control_block_->root_page_pointer_.volatile_pointer_;
+  if (root_pointer.is_null()) {
+    return;
+  }
+  const memory::GlobalVolatilePageResolver& resolver
+    = engine_->get_memory_manager()->get_global_volatile_page_resolver();
+  ArrayPage* root = reinterpret_cast<ArrayPage*>(resolver.resolve_offset(root_pointer));
+  if (root->is_leaf()) {
+    return;
+  }
+  memory::PageReleaseBatch release_batch(engine_);
+  for (uint16_t i = 0; i < kInteriorFanout; ++i) {
+    DualPagePointer& child_pointer = root->get_interior_record(i);
+    if (!child_pointer.volatile_pointer_.is_null()) {
+      release_pages_recursive(resolver, &release_batch, child_pointer.volatile_pointer_);
+      child_pointer.volatile_pointer_.clear();
+    }
+  }
+  release_batch.release_all();
+}
 
 inline ErrorCode ArrayStoragePimpl::locate_record_for_read(
   thread::Thread* context,
@@ -379,6 +676,17 @@ inline ErrorCode ArrayStoragePimpl::get_record(
   Record *record = nullptr;
   bool snapshot_record;
   CHECK_ERROR_CODE(locate_record_for_read(context, offset, &record, &snapshot_record));
+  if (UNLIKELY(context->get_current_xct().is_multi_version())) {
+    return engine_->get_xct_manager()->read_multi_version(
+      context,
+      get_id(),
+      offset,
+      &record->owner_id_,
+      record->payload_,
+      payload,
+      payload_offset,
+      payload_count);
+  }
   CHECK_ERROR_CODE(context->get_current_xct().on_record_read(false, &record->owner_id_));
   std::memcpy(payload, record->payload_ + payload_offset, payload_count);
   return kErrorCodeOk;
@@ -394,6 +702,17 @@ ErrorCode ArrayStoragePimpl::get_record_primitive(
   Record *record = nullptr;
   bool snapshot_record;
   CHECK_ERROR_CODE(locate_record_for_read(context, offset, &record, &snapshot_record));
+  if (UNLIKELY(context->get_current_xct().is_multi_version())) {
+    return engine_->get_xct_manager()->read_multi_version(
+      context,
+      get_id(),
+      offset,
+      &record->owner_id_,
+      record->payload_,
+      payload,
+      payload_offset,
+      sizeof(T));
+  }
   CHECK_ERROR_CODE(context->get_current_xct().on_record_read(false, &record->owner_id_));
   char* ptr = record->payload_ + payload_offset;
   *payload = *reinterpret_cast<const T*>(ptr);
@@ -544,8 +863,13 @@ inline ErrorCode ArrayStoragePimpl::lookup_for_read(
   ASSERT_ND(index);
   ArrayPage* current_page;
   CHECK_ERROR_CODE(get_root_page(context, false, &current_page));
-  uint16_t levels = get_levels();
-  ASSERT_ND(current_page->get_array_range().contains(offset));
+  // We follow the level of the root page we got rather than get_levels(). They differ in the
+  // root snapshot page taken before extend(), which might not even contain the offset.
+  uint16_t levels = current_page->get_level() + 1U;
+  if (UNLIKELY(!current_page->get_array_range().contains(offset))) {
+    ASSERT_ND(current_page->header().snapshot_);
+    return kErrorCodeXctNoSnapshotPage;
+  }
   LookupRoute route = control_block_->route_finder_.find_route(offset);
   bool in_snapshot = current_page->header().snapshot_;
   for (uint8_t level = levels - 1; level > 0; --level) {
@@ -565,6 +889,9 @@ inline ErrorCode ArrayStoragePimpl::lookup_for_read(
   ASSERT_ND(current_page->get_array_range().contains(offset));
   ASSERT_ND(current_page->get_array_range().begin_ + route.route[0] == offset);
   ASSERT_ND(current_page->get_leaf_record(0, get_payload_size())->owner_id_.xct_id_.is_valid());
+  if (levels > 1U) {
+    sample_remote_leaf(context, current_page);
+  }
   *out = current_page;
   *index = route.route[0];
   *snapshot_page = (*out)->header().snapshot_;
@@ -583,7 +910,7 @@ inline ErrorCode ArrayStoragePimpl::lookup_for_write(
   ArrayPage* current_page;
   CHECK_ERROR_CODE(get_root_page(context, true, &current_page));
   ASSERT_ND(!current_page->header().snapshot_);
-  uint16_t levels = get_levels();
+  uint16_t levels = current_page->get_level() + 1U;  // see lookup_for_read()
   ASSERT_ND(current_page->get_array_range().contains(offset));
   LookupRoute route = control_block_->route_finder_.find_route(offset);
   for (uint8_t level = levels - 1; level > 0; --level) {
@@ -601,6 +928,9 @@ inline ErrorCode ArrayStoragePimpl::lookup_for_write(
   ASSERT_ND(current_page->get_array_range().contains(offset));
   ASSERT_ND(current_page->get_array_range().begin_ + route.route[0] == offset);
   ASSERT_ND(current_page->get_leaf_record(0, get_payload_size())->owner_id_.xct_id_.is_valid());
+  if (levels > 1U) {
+    sample_remote_leaf(context, current_page);
+  }
   *out = current_page;
   *index = route.route[0];
   return kErrorCodeOk;
@@ -802,11 +1132,15 @@ inline ErrorCode ArrayStoragePimpl::lookup_for_read_batch(
   LookupRoute routes[kBatchMax];
   ArrayPage* root_page;
   CHECK_ERROR_CODE(get_root_page(context, false, &root_page));
-  uint16_t levels = get_levels();
+  uint16_t levels = root_page->get_level() + 1U;  // see lookup_for_read()
   bool root_snapshot = root_page->header().snapshot_;
   const uint16_t payload_size = get_payload_size();
   for (uint8_t i = 0; i < batch_size; ++i) {
     ASSERT_ND(offset_batch[i] < get_array_size());
+    if (UNLIKELY(!root_page->get_array_range().contains(offset_batch[i]))) {
+      ASSERT_ND(root_snapshot);
+      return kErrorCodeXctNoSnapshotPage;
+    }
     routes[i] = control_block_->route_finder_.find_route(offset_batch[i]);
     if (levels <= 1U) {
       assorted::prefetch_cacheline(root_page->get_leaf_record(
@@ -857,6 +1191,9 @@ inline ErrorCode ArrayStoragePimpl::lookup_for_read_batch(
     ASSERT_ND(index_batch[i] == routes[i].route[0]);
     ASSERT_ND(
       out_batch[i]->get_leaf_record(index_batch[i], payload_size)->owner_id_.xct_id_.is_valid());
+    if (levels > 1U) {
+      sample_remote_leaf(context, out_batch[i]);
+    }
   }
   return kErrorCodeOk;
 }
@@ -873,7 +1210,7 @@ inline ErrorCode ArrayStoragePimpl::lookup_for_write_batch(
   ArrayPage* root_page;
   CHECK_ERROR_CODE(get_root_page(context, true, &root_page));
   ASSERT_ND(!root_page->header().snapshot_);
-  uint16_t levels = get_levels();
+  uint16_t levels = root_page->get_level() + 1U;  // see lookup_for_read()
   const uint16_t payload_size = get_payload_size();
 
   for (uint8_t i = 0; i < batch_size; ++i) {
@@ -922,10 +1259,103 @@ inline ErrorCode ArrayStoragePimpl::lookup_for_write_batch(
     ASSERT_ND(pages[i]->get_array_range().begin_ + routes[i].route[0] == offset_batch[i]);
     ASSERT_ND(index_batch[i] == routes[i].route[0]);
     record_batch[i] = pages[i]->get_leaf_record(routes[i].route[0], payload_size);
+    if (levels > 1U) {
+      sample_remote_leaf(context, pages[i]);
+    }
   }
   return kErrorCodeOk;
 }
 
+xct::TrackMovedRecordResult ArrayStorage::track_moved_record(
+  xct::RwLockableXctId* old_address,
+  xct::WriteXctAccess* /*write_set*/) {
+  return ArrayStoragePimpl(this).track_moved_record(old_address);
+}
+
+xct::TrackMovedRecordResult ArrayStoragePimpl::track_moved_record(
+  xct::RwLockableXctId* old_address) {
+  ASSERT_ND(old_address);
+  ASSERT_ND(old_address->is_moved());
+  // We use moved bit only for migrated volatile leaf pages
+  const ArrayPage* old_page = reinterpret_cast<const ArrayPage*>(to_page(old_address));
+  ASSERT_ND(old_page->is_leaf());
+  ASSERT_ND(!old_page->header().snapshot_);
+  ASSERT_ND(old_page->header().page_version_.is_moved());
+  const uint16_t payload_size = get_payload_size();
+  const char* first_record
+    = reinterpret_cast<const char*>(old_page->get_leaf_record(0, payload_size));
+  const uint16_t index = (reinterpret_cast<const char*>(old_address) - first_record)
+    / (kRecordOverhead + assorted::align8(payload_size));
+  ASSERT_ND(&old_page->get_leaf_record(index, payload_size)->owner_id_ == old_address);
+  const ArrayOffset offset = old_page->get_array_range().begin_ + index;
+
+  DualPagePointer* pointer = find_volatile_leaf_pointer(offset);
+  if (pointer == nullptr || pointer->volatile_pointer_.is_null()) {
+    // the storage's volatile pages have been dropped. retry the whole transaction.
+    return xct::TrackMovedRecordResult();
+  }
+  const auto& resolver = engine_->get_memory_manager()->get_global_volatile_page_resolver();
+  ArrayPage* new_page
+    = reinterpret_cast<ArrayPage*>(resolver.resolve_offset(pointer->volatile_pointer_));
+  ASSERT_ND(new_page->is_leaf());
+  ASSERT_ND(new_page->get_array_range().begin_ == old_page->get_array_range().begin_);
+  Record* record = new_page->get_leaf_record(index, payload_size);
+  return xct::TrackMovedRecordResult(&record->owner_id_, record->payload_);
+}
+
+DualPagePointer* ArrayStoragePimpl::find_volatile_leaf_pointer(ArrayOffset offset) {
+  const auto& resolver = engine_->get_memory_manager()->get_global_volatile_page_resolver();
+  VolatilePagePointer page_id = control_block_->root_page_pointer_.volatile_pointer_;
+  if (page_id.is_null()) {
+    return nullptr;
+  }
+  ArrayPage* page = reinterpret_cast<ArrayPage*>(resolver.resolve_offset(page_id));
+  if (page->is_leaf() || !page->get_array_range().contains(offset)) {
+    return nullptr;
+  }
+  LookupRoute route = control_block_->route_finder_.find_route(offset);
+  for (uint8_t level = page->get_level(); level > 1U; --level) {
+    page_id = page->get_interior_record(route.route[level]).volatile_pointer_;
+    if (page_id.is_null()) {
+      return nullptr;
+    }
+    page = reinterpret_cast<ArrayPage*>(resolver.resolve_offset(page_id));
+    ASSERT_ND(page->get_level() + 1U == level);
+    ASSERT_ND(page->get_array_range().contains(offset));
+  }
+  ASSERT_ND(page->get_level() == 1U);
+  return &page->get_interior_record(route.route[1]);
+}
+
+ErrorCode ArrayStorage::migrate_volatile_page(
+  thread::Thread* context,
+  uint64_t page_key,
+  bool* migrated) {
+  return ArrayStoragePimpl(this).migrate_volatile_page(context, page_key, migrated);
+}
+
+ErrorCode ArrayStoragePimpl::migrate_volatile_page(
+  thread::Thread* context,
+  ArrayOffset leaf_begin,
+  bool* migrated) {
+  *migrated = false;
+  if (leaf_begin >= get_array_size()) {
+    return kErrorCodeOk;
+  }
+  DualPagePointer* pointer = find_volatile_leaf_pointer(leaf_begin);
+  if (pointer == nullptr) {
+    return kErrorCodeOk;
+  }
+  VolatilePagePointer observed = pointer->volatile_pointer_;
+  if (observed.is_null() || observed.get_numa_node() == context->get_numa_node()) {
+    return kErrorCodeOk;
+  }
+  ArrayMigrateLeaf functor(context, pointer, observed);
+  CHECK_ERROR_CODE(context->run_nested_sysxct(&functor, 2U));
+  *migrated = functor.migrated_;
+  return kErrorCodeOk;
+}
+
 #define CHECK_AND_ASSERT(x) do { ASSERT_ND(x); if (!(x)) \
   return ERROR_STACK(kErrorCodeStrArrayFailedVerification); } while (0)
 
@@ -1116,6 +1546,173 @@ ErrorCode ArrayStoragePimpl::follow_pointers_for_write_batch(
   return kErrorCodeOk;
 }
 
+/** The largest number of records in a leaf page, which happens with payload of 8 bytes or less */
+const uint16_t kMaxLeafRecords = kDataSize / (kRecordOverhead + 8U);
+/** How many records ahead we prefetch while aggregating */
+const uint16_t kAggregatePrefetchDistance = 8;
+
+/**
+ * Aggregates count records whose fields are stride bytes apart.
+ * Records interleave with their owner IDs, so the loads are strided rather than contiguous.
+ * We keep 4 independent accumulators so that consecutive records don't serialize on one
+ * dependency chain, which lets the compiler and CPU overlap the loads and comparisons.
+ */
+template <typename T>
+inline void aggregate_strided(
+  const char* base,
+  uint32_t stride,
+  uint16_t count,
+  ArrayAggregateResult<T>* out) {
+  if (count == 0) {
+    return;
+  }
+  T first;
+  std::memcpy(&first, base, sizeof(T));
+  T sum[4] = {0, 0, 0, 0};
+  T min[4] = {first, first, first, first};
+  T max[4] = {first, first, first, first};
+  uint16_t i = 0;
+  for (; i + 4U <= count; i += 4U) {
+    if (i + kAggregatePrefetchDistance < count) {
+      assorted::prefetch_cacheline(base + (i + kAggregatePrefetchDistance) * stride);
+    }
+    for (uint16_t j = 0; j < 4U; ++j) {
+      T value;
+      std::memcpy(&value, base + (i + j) * stride, sizeof(T));
+      sum[j] += value;
+      min[j] = value < min[j] ? value : min[j];
+      max[j] = value > max[j] ? value : max[j];
+    }
+  }
+  for (; i < count; ++i) {
+    T value;
+    std::memcpy(&value, base + i * stride, sizeof(T));
+    sum[0] += value;
+    min[0] = value < min[0] ? value : min[0];
+    max[0] = value > max[0] ? value : max[0];
+  }
+
+  ArrayAggregateResult<T> page_result;
+  page_result.count_ = count;
+  page_result.sum_ = sum[0] + sum[1] + sum[2] + sum[3];
+  page_result.min_ = std::min(std::min(min[0], min[1]), std::min(min[2], min[3]));
+  page_result.max_ = std::max(std::max(max[0], max[1]), std::max(max[2], max[3]));
+  out->merge(page_result);
+}
+
+template <typename T>
+ErrorCode ArrayStoragePimpl::aggregate_primitive(
+  thread::Thread* context,
+  uint16_t payload_offset,
+  ArrayOffset from,
+  ArrayOffset to,
+  ArrayAggregateResult<T>* result) {
+  ASSERT_ND(payload_offset + sizeof(T) <= get_payload_size());
+  ASSERT_ND(from <= to);
+  ASSERT_ND(to <= get_array_size());
+  xct::Xct& current_xct = context->get_current_xct();
+  if (!current_xct.is_active()) {
+    return kErrorCodeXctNoXct;
+  }
+  const bool serializable = current_xct.get_isolation_level() == xct::kSerializable;
+  const uint16_t payload_size = get_payload_size();
+  const uint32_t stride = kRecordOverhead + assorted::align8(payload_size);
+  for (ArrayOffset offset = from; offset < to;) {
+    ArrayPage* page = nullptr;
+    uint16_t index = 0;
+    bool snapshot_page;
+    CHECK_ERROR_CODE(lookup_for_read(context, offset, &page, &index, &snapshot_page));
+    ASSERT_ND(page->is_leaf());
+    const ArrayOffset page_end = std::min<ArrayOffset>(to, page->get_array_range().end_);
+    const uint16_t count = page_end - offset;
+    ASSERT_ND(count > 0 && count <= kMaxLeafRecords);
+    Record* first_record = page->get_leaf_record(index, payload_size);
+    if (snapshot_page) {
+      // Snapshot page is immutable. No read-set or check needed.
+      aggregate_strided<T>(first_record->payload_ + payload_offset, stride, count, result);
+    } else if (serializable) {
+      for (uint16_t i = 0; i < count; ++i) {
+        Record* record = page->get_leaf_record(index + i, payload_size);
+        CHECK_ERROR_CODE(current_xct.on_record_read(false, &record->owner_id_));
+      }
+      assorted::memory_fence_consume();
+      aggregate_strided<T>(first_record->payload_ + payload_offset, stride, count, result);
+    } else {
+      CHECK_ERROR_CODE(aggregate_primitive_volatile_page<T>(
+        first_record,
+        payload_offset,
+        count,
+        result));
+    }
+    offset = page_end;
+  }
+  return kErrorCodeOk;
+}
+
+template <typename T>
+ErrorCode ArrayStoragePimpl::aggregate_primitive_volatile_page(
+  Record* first_record,
+  uint16_t payload_offset,
+  uint16_t count,
+  ArrayAggregateResult<T>* result) {
+  // Without read-set, we make sure we don't see half-written records by observing
+  // all owner IDs of the page before and after the aggregation.
+  const uint32_t stride = kRecordOverhead + assorted::align8(get_payload_size());
+  const char* base = reinterpret_cast<const char*>(first_record);
+  xct::XctId observed[kMaxLeafRecords];
+  while (true) {
+    for (uint16_t i = 0; i < count; ++i) {
+      const Record* record = reinterpret_cast<const Record*>(base + i * stride);
+      observed[i] = record->owner_id_.xct_id_.spin_while_being_written();
+    }
+    assorted::memory_fence_acquire();
+    ArrayAggregateResult<T> page_result;
+    aggregate_strided<T>(first_record->payload_ + payload_offset, stride, count, &page_result);
+    assorted::memory_fence_acquire();
+    bool changed = false;
+    for (uint16_t i = 0; i < count; ++i) {
+      const Record* record = reinterpret_cast<const Record*>(base + i * stride);
+      if (record->owner_id_.xct_id_ != observed[i]) {
+        changed = true;
+        break;
+      }
+    }
+    if (!changed) {
+      result->merge(page_result);
+      return kErrorCodeOk;
+    }
+  }
+}
+
+template <typename T>
+ErrorCode ArrayStorage::aggregate_primitive(
+  thread::Thread* context,
+  uint16_t payload_offset,
+  ArrayOffset from,
+  ArrayOffset to,
+  ArrayAggregateResult<T>* result) {
+  if (to == 0) {
+    to = get_array_size();
+  }
+  return ArrayStoragePimpl(this).aggregate_primitive<T>(context, payload_offset, from, to, result);
+}
+
+// bool makes no sense to aggregate.
+#define EX_AGGREGATE(x) template ErrorCode ArrayStorage::aggregate_primitive< x > \
+  (thread::Thread* context, uint16_t payload_offset, \
+  ArrayOffset from, ArrayOffset to, ArrayAggregateResult< x >* result)
+INSTANTIATE_ALL_INTEGER_TYPES(EX_AGGREGATE);
+EX_AGGREGATE(float);  // NOLINT(readability/function)
+EX_AGGREGATE(double);  // NOLINT(readability/function)
+
+#define EX_AGGREGATE_IMPL(x) template ErrorCode ArrayStoragePimpl::aggregate_primitive< x > \
+  (thread::Thread* context, uint16_t payload_offset, \
+  ArrayOffset from, ArrayOffset to, ArrayAggregateResult< x >* result)
+INSTANTIATE_ALL_INTEGER_TYPES(EX_AGGREGATE_IMPL);
+EX_AGGREGATE_IMPL(float);  // NOLINT(readability/function)
+EX_AGGREGATE_IMPL(double);  // NOLINT(readability/function)
+
+
 // Explicit instantiations for each type
 // @cond DOXYGEN_IGNORE
 #define EXPLICIT_INSTANTIATION_GET(x) template ErrorCode ArrayStorage::get_record_primitive< x > \
@@ -69,6 +69,30 @@ ErrorCode ArrayStoragePimpl::prefetch_pages_recurse(
   ArrayRange range(from, to);
   ASSERT_ND(page_range.overlaps(range));  // otherwise why we came here...
   ASSERT_ND(page_range.begin_ + (interval * kInteriorFanout) >= page_range.end_);  // probably==
+  if (snp_on) {
+    // Bring all snapshot children into the snapshot cache in batches first.
+    // Children are usually consecutive in the snapshot file, so this results in large
+    // sequential reads rather than one read per page. The loop below then hits the cache.
+    SnapshotPagePointer page_ids[thread::Thread::kMaxFindPagesBatch];
+    Page* pages[thread::Thread::kMaxFindPagesBatch];
+    uint16_t batch_size = 0;
+    for (uint16_t i = 0; i < kInteriorFanout; ++i) {
+      ArrayRange child_range(
+        page_range.begin_ + i * interval,
+        page_range.begin_ + (i + 1U) * interval);
+      SnapshotPagePointer snapshot_pointer = page->get_interior_record(i).snapshot_pointer_;
+      if (snapshot_pointer == 0 || !range.overlaps(child_range)) {
+        continue;
+      }
+      page_ids[batch_size] = snapshot_pointer;
+      ++batch_size;
+      if (batch_size == thread::Thread::kMaxFindPagesBatch) {
+        CHECK_ERROR_CODE(context->find_or_read_snapshot_pages_batch(batch_size, page_ids, pages));
+        batch_size = 0;
+      }
+    }
+    CHECK_ERROR_CODE(context->find_or_read_snapshot_pages_batch(batch_size, page_ids, pages));
+  }
   for (uint16_t i = 0; i < kInteriorFanout; ++i) {
     ArrayRange child_range(
       page_range.begin_ + i * interval,
@@ -563,6 +563,16 @@ ErrorCode HashComposeContext::apply_batch(uint64_t cur, uint64_t next) {
           log->get_payload(),
           log->payload_offset_,
           log->payload_count_));
+      } else if (log->header_.get_type() == log::kLogCodeHashDelta) {
+        CHECK_ERROR_CODE(cur_bin_table_.delta_record(
+          log->header_.xct_id_,
+          log->get_key(),
+          log->key_length_,
+          hash,
+          log->reserved_,
+          log->get_payload(),
+          log->payload_offset_,
+          log->payload_count_));
       } else if (log->header_.get_type() == log::kLogCodeHashInsert) {
         CHECK_ERROR_CODE(cur_bin_table_.insert_record(
           log->header_.xct_id_,
@@ -679,7 +689,7 @@ SnapshotPagePointer HashComposeContext::get_cur_path_bin_head(HashBin bin) const
     return 0;
   }
   ASSERT_ND(cur_path_[0].get_bin_range().contains(bin));
-  uint16_t index = bin - cur_path_[0].get_bin_range().end_;
+  uint16_t index = bin - cur_path_[0].get_bin_range().begin_;
   return cur_path_[0].get_pointer(index).snapshot_pointer_;
 }
 
@@ -712,7 +722,7 @@ ErrorStack HashComposeContext::init_cur_path() {
         ASSERT_ND(child->header().storage_id_ == storage_id_);
         ASSERT_ND(child->header().page_id_ == pointer);
         ASSERT_ND(child->get_level() + 1U == parent->get_level());
-        ASSERT_ND(child->get_bin_range() == HashBinRange(0ULL, parent->get_level()));
+        ASSERT_ND(child->get_bin_range() == HashBinRange(0ULL, kHashMaxBins[parent->get_level()]));
         cur_path_lowest_level_ = child->get_level();
         cur_path_valid_range_ = child->get_bin_range();
         parent = child;
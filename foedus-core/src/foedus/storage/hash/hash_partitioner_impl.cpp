@@ -90,6 +90,7 @@ ErrorStack HashPartitioner::design_partition(
 
   if (!data_->partitionable_) {
     // No partitioning needed. We don't even allocate memory for bin_owners_ in this case
+    metadata_->access_statistics_.clear();
     metadata_->valid_ = true;
     return kRetOk;
   }
@@ -121,6 +122,26 @@ ErrorStack HashPartitioner::design_partition(
     LOG(INFO) << "Joined. Designing done";
   }
 
+  // bin ranges mostly read by one node since the previous snapshot go to the node.
+  // then we sample accesses per the same bin ranges for the next snapshot.
+  PartitionerAccessStatistics* statistics = &metadata_->access_statistics_;
+  const uint32_t ranges = std::min<HashBin>(
+    total_bin_count,
+    PartitionerAccessStatistics::kMaxBuckets);
+  uint64_t low_keys[PartitionerAccessStatistics::kMaxBuckets];
+  for (uint32_t i = 0; i < ranges; ++i) {
+    low_keys[i] = total_bin_count * i / ranges;
+  }
+  for (uint32_t i = 0; i < ranges; ++i) {
+    const HashBin low = low_keys[i];
+    const HashBin high = (i + 1U == ranges) ? total_bin_count : low_keys[i + 1U];
+    PartitionId node;
+    if (statistics->find_dominant_node(low, high, &node) && node < node_count) {
+      std::memset(data_->bin_owners_ + low, node, high - low);
+    }
+  }
+  statistics->reset(low_keys, ranges);
+
   metadata_->valid_ = true;
   return kRetOk;
 }
@@ -70,6 +70,9 @@ ErrorStack HashStorage::load(const StorageControlBlock& snapshot_block) {
   HashStoragePimpl pimpl(this);
   return pimpl.load(snapshot_block);
 }
+ErrorStack HashStorage::load_snapshot_view(const StorageControlBlock& snapshot_block) {
+  return HashStoragePimpl(this).load_snapshot_view(snapshot_block);
+}
 ErrorStack  HashStorage::drop() {
   HashStoragePimpl pimpl(this);
   return pimpl.drop();
@@ -244,6 +247,29 @@ ErrorCode HashStorage::increment_record(
     payload_offset);
 }
 
+template <typename PAYLOAD>
+ErrorCode HashStorage::delta_record(
+  thread::Thread* context,
+  const void* key,
+  uint16_t key_length,
+  const HashCombo& combo,
+  DeltaOperator op,
+  PAYLOAD operand,
+  uint16_t payload_offset) {
+  if (!is_valid_delta<PAYLOAD>(op)) {
+    return kErrorCodeInvalidParameter;
+  }
+  HashStoragePimpl pimpl(this);
+  return pimpl.delta_record(
+    context,
+    key,
+    key_length,
+    combo,
+    op,
+    operand,
+    payload_offset);
+}
+
 std::ostream& operator<<(std::ostream& o, const HashStorage& v) {
   o << "<HashStorage>"
     << "<id>" << v.get_id() << "</id>"
@@ -314,6 +340,19 @@ INSTANTIATE_ALL_NUMERIC_TYPES(EXPIN_3);
     x* value, \
     uint16_t payload_offset)
 INSTANTIATE_ALL_NUMERIC_TYPES(EXPIN_5);
+
+// delta_record() does not allow bool
+#define EXPIN_6(x) template ErrorCode HashStorage::delta_record< x > \
+  (thread::Thread* context, \
+    const void* key, \
+    uint16_t key_length, \
+    const HashCombo& combo, \
+    DeltaOperator op, \
+    x operand, \
+    uint16_t payload_offset)
+INSTANTIATE_ALL_INTEGER_TYPES(EXPIN_6);
+EXPIN_6(float);  // NOLINT(readability/function)
+EXPIN_6(double);  // NOLINT(readability/function)
 // @endcond
 
 
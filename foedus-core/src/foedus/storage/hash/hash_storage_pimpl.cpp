@@ -163,6 +163,17 @@ ErrorStack HashStoragePimpl::load(const StorageControlBlock& snapshot_block) {
   return kRetOk;
 }
 
+ErrorStack HashStoragePimpl::load_snapshot_view(const StorageControlBlock& snapshot_block) {
+  control_block_->meta_ = static_cast<const HashMetadata&>(snapshot_block.meta_);
+  control_block_->bin_count_ = 1ULL << get_bin_bits();
+  control_block_->levels_ = bins_to_level(control_block_->bin_count_);
+  control_block_->root_page_pointer_.snapshot_pointer_
+    = control_block_->meta_.root_snapshot_page_id_;
+  control_block_->root_page_pointer_.volatile_pointer_.word = 0;
+  control_block_->status_ = kExists;
+  return kRetOk;
+}
+
 ErrorCode HashStoragePimpl::get_record(
   thread::Thread* context,
   const void* key,
@@ -604,6 +615,64 @@ ErrorCode HashStoragePimpl::increment_record(
   return register_record_write_log(context, location, log_entry);
 }
 
+template <typename PAYLOAD>
+ErrorCode HashStoragePimpl::delta_record(
+  thread::Thread* context,
+  const void* key,
+  uint16_t key_length,
+  const HashCombo& combo,
+  DeltaOperator op,
+  PAYLOAD operand,
+  uint16_t payload_offset) {
+  HashDataPage* bin_head;
+  CHECK_ERROR_CODE(locate_bin(context, true, combo, &bin_head));
+  ASSERT_ND(bin_head);
+  RecordLocation location;
+  CHECK_ERROR_CODE(locate_record_logical(
+    context,
+    true,
+    false,
+    0,
+    key,
+    key_length,
+    combo,
+    bin_head,
+    &location));
+
+  if (!location.is_found()) {
+    return kErrorCodeStrKeyNotFound;  // protected by page version set, so we are done
+  } else if (location.observed_.is_deleted()) {
+    return kErrorCodeStrKeyNotFound;  // protected by the read set
+  } else if (location.cur_payload_length_ < payload_offset + sizeof(PAYLOAD)) {
+    LOG(WARNING) << "short record " << combo;  // probably this is a rare error. so warn.
+    return kErrorCodeStrTooShortPayload;  // protected by the read set
+  }
+
+  // Unlike overwrite_record, this is truly a blind-write. We don't need the read set because
+  // precommit checks the record is not deleted/shrunk after taking the lock.
+  xct::Xct* cur_xct = &context->get_current_xct();
+  if (location.readset_) {
+    cur_xct->remove_last_read(location.readset_);
+  }
+
+  uint16_t log_length
+    = HashDeltaLogType::calculate_log_length(key_length, sizeof(PAYLOAD));
+  HashDeltaLogType* log_entry = reinterpret_cast<HashDeltaLogType*>(
+    context->get_thread_log_buffer().reserve_new_log(log_length));
+  log_entry->populate<PAYLOAD>(
+    get_id(),
+    key,
+    key_length,
+    get_bin_bits(),
+    combo.hash_,
+    op,
+    operand,
+    payload_offset);
+
+  auto* slot = location.page_->get_slot_address(location.index_);
+  return cur_xct->add_to_write_set(get_id(), &slot->tid_, location.record_, log_entry);
+}
+
 ErrorCode HashStoragePimpl::get_root_page(
   thread::Thread* context,
   bool for_write,
@@ -1197,6 +1266,18 @@ xct::TrackMovedRecordResult HashStoragePimpl::track_moved_record_search(
   x* value, \
   uint16_t payload_offset)
 INSTANTIATE_ALL_NUMERIC_TYPES(EXPIN_5I);
+
+#define EXPIN_6I(x) template ErrorCode HashStoragePimpl::delta_record< x > \
+  (thread::Thread* context, \
+  const void* key, \
+  uint16_t key_length, \
+  const HashCombo& combo, \
+  DeltaOperator op, \
+  x operand, \
+  uint16_t payload_offset)
+INSTANTIATE_ALL_INTEGER_TYPES(EXPIN_6I);
+EXPIN_6I(float);  // NOLINT(readability/function)
+EXPIN_6I(double);  // NOLINT(readability/function)
 // @endcond
 
 }  // namespace hash
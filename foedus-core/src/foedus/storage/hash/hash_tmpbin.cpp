@@ -23,6 +23,7 @@
 #include <string>
 
 #include "foedus/assorted/assorted_func.hpp"
+#include "foedus/storage/delta_update.hpp"
 
 namespace foedus {
 namespace storage {
@@ -226,6 +227,43 @@ ErrorCode HashTmpBin::overwrite_record(
   return kErrorCodeOk;
 }
 
+ErrorCode HashTmpBin::delta_record(
+  xct::XctId xct_id,
+  const void* key,
+  uint16_t key_length,
+  HashValue hash,
+  uint8_t delta_tag,
+  const void* operand,
+  uint16_t payload_offset,
+  uint16_t payload_count) {
+  ASSERT_ND(!xct_id.is_deleted());
+  ASSERT_ND(hashinate(key, key_length) == hash);
+  SearchResult result = search_bucket(key, key_length, hash);
+  if (UNLIKELY(result.found_ == 0)) {
+    DLOG(WARNING) << "HashTmpBin::delta_record() hit KeyNotFound case 1. This must not"
+      << " happen except unit testcases.";
+    return kErrorCodeStrKeyNotFound;
+  } else {
+    Record* record = get_record(result.found_);
+    ASSERT_ND(record->hash_ == hash);
+    if (UNLIKELY(record->xct_id_.is_deleted())) {
+      DLOG(WARNING) << "HashTmpBin::delta_record() hit KeyNotFound case 2. This must not"
+        << " happen except unit testcases.";
+      return kErrorCodeStrKeyNotFound;
+    } else if (UNLIKELY(record->payload_length_ < payload_offset + payload_count)) {
+      DLOG(WARNING) << "HashTmpBin::delta_record() hit TooShortPayload case. This must not"
+        << " happen except unit testcases.";
+      return kErrorCodeStrTooShortPayload;
+    }
+    // One xct might apply multiple deltas on the same record, thus "<=".
+    ASSERT_ND(record->xct_id_.compare_epoch_and_orginal(xct_id) <= 0);
+    record->xct_id_ = xct_id;
+    apply_delta(delta_tag, operand, record->get_payload() + payload_offset);
+  }
+
+  return kErrorCodeOk;
+}
+
 ErrorCode HashTmpBin::update_record(
   xct::XctId xct_id,
   const void* key,
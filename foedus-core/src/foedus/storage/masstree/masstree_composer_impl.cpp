@@ -427,7 +427,9 @@ ErrorStack MasstreeComposeContext::execute() {
         } else if (log_type == log::kLogCodeMasstreeUpdate) {
           CHECK_ERROR(execute_update_group(cur, cur + group.count_));
         } else {
-          ASSERT_ND(log_type == log::kLogCodeMasstreeOverwrite);
+          // Delta logs are processed just like overwrites
+          ASSERT_ND(log_type == log::kLogCodeMasstreeOverwrite
+            || log_type == log::kLogCodeMasstreeDelta);
           CHECK_ERROR(execute_overwrite_group(cur, cur + group.count_));
         }
       }
@@ -457,6 +459,8 @@ ErrorStack MasstreeComposeContext::execute_same_key_group(uint32_t from, uint32_
 
   // Let's say I:Insert, U:Update, D:Delete, O:Overwrite
   // overwrite: this is the easiest one that is nullified by following delete/update.
+  // Delta logs are also nullified by following delete/update, so we treat them as O below.
+  // Unlike O, we can't skip a delta even if a following O covers it, but that's it.
   // insert: if there is following delete, everything in-between disappear, including insert/delete.
   // update: nullified by following delete/update
   // delete: strongest. never nullified except the insert-delete pairing.
@@ -521,7 +525,8 @@ ErrorStack MasstreeComposeContext::execute_same_key_group(uint32_t from, uint32_
           break;
         default:
           ASSERT_ND(log_type_j == log::kLogCodeMasstreeUpdate
-            || log_type_j == log::kLogCodeMasstreeOverwrite);
+            || log_type_j == log::kLogCodeMasstreeOverwrite
+            || log_type_j == log::kLogCodeMasstreeDelta);
           ASSERT_ND((!starts_with_insert && insert_count == delete_count)
             || (starts_with_insert && insert_count == delete_count + 1U));
           break;
@@ -589,6 +594,10 @@ ErrorStack MasstreeComposeContext::execute_same_key_group(uint32_t from, uint32_
       next_to_check = next + 1U;
       last_active_delete = to;
     }
+  } else if (starts_with_insert) {
+    // No delete. The first insert is active, and the following logs are U/O applied on it.
+    last_active_insert = from;
+    next_to_check = from + 1U;
   }
 
   // From now on, we are sure there is no more delete or insert.
@@ -613,9 +622,10 @@ ErrorStack MasstreeComposeContext::execute_same_key_group(uint32_t from, uint32_
         is_last_active_update_merged = false;
       }
     } else {
-      // Overwrites are just skipped.
-      ASSERT_ND(log_type == log::kLogCodeMasstreeOverwrite);
-      ASSERT_ND(starts_with_insert || last_active_insert != to);
+      // Overwrites/deltas are just skipped.
+      ASSERT_ND(log_type == log::kLogCodeMasstreeOverwrite
+        || log_type == log::kLogCodeMasstreeDelta);
+      ASSERT_ND(!starts_with_insert || last_active_insert != to);
     }
   }
 
@@ -659,8 +669,9 @@ ErrorStack MasstreeComposeContext::execute_same_key_group(uint32_t from, uint32_
 
     // Process the I/U as usual. This also makes sure that the tail-record is the key.
   } else {
-    ASSERT_ND(log::kLogCodeMasstreeOverwrite == merge_sort_->get_log_type_from_sort_position(cur));
-    // All logs are overwrites.
+    ASSERT_ND(log::kLogCodeMasstreeOverwrite == merge_sort_->get_log_type_from_sort_position(cur)
+      || log::kLogCodeMasstreeDelta == merge_sort_->get_log_type_from_sort_position(cur));
+    // All logs are overwrites/deltas.
     // Even in this case, we must process the first log as usual so that
     // the tail-record in the tail page points to the record.
   }
@@ -671,8 +682,8 @@ ErrorStack MasstreeComposeContext::execute_same_key_group(uint32_t from, uint32_
     return kRetOk;
   }
 
-  // All the followings are overwrites.
-  // Process the remaining overwrites in a tight loop.
+  // All the followings are overwrites/deltas.
+  // Process the remaining overwrites/deltas in a tight loop.
   // We made sure sure the tail-record in the tail page points to the record.
   PathLevel* last = get_last_level();
   ASSERT_ND(get_page(last->tail_)->is_border());
@@ -681,18 +692,26 @@ ErrorStack MasstreeComposeContext::execute_same_key_group(uint32_t from, uint32_
   ASSERT_ND(key_count > 0);
   SlotIndex index = key_count - 1;
   ASSERT_ND(!page->does_point_to_layer(index));
-  char* record = page->get_record(index);
 
   for (uint32_t i = cur; i < to; ++i) {
-    const MasstreeOverwriteLogType* casted =
-      reinterpret_cast<const MasstreeOverwriteLogType*>(merge_sort_->resolve_sort_position(i));
+    const MasstreeCommonLogType* entry =
+      reinterpret_cast<const MasstreeCommonLogType*>(merge_sort_->resolve_sort_position(i));
+    ASSERT_ND(page->equal_key(index, entry->get_key(), entry->key_length_));
+    if (entry->header_.get_type() == log::kLogCodeMasstreeDelta) {
+      const MasstreeDeltaLogType* casted = reinterpret_cast<const MasstreeDeltaLogType*>(entry);
+      casted->apply_on_payload(page->get_record_payload(index), page->get_payload_length(index));
+      continue;
+    }
+
+    const MasstreeOverwriteLogType* casted
+      = reinterpret_cast<const MasstreeOverwriteLogType*>(entry);
     ASSERT_ND(casted->header_.get_type() == log::kLogCodeMasstreeOverwrite);
-    ASSERT_ND(page->equal_key(index, casted->get_key(), casted->key_length_));
 
     // Also, we look for a chance to ignore redundant overwrites.
     // If next overwrite log covers the same or more data range, we can skip the log.
     // Ideally, we should have removed such logs back in mappers.
-    if (i < to) {
+    if (i + 1U < to
+      && merge_sort_->get_log_type_from_sort_position(i + 1U) == log::kLogCodeMasstreeOverwrite) {
       const MasstreeOverwriteLogType* next =
         reinterpret_cast<const MasstreeOverwriteLogType*>(
           merge_sort_->resolve_sort_position(i + 1U));
@@ -704,7 +723,12 @@ ErrorStack MasstreeComposeContext::execute_same_key_group(uint32_t from, uint32_
       }
     }
 
-    casted->apply_record(nullptr, id_, page->get_owner_id(index), record);
+    // snapshot pages are not locked, so not apply_record()
+    ASSERT_ND(page->get_payload_length(index) >= casted->payload_offset_ + casted->payload_count_);
+    std::memcpy(
+      page->get_record_payload(index) + casted->payload_offset_,
+      casted->get_payload(),
+      casted->payload_count_);
   }
   return kRetOk;
 }
@@ -1067,8 +1091,11 @@ inline ErrorStack MasstreeComposeContext::execute_a_log(uint32_t cur) {
   while (key_count > 0
       && key_length > (last->layer_ + 1U) * kSliceLen
       && page->get_slice(key_count - 1) == slice
-      && page->get_remainder_length(key_count - 1) > kSliceLen) {
-    // then we have to either go next layer.
+      && page->get_remainder_length(key_count - 1) > kSliceLen
+      && (page->does_point_to_layer(key_count - 1)
+        || !page->equal_key(key_count - 1, key, key_length))) {
+    // then we have to either go next layer. If the record is the key itself, eg overwrite/delta
+    // on an existing long key, we stay here.
     if (page->does_point_to_layer(key_count - 1)) {
       // the next layer already exists. just follow it.
       ASSERT_ND(page->get_next_layer(key_count - 1)->volatile_pointer_.is_null());
@@ -1092,14 +1119,22 @@ inline ErrorStack MasstreeComposeContext::execute_a_log(uint32_t cur) {
 
   // Now we are sure the tail of the last level is the only relevant record. process the log.
   if (entry->header_.get_type() == log::kLogCodeMasstreeOverwrite) {
-    // [Overwrite] simply reuse log.apply
+    // [Overwrite] copy the payload. Snapshot pages are not locked, so not apply_record().
     SlotIndex index = key_count - 1;
     ASSERT_ND(!page->does_point_to_layer(index));
     ASSERT_ND(page->equal_key(index, key, key_length));
-    char* record = page->get_record(index);
-    const MasstreeOverwriteLogType* casted
-      = reinterpret_cast<const MasstreeOverwriteLogType*>(entry);
-    casted->apply_record(nullptr, id_, page->get_owner_id(index), record);
+    ASSERT_ND(page->get_payload_length(index) >= entry->payload_offset_ + entry->payload_count_);
+    std::memcpy(
+      page->get_record_payload(index) + entry->payload_offset_,
+      entry->get_payload(),
+      entry->payload_count_);
+  } else if (entry->header_.get_type() == log::kLogCodeMasstreeDelta) {
+    // [Delta] apply it on the payload. Snapshot pages are not locked, so not apply_record().
+    SlotIndex index = key_count - 1;
+    ASSERT_ND(!page->does_point_to_layer(index));
+    ASSERT_ND(page->equal_key(index, key, key_length));
+    const MasstreeDeltaLogType* casted = reinterpret_cast<const MasstreeDeltaLogType*>(entry);
+    casted->apply_on_payload(page->get_record_payload(index), page->get_payload_length(index));
   } else {
     // DELETE/INSERT/UPDATE
     ASSERT_ND(
@@ -1308,7 +1343,7 @@ ErrorStack MasstreeComposeContext::open_next_level(
     MasstreeBorderPage* target_casted = as_border(target);
     ASSERT_ND(copy_count <= key_count);
     target_casted->set_key_count(copy_count);
-    level->next_original_ = copy_count + 1U;
+    level->next_original_ = copy_count;
     if (level->next_original_ >= key_count) {
       level->set_no_more_next_original();
     } else {
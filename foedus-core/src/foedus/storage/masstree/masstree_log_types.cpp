@@ -91,6 +91,19 @@ std::ostream& operator<<(std::ostream& o, const MasstreeOverwriteLogType& v) {
   return o;
 }
 
+std::ostream& operator<<(std::ostream& o, const MasstreeDeltaLogType& v) {
+  o << "<MasstreeDeltaLog>"
+    << "<key_length_>" << v.key_length_ << "</key_length_>"
+    << "<key_>" << assorted::Top(v.get_key(), v.key_length_) << "</key_>"
+    << "<payload_offset_>" << v.payload_offset_ << "</payload_offset_>"
+    << "<payload_count_>" << v.payload_count_ << "</payload_count_>"
+    << "<operator_>" << decode_delta_operator(v.reserved_) << "</operator_>"
+    << "<value_type_>" << decode_delta_value_type(v.reserved_) << "</value_type_>"
+    << "<operand_>" << assorted::Top(v.get_payload(), v.payload_count_) << "</operand_>"
+    << "</MasstreeDeltaLog>";
+  return o;
+}
+
 }  // namespace masstree
 }  // namespace storage
 }  // namespace foedus
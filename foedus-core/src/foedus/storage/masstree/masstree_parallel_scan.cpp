@@ -0,0 +1,361 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include "foedus/storage/masstree/masstree_parallel_scan.hpp"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "foedus/engine.hpp"
+#include "foedus/engine_options.hpp"
+#include "foedus/error_stack_batch.hpp"
+#include "foedus/assorted/endianness.hpp"
+#include "foedus/cache/snapshot_file_set.hpp"
+#include "foedus/memory/aligned_memory.hpp"
+#include "foedus/proc/proc_id.hpp"
+#include "foedus/storage/masstree/masstree_cursor.hpp"
+#include "foedus/storage/masstree/masstree_page_impl.hpp"
+#include "foedus/storage/masstree/masstree_storage_pimpl.hpp"
+#include "foedus/thread/impersonate_session.hpp"
+#include "foedus/thread/thread.hpp"
+#include "foedus/thread/thread_pool.hpp"
+#include "foedus/xct/xct_manager.hpp"
+
+namespace foedus {
+namespace storage {
+namespace masstree {
+
+/** Input of the worker procedure. We can pass pointers because the SOC is emulated. */
+struct MasstreeParallelScanInput {
+  MasstreeParallelScan* scan_;
+  uint16_t              partition_;
+};
+
+/** Same as MasstreeCursor's. null key with this length means infimum or supremum. */
+const KeyLength kKeyLengthExtremum = MasstreeCursor::kKeyLengthExtremum;
+/** Cap on the number of boundary candidates we collect while peeking volatile pages. */
+const uint32_t kMaxPeekBoundaries = 1U << 12;
+/** We don't go down to a level of snapshot pages that has more pages than this. */
+const uint32_t kMaxSnapshotPagesPerLevel = 1U << 8;
+
+const char* const MasstreeParallelScan::kWorkerProcName = "foedus.masstree_parallel_scan";
+
+proc::ProcAndName MasstreeParallelScan::get_worker_proc() {
+  return proc::ProcAndName(kWorkerProcName, MasstreeParallelScan::worker_proc);
+}
+
+MasstreeParallelScan::MasstreeParallelScan(Engine* engine, StorageId storage_id)
+  : engine_(engine), storage_(engine, storage_id) {
+}
+
+uint64_t MasstreeParallelScan::get_total_record_count() const {
+  uint64_t total = 0;
+  for (const MasstreeScanPartition& partition : partitions_) {
+    total += partition.record_count_;
+  }
+  return total;
+}
+
+ErrorStack MasstreeParallelScan::collect_boundaries(
+  KeySlice from,
+  KeySlice to,
+  uint32_t desired_boundaries,
+  std::vector<KeySlice>* out) {
+  out->clear();
+  if (from >= to) {
+    return kRetOk;
+  }
+
+  // Boundaries of volatile pages
+  std::vector<KeySlice> found(kMaxPeekBoundaries);
+  uint32_t found_count = 0;
+  MasstreeStorage::PeekBoundariesArguments peek_args = {
+    nullptr,
+    0,
+    kMaxPeekBoundaries,
+    from,
+    to,
+    &found[0],
+    &found_count };
+  WRAP_ERROR_CODE(storage_.peek_volatile_page_boundaries(engine_, peek_args));
+  out->insert(out->end(), found.begin(), found.begin() + found_count);
+
+  // Boundaries of snapshot pages. Volatile pages might have been dropped after the snapshot,
+  // so snapshot pages are often the main source. The snapshot root usually has only a few
+  // pointers (one per partition of the composer), so we go down level by level until we have
+  // enough candidates, reading only the intermediate pages that overlap with the range.
+  MasstreeStoragePimpl pimpl(&storage_);
+  SnapshotPagePointer snapshot_root_id = pimpl.get_first_root_pointer().snapshot_pointer_;
+  if (snapshot_root_id != 0) {
+    memory::AlignedMemory buffer;
+    buffer.alloc(kPageSize, kPageSize, memory::AlignedMemory::kNumaAllocOnnode, 0);
+    MasstreeIntermediatePage* page = reinterpret_cast<MasstreeIntermediatePage*>(
+      buffer.get_block());
+    cache::SnapshotFileSet fileset(engine_);
+    CHECK_ERROR(fileset.initialize());
+    UninitializeGuard fileset_guard(&fileset, UninitializeGuard::kWarnIfUninitializeError);
+    std::vector<SnapshotPagePointer> cur_level;
+    std::vector<SnapshotPagePointer> next_level;
+    cur_level.push_back(snapshot_root_id);
+    while (!cur_level.empty()) {
+      uint32_t found_in_level = 0;
+      next_level.clear();
+      for (SnapshotPagePointer page_id : cur_level) {
+        WRAP_ERROR_CODE(fileset.read_page(page_id, page));
+        ASSERT_ND(page->header().snapshot_);
+        ASSERT_ND(!page->is_border());
+        for (MasstreeIntermediatePointerIterator it(page); it.is_valid(); it.next()) {
+          KeySlice low = it.get_low_key();
+          KeySlice high = it.get_high_key();
+          if (low >= to || high <= from) {
+            continue;
+          }
+          if (low > from) {
+            out->push_back(low);
+            ++found_in_level;
+          }
+          SnapshotPagePointer child = it.get_pointer().snapshot_pointer_;
+          if (page->get_btree_level() >= 2U && child != 0) {
+            next_level.push_back(child);
+          }
+        }
+      }
+      if (found_in_level >= desired_boundaries || next_level.size() > kMaxSnapshotPagesPerLevel) {
+        break;
+      }
+      cur_level.swap(next_level);
+    }
+    CHECK_ERROR(fileset.uninitialize());
+  }
+
+  std::sort(out->begin(), out->end());
+  out->erase(std::unique(out->begin(), out->end()), out->end());
+  return kRetOk;
+}
+
+ErrorStack MasstreeParallelScan::design_partitions(
+  const void* begin_key,
+  KeyLength begin_key_length,
+  const void* end_key,
+  KeyLength end_key_length,
+  uint16_t desired_partitions) {
+  partitions_.clear();
+  if (!storage_.exists() || desired_partitions == 0) {
+    return ERROR_STACK(kErrorCodeInvalidParameter);
+  }
+
+  const bool begin_infimum = (begin_key == nullptr || begin_key_length == kKeyLengthExtremum);
+  const bool end_supremum = (end_key == nullptr || end_key_length == kKeyLengthExtremum);
+  KeySlice from = kInfimumSlice;
+  if (!begin_infimum) {
+    from = normalize_be_bytes_fragment(begin_key, begin_key_length);
+  }
+  KeySlice to = kSupremumSlice;
+  if (!end_supremum) {
+    to = normalize_be_bytes_fragment(end_key, end_key_length);
+  }
+
+  // Any boundary strictly between the first slices of begin/end keys is strictly between
+  // the keys themselves, so sub-ranges never go out of [begin, end).
+  std::vector<KeySlice> boundaries;
+  CHECK_ERROR(collect_boundaries(from, to, desired_partitions * 4U, &boundaries));
+
+  // n boundaries make n+1 page-ranges. Take every n-th to give each partition the same number.
+  const uint32_t ranges = boundaries.size() + 1U;
+  const uint32_t count = std::min<uint32_t>(desired_partitions, ranges);
+  partitions_.resize(count);
+  partitions_[0].low_infimum_ = begin_infimum;
+  if (!begin_infimum) {
+    partitions_[0].low_key_.assign(reinterpret_cast<const char*>(begin_key), begin_key_length);
+  }
+  for (uint32_t i = 1; i < count; ++i) {
+    const uint32_t index = static_cast<uint64_t>(i) * ranges / count - 1U;
+    ASSERT_ND(index < boundaries.size());
+    char be[sizeof(KeySlice)];
+    assorted::write_bigendian<KeySlice>(boundaries[index], be);
+    partitions_[i - 1U].high_supremum_ = false;
+    partitions_[i - 1U].high_key_.assign(be, sizeof(KeySlice));
+    partitions_[i].low_infimum_ = false;
+    partitions_[i].low_key_.assign(be, sizeof(KeySlice));
+  }
+  partitions_[count - 1U].high_supremum_ = end_supremum;
+  if (!end_supremum) {
+    partitions_[count - 1U].high_key_.assign(
+      reinterpret_cast<const char*>(end_key),
+      end_key_length);
+  }
+
+  VLOG(0) << "Masstree-" << storage_.get_id() << " parallel scan: " << count
+    << " partitions out of " << boundaries.size() << " boundary candidates";
+  return kRetOk;
+}
+
+ErrorStack MasstreeParallelScan::worker_proc(const proc::ProcArguments& args) {
+  if (args.input_len_ != sizeof(MasstreeParallelScanInput)) {
+    return ERROR_STACK(kErrorCodeUserDefined);
+  }
+  MasstreeParallelScanInput input;
+  std::memcpy(&input, args.input_buffer_, sizeof(input));
+  return input.scan_->scan_partition(args.context_, input.partition_);
+}
+
+/** Reads all records in the partition with an opened transaction. */
+static ErrorCode scan_partition_records(
+  MasstreeStorage storage,
+  thread::Thread* context,
+  const MasstreeParallelScan::ExecuteArguments& args,
+  uint16_t partition_id,
+  MasstreeScanPartition* partition) {
+  MasstreeCursor cursor(storage, context);
+  CHECK_ERROR_CODE(cursor.open(
+    partition->low_infimum_ ? nullptr : partition->low_key_.data(),
+    partition->low_infimum_ ? kKeyLengthExtremum : partition->low_key_.size(),
+    partition->high_supremum_ ? nullptr : partition->high_key_.data(),
+    partition->high_supremum_ ? kKeyLengthExtremum : partition->high_key_.size()));
+  char key[kMaxKeyLength];
+  while (cursor.is_valid_record()) {
+    const KeyLength key_length = cursor.get_key_length();
+    const PayloadLength payload_length = cursor.get_payload_length();
+    cursor.copy_combined_key(key);
+    if (args.merge_mode_ == MasstreeParallelScan::kOrdered) {
+      partition->buffer_.append(reinterpret_cast<const char*>(&key_length), sizeof(key_length));
+      partition->buffer_.append(
+        reinterpret_cast<const char*>(&payload_length),
+        sizeof(payload_length));
+      partition->buffer_.append(key, key_length);
+      partition->buffer_.append(cursor.get_payload(), payload_length);
+    } else if (args.handler_) {
+      CHECK_ERROR_CODE(args.handler_(
+        args.user_context_,
+        partition_id,
+        key,
+        key_length,
+        cursor.get_payload(),
+        payload_length));
+    }
+    ++partition->record_count_;
+    CHECK_ERROR_CODE(cursor.next());
+  }
+  return kErrorCodeOk;
+}
+
+ErrorStack MasstreeParallelScan::scan_partition(thread::Thread* context, uint16_t partition_id) {
+  ASSERT_ND(partition_id < partitions_.size());
+  MasstreeScanPartition* partition = &partitions_[partition_id];
+  xct::XctManager* xct_manager = engine_->get_xct_manager();
+  if (args_.snapshot_only_) {
+    WRAP_ERROR_CODE(xct_manager->begin_snapshot_only_xct(context));
+  } else {
+    WRAP_ERROR_CODE(xct_manager->begin_xct(context, args_.isolation_level_));
+  }
+
+  ErrorCode scan_result = scan_partition_records(storage_, context, args_, partition_id, partition);
+  if (scan_result != kErrorCodeOk) {
+    WRAP_ERROR_CODE(xct_manager->abort_xct(context));
+    return ERROR_STACK(scan_result);
+  }
+
+  Epoch commit_epoch;
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  return kRetOk;
+}
+
+ErrorStack MasstreeParallelScan::execute(thread::Thread* context, const ExecuteArguments& args) {
+  if (partitions_.empty()) {
+    return ERROR_STACK(kErrorCodeInvalidParameter);
+  } else if (engine_->get_options().soc_.soc_type_ != kChildEmulated) {
+    return ERROR_STACK(kErrorCodeProcRegisterUnsupportedSocType);
+  } else if (args.merge_mode_ == kOrdered && args.handler_ == nullptr) {
+    return ERROR_STACK(kErrorCodeInvalidParameter);
+  }
+  args_ = args;
+  for (MasstreeScanPartition& partition : partitions_) {
+    partition.record_count_ = 0;
+    partition.buffer_.clear();
+  }
+
+  // One session per partition. When all workers are busy, wait for the oldest one.
+  thread::ThreadPool* pool = engine_->get_thread_pool();
+  const uint16_t count = partitions_.size();
+  std::vector<MasstreeParallelScanInput> inputs(count);
+  std::vector<thread::ImpersonateSession> sessions(count);
+  std::deque<uint16_t> in_flight;
+  ErrorStackBatch batch;
+  for (uint16_t i = 0; i < count; ++i) {
+    inputs[i].scan_ = this;
+    inputs[i].partition_ = i;
+    while (!pool->impersonate(kWorkerProcName, &inputs[i], sizeof(inputs[i]), &sessions[i])) {
+      if (!in_flight.empty()) {
+        batch.push_back(sessions[in_flight.front()].get_result());
+        sessions[in_flight.front()].release();
+        in_flight.pop_front();
+      } else if (context && !context->is_running_xct()) {
+        // Even the caller's own thread might be the only one in the pool
+        batch.push_back(scan_partition(context, i));
+        break;
+      } else {
+        batch.push_back(ERROR_STACK(kErrorCodeThrNoThreadAvailable));
+        break;
+      }
+    }
+    if (sessions[i].is_valid()) {
+      in_flight.push_back(i);
+    }
+  }
+  for (uint16_t i : in_flight) {
+    batch.push_back(sessions[i].get_result());
+    sessions[i].release();
+  }
+  CHECK_ERROR(SUMMARIZE_ERROR_BATCH(batch));
+
+  if (args.merge_mode_ == kOrdered) {
+    // Partitions are ordered by key, so just concatenate them.
+    for (uint16_t i = 0; i < count; ++i) {
+      const std::string& buffer = partitions_[i].buffer_;
+      for (uint64_t pos = 0; pos < buffer.size();) {
+        KeyLength key_length;
+        PayloadLength payload_length;
+        std::memcpy(&key_length, buffer.data() + pos, sizeof(key_length));
+        pos += sizeof(key_length);
+        std::memcpy(&payload_length, buffer.data() + pos, sizeof(payload_length));
+        pos += sizeof(payload_length);
+        const char* key = buffer.data() + pos;
+        pos += key_length;
+        const char* payload = buffer.data() + pos;
+        pos += payload_length;
+        ASSERT_ND(pos <= buffer.size());
+        WRAP_ERROR_CODE(args.handler_(
+          args.user_context_,
+          i,
+          key,
+          key_length,
+          payload,
+          payload_length));
+      }
+    }
+  }
+  return kRetOk;
+}
+
+}  // namespace masstree
+}  // namespace storage
+}  // namespace foedus
@@ -95,6 +95,7 @@ ErrorStack MasstreePartitioner::design_partition(
     data_->partition_count_ = 1;
     data_->low_keys_[0] = kInfimumSlice;
     data_->partitions_[0] = 0;
+    metadata_->access_statistics_.clear();
   } else {
     // simply the separators in root page is the partition keys.
     // if we already have a snapshot page, we use the same partition keys, though
@@ -113,6 +114,20 @@ ErrorStack MasstreePartitioner::design_partition(
         ++data_->partition_count_;
       }
     }
+
+    // key ranges mostly read by one node since the previous snapshot go to the node.
+    // then we sample accesses per the same key ranges for the next snapshot.
+    PartitionerAccessStatistics* statistics = &metadata_->access_statistics_;
+    for (uint16_t i = 0; i < data_->partition_count_; ++i) {
+      const KeySlice low = data_->low_keys_[i];
+      const KeySlice high
+        = i + 1U < data_->partition_count_ ? data_->low_keys_[i + 1U] : kSupremumSlice;
+      PartitionId node;
+      if (statistics->find_dominant_node(low, high, &node) && node < engine_->get_soc_count()) {
+        data_->partitions_[i] = node;
+      }
+    }
+    statistics->reset(data_->low_keys_, data_->partition_count_);
   }
 
   metadata_->valid_ = true;
@@ -450,7 +465,8 @@ void prepare_sort_entries(const Partitioner::SortBatchArguments& args, SortEntry
     ASSERT_ND(log_entry->header_.log_type_code_ == log::kLogCodeMasstreeInsert
       || log_entry->header_.log_type_code_ == log::kLogCodeMasstreeDelete
       || log_entry->header_.log_type_code_ == log::kLogCodeMasstreeUpdate
-      || log_entry->header_.log_type_code_ == log::kLogCodeMasstreeOverwrite);
+      || log_entry->header_.log_type_code_ == log::kLogCodeMasstreeOverwrite
+      || log_entry->header_.log_type_code_ == log::kLogCodeMasstreeDelta);
     ASSERT_ND(log_entry->key_length_ == sizeof(KeySlice));
     Epoch epoch = log_entry->header_.xct_id_.get_epoch();
     ASSERT_ND(epoch.subtract(base_epoch) < (1U << 16));
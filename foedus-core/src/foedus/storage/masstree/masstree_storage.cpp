@@ -66,6 +66,9 @@ ErrorStack  MasstreeStorage::create(const Metadata &metadata) {
 ErrorStack MasstreeStorage::load(const StorageControlBlock& snapshot_block) {
   return MasstreeStoragePimpl(this).load(snapshot_block);
 }
+ErrorStack MasstreeStorage::load_snapshot_view(const StorageControlBlock& snapshot_block) {
+  return MasstreeStoragePimpl(this).load_snapshot_view(snapshot_block);
+}
 ErrorStack  MasstreeStorage::drop()   { return MasstreeStoragePimpl(this).drop(); }
 
 std::ostream& operator<<(std::ostream& o, const MasstreeStorage& v) {
@@ -572,6 +575,69 @@ ErrorCode MasstreeStorage::increment_record_normalized(
     payload_offset);
 }
 
+template <typename PAYLOAD>
+ErrorCode MasstreeStorage::delta_record(
+  thread::Thread* context,
+  const void* key,
+  KeyLength key_length,
+  DeltaOperator op,
+  PAYLOAD operand,
+  PayloadLength payload_offset) {
+  if (!is_valid_delta<PAYLOAD>(op)) {
+    return kErrorCodeInvalidParameter;
+  }
+  // Automatically switch to faster implementation for 8-byte keys
+  if (key_length == sizeof(KeySlice)) {
+    KeySlice slice = normalize_be_bytes_full(key);
+    return delta_record_normalized<PAYLOAD>(context, slice, op, operand, payload_offset);
+  }
+
+  MasstreeStoragePimpl pimpl(this);
+  RecordLocation location;
+  CHECK_ERROR_CODE(pimpl.locate_record(
+    context,
+    key,
+    key_length,
+    true,
+    &location));
+  return pimpl.delta_general<PAYLOAD>(
+    context,
+    location,
+    key,
+    key_length,
+    op,
+    operand,
+    payload_offset);
+}
+
+template <typename PAYLOAD>
+ErrorCode MasstreeStorage::delta_record_normalized(
+  thread::Thread* context,
+  KeySlice key,
+  DeltaOperator op,
+  PAYLOAD operand,
+  PayloadLength payload_offset) {
+  if (!is_valid_delta<PAYLOAD>(op)) {
+    return kErrorCodeInvalidParameter;
+  }
+  MasstreeStoragePimpl pimpl(this);
+  RecordLocation location;
+  CHECK_ERROR_CODE(pimpl.locate_record_normalized(
+    context,
+    key,
+    true,
+    &location));
+  uint64_t be_key = assorted::htobe<uint64_t>(key);
+  return pimpl.delta_general<PAYLOAD>(
+    context,
+    location,
+    &be_key,
+    sizeof(be_key),
+    op,
+    operand,
+    payload_offset);
+}
+
 ErrorStack MasstreeStorage::verify_single_thread(thread::Thread* context) {
   return MasstreeStoragePimpl(this).verify_single_thread(context);
 }
@@ -654,6 +720,21 @@ INSTANTIATE_ALL_NUMERIC_TYPES(EXPIN_5);
 #define EXPIN_6(x) template ErrorCode MasstreeStorage::increment_record_normalized< x > \
   (thread::Thread* context, KeySlice key, x* value, PayloadLength payload_offset)
 INSTANTIATE_ALL_NUMERIC_TYPES(EXPIN_6);
+
+// delta_record() does not allow bool
+#define EXPIN_7(x) template ErrorCode MasstreeStorage::delta_record< x > \
+  (thread::Thread* context, const void* key, KeyLength key_length, DeltaOperator op, \
+  x operand, PayloadLength payload_offset)
+INSTANTIATE_ALL_INTEGER_TYPES(EXPIN_7);
+EXPIN_7(float);  // NOLINT(readability/function)
+EXPIN_7(double);  // NOLINT(readability/function)
+
+#define EXPIN_8(x) template ErrorCode MasstreeStorage::delta_record_normalized< x > \
+  (thread::Thread* context, KeySlice key, DeltaOperator op, x operand, \
+  PayloadLength payload_offset)
+INSTANTIATE_ALL_INTEGER_TYPES(EXPIN_8);
+EXPIN_8(float);  // NOLINT(readability/function)
+EXPIN_8(double);  // NOLINT(readability/function)
 // @endcond
 
 }  // namespace masstree
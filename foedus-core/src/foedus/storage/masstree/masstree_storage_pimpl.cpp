@@ -205,6 +205,16 @@ ErrorStack MasstreeStoragePimpl::load(const StorageControlBlock& snapshot_block)
   return kRetOk;
 }
 
+ErrorStack MasstreeStoragePimpl::load_snapshot_view(const StorageControlBlock& snapshot_block) {
+  control_block_->meta_ = static_cast<const MasstreeMetadata&>(snapshot_block.meta_);
+  control_block_->root_page_pointer_.snapshot_pointer_
+    = control_block_->meta_.root_snapshot_page_id_;
+  control_block_->root_page_pointer_.volatile_pointer_.word = 0;
+  control_block_->first_root_locked_ = false;
+  control_block_->status_ = kExists;
+  return kRetOk;
+}
+
 /////////////////////////////////////////////////////////////////////////////
 ///
 ///  Record-wise or page-wise operations
@@ -838,6 +848,51 @@ ErrorCode MasstreeStoragePimpl::increment_general(
   return register_record_write_log(context, location, log_entry);
 }
 
+template <typename PAYLOAD>
+ErrorCode MasstreeStoragePimpl::delta_general(
+  thread::Thread* context,
+  const RecordLocation& location,
+  const void* be_key,
+  KeyLength key_length,
+  DeltaOperator op,
+  PAYLOAD operand,
+  PayloadLength payload_offset) {
+  if (location.observed_.is_deleted()) {
+    // This result is protected by readset
+    return kErrorCodeStrKeyNotFound;
+  }
+  CHECK_ERROR_CODE(check_next_layer_bit(location.observed_));
+  MasstreeBorderPage* border = location.page_;
+  if (border->get_payload_length(location.index_) < payload_offset + sizeof(PAYLOAD)) {
+    LOG(WARNING) << "short record ";  // probably this is a rare error. so warn.
+    return kErrorCodeStrTooShortPayload;
+  }
+
+  // The delta does not depend on the current value. Instead of verifying the observed TID,
+  // precommit checks the record is still there and long enough after taking the lock.
+  xct::Xct* cur_xct = &context->get_current_xct();
+  if (location.readset_) {
+    cur_xct->remove_last_read(location.readset_);
+  }
+
+  uint16_t log_length = MasstreeDeltaLogType::calculate_log_length(key_length, sizeof(PAYLOAD));
+  MasstreeDeltaLogType* log_entry = reinterpret_cast<MasstreeDeltaLogType*>(
+    context->get_thread_log_buffer().reserve_new_log(log_length));
+  log_entry->populate<PAYLOAD>(
+    get_id(),
+    be_key,
+    key_length,
+    op,
+    operand,
+    payload_offset);
+  border->header().stat_last_updater_node_ = context->get_numa_node();
+  return cur_xct->add_to_write_set(
+    get_id(),
+    border->get_owner_id(location.index_),
+    border->get_record(location.index_),
+    log_entry);
+}
+
 // Defines MasstreeStorage methods so that we can inline implementation calls
 xct::TrackMovedRecordResult MasstreeStorage::track_moved_record(
   xct::RwLockableXctId* old_address,
@@ -862,6 +917,14 @@ inline xct::TrackMovedRecordResult MasstreeStoragePimpl::track_moved_record(
   (thread::Thread* context, const RecordLocation& location, \
   const void* be_key, KeyLength key_length, x* value, PayloadLength payload_offset)
 INSTANTIATE_ALL_NUMERIC_TYPES(EXPIN_5);
+
+#define EXPIN_6(x) template ErrorCode MasstreeStoragePimpl::delta_general< x > \
+  (thread::Thread* context, const RecordLocation& location, \
+  const void* be_key, KeyLength key_length, DeltaOperator op, x operand, \
+  PayloadLength payload_offset)
+INSTANTIATE_ALL_INTEGER_TYPES(EXPIN_6);
+EXPIN_6(float);  // NOLINT(readability/function)
+EXPIN_6(double);  // NOLINT(readability/function)
 // @endcond
 
 }  // namespace masstree
@@ -19,16 +19,23 @@
 
 #include <glog/logging.h>
 
+#include <algorithm>
+#include <cstring>
 #include <ostream>
 
 #include "foedus/engine.hpp"
+#include "foedus/engine_options.hpp"
 #include "foedus/assorted/assorted_func.hpp"
+#include "foedus/assorted/atomic_fences.hpp"
 #include "foedus/soc/shared_memory_repo.hpp"
 #include "foedus/soc/soc_manager.hpp"
 #include "foedus/storage/storage.hpp"
 #include "foedus/storage/storage_manager.hpp"
+#include "foedus/storage/array/array_page_impl.hpp"
 #include "foedus/storage/array/array_partitioner_impl.hpp"
+#include "foedus/storage/hash/hash_page_impl.hpp"
 #include "foedus/storage/hash/hash_partitioner_impl.hpp"
+#include "foedus/storage/masstree/masstree_page_impl.hpp"
 #include "foedus/storage/masstree/masstree_partitioner_impl.hpp"
 #include "foedus/storage/sequential/sequential_partitioner_impl.hpp"
 
@@ -80,6 +87,90 @@ ErrorCode PartitionerMetadata::allocate_data(
   return kErrorCodeOk;
 }
 
+void PartitionerAccessStatistics::reset(const uint64_t* low_keys, uint32_t count) {
+  ASSERT_ND(count > 0);
+  // samplers see bucket_count_==0 while we are changing buckets. they might still be
+  // incrementing old counters, which is fine. they are just samples.
+  bucket_count_ = 0;
+  assorted::memory_fence_release();
+  // if there are more partitions than buckets, adjacent partitions share a bucket.
+  const uint32_t stride = (count + kMaxBuckets - 1U) / kMaxBuckets;
+  uint32_t buckets = 0;
+  for (uint32_t i = 0; i < count; i += stride) {
+    ASSERT_ND(i == 0 || low_keys[i] > low_keys[i - stride]);
+    bucket_low_keys_[buckets] = low_keys[i];
+    ++buckets;
+  }
+  ASSERT_ND(buckets <= kMaxBuckets);
+  std::memset(samples_, 0, sizeof(samples_));
+  total_samples_ = 0;
+  assorted::memory_fence_release();
+  bucket_count_ = buckets;
+}
+
+void PartitionerAccessStatistics::sample(uint64_t key, PartitionId node) {
+  const uint32_t buckets = bucket_count_;
+  if (buckets == 0 || node >= kMaxNodes) {
+    return;
+  }
+  ASSERT_ND(buckets <= kMaxBuckets);
+  // the last bucket whose low key is same or smaller than the key. the first bucket also
+  // receives keys smaller than its low key.
+  const uint64_t* pos = std::upper_bound(bucket_low_keys_ + 1U, bucket_low_keys_ + buckets, key);
+  const uint32_t bucket = (pos - bucket_low_keys_) - 1U;
+  ASSERT_ND(bucket < buckets);
+  ++samples_[bucket][node];
+  ++total_samples_;
+}
+
+bool PartitionerAccessStatistics::find_dominant_node(
+  uint64_t low_key,
+  uint64_t high_key,
+  PartitionId* node) const {
+  const uint32_t buckets = bucket_count_;
+  if (buckets == 0 || low_key >= high_key) {
+    return false;
+  }
+  uint32_t counts[kMaxNodes];
+  std::memset(counts, 0, sizeof(counts));
+  uint32_t total = 0;
+  for (uint32_t bucket = 0; bucket < buckets; ++bucket) {
+    const bool last = bucket + 1U == buckets;
+    if ((bucket > 0 && bucket_low_keys_[bucket] >= high_key)
+      || (!last && bucket_low_keys_[bucket + 1U] <= low_key)) {
+      continue;  // doesn't overlap with the key range
+    }
+    for (uint16_t i = 0; i < kMaxNodes; ++i) {
+      counts[i] += samples_[bucket][i];
+      total += samples_[bucket][i];
+    }
+  }
+  if (total < kMinSamples) {
+    return false;
+  }
+  const uint32_t* max_count = std::max_element(counts, counts + kMaxNodes);
+  if (*max_count * 2U <= total) {
+    return false;  // no majority
+  }
+  *node = max_count - counts;
+  return true;
+}
+
+std::ostream& operator<<(std::ostream& o, const PartitionerAccessStatistics& v) {
+  o << "<PartitionerAccessStatistics buckets=\"" << v.bucket_count_
+    << "\" samples=\"" << v.total_samples_ << "\">";
+  for (uint32_t bucket = 0; bucket < v.bucket_count_; ++bucket) {
+    o << "<bucket low=\"" << assorted::Hex(v.bucket_low_keys_[bucket]) << "\">";
+    for (uint16_t node = 0; node < PartitionerAccessStatistics::kMaxNodes; ++node) {
+      if (v.samples_[bucket][node]) {
+        o << "[Node-" << node << "]=" << v.samples_[bucket][node] << " ";
+      }
+    }
+    o << "</bucket>";
+  }
+  o << "</PartitionerAccessStatistics>";
+  return o;
+}
 
 Partitioner::Partitioner(Engine* engine, StorageId id)
   : Attachable< PartitionerMetadata >(engine, PartitionerMetadata::get_metadata(engine, id)) {
@@ -103,6 +194,37 @@ bool Partitioner::is_partitionable() {
   }
 }
 
+void Partitioner::sample_access(Engine* engine, const Page* page, PartitionId node) {
+  const PageHeader& header = page->get_header();
+  uint64_t key;
+  switch (header.get_page_type()) {
+  case kArrayPageType:
+    key = reinterpret_cast<const array::ArrayPage*>(page)->get_array_range().begin_;
+    break;
+  case kHashIntermediatePageType:
+    key = reinterpret_cast<const hash::HashIntermediatePage*>(page)->get_bin_range().begin_;
+    break;
+  case kHashDataPageType:
+    key = reinterpret_cast<const hash::HashDataPage*>(page)->get_bin();
+    break;
+  case kMasstreeIntermediatePageType:
+  case kMasstreeBorderPageType:
+    // partitions are defined in the first layer. we can't tell where deeper pages are.
+    if (header.masstree_layer_ != 0) {
+      return;
+    }
+    key = reinterpret_cast<const masstree::MasstreePage*>(page)->get_low_fence();
+    break;
+  default:
+    return;
+  }
+  const StorageId id = header.storage_id_;
+  if (id == 0 || id >= engine->get_options().storage_.max_storages_) {
+    return;
+  }
+  PartitionerMetadata::get_metadata(engine, id)->access_statistics_.sample(key, node);
+}
+
 ErrorStack Partitioner::design_partition(const DesignPartitionArguments& args) {
   switch (type_) {
   case kArrayStorage: return array::ArrayPartitioner(this).design_partition(args);
@@ -150,6 +272,7 @@ std::ostream& operator<<(std::ostream& o, const PartitionerMetadata& v) {
     << "<valid>" << v.valid_ << "</valid>"
     << "<data_offset_>" << assorted::Hex(v.data_offset_) << "</data_offset_>"
     << "<data_size_>" << assorted::Hex(v.data_size_) << "</data_size_>"
+    << v.access_statistics_
     << "</PartitionerMetadata>";
   return o;
 }
@@ -65,7 +65,10 @@ SequentialCursor::SequentialCursor(
       from_epoch.is_valid() ? from_epoch : engine_->get_savepoint_manager()->get_earliest_epoch()),
     to_epoch_(
       to_epoch.is_valid() ? to_epoch : engine_->get_xct_manager()->get_current_grace_epoch()),
-    latest_snapshot_epoch_(engine_->get_snapshot_manager()->get_snapshot_epoch()),
+    latest_snapshot_epoch_(
+      xct_->is_snapshot_only()
+        ? xct_->get_snapshot_only_epoch()
+        : engine_->get_snapshot_manager()->get_snapshot_epoch()),
     from_epoch_volatile_(max_from_epoch_snapshot_epoch(from_epoch_, latest_snapshot_epoch_)),
     node_filter_(node_filter),
     node_count_(engine_->get_soc_count()),
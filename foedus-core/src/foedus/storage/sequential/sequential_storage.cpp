@@ -64,6 +64,9 @@ ErrorStack SequentialStorage::create(const Metadata &metadata) {
 ErrorStack SequentialStorage::load(const StorageControlBlock& snapshot_block) {
   return SequentialStoragePimpl(this).load(snapshot_block);
 }
+ErrorStack SequentialStorage::load_snapshot_view(const StorageControlBlock& snapshot_block) {
+  return SequentialStoragePimpl(this).load_snapshot_view(snapshot_block);
+}
 ErrorStack SequentialStorage::drop() {
   return SequentialStoragePimpl(this).drop();
 }
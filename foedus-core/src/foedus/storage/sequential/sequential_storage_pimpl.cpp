@@ -185,6 +185,25 @@ ErrorStack SequentialStoragePimpl::load(const StorageControlBlock& snapshot_bloc
   LOG(INFO) << "Loaded a sequential-storage " << get_name();
   return kRetOk;
 }
+ErrorStack SequentialStoragePimpl::load_snapshot_view(const StorageControlBlock& snapshot_block) {
+  control_block_->meta_ = static_cast<const SequentialMetadata&>(snapshot_block.meta_);
+  Epoch truncate_epoch(control_block_->meta_.truncate_epoch_);
+  if (!truncate_epoch.is_valid()) {
+    truncate_epoch = engine_->get_earliest_epoch();
+  }
+  control_block_->cur_truncate_epoch_.store(truncate_epoch.value());
+  control_block_->cur_truncate_epoch_tid_.reset();
+  control_block_->cur_truncate_epoch_tid_.xct_id_.set_epoch(truncate_epoch);
+  control_block_->cur_truncate_epoch_tid_.xct_id_.set_ordinal(1);
+  // no volatile pages. snapshot-only cursors never read them.
+  std::memset(control_block_->head_pointer_pages_, 0, sizeof(control_block_->head_pointer_pages_));
+  std::memset(control_block_->tail_pointer_pages_, 0, sizeof(control_block_->tail_pointer_pages_));
+  control_block_->root_page_pointer_.snapshot_pointer_
+    = control_block_->meta_.root_snapshot_page_id_;
+  control_block_->root_page_pointer_.volatile_pointer_.word = 0;
+  control_block_->status_ = kExists;
+  return kRetOk;
+}
 ErrorStack SequentialStoragePimpl::initialize_head_tail_pages() {
   std::memset(control_block_->head_pointer_pages_, 0, sizeof(control_block_->head_pointer_pages_));
   std::memset(control_block_->tail_pointer_pages_, 0, sizeof(control_block_->tail_pointer_pages_));
@@ -226,6 +245,9 @@ ErrorCode SequentialStorageControlBlock::optimistic_read_truncate_epoch(
   }
 
   *out = Epoch(cur_truncate_epoch_.load());  // atomic!
+  if (cur_xct.is_snapshot_only()) {
+    return kErrorCodeOk;  // it never verifies anything
+  }
   CHECK_ERROR_CODE(cur_xct.add_to_lock_free_read_set(
     meta_.id_,
     observed,
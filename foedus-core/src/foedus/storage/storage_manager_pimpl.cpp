@@ -47,6 +47,7 @@
 #include "foedus/storage/array/array_log_types.hpp"
 #include "foedus/storage/array/array_metadata.hpp"
 #include "foedus/storage/array/array_storage.hpp"
+#include "foedus/storage/array/array_storage_pimpl.hpp"
 #include "foedus/storage/hash/hash_log_types.hpp"
 #include "foedus/storage/hash/hash_metadata.hpp"
 #include "foedus/storage/hash/hash_storage.hpp"
@@ -83,6 +84,12 @@ ErrorStack StorageManagerPimpl::initialize_once() {
   if (engine_->is_master()) {
     // initialize the shared memory. only on master engine
     control_block_->initialize();
+    if (engine_->get_soc_manager()->get_shared_memory_repo()->is_warm_restarted()) {
+      // storages and their volatile pages are what the previous engine left. just resume.
+      LOG(INFO) << "Warm restart. Resuming " << control_block_->largest_storage_id_
+        << " storages in the retained shared memory";
+      return kRetOk;
+    }
     control_block_->largest_storage_id_ = 0;
 
     // Then, initialize storages with latest snapshot
@@ -189,12 +196,24 @@ ErrorStack StorageManagerPimpl::reinitialize_for_recovered_snapshot() {
     // Here, we assume that the initially-allocated volatile root page does NOT have
     // any child volatile page (it shouldn't!). Otherwise, the following overwrite
     // will cause leaked volatile pages.
+    // The only exception is an array extended after the snapshot, which has volatile pages
+    // for the new range. We release them here and grow them again after the overwrite.
+    const bool is_array = block->meta_.type_ == kArrayStorage;
+    array::ArrayStoragePimpl array_pimpl(
+      engine_,
+      reinterpret_cast<array::ArrayStorageControlBlock*>(block));
+    if (is_array) {
+      array_pimpl.release_volatile_pages_except_root();
+    }
     WRAP_ERROR_CODE(fileset.read_page(snapshot_page_id, volatile_page));
     ASSERT_ND(volatile_page->get_header().snapshot_);
     ASSERT_ND(volatile_page->get_header().storage_id_ == id);
     ASSERT_ND(volatile_page->get_snapshot_page_id() == snapshot_page_id);
     volatile_page->get_header().snapshot_ = false;
     volatile_page->get_header().page_id_ = volatile_page_id.word;
+    if (is_array) {
+      CHECK_ERROR(array_pimpl.grow_volatile_pages(&fileset));
+    }
     ++refreshed_storages;
   }
 
@@ -212,7 +231,11 @@ ErrorStack StorageManagerPimpl::uninitialize_once() {
     || !engine_->get_log_manager()->is_initialized()) {
     batch.emprace_back(ERROR_STACK(kErrorCodeDepedentModuleUnavailableUninit));
   }
-  if (engine_->is_master()) {
+  if (engine_->is_master()
+    && engine_->get_soc_manager()->get_shared_memory_repo()->is_retain_at_shutdown()) {
+    LOG(INFO) << "Retaining storages and their volatile pages for warm restart";
+    control_block_->uninitialize();
+  } else if (engine_->is_master()) {
     // drop all existing storages just for releasing memories.
     // this is not a real drop, so we just invoke drop_apply
     uint32_t dropped = 0;
@@ -453,11 +476,13 @@ xct::TrackMovedRecordResult StorageManagerPimpl::track_moved_record(
   StorageId storage_id,
   xct::RwLockableXctId* old_address,
   xct::WriteXctAccess* write_set) {
-  // so far Masstree and Hash have tracking
+  // so far Array, Masstree, and Hash have tracking
   StorageControlBlock* block = storages_ + storage_id;
   ASSERT_ND(block->exists());
   StorageType type = block->meta_.type_;
-  if (type == kMasstreeStorage) {
+  if (type == kArrayStorage) {
+    return array::ArrayStorage(engine_, block).track_moved_record(old_address, write_set);
+  } else if (type == kMasstreeStorage) {
     return masstree::MasstreeStorage(engine_, block).track_moved_record(old_address, write_set);
   } else if (type == kHashStorage) {
     return hash::HashStorage(engine_, block).track_moved_record(old_address, write_set);
@@ -467,6 +492,34 @@ xct::TrackMovedRecordResult StorageManagerPimpl::track_moved_record(
   }
 }
 
+ErrorCode StorageManager::migrate_volatile_page(
+  thread::Thread* context,
+  StorageId storage_id,
+  uint64_t page_key,
+  bool* migrated) {
+  return pimpl_->migrate_volatile_page(context, storage_id, page_key, migrated);
+}
+
+ErrorCode StorageManagerPimpl::migrate_volatile_page(
+  thread::Thread* context,
+  StorageId storage_id,
+  uint64_t page_key,
+  bool* migrated) {
+  // so far only Array supports migration
+  *migrated = false;
+  StorageControlBlock* block = storages_ + storage_id;
+  if (!block->exists()) {
+    return kErrorCodeOk;  // dropped after sampled
+  }
+  StorageType type = block->meta_.type_;
+  if (type == kArrayStorage) {
+    return array::ArrayStorage(engine_, block).migrate_volatile_page(context, page_key, migrated);
+  } else {
+    LOG(WARNING) << "This storage type doesn't support volatile page migration. type=" << type;
+    return kErrorCodeOk;
+  }
+}
+
 ErrorStack StorageManagerPimpl::clone_all_storage_metadata(
   snapshot::SnapshotMetadata *metadata) {
   debugging::StopWatch stop_watch;
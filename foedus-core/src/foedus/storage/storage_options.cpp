@@ -21,11 +21,17 @@ namespace storage {
 StorageOptions::StorageOptions() {
   max_storages_ = kDefaultMaxStorages;
   partitioner_data_memory_mb_ = kDefaultPartitionerDataMemoryMb;
+  partitioner_access_sample_interval_ = 0;
+  volatile_page_migration_sample_interval_ = 0;
+  volatile_page_migration_min_samples_ = kDefaultVolatilePageMigrationMinSamples;
   hot_threshold_ = kDefaultHotThreshold;
 }
 ErrorStack StorageOptions::load(tinyxml2::XMLElement* element) {
   EXTERNALIZE_LOAD_ELEMENT(element, max_storages_);
   EXTERNALIZE_LOAD_ELEMENT(element, partitioner_data_memory_mb_);
+  EXTERNALIZE_LOAD_ELEMENT(element, partitioner_access_sample_interval_);
+  EXTERNALIZE_LOAD_ELEMENT(element, volatile_page_migration_sample_interval_);
+  EXTERNALIZE_LOAD_ELEMENT(element, volatile_page_migration_min_samples_);
   EXTERNALIZE_LOAD_ELEMENT(element, hot_threshold_);
   return kRetOk;
 }
@@ -37,6 +43,15 @@ ErrorStack StorageOptions::save(tinyxml2::XMLElement* element) const {
     "Size in MB of a shared memory buffer allocated for all partitioners during log gleaning."
     "Increase this value when you have a large number of storages that have large partitioning"
     " information (eg. long keys).");
+  EXTERNALIZE_SAVE_ELEMENT(element, partitioner_access_sample_interval_,
+    "Every this number of snapshot-cache misses, a worker thread records the key range and its"
+    " NUMA node so that partitioners assign the range to the node that mostly reads it."
+    " 0 disables sampling.");
+  EXTERNALIZE_SAVE_ELEMENT(element, volatile_page_migration_sample_interval_,
+    "Every this number of accesses to volatile pages in a remote NUMA node, a worker thread"
+    " records the page as a candidate to migrate to its own node. 0 disables migration.");
+  EXTERNALIZE_SAVE_ELEMENT(element, volatile_page_migration_min_samples_,
+    "A candidate page is migrated when it is sampled this number of times.");
   EXTERNALIZE_SAVE_ELEMENT(element, hot_threshold_,
     "Hot record threshold; for HCC only.");
   return kRetOk;
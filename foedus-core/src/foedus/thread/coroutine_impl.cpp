@@ -0,0 +1,358 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include "foedus/thread/coroutine_impl.hpp"
+
+#include <aio.h>
+#include <errno.h>
+#include <glog/logging.h>
+
+#include <chrono>
+#include <cstring>
+
+#include "foedus/assert_nd.hpp"
+#include "foedus/engine.hpp"
+#include "foedus/engine_options.hpp"
+#include "foedus/error_stack_batch.hpp"
+#include "foedus/assorted/assorted_func.hpp"
+#include "foedus/cache/snapshot_file_set.hpp"
+#include "foedus/fs/direct_io_file.hpp"
+#include "foedus/log/log_manager.hpp"
+#include "foedus/log/thread_log_buffer.hpp"
+#include "foedus/memory/numa_node_memory.hpp"
+#include "foedus/storage/page.hpp"
+#include "foedus/thread/thread.hpp"
+#include "foedus/thread/thread_pimpl.hpp"
+#include "foedus/xct/retrospective_lock_list.hpp"
+#include "foedus/xct/sysxct_impl.hpp"
+#include "foedus/xct/xct_access.hpp"
+#include "foedus/xct/xct_manager.hpp"
+#include "foedus/xct/xct_options.hpp"
+
+namespace foedus {
+namespace thread {
+
+CoroutineScheduler::CoroutineScheduler(ThreadPimpl* pimpl)
+  : pimpl_(pimpl),
+    engine_(pimpl->engine_),
+    current_(nullptr),
+    active_count_(0),
+    stack_size_(0),
+    yield_count_(0) {
+}
+
+uint64_t CoroutineScheduler::calculate_memory_size_per_coroutine(const EngineOptions& options) {
+  const xct::XctOptions& xct_opt = options.xct_;
+  uint64_t memory_size = static_cast<uint64_t>(options.thread_.coroutine_stack_kb_) << 10;
+  memory_size += static_cast<uint64_t>(xct_opt.local_work_memory_size_mb_) << 20;
+  // Same pieces as NumaCoreMemory's small_thread_local_memory_, minus the retired-page chunks
+  memory_size += sizeof(xct::SysxctWorkspace);
+  memory_size += sizeof(xct::PageVersionAccess) * xct::Xct::kMaxPageVersionSets;
+  memory_size += sizeof(xct::PointerAccess) * xct::Xct::kMaxPointerSets;
+  memory_size += sizeof(xct::ReadXctAccess) * xct_opt.max_read_set_size_;
+  memory_size += sizeof(xct::WriteXctAccess) * xct_opt.max_write_set_size_;
+  memory_size += sizeof(xct::LockFreeReadXctAccess) * xct_opt.max_lock_free_read_set_size_;
+  memory_size += sizeof(xct::LockFreeWriteXctAccess) * xct_opt.max_lock_free_write_set_size_;
+  const uint64_t total_access_sets = xct_opt.max_read_set_size_ + xct_opt.max_write_set_size_;
+  memory_size += sizeof(xct::LockEntry) * total_access_sets * 2U;
+  return assorted::align<uint64_t, 1U << 12>(memory_size);
+}
+
+ErrorStack CoroutineScheduler::initialize_once() {
+  const EngineOptions& options = engine_->get_options();
+  const uint16_t count = options.thread_.coroutines_per_thread_;
+  ASSERT_ND(count > 0);
+  stack_size_ = static_cast<uint64_t>(options.thread_.coroutine_stack_kb_) << 10;
+  const uint64_t memory_size = calculate_memory_size_per_coroutine(options);
+  const xct::XctOptions& xct_opt = options.xct_;
+  const uint64_t work_memory_size = static_cast<uint64_t>(xct_opt.local_work_memory_size_mb_) << 20;
+  const uint64_t total_access_sets = xct_opt.max_read_set_size_ + xct_opt.max_write_set_size_;
+  VLOG(0) << "Thread-" << pimpl_->id_ << " creating " << count << " coroutines, each of which"
+    << " takes " << memory_size << " bytes";
+  for (uint16_t i = 0; i < count; ++i) {
+    Coroutine* coroutine = new Coroutine(engine_, pimpl_->holder_, pimpl_->id_, i);
+    coroutines_.push_back(coroutine);
+    CHECK_ERROR(pimpl_->node_memory_->allocate_numa_memory(memory_size, &coroutine->memory_));
+
+    char* memory = reinterpret_cast<char*>(coroutine->memory_.get_block());
+    memory += stack_size_;  // the stack comes first
+    xct::Xct::MemoryPieces pieces;
+    pieces.local_work_memory_ = memory;
+    pieces.local_work_memory_size_ = work_memory_size;
+    memory += work_memory_size;
+    pieces.sysxct_workspace_ = reinterpret_cast<xct::SysxctWorkspace*>(memory);
+    memory += sizeof(xct::SysxctWorkspace);
+    pieces.page_version_set_ = reinterpret_cast<xct::PageVersionAccess*>(memory);
+    memory += sizeof(xct::PageVersionAccess) * xct::Xct::kMaxPageVersionSets;
+    pieces.pointer_set_ = reinterpret_cast<xct::PointerAccess*>(memory);
+    memory += sizeof(xct::PointerAccess) * xct::Xct::kMaxPointerSets;
+    pieces.read_set_ = reinterpret_cast<xct::ReadXctAccess*>(memory);
+    memory += sizeof(xct::ReadXctAccess) * xct_opt.max_read_set_size_;
+    pieces.write_set_ = reinterpret_cast<xct::WriteXctAccess*>(memory);
+    memory += sizeof(xct::WriteXctAccess) * xct_opt.max_write_set_size_;
+    pieces.lock_free_read_set_ = reinterpret_cast<xct::LockFreeReadXctAccess*>(memory);
+    memory += sizeof(xct::LockFreeReadXctAccess) * xct_opt.max_lock_free_read_set_size_;
+    pieces.lock_free_write_set_ = reinterpret_cast<xct::LockFreeWriteXctAccess*>(memory);
+    memory += sizeof(xct::LockFreeWriteXctAccess) * xct_opt.max_lock_free_write_set_size_;
+    pieces.current_lock_list_ = reinterpret_cast<xct::LockEntry*>(memory);
+    pieces.current_lock_list_capacity_ = total_access_sets;
+    memory += sizeof(xct::LockEntry) * total_access_sets;
+    pieces.retrospective_lock_list_ = reinterpret_cast<xct::LockEntry*>(memory);
+    pieces.retrospective_lock_list_capacity_ = total_access_sets;
+    memory += sizeof(xct::LockEntry) * total_access_sets;
+    ASSERT_ND(memory <= reinterpret_cast<char*>(coroutine->memory_.get_block()) + memory_size);
+    // Coroutines are for many short transactions. They don't reserve room to grow.
+    pieces.growth_factor_ = 1U;
+
+    coroutine->xct_.initialize(
+      pieces,
+      &pimpl_->control_block_->mcs_block_current_,
+      &pimpl_->control_block_->mcs_rw_async_mapping_current_);
+  }
+  current_ = nullptr;
+  active_count_ = 0;
+  yield_count_ = 0;
+  return kRetOk;
+}
+
+ErrorStack CoroutineScheduler::uninitialize_once() {
+  ASSERT_ND(current_ == nullptr);
+  for (Coroutine* coroutine : coroutines_) {
+    coroutine->memory_.release_block();
+    delete coroutine;
+  }
+  coroutines_.clear();
+  return kRetOk;
+}
+
+uint16_t CoroutineScheduler::get_current_ordinal() const {
+  ASSERT_ND(current_);
+  return current_->ordinal_;
+}
+
+/** Carries over the latest XctId so that XctIds issued on this thread keep increasing. */
+inline void propagate_xct_id(const xct::Xct& from, xct::Xct* to) {
+  const xct::XctId& id = from.get_id();
+  if (id.is_valid() && id.get_ordinal() > 0 && to->get_id().before(id)) {
+    to->remember_previous_xct_id(id);
+  }
+}
+
+ErrorStack CoroutineScheduler::run(
+  proc::Proc proc,
+  uint16_t count,
+  const void* input,
+  uint32_t input_len) {
+  if (current_ || pimpl_->current_xct_->is_active()) {
+    return ERROR_STACK(kErrorCodeThrAlreadyInCoroutine);
+  } else if (count == 0 || count > coroutines_.size()) {
+    return ERROR_STACK(kErrorCodeInvalidParameter);
+  }
+
+  const xct::Xct& thread_xct = pimpl_->default_xct_;
+  const uint64_t address = reinterpret_cast<uintptr_t>(this);
+  for (uint16_t i = 0; i < count; ++i) {
+    Coroutine* coroutine = coroutines_[i];
+    ASSERT_ND(!coroutine->xct_.is_active());
+    coroutine->finished_ = false;
+    coroutine->proc_ = proc;
+    coroutine->output_used_ = 0;
+    coroutine->result_ = kRetOk;
+    proc::ProcArguments args = {
+      engine_,
+      pimpl_->holder_,
+      input,
+      input_len,
+      nullptr,
+      0,
+      &coroutine->output_used_,
+    };
+    coroutine->args_ = args;
+    // Each impersonation resets these defaults on the thread's Xct. Inherit them.
+    coroutine->xct_.set_default_rll_for_this_xct(thread_xct.is_default_rll_for_this_xct());
+    coroutine->xct_.set_default_hot_threshold_for_this_xct(
+      thread_xct.get_default_hot_threshold_for_this_xct());
+    coroutine->xct_.set_default_rll_threshold_for_this_xct(
+      thread_xct.get_default_rll_threshold_for_this_xct());
+
+    ::getcontext(&coroutine->context_);
+    coroutine->context_.uc_stack.ss_sp = coroutine->memory_.get_block();
+    coroutine->context_.uc_stack.ss_size = stack_size_;
+    coroutine->context_.uc_link = &scheduler_context_;
+    ::makecontext(
+      &coroutine->context_,
+      reinterpret_cast<void (*)()>(&CoroutineScheduler::entry_point),
+      2,
+      static_cast<uint32_t>(address >> 32),
+      static_cast<uint32_t>(address));
+  }
+
+  active_count_ = count;
+  for (uint16_t cur = 0; active_count_ > 0; cur = (cur + 1U) % count) {
+    Coroutine* coroutine = coroutines_[cur];
+    if (!coroutine->finished_) {
+      switch_to(coroutine);
+      if (coroutine->finished_) {
+        ASSERT_ND(active_count_ > 0);
+        --active_count_;
+      }
+    }
+  }
+
+  ErrorStackBatch batch;
+  for (uint16_t i = 0; i < count; ++i) {
+    batch.push_back(coroutines_[i]->result_);
+  }
+  return SUMMARIZE_ERROR_BATCH(batch);
+}
+
+void CoroutineScheduler::switch_to(Coroutine* coroutine) {
+  ASSERT_ND(current_ == nullptr);
+  ASSERT_ND(pimpl_->current_xct_ == &pimpl_->default_xct_);
+  propagate_xct_id(pimpl_->default_xct_, &coroutine->xct_);
+  // No suspended coroutine holds a lock, so MCS blocks can be recycled from scratch
+  pimpl_->control_block_->mcs_block_current_ = 0;
+  pimpl_->control_block_->mcs_rw_async_mapping_current_ = 0;
+  pimpl_->current_xct_ = &coroutine->xct_;
+  current_ = coroutine;
+
+  ::swapcontext(&scheduler_context_, &coroutine->context_);
+
+  ASSERT_ND(current_ == coroutine);
+  current_ = nullptr;
+  pimpl_->current_xct_ = &pimpl_->default_xct_;
+  propagate_xct_id(coroutine->xct_, &pimpl_->default_xct_);
+}
+
+void CoroutineScheduler::entry_point(uint32_t address_high, uint32_t address_low) {
+  const uint64_t address = (static_cast<uint64_t>(address_high) << 32) | address_low;
+  CoroutineScheduler* scheduler = reinterpret_cast<CoroutineScheduler*>(address);
+  scheduler->run_current();
+  // returning from here resumes uc_link, which is scheduler_context_
+}
+
+void CoroutineScheduler::run_current() {
+  Coroutine* coroutine = current_;
+  ASSERT_ND(coroutine);
+  coroutine->result_ = coroutine->proc_(coroutine->args_);
+  if (coroutine->xct_.is_active()) {
+    LOG(WARNING) << "Thread-" << pimpl_->id_ << " coroutine-" << coroutine->ordinal_
+      << " returned without ending its transaction. Aborting it";
+    engine_->get_xct_manager()->abort_xct(pimpl_->holder_);
+  }
+  coroutine->finished_ = true;
+}
+
+bool CoroutineScheduler::is_yieldable() const {
+  if (current_ == nullptr) {
+    return false;
+  }
+  const xct::Xct& xct = current_->xct_;
+  ASSERT_ND(pimpl_->current_xct_ == &xct);
+  if (xct.get_current_lock_list()->get_max_locked_id() != xct::kNullUniversalLockId) {
+    return false;
+  } else if (xct.get_sysxct_workspace()->running_sysxct_) {
+    return false;
+  }
+  const log::ThreadLogBuffer& buffer = pimpl_->log_buffer_;
+  return buffer.get_offset_tail() == buffer.get_offset_committed();
+}
+
+bool CoroutineScheduler::yield() {
+  if (active_count_ <= 1U || !is_yieldable()) {
+    return false;
+  }
+  Coroutine* coroutine = current_;
+  ++yield_count_;
+  ::swapcontext(&coroutine->context_, &scheduler_context_);
+  ASSERT_ND(current_ == coroutine);
+  return true;
+}
+
+ErrorCode CoroutineScheduler::read_a_snapshot_page(
+  storage::SnapshotPagePointer page_id,
+  storage::Page* buffer) {
+  ASSERT_ND(is_yieldable());
+  fs::DirectIoFile* file;
+  CHECK_ERROR_CODE(pimpl_->snapshot_file_set_.get_or_open_file(page_id, &file));
+
+  struct aiocb request;
+  std::memset(&request, 0, sizeof(request));
+  request.aio_fildes = file->get_descriptor();
+  request.aio_buf = buffer;
+  request.aio_nbytes = sizeof(storage::Page);
+  request.aio_offset = cache::SnapshotFileSet::get_file_offset(page_id);
+  request.aio_sigevent.sigev_notify = SIGEV_NONE;
+  if (::aio_read(&request) != 0) {
+    LOG(WARNING) << "aio_read() failed. Falling back to synchronous read. err="
+      << assorted::os_error();
+    return pimpl_->snapshot_file_set_.read_page(page_id, buffer);
+  }
+
+  int status;
+  while ((status = ::aio_error(&request)) == EINPROGRESS) {
+    if (!yield()) {
+      // Nothing else to run. Just block on it.
+      const struct aiocb* requests[1] = { &request };
+      ::aio_suspend(requests, 1, nullptr);
+    }
+  }
+  ssize_t read_bytes = ::aio_return(&request);
+  if (status != 0 || read_bytes != static_cast<ssize_t>(sizeof(storage::Page))) {
+    LOG(ERROR) << "Asynchronous read of a snapshot page failed. page_id="
+      << assorted::Hex(page_id) << ", status=" << status << ", read_bytes=" << read_bytes;
+    return kErrorCodeFsTooShortRead;
+  }
+  ASSERT_ND(buffer->get_header().page_id_ == page_id);
+  return kErrorCodeOk;
+}
+
+ErrorCode CoroutineScheduler::wait_for_commit(Epoch commit_epoch, int64_t wait_microseconds) {
+  ASSERT_ND(is_yieldable());
+  log::LogManager* log_manager = engine_->get_log_manager();
+  ErrorCode code = log_manager->wait_until_durable(commit_epoch, 0);
+  if (code != kErrorCodeTimeout || wait_microseconds == 0) {
+    return code;
+  }
+
+  log_manager->wakeup_loggers();
+  const auto until
+    = std::chrono::high_resolution_clock::now() + std::chrono::microseconds(wait_microseconds);
+  while (true) {
+    if (!yield()) {
+      // No other coroutine can run meanwhile. Block on it as usual.
+      int64_t remaining = wait_microseconds;
+      if (wait_microseconds > 0) {
+        remaining = std::chrono::duration_cast<std::chrono::microseconds>(
+          until - std::chrono::high_resolution_clock::now()).count();
+        if (remaining <= 0) {
+          return log_manager->wait_until_durable(commit_epoch, 0);
+        }
+      }
+      return log_manager->wait_until_durable(commit_epoch, remaining);
+    }
+    code = log_manager->wait_until_durable(commit_epoch, 0);
+    if (code != kErrorCodeTimeout) {
+      return code;
+    } else if (wait_microseconds > 0 && std::chrono::high_resolution_clock::now() >= until) {
+      return kErrorCodeTimeout;
+    }
+  }
+}
+
+}  // namespace thread
+}  // namespace foedus
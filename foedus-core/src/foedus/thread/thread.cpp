@@ -21,10 +21,12 @@
 
 #include <ostream>
 
+#include "foedus/assert_nd.hpp"
 #include "foedus/engine.hpp"
 #include "foedus/memory/engine_memory.hpp"
 #include "foedus/memory/numa_core_memory.hpp"
 #include "foedus/soc/soc_manager.hpp"
+#include "foedus/thread/coroutine_impl.hpp"
 #include "foedus/thread/thread_pimpl.hpp"
 
 namespace foedus {
@@ -72,8 +74,12 @@ void Thread::reset_snapshot_cache_counts() const {
   pimpl_->control_block_->stat_snapshot_cache_misses_ = 0;
 }
 
-xct::Xct&   Thread::get_current_xct()   { return pimpl_->current_xct_; }
-bool        Thread::is_running_xct()    const { return pimpl_->current_xct_.is_active(); }
+uint64_t Thread::get_migrated_volatile_pages() const {
+  return pimpl_->control_block_->stat_migrated_volatile_pages_;
+}
+
+xct::Xct&   Thread::get_current_xct()   { return *pimpl_->current_xct_; }
+bool        Thread::is_running_xct()    const { return pimpl_->current_xct_->is_active(); }
 
 log::ThreadLogBuffer& Thread::get_thread_log_buffer() { return pimpl_->log_buffer_; }
 
@@ -114,6 +120,14 @@ void Thread::collect_retired_volatile_page(storage::VolatilePagePointer ptr) {
   pimpl_->collect_retired_volatile_page(ptr);
 }
 
+void Thread::sample_remote_volatile_page(storage::StorageId storage_id, uint64_t page_key) {
+  pimpl_->sample_remote_volatile_page(storage_id, page_key);
+}
+
+ErrorCode Thread::migrate_sampled_volatile_pages() {
+  return pimpl_->migrate_sampled_volatile_pages();
+}
+
 
 std::ostream& operator<<(std::ostream& o, const Thread& v) {
   o << "Thread-" << v.get_thread_global_ordinal() << "(id=" << v.get_thread_id() << ") [";
@@ -139,8 +153,36 @@ storage::Page* Thread::resolve_newpage(memory::PagePoolOffset offset) const {
   return get_local_volatile_page_resolver().resolve_offset_newpage(offset);
 }
 
+ErrorStack Thread::run_coroutines(
+  proc::Proc proc,
+  uint16_t count,
+  const void* input,
+  uint32_t input_len) {
+  if (pimpl_->coroutine_scheduler_ == nullptr) {
+    return ERROR_STACK(kErrorCodeThrCoroutineDisabled);
+  }
+  return pimpl_->coroutine_scheduler_->run(proc, count, input, input_len);
+}
+
+bool Thread::is_in_coroutine() const {
+  return pimpl_->coroutine_scheduler_ && pimpl_->coroutine_scheduler_->is_in_coroutine();
+}
+
+uint16_t Thread::get_coroutine_ordinal() const {
+  ASSERT_ND(is_in_coroutine());
+  return pimpl_->coroutine_scheduler_->get_current_ordinal();
+}
+
+bool Thread::is_coroutine_yieldable() const {
+  return pimpl_->coroutine_scheduler_ && pimpl_->coroutine_scheduler_->is_yieldable();
+}
+
+bool Thread::yield_coroutine() {
+  return pimpl_->coroutine_scheduler_ && pimpl_->coroutine_scheduler_->yield();
+}
+
 bool Thread::is_hot_page(const storage::Page* page) const {
-  const uint16_t threshold = pimpl_->current_xct_.get_hot_threshold_for_this_xct();
+  const uint16_t threshold = pimpl_->current_xct_->get_hot_threshold_for_this_xct();
   return page->get_header().hotness_.value_ >= threshold;
 }
 
@@ -17,13 +17,19 @@
  */
 #include "foedus/thread/thread_group.hpp"
 
+#include <glog/logging.h>
+
 #include <ostream>
+#include <string>
 #include <vector>
 
 #include "foedus/engine.hpp"
 #include "foedus/engine_options.hpp"
 #include "foedus/error_stack_batch.hpp"
+#include "foedus/fs/filesystem.hpp"
+#include "foedus/fs/path.hpp"
 #include "foedus/memory/engine_memory.hpp"
+#include "foedus/soc/soc_options.hpp"
 #include "foedus/thread/thread.hpp"
 #include "foedus/thread/thread_options.hpp"
 
@@ -37,6 +43,23 @@ ThreadGroup::~ThreadGroup() {
 
 ErrorStack ThreadGroup::initialize_once() {
   node_memory_ = engine_->get_memory_manager()->get_local_memory();
+  // The ring must be ready before worker threads start checking it.
+  const soc::SocOptions& soc_options = engine_->get_options().soc_;
+  if (soc_options.client_ring_slots_ > 0) {
+    std::string meta_path = soc_options.convert_client_ring_path_pattern(group_id_);
+    fs::Path path(meta_path);
+    if (fs::exists(path)) {
+      LOG(WARNING) << "Removing a stale meta file of client request ring: " << meta_path;
+      fs::remove(path);
+    }
+    // Not hugepages. External processes might not be configured to attach them.
+    CHECK_ERROR(client_ring_memory_.alloc(
+      meta_path,
+      soc::ClientRing::calculate_memory_size(soc_options),
+      group_id_,
+      false));
+    client_ring_.initialize(client_ring_memory_.get_block(), soc_options);
+  }
   ThreadLocalOrdinal count = engine_->get_options().thread_.thread_count_per_group_;
   for (ThreadLocalOrdinal ordinal = 0; ordinal < count; ++ordinal) {
     ThreadId id = compose_thread_id(group_id_, ordinal);
@@ -50,6 +73,12 @@ ErrorStack ThreadGroup::initialize_once() {
 ErrorStack ThreadGroup::uninitialize_once() {
   ErrorStackBatch batch;
   batch.uninitialize_and_delete_all(&threads_);
+  client_ring_ = soc::ClientRing();
+  if (!client_ring_memory_.is_null()) {
+    // External processes still attaching it keep it alive until they detach.
+    client_ring_memory_.mark_for_release();
+    client_ring_memory_.release_block();
+  }
   node_memory_ = nullptr;
   return SUMMARIZE_ERROR_BATCH(batch);
 }
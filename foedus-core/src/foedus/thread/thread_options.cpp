@@ -45,6 +45,8 @@ ThreadOptions::ThreadOptions() {
   overwrite_thread_schedule_ = false;
   thread_policy_ = kScheduleFifo;
   thread_priority_ = kPriorityDefault;
+  coroutines_per_thread_ = 0;
+  coroutine_stack_kb_ = 1024;
 }
 
 ErrorStack ThreadOptions::load(tinyxml2::XMLElement* element) {
@@ -53,6 +55,8 @@ ErrorStack ThreadOptions::load(tinyxml2::XMLElement* element) {
   EXTERNALIZE_LOAD_ELEMENT(element, overwrite_thread_schedule_);
   EXTERNALIZE_LOAD_ENUM_ELEMENT(element, thread_policy_);
   EXTERNALIZE_LOAD_ENUM_ELEMENT(element, thread_priority_);
+  EXTERNALIZE_LOAD_ELEMENT(element, coroutines_per_thread_);
+  EXTERNALIZE_LOAD_ELEMENT(element, coroutine_stack_kb_);
   return kRetOk;
 }
 
@@ -73,6 +77,11 @@ ErrorStack ThreadOptions::save(tinyxml2::XMLElement* element) const {
   EXTERNALIZE_SAVE_ENUM_ELEMENT(element, thread_priority_,
     "Thread priority for worker threads. ignored if overwrite_thread_schedule_==false\n"
     "The values are compatible with pthread's values.");
+  EXTERNALIZE_SAVE_ELEMENT(element, coroutines_per_thread_,
+    "Max number of transaction coroutines each worker thread can multiplex.\n"
+    " 0 (default) disables the coroutine execution mode.");
+  EXTERNALIZE_SAVE_ELEMENT(element, coroutine_stack_kb_,
+    "Byte size (in KB) of the stack of each coroutine. ignored if coroutines_per_thread_==0.");
   return kRetOk;
 }
 
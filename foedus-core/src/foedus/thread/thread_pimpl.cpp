@@ -22,6 +22,7 @@
 #include <glog/logging.h>
 
 #include <atomic>
+#include <cstring>
 #include <future>
 #include <mutex>
 #include <thread>
@@ -38,10 +39,17 @@
 #include "foedus/memory/numa_node_memory.hpp"
 #include "foedus/proc/proc_id.hpp"
 #include "foedus/proc/proc_manager.hpp"
+#include "foedus/snapshot/snapshot_id.hpp"
+#include "foedus/snapshot/snapshot_manager.hpp"
+#include "foedus/soc/client_ring.hpp"
 #include "foedus/soc/shared_memory_repo.hpp"
 #include "foedus/soc/soc_manager.hpp"
+#include "foedus/storage/partitioner.hpp"
+#include "foedus/storage/storage_manager.hpp"
+#include "foedus/thread/coroutine_impl.hpp"
 #include "foedus/thread/numa_thread_scope.hpp"
 #include "foedus/thread/thread.hpp"
+#include "foedus/thread/thread_group.hpp"
 #include "foedus/thread/thread_pool.hpp"
 #include "foedus/thread/thread_pool_pimpl.hpp"
 #include "foedus/xct/sysxct_functor.hpp"
@@ -52,6 +60,9 @@
 
 namespace foedus {
 namespace thread {
+/** How long an idle thread sleeps on the doorbell of the client request ring at a time. */
+const uint64_t kClientRingIdleSliceUs = 1ULL << 13;
+
 ThreadPimpl::ThreadPimpl(
   Engine* engine,
   Thread* holder,
@@ -67,15 +78,19 @@ ThreadPimpl::ThreadPimpl(
     snapshot_cache_hashtable_(nullptr),
     snapshot_page_pool_(nullptr),
     log_buffer_(engine, id),
-    current_xct_(engine, holder, id),
+    default_xct_(engine, holder, id),
+    current_xct_(&default_xct_),
+    coroutine_scheduler_(nullptr),
     snapshot_file_set_(engine),
     control_block_(nullptr),
+    client_ring_(nullptr),
     task_input_memory_(nullptr),
     task_output_memory_(nullptr),
     mcs_ww_blocks_(nullptr),
     mcs_rw_simple_blocks_(nullptr),
     mcs_rw_extended_blocks_(nullptr),
     canonical_address_(nullptr) {
+  std::memset(migration_candidates_, 0, sizeof(migration_candidates_));
 }
 
 ErrorStack ThreadPimpl::initialize_once() {
@@ -104,15 +119,23 @@ ErrorStack ThreadPimpl::initialize_once() {
     snapshot_cache_hashtable_ = nullptr;
   }
   snapshot_page_pool_ = node_memory_->get_snapshot_pool();
-  current_xct_.initialize(
+  current_xct_ = &default_xct_;
+  default_xct_.initialize(
     core_memory_,
     &control_block_->mcs_block_current_,
     &control_block_->mcs_rw_async_mapping_current_);
   CHECK_ERROR(snapshot_file_set_.initialize());
   CHECK_ERROR(log_buffer_.initialize());
+  if (engine_->get_options().thread_.coroutines_per_thread_ > 0) {
+    coroutine_scheduler_ = new CoroutineScheduler(this);
+    CHECK_ERROR(coroutine_scheduler_->initialize());
+  }
   global_volatile_page_resolver_
     = engine_->get_memory_manager()->get_global_volatile_page_resolver();
   local_volatile_page_resolver_ = node_memory_->get_volatile_pool()->get_resolver();
+  soc::ClientRing* client_ring
+    = engine_->get_thread_pool()->get_pimpl()->get_local_group()->get_client_ring();
+  client_ring_ = client_ring->is_enabled() ? client_ring : nullptr;
 
   raw_thread_set_ = false;
   raw_thread_ = std::move(std::thread(&ThreadPimpl::handle_tasks, this));
@@ -123,7 +146,11 @@ ErrorStack ThreadPimpl::uninitialize_once() {
   ErrorStackBatch batch;
   {
     {
-      control_block_->status_ = kWaitingForTerminate;
+      {
+        // with mutex as the thread might be switching its status to serve client requests
+        soc::SharedMutexScope scope(&control_block_->task_mutex_);
+        control_block_->status_ = kWaitingForTerminate;
+      }
       control_block_->wakeup_cond_.signal();
     }
     LOG(INFO) << "Thread-" << id_ << " requested to terminate";
@@ -146,11 +173,17 @@ ErrorStack ThreadPimpl::uninitialize_once() {
       ASSERT_ND(chunk->empty());
     }
   }
+  if (coroutine_scheduler_) {
+    batch.emprace_back(coroutine_scheduler_->uninitialize());
+    delete coroutine_scheduler_;
+    coroutine_scheduler_ = nullptr;
+  }
   batch.emprace_back(snapshot_file_set_.uninitialize());
   batch.emprace_back(log_buffer_.uninitialize());
   core_memory_ = nullptr;
   node_memory_ = nullptr;
   snapshot_cache_hashtable_ = nullptr;
+  client_ring_ = nullptr;
   control_block_->uninitialize();
   return SUMMARIZE_ERROR_BATCH(batch);
 }
@@ -170,6 +203,11 @@ void ThreadPimpl::handle_tasks() {
   control_block_->status_ = kWaitingForTask;
   while (!is_stop_requested()) {
     assorted::spinlock_yield();
+    if (client_ring_
+      && control_block_->status_ == kWaitingForTask
+      && serve_client_requests() > 0) {
+      continue;  // more requests might be coming. don't sleep.
+    }
     {
       uint64_t demand = control_block_->wakeup_cond_.acquire_ticket();
       if (is_stop_requested()) {
@@ -179,7 +217,14 @@ void ThreadPimpl::handle_tasks() {
       if (control_block_->status_ == kWaitingForTask
         || control_block_->status_ == kWaitingForClientRelease) {
         VLOG(0) << "Thread-" << id_ << " sleeping...";
-        control_block_->wakeup_cond_.timedwait(demand, 100000ULL, 1U << 16, 1U << 13);
+        if (client_ring_ && control_block_->status_ == kWaitingForTask) {
+          // Clients ring the doorbell of the ring when they submit requests, but impersonation
+          // signals wakeup_cond_. We sleep on the former and check the latter periodically,
+          // as often as wakeup_cond_.timedwait() below would poll it at most.
+          client_ring_->wait_for_requests(kClientRingIdleSliceUs);
+        } else {
+          control_block_->wakeup_cond_.timedwait(demand, 100000ULL, 1U << 16, 1U << 13);
+        }
       }
     }
     VLOG(0) << "Thread-" << id_ << " woke up. status=" << control_block_->status_;
@@ -187,38 +232,17 @@ void ThreadPimpl::handle_tasks() {
       control_block_->output_len_ = 0;
       control_block_->status_ = kRunningTask;
 
-      // Reset the default value of enable_rll_for_this_xct etc to system-wide setting
-      // for every impersonation.
-      current_xct_.set_default_rll_for_this_xct(
-        engine_->get_options().xct_.enable_retrospective_lock_list_);
-      current_xct_.set_default_hot_threshold_for_this_xct(
-        engine_->get_options().storage_.hot_threshold_);
-      current_xct_.set_default_rll_threshold_for_this_xct(
-        engine_->get_options().xct_.hot_threshold_for_retrospective_lock_list_);
-
       const proc::ProcName& proc_name = control_block_->proc_name_;
       VLOG(0) << "Thread-" << id_ << " retrieved a task: " << proc_name;
-      proc::Proc proc = nullptr;
-      ErrorStack result = engine_->get_proc_manager()->get_proc(proc_name, &proc);
-      if (result.is_error()) {
-        // control_block_->proc_result_
-        LOG(ERROR) << "Thread-" << id_ << " couldn't find procedure: " << proc_name;
-      } else {
-        uint32_t output_used = 0;
-        proc::ProcArguments args = {
-          engine_,
-          holder_,
-          task_input_memory_,
-          control_block_->input_len_,
-          task_output_memory_,
-          soc::ThreadMemoryAnchors::kTaskOutputMemorySize,
-          &output_used,
-        };
-        result = proc(args);
-        VLOG(0) << "Thread-" << id_ << " run(task) returned. result =" << result
-          << ", output_used=" << output_used;
-        control_block_->output_len_ = output_used;
-      }
+      uint32_t output_used = 0;
+      ErrorStack result = run_proc(
+        proc_name,
+        task_input_memory_,
+        control_block_->input_len_,
+        task_output_memory_,
+        soc::ThreadMemoryAnchors::kTaskOutputMemorySize,
+        &output_used);
+      control_block_->output_len_ = output_used;
       if (result.is_error()) {
         control_block_->proc_result_.from_error_stack(result);
       } else {
@@ -236,6 +260,89 @@ void ThreadPimpl::handle_tasks() {
   control_block_->status_ = kTerminated;
   LOG(INFO) << "Thread-" << id_ << " exits";
 }
+ErrorStack ThreadPimpl::run_proc(
+  const proc::ProcName& proc_name,
+  const void* input,
+  uint32_t input_len,
+  void* output,
+  uint32_t output_size,
+  uint32_t* output_used) {
+  // Reset the default value of enable_rll_for_this_xct etc to system-wide setting
+  // for every impersonation.
+  current_xct_->set_default_rll_for_this_xct(
+    engine_->get_options().xct_.enable_retrospective_lock_list_);
+  current_xct_->set_default_hot_threshold_for_this_xct(
+    engine_->get_options().storage_.hot_threshold_);
+  current_xct_->set_default_rll_threshold_for_this_xct(
+    engine_->get_options().xct_.hot_threshold_for_retrospective_lock_list_);
+
+  *output_used = 0;
+  proc::Proc proc = nullptr;
+  ErrorStack result = engine_->get_proc_manager()->get_proc(proc_name, &proc);
+  if (result.is_error()) {
+    LOG(ERROR) << "Thread-" << id_ << " couldn't find procedure: " << proc_name;
+    return result;
+  }
+  proc::ProcArguments args = {
+    engine_,
+    holder_,
+    input,
+    input_len,
+    output,
+    output_size,
+    output_used,
+  };
+  result = proc(args);
+  VLOG(0) << "Thread-" << id_ << " run(task) returned. result =" << result
+    << ", output_used=" << *output_used;
+  return result;
+}
+
+uint32_t ThreadPimpl::serve_client_requests() {
+  ASSERT_ND(client_ring_);
+  // not just has_requests(), as dequeue() also skips slots that clients abandoned.
+  if (!client_ring_->has_pending_slots()) {
+    return 0;
+  }
+  {
+    soc::SharedMutexScope scope(&control_block_->task_mutex_);
+    if (control_block_->status_ != kWaitingForTask) {
+      return 0;  // someone has just impersonated this thread or requested termination
+    }
+    control_block_->status_ = kRunningTask;
+  }
+
+  const uint16_t batch_size = engine_->get_options().soc_.client_ring_batch_size_;
+  uint32_t served = 0;
+  soc::ClientRing::Ticket ticket;
+  while (served < batch_size && client_ring_->dequeue(&ticket)) {
+    uint32_t output_capacity;
+    void* output = client_ring_->get_output_buffer(ticket, &output_capacity);
+    uint32_t output_used = 0;
+    ErrorStack result = run_proc(
+      client_ring_->get_proc_name(ticket),
+      client_ring_->get_input(ticket),
+      client_ring_->get_input_len(ticket),
+      output,
+      output_capacity,
+      &output_used);
+    client_ring_->complete(ticket, result.get_error_code(), output_used);
+    ++served;
+  }
+  if (served > 0) {
+    client_ring_->signal_completion();
+    DVLOG(1) << "Thread-" << id_ << " served " << served << " client requests";
+  }
+
+  {
+    soc::SharedMutexScope scope(&control_block_->task_mutex_);
+    if (control_block_->status_ == kRunningTask) {
+      control_block_->status_ = kWaitingForTask;
+    }
+  }
+  return served;
+}
+
 void ThreadPimpl::set_thread_schedule() {
   // this code totally assumes pthread. maybe ifdef to handle Windows.. later!
   SPINLOCK_WHILE(raw_thread_set_ == false) {
@@ -418,6 +525,9 @@ ErrorCode ThreadPimpl::follow_page_pointer(
   const storage::Page* parent,
   uint16_t index_in_parent) {
   ASSERT_ND(!tolerate_null_pointer || !will_modify);
+  if (UNLIKELY(current_xct_->is_snapshot_only())) {
+    return follow_page_pointer_snapshot_only(tolerate_null_pointer, will_modify, pointer, page);
+  }
 
   storage::VolatilePagePointer volatile_pointer = pointer->volatile_pointer_;
   bool followed_snapshot = false;
@@ -473,9 +583,9 @@ ErrorCode ThreadPimpl::follow_page_pointer(
   ASSERT_ND((*page) == nullptr || (followed_snapshot == (*page)->get_header().snapshot_));
 
   // if we follow a snapshot pointer, remember pointer set
-  if (current_xct_.get_isolation_level() == xct::kSerializable) {
+  if (current_xct_->get_isolation_level() == xct::kSerializable) {
     if ((*page == nullptr || followed_snapshot) && take_ptr_set_snapshot) {
-      current_xct_.add_to_pointer_set(&pointer->volatile_pointer_, volatile_pointer);
+      current_xct_->add_to_pointer_set(&pointer->volatile_pointer_, volatile_pointer);
     }
   }
   return kErrorCodeOk;
@@ -496,13 +606,20 @@ ErrorCode ThreadPimpl::follow_page_pointers_for_read_batch(
     return kErrorCodeOk;
   } else if (UNLIKELY(batch_size > Thread::kMaxFindPagesBatch)) {
     return kErrorCodeInvalidParameter;
+  } else if (UNLIKELY(current_xct_->is_snapshot_only())) {
+    return follow_page_pointers_for_read_batch_snapshot_only(
+      batch_size,
+      tolerate_null_pointer,
+      pointers,
+      followed_snapshots,
+      out);
   }
 
   // this one uses a batched find method for following snapshot pages.
   // some of them might follow volatile pages, so we do it only when at least one snapshot ptr.
   bool has_some_snapshot = false;
   const bool needs_ptr_set
-    = take_ptr_set_snapshot && current_xct_.get_isolation_level() == xct::kSerializable;
+    = take_ptr_set_snapshot && current_xct_->get_isolation_level() == xct::kSerializable;
 
   // REMINDER: Remember that it might be parents == out. We thus use tmp_out.
   storage::Page* tmp_out[Thread::kMaxFindPagesBatch];
@@ -543,7 +660,7 @@ ErrorCode ThreadPimpl::follow_page_pointers_for_read_batch(
       } else if (tmp_out[b]) {
         // if we follow a snapshot pointer _from volatile page_, remember pointer set
         if (needs_ptr_set && !followed_snapshots[b]) {
-          current_xct_.add_to_pointer_set(&pointer->volatile_pointer_, pointer->volatile_pointer_);
+          current_xct_->add_to_pointer_set(&pointer->volatile_pointer_, pointer->volatile_pointer_);
         }
         followed_snapshots[b] = true;
         out[b] = tmp_out[b];
@@ -592,6 +709,86 @@ ErrorCode ThreadPimpl::follow_page_pointers_for_read_batch(
   return kErrorCodeOk;
 }
 
+ErrorCode ThreadPimpl::check_snapshot_only_pointer(
+  storage::SnapshotPagePointer snapshot_pointer) const {
+  ASSERT_ND(snapshot_pointer != 0);
+  const snapshot::SnapshotId pinned = current_xct_->get_snapshot_only_id();
+  const snapshot::SnapshotId id
+    = storage::extract_snapshot_id_from_snapshot_pointer(snapshot_pointer);
+  if (LIKELY(id == pinned)) {
+    return kErrorCodeOk;
+  }
+  // Pages in older snapshots are fine; they are unchanged as of the pinned snapshot.
+  // Pages in snapshots taken after the pin are not. Snapshot IDs wrap around, so we compare
+  // the distances from the pinned ID, which are small as snapshots are taken infrequently.
+  const snapshot::SnapshotId latest = engine_->get_snapshot_manager()->get_previous_snapshot_id();
+  const uint16_t id_distance = static_cast<uint16_t>(id - pinned);
+  const uint16_t latest_distance = static_cast<uint16_t>(latest - pinned);
+  if (UNLIKELY(id_distance <= latest_distance)) {
+    DVLOG(0) << "Snapshot-" << id << " replaced a page after we pinned snapshot-" << pinned;
+    return kErrorCodeXctSnapshotChanged;
+  }
+  return kErrorCodeOk;
+}
+
+ErrorCode ThreadPimpl::follow_page_pointer_snapshot_only(
+  bool tolerate_null_pointer,
+  bool will_modify,
+  const storage::DualPagePointer* pointer,
+  storage::Page** page) {
+  ASSERT_ND(current_xct_->is_snapshot_only());
+  if (UNLIKELY(will_modify)) {
+    return kErrorCodeXctSnapshotOnlyWrite;
+  }
+  const storage::SnapshotPagePointer snapshot_pointer = pointer->snapshot_pointer_;
+  if (snapshot_pointer == 0) {
+    // the page didn't exist as of the snapshot.
+    if (tolerate_null_pointer) {
+      *page = nullptr;
+      return kErrorCodeOk;
+    }
+    return kErrorCodeXctNoSnapshotPage;
+  }
+  CHECK_ERROR_CODE(check_snapshot_only_pointer(snapshot_pointer));
+  CHECK_ERROR_CODE(find_or_read_a_snapshot_page(snapshot_pointer, page));
+  ASSERT_ND((*page)->get_header().snapshot_);
+  return kErrorCodeOk;
+}
+
+ErrorCode ThreadPimpl::follow_page_pointers_for_read_batch_snapshot_only(
+  uint16_t batch_size,
+  bool tolerate_null_pointer,
+  storage::DualPagePointer** pointers,
+  bool* followed_snapshots,
+  storage::Page** out) {
+  ASSERT_ND(current_xct_->is_snapshot_only());
+  ASSERT_ND(batch_size <= Thread::kMaxFindPagesBatch);
+  storage::SnapshotPagePointer snapshot_page_ids[Thread::kMaxFindPagesBatch];
+  for (uint16_t b = 0; b < batch_size; ++b) {
+    snapshot_page_ids[b] = 0;
+    const storage::DualPagePointer* pointer = pointers[b];
+    if (pointer == nullptr) {
+      continue;
+    }
+    const storage::SnapshotPagePointer snapshot_pointer = pointer->snapshot_pointer_;
+    if (snapshot_pointer == 0) {
+      if (!tolerate_null_pointer) {
+        return kErrorCodeXctNoSnapshotPage;
+      }
+      continue;
+    }
+    CHECK_ERROR_CODE(check_snapshot_only_pointer(snapshot_pointer));
+    snapshot_page_ids[b] = snapshot_pointer;
+  }
+
+  // unlike the usual case, we don't read parents, so it's fine even if parents == out.
+  CHECK_ERROR_CODE(find_or_read_snapshot_pages_batch(batch_size, snapshot_page_ids, out));
+  for (uint16_t b = 0; b < batch_size; ++b) {
+    followed_snapshots[b] = true;
+  }
+  return kErrorCodeOk;
+}
+
 ErrorCode ThreadPimpl::follow_page_pointers_for_write_batch(
   uint16_t batch_size,
   storage::VolatilePageInit page_initializer,
@@ -661,6 +858,7 @@ ErrorCode ThreadPimpl::find_or_read_a_snapshot_page(
       ASSERT_ND(offset != 0);
       CHECK_ERROR_CODE(snapshot_cache_hashtable_->install(page_id, offset));
       ++control_block_->stat_snapshot_cache_misses_;
+      sample_snapshot_cache_miss(snapshot_page_pool_->get_base() + offset);
     } else {
       ++control_block_->stat_snapshot_cache_hits_;
     }
@@ -670,7 +868,7 @@ ErrorCode ThreadPimpl::find_or_read_a_snapshot_page(
     ASSERT_ND(!engine_->get_options().cache_.snapshot_cache_enabled_);
     // Snapshot is disabled. So far this happens only in performance experiments.
     // We use local work memory in this case.
-    CHECK_ERROR_CODE(current_xct_.acquire_local_work_memory(
+    CHECK_ERROR_CODE(current_xct_->acquire_local_work_memory(
       storage::kPageSize,
       reinterpret_cast<void**>(out),
       storage::kPageSize));
@@ -699,6 +897,7 @@ ErrorCode ThreadPimpl::find_or_read_snapshot_pages_batch(
     ASSERT_ND(engine_->get_options().cache_.snapshot_cache_enabled_);
     memory::PagePoolOffset offsets[Thread::kMaxFindPagesBatch];
     CHECK_ERROR_CODE(snapshot_cache_hashtable_->find_batch(batch_size, page_ids, offsets));
+    storage::Page* const pool_base = snapshot_page_pool_->get_base();
     for (uint16_t b = 0; b < batch_size; ++b) {
       memory::PagePoolOffset offset = offsets[b];
       storage::SnapshotPagePointer page_id = page_ids[b];
@@ -710,24 +909,50 @@ ErrorCode ThreadPimpl::find_or_read_snapshot_pages_batch(
         out[b] = out[b - 1];
         continue;
       }
-      if (offset == 0 || snapshot_page_pool_->get_base()[offset].get_header().page_id_ != page_id) {
+      if (offset == 0 || pool_base[offset].get_header().page_id_ != page_id) {
         if (offset != 0) {
           DVLOG(0) << "Interesting, this race is rare, but possible. offset=" << offset;
         }
+        // Scans often miss consecutive pages. If so, read all of them in one sequential I/O.
+        uint16_t run = 1;
+        while (b + run < batch_size
+          && page_ids[b + run] == page_id + run
+          && (offsets[b + run] == 0
+            || pool_base[offsets[b + run]].get_header().page_id_ != page_id + run)) {
+          ++run;
+        }
+        if (run > 1U) {
+          memory::PagePoolOffset new_offsets[Thread::kMaxFindPagesBatch];
+          CHECK_ERROR_CODE(on_snapshot_cache_miss_contiguous(page_id, run, new_offsets));
+          for (uint16_t i = 0; i < run; ++i) {
+            ASSERT_ND(new_offsets[i] != 0);
+            CHECK_ERROR_CODE(snapshot_cache_hashtable_->install(page_id + i, new_offsets[i]));
+            out[b + i] = pool_base + new_offsets[i];
+            ++control_block_->stat_snapshot_cache_misses_;
+            sample_snapshot_cache_miss(out[b + i]);
+          }
+          b += run - 1U;
+          continue;
+        }
         CHECK_ERROR_CODE(on_snapshot_cache_miss(page_id, &offset));
         ASSERT_ND(offset != 0);
         CHECK_ERROR_CODE(snapshot_cache_hashtable_->install(page_id, offset));
         ++control_block_->stat_snapshot_cache_misses_;
+        sample_snapshot_cache_miss(pool_base + offset);
       } else {
         ++control_block_->stat_snapshot_cache_hits_;
       }
       ASSERT_ND(offset != 0);
-      out[b] = snapshot_page_pool_->get_base() + offset;
+      out[b] = pool_base + offset;
     }
   } else {
     ASSERT_ND(!engine_->get_options().cache_.snapshot_cache_enabled_);
     for (uint16_t b = 0; b < batch_size; ++b) {
-      CHECK_ERROR_CODE(current_xct_.acquire_local_work_memory(
+      if (page_ids[b] == 0) {
+        out[b] = nullptr;
+        continue;
+      }
+      CHECK_ERROR_CODE(current_xct_->acquire_local_work_memory(
         storage::kPageSize,
         reinterpret_cast<void**>(out + b),
         storage::kPageSize));
@@ -752,7 +977,13 @@ ErrorCode ThreadPimpl::on_snapshot_cache_miss(
   }
 
   storage::Page* new_page = snapshot_page_pool_->get_base() + offset;
-  ErrorCode read_result = read_a_snapshot_page(page_id, new_page);
+  ErrorCode read_result;
+  if (coroutine_scheduler_ && coroutine_scheduler_->is_yieldable()) {
+    // let other coroutines run while we wait for the I/O
+    read_result = coroutine_scheduler_->read_a_snapshot_page(page_id, new_page);
+  } else {
+    read_result = read_a_snapshot_page(page_id, new_page);
+  }
   if (read_result != kErrorCodeOk) {
     LOG(ERROR) << "Failed to read a snapshot page. thread=" << *holder_
       << ", page_id=" << assorted::Hex(page_id);
@@ -764,6 +995,107 @@ ErrorCode ThreadPimpl::on_snapshot_cache_miss(
   return kErrorCodeOk;
 }
 
+void ThreadPimpl::sample_snapshot_cache_miss(const storage::Page* page) {
+  const uint32_t interval = engine_->get_options().storage_.partitioner_access_sample_interval_;
+  if (interval != 0 && control_block_->stat_snapshot_cache_misses_ % interval == 0) {
+    storage::Partitioner::sample_access(engine_, page, numa_node_);
+  }
+}
+
+void ThreadPimpl::sample_remote_volatile_page(storage::StorageId storage_id, uint64_t page_key) {
+  const uint32_t interval
+    = engine_->get_options().storage_.volatile_page_migration_sample_interval_;
+  if (interval == 0 || ++control_block_->stat_remote_volatile_page_accesses_ % interval != 0) {
+    return;
+  }
+  // Find the page in the candidates. Otherwise, replace the least sampled one.
+  VolatilePageMigrationCandidate* victim = migration_candidates_;
+  for (uint16_t i = 0; i < kMaxMigrationCandidates; ++i) {
+    VolatilePageMigrationCandidate* candidate = migration_candidates_ + i;
+    if (candidate->samples_ > 0
+      && candidate->storage_id_ == storage_id
+      && candidate->page_key_ == page_key) {
+      ++candidate->samples_;
+      return;
+    } else if (candidate->samples_ < victim->samples_) {
+      victim = candidate;
+    }
+  }
+  victim->storage_id_ = storage_id;
+  victim->samples_ = 1;
+  victim->page_key_ = page_key;
+}
+
+ErrorCode ThreadPimpl::migrate_sampled_volatile_pages() {
+  ASSERT_ND(!current_xct_->is_active());
+  const uint32_t min_samples = engine_->get_options().storage_.volatile_page_migration_min_samples_;
+  storage::StorageManager* storage_manager = engine_->get_storage_manager();
+  for (uint16_t i = 0; i < kMaxMigrationCandidates; ++i) {
+    VolatilePageMigrationCandidate* candidate = migration_candidates_ + i;
+    if (candidate->samples_ == 0 || candidate->samples_ < min_samples) {
+      continue;
+    }
+    bool migrated = false;
+    ErrorCode ret = storage_manager->migrate_volatile_page(
+      holder_,
+      candidate->storage_id_,
+      candidate->page_key_,
+      &migrated);
+    candidate->samples_ = 0;
+    if (ret != kErrorCodeOk) {
+      // eg no free pages in this node. We will sample it again if it's really hot.
+      DLOG(INFO) << "Failed to migrate a volatile page. thread=" << *holder_
+        << ", storage_id=" << candidate->storage_id_ << ", err=" << get_error_name(ret);
+      return ret;
+    } else if (migrated) {
+      ++control_block_->stat_migrated_volatile_pages_;
+    }
+  }
+  return kErrorCodeOk;
+}
+
+ErrorCode ThreadPimpl::on_snapshot_cache_miss_contiguous(
+  storage::SnapshotPagePointer page_id_begin,
+  uint16_t page_count,
+  memory::PagePoolOffset* pool_offsets) {
+  ASSERT_ND(page_count <= Thread::kMaxFindPagesBatch);
+  if (coroutine_scheduler_ && coroutine_scheduler_->is_yieldable()) {
+    // asynchronous I/O per page is better as other coroutines run while we wait.
+    for (uint16_t i = 0; i < page_count; ++i) {
+      CHECK_ERROR_CODE(on_snapshot_cache_miss(page_id_begin + i, pool_offsets + i));
+    }
+    return kErrorCodeOk;
+  }
+
+  void* buffers[Thread::kMaxFindPagesBatch];
+  for (uint16_t i = 0; i < page_count; ++i) {
+    pool_offsets[i] = core_memory_->grab_free_snapshot_page();
+    if (pool_offsets[i] == 0) {
+      LOG(ERROR) << "Could not grab free snapshot page while cache miss. thread=" << *holder_
+        << ", page_id=" << assorted::Hex(page_id_begin + i);
+      for (uint16_t j = 0; j < i; ++j) {
+        core_memory_->release_free_snapshot_page(pool_offsets[j]);
+      }
+      return kErrorCodeCacheNoFreePages;
+    }
+    buffers[i] = snapshot_page_pool_->get_base() + pool_offsets[i];
+  }
+
+  ErrorCode read_result = snapshot_file_set_.read_pages_scattered(
+    page_id_begin,
+    page_count,
+    buffers);
+  if (read_result != kErrorCodeOk) {
+    LOG(ERROR) << "Failed to read snapshot pages. thread=" << *holder_
+      << ", page_id_begin=" << assorted::Hex(page_id_begin) << ", page_count=" << page_count;
+    for (uint16_t i = 0; i < page_count; ++i) {
+      core_memory_->release_free_snapshot_page(pool_offsets[i]);
+    }
+    return read_result;
+  }
+  return kErrorCodeOk;
+}
+
 ThreadRef ThreadPimpl::get_thread_ref(ThreadId id) {
   auto* pool_pimpl = engine_->get_thread_pool()->get_pimpl();
   return pool_pimpl->get_thread_ref(id);
@@ -874,7 +1206,7 @@ xct::McsImpl< ThreadPimplMcsAdaptor< RW_BLOCK >, RW_BLOCK > get_mcs_impl(ThreadP
 /// but not much. Doesn't matter.
 
 void ThreadPimpl::cll_release_all_locks_after(xct::UniversalLockId address) {
-  xct::CurrentLockList* cll = current_xct_.get_current_lock_list();
+  xct::CurrentLockList* cll = current_xct_->get_current_lock_list();
   if (is_simple_mcs_rw()) {
     auto impl(get_mcs_impl<xct::McsRwSimpleBlock>(this));
     cll->release_all_after(address, &impl);
@@ -885,7 +1217,7 @@ void ThreadPimpl::cll_release_all_locks_after(xct::UniversalLockId address) {
 }
 
 void ThreadPimpl::cll_giveup_all_locks_after(xct::UniversalLockId address) {
-  xct::CurrentLockList* cll = current_xct_.get_current_lock_list();
+  xct::CurrentLockList* cll = current_xct_->get_current_lock_list();
   if (is_simple_mcs_rw()) {
     auto impl(get_mcs_impl<xct::McsRwSimpleBlock>(this));
     cll->giveup_all_after(address, &impl);
@@ -896,7 +1228,16 @@ void ThreadPimpl::cll_giveup_all_locks_after(xct::UniversalLockId address) {
 }
 
 ErrorCode ThreadPimpl::cll_try_or_acquire_single_lock(xct::LockListPosition pos) {
-  xct::CurrentLockList* cll = current_xct_.get_current_lock_list();
+  xct::CurrentLockList* cll = current_xct_->get_current_lock_list();
+  if (coroutine_scheduler_ && coroutine_scheduler_->is_yieldable()) {
+    // This is the first lock of the coroutine. Rather than spinning in the MCS queue,
+    // let other coroutines run while someone else holds it. We never enqueue ourselves
+    // before yielding because the MCS blocks are shared by all coroutines of this thread.
+    xct::RwLockableXctId* lock = cll->get_entry(pos)->lock_;
+    while (lock->is_keylocked() && coroutine_scheduler_->yield()) {
+      continue;
+    }
+  }
   if (is_simple_mcs_rw()) {
     auto impl(get_mcs_impl<xct::McsRwSimpleBlock>(this));
     return cll->try_or_acquire_single_lock(pos, &impl);
@@ -907,7 +1248,7 @@ ErrorCode ThreadPimpl::cll_try_or_acquire_single_lock(xct::LockListPosition pos)
 }
 
 ErrorCode ThreadPimpl::cll_try_or_acquire_multiple_locks(xct::LockListPosition upto_pos) {
-  xct::CurrentLockList* cll = current_xct_.get_current_lock_list();
+  xct::CurrentLockList* cll = current_xct_->get_current_lock_list();
   if (is_simple_mcs_rw()) {
     auto impl(get_mcs_impl<xct::McsRwSimpleBlock>(this));
     return cll->try_or_acquire_multiple_locks(upto_pos, &impl);
@@ -917,7 +1258,7 @@ ErrorCode ThreadPimpl::cll_try_or_acquire_multiple_locks(xct::LockListPosition u
   }
 }
 void ThreadPimpl::cll_release_all_locks() {
-  xct::CurrentLockList* cll = current_xct_.get_current_lock_list();
+  xct::CurrentLockList* cll = current_xct_->get_current_lock_list();
   if (is_simple_mcs_rw()) {
     auto impl(get_mcs_impl<xct::McsRwSimpleBlock>(this));
     return cll->release_all_locks(&impl);
@@ -928,7 +1269,7 @@ void ThreadPimpl::cll_release_all_locks() {
 }
 
 xct::UniversalLockId ThreadPimpl::cll_get_max_locked_id() const {
-  const xct::CurrentLockList* cll = current_xct_.get_current_lock_list();
+  const xct::CurrentLockList* cll = current_xct_->get_current_lock_list();
   return cll->get_max_locked_id();
 }
 
@@ -980,7 +1321,7 @@ ErrorCode Thread::sysxct_batch_page_locks(
 ErrorCode ThreadPimpl::run_nested_sysxct(
   xct::SysxctFunctor* functor,
   uint32_t max_retries) {
-  xct::SysxctWorkspace* workspace = current_xct_.get_sysxct_workspace();
+  xct::SysxctWorkspace* workspace = current_xct_->get_sysxct_workspace();
   xct::UniversalLockId enclosing_max_lock_id = cll_get_max_locked_id();
   ThreadPimplCllReleaseAllFunctor release_functor(this);
   if (is_simple_mcs_rw()) {
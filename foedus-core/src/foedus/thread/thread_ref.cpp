@@ -129,6 +129,10 @@ void ThreadRef::reset_snapshot_cache_counts() const {
   control_block_->stat_snapshot_cache_misses_ = 0;
 }
 
+uint64_t ThreadRef::get_migrated_volatile_pages() const {
+  return control_block_->stat_migrated_volatile_pages_;
+}
+
 Epoch ThreadGroupRef::get_min_in_commit_epoch() const {
   assorted::memory_fence_acquire();
   Epoch ret = INVALID_EPOCH;
@@ -0,0 +1,230 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include "foedus/xct/version_store_impl.hpp"
+
+#include <glog/logging.h>
+
+#include <cstring>
+
+#include "foedus/assert_nd.hpp"
+#include "foedus/assorted/assorted_func.hpp"
+#include "foedus/assorted/atomic_fences.hpp"
+#include "foedus/engine_options.hpp"
+
+namespace foedus {
+namespace xct {
+
+static_assert(sizeof(RecordVersion) == RecordVersion::kSlotSize, "RecordVersion size mismatch");
+static_assert(sizeof(VersionArena) == sizeof(uint64_t) * 4U, "VersionArena size mismatch");
+
+namespace {
+uint64_t align_4kb(uint64_t value) { return assorted::align< uint64_t, (1U << 12) >(value); }
+
+uint32_t calculate_slots_per_thread(const XctOptions& options) {
+  return (static_cast<uint64_t>(options.version_arena_size_kb_) << 10) / RecordVersion::kSlotSize;
+}
+
+/** Power of two that is at least as large as the total number of slots. */
+uint32_t calculate_bucket_count(uint64_t total_slots) {
+  uint32_t buckets = 1U << 10;
+  while (buckets < total_slots && buckets < (1U << 31)) {
+    buckets <<= 1;
+  }
+  return buckets;
+}
+
+inline VersionStore::Pointer to_pointer(uint32_t generation, uint32_t slot_index) {
+  return (static_cast<uint64_t>(generation) << 32) | slot_index;
+}
+inline uint32_t to_generation(VersionStore::Pointer pointer) {
+  return static_cast<uint32_t>(pointer >> 32);
+}
+inline uint32_t to_slot_index(VersionStore::Pointer pointer) {
+  return static_cast<uint32_t>(pointer);
+}
+}  // namespace
+
+VersionStore::VersionStore()
+  : arenas_(nullptr),
+    buckets_(nullptr),
+    slots_(nullptr),
+    bucket_mask_(0),
+    thread_count_(0),
+    slots_per_thread_(0),
+    max_chain_length_(0) {
+}
+
+uint64_t VersionStore::calculate_memory_size(const EngineOptions& options) {
+  const uint32_t slots_per_thread = calculate_slots_per_thread(options.xct_);
+  if (slots_per_thread == 0) {
+    return 0;
+  }
+  const uint64_t threads = options.thread_.get_total_thread_count();
+  const uint64_t total_slots = threads * slots_per_thread;
+  uint64_t total = 0;
+  total += align_4kb(sizeof(VersionArena) * threads);
+  total += align_4kb(sizeof(Pointer) * calculate_bucket_count(total_slots));
+  total += total_slots * RecordVersion::kSlotSize;
+  return total;
+}
+
+void VersionStore::attach(void* memory, const EngineOptions& options, bool initialize) {
+  const uint32_t slots_per_thread = calculate_slots_per_thread(options.xct_);
+  if (slots_per_thread == 0) {
+    return;
+  }
+  ASSERT_ND(memory);
+  const uint64_t threads = options.thread_.get_total_thread_count();
+  const uint64_t total_slots = threads * slots_per_thread;
+  const uint32_t bucket_count = calculate_bucket_count(total_slots);
+  char* base = reinterpret_cast<char*>(memory);
+  arenas_ = reinterpret_cast<VersionArena*>(base);
+  base += align_4kb(sizeof(VersionArena) * threads);
+  buckets_ = reinterpret_cast< std::atomic<Pointer>* >(base);
+  base += align_4kb(sizeof(Pointer) * bucket_count);
+  slots_ = reinterpret_cast<RecordVersion*>(base);
+  bucket_mask_ = bucket_count - 1U;
+  thread_count_ = threads;
+  slots_per_thread_ = slots_per_thread;
+  max_chain_length_ = options.xct_.max_version_chain_length_;
+  if (initialize) {
+    LOG(INFO) << "Initializing version store. " << total_slots << " slots, "
+      << bucket_count << " buckets";
+    std::memset(memory, 0, calculate_memory_size(options));
+  }
+}
+
+bool VersionStore::retain(
+  thread::ThreadGlobalOrdinal thread_ordinal,
+  storage::StorageId storage_id,
+  uint64_t key,
+  XctId xct_id,
+  Epoch superseded_epoch,
+  const void* payload,
+  uint16_t payload_count,
+  Epoch durable_epoch) {
+  ASSERT_ND(is_enabled());
+  ASSERT_ND(xct_id.get_epoch() < superseded_epoch);
+  // Only this thread modifies its arena and its slots.
+  VersionArena* arena = arenas_ + thread_ordinal;
+  if (payload_count > RecordVersion::kPayloadCapacity) {
+    ++arena->dropped_large_count_;
+    return false;
+  }
+
+  const uint64_t cursor = arena->cursor_;
+  const uint32_t slot_index = thread_ordinal * slots_per_thread_ + cursor;
+  RecordVersion* version = slots_ + slot_index;
+  const uint32_t old_generation = version->generation_.load(std::memory_order_relaxed);
+  ASSERT_ND(old_generation % 2U == 0);
+  if (old_generation != 0 && Epoch(version->superseded_epoch_) > durable_epoch) {
+    // A reader as of the durable epoch might still need the version in this slot.
+    // Rather drop the new version. A reader that needs it will get a retryable error.
+    ++arena->dropped_in_use_count_;
+    return false;
+  }
+
+  uint32_t new_generation = old_generation + 2U;
+  if (new_generation == 0) {
+    new_generation = 2U;  // skip 0 so that a pointer never becomes kNullPointer
+  }
+  version->generation_.store(old_generation + 1U, std::memory_order_relaxed);
+  assorted::memory_fence_release();
+  version->storage_id_ = storage_id;
+  version->key_ = key;
+  version->xct_id_ = xct_id;
+  version->xct_id_.clear_status_bits();
+  version->superseded_epoch_ = superseded_epoch.value();
+  version->payload_count_ = payload_count;
+  std::memcpy(version->payload_, payload, payload_count);
+  version->generation_.store(new_generation, std::memory_order_release);
+  arena->cursor_ = (cursor + 1U) % slots_per_thread_;
+  ++arena->retained_count_;
+
+  // Nobody can reach the slot with new_generation until the CAS below succeeds,
+  // so we can keep updating older_ in the loop.
+  std::atomic<Pointer>* bucket = buckets_ + to_bucket(storage_id, key);
+  const Pointer pointer = to_pointer(new_generation, slot_index);
+  Pointer head = bucket->load(std::memory_order_acquire);
+  while (true) {
+    version->older_ = head;
+    if (bucket->compare_exchange_weak(head, pointer, std::memory_order_acq_rel)) {
+      break;
+    }
+  }
+  return true;
+}
+
+VersionStoreStat VersionStore::get_stat() const {
+  VersionStoreStat stat;
+  stat.retained_count_ = 0;
+  stat.dropped_large_count_ = 0;
+  stat.dropped_in_use_count_ = 0;
+  for (uint32_t i = 0; i < thread_count_; ++i) {
+    stat.retained_count_ += arenas_[i].retained_count_;
+    stat.dropped_large_count_ += arenas_[i].dropped_large_count_;
+    stat.dropped_in_use_count_ += arenas_[i].dropped_in_use_count_;
+  }
+  return stat;
+}
+
+ErrorCode VersionStore::read(
+  storage::StorageId storage_id,
+  uint64_t key,
+  Epoch as_of,
+  void* payload,
+  uint16_t payload_offset,
+  uint16_t payload_count) const {
+  ASSERT_ND(is_enabled());
+  ASSERT_ND(as_of.is_valid());
+  Pointer pointer = buckets_[to_bucket(storage_id, key)].load(std::memory_order_acquire);
+  for (uint16_t hops = 0; hops < max_chain_length_ && pointer != kNullPointer; ++hops) {
+    const RecordVersion* version = slots_ + to_slot_index(pointer);
+    const uint32_t generation = version->generation_.load(std::memory_order_acquire);
+    if (generation != to_generation(pointer)) {
+      // recycled or being recycled. older ones are not reachable any more.
+      break;
+    }
+    const bool same_record = version->storage_id_ == storage_id && version->key_ == key;
+    const Epoch epoch = version->xct_id_.get_epoch();
+    const Epoch superseded_epoch(version->superseded_epoch_);
+    const Pointer older = version->older_;
+    const bool matched = same_record && epoch <= as_of && as_of < superseded_epoch;
+    if (matched) {
+      ASSERT_ND(payload_offset + payload_count <= version->payload_count_);
+      std::memcpy(payload, version->payload_ + payload_offset, payload_count);
+    }
+    assorted::memory_fence_acquire();
+    if (version->generation_.load(std::memory_order_relaxed) != generation) {
+      break;
+    }
+    if (matched) {
+      return kErrorCodeOk;
+    } else if (same_record && superseded_epoch <= as_of) {
+      // Versions of a record are pushed in the order of epochs. Older ones don't match either.
+      break;
+    }
+    pointer = older;
+  }
+  DVLOG(1) << "Version of record " << storage_id << ":" << key << " as of " << as_of
+    << " is not available";
+  return kErrorCodeXctVersionUnavailable;
+}
+
+}  // namespace xct
+}  // namespace foedus
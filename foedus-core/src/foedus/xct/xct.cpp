@@ -19,12 +19,14 @@
 
 #include <glog/logging.h>
 
+#include <algorithm>
 #include <cstring>
 #include <ostream>
 
 #include "foedus/engine.hpp"
 #include "foedus/engine_options.hpp"
 #include "foedus/assorted/atomic_fences.hpp"
+#include "foedus/memory/aligned_memory.hpp"
 #include "foedus/memory/engine_memory.hpp"
 #include "foedus/memory/numa_core_memory.hpp"
 #include "foedus/savepoint/savepoint.hpp"
@@ -38,6 +40,50 @@
 
 namespace foedus {
 namespace xct {
+
+namespace {
+bool is_delta_log(const log::RecordLogType* log_entry) {
+  const log::LogCode type = log_entry->header_.get_type();
+  return type == log::kLogCodeMasstreeDelta || type == log::kLogCodeHashDelta;
+}
+
+/**
+ * Whether another write of the same record might leave the record unable to take the delta.
+ * Precommit checks a delta only against the record before any write of this transaction is
+ * applied, so it can't see a delete or a shrinking update of this transaction.
+ * We reject both orders for simplicity.
+ */
+bool might_not_fit_delta(const log::RecordLogType* delta, const log::RecordLogType* other) {
+  uint32_t required_length;
+  if (delta->header_.get_type() == log::kLogCodeMasstreeDelta) {
+    const auto* casted = reinterpret_cast<const storage::masstree::MasstreeDeltaLogType*>(delta);
+    required_length = casted->payload_offset_ + casted->payload_count_;
+  } else {
+    ASSERT_ND(delta->header_.get_type() == log::kLogCodeHashDelta);
+    const auto* casted = reinterpret_cast<const storage::hash::HashDeltaLogType*>(delta);
+    required_length = casted->payload_offset_ + casted->payload_count_;
+  }
+
+  switch (other->header_.get_type()) {
+  case log::kLogCodeMasstreeDelete:
+  case log::kLogCodeHashDelete:
+    return true;
+  case log::kLogCodeMasstreeInsert:
+  case log::kLogCodeMasstreeUpdate: {
+    // These set the payload length to payload_count_
+    const auto* casted = reinterpret_cast<const storage::masstree::MasstreeCommonLogType*>(other);
+    return casted->payload_count_ < required_length;
+  }
+  case log::kLogCodeHashInsert:
+  case log::kLogCodeHashUpdate: {
+    const auto* casted = reinterpret_cast<const storage::hash::HashCommonLogType*>(other);
+    return casted->payload_count_ < required_length;
+  }
+  default:
+    return false;
+  }
+}
+}  // namespace
 Xct::Xct(Engine* engine, thread::Thread* context, thread::ThreadId thread_id)
   : engine_(engine), context_(context), thread_id_(thread_id) {
   id_ = XctId();
@@ -55,34 +101,70 @@ Xct::Xct(Engine* engine, thread::Thread* context, thread::ThreadId thread_id)
   read_set_ = nullptr;
   read_set_size_ = 0;
   max_read_set_size_ = 0;
+  resident_read_set_size_ = 0;
   write_set_ = nullptr;
   write_set_size_ = 0;
   max_write_set_size_ = 0;
+  resident_write_set_size_ = 0;
+  delta_write_count_ = 0;
   lock_free_read_set_ = nullptr;
   lock_free_read_set_size_ = 0;
   max_lock_free_read_set_size_ = 0;
+  resident_lock_free_read_set_size_ = 0;
   lock_free_write_set_ = nullptr;
   lock_free_write_set_size_ = 0;
   max_lock_free_write_set_size_ = 0;
+  resident_lock_free_write_set_size_ = 0;
+  resident_lock_list_capacity_ = 0;
+  retrospective_lock_list_spilled_ = false;
   pointer_set_size_ = 0;
   page_version_set_size_ = 0;
   isolation_level_ = kSerializable;
+  snapshot_only_id_ = snapshot::kNullSnapshotId;
+  multi_version_epoch_ = INVALID_EPOCH;
   mcs_block_current_ = nullptr;
   mcs_rw_async_mapping_current_ = nullptr;
   local_work_memory_ = nullptr;
   local_work_memory_size_ = 0;
   local_work_memory_cur_ = 0;
+  resident_local_work_memory_size_ = 0;
 }
 
 void Xct::initialize(
   memory::NumaCoreMemory* core_memory,
   uint32_t* mcs_block_current,
   uint32_t* mcs_rw_async_mapping_current) {
+  memory::NumaCoreMemory:: SmallThreadLocalMemoryPieces small_pieces
+    = core_memory->get_small_thread_local_memory_pieces();
+  MemoryPieces pieces;
+  pieces.sysxct_workspace_
+    = reinterpret_cast<SysxctWorkspace*>(small_pieces.sysxct_workspace_memory_);
+  pieces.pointer_set_ = reinterpret_cast<PointerAccess*>(small_pieces.xct_pointer_access_memory_);
+  pieces.page_version_set_
+    = reinterpret_cast<PageVersionAccess*>(small_pieces.xct_page_version_memory_);
+  pieces.read_set_ = reinterpret_cast<ReadXctAccess*>(small_pieces.xct_read_access_memory_);
+  pieces.write_set_ = reinterpret_cast<WriteXctAccess*>(small_pieces.xct_write_access_memory_);
+  pieces.lock_free_read_set_ = reinterpret_cast<LockFreeReadXctAccess*>(
+    small_pieces.xct_lock_free_read_access_memory_);
+  pieces.lock_free_write_set_ = reinterpret_cast<LockFreeWriteXctAccess*>(
+    small_pieces.xct_lock_free_write_access_memory_);
+  pieces.current_lock_list_ = core_memory->get_current_lock_list_memory();
+  pieces.current_lock_list_capacity_ = core_memory->get_current_lock_list_capacity();
+  pieces.retrospective_lock_list_ = core_memory->get_retrospective_lock_list_memory();
+  pieces.retrospective_lock_list_capacity_ = core_memory->get_retrospective_lock_list_capacity();
+  pieces.local_work_memory_ = core_memory->get_local_work_memory();
+  pieces.local_work_memory_size_ = core_memory->get_local_work_memory_size();
+  pieces.growth_factor_ = engine_->get_options().xct_.work_memory_growth_factor_;
+  initialize(pieces, mcs_block_current, mcs_rw_async_mapping_current);
+}
+
+void Xct::initialize(
+  const MemoryPieces& pieces,
+  uint32_t* mcs_block_current,
+  uint32_t* mcs_rw_async_mapping_current) {
   id_.set_epoch(engine_->get_savepoint_manager()->get_initial_current_epoch());
   id_.set_ordinal(0);  // ordinal 0 is possible only as a dummy "latest" XctId
   ASSERT_ND(id_.is_valid());
-  memory::NumaCoreMemory:: SmallThreadLocalMemoryPieces pieces
-    = core_memory->get_small_thread_local_memory_pieces();
   const XctOptions& xct_opt = engine_->get_options().xct_;
 
   default_rll_for_this_xct_ = xct_opt.enable_retrospective_lock_list_;
@@ -92,45 +174,105 @@ void Xct::initialize(
   default_rll_threshold_for_this_xct_ = xct_opt.hot_threshold_for_retrospective_lock_list_;
   rll_threshold_for_this_xct_ = default_rll_threshold_for_this_xct_;
 
-  sysxct_workspace_ = reinterpret_cast<SysxctWorkspace*>(pieces.sysxct_workspace_memory_);
+  sysxct_workspace_ = pieces.sysxct_workspace_;
 
-  read_set_ = reinterpret_cast<ReadXctAccess*>(pieces.xct_read_access_memory_);
+  const uint32_t growth_factor = pieces.growth_factor_;
+  ASSERT_ND(growth_factor >= 1U);
+  read_set_ = pieces.read_set_;
   read_set_size_ = 0;
-  max_read_set_size_ = xct_opt.max_read_set_size_;
-  write_set_ = reinterpret_cast<WriteXctAccess*>(pieces.xct_write_access_memory_);
+  max_read_set_size_ = xct_opt.max_read_set_size_ * growth_factor;
+  resident_read_set_size_ = xct_opt.max_read_set_size_;
+  write_set_ = pieces.write_set_;
   write_set_size_ = 0;
-  max_write_set_size_ = xct_opt.max_write_set_size_;
-  lock_free_read_set_ = reinterpret_cast<LockFreeReadXctAccess*>(
-    pieces.xct_lock_free_read_access_memory_);
+  max_write_set_size_ = xct_opt.max_write_set_size_ * growth_factor;
+  resident_write_set_size_ = xct_opt.max_write_set_size_;
+  lock_free_read_set_ = pieces.lock_free_read_set_;
   lock_free_read_set_size_ = 0;
-  max_lock_free_read_set_size_ = xct_opt.max_lock_free_read_set_size_;
-  lock_free_write_set_ = reinterpret_cast<LockFreeWriteXctAccess*>(
-    pieces.xct_lock_free_write_access_memory_);
+  max_lock_free_read_set_size_ = xct_opt.max_lock_free_read_set_size_ * growth_factor;
+  resident_lock_free_read_set_size_ = xct_opt.max_lock_free_read_set_size_;
+  lock_free_write_set_ = pieces.lock_free_write_set_;
   lock_free_write_set_size_ = 0;
-  max_lock_free_write_set_size_ = xct_opt.max_lock_free_write_set_size_;
-  pointer_set_ = reinterpret_cast<PointerAccess*>(pieces.xct_pointer_access_memory_);
+  max_lock_free_write_set_size_ = xct_opt.max_lock_free_write_set_size_ * growth_factor;
+  resident_lock_free_write_set_size_ = xct_opt.max_lock_free_write_set_size_;
+  resident_lock_list_capacity_ = xct_opt.max_read_set_size_ + xct_opt.max_write_set_size_;
+  retrospective_lock_list_spilled_ = false;
+  pointer_set_ = pieces.pointer_set_;
   pointer_set_size_ = 0;
-  page_version_set_ = reinterpret_cast<PageVersionAccess*>(pieces.xct_page_version_memory_);
+  page_version_set_ = pieces.page_version_set_;
   page_version_set_size_ = 0;
   mcs_block_current_ = mcs_block_current;
   *mcs_block_current_ = 0;
   mcs_rw_async_mapping_current_ = mcs_rw_async_mapping_current;
   *mcs_rw_async_mapping_current_ = 0;
-  local_work_memory_ = core_memory->get_local_work_memory();
-  local_work_memory_size_ = core_memory->get_local_work_memory_size();
+  local_work_memory_ = pieces.local_work_memory_;
+  local_work_memory_size_ = pieces.local_work_memory_size_;
   local_work_memory_cur_ = 0;
+  resident_local_work_memory_size_ = local_work_memory_size_ / growth_factor;
 
   sysxct_workspace_->init(context_);
   current_lock_list_.init(
-    core_memory->get_current_lock_list_memory(),
-    core_memory->get_current_lock_list_capacity(),
+    pieces.current_lock_list_,
+    pieces.current_lock_list_capacity_,
     engine_->get_memory_manager()->get_global_volatile_page_resolver());
   retrospective_lock_list_.init(
-    core_memory->get_retrospective_lock_list_memory(),
-    core_memory->get_retrospective_lock_list_capacity(),
+    pieces.retrospective_lock_list_,
+    pieces.retrospective_lock_list_capacity_,
     engine_->get_memory_manager()->get_global_volatile_page_resolver());
 }
 
+namespace {
+/** Discards entries in [max(used, resident), capacity) of the array. */
+template <typename T>
+void discard_tail(T* array, uint64_t used, uint64_t resident, uint64_t capacity) {
+  const uint64_t from = std::max<uint64_t>(used, resident);
+  if (from < capacity) {
+    memory::discard_physical_memory(array + from, sizeof(T) * (capacity - from));
+  }
+}
+}  // namespace
+
+void Xct::release_spilled_work_memory() {
+  ASSERT_ND(!active_);
+  DVLOG(1) << "Releasing spilled work memory. read_set_size=" << read_set_size_
+    << ", write_set_size=" << write_set_size_
+    << ", local_work_memory_cur=" << local_work_memory_cur_;
+  // We discard all tails regardless of which one exceeded. madvise on untouched pages is cheap.
+  discard_tail(read_set_, 0, resident_read_set_size_, max_read_set_size_);
+  discard_tail(write_set_, 0, resident_write_set_size_, max_write_set_size_);
+  discard_tail(
+    lock_free_read_set_,
+    0,
+    resident_lock_free_read_set_size_,
+    max_lock_free_read_set_size_);
+  discard_tail(
+    lock_free_write_set_,
+    0,
+    resident_lock_free_write_set_size_,
+    max_lock_free_write_set_size_);
+  discard_tail(
+    reinterpret_cast<char*>(local_work_memory_),
+    0,
+    resident_local_work_memory_size_,
+    local_work_memory_size_);
+  ASSERT_ND(current_lock_list_.is_empty());
+  discard_tail(
+    current_lock_list_.get_array(),
+    0,
+    resident_lock_list_capacity_,
+    current_lock_list_.get_capacity());
+
+  // RLL might be used in the next run. Index-0 is a dummy entry.
+  const uint64_t rll_used = retrospective_lock_list_.is_empty()
+    ? 0
+    : retrospective_lock_list_.get_last_active_entry() + 1U;
+  discard_tail(
+    retrospective_lock_list_.get_array(),
+    rll_used,
+    resident_lock_list_capacity_,
+    retrospective_lock_list_.get_capacity());
+  retrospective_lock_list_spilled_ = rll_used > resident_lock_list_capacity_;
+}
+
 void Xct::issue_next_id(XctId max_xct_id, Epoch *epoch)  {
   ASSERT_ND(id_.is_valid());
 
@@ -199,7 +341,7 @@ ErrorCode Xct::add_to_pointer_set(
   const storage::VolatilePagePointer* pointer_address,
   storage::VolatilePagePointer observed) {
   ASSERT_ND(pointer_address);
-  if (isolation_level_ != kSerializable) {
+  if (isolation_level_ != kSerializable || is_multi_version()) {
     return kErrorCodeOk;
   }
 
@@ -243,7 +385,7 @@ ErrorCode Xct::add_to_page_version_set(
   const storage::PageVersion* version_address,
   storage::PageVersionStatus observed) {
   ASSERT_ND(version_address);
-  if (isolation_level_ != kSerializable) {
+  if (isolation_level_ != kSerializable || is_multi_version()) {
     return kErrorCodeOk;
   } else if (UNLIKELY(page_version_set_size_ >= kMaxPointerSets)) {
     return kErrorCodeXctPageVersionSetOverflow;
@@ -275,6 +417,9 @@ ErrorCode Xct::on_record_read(
     *observed_xid = tid_address->xct_id_;
     ASSERT_ND(!observed_xid->is_being_written());
     return kErrorCodeOk;
+  } else if (UNLIKELY(is_multi_version())) {
+    // Multi-version reads go through XctManager::read_multi_version(), not here.
+    return kErrorCodeXctMultiVersionUnsupported;
   } else if (isolation_level_ != kSerializable) {
     // No read-set or read-locks needed in non-serializable transactions.
     // Also no point to conservatively take write-locks recommended by RLL
@@ -456,9 +601,20 @@ ErrorCode Xct::add_to_write_set(
   log::invoke_assert_valid(log_entry);
 #endif  // NDEBUG
 
-  if (UNLIKELY(write_set_size_ >= max_write_set_size_)) {
+  if (UNLIKELY(is_snapshot_only())) {
+    return kErrorCodeXctSnapshotOnlyWrite;
+  } else if (UNLIKELY(is_multi_version())) {
+    return kErrorCodeXctMultiVersionWrite;
+  } else if (UNLIKELY(write_set_size_ >= max_write_set_size_)) {
     return kErrorCodeXctWriteSetOverflow;
   }
+  const bool is_delta = is_delta_log(log_entry);
+  if (UNLIKELY(is_delta || delta_write_count_ > 0)) {
+    CHECK_ERROR_CODE(check_delta_conflict(owner_id_address, log_entry, is_delta));
+    if (is_delta) {
+      ++delta_write_count_;
+    }
+  }
   WriteXctAccess* write = write_set_ + write_set_size_;
   write->ordinal_ = write_set_size_;
   write->payload_address_ = payload_address;
@@ -466,10 +622,44 @@ ErrorCode Xct::add_to_write_set(
   write->storage_id_ = storage_id;
   write->set_owner_id_resolve_lock_id(resolver, owner_id_address);
   write->related_read_ = CXX11_NULLPTR;
+  write->repair_functor_ = CXX11_NULLPTR;
   ++write_set_size_;
   return kErrorCodeOk;
 }
 
+ErrorCode Xct::check_delta_conflict(
+  const RwLockableXctId* owner_id_address,
+  const log::RecordLogType* log_entry,
+  bool is_delta) const {
+  for (uint32_t i = 0; i < write_set_size_; ++i) {
+    const WriteXctAccess& other = write_set_[i];
+    if (other.owner_id_address_ != owner_id_address) {
+      continue;
+    }
+    const bool other_is_delta = is_delta_log(other.log_entry_);
+    if (is_delta == other_is_delta) {
+      continue;  // deltas commute with each other. two non-deltas are none of our business.
+    }
+    const log::RecordLogType* delta = is_delta ? log_entry : other.log_entry_;
+    const log::RecordLogType* non_delta = is_delta ? other.log_entry_ : log_entry;
+    if (might_not_fit_delta(delta, non_delta)) {
+      DLOG(INFO) << "A delta update conflicts with another write of the same record in the same"
+        << " transaction. delta=" << delta->header_ << ", other=" << non_delta->header_;
+      return kErrorCodeXctDeltaConflict;
+    }
+  }
+  return kErrorCodeOk;
+}
+
+ErrorCode Xct::set_repair_functor(XctRepairFunctor* functor) {
+  ASSERT_ND(functor);
+  if (UNLIKELY(write_set_size_ == 0)) {
+    return kErrorCodeInvalidParameter;
+  }
+  write_set_[write_set_size_ - 1U].repair_functor_ = functor;
+  return kErrorCodeOk;
+}
+
 
 ErrorCode Xct::add_to_read_and_write_set(
   storage::StorageId storage_id,
@@ -553,7 +743,11 @@ ErrorCode Xct::add_to_lock_free_write_set(
   log::RecordLogType* log_entry) {
   ASSERT_ND(storage_id != 0);
   ASSERT_ND(log_entry);
-  if (UNLIKELY(lock_free_write_set_size_ >= max_lock_free_write_set_size_)) {
+  if (UNLIKELY(is_snapshot_only())) {
+    return kErrorCodeXctSnapshotOnlyWrite;
+  } else if (UNLIKELY(is_multi_version())) {
+    return kErrorCodeXctMultiVersionWrite;
+  } else if (UNLIKELY(lock_free_write_set_size_ >= max_lock_free_write_set_size_)) {
     return kErrorCodeXctWriteSetOverflow;
   }
 
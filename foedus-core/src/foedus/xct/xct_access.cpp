@@ -68,6 +68,9 @@ std::ostream& operator<<(std::ostream& o, const WriteXctAccess& v) {
   if (v.related_read_) {
     o << "<HasRelatedRead />";  // does not output its content to avoid circle
   }
+  if (v.repair_functor_) {
+    o << "<HasRepairFunctor />";
+  }
   o << "</WriteAccess>";
   return o;
 }
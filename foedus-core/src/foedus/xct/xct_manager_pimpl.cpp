@@ -21,6 +21,7 @@
 
 #include <algorithm>
 #include <chrono>
+#include <cstring>
 #include <thread>
 #include <vector>
 
@@ -37,19 +38,29 @@
 #include "foedus/log/thread_log_buffer.hpp"
 #include "foedus/savepoint/savepoint.hpp"
 #include "foedus/savepoint/savepoint_manager.hpp"
+#include "foedus/snapshot/snapshot_id.hpp"
+#include "foedus/snapshot/snapshot_manager.hpp"
 #include "foedus/soc/soc_manager.hpp"
 #include "foedus/storage/record.hpp"
 #include "foedus/storage/storage_manager.hpp"
+#include "foedus/storage/array/array_log_types.hpp"
+#include "foedus/storage/array/array_storage.hpp"
+#include "foedus/storage/hash/hash_log_types.hpp"
+#include "foedus/storage/masstree/masstree_log_types.hpp"
+#include "foedus/thread/coroutine_impl.hpp"
 #include "foedus/thread/thread.hpp"
+#include "foedus/thread/thread_pimpl.hpp"
 #include "foedus/thread/thread_pool.hpp"
 #include "foedus/thread/thread_ref.hpp"
 #include "foedus/xct/in_commit_epoch_guard.hpp"
 #include "foedus/xct/retrospective_lock_list.hpp"
+#include "foedus/xct/version_store_impl.hpp"
 #include "foedus/xct/xct.hpp"
 #include "foedus/xct/xct_access.hpp"
 #include "foedus/xct/xct_id.hpp"
 #include "foedus/xct/xct_manager.hpp"
 #include "foedus/xct/xct_options.hpp"
+#include "foedus/xct/xct_repair_functor.hpp"
 
 namespace foedus {
 namespace xct {
@@ -72,10 +83,52 @@ ErrorCode   XctManager::wait_for_commit(Epoch commit_epoch, int64_t wait_microse
   return pimpl_->wait_for_commit(commit_epoch, wait_microseconds);
 }
 
+ErrorCode   XctManager::wait_for_commit(
+  thread::Thread* context,
+  Epoch commit_epoch,
+  int64_t wait_microseconds) {
+  return pimpl_->wait_for_commit(context, commit_epoch, wait_microseconds);
+}
+
 ErrorCode   XctManager::begin_xct(thread::Thread* context, IsolationLevel isolation_level) {
   return pimpl_->begin_xct(context, isolation_level);
 }
 
+ErrorCode   XctManager::begin_snapshot_only_xct(thread::Thread* context) {
+  return pimpl_->begin_snapshot_only_xct(context);
+}
+ErrorCode   XctManager::begin_snapshot_only_xct(
+  thread::Thread* context,
+  snapshot::SnapshotId snapshot_id,
+  Epoch snapshot_epoch) {
+  return pimpl_->begin_snapshot_only_xct(context, snapshot_id, snapshot_epoch);
+}
+ErrorCode   XctManager::begin_multi_version_xct(thread::Thread* context) {
+  return pimpl_->begin_multi_version_xct(context);
+}
+VersionStoreStat XctManager::get_version_store_stat() const {
+  return pimpl_->get_version_store_stat();
+}
+ErrorCode   XctManager::read_multi_version(
+  thread::Thread* context,
+  storage::StorageId storage_id,
+  uint64_t key,
+  const RwLockableXctId* owner_id,
+  const char* record_payload,
+  void* payload,
+  uint16_t payload_offset,
+  uint16_t payload_count) {
+  return pimpl_->read_multi_version(
+    context,
+    storage_id,
+    key,
+    owner_id,
+    record_payload,
+    payload,
+    payload_offset,
+    payload_count);
+}
+
 ErrorCode   XctManager::precommit_xct(thread::Thread* context, Epoch *commit_epoch) {
   return pimpl_->precommit_xct(context, commit_epoch);
 }
@@ -88,6 +141,10 @@ ErrorStack XctManagerPimpl::initialize_once() {
   }
   soc::SharedMemoryRepo* memory_repo = engine_->get_soc_manager()->get_shared_memory_repo();
   control_block_ = memory_repo->get_global_memory_anchors()->xct_manager_memory_;
+  version_store_.attach(
+    memory_repo->get_global_memory_anchors()->version_store_memory_,
+    engine_->get_options(),
+    engine_->is_master());
 
   if (engine_->is_master()) {
     control_block_->initialize();
@@ -299,6 +356,23 @@ ErrorCode XctManagerPimpl::wait_for_commit(Epoch commit_epoch, int64_t wait_micr
   return engine_->get_log_manager()->wait_until_durable(commit_epoch, wait_microseconds);
 }
 
+ErrorCode XctManagerPimpl::wait_for_commit(
+  thread::Thread* context,
+  Epoch commit_epoch,
+  int64_t wait_microseconds) {
+  thread::CoroutineScheduler* scheduler = context->get_pimpl()->coroutine_scheduler_;
+  if (scheduler == nullptr || !scheduler->is_yieldable()) {
+    return wait_for_commit(commit_epoch, wait_microseconds);
+  }
+
+  Epoch target_epoch = commit_epoch.one_more().one_more();
+  if (target_epoch > get_current_global_epoch()) {
+    set_requested_global_epoch(target_epoch);
+    wakeup_epoch_chime_thread();
+  }
+  return scheduler->wait_for_commit(commit_epoch, wait_microseconds);
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////
 ///
 ///       User transactions related methods
@@ -312,6 +386,10 @@ ErrorCode XctManagerPimpl::begin_xct(thread::Thread* context, IsolationLevel iso
   if (UNLIKELY(control_block_->new_transaction_paused_.load())) {
     wait_until_resume_accepting_xct(context);
   }
+  if (engine_->get_options().storage_.volatile_page_migration_sample_interval_ != 0) {
+    // Migration is just an optimization. Even if it fails, the new transaction can go on.
+    context->migrate_sampled_volatile_pages();
+  }
   DVLOG(1) << *context << " Began new transaction."
     << " RLL size=" << current_xct.get_retrospective_lock_list()->get_last_active_entry();
   current_xct.activate(isolation_level);
@@ -324,6 +402,83 @@ ErrorCode XctManagerPimpl::begin_xct(thread::Thread* context, IsolationLevel iso
   return kErrorCodeOk;
 }
 
+ErrorCode XctManagerPimpl::begin_snapshot_only_xct(thread::Thread* context) {
+  Xct& current_xct = context->get_current_xct();
+  if (current_xct.is_active()) {
+    return kErrorCodeXctAlreadyRunning;
+  }
+  // Read the epoch first. If a new snapshot completes in between, we get an older epoch
+  // than the snapshot's, which is still a durable epoch, so it's fine as the commit epoch.
+  const snapshot::SnapshotManager* snapshot_manager = engine_->get_snapshot_manager();
+  const Epoch snapshot_epoch = snapshot_manager->get_snapshot_epoch();
+  const snapshot::SnapshotId snapshot_id = snapshot_manager->get_previous_snapshot_id();
+  return begin_snapshot_only_xct(context, snapshot_id, snapshot_epoch);
+}
+
+ErrorCode XctManagerPimpl::begin_snapshot_only_xct(
+  thread::Thread* context,
+  snapshot::SnapshotId snapshot_id,
+  Epoch snapshot_epoch) {
+  Xct& current_xct = context->get_current_xct();
+  if (current_xct.is_active()) {
+    return kErrorCodeXctAlreadyRunning;
+  }
+  if (snapshot_id == snapshot::kNullSnapshotId || !snapshot_epoch.is_valid()) {
+    return kErrorCodeXctNoSnapshot;
+  }
+  CHECK_ERROR_CODE(begin_xct(context, kSnapshot));
+  current_xct.set_snapshot_only(snapshot_id, snapshot_epoch);
+  DVLOG(1) << *context << " Began snapshot-only transaction on snapshot-" << snapshot_id;
+  return kErrorCodeOk;
+}
+
+ErrorCode XctManagerPimpl::begin_multi_version_xct(thread::Thread* context) {
+  if (!version_store_.is_enabled()) {
+    return kErrorCodeXctMultiVersionDisabled;
+  }
+  Xct& current_xct = context->get_current_xct();
+  if (current_xct.is_active()) {
+    return kErrorCodeXctAlreadyRunning;
+  }
+  // All transactions in the durable epoch have finished applying their writes because
+  // the epoch chime waits for in-commit epochs before advancing the global epoch.
+  const Epoch as_of = engine_->get_log_manager()->get_durable_global_epoch();
+  ASSERT_ND(as_of.is_valid());
+  CHECK_ERROR_CODE(begin_xct(context, kSerializable));
+  current_xct.set_multi_version(as_of);
+  DVLOG(1) << *context << " Began multi-version transaction as of " << as_of;
+  return kErrorCodeOk;
+}
+
+ErrorCode XctManagerPimpl::read_multi_version(
+  thread::Thread* context,
+  storage::StorageId storage_id,
+  uint64_t key,
+  const RwLockableXctId* owner_id,
+  const char* record_payload,
+  void* payload,
+  uint16_t payload_offset,
+  uint16_t payload_count) {
+  const Xct& current_xct = context->get_current_xct();
+  ASSERT_ND(current_xct.is_multi_version());
+  ASSERT_ND(version_store_.is_enabled());
+  const Epoch as_of = current_xct.get_multi_version_epoch();
+  while (true) {
+    const XctId observed = owner_id->xct_id_.spin_while_being_written();
+    if (observed.get_epoch().is_valid() && observed.get_epoch() > as_of) {
+      // overwritten after as_of. the writer retained the old image before overwriting it.
+      return version_store_.read(storage_id, key, as_of, payload, payload_offset, payload_count);
+    }
+    std::memcpy(payload, record_payload + payload_offset, payload_count);
+    assorted::memory_fence_acquire();
+    if (owner_id->xct_id_ == observed) {
+      return kErrorCodeOk;
+    }
+    // a concurrent writer overwrote it while we copied. the next iteration will see a new
+    // epoch, so this doesn't spin long.
+  }
+}
+
 void XctManagerPimpl::pause_accepting_xct() {
   control_block_->new_transaction_paused_.store(true);
 }
@@ -349,7 +504,20 @@ ErrorCode XctManagerPimpl::precommit_xct(thread::Thread* context, Epoch *commit_
 
   ErrorCode result;
   bool read_only = context->get_current_xct().is_read_only();
-  if (read_only) {
+  if (current_xct.is_snapshot_only()) {
+    // it read only immutable snapshot pages. nothing to verify.
+    ASSERT_ND(read_only);
+    ASSERT_ND(current_xct.get_read_set_size() == 0);
+    ASSERT_ND(current_xct.get_pointer_set_size() == 0);
+    *commit_epoch = current_xct.get_snapshot_only_epoch();
+    result = kErrorCodeOk;
+  } else if (current_xct.is_multi_version()) {
+    // it read versions as of a durable epoch, which never change. nothing to verify.
+    ASSERT_ND(read_only);
+    ASSERT_ND(current_xct.get_read_set_size() == 0);
+    *commit_epoch = current_xct.get_multi_version_epoch();
+    result = kErrorCodeOk;
+  } else if (read_only) {
     result = precommit_xct_readonly(context, commit_epoch);
   } else {
     result = precommit_xct_readwrite(context, commit_epoch);
@@ -536,6 +704,22 @@ ErrorCode XctManagerPimpl::precommit_xct_lock_batch_track_moved(thread::Thread*
   return kErrorCodeOk;
 }
 
+bool XctManagerPimpl::precommit_xct_check_blind_write(const WriteXctAccess* write) const {
+  ASSERT_ND(write->related_read_ == nullptr);
+  ASSERT_ND(write->owner_id_address_->is_keylocked());
+  const log::LogCode type = write->log_entry_->header_.get_type();
+  if (type == log::kLogCodeMasstreeDelta) {
+    const auto* casted = reinterpret_cast<const storage::masstree::MasstreeDeltaLogType*>(
+      write->log_entry_);
+    return casted->is_applicable(write->owner_id_address_);
+  } else if (type == log::kLogCodeHashDelta) {
+    const auto* casted = reinterpret_cast<const storage::hash::HashDeltaLogType*>(
+      write->log_entry_);
+    return casted->is_applicable(write->owner_id_address_);
+  }
+  return true;
+}
+
 ErrorCode XctManagerPimpl::precommit_xct_lock(thread::Thread* context, XctId* max_xct_id) {
   Xct& current_xct = context->get_current_xct();
   WriteXctAccess* write_set = current_xct.get_write_set();
@@ -627,9 +811,16 @@ moved_retry:
       ASSERT_ND(entry->owner_id_address_ == r->owner_id_address_);
       if (r->related_read_) {
         ASSERT_ND(r->related_read_->owner_id_address_ == r->owner_id_address_);
-        if (r->owner_id_address_->xct_id_ != r->related_read_->observed_owner_id_) {
+        if (r->owner_id_address_->xct_id_ != r->related_read_->observed_owner_id_
+          && !precommit_xct_repair(
+            context,
+            r->related_read_,
+            write_set + it.write_cur_pos_,
+            write_set + it.write_next_pos_)) {
           return kErrorCodeXctRaceAbort;
         }
+      } else if (UNLIKELY(!precommit_xct_check_blind_write(r))) {
+        return kErrorCodeXctRaceAbort;
       }
     }
   }
@@ -643,6 +834,41 @@ moved_retry:
   return kErrorCodeOk;
 }
 
+bool XctManagerPimpl::precommit_xct_repair(
+  thread::Thread* context,
+  ReadXctAccess* read,
+  WriteXctAccess* writes_begin,
+  WriteXctAccess* writes_end) {
+  ASSERT_ND(writes_begin < writes_end);
+  ASSERT_ND(read->owner_id_address_ == writes_begin->owner_id_address_);
+  ASSERT_ND(read->owner_id_address_->is_keylocked());
+  // We hold the X-lock, so nobody else changes the record during the repair.
+  const XctId current_id = read->owner_id_address_->xct_id_;
+  if (current_id.is_deleted() || current_id.is_moved() || current_id.is_next_layer()) {
+    return false;
+  }
+  for (WriteXctAccess* write = writes_begin; write != writes_end; ++write) {
+    ASSERT_ND(write->owner_id_address_ == read->owner_id_address_);
+    if (write->repair_functor_ == nullptr) {
+      return false;
+    }
+  }
+  for (WriteXctAccess* write = writes_begin; write != writes_end; ++write) {
+    ErrorCode repair_ret = write->repair_functor_->repair(
+      context,
+      write->payload_address_,
+      write->log_entry_);
+    if (repair_ret != kErrorCodeOk) {
+      DVLOG(1) << *context << " repair functor refused to repair. will abort";
+      return false;
+    }
+  }
+  DVLOG(1) << *context << " repaired " << (writes_end - writes_begin) << " writes. observed_xid="
+    << read->observed_owner_id_ << ", now_xid=" << current_id;
+  read->observed_owner_id_ = current_id;
+  return true;
+}
+
 const uint16_t kReadsetPrefetchBatch = 16;
 
 bool XctManagerPimpl::precommit_xct_verify_readonly(thread::Thread* context, Epoch *commit_epoch) {
@@ -771,9 +997,27 @@ bool XctManagerPimpl::precommit_xct_verify_readwrite(thread::Thread* context, Xc
     }
 
     if (access.observed_owner_id_ != access.owner_id_address_->xct_id_) {
-      DVLOG(1) << *context << " read set changed by other transaction. will abort";
-      // same as read_only
-      return false;
+      // If we have locked the record to write it, maybe we can repair the writes.
+      WriteXctAccess* write_set = current_xct.get_write_set();
+      WriteXctAccess* write_set_end = write_set + current_xct.get_write_set_size();
+      WriteXctAccess* writes_begin = std::lower_bound(
+        write_set,
+        write_set_end,
+        access,
+        [](const WriteXctAccess& write, const ReadXctAccess& read) {
+          return write.owner_lock_id_ < read.owner_lock_id_;
+        });
+      WriteXctAccess* writes_end = writes_begin;
+      while (writes_end != write_set_end
+        && writes_end->owner_id_address_ == access.owner_id_address_) {
+        ++writes_end;
+      }
+      if (writes_begin == writes_end
+        || !precommit_xct_repair(context, &access, writes_begin, writes_end)) {
+        DVLOG(1) << *context << " read set changed by other transaction. will abort";
+        // same as read_only
+        return false;
+      }
     }
 
     /*
@@ -904,6 +1148,9 @@ void XctManagerPimpl::precommit_xct_apply(
       ASSERT_ND(write.owner_id_address_->xct_id_.is_being_written());
     } else {
       ASSERT_ND(!write.owner_id_address_->xct_id_.is_being_written());
+      if (version_store_.is_enabled()) {
+        precommit_xct_retain_version(context, write, *commit_epoch);
+      }
       write.owner_id_address_->xct_id_.set_being_written();
       assorted::memory_fence_release();
     }
@@ -951,6 +1198,40 @@ void XctManagerPimpl::precommit_xct_apply(
   DVLOG(1) << *context << " applied and unlocked write set";
 }
 
+void XctManagerPimpl::precommit_xct_retain_version(
+  thread::Thread* context,
+  const WriteXctAccess& write,
+  Epoch commit_epoch) {
+  const log::LogCode log_type = write.log_entry_->header_.get_type();
+  if (log_type != log::kLogCodeArrayOverwrite && log_type != log::kLogCodeArrayIncrement) {
+    return;
+  }
+  // We still hold the lock and haven't set being_written, so this is the last committed image.
+  const XctId old_xct_id = write.owner_id_address_->xct_id_;
+  ASSERT_ND(!old_xct_id.is_being_written());
+  if (!old_xct_id.get_epoch().is_valid() || old_xct_id.get_epoch() >= commit_epoch) {
+    // Readers read as of a durable epoch, which is before commit_epoch. They never need
+    // the image written in the same epoch.
+    return;
+  }
+  const auto* log_entry
+    = reinterpret_cast<const storage::array::ArrayCommonUpdateLogType*>(write.log_entry_);
+  storage::array::ArrayStorage storage(engine_, write.storage_id_);
+  bool retained = version_store_.retain(
+    context->get_thread_global_ordinal(),
+    write.storage_id_,
+    log_entry->offset_,
+    old_xct_id,
+    commit_epoch,
+    write.payload_address_,
+    storage.get_payload_size(),
+    engine_->get_log_manager()->get_durable_global_epoch_weak());
+  if (!retained) {
+    DVLOG(2) << *context << " Couldn't retain the old version of "
+      << write.storage_id_ << ":" << log_entry->offset_;
+  }
+}
+
 ErrorCode XctManagerPimpl::abort_xct(thread::Thread* context) {
   Xct& current_xct = context->get_current_xct();
   if (!current_xct.is_active()) {
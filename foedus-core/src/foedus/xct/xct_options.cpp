@@ -25,11 +25,14 @@ XctOptions::XctOptions() {
   max_lock_free_read_set_size_ = kDefaultMaxLockFreeReadSetSize;
   max_lock_free_write_set_size_ = kDefaultMaxLockFreeWriteSetSize;
   local_work_memory_size_mb_ = kDefaultLocalWorkMemorySizeMb;
+  work_memory_growth_factor_ = kDefaultWorkMemoryGrowthFactor;
   epoch_advance_interval_ms_ = kDefaultEpochAdvanceIntervalMs;
   enable_retrospective_lock_list_ = false;  // TODO(Hideaki) tentative!
   hot_threshold_for_retrospective_lock_list_ = kDefaultHotThreshold;
   force_canonical_xlocks_in_precommit_ = true;  // TODO(Hideaki) tentative!
   mcs_implementation_type_ = kMcsImplementationTypeSimple;
+  version_arena_size_kb_ = kDefaultVersionArenaSizeKb;
+  max_version_chain_length_ = kDefaultMaxVersionChainLength;
 }
 
 ErrorStack XctOptions::load(tinyxml2::XMLElement* element) {
@@ -38,11 +41,14 @@ ErrorStack XctOptions::load(tinyxml2::XMLElement* element) {
   EXTERNALIZE_LOAD_ELEMENT(element, max_lock_free_read_set_size_);
   EXTERNALIZE_LOAD_ELEMENT(element, max_lock_free_write_set_size_);
   EXTERNALIZE_LOAD_ELEMENT(element, local_work_memory_size_mb_);
+  EXTERNALIZE_LOAD_ELEMENT(element, work_memory_growth_factor_);
   EXTERNALIZE_LOAD_ELEMENT(element, epoch_advance_interval_ms_);
   EXTERNALIZE_LOAD_ELEMENT(element, enable_retrospective_lock_list_);
   EXTERNALIZE_LOAD_ELEMENT(element, hot_threshold_for_retrospective_lock_list_);
   EXTERNALIZE_LOAD_ELEMENT(element, force_canonical_xlocks_in_precommit_);
   EXTERNALIZE_LOAD_ELEMENT(element, mcs_implementation_type_);
+  EXTERNALIZE_LOAD_ELEMENT(element, version_arena_size_kb_);
+  EXTERNALIZE_LOAD_ELEMENT(element, max_version_chain_length_);
   return kRetOk;
 }
 
@@ -66,6 +72,11 @@ ErrorStack XctOptions::save(tinyxml2::XMLElement* element) const {
     "Local work memory is used for various purposes during a transaction."
     " We avoid allocating such temporary memory for each transaction and pre-allocate this"
     " size at start up.");
+  EXTERNALIZE_SAVE_ELEMENT(element, work_memory_growth_factor_,
+    "How many times larger than the sizes above the read/write-sets, lock lists, and local"
+    " work memory of one transaction can grow. Default is 4. The part beyond the sizes above"
+    " is just reserved address space, backed by physical memory only while a large"
+    " transaction uses it. 1 means a transaction can't exceed the sizes above.");
   EXTERNALIZE_SAVE_ELEMENT(element, epoch_advance_interval_ms_,
     "Intervals in milliseconds between epoch advancements. Default is 20 ms\n"
     " Too frequent epoch advancement might become bottleneck because we synchronously write.\n"
@@ -83,6 +94,12 @@ ErrorStack XctOptions::save(tinyxml2::XMLElement* element) const {
   EXTERNALIZE_SAVE_ELEMENT(element, mcs_implementation_type_,
     "Defines which implementation of MCS locks to use for RW locks."
     " So far we allow kMcsImplementationTypeSimple and kMcsImplementationTypeExtended.");
+  EXTERNALIZE_SAVE_ELEMENT(element, version_arena_size_kb_,
+    "Size of the per-thread arena that retains old versions of overwritten records."
+    " 0 (default) disables multi-version reads. Otherwise, read-only transactions that"
+    " begin with begin_multi_version_xct() read the versions as of the durable epoch.");
+  EXTERNALIZE_SAVE_ELEMENT(element, max_version_chain_length_,
+    "The maximum number of versions a multi-version read follows in a version chain.");
   return kRetOk;
 }
 
@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#include "foedus/engine.hpp"
+#include "foedus/engine_options.hpp"
+#include "foedus/test_common.hpp"
+#include "foedus/cache/cache_hashtable.hpp"
+#include "foedus/cache/cache_manager_pimpl.hpp"
+#include "foedus/fs/filesystem.hpp"
+#include "foedus/memory/engine_memory.hpp"
+#include "foedus/memory/numa_node_memory.hpp"
+#include "foedus/proc/proc_manager.hpp"
+#include "foedus/snapshot/snapshot_manager.hpp"
+#include "foedus/storage/storage_manager.hpp"
+#include "foedus/storage/array/array_metadata.hpp"
+#include "foedus/storage/array/array_storage.hpp"
+#include "foedus/thread/impersonate_session.hpp"
+#include "foedus/thread/thread.hpp"
+#include "foedus/thread/thread_pool.hpp"
+#include "foedus/xct/xct_manager.hpp"
+
+/**
+ * @file test_cache_hot_list.cpp
+ * Testcases for persisting hot snapshot page IDs and prefetching them at startup.
+ */
+namespace foedus {
+namespace cache {
+DEFINE_TEST_CASE_PACKAGE(CacheHotListTest, foedus.cache);
+
+const storage::array::ArrayOffset kRecords = 10000;
+
+ErrorStack populate_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  storage::array::ArrayStorage array(args.engine_, "hot");
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  Epoch commit_epoch;
+  // small transactions not to overflow the tiny log buffer
+  const storage::array::ArrayOffset kBatch = 1000;
+  for (storage::array::ArrayOffset from = 0; from < kRecords; from += kBatch) {
+    CHECK_ERROR(xct_manager->begin_xct(context, xct::kSerializable));
+    for (storage::array::ArrayOffset i = from; i < from + kBatch; ++i) {
+      CHECK_ERROR(array.overwrite_record_primitive<uint64_t>(context, i, i * 3U, 0));
+    }
+    CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+  }
+  CHECK_ERROR(xct_manager->wait_for_commit(commit_epoch));
+  return kRetOk;
+}
+
+/** Reads all records from snapshot pages, which installs them to the snapshot cache. */
+ErrorStack read_snapshot_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  storage::array::ArrayStorage array(args.engine_, "hot");
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  CHECK_ERROR(xct_manager->begin_snapshot_only_xct(context));
+  for (storage::array::ArrayOffset i = 0; i < kRecords; ++i) {
+    uint64_t value = 0;
+    CHECK_ERROR(array.get_record_primitive<uint64_t>(context, i, &value, 0));
+    EXPECT_EQ(i * 3U, value) << i;
+  }
+  Epoch commit_epoch;
+  CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+  return kRetOk;
+}
+
+/** Waits until the cache has as many entries as the input, then outputs the entry count. */
+ErrorStack wait_prefetch_task(const proc::ProcArguments& args) {
+  const uint64_t expected = *reinterpret_cast<const uint64_t*>(args.input_buffer_);
+  CacheHashtable* hashtable
+    = args.engine_->get_memory_manager()->get_local_memory()->get_snapshot_cache_table();
+  uint64_t entries = 0;
+  for (uint32_t rep = 0; rep < 1000U; ++rep) {
+    CacheHashtable::Stat stat = hashtable->get_stat_single_thread();
+    entries = stat.normal_entries_ + stat.overflow_entries_;
+    if (entries >= expected) {
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  *args.output_used_ = sizeof(entries);
+  *reinterpret_cast<uint64_t*>(args.output_buffer_) = entries;
+  return kRetOk;
+}
+
+uint64_t read_hot_list_count(const EngineOptions& options) {
+  std::string path = options.cache_.convert_hot_list_path_pattern(0);
+  EXPECT_TRUE(fs::exists(fs::Path(path))) << path;
+  std::ifstream file(path, std::ifstream::binary);
+  CacheManagerPimpl::HotListHeader header = {0, 0};
+  file.read(reinterpret_cast<char*>(&header), sizeof(header));
+  EXPECT_EQ(CacheManagerPimpl::kHotListMagicWord, header.magic_word_);
+  return header.page_count_;
+}
+
+void register_tasks(Engine* engine) {
+  engine->get_proc_manager()->pre_register("populate_task", populate_task);
+  engine->get_proc_manager()->pre_register("read_snapshot_task", read_snapshot_task);
+  engine->get_proc_manager()->pre_register("wait_prefetch_task", wait_prefetch_task);
+}
+
+TEST(CacheHotListTest, DumpAndPrefetch) {
+  EngineOptions options = get_tiny_options();
+  options.cache_.snapshot_cache_persist_hot_list_ = true;
+  {
+    Engine engine(options);
+    register_tasks(&engine);
+    COERCE_ERROR(engine.initialize());
+    {
+      UninitializeGuard guard(&engine);
+      storage::array::ArrayMetadata meta("hot", sizeof(uint64_t), kRecords);
+      storage::array::ArrayStorage storage;
+      Epoch epoch;
+      COERCE_ERROR(engine.get_storage_manager()->create_array(&meta, &storage, &epoch));
+      thread::ThreadPool* pool = engine.get_thread_pool();
+      COERCE_ERROR(pool->impersonate_synchronous("populate_task"));
+      engine.get_snapshot_manager()->trigger_snapshot_immediate(true);
+      COERCE_ERROR(pool->impersonate_synchronous("read_snapshot_task"));
+      COERCE_ERROR(engine.uninitialize());
+    }
+  }
+
+  // at least all leaf pages of the array are in the list
+  uint64_t dumped = read_hot_list_count(options);
+  const uint64_t kRecordsInLeaf = storage::array::to_records_in_leaf(sizeof(uint64_t));
+  EXPECT_GE(dumped, kRecords / kRecordsInLeaf);
+
+  {
+    Engine engine(options);
+    register_tasks(&engine);
+    COERCE_ERROR(engine.initialize());
+    {
+      UninitializeGuard guard(&engine);
+      thread::ThreadPool* pool = engine.get_thread_pool();
+      uint64_t entries = 0;
+      {
+        thread::ImpersonateSession session;
+        EXPECT_TRUE(pool->impersonate("wait_prefetch_task", &dumped, sizeof(dumped), &session));
+        COERCE_ERROR(session.get_result());
+        EXPECT_EQ(sizeof(entries), session.get_output_size());
+        session.get_output(&entries);
+        session.release();
+      }
+      EXPECT_GE(entries, dumped);
+      // prefetched pages must be the correct pages
+      COERCE_ERROR(pool->impersonate_synchronous("read_snapshot_task"));
+      COERCE_ERROR(engine.uninitialize());
+    }
+  }
+  cleanup_test(options);
+}
+
+TEST(CacheHotListTest, BrokenFile) {
+  EngineOptions options = get_tiny_options();
+  options.cache_.snapshot_cache_persist_hot_list_ = true;
+  std::string path = options.cache_.convert_hot_list_path_pattern(0);
+  fs::create_directories(fs::Path(path).parent_path());
+  {
+    std::ofstream file(path, std::ofstream::binary);
+    file << "this is not a hot list";
+  }
+
+  // the engine just ignores the broken list and overwrites it at shutdown
+  Engine engine(options);
+  register_tasks(&engine);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    COERCE_ERROR(engine.uninitialize());
+  }
+  EXPECT_EQ(0, read_hot_list_count(options));
+  cleanup_test(options);
+}
+
+}  // namespace cache
+}  // namespace foedus
+
+TEST_MAIN_CAPTURE_SIGNALS(CacheHotListTest, foedus.cache);
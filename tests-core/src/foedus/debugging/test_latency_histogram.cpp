@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include <stdint.h>
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <string>
+
+#include "foedus/engine.hpp"
+#include "foedus/engine_options.hpp"
+#include "foedus/epoch.hpp"
+#include "foedus/test_common.hpp"
+#include "foedus/debugging/latency_histogram.hpp"
+#include "foedus/debugging/open_loop.hpp"
+#include "foedus/proc/proc_manager.hpp"
+#include "foedus/storage/storage_manager.hpp"
+#include "foedus/storage/array/array_metadata.hpp"
+#include "foedus/storage/array/array_storage.hpp"
+#include "foedus/thread/thread.hpp"
+#include "foedus/thread/thread_pool.hpp"
+#include "foedus/xct/xct_manager.hpp"
+
+/**
+ * @file test_latency_histogram.cpp
+ * Testcases for LatencyHistogram and the open-loop helpers.
+ */
+namespace foedus {
+namespace debugging {
+DEFINE_TEST_CASE_PACKAGE(LatencyHistogramTest, foedus.debugging);
+
+TEST(LatencyHistogramTest, Buckets) {
+  for (uint32_t i = 0; i < static_cast<uint32_t>(LatencyHistogram::kBucketCount); ++i) {
+    uint64_t low = LatencyHistogram::bucket_lowest_value(i);
+    uint64_t high = LatencyHistogram::bucket_highest_value(i);
+    EXPECT_LE(low, high) << i;
+    EXPECT_EQ(i, LatencyHistogram::to_bucket(low)) << i;
+    EXPECT_EQ(i, LatencyHistogram::to_bucket(high)) << i;
+    if (i > 0) {
+      EXPECT_EQ(LatencyHistogram::bucket_highest_value(i - 1) + 1U, low) << i;
+    }
+    // relative error is within 1/32
+    EXPECT_LE((high - low) * 32U, low + 1U) << i;
+  }
+  const uint64_t kLargest = (1ULL << LatencyHistogram::kMaxValueBits) - 1U;
+  const uint32_t kLastBucket = LatencyHistogram::kBucketCount - 1;
+  EXPECT_EQ(kLastBucket, LatencyHistogram::to_bucket(kLargest));
+  EXPECT_EQ(kLastBucket, LatencyHistogram::to_bucket(kLargest + 1U));
+  EXPECT_EQ(kLastBucket, LatencyHistogram::to_bucket(~0ULL));
+}
+
+TEST(LatencyHistogramTest, Percentiles) {
+  LatencyHistogram histogram;
+  EXPECT_EQ(0U, histogram.get_count());
+  EXPECT_EQ(0U, histogram.get_percentile_nanoseconds(50.0));
+  // 1us, 2us, ..., 1000us
+  for (uint64_t i = 1; i <= 1000U; ++i) {
+    histogram.record(i * 1000U);
+  }
+  EXPECT_EQ(1000U, histogram.get_count());
+  EXPECT_NEAR(500500.0, histogram.get_mean_nanoseconds(), 0.1);
+  const double kPercentiles[] = {1.0, 50.0, 90.0, 99.0, 99.9, 100.0};
+  for (double percentile : kPercentiles) {
+    double expected = percentile * 10000.0;
+    double actual = histogram.get_percentile_nanoseconds(percentile);
+    EXPECT_GE(actual, expected) << percentile;
+    EXPECT_LE(actual, expected * 1.04) << percentile;
+  }
+  EXPECT_EQ(histogram.get_percentile_nanoseconds(100.0), histogram.get_max_nanoseconds());
+
+  std::stringstream str;
+  histogram.write_json(&str);
+  EXPECT_EQ(0, str.str().find("{\"count\":1000,\"mean_us\":500.5,\"p50_us\":")) << str.str();
+}
+
+TEST(LatencyHistogramTest, Subtract) {
+  LatencyHistogram cumulative;
+  for (uint32_t i = 0; i < 100U; ++i) {
+    cumulative.record(10000U);
+  }
+  LatencyHistogram previous = cumulative;
+  for (uint32_t i = 0; i < 10U; ++i) {
+    cumulative.record(5000000U);
+  }
+  LatencyHistogram interval = cumulative;
+  interval.subtract(previous);
+  EXPECT_EQ(10U, interval.get_count());
+  EXPECT_EQ(50000000U, interval.get_total_nanoseconds());
+  EXPECT_GE(interval.get_percentile_nanoseconds(1.0), 5000000U);
+
+  LatencyHistogram merged = previous;
+  merged.merge(interval);
+  EXPECT_EQ(cumulative.get_count(), merged.get_count());
+  EXPECT_EQ(cumulative.get_total_nanoseconds(), merged.get_total_nanoseconds());
+  EXPECT_EQ(cumulative.get_percentile_nanoseconds(95.0), merged.get_percentile_nanoseconds(95.0));
+}
+
+TEST(LatencyHistogramTest, FixedArrival) {
+  ArrivalSchedule schedule(ArrivalSchedule::kFixed, 1000.0, 1234U);
+  schedule.start(5000U);
+  for (uint64_t i = 0; i < 100U; ++i) {
+    EXPECT_EQ(5000U + i * 1000000U, schedule.pop_arrival());
+  }
+}
+
+TEST(LatencyHistogramTest, PoissonArrival) {
+  ArrivalSchedule schedule(ArrivalSchedule::kPoisson, 1000.0, 1234U);
+  schedule.start(0);
+  const uint32_t kArrivals = 100000U;
+  uint64_t previous = schedule.pop_arrival();
+  uint32_t short_intervals = 0;
+  for (uint32_t i = 1; i < kArrivals; ++i) {
+    uint64_t arrival = schedule.pop_arrival();
+    EXPECT_GE(arrival, previous);
+    if (arrival - previous < 1000000U) {
+      ++short_intervals;
+    }
+    previous = arrival;
+  }
+  // the mean interval is 1ms
+  EXPECT_NEAR(1000000.0, static_cast<double>(schedule.get_next_arrival()) / kArrivals, 20000.0);
+  // P(interval < mean) = 1 - 1/e = 63.2%
+  EXPECT_NEAR(0.632, static_cast<double>(short_intervals) / kArrivals, 0.01);
+}
+
+const uint16_t kXctTypes = 2;
+const uint32_t kXcts = 100;
+
+ErrorStack record_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  Engine* engine = args.engine_;
+  xct::XctManager* xct_manager = engine->get_xct_manager();
+  storage::array::ArrayStorage array(engine, "test");
+  LatencyHistogram histograms[kXctTypes];
+  // small enough to wait for durability in on_commit()
+  DurableLatencyRecorder recorder(engine, histograms, 8U);
+  for (uint32_t i = 0; i < kXcts; ++i) {
+    const uint64_t intended_start = get_monotonic_nanoseconds();
+    recorder.complete_durable();
+    CHECK_ERROR(xct_manager->begin_xct(context, xct::kSerializable));
+    CHECK_ERROR(array.overwrite_record_primitive<uint64_t>(context, i, i, 0));
+    Epoch commit_epoch;
+    CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+    recorder.on_commit(i % kXctTypes, intended_start, commit_epoch);
+    EXPECT_LE(recorder.get_pending_count(), 8U);
+  }
+  // a rolled-back transaction has no commit epoch, recorded immediately
+  recorder.on_commit(0, get_monotonic_nanoseconds(), Epoch());
+  recorder.complete_all();
+  EXPECT_EQ(0U, recorder.get_pending_count());
+  EXPECT_EQ(kXcts / 2U + 1U, histograms[0].get_count());
+  EXPECT_EQ(kXcts / 2U, histograms[1].get_count());
+  EXPECT_GT(histograms[1].get_percentile_nanoseconds(50.0), 0U);
+  return kRetOk;
+}
+
+TEST(LatencyHistogramTest, DurableRecorder) {
+  EngineOptions options = get_tiny_options();
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("record_task", record_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    storage::array::ArrayMetadata meta("test", sizeof(uint64_t), kXcts);
+    storage::array::ArrayStorage storage;
+    Epoch epoch;
+    COERCE_ERROR(engine.get_storage_manager()->create_array(&meta, &storage, &epoch));
+    COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("record_task"));
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+}  // namespace debugging
+}  // namespace foedus
+
+TEST_MAIN_CAPTURE_SIGNALS(LatencyHistogramTest, foedus.debugging);
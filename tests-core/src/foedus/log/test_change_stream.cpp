@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <sstream>
+#include <string>
+
+#include "foedus/engine.hpp"
+#include "foedus/engine_options.hpp"
+#include "foedus/epoch.hpp"
+#include "foedus/test_common.hpp"
+#include "foedus/log/change_stream.hpp"
+#include "foedus/log/log_manager.hpp"
+#include "foedus/log/log_type.hpp"
+#include "foedus/proc/proc_manager.hpp"
+#include "foedus/storage/storage_manager.hpp"
+#include "foedus/storage/array/array_log_types.hpp"
+#include "foedus/storage/array/array_metadata.hpp"
+#include "foedus/storage/array/array_storage.hpp"
+#include "foedus/thread/thread.hpp"
+#include "foedus/thread/thread_pool.hpp"
+#include "foedus/xct/xct_manager.hpp"
+
+/**
+ * @file test_change_stream.cpp
+ * Testcases for ChangeStream, the change-data-capture feed of committed records.
+ */
+namespace foedus {
+namespace log {
+DEFINE_TEST_CASE_PACKAGE(ChangeStreamTest, foedus.log);
+
+const storage::array::ArrayOffset kRecords = 100;
+
+/** Overwrites all records of both arrays. "watched" gets i * 3, "ignored" gets i * 5. */
+ErrorStack write_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  storage::array::ArrayStorage watched(args.engine_, "watched");
+  storage::array::ArrayStorage ignored(args.engine_, "ignored");
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  Epoch commit_epoch;
+  for (storage::array::ArrayOffset i = 0; i < kRecords; ++i) {
+    CHECK_ERROR(xct_manager->begin_xct(context, xct::kSerializable));
+    CHECK_ERROR(watched.overwrite_record_primitive<uint64_t>(context, i, i * 3U, 0));
+    CHECK_ERROR(ignored.overwrite_record_primitive<uint64_t>(context, i, i * 5U, 0));
+    CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+  }
+  CHECK_ERROR(xct_manager->wait_for_commit(commit_epoch));
+  return kRetOk;
+}
+
+storage::StorageId create_array(Engine* engine, const char* name) {
+  storage::array::ArrayMetadata meta(name, sizeof(uint64_t), kRecords);
+  storage::array::ArrayStorage storage;
+  Epoch epoch;
+  COERCE_ERROR(engine->get_storage_manager()->create_array(&meta, &storage, &epoch));
+  return storage.get_id();
+}
+
+TEST(ChangeStreamTest, Subscribe) {
+  EngineOptions options = get_tiny_options();
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("write_task", write_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    storage::StorageId watched_id = create_array(&engine, "watched");
+    create_array(&engine, "ignored");
+    ChangeStream stream(&engine, Epoch());
+    stream.subscribe(watched_id);
+    stream.set_max_batch_epochs(2);
+    const Epoch start_epoch = stream.get_consumed_epoch();
+    EXPECT_TRUE(start_epoch.is_valid());
+
+    COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("write_task"));
+    // write_task waited for its commit, so this covers all of them
+    const Epoch commit_epoch = engine.get_log_manager()->get_durable_global_epoch();
+    EXPECT_GT(commit_epoch, start_epoch);
+
+    uint32_t count = 0;
+    xct::XctId previous;
+    previous.data_ = 0;
+    ChangeBatch batch;
+    while (stream.get_consumed_epoch() < commit_epoch) {
+      COERCE_ERROR(stream.fetch(&batch, 1000000));
+      EXPECT_EQ(batch.get_until_epoch(), stream.get_consumed_epoch());
+      EXPECT_LE(batch.get_until_epoch().subtract(batch.get_from_epoch()), 2U);
+      for (uint32_t i = 0; i < batch.get_record_count(); ++i) {
+        const ChangeRecord& record = batch.get_record(i);
+        EXPECT_EQ(watched_id, record.get_storage_id());
+        EXPECT_EQ(kLogCodeArrayOverwrite, record.get_type());
+        EXPECT_GT(record.get_epoch(), batch.get_from_epoch());
+        EXPECT_LE(record.get_epoch(), batch.get_until_epoch());
+        if (previous.is_valid()) {
+          EXPECT_FALSE(record.get_xct_id().before(previous));
+        }
+        previous = record.get_xct_id();
+        const storage::array::ArrayOverwriteLogType* log
+          = reinterpret_cast<const storage::array::ArrayOverwriteLogType*>(record.log_);
+        ASSERT_EQ(sizeof(uint64_t), log->payload_count_);
+        uint64_t value;
+        std::memcpy(&value, log->payload_, sizeof(value));
+        EXPECT_EQ(log->offset_ * 3U, value);
+        EXPECT_EQ(count, log->offset_);  // one thread wrote them in this order
+        ++count;
+      }
+    }
+    EXPECT_EQ(kRecords, count);
+    ASSERT_GT(batch.get_record_count(), 0U);
+    std::stringstream str;
+    str << batch.get_record(0);
+    EXPECT_NE(std::string::npos, str.str().find("ChangeRecord"));
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+TEST(ChangeStreamTest, Wait) {
+  EngineOptions options = get_tiny_options();
+  Engine engine(options);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    Epoch durable_epoch = engine.get_log_manager()->get_durable_global_epoch();
+    ChangeStream stream(&engine, durable_epoch);
+    ChangeBatch batch;
+    // nothing is durable after it yet, so an immediate fetch returns nothing
+    COERCE_ERROR(stream.fetch(&batch, 0));
+    EXPECT_TRUE(batch.is_empty());
+    EXPECT_LE(batch.get_from_epoch(), batch.get_until_epoch());
+    // epochs keep advancing without transactions. waiting returns empty epochs.
+    while (stream.get_consumed_epoch() == durable_epoch) {
+      COERCE_ERROR(stream.fetch(&batch, 1000000));
+    }
+    EXPECT_TRUE(batch.is_empty());
+    EXPECT_GT(batch.get_until_epoch(), durable_epoch);
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+}  // namespace log
+}  // namespace foedus
+
+TEST_MAIN_CAPTURE_SIGNALS(ChangeStreamTest, foedus.log);
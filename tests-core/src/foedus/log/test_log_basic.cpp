@@ -17,18 +17,23 @@
  */
 #include <gtest/gtest.h>
 
+#include <cstring>
 #include <string>
 
 #include "foedus/engine.hpp"
 #include "foedus/engine_options.hpp"
 #include "foedus/epoch.hpp"
 #include "foedus/test_common.hpp"
+#include "foedus/fs/filesystem.hpp"
 #include "foedus/log/common_log_types.hpp"
 #include "foedus/log/log_options.hpp"
 #include "foedus/log/thread_log_buffer.hpp"
 #include "foedus/memory/numa_core_memory.hpp"
 #include "foedus/proc/proc_manager.hpp"
+#include "foedus/storage/storage_manager.hpp"
+#include "foedus/storage/array/array_metadata.hpp"
 #include "foedus/storage/array/array_page_impl.hpp"
+#include "foedus/storage/array/array_storage.hpp"
 #include "foedus/thread/thread.hpp"
 #include "foedus/thread/thread_pool.hpp"
 #include "foedus/xct/xct.hpp"
@@ -216,6 +221,137 @@ TEST(LogBasicTest, BufferWrapAround) {
   cleanup_test(options);
 }
 
+TEST(LogBasicTest, DynamicAssignment) {
+  EngineOptions options = get_tiny_options();
+  options.log_.log_buffer_kb_ = 16;
+  // two loggers for two threads. each logger might write out either thread's logs.
+  options.log_.loggers_per_node_ = 2;
+  options.log_.dynamic_logger_assignment_ = true;
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register(proc::ProcAndName(
+    "test_buffer_wrap_around",
+    test_buffer_wrap_around));
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("test_buffer_wrap_around"));
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+const storage::array::ArrayOffset kSkewedRecords = 64;
+const uint32_t kSkewedMaxRounds = 1000;
+
+EngineOptions get_skewed_options() {
+  EngineOptions options = get_tiny_options();
+  // two loggers for two threads, but only one thread writes.
+  options.log_.loggers_per_node_ = 2;
+  options.log_.dynamic_logger_assignment_ = true;
+  return options;
+}
+
+uint64_t get_logger_file_size(Engine* engine, LoggerId logger) {
+  return fs::file_size(fs::Path(
+    engine->get_options().log_.construct_suffixed_log_path(0, logger, 0)));
+}
+
+/**
+ * Only one thread writes, so the logger of the other thread has its own logs only if it
+ * claimed the writer's logs. Each round overwrites all records in a new epoch until both
+ * loggers have written out something. Outputs the number of rounds.
+ */
+ErrorStack skewed_write_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  Engine* engine = args.engine_;
+  storage::array::ArrayStorage array(engine, "skewed");
+  xct::XctManager* xct_manager = engine->get_xct_manager();
+  const uint64_t initial_sizes[2] = {
+    get_logger_file_size(engine, 0),
+    get_logger_file_size(engine, 1)};
+  uint32_t rounds = 0;
+  bool both_written = false;
+  while (!both_written && rounds < kSkewedMaxRounds) {
+    ++rounds;
+    Epoch commit_epoch;
+    for (storage::array::ArrayOffset i = 0; i < kSkewedRecords; ++i) {
+      WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+      WRAP_ERROR_CODE(array.overwrite_record_primitive<uint64_t>(context, i, rounds, 0));
+      WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+    }
+    WRAP_ERROR_CODE(xct_manager->wait_for_commit(commit_epoch));
+    both_written = get_logger_file_size(engine, 0) > initial_sizes[0]
+      && get_logger_file_size(engine, 1) > initial_sizes[1];
+  }
+  EXPECT_TRUE(both_written) << "rounds=" << rounds;
+  std::memcpy(args.output_buffer_, &rounds, sizeof(rounds));
+  *args.output_used_ = sizeof(rounds);
+  return kRetOk;
+}
+
+ErrorStack skewed_verify_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  EXPECT_EQ(sizeof(uint32_t), args.input_len_);
+  uint32_t rounds;
+  std::memcpy(&rounds, args.input_buffer_, sizeof(rounds));
+  storage::array::ArrayStorage array(args.engine_, "skewed");
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+  for (storage::array::ArrayOffset i = 0; i < kSkewedRecords; ++i) {
+    uint64_t value = 0;
+    WRAP_ERROR_CODE(array.get_record_primitive<uint64_t>(context, i, &value, 0));
+    EXPECT_EQ(rounds, value) << i;
+  }
+  Epoch commit_epoch;
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  return kRetOk;
+}
+
+TEST(LogBasicTest, DynamicAssignmentSkewed) {
+  EngineOptions options = get_skewed_options();
+  uint32_t rounds = 0;
+  {
+    Engine engine(options);
+    engine.get_proc_manager()->pre_register("skewed_write_task", skewed_write_task);
+    COERCE_ERROR(engine.initialize());
+    {
+      UninitializeGuard guard(&engine);
+      storage::array::ArrayMetadata meta("skewed", sizeof(uint64_t), kSkewedRecords);
+      storage::array::ArrayStorage storage;
+      Epoch epoch;
+      COERCE_ERROR(engine.get_storage_manager()->create_array(&meta, &storage, &epoch));
+      thread::ImpersonateSession session;
+      EXPECT_TRUE(engine.get_thread_pool()->impersonate(
+        "skewed_write_task",
+        nullptr,
+        0,
+        &session));
+      COERCE_ERROR(session.get_result());
+      EXPECT_EQ(sizeof(rounds), session.get_output_size());
+      session.get_output(&rounds);
+      session.release();
+      COERCE_ERROR(engine.uninitialize());
+    }
+  }
+  EXPECT_GT(rounds, 0U);
+
+  // restart merges the logs of both loggers, whichever wrote each epoch of the writer
+  {
+    Engine engine(options);
+    engine.get_proc_manager()->pre_register("skewed_verify_task", skewed_verify_task);
+    COERCE_ERROR(engine.initialize());
+    {
+      UninitializeGuard guard(&engine);
+      COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous(
+        "skewed_verify_task",
+        &rounds,
+        sizeof(rounds)));
+      COERCE_ERROR(engine.uninitialize());
+    }
+  }
+  cleanup_test(options);
+}
+
 }  // namespace log
 }  // namespace foedus
 
@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+
+#include "foedus/engine.hpp"
+#include "foedus/engine_options.hpp"
+#include "foedus/epoch.hpp"
+#include "foedus/test_common.hpp"
+#include "foedus/log/log_manager.hpp"
+#include "foedus/log/log_shipper.hpp"
+#include "foedus/proc/proc_manager.hpp"
+#include "foedus/snapshot/snapshot_manager.hpp"
+#include "foedus/storage/storage_manager.hpp"
+#include "foedus/storage/array/array_metadata.hpp"
+#include "foedus/storage/array/array_storage.hpp"
+#include "foedus/thread/thread.hpp"
+#include "foedus/thread/thread_pool.hpp"
+#include "foedus/xct/xct_manager.hpp"
+
+/**
+ * @file test_log_shipper.cpp
+ * Testcases for LogShipper, failing over to the standby image it ships.
+ */
+namespace foedus {
+namespace log {
+DEFINE_TEST_CASE_PACKAGE(LogShipperTest, foedus.log);
+
+const storage::array::ArrayOffset kRecords = 300;
+
+/** Input of write_task: overwrites records [from, to) with value offset * multiplier. */
+struct WriteInput {
+  storage::array::ArrayOffset from_;
+  storage::array::ArrayOffset to_;
+  uint64_t                    multiplier_;
+};
+
+ErrorStack write_task(const proc::ProcArguments& args) {
+  const WriteInput* input = reinterpret_cast<const WriteInput*>(args.input_buffer_);
+  thread::Thread* context = args.context_;
+  storage::array::ArrayStorage array(args.engine_, "ship");
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  Epoch commit_epoch;
+  for (storage::array::ArrayOffset i = input->from_; i < input->to_; ++i) {
+    CHECK_ERROR(xct_manager->begin_xct(context, xct::kSerializable));
+    CHECK_ERROR(array.overwrite_record_primitive<uint64_t>(context, i, i * input->multiplier_, 0));
+    CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+  }
+  CHECK_ERROR(xct_manager->wait_for_commit(commit_epoch));
+  return kRetOk;
+}
+
+/** Records in the first half have i * 3, the second half i * 5. */
+ErrorStack verify_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  storage::array::ArrayStorage array(args.engine_, "ship");
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  CHECK_ERROR(xct_manager->begin_xct(context, xct::kSerializable));
+  for (storage::array::ArrayOffset i = 0; i < kRecords; ++i) {
+    uint64_t value = 0;
+    CHECK_ERROR(array.get_record_primitive<uint64_t>(context, i, &value, 0));
+    EXPECT_EQ(i * (i < kRecords / 2 ? 3U : 5U), value) << i;
+  }
+  Epoch commit_epoch;
+  CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+  return kRetOk;
+}
+
+void write_records(
+  Engine* engine,
+  storage::array::ArrayOffset from,
+  storage::array::ArrayOffset to,
+  uint64_t multiplier) {
+  WriteInput input = {from, to, multiplier};
+  COERCE_ERROR(engine->get_thread_pool()->impersonate_synchronous(
+    "write_task",
+    &input,
+    sizeof(input)));
+}
+
+void create_array(Engine* engine) {
+  storage::array::ArrayMetadata meta("ship", sizeof(uint64_t), kRecords);
+  storage::array::ArrayStorage storage;
+  Epoch epoch;
+  COERCE_ERROR(engine->get_storage_manager()->create_array(&meta, &storage, &epoch));
+}
+
+void fail_over(const EngineOptions& standby_options) {
+  Engine engine(standby_options);
+  engine.get_proc_manager()->pre_register("verify_task", verify_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("verify_task"));
+    COERCE_ERROR(engine.uninitialize());
+  }
+}
+
+TEST(LogShipperTest, ShipAndFailOver) {
+  EngineOptions options = get_tiny_options();
+  EngineOptions standby_options = get_tiny_options();
+  {
+    Engine engine(options);
+    engine.get_proc_manager()->pre_register("write_task", write_task);
+    COERCE_ERROR(engine.initialize());
+    {
+      UninitializeGuard guard(&engine);
+      LogShipper shipper(&engine, standby_options);
+      EXPECT_FALSE(shipper.get_shipped_epoch().is_valid());
+      create_array(&engine);
+      write_records(&engine, 0, kRecords, 3U);
+      COERCE_ERROR(shipper.ship_once());
+      EXPECT_TRUE(shipper.get_shipped_epoch().is_valid());
+      EXPECT_GT(shipper.get_shipped_bytes(), 0U);
+
+      // the standby recovers from the shipped snapshot and the logs after it
+      engine.get_snapshot_manager()->trigger_snapshot_immediate(true);
+      write_records(&engine, kRecords / 2, kRecords, 5U);
+      Epoch durable_epoch = engine.get_log_manager()->get_durable_global_epoch();
+      COERCE_ERROR(shipper.ship_once());
+      EXPECT_GE(shipper.get_shipped_epoch(), durable_epoch);
+
+      // not shipped. lost in the fail over
+      write_records(&engine, 0, kRecords, 7U);
+      COERCE_ERROR(engine.uninitialize());
+    }
+  }
+
+  fail_over(standby_options);
+  cleanup_test(options);
+  cleanup_test(standby_options);
+}
+
+TEST(LogShipperTest, Background) {
+  EngineOptions options = get_tiny_options();
+  EngineOptions standby_options = get_tiny_options();
+  {
+    Engine engine(options);
+    engine.get_proc_manager()->pre_register("write_task", write_task);
+    COERCE_ERROR(engine.initialize());
+    {
+      UninitializeGuard guard(&engine);
+      LogShipper shipper(&engine, standby_options);
+      EXPECT_GT(shipper.get_lag_epochs(), 0U);
+      shipper.start(10);
+      EXPECT_TRUE(shipper.is_running());
+      create_array(&engine);
+      write_records(&engine, 0, kRecords / 2, 3U);
+      engine.get_snapshot_manager()->trigger_snapshot_immediate(true);
+      write_records(&engine, kRecords / 2, kRecords, 5U);
+      Epoch durable_epoch = engine.get_log_manager()->get_durable_global_epoch();
+      for (uint32_t rep = 0; rep < 1000U; ++rep) {
+        Epoch shipped = shipper.get_shipped_epoch();
+        if (shipped.is_valid() && shipped >= durable_epoch) {
+          break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
+      EXPECT_GE(shipper.get_shipped_epoch(), durable_epoch);
+      COERCE_ERROR(shipper.stop());
+      EXPECT_FALSE(shipper.is_running());
+      uint32_t lag = shipper.get_lag_epochs();
+      Epoch now = engine.get_log_manager()->get_durable_global_epoch();
+      EXPECT_LE(lag, now.subtract(durable_epoch));
+      COERCE_ERROR(engine.uninitialize());
+    }
+  }
+
+  fail_over(standby_options);
+  cleanup_test(options);
+  cleanup_test(standby_options);
+}
+
+}  // namespace log
+}  // namespace foedus
+
+TEST_MAIN_CAPTURE_SIGNALS(LogShipperTest, foedus.log);
@@ -0,0 +1,299 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <fstream>
+#include <string>
+
+#include "foedus/engine.hpp"
+#include "foedus/engine_options.hpp"
+#include "foedus/epoch.hpp"
+#include "foedus/test_common.hpp"
+#include "foedus/fs/filesystem.hpp"
+#include "foedus/log/log_options.hpp"
+#include "foedus/log/log_sink.hpp"
+#include "foedus/log/striped_log_file.hpp"
+#include "foedus/memory/aligned_memory.hpp"
+#include "foedus/proc/proc_manager.hpp"
+#include "foedus/storage/storage_manager.hpp"
+#include "foedus/storage/array/array_metadata.hpp"
+#include "foedus/storage/array/array_storage.hpp"
+#include "foedus/thread/thread.hpp"
+#include "foedus/thread/thread_pool.hpp"
+#include "foedus/xct/xct_manager.hpp"
+
+/**
+ * @file test_log_sink.cpp
+ * Testcases for MmapLogSink and StripedLogSink.
+ */
+namespace foedus {
+namespace log {
+DEFINE_TEST_CASE_PACKAGE(LogSinkTest, foedus.log);
+
+const uint64_t kUnit = 1 << 12;
+
+fs::Path prepare_sink_path(const EngineOptions& options) {
+  fs::Path path(options.log_.construct_suffixed_log_path(0, 0, 0));
+  fs::create_directories(path.parent_path());
+  return path;
+}
+
+void fill_block(memory::AlignedMemory* block, char value) {
+  std::memset(block->get_block(), value, block->get_size());
+}
+
+TEST(LogSinkTest, MmapWriteAndReopen) {
+  EngineOptions options = get_tiny_options();
+  fs::Path path = prepare_sink_path(options);
+  fs::Path header_path = MmapLogSink::get_header_path(path);
+  memory::AlignedMemory block(kUnit * 2, kUnit, memory::AlignedMemory::kPosixMemalign, 0);
+  {
+    MmapLogSink sink(path, false);
+    EXPECT_EQ(kErrorCodeOk, sink.open());
+    EXPECT_EQ(0, sink.get_current_offset());
+    EXPECT_TRUE(fs::exists(header_path));
+    fill_block(&block, 'a');
+    EXPECT_EQ(kErrorCodeOk, sink.write(block.get_size(), block.get_block()));
+    EXPECT_EQ(kErrorCodeOk, sink.sync());
+    fill_block(&block, 'b');
+    EXPECT_EQ(kErrorCodeOk, sink.write(kUnit, block.get_block()));
+    EXPECT_EQ(kUnit * 3, sink.get_current_offset());
+    // while open, the file is larger than logs
+    EXPECT_GE(fs::file_size(path), MmapLogSink::kExtentSize);
+    sink.close();
+  }
+  // once closed, the file is just an ordinary log file
+  EXPECT_EQ(kUnit * 3, fs::file_size(path));
+  EXPECT_FALSE(fs::exists(header_path));
+  {
+    std::ifstream file(path.string(), std::ifstream::binary);
+    std::string content(kUnit * 3, '\0');
+    file.read(&content[0], content.size());
+    EXPECT_EQ(std::string(kUnit * 2, 'a'), content.substr(0, kUnit * 2));
+    EXPECT_EQ(std::string(kUnit, 'b'), content.substr(kUnit * 2));
+  }
+
+  {
+    MmapLogSink sink(path, false);
+    EXPECT_EQ(kErrorCodeOk, sink.open());
+    EXPECT_EQ(kUnit * 3, sink.get_current_offset());
+    EXPECT_EQ(kErrorCodeOk, sink.write(kUnit, block.get_block()));
+    EXPECT_EQ(kErrorCodeOk, sink.truncate(kUnit * 2));
+    EXPECT_EQ(kUnit * 2, sink.get_current_offset());
+  }
+  EXPECT_EQ(kUnit * 2, fs::file_size(path));
+  EXPECT_FALSE(fs::exists(header_path));
+  cleanup_test(options);
+}
+
+TEST(LogSinkTest, MmapCrashedHeader) {
+  EngineOptions options = get_tiny_options();
+  fs::Path path = prepare_sink_path(options);
+  fs::Path header_path = MmapLogSink::get_header_path(path);
+  // emulate a crash while the file was open: the file has a garbage tail after durable logs
+  {
+    std::ofstream file(path.string(), std::ofstream::binary);
+    std::string content(kUnit * 4, 'x');
+    file.write(content.data(), content.size());
+    std::ofstream header_file(header_path.string(), std::ofstream::binary);
+    MmapLogSink::Header header = {MmapLogSink::kHeaderMagicWord, kUnit};
+    header_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  }
+  {
+    MmapLogSink sink(path, false);
+    EXPECT_EQ(kErrorCodeOk, sink.open());
+    EXPECT_EQ(kUnit, sink.get_current_offset());
+  }
+  EXPECT_EQ(kUnit, fs::file_size(path));
+  EXPECT_FALSE(fs::exists(header_path));
+  cleanup_test(options);
+}
+
+EngineOptions get_striped_options() {
+  EngineOptions options = get_tiny_options();
+  std::string pattern = options.log_.folder_path_pattern_.str() + "/stripe_$STRIPE$";
+  options.log_.folder_path_pattern_.assign(pattern);
+  options.log_.log_stripes_ = 3;
+  options.log_.log_stripe_unit_kb_ = kUnit >> 10;
+  return options;
+}
+
+uint64_t get_stripe_size(const EngineOptions& options, uint16_t stripe) {
+  return fs::file_size(fs::Path(options.log_.construct_suffixed_log_path(0, 0, 0, stripe)));
+}
+
+TEST(LogSinkTest, StripeLayout) {
+  LogStripeLayout layout(3, kUnit);
+  EXPECT_EQ(0, layout.to_stripe(0));
+  EXPECT_EQ(0, layout.to_stripe(kUnit - 8U));
+  EXPECT_EQ(1, layout.to_stripe(kUnit));
+  EXPECT_EQ(0, layout.to_stripe(kUnit * 3));
+  EXPECT_EQ(kUnit + 8U, layout.to_stripe_offset(kUnit * 3 + 8U));
+  EXPECT_EQ(kUnit * 2, layout.get_stripe_length(kUnit * 5, 0));
+  EXPECT_EQ(kUnit * 2, layout.get_stripe_length(kUnit * 5, 1));
+  EXPECT_EQ(kUnit, layout.get_stripe_length(kUnit * 5, 2));
+  EXPECT_EQ(0, layout.get_stripe_length(kUnit, 2));
+}
+
+TEST(LogSinkTest, StripedWriteAndRead) {
+  EngineOptions options = get_striped_options();
+  for (uint16_t stripe = 0; stripe < options.log_.log_stripes_; ++stripe) {
+    fs::create_directories(fs::Path(options.log_.convert_folder_path_pattern(0, 0, stripe)));
+  }
+  // each unit is filled with a different character
+  memory::AlignedMemory block(kUnit * 3, kUnit, memory::AlignedMemory::kPosixMemalign, 0);
+  char* data = reinterpret_cast<char*>(block.get_block());
+  {
+    StripedLogSink sink(options.log_, 0, 0, 0);
+    EXPECT_EQ(kErrorCodeOk, sink.open());
+    EXPECT_EQ(0, sink.get_current_offset());
+    std::memset(data, 'a', kUnit);
+    std::memset(data + kUnit, 'b', kUnit);
+    EXPECT_EQ(kErrorCodeOk, sink.write(kUnit * 2, data));
+    std::memset(data, 'c', kUnit);
+    std::memset(data + kUnit, 'd', kUnit);
+    std::memset(data + kUnit * 2, 'e', kUnit);
+    EXPECT_EQ(kErrorCodeOk, sink.write(kUnit * 3, data));
+    EXPECT_EQ(kErrorCodeOk, sink.sync());
+    EXPECT_EQ(kUnit * 5, sink.get_current_offset());
+    EXPECT_EQ(kUnit * 2, get_stripe_size(options, 0));
+    EXPECT_EQ(kUnit * 2, get_stripe_size(options, 1));
+    EXPECT_EQ(kUnit, get_stripe_size(options, 2));
+    EXPECT_EQ(kErrorCodeOk, sink.truncate(kUnit * 4));
+    EXPECT_EQ(kUnit * 4, sink.get_current_offset());
+    sink.close();
+  }
+  EXPECT_EQ(kUnit * 4, StripedLogFile::get_file_size(options.log_, 0, 0, 0));
+  {
+    StripedLogSink sink(options.log_, 0, 0, 0);
+    EXPECT_EQ(kErrorCodeOk, sink.open());
+    EXPECT_EQ(kUnit * 4, sink.get_current_offset());
+  }
+
+  // the reader reassembles the stripes
+  StripedLogFile file(options.log_, 0, 0, 0, options.log_.emulation_);
+  EXPECT_EQ(kErrorCodeOk, file.open());
+  EXPECT_EQ(kUnit * 4, file.get_size());
+  EXPECT_EQ(kErrorCodeOk, file.read(kUnit, kUnit * 3, data));
+  EXPECT_EQ(std::string(kUnit, 'b'), std::string(data, kUnit));
+  EXPECT_EQ(std::string(kUnit, 'c'), std::string(data + kUnit, kUnit));
+  EXPECT_EQ(std::string(kUnit, 'd'), std::string(data + kUnit * 2, kUnit));
+  file.close();
+  cleanup_test(options);
+}
+
+const storage::array::ArrayOffset kRecords = 300;
+
+ErrorStack insert_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  storage::array::ArrayStorage array(args.engine_, "sink");
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  Epoch commit_epoch;
+  for (storage::array::ArrayOffset i = 0; i < kRecords; ++i) {
+    CHECK_ERROR(xct_manager->begin_xct(context, xct::kSerializable));
+    CHECK_ERROR(array.overwrite_record_primitive<uint64_t>(context, i, i * 5U, 0));
+    CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+  }
+  CHECK_ERROR(xct_manager->wait_for_commit(commit_epoch));
+  return kRetOk;
+}
+
+ErrorStack verify_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  storage::array::ArrayStorage array(args.engine_, "sink");
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  CHECK_ERROR(xct_manager->begin_xct(context, xct::kSerializable));
+  for (storage::array::ArrayOffset i = 0; i < kRecords; ++i) {
+    uint64_t value = 0;
+    CHECK_ERROR(array.get_record_primitive<uint64_t>(context, i, &value, 0));
+    EXPECT_EQ(i * 5U, value) << i;
+  }
+  Epoch commit_epoch;
+  CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+  return kRetOk;
+}
+
+TEST(LogSinkTest, MmapRestart) {
+  EngineOptions options = get_tiny_options();
+  options.log_.sink_type_ = LogOptions::kLogSinkMmap;
+  {
+    Engine engine(options);
+    engine.get_proc_manager()->pre_register("insert_task", insert_task);
+    COERCE_ERROR(engine.initialize());
+    {
+      UninitializeGuard guard(&engine);
+      storage::array::ArrayMetadata meta("sink", sizeof(uint64_t), kRecords);
+      storage::array::ArrayStorage storage;
+      Epoch epoch;
+      COERCE_ERROR(engine.get_storage_manager()->create_array(&meta, &storage, &epoch));
+      COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("insert_task"));
+      COERCE_ERROR(engine.uninitialize());
+    }
+  }
+
+  // The logs written by MmapLogSink are read by the usual restart, even with the default sink
+  options.log_.sink_type_ = LogOptions::kLogSinkDirectIo;
+  {
+    Engine engine(options);
+    engine.get_proc_manager()->pre_register("verify_task", verify_task);
+    COERCE_ERROR(engine.initialize());
+    {
+      UninitializeGuard guard(&engine);
+      COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("verify_task"));
+      COERCE_ERROR(engine.uninitialize());
+    }
+  }
+  cleanup_test(options);
+}
+
+TEST(LogSinkTest, StripedRestart) {
+  EngineOptions options = get_striped_options();
+  {
+    Engine engine(options);
+    engine.get_proc_manager()->pre_register("insert_task", insert_task);
+    COERCE_ERROR(engine.initialize());
+    {
+      UninitializeGuard guard(&engine);
+      storage::array::ArrayMetadata meta("sink", sizeof(uint64_t), kRecords);
+      storage::array::ArrayStorage storage;
+      Epoch epoch;
+      COERCE_ERROR(engine.get_storage_manager()->create_array(&meta, &storage, &epoch));
+      COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("insert_task"));
+      COERCE_ERROR(engine.uninitialize());
+    }
+  }
+
+  // restart reads the striped log files
+  {
+    Engine engine(options);
+    engine.get_proc_manager()->pre_register("verify_task", verify_task);
+    COERCE_ERROR(engine.initialize());
+    {
+      UninitializeGuard guard(&engine);
+      COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("verify_task"));
+      COERCE_ERROR(engine.uninitialize());
+    }
+  }
+  cleanup_test(options);
+}
+
+}  // namespace log
+}  // namespace foedus
+
+TEST_MAIN_CAPTURE_SIGNALS(LogSinkTest, foedus.log);
@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "foedus/engine.hpp"
+#include "foedus/engine_options.hpp"
+#include "foedus/test_common.hpp"
+#include "foedus/fs/filesystem.hpp"
+#include "foedus/proc/proc_manager.hpp"
+#include "foedus/soc/shared_memory_repo.hpp"
+#include "foedus/soc/soc_manager.hpp"
+#include "foedus/storage/storage_manager.hpp"
+#include "foedus/storage/masstree/masstree_metadata.hpp"
+#include "foedus/storage/masstree/masstree_storage.hpp"
+#include "foedus/thread/thread.hpp"
+#include "foedus/thread/thread_pool.hpp"
+#include "foedus/xct/xct_manager.hpp"
+
+/**
+ * @file test_restart_warm.cpp
+ * Testcases for warm restart, which re-attaches shared memories retained at clean shutdown.
+ */
+namespace foedus {
+namespace restart {
+DEFINE_TEST_CASE_PACKAGE(RestartWarmTest, foedus.restart);
+
+struct KeyRange {
+  uint64_t from_;
+  uint64_t to_;
+};
+
+ErrorStack insert_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  const KeyRange* range = reinterpret_cast<const KeyRange*>(args.input_buffer_);
+  storage::masstree::MasstreeStorage masstree(args.engine_, "warm");
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  CHECK_ERROR(xct_manager->begin_xct(context, xct::kSerializable));
+  for (uint64_t key = range->from_; key < range->to_; ++key) {
+    uint64_t payload = key * 3U;
+    CHECK_ERROR(masstree.insert_record_normalized(context, key, &payload, sizeof(payload)));
+  }
+  Epoch commit_epoch;
+  CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+  return kRetOk;
+}
+
+ErrorStack verify_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  const KeyRange* range = reinterpret_cast<const KeyRange*>(args.input_buffer_);
+  storage::masstree::MasstreeStorage masstree(args.engine_, "warm");
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  CHECK_ERROR(xct_manager->begin_xct(context, xct::kSerializable));
+  for (uint64_t key = range->from_; key < range->to_; ++key) {
+    uint64_t payload = 0;
+    CHECK_ERROR(masstree.get_record_primitive_normalized<uint64_t>(
+      context,
+      key,
+      &payload,
+      0,
+      true));
+    EXPECT_EQ(key * 3U, payload) << key;
+  }
+  uint64_t payload = 0;
+  EXPECT_EQ(
+    kErrorCodeStrKeyNotFound,
+    masstree.get_record_primitive_normalized<uint64_t>(context, range->to_, &payload, 0, true));
+  Epoch commit_epoch;
+  CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+  return kRetOk;
+}
+
+EngineOptions get_warm_options() {
+  EngineOptions options = get_tiny_options();
+  // rigorous boundary checks disable warm restart
+  options.memory_.rigorous_memory_boundary_check_ = false;
+  options.memory_.rigorous_page_boundary_check_ = false;
+  options.restart_.enable_warm_restart_ = true;
+  return options;
+}
+
+bool is_warm_restarted(Engine* engine) {
+  return engine->get_soc_manager()->get_shared_memory_repo()->is_warm_restarted();
+}
+
+/** Runs one engine. Verifies keys before the range unless create, then inserts the range. */
+void run_engine(const EngineOptions& options, bool expect_warm, bool create, KeyRange range) {
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("insert_task", insert_task);
+  engine.get_proc_manager()->pre_register("verify_task", verify_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    EXPECT_EQ(expect_warm, is_warm_restarted(&engine));
+    if (create) {
+      storage::masstree::MasstreeMetadata meta("warm");
+      storage::masstree::MasstreeStorage out;
+      Epoch commit_epoch;
+      COERCE_ERROR(engine.get_storage_manager()->create_masstree(&meta, &out, &commit_epoch));
+      EXPECT_TRUE(out.exists());
+    } else {
+      KeyRange existing = {0, range.from_};
+      COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous(
+        "verify_task",
+        &existing,
+        sizeof(existing)));
+    }
+    COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous(
+      "insert_task",
+      &range,
+      sizeof(range)));
+    COERCE_ERROR(engine.uninitialize());
+  }
+}
+
+TEST(RestartWarmTest, Reattach) {
+  EngineOptions options = get_warm_options();
+  fs::Path manifest_path(options.restart_.warm_restart_manifest_path_.str());
+  KeyRange first = {0, 100};
+  run_engine(options, false, true, first);
+  EXPECT_TRUE(fs::exists(manifest_path));
+
+  KeyRange second = {100, 200};
+  run_engine(options, true, false, second);
+  EXPECT_TRUE(fs::exists(manifest_path));
+
+  // Without warm restart, the engine reclaims the retained memories and recovers from logs.
+  EngineOptions cold_options = options;
+  cold_options.restart_.enable_warm_restart_ = false;
+  KeyRange third = {200, 300};
+  run_engine(cold_options, false, false, third);
+  EXPECT_FALSE(fs::exists(manifest_path));
+  cleanup_test(options);
+}
+
+TEST(RestartWarmTest, LayoutChanged) {
+  EngineOptions options = get_warm_options();
+  KeyRange first = {0, 100};
+  run_engine(options, false, true, first);
+
+  // The retained memories are not reusable. Falls back to cold restart.
+  EngineOptions changed_options = options;
+  changed_options.storage_.max_storages_ += 16U;
+  KeyRange second = {100, 200};
+  run_engine(changed_options, false, false, second);
+
+  // this time the layout is the same
+  KeyRange third = {200, 300};
+  run_engine(changed_options, true, false, third);
+
+  // reclaim the retained memories before we remove the manifest
+  changed_options.restart_.enable_warm_restart_ = false;
+  {
+    Engine engine(changed_options);
+    COERCE_ERROR(engine.initialize());
+    UninitializeGuard guard(&engine);
+    EXPECT_FALSE(is_warm_restarted(&engine));
+    COERCE_ERROR(engine.uninitialize());
+  }
+  EXPECT_FALSE(fs::exists(fs::Path(options.restart_.warm_restart_manifest_path_.str())));
+  cleanup_test(options);
+}
+
+}  // namespace restart
+}  // namespace foedus
+
+TEST_MAIN_CAPTURE_SIGNALS(RestartWarmTest, foedus.restart);
@@ -0,0 +1,226 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "foedus/engine.hpp"
+#include "foedus/engine_options.hpp"
+#include "foedus/epoch.hpp"
+#include "foedus/test_common.hpp"
+#include "foedus/proc/proc_manager.hpp"
+#include "foedus/snapshot/snapshot_manager.hpp"
+#include "foedus/snapshot/snapshot_view.hpp"
+#include "foedus/storage/storage_manager.hpp"
+#include "foedus/storage/array/array_metadata.hpp"
+#include "foedus/storage/array/array_storage.hpp"
+#include "foedus/storage/masstree/masstree_metadata.hpp"
+#include "foedus/storage/masstree/masstree_storage.hpp"
+#include "foedus/thread/thread.hpp"
+#include "foedus/thread/thread_pool.hpp"
+#include "foedus/xct/xct_manager.hpp"
+
+/**
+ * @file test_snapshot_composers.cpp
+ * Testcases for reducers that compose storages with more than one thread.
+ */
+namespace foedus {
+namespace snapshot {
+DEFINE_TEST_CASE_PACKAGE(SnapshotComposersTest, foedus.snapshot);
+
+const uint16_t kComposers = 3;
+const uint32_t kArrays = 4;
+const uint32_t kMasstrees = 2;
+/** Enough to make the reducers dump a few sorted runs. */
+const uint32_t kArrayRecords = 8192;
+const uint32_t kMasstreeRecords = 64;
+
+uint64_t to_value(uint64_t version, uint32_t storage, uint32_t i) {
+  return version * 1000000000ULL + storage * 1000000ULL + i;
+}
+
+storage::StorageName to_name(const std::string& prefix, uint32_t storage) {
+  std::string str = prefix + std::to_string(storage);
+  return storage::StorageName(str.data(), str.size());
+}
+storage::StorageName array_name(uint32_t storage) { return to_name("array", storage); }
+storage::StorageName masstree_name(uint32_t storage) { return to_name("masstree", storage); }
+
+/** Overwrites all records with version-N. Version-1 inserts to masstrees. */
+ErrorStack write_task(const proc::ProcArguments& args) {
+  const uint64_t version = *reinterpret_cast<const uint64_t*>(args.input_buffer_);
+  thread::Thread* context = args.context_;
+  storage::StorageManager* storages = args.engine_->get_storage_manager();
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  Epoch commit_epoch;
+  for (uint32_t s = 0; s < kArrays; ++s) {
+    storage::array::ArrayStorage array = storages->get_array(array_name(s));
+    for (uint32_t i = 0; i < kArrayRecords; ++i) {
+      WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+      WRAP_ERROR_CODE(array.overwrite_record_primitive<uint64_t>(
+        context,
+        i,
+        to_value(version, s, i),
+        0));
+      WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+    }
+  }
+  for (uint32_t s = 0; s < kMasstrees; ++s) {
+    storage::masstree::MasstreeStorage masstree = storages->get_masstree(masstree_name(s));
+    for (uint32_t i = 0; i < kMasstreeRecords; ++i) {
+      const uint64_t value = to_value(version, s, i);
+      WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+      if (version == 1U) {
+        WRAP_ERROR_CODE(masstree.insert_record_normalized(context, i, &value, sizeof(value)));
+      } else {
+        WRAP_ERROR_CODE(masstree.overwrite_record_primitive_normalized<uint64_t>(
+          context,
+          i,
+          value,
+          0));
+      }
+      WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+    }
+  }
+  WRAP_ERROR_CODE(xct_manager->wait_for_commit(commit_epoch));
+  return kRetOk;
+}
+
+struct VerifyInput {
+  SnapshotId  snapshot_id_;
+  uint64_t    version_;
+};
+
+/** Reads the snapshot, which must contain exactly version-N in all storages. */
+ErrorStack verify_task(const proc::ProcArguments& args) {
+  const VerifyInput* input = reinterpret_cast<const VerifyInput*>(args.input_buffer_);
+  thread::Thread* context = args.context_;
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  SnapshotView view(args.engine_);
+  CHECK_ERROR(view.open(input->snapshot_id_));
+  WRAP_ERROR_CODE(view.begin_xct(context));
+  for (uint32_t s = 0; s < kArrays; ++s) {
+    storage::array::ArrayStorage array = view.get_array(array_name(s));
+    for (uint32_t i = 0; i < kArrayRecords; ++i) {
+      uint64_t value = 0;
+      WRAP_ERROR_CODE(array.get_record_primitive<uint64_t>(context, i, &value, 0));
+      EXPECT_EQ(to_value(input->version_, s, i), value) << s << ":" << i;
+    }
+  }
+  for (uint32_t s = 0; s < kMasstrees; ++s) {
+    storage::masstree::MasstreeStorage masstree = view.get_masstree(masstree_name(s));
+    for (uint32_t i = 0; i < kMasstreeRecords; ++i) {
+      uint64_t value = 0;
+      WRAP_ERROR_CODE(masstree.get_record_primitive_normalized<uint64_t>(
+        context,
+        i,
+        &value,
+        0,
+        true));
+      EXPECT_EQ(to_value(input->version_, s, i), value) << s << ":" << i;
+    }
+  }
+  Epoch commit_epoch;
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  return kRetOk;
+}
+
+void create_storages(Engine* engine) {
+  storage::StorageManager* storages = engine->get_storage_manager();
+  Epoch epoch;
+  // keep volatile pages so that we can keep writing across snapshots
+  const uint32_t kKeepAll = 0xFFFFFFFFU;
+  for (uint32_t s = 0; s < kArrays; ++s) {
+    storage::array::ArrayMetadata meta(array_name(s), sizeof(uint64_t), kArrayRecords);
+    meta.snapshot_thresholds_.snapshot_keep_threshold_ = kKeepAll;
+    storage::array::ArrayStorage array;
+    COERCE_ERROR(storages->create_array(&meta, &array, &epoch));
+  }
+  for (uint32_t s = 0; s < kMasstrees; ++s) {
+    storage::masstree::MasstreeMetadata meta(masstree_name(s));
+    meta.snapshot_thresholds_.snapshot_keep_threshold_ = kKeepAll;
+    storage::masstree::MasstreeStorage masstree;
+    COERCE_ERROR(storages->create_masstree(&meta, &masstree, &epoch));
+  }
+}
+
+SnapshotId write_and_snapshot(Engine* engine, uint64_t version) {
+  COERCE_ERROR(engine->get_thread_pool()->impersonate_synchronous(
+    "write_task",
+    &version,
+    sizeof(version)));
+  engine->get_snapshot_manager()->trigger_snapshot_immediate(true);
+  return engine->get_snapshot_manager()->get_previous_snapshot_id();
+}
+
+void verify(Engine* engine, SnapshotId snapshot_id, uint64_t version) {
+  VerifyInput input = {snapshot_id, version};
+  COERCE_ERROR(engine->get_thread_pool()->impersonate_synchronous(
+    "verify_task",
+    &input,
+    sizeof(input)));
+}
+
+void test_composers(bool two_nodes) {
+  EngineOptions options = get_tiny_options();
+  options.snapshot_.log_reducer_composers_ = kComposers;
+  // small read buffers so that composers jump over storages taken by others
+  options.snapshot_.log_reducer_read_io_buffer_kb_ = 128;
+  if (two_nodes) {
+    options.thread_.thread_count_per_group_ = 1;
+    options.thread_.group_count_ = 2;
+    options.log_.loggers_per_node_ = 1;
+  }
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("write_task", write_task);
+  engine.get_proc_manager()->pre_register("verify_task", verify_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    create_storages(&engine);
+    SnapshotId first = write_and_snapshot(&engine, 1U);
+    verify(&engine, first, 1U);
+
+    // the second snapshot reads pages in shards of the first one
+    SnapshotId second = write_and_snapshot(&engine, 2U);
+    EXPECT_NE(first, second);
+    verify(&engine, second, 2U);
+    verify(&engine, first, 1U);
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+TEST(SnapshotComposersTest, OneNode) { test_composers(false); }
+TEST(SnapshotComposersTest, TwoNodes) { test_composers(true); }
+
+TEST(SnapshotComposersTest, InvalidOption) {
+  EngineOptions options = get_tiny_options();
+  options.snapshot_.log_reducer_composers_ = storage::kMaxSnapshotShards + 1U;
+  Engine engine(options);
+  ErrorStack ret = engine.initialize();
+  EXPECT_TRUE(ret.is_error());
+  EXPECT_EQ(kErrorCodeConfValueOutofrange, ret.get_error_code());
+  COERCE_ERROR(engine.uninitialize());
+  cleanup_test(options);
+}
+
+}  // namespace snapshot
+}  // namespace foedus
+
+TEST_MAIN_CAPTURE_SIGNALS(SnapshotComposersTest, foedus.snapshot);
@@ -0,0 +1,232 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+
+#include "foedus/engine.hpp"
+#include "foedus/engine_options.hpp"
+#include "foedus/epoch.hpp"
+#include "foedus/test_common.hpp"
+#include "foedus/proc/proc_manager.hpp"
+#include "foedus/snapshot/snapshot_manager.hpp"
+#include "foedus/snapshot/snapshot_view.hpp"
+#include "foedus/storage/storage_manager.hpp"
+#include "foedus/storage/array/array_metadata.hpp"
+#include "foedus/storage/array/array_storage.hpp"
+#include "foedus/storage/masstree/masstree_metadata.hpp"
+#include "foedus/storage/masstree/masstree_storage.hpp"
+#include "foedus/thread/thread.hpp"
+#include "foedus/thread/thread_pool.hpp"
+#include "foedus/xct/xct_manager.hpp"
+
+/**
+ * @file test_snapshot_pregleaning.cpp
+ * Testcases for snapshots taken on top of logs pre-gleaned between snapshots.
+ */
+namespace foedus {
+namespace snapshot {
+DEFINE_TEST_CASE_PACKAGE(SnapshotPregleaningTest, foedus.snapshot);
+
+const uint32_t kRecords = 64;
+/** Long enough for a few pre-gleaning rounds to happen. */
+const uint32_t kPregleaningWaitMs = 200;
+
+uint64_t to_value(uint64_t version, uint32_t i) { return version * 1000U + i; }
+
+struct WriteInput {
+  uint64_t  version_;
+  uint32_t  records_;
+};
+
+/** Overwrites all records with version-N. Version-1 inserts to masstree. */
+ErrorStack write_task(const proc::ProcArguments& args) {
+  const WriteInput* input = reinterpret_cast<const WriteInput*>(args.input_buffer_);
+  thread::Thread* context = args.context_;
+  storage::StorageManager* storages = args.engine_->get_storage_manager();
+  storage::array::ArrayStorage array = storages->get_array("array");
+  storage::masstree::MasstreeStorage masstree = storages->get_masstree("masstree");
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  Epoch commit_epoch;
+  for (uint32_t i = 0; i < input->records_; ++i) {
+    const uint64_t value = to_value(input->version_, i);
+    WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+    WRAP_ERROR_CODE(array.overwrite_record_primitive<uint64_t>(context, i, value, 0));
+    if (input->version_ == 1U) {
+      WRAP_ERROR_CODE(masstree.insert_record_normalized(context, i, &value, sizeof(value)));
+    } else {
+      WRAP_ERROR_CODE(masstree.overwrite_record_primitive_normalized<uint64_t>(
+        context,
+        i,
+        value,
+        0));
+    }
+    WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  }
+  WRAP_ERROR_CODE(xct_manager->wait_for_commit(commit_epoch));
+  return kRetOk;
+}
+
+struct VerifyInput {
+  SnapshotId  snapshot_id_;
+  uint64_t    version_;
+  uint32_t    records_;
+};
+
+/** Reads the snapshot, which must contain exactly version-N. */
+ErrorStack verify_task(const proc::ProcArguments& args) {
+  const VerifyInput* input = reinterpret_cast<const VerifyInput*>(args.input_buffer_);
+  thread::Thread* context = args.context_;
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  SnapshotView view(args.engine_);
+  CHECK_ERROR(view.open(input->snapshot_id_));
+  storage::array::ArrayStorage array = view.get_array("array");
+  storage::masstree::MasstreeStorage masstree = view.get_masstree("masstree");
+  WRAP_ERROR_CODE(view.begin_xct(context));
+  for (uint32_t i = 0; i < input->records_; ++i) {
+    uint64_t value = 0;
+    WRAP_ERROR_CODE(array.get_record_primitive<uint64_t>(context, i, &value, 0));
+    EXPECT_EQ(to_value(input->version_, i), value) << i;
+    value = 0;
+    WRAP_ERROR_CODE(masstree.get_record_primitive_normalized<uint64_t>(
+      context,
+      i,
+      &value,
+      0,
+      true));
+    EXPECT_EQ(to_value(input->version_, i), value) << i;
+  }
+  Epoch commit_epoch;
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  return kRetOk;
+}
+
+EngineOptions get_pregleaning_options(bool two_nodes) {
+  EngineOptions options = get_tiny_options();
+  options.snapshot_.log_pregleaning_interval_milliseconds_ = 10;
+  if (two_nodes) {
+    options.thread_.thread_count_per_group_ = 1;
+    options.thread_.group_count_ = 2;
+    options.log_.loggers_per_node_ = 1;
+  }
+  return options;
+}
+
+void create_storages(Engine* engine, uint32_t records) {
+  storage::StorageManager* storages = engine->get_storage_manager();
+  Epoch epoch;
+  // keep volatile pages so that we can keep writing across snapshots
+  const uint32_t kKeepAll = 0xFFFFFFFFU;
+  storage::array::ArrayMetadata array_meta("array", sizeof(uint64_t), records);
+  array_meta.snapshot_thresholds_.snapshot_keep_threshold_ = kKeepAll;
+  storage::array::ArrayStorage array;
+  COERCE_ERROR(storages->create_array(&array_meta, &array, &epoch));
+  storage::masstree::MasstreeMetadata masstree_meta("masstree");
+  masstree_meta.snapshot_thresholds_.snapshot_keep_threshold_ = kKeepAll;
+  storage::masstree::MasstreeStorage masstree;
+  COERCE_ERROR(storages->create_masstree(&masstree_meta, &masstree, &epoch));
+}
+
+/** Writes version-N, then gives the snapshot thread time to pre-glean it. */
+void write_version(Engine* engine, uint64_t version, uint32_t records) {
+  WriteInput input = {version, records};
+  COERCE_ERROR(engine->get_thread_pool()->impersonate_synchronous(
+    "write_task",
+    &input,
+    sizeof(input)));
+  std::this_thread::sleep_for(std::chrono::milliseconds(kPregleaningWaitMs));
+}
+
+SnapshotId take_snapshot(Engine* engine) {
+  engine->get_snapshot_manager()->trigger_snapshot_immediate(true);
+  return engine->get_snapshot_manager()->get_previous_snapshot_id();
+}
+
+void verify(Engine* engine, SnapshotId snapshot_id, uint64_t version, uint32_t records) {
+  VerifyInput input = {snapshot_id, version, records};
+  COERCE_ERROR(engine->get_thread_pool()->impersonate_synchronous(
+    "verify_task",
+    &input,
+    sizeof(input)));
+}
+
+void test_overwrites(bool two_nodes) {
+  EngineOptions options = get_pregleaning_options(two_nodes);
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("write_task", write_task);
+  engine.get_proc_manager()->pre_register("verify_task", verify_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    create_storages(&engine, kRecords);
+    // each version is likely in different sorted runs. the snapshot must see the last one.
+    write_version(&engine, 1U, kRecords);
+    write_version(&engine, 2U, kRecords);
+    write_version(&engine, 3U, kRecords);
+    SnapshotId first = take_snapshot(&engine);
+    verify(&engine, first, 3U, kRecords);
+
+    // next snapshot starts over with its own sorted runs
+    write_version(&engine, 4U, kRecords);
+    write_version(&engine, 5U, kRecords);
+    SnapshotId second = take_snapshot(&engine);
+    EXPECT_NE(first, second);
+    verify(&engine, second, 5U, kRecords);
+    verify(&engine, first, 3U, kRecords);
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+TEST(SnapshotPregleaningTest, OneNode) { test_overwrites(false); }
+TEST(SnapshotPregleaningTest, TwoNodes) { test_overwrites(true); }
+
+ErrorStack extend_task(const proc::ProcArguments& args) {
+  storage::array::ArrayStorage array = args.engine_->get_storage_manager()->get_array("array");
+  Epoch commit_epoch;
+  CHECK_ERROR(array.extend(kRecords * 2U, &commit_epoch));
+  WRAP_ERROR_CODE(args.engine_->get_xct_manager()->wait_for_commit(commit_epoch));
+  return kRetOk;
+}
+
+TEST(SnapshotPregleaningTest, Extend) {
+  EngineOptions options = get_pregleaning_options(true);
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("write_task", write_task);
+  engine.get_proc_manager()->pre_register("verify_task", verify_task);
+  engine.get_proc_manager()->pre_register("extend_task", extend_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    create_storages(&engine, kRecords);
+    write_version(&engine, 1U, kRecords);
+    // the pre-gleaned runs are partitioned for the old array. they must be discarded
+    COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("extend_task"));
+    write_version(&engine, 2U, kRecords);
+    SnapshotId snapshot_id = take_snapshot(&engine);
+    verify(&engine, snapshot_id, 2U, kRecords);
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+}  // namespace snapshot
+}  // namespace foedus
+
+TEST_MAIN_CAPTURE_SIGNALS(SnapshotPregleaningTest, foedus.snapshot);
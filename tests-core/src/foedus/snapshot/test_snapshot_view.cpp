@@ -0,0 +1,267 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+#include "foedus/engine.hpp"
+#include "foedus/engine_options.hpp"
+#include "foedus/epoch.hpp"
+#include "foedus/test_common.hpp"
+#include "foedus/memory/aligned_memory.hpp"
+#include "foedus/proc/proc_manager.hpp"
+#include "foedus/snapshot/snapshot_manager.hpp"
+#include "foedus/snapshot/snapshot_view.hpp"
+#include "foedus/storage/storage_manager.hpp"
+#include "foedus/storage/array/array_metadata.hpp"
+#include "foedus/storage/array/array_storage.hpp"
+#include "foedus/storage/hash/hash_metadata.hpp"
+#include "foedus/storage/hash/hash_storage.hpp"
+#include "foedus/storage/masstree/masstree_cursor.hpp"
+#include "foedus/storage/masstree/masstree_metadata.hpp"
+#include "foedus/storage/masstree/masstree_storage.hpp"
+#include "foedus/storage/sequential/sequential_cursor.hpp"
+#include "foedus/storage/sequential/sequential_metadata.hpp"
+#include "foedus/storage/sequential/sequential_storage.hpp"
+#include "foedus/thread/thread.hpp"
+#include "foedus/thread/thread_pool.hpp"
+#include "foedus/xct/xct_manager.hpp"
+
+/**
+ * @file test_snapshot_view.cpp
+ * Testcases for SnapshotView, reading storages as of past snapshots.
+ */
+namespace foedus {
+namespace snapshot {
+DEFINE_TEST_CASE_PACKAGE(SnapshotViewTest, foedus.snapshot);
+
+const uint32_t kRecords = 64;
+
+/** Value of the i-th record written in the given version. */
+uint64_t to_value(uint64_t version, uint32_t i) { return version * 1000U + i; }
+
+/** Writes version-N of all records to all storages. Sequential appends them. */
+ErrorStack write_task(const proc::ProcArguments& args) {
+  const uint64_t version = *reinterpret_cast<const uint64_t*>(args.input_buffer_);
+  thread::Thread* context = args.context_;
+  storage::StorageManager* storages = args.engine_->get_storage_manager();
+  storage::array::ArrayStorage array = storages->get_array("array");
+  storage::hash::HashStorage hash = storages->get_hash("hash");
+  storage::masstree::MasstreeStorage masstree = storages->get_masstree("masstree");
+  storage::sequential::SequentialStorage sequential = storages->get_sequential("sequential");
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  Epoch commit_epoch;
+  for (uint32_t i = 0; i < kRecords; ++i) {
+    const uint64_t value = to_value(version, i);
+    const uint64_t key = i;
+    WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+    WRAP_ERROR_CODE(array.overwrite_record_primitive<uint64_t>(context, i, value, 0));
+    if (version == 1U) {
+      WRAP_ERROR_CODE(hash.insert_record(context, &key, sizeof(key), &value, sizeof(value)));
+      WRAP_ERROR_CODE(masstree.insert_record_normalized(context, key, &value, sizeof(value)));
+    } else {
+      WRAP_ERROR_CODE(hash.overwrite_record_primitive<uint64_t>(context, key, value, 0));
+      WRAP_ERROR_CODE(masstree.overwrite_record_primitive_normalized<uint64_t>(
+        context,
+        key,
+        value,
+        0));
+    }
+    WRAP_ERROR_CODE(sequential.append_record(context, &value, sizeof(value)));
+    WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  }
+  WRAP_ERROR_CODE(xct_manager->wait_for_commit(commit_epoch));
+  return kRetOk;
+}
+
+struct VerifyInput {
+  SnapshotId  snapshot_id_;
+  uint64_t    version_;
+};
+
+/** Reads all storages as of the snapshot, which must see exactly version-N. */
+ErrorStack verify_task(const proc::ProcArguments& args) {
+  const VerifyInput* input = reinterpret_cast<const VerifyInput*>(args.input_buffer_);
+  const uint64_t version = input->version_;
+  thread::Thread* context = args.context_;
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  SnapshotView view(args.engine_);
+  CHECK_ERROR(view.open(input->snapshot_id_));
+  EXPECT_TRUE(view.is_open());
+  EXPECT_EQ(input->snapshot_id_, view.get_snapshot_id());
+  storage::array::ArrayStorage array = view.get_array("array");
+  storage::hash::HashStorage hash = view.get_hash("hash");
+  storage::masstree::MasstreeStorage masstree = view.get_masstree("masstree");
+  storage::sequential::SequentialStorage sequential = view.get_sequential("sequential");
+  EXPECT_TRUE(array.exists());
+  EXPECT_TRUE(hash.exists());
+  EXPECT_TRUE(masstree.exists());
+  EXPECT_TRUE(sequential.exists());
+  EXPECT_FALSE(view.get_array("nonexistent").exists());
+
+  WRAP_ERROR_CODE(view.begin_xct(context));
+  for (uint32_t i = 0; i < kRecords; ++i) {
+    const uint64_t key = i;
+    uint64_t value = 0;
+    WRAP_ERROR_CODE(array.get_record_primitive<uint64_t>(context, i, &value, 0));
+    EXPECT_EQ(to_value(version, i), value) << i;
+    value = 0;
+    WRAP_ERROR_CODE(hash.get_record_primitive<uint64_t>(context, key, &value, 0, true));
+    EXPECT_EQ(to_value(version, i), value) << i;
+    value = 0;
+    WRAP_ERROR_CODE(masstree.get_record_primitive_normalized<uint64_t>(
+      context,
+      key,
+      &value,
+      0,
+      true));
+    EXPECT_EQ(to_value(version, i), value) << i;
+  }
+  EXPECT_EQ(kErrorCodeXctSnapshotOnlyWrite, array.overwrite_record_primitive<uint64_t>(
+    context,
+    0,
+    0,
+    0));
+
+  storage::masstree::MasstreeCursor cursor(masstree, context);
+  WRAP_ERROR_CODE(cursor.open());
+  uint32_t count = 0;
+  while (cursor.is_valid_record()) {
+    EXPECT_EQ(count, cursor.get_normalized_key());
+    uint64_t value;
+    std::memcpy(&value, cursor.get_payload(), sizeof(value));
+    EXPECT_EQ(to_value(version, count), value) << count;
+    ++count;
+    WRAP_ERROR_CODE(cursor.next());
+  }
+  EXPECT_EQ(kRecords, count);
+
+  // sequential storage retains all versions upto the snapshot
+  memory::AlignedMemory buffer;
+  buffer.alloc(1 << 16, 1 << 12, memory::AlignedMemory::kNumaAllocOnnode, 0);
+  storage::sequential::SequentialCursor sequential_cursor(
+    context,
+    sequential,
+    buffer.get_block(),
+    buffer.get_size(),
+    storage::sequential::SequentialCursor::kNodeFirstMode);
+  uint32_t appended = 0;
+  storage::sequential::SequentialRecordIterator it;
+  while (sequential_cursor.is_valid()) {
+    WRAP_ERROR_CODE(sequential_cursor.next_batch(&it));
+    while (it.is_valid()) {
+      uint64_t value;
+      std::memcpy(&value, it.get_cur_record_raw(), sizeof(value));
+      EXPECT_LE(value / 1000U, version);
+      EXPECT_LE(it.get_cur_record_epoch(), view.get_valid_until_epoch());
+      ++appended;
+      it.next();
+    }
+  }
+  EXPECT_EQ(kRecords * version, appended);
+
+  Epoch commit_epoch;
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  EXPECT_EQ(view.get_valid_until_epoch(), commit_epoch);
+  return kRetOk;
+}
+
+void create_storages(Engine* engine) {
+  storage::StorageManager* storages = engine->get_storage_manager();
+  Epoch epoch;
+  // Views read only snapshot pages. Keep volatile pages so that the engine keeps writing
+  // between snapshots without re-installing dropped root pages.
+  const uint32_t kKeepAll = 0xFFFFFFFFU;
+  storage::array::ArrayMetadata array_meta("array", sizeof(uint64_t), kRecords);
+  array_meta.snapshot_thresholds_.snapshot_keep_threshold_ = kKeepAll;
+  storage::array::ArrayStorage array;
+  COERCE_ERROR(storages->create_array(&array_meta, &array, &epoch));
+  storage::hash::HashMetadata hash_meta("hash");
+  hash_meta.snapshot_thresholds_.snapshot_keep_threshold_ = kKeepAll;
+  storage::hash::HashStorage hash;
+  COERCE_ERROR(storages->create_hash(&hash_meta, &hash, &epoch));
+  storage::masstree::MasstreeMetadata masstree_meta("masstree");
+  masstree_meta.snapshot_thresholds_.snapshot_keep_threshold_ = kKeepAll;
+  storage::masstree::MasstreeStorage masstree;
+  COERCE_ERROR(storages->create_masstree(&masstree_meta, &masstree, &epoch));
+  storage::sequential::SequentialMetadata sequential_meta("sequential");
+  storage::sequential::SequentialStorage sequential;
+  COERCE_ERROR(storages->create_sequential(&sequential_meta, &sequential, &epoch));
+}
+
+void write_version(Engine* engine, uint64_t version) {
+  COERCE_ERROR(engine->get_thread_pool()->impersonate_synchronous(
+    "write_task",
+    &version,
+    sizeof(version)));
+}
+
+SnapshotId take_snapshot(Engine* engine) {
+  engine->get_snapshot_manager()->trigger_snapshot_immediate(true);
+  return engine->get_snapshot_manager()->get_previous_snapshot_id();
+}
+
+void verify(Engine* engine, SnapshotId snapshot_id, uint64_t version) {
+  VerifyInput input = {snapshot_id, version};
+  COERCE_ERROR(engine->get_thread_pool()->impersonate_synchronous(
+    "verify_task",
+    &input,
+    sizeof(input)));
+}
+
+TEST(SnapshotViewTest, TimeTravel) {
+  EngineOptions options = get_tiny_options();
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("write_task", write_task);
+  engine.get_proc_manager()->pre_register("verify_task", verify_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    create_storages(&engine);
+    write_version(&engine, 1U);
+    SnapshotId first = take_snapshot(&engine);
+    write_version(&engine, 2U);
+    SnapshotId second = take_snapshot(&engine);
+    EXPECT_NE(first, second);
+    write_version(&engine, 3U);  // only in volatile pages
+    verify(&engine, first, 1U);
+    verify(&engine, second, 2U);
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+TEST(SnapshotViewTest, NotFound) {
+  EngineOptions options = get_tiny_options();
+  Engine engine(options);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    SnapshotView view(&engine);
+    EXPECT_EQ(kErrorCodeSnapshotNotFound, view.open(1).get_error_code());
+    EXPECT_FALSE(view.is_open());
+    EXPECT_EQ(kErrorCodeSnapshotNotFound, view.open(kNullSnapshotId).get_error_code());
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+}  // namespace snapshot
+}  // namespace foedus
+
+TEST_MAIN_CAPTURE_SIGNALS(SnapshotViewTest, foedus.snapshot);
@@ -0,0 +1,217 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include "foedus/engine.hpp"
+#include "foedus/engine_options.hpp"
+#include "foedus/test_common.hpp"
+#include "foedus/proc/proc_manager.hpp"
+#include "foedus/soc/client_ring.hpp"
+#include "foedus/soc/soc_options.hpp"
+
+/**
+ * @file test_client_ring.cpp
+ * Testcases for ClientRing, connecting to the engine like an external process does.
+ */
+namespace foedus {
+namespace soc {
+DEFINE_TEST_CASE_PACKAGE(ClientRingTest, foedus.soc);
+
+const uint64_t kTimeoutUs = 10000000ULL;
+
+ErrorStack increment_task(const proc::ProcArguments& args) {
+  EXPECT_EQ(sizeof(uint64_t), args.input_len_);
+  EXPECT_GE(args.output_buffer_size_, sizeof(uint64_t));
+  uint64_t value;
+  std::memcpy(&value, args.input_buffer_, sizeof(value));
+  ++value;
+  std::memcpy(args.output_buffer_, &value, sizeof(value));
+  *args.output_used_ = sizeof(value);
+  return kRetOk;
+}
+
+EngineOptions get_ring_options(uint32_t slots) {
+  EngineOptions options = get_tiny_options();
+  options.soc_.client_ring_slots_ = slots;
+  options.soc_.client_ring_slot_kb_ = 1;
+  options.soc_.client_ring_batch_size_ = 4;
+  std::string pattern = "/tmp/foedus_test_client_ring_" + get_random_name() + "_$NODE$";
+  options.soc_.client_ring_path_pattern_.assign(pattern);
+  return options;
+}
+
+ClientRing::Ticket submit_increment(ClientRing* ring, uint64_t value) {
+  ClientRing::Ticket ticket = 0;
+  void* input = nullptr;
+  EXPECT_EQ(kErrorCodeOk, ring->reserve(sizeof(value), &ticket, &input));
+  std::memcpy(input, &value, sizeof(value));
+  EXPECT_EQ(kErrorCodeOk, ring->submit(ticket, "increment_task"));
+  return ticket;
+}
+
+void verify_increment(ClientRing* ring, ClientRing::Ticket ticket, uint64_t value) {
+  EXPECT_EQ(kErrorCodeOk, ring->wait(ticket, kTimeoutUs));
+  EXPECT_EQ(kErrorCodeOk, ring->get_result(ticket));
+  EXPECT_EQ(sizeof(uint64_t), ring->get_output_len(ticket));
+  uint64_t output;
+  std::memcpy(&output, ring->get_output(ticket), sizeof(output));
+  EXPECT_EQ(value + 1U, output);
+  ring->release(ticket);
+}
+
+TEST(ClientRingTest, Basic) {
+  EngineOptions options = get_ring_options(64);
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("increment_task", increment_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    ClientRingConnection connection;
+    COERCE_ERROR(connection.connect(options.soc_.convert_client_ring_path_pattern(0)));
+    ClientRing* ring = connection.get_ring();
+    EXPECT_EQ(64U, ring->get_slot_count());
+    const uint32_t kRequests = 40;
+    for (uint32_t rep = 0; rep < 3; ++rep) {
+      ClientRing::Ticket tickets[kRequests];
+      for (uint32_t i = 0; i < kRequests; ++i) {
+        tickets[i] = submit_increment(ring, rep * 1000U + i);
+      }
+      for (uint32_t i = 0; i < kRequests; ++i) {
+        verify_increment(ring, tickets[i], rep * 1000U + i);
+      }
+    }
+    connection.disconnect();
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+TEST(ClientRingTest, Full) {
+  EngineOptions options = get_ring_options(3);  // rounded up to 4
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("increment_task", increment_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    ClientRingConnection connection;
+    COERCE_ERROR(connection.connect(options.soc_.convert_client_ring_path_pattern(0)));
+    ClientRing* ring = connection.get_ring();
+    EXPECT_EQ(4U, ring->get_slot_count());
+    ClientRing::Ticket tickets[4];
+    for (uint32_t i = 0; i < 4U; ++i) {
+      tickets[i] = submit_increment(ring, i);
+    }
+    // completed slots are not reusable until released
+    EXPECT_EQ(kErrorCodeOk, ring->wait(tickets[3], kTimeoutUs));
+    ClientRing::Ticket ticket;
+    void* input;
+    EXPECT_EQ(kErrorCodeSocClientRingFull, ring->reserve(sizeof(uint64_t), &ticket, &input));
+    verify_increment(ring, tickets[0], 0);
+    EXPECT_EQ(kErrorCodeSocClientRingTooLargeInput, ring->reserve(1U << 11, &ticket, &input));
+    ticket = submit_increment(ring, 4);
+    verify_increment(ring, ticket, 4);
+    for (uint32_t i = 1; i < 4U; ++i) {
+      verify_increment(ring, tickets[i], i);
+    }
+    connection.disconnect();
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+TEST(ClientRingTest, ProcNotFound) {
+  EngineOptions options = get_ring_options(8);
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("increment_task", increment_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    ClientRingConnection connection;
+    COERCE_ERROR(connection.connect(options.soc_.convert_client_ring_path_pattern(0)));
+    ClientRing* ring = connection.get_ring();
+    ClientRing::Ticket ticket;
+    void* input;
+    EXPECT_EQ(kErrorCodeOk, ring->reserve(0, &ticket, &input));
+    EXPECT_EQ(kErrorCodeOk, ring->submit(ticket, "no_such_task"));
+    EXPECT_EQ(kErrorCodeOk, ring->wait(ticket, kTimeoutUs));
+    EXPECT_EQ(kErrorCodeProcNotFound, ring->get_result(ticket));
+    EXPECT_EQ(0U, ring->get_output_len(ticket));
+    ring->release(ticket);
+    // the ring keeps working after an error
+    ticket = submit_increment(ring, 42);
+    verify_increment(ring, ticket, 42);
+    connection.disconnect();
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+TEST(ClientRingTest, Abandoned) {
+  EngineOptions options = get_ring_options(4);
+  options.soc_.client_ring_abandon_timeout_us_ = 100000;
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("increment_task", increment_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    ClientRingConnection connection;
+    COERCE_ERROR(connection.connect(options.soc_.convert_client_ring_path_pattern(0)));
+    ClientRing* ring = connection.get_ring();
+
+    // a reserved slot that is not submitted in time is skipped, not blocking later requests
+    ClientRing::Ticket stalled;
+    void* input;
+    EXPECT_EQ(kErrorCodeOk, ring->reserve(sizeof(uint64_t), &stalled, &input));
+    ClientRing::Ticket ticket = submit_increment(ring, 1);
+    verify_increment(ring, ticket, 1);
+    EXPECT_EQ(kErrorCodeSocClientRingAbandoned, ring->submit(stalled, "increment_task"));
+
+    // completed slots that are not released in time are reclaimed when the ring is full
+    ClientRing::Ticket tickets[4];
+    for (uint32_t i = 0; i < 4U; ++i) {
+      tickets[i] = submit_increment(ring, i);
+    }
+    for (uint32_t i = 0; i < 4U; ++i) {
+      EXPECT_EQ(kErrorCodeOk, ring->wait(tickets[i], kTimeoutUs));
+    }
+    EXPECT_EQ(kErrorCodeSocClientRingFull, ring->reserve(sizeof(uint64_t), &ticket, &input));
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    ticket = submit_increment(ring, 42);
+    EXPECT_TRUE(ring->is_abandoned(tickets[0]));
+    EXPECT_EQ(kErrorCodeSocClientRingAbandoned, ring->get_result(tickets[0]));
+    EXPECT_EQ(kErrorCodeSocClientRingAbandoned, ring->wait(tickets[0], kTimeoutUs));
+    ring->release(tickets[0]);  // no effect
+    verify_increment(ring, ticket, 42);
+    for (uint32_t i = 1; i < 4U; ++i) {
+      verify_increment(ring, tickets[i], i);
+    }
+    connection.disconnect();
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+}  // namespace soc
+}  // namespace foedus
+
+TEST_MAIN_CAPTURE_SIGNALS(ClientRingTest, foedus.soc);
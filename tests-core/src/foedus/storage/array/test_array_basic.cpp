@@ -17,6 +17,7 @@
  */
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <cstring>
 #include <iostream>
 #include <vector>
@@ -26,6 +27,7 @@
 #include "foedus/epoch.hpp"
 #include "foedus/test_common.hpp"
 #include "foedus/proc/proc_manager.hpp"
+#include "foedus/snapshot/snapshot_manager.hpp"
 #include "foedus/storage/storage_manager.hpp"
 #include "foedus/storage/array/array_metadata.hpp"
 #include "foedus/storage/array/array_route.hpp"
@@ -33,6 +35,7 @@
 #include "foedus/storage/array/array_storage_pimpl.hpp"
 #include "foedus/thread/thread.hpp"
 #include "foedus/thread/thread_pool.hpp"
+#include "foedus/xct/xct.hpp"
 #include "foedus/xct/xct_manager.hpp"
 
 namespace foedus {
@@ -243,6 +246,368 @@ TEST(ArrayBasicTest, CreateAndReadWrite) {
   cleanup_test(options);
 }
 
+const ArrayOffset kAggregateRecords = 5000;
+
+/** Sets offset to the 1st field and (offset % 7) to the 2nd field */
+ErrorStack aggregate_populate_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  ArrayStorage array(args.engine_, "test5");
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  CHECK_ERROR(xct_manager->begin_xct(context, xct::kSerializable));
+  for (ArrayOffset i = 0; i < kAggregateRecords; ++i) {
+    CHECK_ERROR(array.overwrite_record_primitive<uint64_t>(context, i, i, 0));
+    CHECK_ERROR(array.overwrite_record_primitive<int32_t>(context, i, i % 7, 8));
+  }
+  Epoch commit_epoch;
+  CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+  CHECK_ERROR(xct_manager->wait_for_commit(commit_epoch));
+  return kRetOk;
+}
+
+void verify_aggregate(thread::Thread* context, ArrayOffset from, ArrayOffset to) {
+  ArrayStorage array(context->get_engine(), "test5");
+  ArrayAggregateResult<uint64_t> result;
+  COERCE_ERROR_CODE(array.aggregate_primitive<uint64_t>(context, 0, from, to, &result));
+  EXPECT_EQ(to - from, result.count_);
+  EXPECT_EQ((from + to - 1U) * (to - from) / 2U, result.sum_);
+  EXPECT_EQ(from, result.min_);
+  EXPECT_EQ(to - 1U, result.max_);
+
+  ArrayAggregateResult<int32_t> result2;
+  COERCE_ERROR_CODE(array.aggregate_primitive<int32_t>(context, 8, from, to, &result2));
+  int32_t expected_sum = 0;
+  for (ArrayOffset i = from; i < to; ++i) {
+    expected_sum += i % 7;
+  }
+  EXPECT_EQ(to - from, result2.count_);
+  EXPECT_EQ(expected_sum, result2.sum_);
+  if (to - from >= 7U) {
+    EXPECT_EQ(0, result2.min_);
+    EXPECT_EQ(6, result2.max_);
+  } else {
+    EXPECT_EQ(static_cast<int32_t>(from % 7), result2.min_);
+  }
+}
+
+ErrorStack aggregate_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  const bool snapshot_only = *reinterpret_cast<const bool*>(args.input_buffer_);
+  const xct::IsolationLevel levels[] = { xct::kSerializable, xct::kDirtyRead };
+  for (uint16_t rep = 0; rep < 2U; ++rep) {
+    if (snapshot_only) {
+      CHECK_ERROR(xct_manager->begin_snapshot_only_xct(context));
+    } else {
+      CHECK_ERROR(xct_manager->begin_xct(context, levels[rep]));
+    }
+    verify_aggregate(context, 0, kAggregateRecords);
+    verify_aggregate(context, 123, 4567);
+    verify_aggregate(context, 10, 11);
+    if (snapshot_only || levels[rep] != xct::kSerializable) {
+      EXPECT_EQ(0, context->get_current_xct().get_read_set_size());
+    }
+    Epoch commit_epoch;
+    CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+  }
+  return kRetOk;
+}
+
+TEST(ArrayBasicTest, Aggregate) {
+  EngineOptions options = get_tiny_options();
+  options.log_.log_buffer_kb_ = 1 << 11;
+  options.xct_.max_read_set_size_ = 1 << 15;
+  options.xct_.max_write_set_size_ = 1 << 14;
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("aggregate_populate_task", aggregate_populate_task);
+  engine.get_proc_manager()->pre_register("aggregate_task", aggregate_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    ArrayMetadata meta("test5", 16, kAggregateRecords);
+    ArrayStorage storage;
+    Epoch epoch;
+    COERCE_ERROR(engine.get_storage_manager()->create_array(&meta, &storage, &epoch));
+    thread::ThreadPool* pool = engine.get_thread_pool();
+    COERCE_ERROR(pool->impersonate_synchronous("aggregate_populate_task"));
+    bool snapshot_only = false;
+    COERCE_ERROR(pool->impersonate_synchronous("aggregate_task", &snapshot_only, sizeof(bool)));
+    engine.get_snapshot_manager()->trigger_snapshot_immediate(true);
+    snapshot_only = true;
+    COERCE_ERROR(pool->impersonate_synchronous("aggregate_task", &snapshot_only, sizeof(bool)));
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+const ArrayOffset kExtendInitialRecords = 100;
+// 168 records per leaf page and 252 pointers per interior page with 8-byte payloads.
+const ArrayOffset kExtendTwoLevelRecords = 20000;
+const ArrayOffset kExtendThreeLevelRecords = 45000;
+const uint64_t kExtendValue = 1000;
+
+struct ExtendInput {
+  ArrayOffset from_;
+  ArrayOffset to_;
+  /** Records in [from_, written_to_) have kExtendValue + offset, others are zero */
+  ArrayOffset written_to_;
+  bool        snapshot_only_;
+};
+
+/** Sets kExtendValue + offset to [from_, to_), committing every 1000 records */
+ErrorStack extend_write_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  const ExtendInput* input = reinterpret_cast<const ExtendInput*>(args.input_buffer_);
+  ArrayStorage array(args.engine_, "test6");
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  for (ArrayOffset i = input->from_; i < input->to_;) {
+    CHECK_ERROR(xct_manager->begin_xct(context, xct::kSerializable));
+    for (ArrayOffset end = std::min<ArrayOffset>(i + 1000U, input->to_); i < end; ++i) {
+      CHECK_ERROR(array.overwrite_record_primitive<uint64_t>(context, i, kExtendValue + i, 0));
+    }
+    Epoch commit_epoch;
+    CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+    CHECK_ERROR(xct_manager->wait_for_commit(commit_epoch));
+  }
+  return kRetOk;
+}
+
+ErrorStack extend_verify_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  const ExtendInput* input = reinterpret_cast<const ExtendInput*>(args.input_buffer_);
+  ArrayStorage array(args.engine_, "test6");
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  for (ArrayOffset i = input->from_; i < input->to_;) {
+    if (input->snapshot_only_) {
+      CHECK_ERROR(xct_manager->begin_snapshot_only_xct(context));
+    } else {
+      CHECK_ERROR(xct_manager->begin_xct(context, xct::kSerializable));
+    }
+    for (ArrayOffset end = std::min<ArrayOffset>(i + 1000U, input->to_); i < end; ++i) {
+      uint64_t data;
+      CHECK_ERROR(array.get_record_primitive<uint64_t>(context, i, &data, 0));
+      EXPECT_EQ(i < input->written_to_ ? kExtendValue + i : 0, data) << i;
+    }
+    Epoch commit_epoch;
+    CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+  }
+  return kRetOk;
+}
+
+/** The latest snapshot doesn't have the extended range yet */
+ErrorStack extend_no_snapshot_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  ArrayStorage array(args.engine_, "test6");
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  CHECK_ERROR(xct_manager->begin_snapshot_only_xct(context));
+  uint64_t data;
+  EXPECT_EQ(
+    kErrorCodeXctNoSnapshotPage,
+    array.get_record_primitive<uint64_t>(context, kExtendTwoLevelRecords - 1U, &data, 0));
+  CHECK_ERROR(array.get_record_primitive<uint64_t>(context, 0, &data, 0));
+  EXPECT_EQ(kExtendValue, data);
+  Epoch commit_epoch;
+  CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+  return kRetOk;
+}
+
+TEST(ArrayBasicTest, Extend) {
+  EngineOptions options = get_tiny_options();
+  options.log_.log_buffer_kb_ = 1 << 11;
+  options.cache_.snapshot_cache_size_mb_per_node_ *= 4;
+  const uint16_t kInputSize = sizeof(ExtendInput);
+  {
+    Engine engine(options);
+    engine.get_proc_manager()->pre_register("extend_write_task", extend_write_task);
+    engine.get_proc_manager()->pre_register("extend_verify_task", extend_verify_task);
+    engine.get_proc_manager()->pre_register("extend_no_snapshot_task", extend_no_snapshot_task);
+    COERCE_ERROR(engine.initialize());
+    {
+      UninitializeGuard guard(&engine);
+      ArrayMetadata meta("test6", sizeof(uint64_t), kExtendInitialRecords);
+      ArrayStorage storage;
+      Epoch epoch;
+      COERCE_ERROR(engine.get_storage_manager()->create_array(&meta, &storage, &epoch));
+      EXPECT_EQ(1U, storage.get_levels());
+      thread::ThreadPool* pool = engine.get_thread_pool();
+      ExtendInput input = {0, kExtendInitialRecords, kExtendInitialRecords, false};
+      COERCE_ERROR(pool->impersonate_synchronous("extend_write_task", &input, kInputSize));
+      engine.get_snapshot_manager()->trigger_snapshot_immediate(true);
+
+      // shrinking is not allowed. it's just ignored.
+      COERCE_ERROR(storage.extend(kExtendInitialRecords / 2U, &epoch));
+      EXPECT_EQ(kExtendInitialRecords, storage.get_array_size());
+      COERCE_ERROR(storage.extend(kExtendTwoLevelRecords, &epoch));
+      EXPECT_TRUE(epoch.is_valid());
+      EXPECT_EQ(kExtendTwoLevelRecords, storage.get_array_size());
+      EXPECT_EQ(2U, storage.get_levels());
+      input.to_ = kExtendTwoLevelRecords;
+      COERCE_ERROR(pool->impersonate_synchronous("extend_verify_task", &input, kInputSize));
+      COERCE_ERROR(pool->impersonate_synchronous("extend_no_snapshot_task"));
+
+      input.from_ = kExtendInitialRecords;
+      COERCE_ERROR(pool->impersonate_synchronous("extend_write_task", &input, kInputSize));
+      engine.get_snapshot_manager()->trigger_snapshot_immediate(true);
+      input.from_ = 0;
+      input.written_to_ = kExtendTwoLevelRecords;
+      COERCE_ERROR(pool->impersonate_synchronous("extend_verify_task", &input, kInputSize));
+      input.snapshot_only_ = true;
+      COERCE_ERROR(pool->impersonate_synchronous("extend_verify_task", &input, kInputSize));
+
+      // this one is not snapshotted. restart must redo it.
+      COERCE_ERROR(storage.extend(kExtendThreeLevelRecords, &epoch));
+      EXPECT_EQ(3U, storage.get_levels());
+      COERCE_ERROR_CODE(engine.get_xct_manager()->wait_for_commit(epoch));
+      COERCE_ERROR(engine.uninitialize());
+    }
+  }
+  {
+    Engine engine(options);
+    engine.get_proc_manager()->pre_register("extend_write_task", extend_write_task);
+    engine.get_proc_manager()->pre_register("extend_verify_task", extend_verify_task);
+    COERCE_ERROR(engine.initialize());
+    {
+      UninitializeGuard guard(&engine);
+      ArrayStorage storage(&engine, "test6");
+      EXPECT_EQ(kExtendThreeLevelRecords, storage.get_array_size());
+      EXPECT_EQ(3U, storage.get_levels());
+      thread::ThreadPool* pool = engine.get_thread_pool();
+      ExtendInput input = {0, kExtendThreeLevelRecords, kExtendTwoLevelRecords, false};
+      COERCE_ERROR(pool->impersonate_synchronous("extend_verify_task", &input, kInputSize));
+      input.from_ = kExtendTwoLevelRecords;
+      input.written_to_ = kExtendThreeLevelRecords;
+      COERCE_ERROR(pool->impersonate_synchronous("extend_write_task", &input, kInputSize));
+      COERCE_ERROR(pool->impersonate_synchronous("extend_verify_task", &input, kInputSize));
+      engine.get_snapshot_manager()->trigger_snapshot_immediate(true);
+      input.from_ = 0;
+      input.snapshot_only_ = true;
+      COERCE_ERROR(pool->impersonate_synchronous("extend_verify_task", &input, kInputSize));
+      COERCE_ERROR(engine.uninitialize());
+    }
+  }
+  cleanup_test(options);
+}
+
+// 168 records per leaf page with 8-byte payloads. 12 leaf pages under the root.
+const ArrayOffset kMigrateRecords = 2000;
+const uint64_t kMigrateValue = 3000;
+
+ErrorStack migrate_populate_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  ArrayStorage array(args.engine_, "test7");
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  CHECK_ERROR(xct_manager->begin_xct(context, xct::kSerializable));
+  for (ArrayOffset i = 0; i < kMigrateRecords; ++i) {
+    CHECK_ERROR(array.overwrite_record_primitive<uint64_t>(context, i, kMigrateValue + i, 0));
+  }
+  Epoch commit_epoch;
+  CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+  CHECK_ERROR(xct_manager->wait_for_commit(commit_epoch));
+  return kRetOk;
+}
+
+/** Returns the volatile pointers to leaf pages, which are children of the root page. */
+std::vector<DualPagePointer*> get_migrate_leaf_pointers(thread::Thread* context) {
+  ArrayStorage array(context->get_engine(), "test7");
+  ArrayPage* root = reinterpret_cast<ArrayPage*>(
+    context->resolve(array.get_control_block()->root_page_pointer_.volatile_pointer_));
+  EXPECT_EQ(1U, root->get_level());
+  std::vector<DualPagePointer*> ret;
+  for (uint16_t i = 0; i < kInteriorFanout; ++i) {
+    DualPagePointer* pointer = &root->get_interior_record(i);
+    if (!pointer->volatile_pointer_.is_null()) {
+      ret.push_back(pointer);
+    }
+  }
+  return ret;
+}
+
+ErrorStack migrate_access_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  ArrayStorage array(args.engine_, "test7");
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  std::vector<DualPagePointer*> pointers = get_migrate_leaf_pointers(context);
+  EXPECT_EQ(12U, pointers.size());
+  for (DualPagePointer* pointer : pointers) {
+    EXPECT_EQ(0, pointer->volatile_pointer_.get_numa_node());
+  }
+  EXPECT_EQ(0, context->get_migrated_volatile_pages());
+
+  // reading them from node-1 samples all leaf pages as remote accesses.
+  CHECK_ERROR(xct_manager->begin_xct(context, xct::kSerializable));
+  for (ArrayOffset i = 0; i < kMigrateRecords; ++i) {
+    uint64_t data;
+    CHECK_ERROR(array.get_record_primitive<uint64_t>(context, i, &data, 0));
+    EXPECT_EQ(kMigrateValue + i, data) << i;
+  }
+  Epoch commit_epoch;
+  CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+  ArrayPage* old_leaf = reinterpret_cast<ArrayPage*>(
+    context->resolve(pointers[0]->volatile_pointer_));
+  xct::RwLockableXctId* old_owner_id = &old_leaf->get_leaf_record(5, 8)->owner_id_;
+
+  // the next transaction migrates them to node-1 before it begins
+  CHECK_ERROR(xct_manager->begin_xct(context, xct::kSerializable));
+  EXPECT_EQ(12U, context->get_migrated_volatile_pages());
+  for (DualPagePointer* pointer : pointers) {
+    EXPECT_EQ(1U, pointer->volatile_pointer_.get_numa_node());
+  }
+  EXPECT_TRUE(old_owner_id->is_moved());
+  xct::TrackMovedRecordResult tracked = args.engine_->get_storage_manager()->track_moved_record(
+    array.get_id(),
+    old_owner_id,
+    nullptr);
+  ArrayPage* new_leaf = reinterpret_cast<ArrayPage*>(
+    context->resolve(pointers[0]->volatile_pointer_));
+  EXPECT_EQ(&new_leaf->get_leaf_record(5, 8)->owner_id_, tracked.new_owner_address_);
+  EXPECT_FALSE(tracked.new_owner_address_->is_moved());
+  EXPECT_EQ(kMigrateValue + 5U, *reinterpret_cast<uint64_t*>(tracked.new_payload_address_));
+
+  // the migrated pages have the same records, and we can keep modifying them
+  for (ArrayOffset i = 0; i < kMigrateRecords; ++i) {
+    uint64_t data;
+    CHECK_ERROR(array.get_record_primitive<uint64_t>(context, i, &data, 0));
+    EXPECT_EQ(kMigrateValue + i, data) << i;
+    CHECK_ERROR(array.overwrite_record_primitive<uint64_t>(context, i, data + 1U, 0));
+  }
+  CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+  CHECK_ERROR(xct_manager->wait_for_commit(commit_epoch));
+
+  // now they are local. nothing to migrate.
+  CHECK_ERROR(xct_manager->begin_xct(context, xct::kSerializable));
+  EXPECT_EQ(12U, context->get_migrated_volatile_pages());
+  for (ArrayOffset i = 0; i < kMigrateRecords; ++i) {
+    uint64_t data;
+    CHECK_ERROR(array.get_record_primitive<uint64_t>(context, i, &data, 0));
+    EXPECT_EQ(kMigrateValue + i + 1U, data) << i;
+  }
+  CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+  return kRetOk;
+}
+
+TEST(ArrayBasicTest, Migrate) {
+  EngineOptions options = get_tiny_options();
+  options.thread_.group_count_ = 2;
+  options.log_.log_buffer_kb_ = 1 << 10;
+  options.storage_.volatile_page_migration_sample_interval_ = 1;
+  options.storage_.volatile_page_migration_min_samples_ = 1;
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("migrate_populate_task", migrate_populate_task);
+  engine.get_proc_manager()->pre_register("migrate_access_task", migrate_access_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    ArrayMetadata meta("test7", sizeof(uint64_t), kMigrateRecords);
+    ArrayStorage storage;
+    Epoch epoch;
+    COERCE_ERROR(engine.get_storage_manager()->create_array(&meta, &storage, &epoch));
+    thread::ThreadPool* pool = engine.get_thread_pool();
+    COERCE_ERROR(pool->impersonate_on_numa_node_synchronous(0, "migrate_populate_task"));
+    COERCE_ERROR(pool->impersonate_on_numa_node_synchronous(1, "migrate_access_task"));
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
 }  // namespace array
 }  // namespace storage
 }  // namespace foedus
@@ -102,6 +102,80 @@ TEST(ArrayPartitionerTest, InitialPartition) {
   cleanup_test(options);
 }
 
+void design_partition(Engine* engine, Partitioner* partitioner) {
+  memory::AlignedMemory work_memory;
+  work_memory.alloc(1U << 21, 1U << 12, memory::AlignedMemory::kNumaAllocOnnode, 0);
+  cache::SnapshotFileSet fileset(engine);
+  COERCE_ERROR(fileset.initialize())
+  Partitioner::DesignPartitionArguments args = { &work_memory, &fileset};
+  COERCE_ERROR(partitioner->design_partition(args));
+  COERCE_ERROR(fileset.uninitialize());
+  EXPECT_TRUE(partitioner->is_valid());
+}
+
+TEST(ArrayPartitionerTest, AccessStatistics) {
+  EngineOptions options = get_tiny_options();
+  options.log_.log_buffer_kb_ = 1 << 10;
+  options.thread_.group_count_ = 2;
+  options.memory_.page_pool_size_mb_per_node_ = 4;
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("populate", populate);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    ArrayStorage out;
+    Epoch commit_epoch;
+    ArrayMetadata meta("test", 3000, 300);  // same as InitialPartition. 2 children in root.
+    COERCE_ERROR(engine.get_storage_manager()->create_array(&meta, &out, &commit_epoch));
+    COERCE_ERROR(engine.get_thread_pool()->impersonate_on_numa_node_synchronous(0, "populate"));
+    COERCE_ERROR(engine.get_thread_pool()->impersonate_on_numa_node_synchronous(1, "populate"));
+    PartitionerMetadata* metadata = PartitionerMetadata::get_metadata(&engine, out.get_id());
+    PartitionerAccessStatistics* statistics = &metadata->access_statistics_;
+    EXPECT_EQ(0U, statistics->bucket_count_);
+
+    // the first design follows the owners of volatile pages, then starts sampling
+    Partitioner partitioner(&engine, out.get_id());
+    design_partition(&engine, &partitioner);
+    {
+      ArrayPartitioner array_partitioner(&partitioner);
+      EXPECT_TRUE(array_partitioner.is_partitionable());
+      EXPECT_EQ(0, array_partitioner.get_bucket_owners()[0]);
+      EXPECT_EQ(1U, array_partitioner.get_bucket_owners()[1]);
+    }
+    EXPECT_GE(statistics->bucket_count_, 2U);
+    EXPECT_EQ(0U, statistics->bucket_low_keys_[0]);
+
+    // node-1 mostly reads the first child and node-0 reads the second child.
+    for (uint32_t i = 0; i < PartitionerAccessStatistics::kMinSamples; ++i) {
+      statistics->sample(i, 1U);
+      statistics->sample(299U - i, 0);
+    }
+    statistics->sample(0, 0);
+    EXPECT_EQ(PartitionerAccessStatistics::kMinSamples * 2U + 1U, statistics->total_samples_);
+
+    // the next snapshot swaps the owners
+    metadata->clear_counts();
+    design_partition(&engine, &partitioner);
+    {
+      ArrayPartitioner array_partitioner(&partitioner);
+      EXPECT_EQ(1U, array_partitioner.get_bucket_owners()[0]);
+      EXPECT_EQ(0, array_partitioner.get_bucket_owners()[1]);
+    }
+    EXPECT_EQ(0U, statistics->total_samples_);
+
+    // without samples, it falls back to the owners of volatile pages
+    metadata->clear_counts();
+    design_partition(&engine, &partitioner);
+    {
+      ArrayPartitioner array_partitioner(&partitioner);
+      EXPECT_EQ(0, array_partitioner.get_bucket_owners()[0]);
+      EXPECT_EQ(1U, array_partitioner.get_bucket_owners()[1]);
+    }
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
 const uint16_t kPayload = 16;
 
 typedef void (*TestFunctor)(Partitioner partitioner);
@@ -121,14 +195,7 @@ void execute_test(TestFunctor functor, uint64_t array_size = 1024) {
     COERCE_ERROR(engine.get_thread_pool()->impersonate_on_numa_node_synchronous(0, "populate"));
     COERCE_ERROR(engine.get_thread_pool()->impersonate_on_numa_node_synchronous(1, "populate"));
     Partitioner partitioner(&engine, out.get_id());
-    memory::AlignedMemory work_memory;
-    work_memory.alloc(1U << 21, 1U << 12, memory::AlignedMemory::kNumaAllocOnnode, 0);
-    cache::SnapshotFileSet fileset(&engine);
-    COERCE_ERROR(fileset.initialize())
-    Partitioner::DesignPartitionArguments args = { &work_memory, &fileset};
-    COERCE_ERROR(partitioner.design_partition(args));
-    COERCE_ERROR(fileset.uninitialize());
-    EXPECT_TRUE(partitioner.is_valid());
+    design_partition(&engine, &partitioner);
     functor(partitioner);
     COERCE_ERROR(engine.uninitialize());
   }
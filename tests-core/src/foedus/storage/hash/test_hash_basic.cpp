@@ -25,11 +25,14 @@
 #include "foedus/epoch.hpp"
 #include "foedus/test_common.hpp"
 #include "foedus/proc/proc_manager.hpp"
+#include "foedus/snapshot/snapshot_manager.hpp"
+#include "foedus/storage/delta_update.hpp"
 #include "foedus/storage/storage_manager.hpp"
 #include "foedus/storage/hash/hash_metadata.hpp"
 #include "foedus/storage/hash/hash_storage.hpp"
 #include "foedus/thread/thread.hpp"
 #include "foedus/thread/thread_pool.hpp"
+#include "foedus/xct/xct.hpp"
 #include "foedus/xct/xct_manager.hpp"
 
 namespace foedus {
@@ -212,6 +215,113 @@ TEST(HashBasicTest, Overwrite) {
   }
   cleanup_test(options);
 }
+const uint64_t kDeltaKey = 12345ULL;
+
+ErrorStack delta_populate_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  HashStorage hash = context->get_engine()->get_storage_manager()->get_hash("ggg");
+  xct::XctManager* xct_manager = context->get_engine()->get_xct_manager();
+  CHECK_ERROR(xct_manager->begin_xct(context, xct::kSerializable));
+  char data[12];
+  std::memset(data, 0, sizeof(data));
+  CHECK_ERROR(hash.insert_record(context, kDeltaKey, data, sizeof(data)));
+  Epoch commit_epoch;
+  CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+  CHECK_ERROR(xct_manager->wait_for_commit(commit_epoch));
+  return foedus::kRetOk;
+}
+
+/** Applies rounds [from, to) of deltas: add to the int64 at 0, max to the uint32 at 8. */
+ErrorStack delta_apply_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  const uint32_t* range = reinterpret_cast<const uint32_t*>(args.input_buffer_);
+  HashStorage hash = context->get_engine()->get_storage_manager()->get_hash("ggg");
+  xct::XctManager* xct_manager = context->get_engine()->get_xct_manager();
+  Epoch commit_epoch;
+  for (uint32_t i = range[0]; i < range[1]; ++i) {
+    CHECK_ERROR(xct_manager->begin_xct(context, xct::kSerializable));
+    CHECK_ERROR(hash.delta_record(context, kDeltaKey, kDeltaAdd, static_cast<int64_t>(i), 0));
+    CHECK_ERROR(hash.delta_record(context, kDeltaKey, kDeltaMax, i, 8));
+    EXPECT_EQ(0, context->get_current_xct().get_read_set_size());
+    CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+  }
+  CHECK_ERROR(xct_manager->begin_xct(context, xct::kSerializable));
+  EXPECT_EQ(
+    kErrorCodeInvalidParameter,
+    hash.delta_record(context, kDeltaKey, kDeltaBitOr, 1.0, 0));
+  EXPECT_EQ(
+    kErrorCodeStrTooShortPayload,
+    hash.delta_record(context, kDeltaKey, kDeltaAdd, kDeltaKey, 8));
+  EXPECT_EQ(
+    kErrorCodeStrKeyNotFound,
+    hash.delta_record(context, kDeltaKey + 1U, kDeltaAdd, kDeltaKey, 0));
+  CHECK_ERROR(xct_manager->abort_xct(context));
+  CHECK_ERROR(xct_manager->wait_for_commit(commit_epoch));
+  return foedus::kRetOk;
+}
+
+/** Verifies the result of rounds [1, input). Reads only the snapshot if input is negative. */
+ErrorStack delta_verify_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  int32_t input = *reinterpret_cast<const int32_t*>(args.input_buffer_);
+  const bool snapshot_only = input < 0;
+  const uint64_t rounds = (snapshot_only ? -input : input) - 1;
+  HashStorage hash = context->get_engine()->get_storage_manager()->get_hash("ggg");
+  xct::XctManager* xct_manager = context->get_engine()->get_xct_manager();
+  if (snapshot_only) {
+    CHECK_ERROR(xct_manager->begin_snapshot_only_xct(context));
+  } else {
+    CHECK_ERROR(xct_manager->begin_xct(context, xct::kSerializable));
+  }
+  int64_t sum;
+  uint32_t max;
+  CHECK_ERROR(hash.get_record_primitive(context, kDeltaKey, &sum, 0, true));
+  CHECK_ERROR(hash.get_record_primitive(context, kDeltaKey, &max, 8, true));
+  EXPECT_EQ(static_cast<int64_t>(rounds * (rounds + 1U) / 2U), sum);
+  EXPECT_EQ(rounds, max);
+  Epoch commit_epoch;
+  CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+  return foedus::kRetOk;
+}
+
+TEST(HashBasicTest, Delta) {
+  EngineOptions options = get_tiny_options();
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("delta_populate_task", delta_populate_task);
+  engine.get_proc_manager()->pre_register("delta_apply_task", delta_apply_task);
+  engine.get_proc_manager()->pre_register("delta_verify_task", delta_verify_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    HashMetadata meta("ggg", 8);
+    HashStorage storage;
+    Epoch epoch;
+    COERCE_ERROR(engine.get_storage_manager()->create_hash(&meta, &storage, &epoch));
+    thread::ThreadPool* pool = engine.get_thread_pool();
+    COERCE_ERROR(pool->impersonate_synchronous("delta_populate_task"));
+
+    // The first snapshot sees insert and deltas of the same key
+    const uint32_t first[2] = {1, 11};
+    COERCE_ERROR(pool->impersonate_synchronous("delta_apply_task", first, sizeof(first)));
+    const int32_t volatile_first = 11;
+    const int32_t snapshot_first = -11;
+    COERCE_ERROR(pool->impersonate_synchronous("delta_verify_task", &volatile_first, 4));
+    engine.get_snapshot_manager()->trigger_snapshot_immediate(true);
+    COERCE_ERROR(pool->impersonate_synchronous("delta_verify_task", &snapshot_first, 4));
+
+    // The second snapshot applies only deltas on the record in the previous snapshot
+    const uint32_t second[2] = {11, 21};
+    COERCE_ERROR(pool->impersonate_synchronous("delta_apply_task", second, sizeof(second)));
+    const int32_t volatile_second = 21;
+    const int32_t snapshot_second = -21;
+    COERCE_ERROR(pool->impersonate_synchronous("delta_verify_task", &volatile_second, 4));
+    engine.get_snapshot_manager()->trigger_snapshot_immediate(true);
+    COERCE_ERROR(pool->impersonate_synchronous("delta_verify_task", &snapshot_second, 4));
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
 TEST(HashBasicTest, CreateAndDrop) {
   EngineOptions options = get_tiny_options();
   Engine engine(options);
@@ -110,6 +110,8 @@ HashStorage  tellers;
 sequential::SequentialStorage histories;
 bool          use_primitive_accessors = false;
 bool          use_increment = false;
+/** Branch/teller balances use delta_record(). Implies use_increment for accounts. */
+bool          use_delta = false;
 int thread_count;
 bool contended;
 soc::SharedRendezvous start_rendezvous;
@@ -257,7 +259,12 @@ class RunTpcbTask {
     WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
 
     int64_t branch_balance_old = -1, branch_balance_new;
-    if (use_increment) {
+    if (use_delta) {
+      // blind write. we don't know the balance
+      WRAP_ERROR_CODE(branches.delta_record(context, branch_id, kDeltaAdd, amount, 0));
+      branch_balance_old = 0;
+      branch_balance_new = amount;
+    } else if (use_increment) {
       branch_balance_new = amount;
       WRAP_ERROR_CODE(branches.increment_record(context, branch_id, &branch_balance_new, 0));
       branch_balance_old = branch_balance_new - amount;
@@ -291,7 +298,22 @@ class RunTpcbTask {
 
     int64_t teller_balance_old = -1, teller_balance_new;
     uint64_t teller_branch_id = 0;
-    if (use_increment) {
+    if (use_delta) {
+      WRAP_ERROR_CODE(tellers.get_record_primitive(
+        context,
+        teller_id,
+        &teller_branch_id,
+        0,
+        false));
+      WRAP_ERROR_CODE(tellers.delta_record(
+        context,
+        teller_id,
+        kDeltaAdd,
+        amount,
+        sizeof(uint64_t)));
+      teller_balance_old = 0;
+      teller_balance_new = amount;
+    } else if (use_increment) {
       WRAP_ERROR_CODE(tellers.get_record_primitive(
         context,
         teller_id,
@@ -522,11 +544,12 @@ ErrorStack verify_tpcb_task(const proc::ProcArguments& args) {
 }
 
 void multi_thread_test(int thread_count_arg, bool contended_arg,
-             bool use_primitive = false, bool use_inc = false) {
+             bool use_primitive = false, bool use_inc = false, bool use_dlt = false) {
   thread_count = thread_count_arg;
   contended = contended_arg;
   use_primitive_accessors = use_primitive;
   use_increment = use_inc;
+  use_delta = use_dlt;
   EngineOptions options = get_tiny_options();
   options.memory_.page_pool_size_mb_per_node_ = 32;
   options.memory_.page_pool_size_mb_per_node_ *= 2U;  // for rigorous_check
@@ -587,6 +610,10 @@ TEST(HashTpcbTest, FourThreadedNoContentionInc)   { multi_thread_test(4, false,
 TEST(HashTpcbTest, SingleThreadedContendedInc)    { multi_thread_test(1, true, true, true); }
 TEST(HashTpcbTest, TwoThreadedContendedInc)       { multi_thread_test(2, true, true, true); }
 TEST(HashTpcbTest, FourThreadedContendedInc)      { multi_thread_test(4, true, true, true); }
+
+TEST(HashTpcbTest, SingleThreadedContendedDelta) { multi_thread_test(1, true, true, true, true); }
+TEST(HashTpcbTest, TwoThreadedContendedDelta)    { multi_thread_test(2, true, true, true, true); }
+TEST(HashTpcbTest, FourThreadedContendedDelta)   { multi_thread_test(4, true, true, true, true); }
 }  // namespace hash
 }  // namespace storage
 }  // namespace foedus
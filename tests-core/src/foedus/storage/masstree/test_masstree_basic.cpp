@@ -27,12 +27,15 @@
 #include "foedus/test_common.hpp"
 #include "foedus/assorted/uniform_random.hpp"
 #include "foedus/proc/proc_manager.hpp"
+#include "foedus/snapshot/snapshot_manager.hpp"
+#include "foedus/storage/delta_update.hpp"
 #include "foedus/storage/storage_manager.hpp"
 #include "foedus/storage/hash/hash_hashinate.hpp"
 #include "foedus/storage/masstree/masstree_metadata.hpp"
 #include "foedus/storage/masstree/masstree_storage.hpp"
 #include "foedus/thread/thread.hpp"
 #include "foedus/thread/thread_pool.hpp"
+#include "foedus/xct/xct.hpp"
 #include "foedus/xct/xct_manager.hpp"
 
 namespace foedus {
@@ -288,6 +291,227 @@ TEST(MasstreeBasicTest, Overwrite) {
   cleanup_test(options);
 }
 
+struct DeltaData {
+  int64_t   sum_;
+  uint32_t  min_;
+  uint32_t  max_;
+  uint64_t  bits_;
+  double    total_;
+};
+const KeySlice kDeltaKey = 12345ULL;
+const char kDeltaLongKey[] = "delta_test_long_key";  // goes to next layer
+
+ErrorStack delta_populate_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  MasstreeStorage masstree = context->get_engine()->get_storage_manager()->get_masstree("ggg");
+  xct::XctManager* xct_manager = context->get_engine()->get_xct_manager();
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+  DeltaData data = {0, 1000U, 0, 0, 0};
+  WRAP_ERROR_CODE(masstree.insert_record_normalized(context, kDeltaKey, &data, sizeof(data)));
+  WRAP_ERROR_CODE(masstree.insert_record(
+    context,
+    kDeltaLongKey,
+    sizeof(kDeltaLongKey),
+    &data,
+    sizeof(data)));
+  Epoch commit_epoch;
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  WRAP_ERROR_CODE(xct_manager->wait_for_commit(commit_epoch));
+  return foedus::kRetOk;
+}
+
+/** Applies rounds [from, to) of deltas */
+ErrorStack delta_apply_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  const uint32_t* range = reinterpret_cast<const uint32_t*>(args.input_buffer_);
+  MasstreeStorage masstree = context->get_engine()->get_storage_manager()->get_masstree("ggg");
+  xct::XctManager* xct_manager = context->get_engine()->get_xct_manager();
+  Epoch commit_epoch;
+  for (uint32_t i = range[0]; i < range[1]; ++i) {
+    WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+    for (int k = 0; k < 2; ++k) {
+      const void* key = k == 0 ? nullptr : kDeltaLongKey;
+      uint64_t be_key = assorted::htobe<uint64_t>(kDeltaKey);
+      if (k == 0) {
+        key = &be_key;
+      }
+      KeyLength key_length = k == 0 ? sizeof(be_key) : sizeof(kDeltaLongKey);
+      WRAP_ERROR_CODE(masstree.delta_record<int64_t>(context, key, key_length, kDeltaAdd, i, 0));
+      WRAP_ERROR_CODE(masstree.delta_record<uint32_t>(
+        context,
+        key,
+        key_length,
+        kDeltaMin,
+        1000U - i,
+        8));
+      WRAP_ERROR_CODE(masstree.delta_record<uint32_t>(context, key, key_length, kDeltaMax, i, 12));
+      WRAP_ERROR_CODE(masstree.delta_record<uint64_t>(
+        context,
+        key,
+        key_length,
+        kDeltaBitOr,
+        1ULL << i,
+        16));
+      WRAP_ERROR_CODE(masstree.delta_record<double>(context, key, key_length, kDeltaAdd, 0.5, 24));
+    }
+    // delta_record() is a blind write
+    EXPECT_EQ(0, context->get_current_xct().get_read_set_size());
+    EXPECT_EQ(10U, context->get_current_xct().get_write_set_size());
+    WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  }
+
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+  EXPECT_EQ(
+    kErrorCodeInvalidParameter,
+    masstree.delta_record_normalized<double>(context, kDeltaKey, kDeltaBitOr, 1.0, 24));
+  EXPECT_EQ(
+    kErrorCodeStrTooShortPayload,
+    masstree.delta_record_normalized<uint64_t>(context, kDeltaKey, kDeltaAdd, 1, 28));
+  EXPECT_EQ(
+    kErrorCodeStrKeyNotFound,
+    masstree.delta_record_normalized<uint64_t>(context, kDeltaKey + 1U, kDeltaAdd, 1, 0));
+  WRAP_ERROR_CODE(xct_manager->abort_xct(context));
+  WRAP_ERROR_CODE(xct_manager->wait_for_commit(commit_epoch));
+  return foedus::kRetOk;
+}
+
+/** Verifies the result of rounds [1, input). Reads only the snapshot if input is negative. */
+ErrorStack delta_verify_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  int32_t input = *reinterpret_cast<const int32_t*>(args.input_buffer_);
+  const bool snapshot_only = input < 0;
+  const uint64_t rounds = (snapshot_only ? -input : input) - 1;
+  MasstreeStorage masstree = context->get_engine()->get_storage_manager()->get_masstree("ggg");
+  xct::XctManager* xct_manager = context->get_engine()->get_xct_manager();
+  if (snapshot_only) {
+    WRAP_ERROR_CODE(xct_manager->begin_snapshot_only_xct(context));
+  } else {
+    WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+  }
+  for (int k = 0; k < 2; ++k) {
+    DeltaData data;
+    PayloadLength capacity = sizeof(data);
+    if (k == 0) {
+      WRAP_ERROR_CODE(masstree.get_record_normalized(context, kDeltaKey, &data, &capacity, true));
+    } else {
+      WRAP_ERROR_CODE(masstree.get_record(
+        context,
+        kDeltaLongKey,
+        sizeof(kDeltaLongKey),
+        &data,
+        &capacity,
+        true));
+    }
+    EXPECT_EQ(sizeof(data), capacity);
+    EXPECT_EQ(static_cast<int64_t>(rounds * (rounds + 1U) / 2U), data.sum_) << k;
+    EXPECT_EQ(rounds == 0 ? 1000U : 1000U - rounds, data.min_) << k;
+    EXPECT_EQ(rounds, data.max_) << k;
+    EXPECT_EQ((2ULL << rounds) - 2ULL, data.bits_) << k;
+    EXPECT_DOUBLE_EQ(0.5 * rounds, data.total_) << k;
+  }
+  Epoch commit_epoch;
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  return foedus::kRetOk;
+}
+
+TEST(MasstreeBasicTest, Delta) {
+  EngineOptions options = get_tiny_options();
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("delta_populate_task", delta_populate_task);
+  engine.get_proc_manager()->pre_register("delta_apply_task", delta_apply_task);
+  engine.get_proc_manager()->pre_register("delta_verify_task", delta_verify_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    MasstreeMetadata meta("ggg");
+    MasstreeStorage storage;
+    Epoch epoch;
+    COERCE_ERROR(engine.get_storage_manager()->create_masstree(&meta, &storage, &epoch));
+    thread::ThreadPool* pool = engine.get_thread_pool();
+    COERCE_ERROR(pool->impersonate_synchronous("delta_populate_task"));
+
+    // The first snapshot sees insert and deltas of the same keys
+    const uint32_t first[2] = {1, 11};
+    COERCE_ERROR(pool->impersonate_synchronous("delta_apply_task", first, sizeof(first)));
+    const int32_t volatile_first = 11;
+    const int32_t snapshot_first = -11;
+    COERCE_ERROR(pool->impersonate_synchronous("delta_verify_task", &volatile_first, 4));
+    engine.get_snapshot_manager()->trigger_snapshot_immediate(true);
+    COERCE_ERROR(pool->impersonate_synchronous("delta_verify_task", &snapshot_first, 4));
+
+    // The second snapshot applies only deltas on the records in the previous snapshot
+    const uint32_t second[2] = {11, 21};
+    COERCE_ERROR(pool->impersonate_synchronous("delta_apply_task", second, sizeof(second)));
+    const int32_t volatile_second = 21;
+    const int32_t snapshot_second = -21;
+    COERCE_ERROR(pool->impersonate_synchronous("delta_verify_task", &snapshot_first, 4));
+    COERCE_ERROR(pool->impersonate_synchronous("delta_verify_task", &volatile_second, 4));
+    engine.get_snapshot_manager()->trigger_snapshot_immediate(true);
+    COERCE_ERROR(pool->impersonate_synchronous("delta_verify_task", &snapshot_second, 4));
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+ErrorStack delta_conflict_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  MasstreeStorage masstree = context->get_engine()->get_storage_manager()->get_masstree("ggg");
+  xct::XctManager* xct_manager = context->get_engine()->get_xct_manager();
+
+  // delete, then delta
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+  WRAP_ERROR_CODE(masstree.delete_record_normalized(context, kDeltaKey));
+  EXPECT_EQ(
+    kErrorCodeXctDeltaConflict,
+    masstree.delta_record_normalized<uint64_t>(context, kDeltaKey, kDeltaAdd, 1, 0));
+  WRAP_ERROR_CODE(xct_manager->abort_xct(context));
+
+  // delta, then shrinking update
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+  WRAP_ERROR_CODE(masstree.delta_record_normalized<uint64_t>(context, kDeltaKey, kDeltaAdd, 1, 16));
+  uint64_t short_data = 0;
+  EXPECT_EQ(
+    kErrorCodeXctDeltaConflict,
+    masstree.upsert_record_normalized(context, kDeltaKey, &short_data, sizeof(short_data)));
+  WRAP_ERROR_CODE(xct_manager->abort_xct(context));
+
+  // an update that keeps the delta's bytes is fine, and so are deltas on other records
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+  DeltaData data = {0, 1000U, 0, 0, 0};
+  WRAP_ERROR_CODE(masstree.upsert_record_normalized(context, kDeltaKey, &data, sizeof(data)));
+  WRAP_ERROR_CODE(masstree.delta_record_normalized<int64_t>(context, kDeltaKey, kDeltaAdd, 5, 0));
+  WRAP_ERROR_CODE(masstree.delete_record(context, kDeltaLongKey, sizeof(kDeltaLongKey)));
+  Epoch commit_epoch;
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+  PayloadLength capacity = sizeof(data);
+  WRAP_ERROR_CODE(masstree.get_record_normalized(context, kDeltaKey, &data, &capacity, true));
+  EXPECT_EQ(5, data.sum_);
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  return foedus::kRetOk;
+}
+
+TEST(MasstreeBasicTest, DeltaConflict) {
+  EngineOptions options = get_tiny_options();
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("delta_populate_task", delta_populate_task);
+  engine.get_proc_manager()->pre_register("delta_conflict_task", delta_conflict_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    MasstreeMetadata meta("ggg");
+    MasstreeStorage storage;
+    Epoch epoch;
+    COERCE_ERROR(engine.get_storage_manager()->create_masstree(&meta, &storage, &epoch));
+    thread::ThreadPool* pool = engine.get_thread_pool();
+    COERCE_ERROR(pool->impersonate_synchronous("delta_populate_task"));
+    COERCE_ERROR(pool->impersonate_synchronous("delta_conflict_task"));
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
 ErrorStack next_layer_task(const proc::ProcArguments& args) {
   thread::Thread* context = args.context_;
   MasstreeStorage masstree = context->get_engine()->get_storage_manager()->get_masstree("ggg");
@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+#include "foedus/engine.hpp"
+#include "foedus/engine_options.hpp"
+#include "foedus/epoch.hpp"
+#include "foedus/test_common.hpp"
+#include "foedus/assorted/endianness.hpp"
+#include "foedus/proc/proc_manager.hpp"
+#include "foedus/snapshot/snapshot_manager.hpp"
+#include "foedus/storage/storage_manager.hpp"
+#include "foedus/storage/masstree/masstree_metadata.hpp"
+#include "foedus/storage/masstree/masstree_parallel_scan.hpp"
+#include "foedus/storage/masstree/masstree_storage.hpp"
+#include "foedus/thread/thread.hpp"
+#include "foedus/thread/thread_pool.hpp"
+#include "foedus/xct/xct_manager.hpp"
+
+namespace foedus {
+namespace storage {
+namespace masstree {
+DEFINE_TEST_CASE_PACKAGE(MasstreeParallelScanTest, foedus.storage.masstree);
+
+const uint32_t kRecords = 1 << 12;
+const uint16_t kPartitions = 4;
+const char* kTableName = "test";
+
+ErrorStack populate_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  MasstreeStorage storage(context->get_engine(), kTableName);
+  xct::XctManager* xct_manager = context->get_engine()->get_xct_manager();
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+  for (uint64_t i = 0; i < kRecords; ++i) {
+    KeySlice key = normalize_primitive<uint64_t>(i);
+    WRAP_ERROR_CODE(storage.insert_record_normalized(context, key, &i, sizeof(i)));
+  }
+  Epoch commit_epoch;
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  WRAP_ERROR_CODE(xct_manager->wait_for_commit(commit_epoch));
+  return kRetOk;
+}
+
+/** Each partition has its own slot, so the unordered handler needs no synchronization. */
+struct ScanResult {
+  uint64_t count_[kPartitions];
+  uint64_t sum_[kPartitions];
+  std::vector<uint64_t> ordered_;
+};
+
+ErrorCode unordered_handler(
+  void* user_context,
+  uint16_t partition,
+  const char* key,
+  KeyLength key_length,
+  const char* payload,
+  PayloadLength payload_length) {
+  ScanResult* result = reinterpret_cast<ScanResult*>(user_context);
+  EXPECT_LT(partition, kPartitions);
+  EXPECT_EQ(sizeof(KeySlice), key_length);
+  EXPECT_EQ(sizeof(uint64_t), payload_length);
+  uint64_t value;
+  std::memcpy(&value, payload, sizeof(value));
+  EXPECT_EQ(normalize_primitive<uint64_t>(value), normalize_be_bytes_full(key));
+  ++result->count_[partition];
+  result->sum_[partition] += value;
+  return kErrorCodeOk;
+}
+
+ErrorCode ordered_handler(
+  void* user_context,
+  uint16_t /*partition*/,
+  const char* /*key*/,
+  KeyLength /*key_length*/,
+  const char* payload,
+  PayloadLength payload_length) {
+  ScanResult* result = reinterpret_cast<ScanResult*>(user_context);
+  EXPECT_EQ(sizeof(uint64_t), payload_length);
+  uint64_t value;
+  std::memcpy(&value, payload, sizeof(value));
+  result->ordered_.push_back(value);
+  return kErrorCodeOk;
+}
+
+void verify_unordered(
+  Engine* engine,
+  const void* begin,
+  const void* end,
+  uint64_t from,
+  uint64_t to,
+  bool snapshot_only) {
+  MasstreeParallelScan scan(engine, MasstreeStorage(engine, kTableName).get_id());
+  KeyLength begin_length = begin ? sizeof(KeySlice) : 0;
+  KeyLength end_length = end ? sizeof(KeySlice) : 0;
+  COERCE_ERROR(scan.design_partitions(begin, begin_length, end, end_length, kPartitions));
+  EXPECT_GT(scan.get_partitions().size(), 1U);
+  EXPECT_LE(scan.get_partitions().size(), kPartitions);
+
+  ScanResult result;
+  std::memset(result.count_, 0, sizeof(result.count_));
+  std::memset(result.sum_, 0, sizeof(result.sum_));
+  MasstreeParallelScan::ExecuteArguments args;
+  args.handler_ = unordered_handler;
+  args.user_context_ = &result;
+  args.snapshot_only_ = snapshot_only;
+  COERCE_ERROR(scan.execute(nullptr, args));
+
+  uint64_t count = 0;
+  uint64_t sum = 0;
+  for (uint16_t i = 0; i < kPartitions; ++i) {
+    count += result.count_[i];
+    sum += result.sum_[i];
+  }
+  EXPECT_EQ(to - from, count);
+  EXPECT_EQ(to - from, scan.get_total_record_count());
+  EXPECT_EQ((from + to - 1U) * (to - from) / 2U, sum);
+}
+
+void verify_ordered(Engine* engine) {
+  MasstreeParallelScan scan(engine, MasstreeStorage(engine, kTableName).get_id());
+  COERCE_ERROR(scan.design_partitions(nullptr, 0, nullptr, 0, kPartitions));
+  EXPECT_GT(scan.get_partitions().size(), 1U);
+
+  ScanResult result;
+  MasstreeParallelScan::ExecuteArguments args;
+  args.merge_mode_ = MasstreeParallelScan::kOrdered;
+  args.handler_ = ordered_handler;
+  args.user_context_ = &result;
+  COERCE_ERROR(scan.execute(nullptr, args));
+  EXPECT_EQ(kRecords, result.ordered_.size());
+  for (uint64_t i = 0; i < result.ordered_.size(); ++i) {
+    EXPECT_EQ(i, result.ordered_[i]) << i;
+  }
+}
+
+void execute_test(bool snapshot) {
+  EngineOptions options = get_tiny_options();
+  options.thread_.thread_count_per_group_ = kPartitions;
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("populate_task", populate_task);
+  engine.get_proc_manager()->pre_register(MasstreeParallelScan::get_worker_proc());
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    MasstreeStorage out;
+    Epoch commit_epoch;
+    MasstreeMetadata meta(kTableName);
+    COERCE_ERROR(engine.get_storage_manager()->create_masstree(&meta, &out, &commit_epoch));
+    COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("populate_task"));
+    if (snapshot) {
+      engine.get_snapshot_manager()->trigger_snapshot_immediate(true);
+    }
+
+    verify_unordered(&engine, nullptr, nullptr, 0, kRecords, snapshot);
+    char begin[sizeof(KeySlice)];
+    char end[sizeof(KeySlice)];
+    assorted::write_bigendian<uint64_t>(100, begin);
+    assorted::write_bigendian<uint64_t>(kRecords - 100, end);
+    verify_unordered(&engine, begin, end, 100, kRecords - 100, snapshot);
+    verify_ordered(&engine);
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+TEST(MasstreeParallelScanTest, Volatile) { execute_test(false); }
+TEST(MasstreeParallelScanTest, Snapshot) { execute_test(true); }
+
+}  // namespace masstree
+}  // namespace storage
+}  // namespace foedus
+
+TEST_MAIN_CAPTURE_SIGNALS(MasstreeParallelScanTest, foedus.storage.masstree);
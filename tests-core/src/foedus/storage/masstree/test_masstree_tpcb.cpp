@@ -112,6 +112,8 @@ MasstreeStorage  tellers;
 sequential::SequentialStorage histories;
 bool          use_primitive_accessors = false;
 bool          use_increment = false;
+/** Branch/teller balances use delta_record(). Implies use_increment for accounts. */
+bool          use_delta = false;
 int thread_count;
 bool contended;
 soc::SharedRendezvous start_rendezvous;
@@ -265,7 +267,17 @@ class RunTpcbTask {
     WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
 
     int64_t branch_balance_old = -1, branch_balance_new;
-    if (use_increment) {
+    if (use_delta) {
+      // blind write. we don't know the balance
+      WRAP_ERROR_CODE(branches.delta_record_normalized(
+        context,
+        nm(branch_id),
+        kDeltaAdd,
+        amount,
+        0));
+      branch_balance_old = 0;
+      branch_balance_new = amount;
+    } else if (use_increment) {
       branch_balance_new = amount;
       WRAP_ERROR_CODE(branches.increment_record_normalized(
         context,
@@ -308,7 +320,22 @@ class RunTpcbTask {
 
     int64_t teller_balance_old = -1, teller_balance_new;
     uint64_t teller_branch_id = 0;
-    if (use_increment) {
+    if (use_delta) {
+      WRAP_ERROR_CODE(tellers.get_record_primitive_normalized(
+        context,
+        nm(teller_id),
+        &teller_branch_id,
+        0,
+        false));
+      WRAP_ERROR_CODE(tellers.delta_record_normalized(
+        context,
+        nm(teller_id),
+        kDeltaAdd,
+        amount,
+        sizeof(uint64_t)));
+      teller_balance_old = 0;
+      teller_balance_new = amount;
+    } else if (use_increment) {
       WRAP_ERROR_CODE(tellers.get_record_primitive_normalized(
         context,
         nm(teller_id),
@@ -552,11 +579,12 @@ ErrorStack verify_tpcb_task(const proc::ProcArguments& args) {
 }
 
 void multi_thread_test(int thread_count_arg, bool contended_arg,
-             bool use_primitive = false, bool use_inc = false) {
+             bool use_primitive = false, bool use_inc = false, bool use_dlt = false) {
   thread_count = thread_count_arg;
   contended = contended_arg;
   use_primitive_accessors = use_primitive;
   use_increment = use_inc;
+  use_delta = use_dlt;
   EngineOptions options = get_tiny_options();
   options.log_.log_buffer_kb_ = 1 << 12;
   options.thread_.group_count_ = 1;
@@ -615,6 +643,12 @@ TEST(MasstreeTpcbTest, FourThreadedNoContentionInc)   { multi_thread_test(4, fal
 TEST(MasstreeTpcbTest, SingleThreadedContendedInc)    { multi_thread_test(1, true, true, true); }
 TEST(MasstreeTpcbTest, TwoThreadedContendedInc)       { multi_thread_test(2, true, true, true); }
 TEST(MasstreeTpcbTest, FourThreadedContendedInc)      { multi_thread_test(4, true, true, true); }
+
+TEST(MasstreeTpcbTest, SingleThreadedContendedDelta) {
+  multi_thread_test(1, true, true, true, true);
+}
+TEST(MasstreeTpcbTest, TwoThreadedContendedDelta) { multi_thread_test(2, true, true, true, true); }
+TEST(MasstreeTpcbTest, FourThreadedContendedDelta) { multi_thread_test(4, true, true, true, true); }
 }  // namespace masstree
 }  // namespace storage
 }  // namespace foedus
@@ -81,8 +81,16 @@ EngineOptions get_randomized_paths() {
     options.snapshot_.folder_path_pattern_.assign(str.str());
   }
 
+  {
+    std::stringstream str;
+    str << "tmp_folders/" << uniquefier << "/snapshots/node_$NODE$/hot_pages.bin";
+    options.cache_.snapshot_cache_hot_list_path_pattern_.assign(str.str());
+  }
+
   options.savepoint_.savepoint_path_.assign(
     std::string("tmp_folders/") + uniquefier + "/savepoints.xml");
+  options.restart_.warm_restart_manifest_path_.assign(
+    std::string("tmp_folders/") + uniquefier + "/shared_memory_manifest.bin");
 
   // Mainly for performance reasons, we now put debug logs to
   //  /dev/shm/foedus_test/glog/<unique_name>.
@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include <stdint.h>
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "foedus/engine.hpp"
+#include "foedus/engine_options.hpp"
+#include "foedus/epoch.hpp"
+#include "foedus/test_common.hpp"
+#include "foedus/proc/proc_manager.hpp"
+#include "foedus/storage/storage_manager.hpp"
+#include "foedus/storage/array/array_metadata.hpp"
+#include "foedus/storage/array/array_storage.hpp"
+#include "foedus/thread/thread.hpp"
+#include "foedus/thread/thread_pool.hpp"
+#include "foedus/xct/xct.hpp"
+#include "foedus/xct/xct_manager.hpp"
+
+namespace foedus {
+namespace thread {
+DEFINE_TEST_CASE_PACKAGE(CoroutineTest, foedus.thread);
+
+const uint16_t kCoroutines = 4;
+const uint32_t kRounds = 5;
+const uint32_t kIncrements = 20;
+
+/** Each coroutine appends its ordinal kRounds times, yielding in between. */
+std::vector<uint16_t> interleave_history;
+
+ErrorStack interleave_coroutine(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  EXPECT_TRUE(context->is_in_coroutine());
+  EXPECT_FALSE(context->is_running_xct());
+  for (uint32_t i = 0; i < kRounds; ++i) {
+    interleave_history.push_back(context->get_coroutine_ordinal());
+    EXPECT_TRUE(context->is_coroutine_yieldable());
+    context->yield_coroutine();
+  }
+  return kRetOk;
+}
+
+ErrorStack interleave_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  EXPECT_FALSE(context->is_in_coroutine());
+  EXPECT_FALSE(context->yield_coroutine());
+  interleave_history.clear();
+  CHECK_ERROR(context->run_coroutines(interleave_coroutine, kCoroutines, nullptr, 0));
+  EXPECT_FALSE(context->is_in_coroutine());
+  return kRetOk;
+}
+
+ErrorStack disabled_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  ErrorStack result = context->run_coroutines(interleave_coroutine, 1, nullptr, 0);
+  EXPECT_EQ(kErrorCodeThrCoroutineDisabled, result.get_error_code());
+  EXPECT_FALSE(context->yield_coroutine());
+  return kRetOk;
+}
+
+ErrorStack nested_coroutine(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  ErrorStack result = context->run_coroutines(interleave_coroutine, 1, nullptr, 0);
+  EXPECT_EQ(kErrorCodeThrAlreadyInCoroutine, result.get_error_code());
+  return kRetOk;
+}
+
+ErrorStack nested_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  CHECK_ERROR(context->run_coroutines(nested_coroutine, 2, nullptr, 0));
+  ErrorStack result = context->run_coroutines(interleave_coroutine, kCoroutines + 1, nullptr, 0);
+  EXPECT_EQ(kErrorCodeInvalidParameter, result.get_error_code());
+  return kRetOk;
+}
+
+/**
+ * Each coroutine increments the same record kIncrements times. It yields between
+ * the read and the write, so concurrent coroutines cause race aborts, which we retry.
+ */
+ErrorStack increment_coroutine(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  Engine* engine = args.engine_;
+  storage::array::ArrayStorage array = engine->get_storage_manager()->get_array("test");
+  xct::XctManager* xct_manager = engine->get_xct_manager();
+  const uint16_t ordinal = context->get_coroutine_ordinal();
+  for (uint32_t i = 0; i < kIncrements;) {
+    CHECK_ERROR(xct_manager->begin_xct(context, xct::kSerializable));
+    uint64_t value;
+    CHECK_ERROR(array.get_record_primitive<uint64_t>(context, 0, &value, 0));
+    uint64_t mine;
+    CHECK_ERROR(array.get_record_primitive<uint64_t>(context, ordinal + 1U, &mine, 0));
+    context->yield_coroutine();
+    CHECK_ERROR(array.overwrite_record_primitive<uint64_t>(context, 0, value + 1U, 0));
+    CHECK_ERROR(array.overwrite_record_primitive<uint64_t>(context, ordinal + 1U, mine + 1U, 0));
+    EXPECT_FALSE(context->is_coroutine_yieldable());  // we have uncommitted logs
+    Epoch commit_epoch;
+    ErrorCode code = xct_manager->precommit_xct(context, &commit_epoch);
+    if (code == kErrorCodeXctRaceAbort) {
+      continue;
+    }
+    WRAP_ERROR_CODE(code);
+    WRAP_ERROR_CODE(xct_manager->wait_for_commit(context, commit_epoch));
+    ++i;
+  }
+  return kRetOk;
+}
+
+ErrorStack increment_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  CHECK_ERROR(context->run_coroutines(increment_coroutine, kCoroutines, nullptr, 0));
+  EXPECT_FALSE(context->is_running_xct());
+
+  Engine* engine = args.engine_;
+  storage::array::ArrayStorage array = engine->get_storage_manager()->get_array("test");
+  xct::XctManager* xct_manager = engine->get_xct_manager();
+  CHECK_ERROR(xct_manager->begin_xct(context, xct::kSerializable));
+  uint64_t total;
+  CHECK_ERROR(array.get_record_primitive<uint64_t>(context, 0, &total, 0));
+  EXPECT_EQ(kCoroutines * kIncrements, total);
+  for (uint16_t i = 0; i < kCoroutines; ++i) {
+    uint64_t mine;
+    CHECK_ERROR(array.get_record_primitive<uint64_t>(context, i + 1U, &mine, 0));
+    EXPECT_EQ(kIncrements, mine);
+  }
+  Epoch commit_epoch;
+  CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+  CHECK_ERROR(xct_manager->wait_for_commit(commit_epoch));
+  return kRetOk;
+}
+
+EngineOptions get_coroutine_options() {
+  EngineOptions options = get_tiny_options();
+  options.thread_.coroutines_per_thread_ = kCoroutines;
+  options.thread_.coroutine_stack_kb_ = 256;
+  return options;
+}
+
+TEST(CoroutineTest, Disabled) {
+  EngineOptions options = get_tiny_options();
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("disabled_task", disabled_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("disabled_task"));
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+TEST(CoroutineTest, Interleave) {
+  EngineOptions options = get_coroutine_options();
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("interleave_task", interleave_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("interleave_task"));
+    // round-robin: 0,1,2,3,0,1,2,3,...
+    ASSERT_EQ(kCoroutines * kRounds, interleave_history.size());
+    for (uint32_t i = 0; i < interleave_history.size(); ++i) {
+      EXPECT_EQ(i % kCoroutines, interleave_history[i]) << i;
+    }
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+TEST(CoroutineTest, Nested) {
+  EngineOptions options = get_coroutine_options();
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("nested_task", nested_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("nested_task"));
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+TEST(CoroutineTest, Increment) {
+  EngineOptions options = get_coroutine_options();
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("increment_task", increment_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    storage::array::ArrayMetadata meta("test", sizeof(uint64_t), kCoroutines + 1U);
+    storage::array::ArrayStorage storage;
+    Epoch epoch;
+    COERCE_ERROR(engine.get_storage_manager()->create_array(&meta, &storage, &epoch));
+    COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("increment_task"));
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+}  // namespace thread
+}  // namespace foedus
+
+TEST_MAIN_CAPTURE_SIGNALS(CoroutineTest, foedus.thread);
@@ -0,0 +1,214 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include <stdint.h>
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "foedus/engine.hpp"
+#include "foedus/engine_options.hpp"
+#include "foedus/epoch.hpp"
+#include "foedus/test_common.hpp"
+#include "foedus/log/log_manager.hpp"
+#include "foedus/proc/proc_manager.hpp"
+#include "foedus/storage/storage_manager.hpp"
+#include "foedus/storage/array/array_metadata.hpp"
+#include "foedus/storage/array/array_storage.hpp"
+#include "foedus/thread/thread.hpp"
+#include "foedus/thread/thread_pool.hpp"
+#include "foedus/xct/version_store_impl.hpp"
+#include "foedus/xct/xct.hpp"
+#include "foedus/xct/xct_id.hpp"
+#include "foedus/xct/xct_manager.hpp"
+
+namespace foedus {
+namespace xct {
+DEFINE_TEST_CASE_PACKAGE(XctMultiVersionTest, foedus.xct);
+
+const storage::array::ArrayOffset kRecords = 500;
+
+XctId make_xct_id(Epoch::EpochInteger epoch) {
+  XctId id;
+  id.set(epoch, 1);
+  return id;
+}
+
+TEST(XctMultiVersionTest, VersionStore) {
+  EngineOptions options;
+  options.xct_.version_arena_size_kb_ = 1;  // 4 slots per thread
+  const uint32_t kSlots = 1024 / RecordVersion::kSlotSize;
+  std::vector<char> memory(VersionStore::calculate_memory_size(options));
+  VersionStore store;
+  store.attach(&memory[0], options, true);
+  EXPECT_TRUE(store.is_enabled());
+
+  const uint64_t v3 = 3, v5 = 5;
+  EXPECT_TRUE(store.retain(0, 1, 42, make_xct_id(3), Epoch(5), &v3, sizeof(v3), Epoch(2)));
+  EXPECT_TRUE(store.retain(0, 1, 42, make_xct_id(5), Epoch(7), &v5, sizeof(v5), Epoch(2)));
+  uint64_t data = 0;
+  EXPECT_EQ(kErrorCodeOk, store.read(1, 42, Epoch(4), &data, 0, sizeof(data)));
+  EXPECT_EQ(v3, data);
+  EXPECT_EQ(kErrorCodeOk, store.read(1, 42, Epoch(6), &data, 0, sizeof(data)));
+  EXPECT_EQ(v5, data);
+  EXPECT_EQ(kErrorCodeXctVersionUnavailable, store.read(1, 42, Epoch(2), &data, 0, sizeof(data)));
+  EXPECT_EQ(kErrorCodeXctVersionUnavailable, store.read(1, 43, Epoch(4), &data, 0, sizeof(data)));
+  EXPECT_EQ(kErrorCodeXctVersionUnavailable, store.read(2, 42, Epoch(4), &data, 0, sizeof(data)));
+
+  // fill up the arena of thread-0 with other records.
+  for (uint32_t i = 2; i < kSlots; ++i) {
+    EXPECT_TRUE(store.retain(0, 1, i, make_xct_id(3), Epoch(9), &v3, sizeof(v3), Epoch(2)));
+  }
+  // The oldest slot is superseded in epoch-5, which is not durable yet. Can't recycle it.
+  EXPECT_FALSE(store.retain(0, 1, 100, make_xct_id(3), Epoch(9), &v3, sizeof(v3), Epoch(4)));
+  // Another thread has its own arena.
+  EXPECT_TRUE(store.retain(1, 1, 100, make_xct_id(3), Epoch(9), &v3, sizeof(v3), Epoch(4)));
+  // Now epoch-5 is durable.
+  EXPECT_TRUE(store.retain(0, 1, 101, make_xct_id(3), Epoch(9), &v3, sizeof(v3), Epoch(5)));
+  EXPECT_EQ(kErrorCodeXctVersionUnavailable, store.read(1, 42, Epoch(4), &data, 0, sizeof(data)));
+  EXPECT_EQ(kErrorCodeOk, store.read(1, 42, Epoch(6), &data, 0, sizeof(data)));
+  EXPECT_EQ(v5, data);
+  EXPECT_EQ(kErrorCodeOk, store.read(1, 100, Epoch(8), &data, 0, sizeof(data)));
+  EXPECT_EQ(v3, data);
+
+  // too large to retain
+  const uint16_t kLarge = RecordVersion::kPayloadCapacity + 1U;
+  std::vector<char> large(kLarge, 0);
+  EXPECT_FALSE(store.retain(1, 1, 102, make_xct_id(3), Epoch(9), &large[0], kLarge, Epoch(5)));
+
+  // the drops above are counted
+  VersionStoreStat stat = store.get_stat();
+  EXPECT_EQ(kSlots + 2U, stat.retained_count_);
+  EXPECT_EQ(1U, stat.dropped_large_count_);
+  EXPECT_EQ(1U, stat.dropped_in_use_count_);
+}
+
+ErrorStack disabled_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  XctManager* xct_manager = args.engine_->get_xct_manager();
+  EXPECT_EQ(kErrorCodeXctMultiVersionDisabled, xct_manager->begin_multi_version_xct(context));
+  EXPECT_FALSE(context->is_running_xct());
+  return kRetOk;
+}
+
+/** Sets value + offset to all records, and optionally waits for commit */
+ErrorStack populate(thread::Thread* context, uint64_t value, bool wait, Epoch* commit_epoch) {
+  Engine* engine = context->get_engine();
+  storage::array::ArrayStorage array = engine->get_storage_manager()->get_array("test");
+  XctManager* xct_manager = engine->get_xct_manager();
+  CHECK_ERROR(xct_manager->begin_xct(context, kSerializable));
+  for (storage::array::ArrayOffset i = 0; i < kRecords; ++i) {
+    CHECK_ERROR(array.overwrite_record_primitive<uint64_t>(context, i, value + i, 0));
+  }
+  CHECK_ERROR(xct_manager->precommit_xct(context, commit_epoch));
+  if (wait) {
+    CHECK_ERROR(xct_manager->wait_for_commit(*commit_epoch));
+  }
+  return kRetOk;
+}
+
+ErrorStack basic_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  Engine* engine = args.engine_;
+  storage::array::ArrayStorage array = engine->get_storage_manager()->get_array("test");
+  XctManager* xct_manager = engine->get_xct_manager();
+  const uint64_t kOld = 0;
+  const uint64_t kNew = 1000000;
+  Epoch old_epoch;
+  CHECK_ERROR(populate(context, kOld, true, &old_epoch));
+  Epoch new_epoch;
+  CHECK_ERROR(populate(context, kNew, false, &new_epoch));
+  EXPECT_LT(old_epoch, new_epoch);
+  // the second populate overwrote all records in a new epoch
+  VersionStoreStat stat = xct_manager->get_version_store_stat();
+  EXPECT_GE(stat.retained_count_ + stat.dropped_in_use_count_, kRecords);
+  EXPECT_EQ(0U, stat.dropped_large_count_);
+
+  CHECK_ERROR(xct_manager->begin_multi_version_xct(context));
+  const Epoch as_of = context->get_current_xct().get_multi_version_epoch();
+  EXPECT_TRUE(context->get_current_xct().is_multi_version());
+  EXPECT_GE(as_of, old_epoch);
+  // Unless the new values have become durable in the meantime, we must see the old values
+  // retained in the version store. Either way, all records must be of the same version.
+  const uint64_t expected = as_of < new_epoch ? kOld : kNew;
+  for (storage::array::ArrayOffset i = 0; i < kRecords; ++i) {
+    uint64_t data;
+    CHECK_ERROR(array.get_record_primitive<uint64_t>(context, i, &data, 0));
+    EXPECT_EQ(expected + i, data) << i;
+    uint64_t data2;
+    CHECK_ERROR(array.get_record(context, i, &data2, 0, sizeof(data2)));
+    EXPECT_EQ(expected + i, data2) << i;
+  }
+  EXPECT_EQ(0, context->get_current_xct().get_read_set_size());
+  EXPECT_EQ(0, context->get_current_xct().get_pointer_set_size());
+  EXPECT_EQ(
+    kErrorCodeXctMultiVersionWrite,
+    array.overwrite_record_primitive<uint64_t>(context, 0, 42, 0));
+  const void* payload;
+  EXPECT_EQ(kErrorCodeXctMultiVersionUnsupported, array.get_record_payload(context, 0, &payload));
+
+  Epoch commit_epoch;
+  CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+  EXPECT_EQ(as_of, commit_epoch);
+  CHECK_ERROR(xct_manager->wait_for_commit(new_epoch));
+
+  // now the new values are durable, and the current images are visible.
+  CHECK_ERROR(xct_manager->begin_multi_version_xct(context));
+  for (storage::array::ArrayOffset i = 0; i < kRecords; ++i) {
+    uint64_t data;
+    CHECK_ERROR(array.get_record_primitive<uint64_t>(context, i, &data, 0));
+    EXPECT_EQ(kNew + i, data) << i;
+  }
+  CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+  return kRetOk;
+}
+
+TEST(XctMultiVersionTest, Disabled) {
+  EngineOptions options = get_tiny_options();
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("disabled_task", disabled_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("disabled_task"));
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+TEST(XctMultiVersionTest, Basic) {
+  EngineOptions options = get_tiny_options();
+  options.xct_.version_arena_size_kb_ = 1024;
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("basic_task", basic_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    storage::array::ArrayMetadata meta("test", sizeof(uint64_t), kRecords);
+    storage::array::ArrayStorage storage;
+    Epoch epoch;
+    COERCE_ERROR(engine.get_storage_manager()->create_array(&meta, &storage, &epoch));
+    COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("basic_task"));
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+}  // namespace xct
+}  // namespace foedus
+
+TEST_MAIN_CAPTURE_SIGNALS(XctMultiVersionTest, foedus.xct);
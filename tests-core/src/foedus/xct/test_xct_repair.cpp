@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include <stdint.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+#include "foedus/engine.hpp"
+#include "foedus/engine_options.hpp"
+#include "foedus/epoch.hpp"
+#include "foedus/test_common.hpp"
+#include "foedus/proc/proc_manager.hpp"
+#include "foedus/storage/storage_manager.hpp"
+#include "foedus/storage/array/array_log_types.hpp"
+#include "foedus/storage/array/array_metadata.hpp"
+#include "foedus/storage/array/array_storage.hpp"
+#include "foedus/thread/thread.hpp"
+#include "foedus/thread/thread_pool.hpp"
+#include "foedus/xct/xct.hpp"
+#include "foedus/xct/xct_manager.hpp"
+#include "foedus/xct/xct_repair_functor.hpp"
+
+namespace foedus {
+namespace xct {
+DEFINE_TEST_CASE_PACKAGE(XctRepairTest, foedus.xct);
+
+const storage::array::ArrayOffset kRecords = 10;
+const storage::array::ArrayOffset kTarget = 3;
+
+/** 0: initial, 1: reader has read the record, 2: writer has committed. */
+std::atomic<int> stage;
+
+/** Re-computes the increment from the current value. */
+struct IncrementRepair : public XctRepairFunctor {
+  IncrementRepair() : calls_(0) {}
+  ErrorCode repair(
+    thread::Thread* /*context*/,
+    const char* payload,
+    log::RecordLogType* log_entry) override {
+    uint64_t current;
+    std::memcpy(&current, payload, sizeof(current));
+    auto* casted = reinterpret_cast<storage::array::ArrayOverwriteLogType*>(log_entry);
+    EXPECT_EQ(sizeof(uint64_t), casted->payload_count_);
+    const uint64_t incremented = current + 1U;
+    std::memcpy(casted->payload_, &incremented, sizeof(incremented));
+    ++calls_;
+    return kErrorCodeOk;
+  }
+  uint32_t calls_;
+};
+
+void wait_stage(int value) {
+  while (stage.load() < value) {
+    std::this_thread::yield();
+  }
+}
+
+ErrorStack increment(thread::Thread* context, storage::array::ArrayStorage* array) {
+  XctManager* xct_manager = context->get_engine()->get_xct_manager();
+  CHECK_ERROR(xct_manager->begin_xct(context, kSerializable));
+  uint64_t data;
+  CHECK_ERROR(array->get_record_primitive<uint64_t>(context, kTarget, &data, 0));
+  CHECK_ERROR(array->overwrite_record_primitive<uint64_t>(context, kTarget, data + 1U, 0));
+  Epoch commit_epoch;
+  CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+  return kRetOk;
+}
+
+ErrorStack writer_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  storage::array::ArrayStorage array = args.engine_->get_storage_manager()->get_array("test");
+  wait_stage(1);
+  CHECK_ERROR(increment(context, &array));
+  stage.store(2);
+  return kRetOk;
+}
+
+ErrorStack reader_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  EXPECT_EQ(sizeof(bool), args.input_len_);
+  const bool use_repair = *reinterpret_cast<const bool*>(args.input_buffer_);
+  storage::array::ArrayStorage array = args.engine_->get_storage_manager()->get_array("test");
+  XctManager* xct_manager = args.engine_->get_xct_manager();
+  IncrementRepair repair;
+  CHECK_ERROR(xct_manager->begin_xct(context, kSerializable));
+  EXPECT_EQ(kErrorCodeInvalidParameter, context->get_current_xct().set_repair_functor(&repair));
+  uint64_t data;
+  CHECK_ERROR(array.get_record_primitive<uint64_t>(context, kTarget, &data, 0));
+  EXPECT_EQ(0, data);
+  stage.store(1);
+  wait_stage(2);
+  // The value we read is now stale.
+  CHECK_ERROR(array.overwrite_record_primitive<uint64_t>(context, kTarget, data + 1U, 0));
+  if (use_repair) {
+    CHECK_ERROR(context->get_current_xct().set_repair_functor(&repair));
+  }
+  Epoch commit_epoch;
+  ErrorCode ret = xct_manager->precommit_xct(context, &commit_epoch);
+  if (use_repair) {
+    EXPECT_EQ(kErrorCodeOk, ret);
+    EXPECT_EQ(1U, repair.calls_);
+  } else {
+    EXPECT_EQ(kErrorCodeXctRaceAbort, ret);
+    EXPECT_EQ(0, repair.calls_);
+    // usual retry from scratch
+    CHECK_ERROR(increment(context, &array));
+  }
+
+  CHECK_ERROR(xct_manager->begin_xct(context, kSerializable));
+  CHECK_ERROR(array.get_record_primitive<uint64_t>(context, kTarget, &data, 0));
+  EXPECT_EQ(2U, data);
+  CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+  return kRetOk;
+}
+
+void test_main(bool use_repair) {
+  EngineOptions options = get_tiny_options();
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("reader_task", reader_task);
+  engine.get_proc_manager()->pre_register("writer_task", writer_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    storage::array::ArrayMetadata meta("test", sizeof(uint64_t), kRecords);
+    storage::array::ArrayStorage storage;
+    Epoch epoch;
+    COERCE_ERROR(engine.get_storage_manager()->create_array(&meta, &storage, &epoch));
+    stage.store(0);
+    thread::ImpersonateSession reader;
+    thread::ImpersonateSession writer;
+    EXPECT_TRUE(engine.get_thread_pool()->impersonate(
+      "reader_task",
+      &use_repair,
+      sizeof(use_repair),
+      &reader));
+    EXPECT_TRUE(engine.get_thread_pool()->impersonate("writer_task", nullptr, 0, &writer));
+    COERCE_ERROR(writer.get_result());
+    COERCE_ERROR(reader.get_result());
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+TEST(XctRepairTest, Repaired) { test_main(true); }
+TEST(XctRepairTest, NoFunctor) { test_main(false); }
+
+}  // namespace xct
+}  // namespace foedus
+
+TEST_MAIN_CAPTURE_SIGNALS(XctRepairTest, foedus.xct);
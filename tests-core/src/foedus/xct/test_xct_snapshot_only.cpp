@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include <stdint.h>
+#include <gtest/gtest.h>
+
+#include "foedus/engine.hpp"
+#include "foedus/engine_options.hpp"
+#include "foedus/epoch.hpp"
+#include "foedus/test_common.hpp"
+#include "foedus/log/log_manager.hpp"
+#include "foedus/proc/proc_manager.hpp"
+#include "foedus/snapshot/snapshot_manager.hpp"
+#include "foedus/storage/storage_manager.hpp"
+#include "foedus/storage/array/array_metadata.hpp"
+#include "foedus/storage/array/array_storage.hpp"
+#include "foedus/thread/thread.hpp"
+#include "foedus/thread/thread_pool.hpp"
+#include "foedus/xct/xct.hpp"
+#include "foedus/xct/xct_manager.hpp"
+
+namespace foedus {
+namespace xct {
+DEFINE_TEST_CASE_PACKAGE(XctSnapshotOnlyTest, foedus.xct);
+
+// enough records to have multiple leaf pages, so batched reads follow many snapshot pointers
+const storage::array::ArrayOffset kRecords = 2000;
+const uint16_t kBatch = 16;
+
+ErrorStack no_snapshot_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  XctManager* xct_manager = args.engine_->get_xct_manager();
+  EXPECT_EQ(kErrorCodeXctNoSnapshot, xct_manager->begin_snapshot_only_xct(context));
+  EXPECT_FALSE(context->is_running_xct());
+  return kRetOk;
+}
+
+/** Sets value + offset to all records */
+ErrorStack populate_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  Engine* engine = args.engine_;
+  uint64_t value = *reinterpret_cast<const uint64_t*>(args.input_buffer_);
+  storage::array::ArrayStorage array = engine->get_storage_manager()->get_array("test");
+  XctManager* xct_manager = engine->get_xct_manager();
+  CHECK_ERROR(xct_manager->begin_xct(context, kSerializable));
+  for (storage::array::ArrayOffset i = 0; i < kRecords; ++i) {
+    CHECK_ERROR(array.overwrite_record_primitive<uint64_t>(context, i, value + i, 0));
+  }
+  Epoch commit_epoch;
+  CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+  CHECK_ERROR(xct_manager->wait_for_commit(commit_epoch));
+  return kRetOk;
+}
+
+/** Verifies all records are value + offset */
+ErrorStack verify_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  Engine* engine = args.engine_;
+  uint64_t value = *reinterpret_cast<const uint64_t*>(args.input_buffer_);
+  bool snapshot_only = value == 0;
+  storage::array::ArrayStorage array = engine->get_storage_manager()->get_array("test");
+  XctManager* xct_manager = engine->get_xct_manager();
+  if (snapshot_only) {
+    CHECK_ERROR(xct_manager->begin_snapshot_only_xct(context));
+    EXPECT_TRUE(context->get_current_xct().is_snapshot_only());
+    EXPECT_EQ(
+      engine->get_snapshot_manager()->get_previous_snapshot_id(),
+      context->get_current_xct().get_snapshot_only_id());
+  } else {
+    CHECK_ERROR(xct_manager->begin_xct(context, kSerializable));
+    EXPECT_FALSE(context->get_current_xct().is_snapshot_only());
+  }
+
+  // one by one
+  for (storage::array::ArrayOffset i = 0; i < kRecords; ++i) {
+    uint64_t data;
+    CHECK_ERROR(array.get_record_primitive<uint64_t>(context, i, &data, 0));
+    EXPECT_EQ(value + i, data) << i;
+  }
+  // batched
+  for (storage::array::ArrayOffset i = 0; i + kBatch <= kRecords; i += kBatch) {
+    storage::array::ArrayOffset offsets[kBatch];
+    uint64_t data[kBatch];
+    for (uint16_t j = 0; j < kBatch; ++j) {
+      offsets[j] = i + j;
+    }
+    CHECK_ERROR(array.get_record_primitive_batch<uint64_t>(context, 0, kBatch, offsets, data));
+    for (uint16_t j = 0; j < kBatch; ++j) {
+      EXPECT_EQ(value + i + j, data[j]) << (i + j);
+    }
+  }
+
+  if (snapshot_only) {
+    // nothing to verify at commit
+    EXPECT_EQ(0, context->get_current_xct().get_read_set_size());
+    EXPECT_EQ(0, context->get_current_xct().get_pointer_set_size());
+    EXPECT_EQ(
+      kErrorCodeXctSnapshotOnlyWrite,
+      array.overwrite_record_primitive<uint64_t>(context, 0, 42, 0));
+  }
+  Epoch commit_epoch;
+  CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+  if (snapshot_only) {
+    EXPECT_EQ(engine->get_snapshot_manager()->get_snapshot_epoch(), commit_epoch);
+    EXPECT_GE(engine->get_log_manager()->get_durable_global_epoch(), commit_epoch);
+  }
+  CHECK_ERROR(xct_manager->wait_for_commit(commit_epoch));
+  return kRetOk;
+}
+
+TEST(XctSnapshotOnlyTest, NoSnapshot) {
+  EngineOptions options = get_tiny_options();
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("no_snapshot_task", no_snapshot_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("no_snapshot_task"));
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+TEST(XctSnapshotOnlyTest, Basic) {
+  EngineOptions options = get_tiny_options();
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("populate_task", populate_task);
+  engine.get_proc_manager()->pre_register("verify_task", verify_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    storage::array::ArrayMetadata meta("test", sizeof(uint64_t), kRecords);
+    storage::array::ArrayStorage storage;
+    Epoch epoch;
+    COERCE_ERROR(engine.get_storage_manager()->create_array(&meta, &storage, &epoch));
+    thread::ThreadPool* pool = engine.get_thread_pool();
+
+    // value 0 is snapshotted. value 1000000 is only in volatile pages.
+    const uint64_t kSnapshotted = 0;
+    const uint64_t kVolatile = 1000000;
+    COERCE_ERROR(pool->impersonate_synchronous("populate_task", &kSnapshotted, sizeof(uint64_t)));
+    engine.get_snapshot_manager()->trigger_snapshot_immediate(true);
+    COERCE_ERROR(pool->impersonate_synchronous("populate_task", &kVolatile, sizeof(uint64_t)));
+
+    // snapshot-only transaction sees the snapshot. usual transaction sees the latest.
+    COERCE_ERROR(pool->impersonate_synchronous("verify_task", &kSnapshotted, sizeof(uint64_t)));
+    COERCE_ERROR(pool->impersonate_synchronous("verify_task", &kVolatile, sizeof(uint64_t)));
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+}  // namespace xct
+}  // namespace foedus
+
+TEST_MAIN_CAPTURE_SIGNALS(XctSnapshotOnlyTest, foedus.xct);
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include <stdint.h>
+#include <gtest/gtest.h>
+
+#include "foedus/engine.hpp"
+#include "foedus/engine_options.hpp"
+#include "foedus/epoch.hpp"
+#include "foedus/test_common.hpp"
+#include "foedus/proc/proc_manager.hpp"
+#include "foedus/storage/storage_manager.hpp"
+#include "foedus/storage/array/array_metadata.hpp"
+#include "foedus/storage/array/array_storage.hpp"
+#include "foedus/thread/thread.hpp"
+#include "foedus/thread/thread_pool.hpp"
+#include "foedus/xct/xct.hpp"
+#include "foedus/xct/xct_manager.hpp"
+
+namespace foedus {
+namespace xct {
+DEFINE_TEST_CASE_PACKAGE(XctWorkMemoryTest, foedus.xct);
+
+const uint32_t kMaxReadSetSize = 64;
+const uint32_t kMaxWriteSetSize = 32;
+/** More than kMaxWriteSetSize, less than kMaxWriteSetSize * 4 */
+const storage::array::ArrayOffset kLargeXctRecords = 100;
+const storage::array::ArrayOffset kRecords = 256;
+
+/** Increments records in a transaction that is larger than the configured sizes. */
+ErrorStack large_xct_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  EXPECT_EQ(sizeof(bool), args.input_len_);
+  const bool expect_growth = *reinterpret_cast<const bool*>(args.input_buffer_);
+  storage::array::ArrayStorage array = args.engine_->get_storage_manager()->get_array("test");
+  XctManager* xct_manager = args.engine_->get_xct_manager();
+  Xct& current_xct = context->get_current_xct();
+  Epoch commit_epoch;
+
+  CHECK_ERROR(xct_manager->begin_xct(context, kSerializable));
+  for (storage::array::ArrayOffset i = 0; i < kLargeXctRecords; ++i) {
+    uint64_t data;
+    CHECK_ERROR(array.get_record_primitive<uint64_t>(context, i, &data, 0));
+    EXPECT_EQ(i, data);
+    ErrorCode ret = array.overwrite_record_primitive<uint64_t>(context, i, data + 1U, 0);
+    if (!expect_growth && i >= kMaxWriteSetSize) {
+      EXPECT_EQ(kErrorCodeXctWriteSetOverflow, ret);
+      CHECK_ERROR(xct_manager->abort_xct(context));
+      EXPECT_FALSE(current_xct.is_work_memory_spilled());
+      return kRetOk;
+    }
+    CHECK_ERROR(ret);
+  }
+  EXPECT_EQ(kLargeXctRecords, current_xct.get_write_set_size());
+  CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+  EXPECT_TRUE(current_xct.is_work_memory_spilled());
+
+  // The next transaction starts from the resident part again.
+  CHECK_ERROR(xct_manager->begin_xct(context, kSerializable));
+  for (storage::array::ArrayOffset i = 0; i < kRecords; ++i) {
+    uint64_t data;
+    CHECK_ERROR(array.get_record_primitive<uint64_t>(context, i, &data, 0));
+    EXPECT_EQ(i < kLargeXctRecords ? i + 1U : i, data);
+    if ((i + 1U) % kMaxReadSetSize == 0) {
+      // verify in a few transactions so that we don't exceed the resident read-set
+      CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+      EXPECT_FALSE(current_xct.is_work_memory_spilled());
+      CHECK_ERROR(xct_manager->begin_xct(context, kSerializable));
+    }
+  }
+  CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+  return kRetOk;
+}
+
+ErrorStack populate_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  storage::array::ArrayStorage array = args.engine_->get_storage_manager()->get_array("test");
+  XctManager* xct_manager = args.engine_->get_xct_manager();
+  Epoch commit_epoch;
+  for (storage::array::ArrayOffset i = 0; i < kRecords; ++i) {
+    CHECK_ERROR(xct_manager->begin_xct(context, kSerializable));
+    CHECK_ERROR(array.overwrite_record_primitive<uint64_t>(context, i, i, 0));
+    CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+  }
+  return kRetOk;
+}
+
+void test_main(bool growth) {
+  EngineOptions options = get_tiny_options();
+  options.xct_.max_read_set_size_ = kMaxReadSetSize;
+  options.xct_.max_write_set_size_ = kMaxWriteSetSize;
+  options.xct_.work_memory_growth_factor_ = growth ? 4U : 1U;
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("populate_task", populate_task);
+  engine.get_proc_manager()->pre_register("large_xct_task", large_xct_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    storage::array::ArrayMetadata meta("test", sizeof(uint64_t), kRecords);
+    storage::array::ArrayStorage storage;
+    Epoch epoch;
+    COERCE_ERROR(engine.get_storage_manager()->create_array(&meta, &storage, &epoch));
+    COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("populate_task"));
+    COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous(
+      "large_xct_task",
+      &growth,
+      sizeof(growth)));
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+TEST(XctWorkMemoryTest, Grow) { test_main(true); }
+TEST(XctWorkMemoryTest, NoGrowth) { test_main(false); }
+
+}  // namespace xct
+}  // namespace foedus
+
+TEST_MAIN_CAPTURE_SIGNALS(XctWorkMemoryTest, foedus.xct);